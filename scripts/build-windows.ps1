@@ -19,10 +19,22 @@ $VendorSqlite = "vendor/sqlite"
 # Source files
 $Sources = @(
     "$SrcDir/diskann_api.c",
+    "$SrcDir/diskann_bitmap.c",
     "$SrcDir/diskann_blob.c",
+    "$SrcDir/diskann_build.c",
+    "$SrcDir/diskann_cache.c",
+    "$SrcDir/diskann_calibrate.c",
     "$SrcDir/diskann_insert.c",
+    "$SrcDir/diskann_label.c",
     "$SrcDir/diskann_node.c",
+    "$SrcDir/diskann_optimize.c",
+    "$SrcDir/diskann_pq.c",
     "$SrcDir/diskann_search.c",
+    "$SrcDir/diskann_shard.c",
+    "$SrcDir/diskann_simd.c",
+    "$SrcDir/diskann_snapshot.c",
+    "$SrcDir/diskann_stats.c",
+    "$SrcDir/diskann_thread.c",
     "$SrcDir/diskann_vtab.c"
 )
 
@@ -55,6 +55,36 @@ extern "C" {
 #define DISKANN_METRIC_COSINE 1
 #define DISKANN_METRIC_DOT 2
 
+/*
+** Edge vector encodings (DiskAnnConfig.edge_type)
+**
+** Every edge slot in a node block holds a copy of the neighbor's vector so
+** search can score neighbors without loading their blocks. INT8 stores one
+** byte per dimension, scalar-quantized over the per-index
+** [quant_min, quant_max] range, cutting block size (and I/O per search hop)
+** by ~4x. Without a configured range, the range is taken from the first
+** vectors inserted (all of them for diskann_build()) with some headroom;
+** components outside it are clamped. Node vectors keep full precision and
+** are used to rerank results.
+** FLOAT32 edges store the neighbor's vector exactly as its node does, in
+** the index's vector_type (see below).
+*/
+#define DISKANN_EDGE_FLOAT32 0
+#define DISKANN_EDGE_INT8 1
+
+/*
+** Vector element types (DiskAnnConfig.vector_type)
+**
+** How node vectors, and DISKANN_EDGE_FLOAT32 edge slots, are stored.
+** FLOAT16 (IEEE 754 binary16) and BFLOAT16 take 2 bytes per dimension,
+** halving block size and I/O per search hop. The API still takes float32
+** vectors, rounded to nearest on write; distances are computed against
+** the stored values, converted inside the distance kernels.
+*/
+#define DISKANN_VECTOR_FLOAT32 0
+#define DISKANN_VECTOR_FLOAT16 1
+#define DISKANN_VECTOR_BFLOAT16 2
+
 /*
 ** Opaque index handle
 */
@@ -70,6 +100,10 @@ typedef struct DiskAnnConfig {
   uint32_t search_list_size; /* search beam width (default: 100, auto-scales) */
   uint32_t insert_list_size; /* insert beam width (default: 200) */
   uint32_t block_size;       /* node block size in bytes (default: 4096) */
+  uint8_t edge_type;         /* DISKANN_EDGE_* (default: FLOAT32) */
+  float quant_min;           /* INT8 value range; both 0 = from the data */
+  float quant_max;
+  uint8_t vector_type;       /* DISKANN_VECTOR_* (default: FLOAT32) */
 } DiskAnnConfig;
 
 /*
@@ -87,6 +121,31 @@ typedef struct DiskAnnResult {
 */
 typedef int (*DiskAnnFilterFn)(int64_t rowid, void *ctx);
 
+/* DiskAnnSearchParams.exact: let the planner choose, always scan every
+** row, or always walk the graph */
+#define DISKANN_SEARCH_AUTO 0
+#define DISKANN_SEARCH_EXACT 1
+#define DISKANN_SEARCH_GRAPH 2
+
+/*
+** Per-query search parameters (see diskann_search_ex()). Zeroed fields
+** take the handle's settings, so a zero-initialized struct searches
+** exactly like diskann_search().
+*/
+typedef struct DiskAnnSearchParams {
+  uint32_t search_list_size; /* beam size floor (0 = the index's); still
+                             ** raised to sqrt(n) like the index's */
+  int exact;                 /* DISKANN_SEARCH_AUTO, _EXACT or _GRAPH */
+  float recall_target;       /* recall@k to size the beam for, read off the
+                             ** calibrated curve (0 = the index's target;
+                             ** see diskann_calibrate()). Ignored when
+                             ** search_list_size is set or the index is
+                             ** not calibrated. */
+  uint32_t patience;         /* stop once this many visited nodes in a row
+                             ** left the top k unchanged (0 = walk until
+                             ** the beam is exhausted) */
+} DiskAnnSearchParams;
+
 /*
 ** Create a new DiskANN index with the specified configuration.
 **
@@ -128,6 +187,91 @@ int diskann_open_index(sqlite3 *db, const char *db_name, const char *index_name,
 */
 void diskann_close_index(DiskAnnIndex *idx);
 
+/*
+** Open a search-only handle on another connection that shares an open
+** index's state.
+**
+** The reader borrows the shared handle's configuration, entry point, PQ
+** codes, labels and read cache (see diskann_set_cache_budget()) instead
+** of re-reading _metadata and warming its own copies, and keeps its own
+** statements and search context. One reader per connection lets a pool
+** of reader threads serve queries through one shared handle: pass
+** per-query settings with diskann_search_ex() rather than changing the
+** shared handle.
+**
+** Readers refuse every write (DISKANN_ERROR_INVALID). The shared handle
+** must not be written to while readers search, and must outlive them.
+** Rows committed through other handles are found, but the borrowed entry
+** point, PQ codes and labels only change with the shared handle; each
+** search picks up what the shared handle holds at that moment, so
+** inserting through it, diskann_pq_build() or diskann_set_cache_budget()
+** between searches is safe. The read cache is cleared when any reader's
+** connection sees another connection's commit.
+**
+** Parameters:
+**   shared  - Handle from diskann_open_index() or diskann_open_snapshot()
+**             (not another reader)
+**   db      - Connection for this reader, opened on the same database
+**             (NULL for a snapshot's readers)
+**   db_name - Schema holding the index on db (NULL = shared's)
+**   out     - Receives the reader; close it with diskann_close_index()
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if an argument is NULL or shared is a reader
+**   DISKANN_ERROR_NOMEM if allocation fails
+*/
+int diskann_open_reader(DiskAnnIndex *shared, sqlite3 *db,
+                        const char *db_name, DiskAnnIndex **out);
+
+/*
+** Write a point-in-time copy of the index graph to a flat file for
+** diskann_open_snapshot().
+**
+** Every node block is copied in rowid order, with the handle's entry
+** point and configuration. The file is written next to path and renamed
+** over it when complete, so processes serving an older snapshot of path
+** keep a valid mapping. PQ codes and labels are not exported: snapshot
+** searches use the stored edge vectors and filter with callbacks only.
+**
+** Parameters:
+**   idx  - Index handle (not a reader or snapshot, not in batch mode)
+**   path - Destination file
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx is read-only or in batch mode
+**   DISKANN_ERROR_IO if the file cannot be written or renamed
+**   DISKANN_ERROR_NOMEM if allocation fails
+**   DISKANN_ERROR on SQLite errors or malformed blocks
+*/
+int diskann_export_snapshot(DiskAnnIndex *idx, const char *path);
+
+/*
+** Open a snapshot written by diskann_export_snapshot() as a read-only
+** index handle.
+**
+** The file is memory-mapped and searches read node blocks in place: no
+** SQLite connection, BLOB handles or block copies, and the OS page cache
+** is shared between processes serving the same file. The handle supports
+** diskann_search(), diskann_search_ex(), diskann_search_filtered(),
+** diskann_search_exact(), diskann_search_batch() and
+** diskann_open_reader() (with db NULL); writes return
+** DISKANN_ERROR_INVALID. It sees no later changes to the source index.
+**
+** Parameters:
+**   path - Snapshot file
+**   out  - Receives the handle; close it with diskann_close_index()
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_IO if the file cannot be opened or mapped
+**   DISKANN_ERROR_VERSION if it is not a snapshot this build can read
+**   DISKANN_ERROR if it is truncated or inconsistent
+**   DISKANN_ERROR_NOMEM if allocation fails
+*/
+int diskann_open_snapshot(const char *path, DiskAnnIndex **out);
+
 /*
 ** Insert a vector into the index.
 **
@@ -143,13 +287,62 @@ void diskann_close_index(DiskAnnIndex *idx);
 int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
                    uint32_t dims);
 
+/*
+** Insert n vectors as one operation.
+**
+** Runs under a single SAVEPOINT (and its own batch mode unless one is
+** already active): all shadow rows are written up front with one
+** prepared statement, then the nodes are linked in order. Each node's
+** walk starts at its nearest already-linked batch member (the index entry
+** point for the first), and besides the visited nodes it is offered its 8
+** nearest batch members, compared in memory within windows of 512, so
+** batches of similar vectors link to each other directly. Tombstoned or
+** queued ids are reused as in diskann_insert(). On error nothing is
+** inserted.
+**
+** Parameters:
+**   idx     - Index handle
+**   ids     - n vector IDs (distinct)
+**   vectors - n vectors, row-major (dims floats each)
+**   n       - Number of vectors (0 is a no-op)
+**   dims    - Vector dimensions (must match index configuration)
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_EXISTS if an id is already a live node or repeats
+**   Other error codes on failure
+*/
+int diskann_insert_batch(DiskAnnIndex *idx, const int64_t *ids,
+                         const float *vectors, int n, uint32_t dims);
+
+/*
+** Store a vector without linking it into the graph (bulk-load ingest).
+**
+** Much cheaper than diskann_insert(): one shadow-row INSERT, no search and
+** no neighbor rewrites. The node is not reachable by searches until
+** diskann_build() constructs the graph.
+**
+** Parameters:
+**   idx     - Index handle
+**   id      - Vector ID (user-provided, e.g., image ID)
+**   vector  - Vector data (float32 array)
+**   dims    - Vector dimensions (must match index configuration)
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_EXISTS if id is already in the index
+**   Other error codes on failure
+*/
+int diskann_insert_vector(DiskAnnIndex *idx, int64_t id, const float *vector,
+                          uint32_t dims);
+
 /*
 ** Search for k-nearest neighbors.
 **
 ** The search beam width is automatically scaled to max(configured, sqrt(n))
 ** where n is the index size. This maintains recall as the index grows without
-** manual tuning. Per-query overrides via the vtab search_list_size constraint
-** also benefit from this floor.
+** manual tuning. Per-query overrides (diskann_search_ex() and the vtab
+** search_list_size constraint) also benefit from this floor.
 **
 ** Parameters:
 **   idx     - Index handle
@@ -191,6 +384,142 @@ int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
                             uint32_t dims, int k, DiskAnnResult *results,
                             DiskAnnFilterFn filter_fn, void *filter_ctx);
 
+/*
+** diskann_search_filtered() with per-query parameters.
+**
+** params overrides the handle's search list size and exact scan planning
+** for this query only (NULL = the handle's settings). The handle is not
+** modified, so readers sharing an index may pass different parameters
+** concurrently.
+**
+** Parameters and returns as for diskann_search_filtered().
+*/
+int diskann_search_ex(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                      int k, const DiskAnnSearchParams *params,
+                      DiskAnnResult *results, DiskAnnFilterFn filter_fn,
+                      void *filter_ctx);
+
+/*
+** Exact k-nearest-neighbor search by scanning the whole index.
+**
+** Scores every row (those accepted by filter_fn, if given) and returns the
+** true k nearest, sorted. The scan reads only each block's node vector,
+** in rowid order, so it touches far fewer bytes per row than a graph hop.
+** diskann_search() and diskann_search_filtered() switch to it on their own
+** for small indexes (see diskann_set_exact_scan_threshold()); call it
+** directly for ground truth or to force exact results.
+**
+** Parameters and returns as for diskann_search_filtered().
+*/
+int diskann_search_exact(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                         int k, DiskAnnResult *results,
+                         DiskAnnFilterFn filter_fn, void *filter_ctx);
+
+/*
+** Search for the k nearest neighbors of many queries at once.
+**
+** Queries run concurrently on up to num_threads workers. Each worker opens
+** its own read-only connection to the index's database file and keeps its
+** own search context; all of them share the read-side node cache (see
+** diskann_set_cache_budget()) and start from the same entry point. Runs
+** sequentially on the caller's connection when the database has no file
+** (":memory:" or temp), the connection holds uncommitted writes (other
+** connections could not see them), SQLite was built without threading, or
+** only one worker would be used.
+**
+** Parameters:
+**   idx         - Index handle
+**   queries     - n_queries query vectors, row-major (dims floats each)
+**   n_queries   - Number of queries
+**   dims        - Query dimensions (must match index configuration)
+**   k           - Results per query
+**   results     - n_queries * k results: query q fills results[q * k ...]
+**   n_results   - n_queries counts: results found for each query
+**   num_threads - Worker threads (0 = one per online CPU)
+**
+** Returns:
+**   DISKANN_OK on success, or a negative error code (the first error any
+**   worker hit; other results are then undefined)
+*/
+int diskann_search_batch(DiskAnnIndex *idx, const float *queries,
+                         int n_queries, uint32_t dims, int k,
+                         DiskAnnResult *results, int *n_results,
+                         uint32_t num_threads);
+
+/*
+** diskann_search_batch() with per-query parameters applied to every query
+** (NULL = the handle's settings). DISKANN_SEARCH_EXACT scores all queries
+** in one pass over the rows.
+*/
+int diskann_search_batch_ex(DiskAnnIndex *idx, const float *queries,
+                            int n_queries, uint32_t dims, int k,
+                            const DiskAnnSearchParams *params,
+                            DiskAnnResult *results, int *n_results,
+                            uint32_t num_threads);
+
+/*
+** Set the byte budget of the shared read-side node cache.
+**
+** diskann_search() and diskann_search_filtered() normally re-read every
+** block from SQLite. With a budget set, blocks they read are kept in an
+** LRU cache owned by the index handle, so the hot region around the
+** entry point is served from memory across queries. Blocks rewritten or
+** deleted through this handle are evicted; the cache is cleared by
+** diskann_abort_batch() and when another connection commits to the
+** database. Blocks read inside a write transaction are not cached.
+**
+** Parameters:
+**   idx   - Index handle
+**   bytes - Memory budget (0 disables the cache, the default). Each
+**           entry costs about block_size bytes.
+**
+** Returns:
+**   DISKANN_OK on success (any previous cache contents are dropped)
+**   DISKANN_ERROR_INVALID if idx is NULL
+**   DISKANN_ERROR_NOMEM if allocation fails
+*/
+int diskann_set_cache_budget(DiskAnnIndex *idx, uint64_t bytes);
+
+/* Upper bound for diskann_set_beam_width() */
+#define DISKANN_MAX_BEAM_WIDTH 16
+
+/*
+** Set how many candidates each search hop expands.
+**
+** With the default width of 1, a search loads one block per hop and
+** scores its edges before choosing the next. A width W takes the W
+** closest unvisited candidates, loads all their blocks (in rowid order,
+** for B-tree locality) and then scores all their edges, so a cold-cache
+** search needs fewer dependent hops at the price of some extra reads.
+** Applies to diskann_search(), diskann_search_filtered() and
+** diskann_search_batch() on this handle; inserts always use 1. Not
+** persisted.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx is NULL or width is not in
+**   [1, DISKANN_MAX_BEAM_WIDTH]
+*/
+int diskann_set_beam_width(DiskAnnIndex *idx, uint32_t width);
+
+/* Default for diskann_set_exact_scan_threshold() */
+#define DISKANN_DEFAULT_EXACT_SCAN_ROWS 2048
+
+/*
+** Set the index size up to which searches scan instead of walking.
+**
+** While MAX(rowid) of the index is at most max_rows, diskann_search(),
+** diskann_search_filtered() and diskann_search_batch() answer with the
+** exact scan of diskann_search_exact(): at that size, reading every
+** node vector costs about as much as a graph walk and the results are
+** exact. 0 always walks the graph. Not persisted.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx is NULL
+*/
+int diskann_set_exact_scan_threshold(DiskAnnIndex *idx, uint32_t max_rows);
+
 /*
 ** Begin batch mode for multiple inserts.
 **
@@ -206,6 +535,11 @@ int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
 **     are deferred and applied in a single repair pass at end_batch(). Trades
 **     small-scale recall for ~30% insert speedup. Best at 10k+ vectors.
 **     Without this flag, batch mode only provides persistent BlobCache.
+**   DISKANN_BATCH_DEFERRED_DELETES - Queue immediate-mode diskann_delete()
+**     calls: queued rows disappear from searches at once and are removed
+**     together by diskann_delete_batch() at end_batch(), so each affected
+**     neighbor block is rewritten once. Inserting a queued id flushes the
+**     queue first. Tombstone-mode deletes are not queued.
 **
 ** Returns:
 **   DISKANN_OK on success
@@ -215,8 +549,22 @@ int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
 ** Caller must call diskann_end_batch() when done inserting.
 */
 #define DISKANN_BATCH_DEFERRED_EDGES 0x01
+#define DISKANN_BATCH_DEFERRED_DELETES 0x02
 int diskann_begin_batch(DiskAnnIndex *idx, int flags);
 
+/*
+** diskann_begin_batch() with the memory budget of deferred back-edges.
+** Deferred edges keep each inserted vector once plus 24 bytes per edge;
+** once they reach edge_budget_bytes, the insert that got them there
+** applies them in one sorted repair pass and deferring starts over.
+** diskann_begin_batch() uses 64 MiB.
+**
+** Returns DISKANN_ERROR_INVALID for a zero budget, otherwise as
+** diskann_begin_batch().
+*/
+int diskann_begin_batch_budget(DiskAnnIndex *idx, int flags,
+                               uint64_t edge_budget_bytes);
+
 /*
 ** End batch mode and free the persistent cache.
 **
@@ -247,15 +595,430 @@ int diskann_abort_batch(DiskAnnIndex *idx);
 /*
 ** Delete a vector from the index.
 **
+** In the default immediate mode the node's row is removed at once, along
+** with the back-edges its neighbors hold (one block write per neighbor).
+** In tombstone mode (see diskann_set_delete_mode()) only the node's own
+** block is rewritten with a tombstone flag: searches keep routing through
+** it but never return it, and diskann_consolidate() later repairs the
+** graph around all tombstones in one pass. Inserting the id again purges
+** its tombstone first.
+**
 ** Parameters:
 **   idx - Index handle
 **   id  - Vector ID to delete
 **
 ** Returns:
-**   DISKANN_OK on success, error code on failure
+**   DISKANN_OK on success
+**   DISKANN_ERROR_NOTFOUND if id is not in the index (or already deleted)
+**   Other error codes on failure
 */
 int diskann_delete(DiskAnnIndex *idx, int64_t id);
 
+/*
+** Delete many vectors at once, in one SAVEPOINT.
+**
+** Every node a deleted node links to drops its edges into the batch and
+** is offered the deleted nodes' remaining neighbors instead (the repair
+** diskann_consolidate() does), with each neighbor block rewritten once in
+** rowid order. Other in-edges stay behind as zombie edges, as with
+** diskann_delete(). Ids that are not in the index are skipped. Immediate mode
+** semantics apply in either delete mode: rows are removed, not tombstoned.
+**
+** Parameters:
+**   idx - Index handle
+**   ids - Vector IDs to delete (duplicates are fine)
+**   n   - Number of ids
+**
+** Returns:
+**   Number of vectors deleted (>= 0) on success
+**   Negative error code on failure (nothing is deleted)
+*/
+int diskann_delete_batch(DiskAnnIndex *idx, const int64_t *ids, int n);
+
+/* Delete modes for diskann_set_delete_mode() */
+#define DISKANN_DELETE_IMMEDIATE 0
+#define DISKANN_DELETE_TOMBSTONE 1
+
+/* Consolidation threshold the virtual table uses for delete_mode=tombstone */
+#define DISKANN_DEFAULT_CONSOLIDATE_THRESHOLD 1024
+
+/*
+** Choose how diskann_delete() removes vectors.
+**
+** Tombstone deletes cost one block write instead of one per neighbor, and
+** diskann_consolidate() reconnects the in-neighbors of every tombstoned
+** node (FreshDiskANN's delete consolidation) so recall does not drift.
+** The mode is persisted in the index metadata. Enabling tombstones marks
+** the index format_version 4, which older library builds refuse to open.
+**
+** Parameters:
+**   idx            - Index handle
+**   mode           - DISKANN_DELETE_IMMEDIATE or DISKANN_DELETE_TOMBSTONE
+**   consolidate_at - Tombstone count at which diskann_delete() runs
+**                    diskann_consolidate() itself (0 = only explicit calls)
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx is NULL or mode is unknown
+**   Other error codes on failure
+*/
+int diskann_set_delete_mode(DiskAnnIndex *idx, int mode,
+                            uint32_t consolidate_at);
+
+/*
+** Consolidate tombstoned deletes.
+**
+** Visits every live node once, in rowid order. A node with edges to
+** tombstoned nodes drops them and is offered the tombstoned nodes' live
+** neighbors instead, under the same pruning rule as inserts. The
+** tombstoned rows are then removed (with their PQ codes), and the entry
+** point moves if it was one of them. Runs inside one SAVEPOINT.
+**
+** Cost: a header read per node, plus one block rewrite per node that
+** pointed at a tombstone. Tombstoned blocks are each read once and kept in
+** a bounded cache while their in-neighbors are repaired.
+**
+** Parameters:
+**   idx - Index handle
+**
+** Returns:
+**   Number of tombstoned rows removed (0 when there were none), or a
+**   negative error code (the index is then unchanged)
+*/
+int diskann_consolidate(DiskAnnIndex *idx);
+
+/*
+** Rewrite the shadow table in graph-locality order.
+**
+** Tombstones are consolidated first (diskann_consolidate()). Every row is
+** then rewritten in breadth-first order from the entry point, so the
+** blocks of graph neighbors are stored on nearby database pages: a cold
+** search reads fewer, closer pages and keeps a smaller page-cache
+** footprint. The rewrite also repacks pages left sparse by deletes.
+** Rowids, edges and search results are unchanged. The virtual table
+** runs it on INSERT INTO t(t) VALUES('optimize').
+**
+** Cost: every block is read once and written twice (rows are staged in
+** a temporary database), inside one SAVEPOINT. VACUUM rewrites rows in
+** rowid order again, so run it after VACUUM rather than before.
+**
+** Parameters:
+**   idx - Index handle (not in batch mode)
+**
+** Returns:
+**   Number of rows rewritten (0 for an empty index), or a negative error
+**   code (the shadow table is then unchanged)
+*/
+int diskann_optimize(DiskAnnIndex *idx);
+
+/*
+** Re-pick the index entry point.
+**
+** Searches and inserts start their beam search from a persisted entry
+** node instead of a random row. This samples a few hundred nodes, takes
+** the one closest to their mean (an approximate medoid) and stores it in
+** the metadata table. diskann_end_batch() calls this automatically as the
+** index grows; call it directly after bulk loading without batch mode.
+**
+** Parameters:
+**   idx - Index handle
+**
+** Returns:
+**   DISKANN_OK on success (also for an empty index, which clears the entry
+**   point), error code on failure
+*/
+int diskann_refresh_entry_point(DiskAnnIndex *idx);
+
+/*
+** Recall calibration settings (see diskann_calibrate()). Zeroed fields
+** take the defaults.
+*/
+typedef struct DiskAnnCalibrateConfig {
+  uint32_t n_queries;  /* stored rows sampled as queries (0 = 100) */
+  uint32_t k;          /* recall@k to measure (0 = 10) */
+  float recall_target; /* target searches use by default (0 = 0.95) */
+} DiskAnnCalibrateConfig;
+
+/* Most points a recall curve keeps */
+#define DISKANN_MAX_RECALL_POINTS 16
+
+/*
+** Measure the index's recall curve and size search beams from it.
+**
+** Without a curve, searches widen the beam to sqrt(MAX(rowid)): more
+** than large indexes need, and inflated by rowid gaps. This samples
+** stored rows as queries, finds their true k nearest neighbors (the
+** query row itself excluded) with one exact scan, then measures
+** recall@k of graph searches at growing search list sizes until recall
+** reaches 1 or DISKANN_MAX_RECALL_POINTS sizes were tried. The curve and
+** recall_target are stored in the metadata table.
+**
+** Searches that set no search_list_size then use the smallest measured
+** size reaching their recall target (DiskAnnSearchParams.recall_target,
+** else the stored one), widened by sqrt(growth) as the index grows past
+** its calibrated size and by k / calibrated k for larger k. Calibrate
+** again after rebuilding or heavily changing the index.
+**
+** Cost: one exact scan of the index plus n_queries graph searches per
+** curve point. diskann_stats() does not count the searches and block
+** reads of calibration (the shared read cache does). The virtual table
+** runs it on INSERT INTO t(t) VALUES('calibrate').
+**
+** Parameters:
+**   idx    - Index handle (not read-only, not in batch mode)
+**   config - Calibration settings (NULL = defaults)
+**
+** Returns:
+**   Number of curve points stored (0 for an empty index, which keeps any
+**   previous curve), or a negative error code
+*/
+int diskann_calibrate(DiskAnnIndex *idx, const DiskAnnCalibrateConfig *config);
+
+/*
+** Copy the index's recall curve: up to max_points (search list size,
+** recall@k) pairs, ascending by size. Either array may be NULL.
+**
+** Returns:
+**   Number of points the curve has (0 = not calibrated), or
+**   DISKANN_ERROR_INVALID
+*/
+int diskann_recall_curve(const DiskAnnIndex *idx, uint32_t *search_list_sizes,
+                         float *recalls, int max_points);
+
+/*
+** Build (or rebuild) product-quantization routing codes for an index.
+**
+** Trains a codebook on up to sample_size vectors already in the index,
+** encodes every node into n_subvectors bytes and stores the codes in the
+** {index}_pq shadow tables. Codes are kept in RAM while the index is open
+** (loaded again by diskann_open_index()) and maintained by later inserts
+** and deletes. Searches then score candidate edges from the codes and
+** rerank visited nodes with their exact vectors.
+**
+** Parameters:
+**   idx          - Index handle (should already hold representative data)
+**   n_subvectors - Code bytes per vector, 1..dimensions (e.g. dims / 8)
+**   sample_size  - Training sample size (0 = DISKANN_PQ_DEFAULT_SAMPLE_SIZE)
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID for bad parameters
+**   DISKANN_ERROR_NOTFOUND if the index is empty
+**   Other error codes on failure (the previous codes, if any, are kept)
+*/
+#define DISKANN_PQ_DEFAULT_SAMPLE_SIZE 4096
+int diskann_pq_build(DiskAnnIndex *idx, uint32_t n_subvectors,
+                     uint32_t sample_size);
+
+/*
+** Progress callback for diskann_build(): called on the calling thread after
+** each insertion round with the number of nodes linked so far.
+*/
+typedef void (*DiskAnnProgressFn)(uint32_t processed, uint32_t total,
+                                  void *ctx);
+
+/* Options for diskann_build(); zero-initialize for defaults */
+typedef struct DiskAnnBuildConfig {
+  uint32_t num_threads;       /* Worker threads (0 = one per online CPU) */
+  DiskAnnProgressFn progress; /* Optional progress callback (NULL = none) */
+  void *progress_ctx;         /* Passed through to progress */
+} DiskAnnBuildConfig;
+
+/*
+** Build (or rebuild) the whole graph in memory from the stored vectors.
+**
+** Loads every vector in the index, constructs the Vamana graph in RAM with
+** a pool of worker threads (same insert_list_size, max_neighbors and
+** pruning_alpha as diskann_insert()), then rewrites every node block in a
+** single sorted pass inside one SAVEPOINT and makes the medoid the entry
+** point. Intended after a diskann_insert_vector() bulk load or to
+** re-index; existing edges are discarded. Later diskann_insert() calls
+** extend the built graph as usual.
+**
+** Memory: all vectors plus max_neighbors edges per node are held in RAM
+** for the duration of the call.
+**
+** Parameters:
+**   idx    - Index handle (not in batch mode)
+**   config - Build options (NULL = defaults)
+**
+** Returns:
+**   DISKANN_OK on success (also for an empty index)
+**   DISKANN_ERROR_INVALID for a NULL handle or while in batch mode
+**   Other error codes on failure (the previous graph is kept)
+*/
+int diskann_build(DiskAnnIndex *idx, const DiskAnnBuildConfig *config);
+
+/* DiskAnnStats.visited buckets: bucket 0 counts graph walks that visited
+** at most 1 node, bucket i walks that visited [2^i, 2^(i+1)) nodes; the
+** last bucket is open-ended */
+#define DISKANN_STATS_VISITED_BUCKETS 16
+
+/*
+** Cumulative counters of one index handle, since it was opened or last
+** reset (see diskann_stats()).
+*/
+typedef struct DiskAnnStats {
+  uint64_t blocks_read;    /* Node block reads, full or partial */
+  uint64_t blocks_written; /* Node block writes */
+  uint64_t bytes_read;     /* Bytes of those reads */
+  uint64_t bytes_written;  /* Bytes of those writes (a write may cover
+                           ** only the changed edge slots) */
+  /* Shared read cache (diskann_set_cache_budget()); shared with readers
+  ** and kept across diskann_stats_reset() */
+  uint64_t read_cache_hits;
+  uint64_t read_cache_misses;
+  /* Block caches of inserts and batch mode */
+  uint64_t insert_cache_hits;
+  uint64_t insert_cache_misses;
+  uint64_t searches;      /* Queries answered, graph walk or exact scan */
+  uint64_t nodes_visited; /* Nodes visited by graph walks */
+  uint64_t visited[DISKANN_STATS_VISITED_BUCKETS]; /* Walks by nodes
+                                                   ** visited */
+  uint64_t zombie_edges; /* Edges to deleted rows met by walks */
+  uint64_t inserts;      /* Successful diskann_insert()/_batch() nodes */
+  /* Latency percentiles in microseconds, estimated from a log-scale
+  ** histogram (within about 12%); 0 until the first sample */
+  double search_p50_us;
+  double search_p99_us;
+  double insert_p50_us;
+  double insert_p99_us;
+} DiskAnnStats;
+
+/*
+** Read the counters of an index handle.
+**
+** Counting is always on and costs a clock read per search or insert.
+** Each handle counts only its own work: readers (diskann_open_reader())
+** start from zero, and diskann_search_batch() adds its workers' counts
+** to the calling handle. The virtual table exposes the same counters as
+** the eponymous table "<table>_stats" on its connection.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx or out is NULL
+*/
+int diskann_stats(DiskAnnIndex *idx, DiskAnnStats *out);
+
+/*
+** Zero the counters of an index handle (the shared read cache keeps its
+** own).
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if idx is NULL
+*/
+int diskann_stats_reset(DiskAnnIndex *idx);
+
+/*
+** Partitioned indexes
+**
+** One logical index split over N shard indexes of the same name, each in
+** its own schema of one connection, typically separate database files
+** ATTACHed to it. Each shard is an ordinary index (create them with
+** diskann_create_index(), same configuration), so it has its own writer
+** file, WAL and vacuum. Bulk loads store vectors with
+** diskann_insert_vector() and link every shard in parallel with
+** diskann_shards_build().
+**
+** Rows are routed to a shard by a hash of their rowid
+** (diskann_shard_for()); layouts partitioned by some other key insert
+** through diskann_shard_index() instead. Searches fan out to every shard
+** and merge the per-shard top k.
+**
+** The virtual table builds on this: diskann(..., shards=s1:s2) keeps one
+** shard index per listed schema behind an unchanged SQL interface, routed
+** by rowid or by a metadata column declared PARTITION.
+*/
+typedef struct DiskAnnShards DiskAnnShards;
+
+/*
+** Open index_name in each of the n_shards schemas db_names on db.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if an argument is NULL, n_shards is not in
+**     1..DISKANN_MAX_SHARDS, or the shards differ in dimensions or metric
+**   DISKANN_ERROR_NOMEM if allocation fails
+**   or the error of the first shard that fails to open
+*/
+int diskann_open_shards(sqlite3 *db, const char *const *db_names,
+                        int n_shards, const char *index_name,
+                        DiskAnnShards **out);
+
+/* Most shards per diskann_open_shards() */
+#define DISKANN_MAX_SHARDS 256
+
+/* Close every shard and its search connections (NULL safe) */
+void diskann_close_shards(DiskAnnShards *shards);
+
+/*
+** Shard that rowid id routes to, into *shard: stable for a given shard
+** count. Returns DISKANN_OK, or DISKANN_ERROR_INVALID if an argument is
+** NULL.
+*/
+int diskann_shard_for(const DiskAnnShards *shards, int64_t id, int *shard);
+
+/* Number of shards (0 for NULL) */
+int diskann_shard_count(const DiskAnnShards *shards);
+
+/* Handle of shard i (0-based), or NULL. Owned by shards. */
+DiskAnnIndex *diskann_shard_index(DiskAnnShards *shards, int i);
+
+/* diskann_insert() / diskann_delete() on the shard id routes to */
+int diskann_shards_insert(DiskAnnShards *shards, int64_t id,
+                          const float *vector, uint32_t dims);
+int diskann_shards_delete(DiskAnnShards *shards, int64_t id);
+
+/*
+** Search every shard for the k nearest neighbors of query and merge them.
+**
+** Shards are searched concurrently on up to num_threads workers (0 = one
+** per shard). Each shard gets a read-only connection to its database
+** file, opened on the first concurrent search and kept until
+** diskann_close_shards(), with a reader of the shard's handle (see
+** diskann_open_reader()). Shards are searched one after another on the
+** caller's connection when any shard has no file (":memory:" or temp),
+** the connection holds uncommitted writes to a shard, SQLite was built
+** without threading, or one worker would do.
+**
+** Parameters:
+**   shards  - Handle from diskann_open_shards()
+**   query   - Query vector (dims floats)
+**   dims    - Query dimensions (must match the shards)
+**   k       - Number of results to return
+**   params  - Per-query parameters for every shard (NULL = each shard's)
+**   results - Result array (caller must allocate k elements)
+**   num_threads - Worker threads (0 = one per shard)
+**
+** Returns:
+**   Number of results found, or the first negative error code a shard
+**   returned
+*/
+int diskann_shards_search(DiskAnnShards *shards, const float *query,
+                          uint32_t dims, int k,
+                          const DiskAnnSearchParams *params,
+                          DiskAnnResult *results, uint32_t num_threads);
+
+/*
+** diskann_build() every shard, in parallel.
+**
+** Each worker opens its own read-write connection to a shard's file, so
+** shards build concurrently (config->num_threads, 0 = one per CPU, is
+** split between them and config->progress is not called). The shard
+** handles then re-read the stored entry points. Shards are built one
+** after another on the caller's connection instead when any shard has no
+** file, the connection is inside a transaction, or one worker would do.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if shards is NULL or a shard is in batch mode
+**   or the first error a shard's build returned (shards built in
+**   parallel keep their new graphs)
+*/
+int diskann_shards_build(DiskAnnShards *shards,
+                         const DiskAnnBuildConfig *config);
+
 /*
 ** Drop an index (delete all data).
 **
@@ -7,12 +7,20 @@
 ** MIT License
 */
 #include "diskann.h"
+#include "diskann_bitmap.h"
 #include "diskann_blob.h"
 #include "diskann_cache.h"
 #include "diskann_internal.h"
+#include "diskann_label.h"
 #include "diskann_node.h"
+#include "diskann_pq.h"
+#include "diskann_search.h"
+#include "diskann_snapshot.h"
+#include "diskann_stats.h"
 #include "diskann_util.h"
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,8 +32,20 @@
 #define DEFAULT_MAX_NEIGHBORS 32
 #define DEFAULT_SEARCH_LIST_SIZE 100
 #define DEFAULT_INSERT_LIST_SIZE 100 /* Reduced from 200 for faster builds */
-/* Format version for indices created by this code */
-#define CURRENT_FORMAT_VERSION 2
+/* Newest index format this code can open. Version 3 adds non-float32 edge
+** encodings, version 4 tombstoned nodes and version 5 half-precision
+** vectors; indexes are written at the lowest version their features need
+** so older library builds keep opening them. */
+#define CURRENT_FORMAT_VERSION 5
+#define FORMAT_VERSION_FLOAT32_EDGES 2
+#define FORMAT_VERSION_ENCODED_EDGES 3
+#define FORMAT_VERSION_TOMBSTONES 4
+#define FORMAT_VERSION_HALF_VECTORS 5
+/* Stored quantization bounds are fixed-point (x1e6) int64s */
+#define QUANT_FIXED_SCALE 1e6
+#define QUANT_MAX_ABS 1e12
+/* Number of INT8 code steps between quant_min and quant_max */
+#define INT8_CODE_STEPS 255.0f
 /* 1.4 leads to less aggressive pruning for better connectivity at scale */
 #define DEFAULT_PRUNING_ALPHA 1.4
 /* Maximum allowed values */
@@ -38,8 +58,8 @@
 ** insert/prune cycles.
 **
 ** Formula:
-**   node_overhead = NODE_METADATA_SIZE + (dimensions × sizeof(float))
-**   edge_overhead = (dimensions × sizeof(float)) + EDGE_METADATA_SIZE
+**   node_overhead = NODE_METADATA_SIZE + (dimensions × element size)
+**   edge_overhead = edge_vector_size(edge_type) + EDGE_METADATA_SIZE
 **   margin_neighbors = max_neighbors + (max_neighbors / 10)
 **   min_size = node_overhead + (margin_neighbors × edge_overhead)
 **   aligned = round up to 4KB boundary
@@ -47,17 +67,23 @@
 ** Returns 0 on error (overflow or invalid inputs).
 */
 static uint32_t calculate_block_size(uint32_t dimensions,
-                                     uint32_t max_neighbors) {
+                                     uint32_t max_neighbors,
+                                     uint8_t edge_type, uint8_t vector_type) {
   if (dimensions == 0 || max_neighbors == 0) {
     return 0;
   }
 
   /* Node overhead: metadata + vector */
-  uint64_t node_vector_size = (uint64_t)dimensions * sizeof(float);
+  uint64_t node_vector_size =
+      (uint64_t)dimensions * diskann_vector_element_size(vector_type);
   uint64_t node_overhead = NODE_METADATA_SIZE + node_vector_size;
 
-  /* Edge overhead: vector + metadata */
-  uint64_t edge_vector_size = (uint64_t)dimensions * sizeof(float);
+  /* Edge overhead: encoded vector + metadata */
+  uint64_t edge_vector_size =
+      diskann_edge_vector_size(edge_type, vector_type, dimensions);
+  if (edge_vector_size == 0) {
+    return 0;
+  }
   uint64_t edge_overhead = edge_vector_size + EDGE_METADATA_SIZE;
 
   /* Add 10% margin for safety (allow temporary over-subscription during
@@ -114,15 +140,83 @@ static int store_metadata_int(sqlite3 *db, const char *db_name,
   return (rc == SQLITE_DONE) ? DISKANN_OK : DISKANN_ERROR;
 }
 
+/* Set the INT8 decode parameters from fixed-point stored bounds */
+static void set_quant_range(DiskAnnIndex *idx, int64_t min_x1e6,
+                            int64_t max_x1e6) {
+  idx->quant_min = (float)((double)min_x1e6 / QUANT_FIXED_SCALE);
+  idx->quant_scale =
+      (float)((double)(max_x1e6 - min_x1e6) / QUANT_FIXED_SCALE) /
+      INT8_CODE_STEPS;
+}
+
+/* i of a "<prefix><i>" recall curve key, or -1 */
+static int recall_key_index(const char *key, const char *prefix) {
+  size_t len = strlen(prefix);
+  if (strncmp(key, prefix, len) != 0 || key[len] == '\0') {
+    return -1;
+  }
+  int i = 0;
+  for (key += len; *key; key++) {
+    if (*key < '0' || *key > '9' || i >= DISKANN_MAX_RECALL_POINTS) {
+      return -1;
+    }
+    i = i * 10 + (*key - '0');
+  }
+  return i < DISKANN_MAX_RECALL_POINTS ? i : -1;
+}
+
+/* One "recall_*" metadata key, prefix stripped, into curve */
+static void load_recall_key(DiskAnnRecallCurve *curve, const char *key,
+                            int64_t value) {
+  int i;
+  if (strcmp(key, "points") == 0) {
+    curve->n_points = value >= 0 && value <= DISKANN_MAX_RECALL_POINTS
+                          ? (int)value
+                          : -1;
+  } else if (strcmp(key, "k") == 0) {
+    curve->k = value > 0 && value <= UINT32_MAX ? (uint32_t)value : 0;
+  } else if (strcmp(key, "target_x1e6") == 0) {
+    curve->target = (float)((double)value / 1e6);
+  } else if (strcmp(key, "rows") == 0) {
+    curve->rows = value;
+  } else if ((i = recall_key_index(key, "l_")) >= 0) {
+    curve->search_list_size[i] =
+        value > 0 && value <= UINT32_MAX ? (uint32_t)value : 0;
+  } else if ((i = recall_key_index(key, "x1e6_")) >= 0) {
+    curve->recall[i] = (float)((double)value / 1e6);
+  }
+}
+
+/* Is a loaded curve complete: sizes ascending, recalls and target in
+** [0, 1]? An empty curve is valid (not calibrated). */
+static int recall_curve_valid(const DiskAnnRecallCurve *curve) {
+  if (curve->n_points == 0) {
+    return 1;
+  }
+  if (curve->n_points < 0 || curve->k == 0 || curve->rows <= 0 ||
+      !(curve->target > 0.0f && curve->target <= 1.0f)) {
+    return 0;
+  }
+  for (int i = 0; i < curve->n_points; i++) {
+    if (curve->search_list_size[i] == 0 ||
+        (i > 0 &&
+         curve->search_list_size[i] <= curve->search_list_size[i - 1]) ||
+        !(curve->recall[i] >= 0.0f && curve->recall[i] <= 1.0f)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 /*
-** Check if a shadow table already exists for the given index.
+** Check if the {index_name}_{suffix} table exists.
 ** Returns 1 if exists, 0 if not, -1 on error.
 */
-static int shadow_table_exists(sqlite3 *db, const char *db_name,
-                               const char *index_name) {
+static int index_table_exists(sqlite3 *db, const char *db_name,
+                              const char *index_name, const char *suffix) {
   char *sql = sqlite3_mprintf("SELECT name FROM \"%w\".sqlite_master "
-                              "WHERE type='table' AND name='%q_shadow'",
-                              db_name, index_name);
+                              "WHERE type='table' AND name='%q_%q'",
+                              db_name, index_name, suffix);
   if (!sql)
     return -1;
 
@@ -137,6 +231,15 @@ static int shadow_table_exists(sqlite3 *db, const char *db_name,
   return (rc == SQLITE_ROW) ? 1 : 0;
 }
 
+/*
+** Check if a shadow table already exists for the given index.
+** Returns 1 if exists, 0 if not, -1 on error.
+*/
+static int shadow_table_exists(sqlite3 *db, const char *db_name,
+                               const char *index_name) {
+  return index_table_exists(db, db_name, index_name, "shadow");
+}
+
 int diskann_create_index(sqlite3 *db, const char *db_name,
                          const char *index_name, const DiskAnnConfig *config) {
   char *sql = NULL;
@@ -167,11 +270,28 @@ int diskann_create_index(sqlite3 *db, const char *db_name,
   if (config->dimensions == 0 || config->dimensions > MAX_DIMENSIONS) {
     return DISKANN_ERROR_DIMENSION;
   }
+  if (config->metric > DISKANN_METRIC_DOT) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (config->edge_type > DISKANN_EDGE_INT8 ||
+      config->vector_type > DISKANN_VECTOR_BFLOAT16) {
+    return DISKANN_ERROR_INVALID;
+  }
+  /* Both 0: the INT8 range is taken from the first vectors inserted */
+  float quant_min = config->quant_min;
+  float quant_max = config->quant_max;
+  int quant_auto = quant_min == 0.0f && quant_max == 0.0f;
+  if (!quant_auto &&
+      (!(quant_max > quant_min) || !(fabsf(quant_min) < QUANT_MAX_ABS) ||
+       !(fabsf(quant_max) < QUANT_MAX_ABS))) {
+    return DISKANN_ERROR_INVALID;
+  }
 
   /* Auto-calculate or validate block_size */
   uint32_t block_size = config->block_size;
   uint32_t min_required =
-      calculate_block_size(config->dimensions, config->max_neighbors);
+      calculate_block_size(config->dimensions, config->max_neighbors,
+                           config->edge_type, config->vector_type);
 
   if (min_required == 0) {
     /* Calculation failed (overflow or invalid inputs) */
@@ -259,8 +379,14 @@ int diskann_create_index(sqlite3 *db, const char *db_name,
   }
 
   /* Store format version (for future migration/compatibility) */
+  int64_t format_version = actual_config.edge_type == DISKANN_EDGE_FLOAT32
+                               ? FORMAT_VERSION_FLOAT32_EDGES
+                               : FORMAT_VERSION_ENCODED_EDGES;
+  if (actual_config.vector_type != DISKANN_VECTOR_FLOAT32) {
+    format_version = FORMAT_VERSION_HALF_VECTORS;
+  }
   rc = store_metadata_int(db, db_name, index_name, "format_version",
-                          (int64_t)CURRENT_FORMAT_VERSION);
+                          format_version);
   if (rc != DISKANN_OK)
     return rc;
 
@@ -295,6 +421,36 @@ int diskann_create_index(sqlite3 *db, const char *db_name,
   if (rc != DISKANN_OK)
     return rc;
 
+  if (actual_config.edge_type != DISKANN_EDGE_FLOAT32) {
+    rc = store_metadata_int(db, db_name, index_name, "edge_type",
+                            (int64_t)actual_config.edge_type);
+    if (rc != DISKANN_OK)
+      return rc;
+    if (quant_auto) {
+      rc = store_metadata_int(db, db_name, index_name, "quant_auto", 1);
+      if (rc != DISKANN_OK)
+        return rc;
+    } else {
+      /* Quantization range as fixed-point (×1e6), like pruning_alpha */
+      rc = store_metadata_int(
+          db, db_name, index_name, "quant_min_x1e6",
+          (int64_t)llround((double)quant_min * QUANT_FIXED_SCALE));
+      if (rc != DISKANN_OK)
+        return rc;
+      rc = store_metadata_int(
+          db, db_name, index_name, "quant_max_x1e6",
+          (int64_t)llround((double)quant_max * QUANT_FIXED_SCALE));
+      if (rc != DISKANN_OK)
+        return rc;
+    }
+  }
+  if (actual_config.vector_type != DISKANN_VECTOR_FLOAT32) {
+    rc = store_metadata_int(db, db_name, index_name, "vector_type",
+                            (int64_t)actual_config.vector_type);
+    if (rc != DISKANN_OK)
+      return rc;
+  }
+
   return DISKANN_OK;
 }
 
@@ -387,6 +543,7 @@ int diskann_open_index(sqlite3 *db, const char *db_name, const char *index_name,
 
   /* Read all metadata entries (stored as portable integers) */
   int64_t format_version = 0; /* 0 = not found (old index) */
+  int64_t quant_min_x1e6 = 0, quant_max_x1e6 = 0;
 
   while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
     const char *key = (const char *)sqlite3_column_text(stmt, 0);
@@ -411,8 +568,31 @@ int diskann_open_index(sqlite3 *db, const char *db_name, const char *index_name,
       idx->block_size = (uint32_t)value;
     } else if (strcmp(key, "pruning_alpha_x1000") == 0) {
       idx->pruning_alpha = (double)value / 1000.0;
+    } else if (strcmp(key, "edge_type") == 0) {
+      idx->edge_type = (uint8_t)value;
+    } else if (strcmp(key, "vector_type") == 0) {
+      idx->vector_type = (uint8_t)value;
+    } else if (strcmp(key, "quant_min_x1e6") == 0) {
+      quant_min_x1e6 = value;
+    } else if (strcmp(key, "quant_max_x1e6") == 0) {
+      quant_max_x1e6 = value;
+    } else if (strcmp(key, "quant_auto") == 0) {
+      idx->quant_auto = value != 0;
+    } else if (strcmp(key, "entry_rowid") == 0) {
+      idx->entry_rowid = value;
+      idx->has_entry = 1;
+    } else if (strcmp(key, "delete_mode") == 0) {
+      idx->delete_mode = (int)value;
+    } else if (strcmp(key, "consolidate_threshold") == 0) {
+      idx->consolidate_at =
+          value > 0 && value <= UINT32_MAX ? (uint32_t)value : 0;
+    } else if (strncmp(key, "recall_", 7) == 0) {
+      load_recall_key(&idx->recall, key + 7, value);
     }
   }
+  if (!recall_curve_valid(&idx->recall)) {
+    memset(&idx->recall, 0, sizeof(idx->recall)); /* search uncalibrated */
+  }
 
   sqlite3_finalize(stmt);
   stmt = NULL;
@@ -441,20 +621,47 @@ int diskann_open_index(sqlite3 *db, const char *db_name, const char *index_name,
     rc = DISKANN_ERROR;
     goto cleanup;
   }
+  if (idx->metric > DISKANN_METRIC_DOT) {
+    rc = DISKANN_ERROR;
+    goto cleanup;
+  }
+  if (idx->delete_mode != DISKANN_DELETE_IMMEDIATE &&
+      (idx->delete_mode != DISKANN_DELETE_TOMBSTONE ||
+       format_version < FORMAT_VERSION_TOMBSTONES)) {
+    rc = DISKANN_ERROR;
+    goto cleanup;
+  }
+  if (idx->vector_type != DISKANN_VECTOR_FLOAT32 &&
+      (format_version < FORMAT_VERSION_HALF_VECTORS ||
+       idx->vector_type > DISKANN_VECTOR_BFLOAT16)) {
+    rc = DISKANN_ERROR;
+    goto cleanup;
+  }
+  if (idx->edge_type != DISKANN_EDGE_FLOAT32) {
+    /* Encoded edges need a v3+ index and a valid quantization range; a
+    ** range derived from the data is stored by the first insert */
+    int has_range = quant_max_x1e6 > quant_min_x1e6;
+    if (format_version < FORMAT_VERSION_ENCODED_EDGES ||
+        idx->edge_type > DISKANN_EDGE_INT8 ||
+        (!has_range && !idx->quant_auto)) {
+      rc = DISKANN_ERROR;
+      goto cleanup;
+    }
+    if (has_range) {
+      set_quant_range(idx, quant_min_x1e6, quant_max_x1e6);
+    } else {
+      idx->quant_unsettled = 1;
+    }
+  }
 
-  /* Compute derived layout fields (float32-only: both sizes identical) */
-  idx->nNodeVectorSize = idx->dimensions * (uint32_t)sizeof(float);
-  idx->nEdgeVectorSize = idx->nNodeVectorSize;
+  diskann_init_derived(idx);
 
-  /* Default pruning_alpha if not stored (backwards compat with old indexes) */
-  if (idx->pruning_alpha == 0.0) {
-    idx->pruning_alpha = DEFAULT_PRUNING_ALPHA;
+  /* Load PQ routing codes if diskann_pq_build() was run on this index */
+  rc = diskann_pq_load(idx);
+  if (rc != DISKANN_OK) {
+    goto cleanup;
   }
 
-  /* Initialize statistics */
-  idx->num_reads = 0;
-  idx->num_writes = 0;
-
   /* Success - transfer ownership to caller */
   *out_index = idx;
   return DISKANN_OK;
@@ -473,10 +680,137 @@ cleanup:
   return rc;
 }
 
+void diskann_reader_init(DiskAnnIndex *reader, DiskAnnIndex *idx, sqlite3 *db,
+                         char *db_name) {
+  *reader = *idx;
+  reader->shared = idx;
+  reader->db = db;
+  reader->db_name = db_name;
+  reader->search_pool = NULL;
+  reader->blob_pool = NULL;
+  reader->dist_memo = NULL;
+  reader->batch_cache = NULL;
+  reader->deferred_edges = NULL;
+  reader->deferred_deletes = NULL;
+  memset(reader->stmts, 0, sizeof(reader->stmts)); /* prepared on idx->db */
+  reader->read_cache_data_version = 0;
+  reader->num_reads = 0;
+  reader->num_writes = 0;
+  reader->num_read_bytes = 0;
+  reader->num_write_bytes = 0;
+  memset(&reader->counters, 0, sizeof(reader->counters));
+}
+
+void diskann_reader_deinit(DiskAnnIndex *reader) {
+  diskann_stmts_finalize(reader);
+  if (reader->search_pool) {
+    diskann_search_ctx_deinit(reader->search_pool);
+    sqlite3_free(reader->search_pool);
+    reader->search_pool = NULL;
+  }
+  sqlite3_free(reader->db_name);
+  reader->db_name = NULL;
+  /* db is borrowed; names, PQ codes, labels, read cache and snapshot are
+  ** shared */
+}
+
+void diskann_reader_sync(DiskAnnIndex *reader) {
+  const DiskAnnIndex *idx = reader->shared;
+  if (!idx) {
+    return;
+  }
+  reader->pq = idx->pq;
+  reader->labels = idx->labels;
+  if (reader->read_cache != idx->read_cache) {
+    reader->read_cache = idx->read_cache;
+    reader->read_cache_data_version = 0;
+  }
+  reader->entry_rowid = idx->entry_rowid;
+  reader->has_entry = idx->has_entry;
+  reader->recall = idx->recall;
+  /* Unknown on the shared handle: keep the count this reader looked up */
+  if (idx->cached_max_rowid > 0) {
+    reader->cached_max_rowid = idx->cached_max_rowid;
+  }
+  if (!idx->quant_unsettled) {
+    reader->quant_min = idx->quant_min;
+    reader->quant_scale = idx->quant_scale;
+    reader->quant_unsettled = 0;
+  }
+}
+
+int diskann_open_reader(DiskAnnIndex *shared, sqlite3 *db,
+                        const char *db_name, DiskAnnIndex **out) {
+  if (!out) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+  /* A snapshot's readers need no connection */
+  if (!shared || shared->shared || (!db && !shared->snapshot)) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  DiskAnnIndex *reader = (DiskAnnIndex *)malloc(sizeof(DiskAnnIndex));
+  char *name = NULL;
+  if (db) {
+    name = sqlite3_mprintf("%s", db_name ? db_name : shared->db_name);
+  }
+  if (!reader || (db && !name)) {
+    free(reader);
+    sqlite3_free(name);
+    return DISKANN_ERROR_NOMEM;
+  }
+  diskann_reader_init(reader, shared, db, name);
+  *out = reader;
+  return DISKANN_OK;
+}
+
+void diskann_init_derived(DiskAnnIndex *idx) {
+  /* Compute derived layout fields */
+  idx->nNodeVectorSize =
+      idx->dimensions * diskann_vector_element_size(idx->vector_type);
+  idx->nEdgeVectorSize = diskann_edge_vector_size(
+      idx->edge_type, idx->vector_type, idx->dimensions);
+
+  /* Pick the widest distance kernel this CPU supports */
+  idx->simd_level = diskann_simd_level();
+  idx->distance = diskann_simd_distance_fn(idx->simd_level, idx->metric);
+  idx->dot = diskann_simd_kernels(idx->simd_level)->dot;
+  idx->l2_bounded = idx->metric == DISKANN_METRIC_EUCLIDEAN &&
+                            idx->vector_type == DISKANN_VECTOR_FLOAT32
+                        ? diskann_simd_kernels(idx->simd_level)->l2_bounded
+                        : NULL;
+  idx->half_distance =
+      diskann_simd_half_fn(idx->simd_level, idx->vector_type, idx->metric);
+
+  /* Default pruning_alpha if not stored (backwards compat with old indexes) */
+  if (idx->pruning_alpha == 0.0) {
+    idx->pruning_alpha = DEFAULT_PRUNING_ALPHA;
+  }
+
+  /* Initialize statistics */
+  idx->num_reads = 0;
+  idx->num_writes = 0;
+
+  idx->entry_refresh_at = DISKANN_ENTRY_REFRESH_MIN_INSERTS;
+  idx->beam_width = 1;
+  idx->exact_scan_max_rows = DISKANN_DEFAULT_EXACT_SCAN_ROWS;
+}
+
+static void deferred_deletes_free(DiskAnnIndex *idx);
+static int deferred_deletes_alloc(DiskAnnIndex *idx);
+
 void diskann_close_index(DiskAnnIndex *idx) {
   if (!idx) {
     return; /* Safe to call with NULL */
   }
+  if (idx->shared) {
+    diskann_reader_deinit(idx);
+    free(idx);
+    return;
+  }
+  deferred_deletes_free(idx); /* Unapplied: the transaction never ended */
+  diskann_stmts_finalize(idx);
 
   /* Clean up deferred edges if still active (safety net) */
   if (idx->deferred_edges) {
@@ -492,6 +826,31 @@ void diskann_close_index(DiskAnnIndex *idx) {
     idx->batch_cache = NULL;
   }
 
+  if (idx->read_cache) {
+    blob_cache_deinit(idx->read_cache);
+    sqlite3_free(idx->read_cache);
+    idx->read_cache = NULL;
+  }
+
+  if (idx->search_pool) {
+    diskann_search_ctx_deinit(idx->search_pool);
+    sqlite3_free(idx->search_pool);
+    idx->search_pool = NULL;
+  }
+
+  /* After the caches: their spots return to the pool */
+  blob_pool_free(idx->blob_pool);
+  idx->blob_pool = NULL;
+  diskann_dist_memo_free(idx->dist_memo);
+  idx->dist_memo = NULL;
+
+  diskann_pq_free(idx->pq);
+  idx->pq = NULL;
+  diskann_labels_free(idx->labels);
+  idx->labels = NULL;
+  diskann_snapshot_close(idx->snapshot);
+  idx->snapshot = NULL;
+
   /* Free malloc'd strings */
   if (idx->db_name) {
     sqlite3_free(idx->db_name);
@@ -514,10 +873,168 @@ void diskann_close_index(DiskAnnIndex *idx) {
   free(idx);
 }
 
-int diskann_begin_batch(DiskAnnIndex *idx, int flags) {
+/**************************************************************************
+** Prepared statement cache
+**
+** Every insert, delete and search runs a few fixed SQL statements. Each is
+** prepared once per handle and reset after use instead of being formatted
+** and compiled per call.
+**************************************************************************/
+
+/* Savepoint names by DiskAnnSavepoint */
+static const char *const savepoint_names[DISKANN_SAVEPOINT_COUNT] = {
+    "insert",       "insert_batch", "delete",
+    "delete_batch", "consolidate",  "optimize", "calibrate"};
+
+/* Statement op of savepoint sp: 0 SAVEPOINT, 1 RELEASE, 2 ROLLBACK TO */
+#define SAVEPOINT_STMT(sp, op) \
+  ((DiskAnnStmtId)(DISKANN_STMT_SAVEPOINT + 3 * (int)(sp) + (op)))
+
+/* SQL text of statement id (sqlite3_malloc'd, NULL on OOM) */
+static char *stmt_sql(const DiskAnnIndex *idx, DiskAnnStmtId id) {
+  switch (id) {
+  case DISKANN_STMT_RANDOM_ROW:
+    return sqlite3_mprintf("SELECT rowid FROM \"%w\".%s "
+                           "WHERE rowid >= (ABS(RANDOM()) %% "
+                           "(SELECT MAX(rowid) FROM \"%w\".%s)) + 1 LIMIT 1",
+                           idx->db_name, idx->shadow_name, idx->db_name,
+                           idx->shadow_name);
+  case DISKANN_STMT_FIRST_ROW:
+    return sqlite3_mprintf("SELECT rowid FROM \"%w\".%s LIMIT 1",
+                           idx->db_name, idx->shadow_name);
+  case DISKANN_STMT_MAX_ROWID:
+    return sqlite3_mprintf("SELECT MAX(rowid) FROM \"%w\".%s", idx->db_name,
+                           idx->shadow_name);
+  case DISKANN_STMT_DATA_VERSION:
+    return sqlite3_mprintf("PRAGMA \"%w\".data_version", idx->db_name);
+  case DISKANN_STMT_INSERT_ROW:
+    return sqlite3_mprintf("INSERT INTO \"%w\".%s (id, data) VALUES (?, ?)",
+                           idx->db_name, idx->shadow_name);
+  case DISKANN_STMT_DELETE_ROW:
+    return sqlite3_mprintf("DELETE FROM \"%w\".%s WHERE id = ?",
+                           idx->db_name, idx->shadow_name);
+  case DISKANN_STMT_TOMBSTONE_ADD:
+    return sqlite3_mprintf("INSERT INTO \"%w\".\"%w_metadata\" (key, value) "
+                           "VALUES ('tombstones', MAX(?1, 0)) "
+                           "ON CONFLICT(key) DO UPDATE SET "
+                           "value = MAX(value + ?1, 0)",
+                           idx->db_name, idx->index_name);
+  case DISKANN_STMT_QUANT_RANGE:
+    return sqlite3_mprintf(
+        "SELECT MAX(CASE key WHEN 'quant_min_x1e6' THEN value END), "
+        "MAX(CASE key WHEN 'quant_max_x1e6' THEN value END) "
+        "FROM \"%w\".\"%w_metadata\" "
+        "WHERE key IN ('quant_min_x1e6', 'quant_max_x1e6')",
+        idx->db_name, idx->index_name);
+  case DISKANN_STMT_PQ_INSERT:
+    return sqlite3_mprintf("INSERT OR REPLACE INTO \"%w\".\"%w_pq\" "
+                           "(id, code) VALUES (?, ?)",
+                           idx->db_name, idx->index_name);
+  case DISKANN_STMT_PQ_DELETE:
+    return sqlite3_mprintf("DELETE FROM \"%w\".\"%w_pq\" WHERE id = ?",
+                           idx->db_name, idx->index_name);
+  default:
+    break;
+  }
+
+  /* Savepoint statements, in SAVEPOINT_STMT() order */
+  static const char *const ops[3] = {"SAVEPOINT", "RELEASE", "ROLLBACK TO"};
+  int n = (int)id - DISKANN_STMT_SAVEPOINT;
+  return sqlite3_mprintf("%s diskann_%s_%s", ops[n % 3], savepoint_names[n / 3],
+                         idx->index_name);
+}
+
+sqlite3_stmt *diskann_stmt(DiskAnnIndex *idx, DiskAnnStmtId id) {
+  sqlite3_stmt *stmt = idx->stmts[id];
+  if (!idx->db) {
+    return NULL; /* snapshot handle */
+  }
+  if (stmt) {
+    sqlite3_reset(stmt); /* no-op unless a caller left it active */
+    return stmt;
+  }
+
+  char *sql = stmt_sql(idx, id);
+  if (!sql) {
+    return NULL;
+  }
+  int rc = sqlite3_prepare_v3(idx->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                              &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    return NULL;
+  }
+  idx->stmts[id] = stmt;
+  return stmt;
+}
+
+void diskann_stmts_finalize(DiskAnnIndex *idx) {
+  for (int i = 0; i < DISKANN_STMT_COUNT; i++) {
+    sqlite3_finalize(idx->stmts[i]);
+    idx->stmts[i] = NULL;
+  }
+}
+
+int diskann_set_cache_budget(DiskAnnIndex *idx, uint64_t bytes) {
+  /* A reader's cache is its shared handle's; snapshots need none */
+  if (!idx || diskann_is_read_only(idx)) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  /* Any resize starts from an empty cache */
+  if (idx->read_cache) {
+    blob_cache_deinit(idx->read_cache);
+    sqlite3_free(idx->read_cache);
+    idx->read_cache = NULL;
+  }
+
+  /* Each entry costs one block plus its BlobSpot header */
+  if (bytes < BLOB_CACHE_ENTRY_BYTES(idx->block_size)) {
+    return DISKANN_OK; /* disabled */
+  }
+
+  BlobCache *cache = (BlobCache *)sqlite3_malloc(sizeof(BlobCache));
+  if (!cache) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = blob_cache_init_bytes(cache, bytes, idx->block_size);
+  if (rc != DISKANN_OK) {
+    sqlite3_free(cache);
+    return rc;
+  }
+  blob_cache_enable_mutex(cache); /* shared with readers and workers */
+  idx->read_cache = cache;
+  idx->read_cache_data_version = 0;
+  return DISKANN_OK;
+}
+
+int diskann_set_beam_width(DiskAnnIndex *idx, uint32_t width) {
+  if (!idx || width == 0 || width > DISKANN_MAX_BEAM_WIDTH) {
+    return DISKANN_ERROR_INVALID;
+  }
+  idx->beam_width = width;
+  return DISKANN_OK;
+}
+
+int diskann_set_exact_scan_threshold(DiskAnnIndex *idx, uint32_t max_rows) {
   if (!idx) {
     return DISKANN_ERROR_INVALID;
   }
+  idx->exact_scan_max_rows = max_rows;
+  return DISKANN_OK;
+}
+
+int diskann_begin_batch(DiskAnnIndex *idx, int flags) {
+  return diskann_begin_batch_budget(idx, flags,
+                                    DEFERRED_EDGE_LIST_DEFAULT_BUDGET);
+}
+
+int diskann_begin_batch_budget(DiskAnnIndex *idx, int flags,
+                               uint64_t edge_budget_bytes) {
+  if (!idx || diskann_is_read_only(idx) || edge_budget_bytes == 0) {
+    return DISKANN_ERROR_INVALID;
+  }
   if (idx->batch_cache != NULL) {
     return DISKANN_ERROR_INVALID; /* Already in batch mode */
   }
@@ -546,9 +1063,8 @@ int diskann_begin_batch(DiskAnnIndex *idx, int flags) {
       idx->batch_cache = NULL;
       return DISKANN_ERROR_NOMEM;
     }
-    rc = deferred_edge_list_init(idx->deferred_edges,
-                                 DEFERRED_EDGE_LIST_DEFAULT_CAPACITY,
-                                 idx->nNodeVectorSize);
+    rc = deferred_edge_list_init(idx->deferred_edges, edge_budget_bytes,
+                                 idx->dimensions * (uint32_t)sizeof(float));
     if (rc != DISKANN_OK) {
       sqlite3_free(idx->deferred_edges);
       idx->deferred_edges = NULL;
@@ -559,6 +1075,14 @@ int diskann_begin_batch(DiskAnnIndex *idx, int flags) {
     }
   }
 
+  if (flags & DISKANN_BATCH_DEFERRED_DELETES) {
+    rc = deferred_deletes_alloc(idx);
+    if (rc != DISKANN_OK) {
+      diskann_abort_batch(idx);
+      return rc;
+    }
+  }
+
   return DISKANN_OK;
 }
 
@@ -580,11 +1104,206 @@ int diskann_end_batch(DiskAnnIndex *idx) {
     idx->deferred_edges = NULL;
   }
 
+  /* Then the queued deletes, repairing around them in one pass */
+  if (rc == DISKANN_OK) {
+    rc = diskann_flush_deletes(idx);
+  }
+  deferred_deletes_free(idx);
+
   /* Free cache (frees all owned BlobSpots in owning mode) */
+  diskann_stats_fold_cache(idx, idx->batch_cache);
   blob_cache_deinit(idx->batch_cache);
   sqlite3_free(idx->batch_cache);
   idx->batch_cache = NULL;
 
+  /* Re-pick the entry point as the index grows (geometric schedule keeps
+  ** the sampling cost amortized O(1) per insert) */
+  if (rc == DISKANN_OK && idx->entry_inserts >= idx->entry_refresh_at) {
+    rc = diskann_refresh_entry_point(idx);
+  }
+
+  return rc;
+}
+
+int diskann_set_entry_point(DiskAnnIndex *idx, int64_t rowid) {
+  int rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                              "entry_rowid", rowid);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  idx->entry_rowid = rowid;
+  idx->has_entry = 1;
+  idx->entry_inserts = 0;
+  return DISKANN_OK;
+}
+
+int diskann_clear_entry_point(DiskAnnIndex *idx) {
+  char *sql = sqlite3_mprintf("DELETE FROM \"%w\".\"%w_metadata\" "
+                              "WHERE key = 'entry_rowid'",
+                              idx->db_name, idx->index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  idx->has_entry = 0;
+  return DISKANN_OK;
+}
+
+int diskann_reload_entry_point(DiskAnnIndex *idx) {
+  sqlite3_stmt *stmt = NULL;
+  char *sql = sqlite3_mprintf("SELECT value FROM \"%w\".\"%w_metadata\" "
+                              "WHERE key = 'entry_rowid'",
+                              idx->db_name, idx->index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW) {
+    idx->entry_rowid = sqlite3_column_int64(stmt, 0);
+  }
+  idx->has_entry = rc == SQLITE_ROW;
+  idx->entry_inserts = 0;
+  sqlite3_finalize(stmt);
+  return rc == SQLITE_ROW || rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/*
+** Bounds for INT8 codes covering the components of n vectors. Values the
+** sample has not seen get a margin that shrinks as the sample grows: a
+** quarter span for one vector, 1/64 for 256 or more.
+*/
+static void derive_quant_bounds(const DiskAnnIndex *idx, const float *vectors,
+                                uint64_t n, int64_t *min_x1e6,
+                                int64_t *max_x1e6) {
+  float lo = INFINITY, hi = -INFINITY;
+  uint64_t count = n * idx->dimensions;
+  for (uint64_t i = 0; i < count; i++) {
+    float v = vectors[i];
+    if (isfinite(v)) {
+      lo = v < lo ? v : lo;
+      hi = v > hi ? v : hi;
+    }
+  }
+  if (!(hi >= lo)) {
+    lo = -1.0f; /* nothing finite: any range will do */
+    hi = 1.0f;
+  }
+  double span = (double)hi - (double)lo;
+  double margin;
+  if (span > 0.0) {
+    margin = span / (4.0 * sqrt((double)(n < 256 ? n : 256)));
+  } else {
+    margin = fabs((double)lo) > 0.0 ? fabs((double)lo) : 1.0;
+  }
+  double lo_d = fmax((double)lo - margin, -QUANT_MAX_ABS);
+  double hi_d = fmin((double)hi + margin, QUANT_MAX_ABS);
+  *min_x1e6 = (int64_t)floor(lo_d * QUANT_FIXED_SCALE);
+  *max_x1e6 = (int64_t)ceil(hi_d * QUANT_FIXED_SCALE);
+}
+
+int diskann_prepare_quant_range(DiskAnnIndex *idx, const float *vectors,
+                                uint64_t n) {
+  if (!idx->quant_unsettled) {
+    return DISKANN_OK;
+  }
+  sqlite3_stmt *stmt = diskann_stmt(idx, DISKANN_STMT_QUANT_RANGE);
+  if (!stmt) {
+    return DISKANN_ERROR;
+  }
+  int64_t min_x1e6 = 0, max_x1e6 = 0;
+  int step = sqlite3_step(stmt);
+  int has_range = step == SQLITE_ROW &&
+                  sqlite3_column_type(stmt, 0) != SQLITE_NULL &&
+                  sqlite3_column_type(stmt, 1) != SQLITE_NULL;
+  if (has_range) {
+    min_x1e6 = sqlite3_column_int64(stmt, 0);
+    max_x1e6 = sqlite3_column_int64(stmt, 1);
+  }
+  sqlite3_reset(stmt);
+  if (step != SQLITE_ROW) {
+    return DISKANN_ERROR;
+  }
+  if (has_range && max_x1e6 > min_x1e6) {
+    set_quant_range(idx, min_x1e6, max_x1e6);
+    /* Outside a write transaction the stored range is committed: stop
+    ** checking. Inside one it may yet be rolled back. */
+    if (sqlite3_txn_state(idx->db, idx->db_name) != SQLITE_TXN_WRITE) {
+      idx->quant_unsettled = 0;
+    }
+    return DISKANN_OK;
+  }
+  if (n == 0 || diskann_is_read_only(idx)) {
+    return DISKANN_OK; /* nothing to derive from yet */
+  }
+
+  /* Stored inside the caller's savepoint: a rollback takes the range
+  ** with the edges encoded by it, and the next insert derives again */
+  derive_quant_bounds(idx, vectors, n, &min_x1e6, &max_x1e6);
+  int rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                              "quant_min_x1e6", min_x1e6);
+  if (rc == DISKANN_OK) {
+    rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                            "quant_max_x1e6", max_x1e6);
+  }
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  set_quant_range(idx, min_x1e6, max_x1e6);
+  return DISKANN_OK;
+}
+
+int diskann_store_recall_curve(DiskAnnIndex *idx,
+                               const DiskAnnRecallCurve *curve) {
+  char *sql = sqlite3_mprintf("DELETE FROM \"%w\".\"%w_metadata\" "
+                              "WHERE key LIKE 'recall\\_%%' ESCAPE '\\'",
+                              idx->db_name, idx->index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int active = diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_CALIBRATE);
+  int rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL) == SQLITE_OK
+               ? DISKANN_OK
+               : DISKANN_ERROR;
+  sqlite3_free(sql);
+
+  const struct {
+    const char *key;
+    int64_t value;
+  } scalars[] = {
+      {"recall_points", curve->n_points},
+      {"recall_k", curve->k},
+      {"recall_target_x1e6", (int64_t)llround((double)curve->target * 1e6)},
+      {"recall_rows", curve->rows},
+  };
+  size_t n_scalars = sizeof(scalars) / sizeof(scalars[0]);
+  for (size_t i = 0; rc == DISKANN_OK && i < n_scalars; i++) {
+    rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                            scalars[i].key, scalars[i].value);
+  }
+  for (int i = 0; rc == DISKANN_OK && i < curve->n_points; i++) {
+    char key[32];
+    snprintf(key, sizeof(key), "recall_l_%d", i);
+    rc = store_metadata_int(idx->db, idx->db_name, idx->index_name, key,
+                            curve->search_list_size[i]);
+    if (rc == DISKANN_OK) {
+      snprintf(key, sizeof(key), "recall_x1e6_%d", i);
+      rc = store_metadata_int(idx->db, idx->db_name, idx->index_name, key,
+                              llround((double)curve->recall[i] * 1e6));
+    }
+  }
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_CALIBRATE, active, rc);
+  if (rc == DISKANN_OK) {
+    idx->recall = *curve;
+  }
   return rc;
 }
 
@@ -592,18 +1311,24 @@ int diskann_abort_batch(DiskAnnIndex *idx) {
   if (!idx) {
     return DISKANN_ERROR_INVALID;
   }
+
+  /* Blocks read inside the rolled-back transaction may be cached */
+  blob_cache_clear(idx->read_cache);
+
   if (idx->batch_cache == NULL) {
     return DISKANN_ERROR_INVALID; /* Not in batch mode */
   }
 
-  /* Discard deferred edges WITHOUT applying (rollback path) */
+  /* Discard deferred edges and deletes WITHOUT applying (rollback path) */
   if (idx->deferred_edges) {
     deferred_edge_list_deinit(idx->deferred_edges);
     sqlite3_free(idx->deferred_edges);
     idx->deferred_edges = NULL;
   }
+  deferred_deletes_free(idx);
 
   /* Free cache (frees all owned BlobSpots in owning mode) */
+  diskann_stats_fold_cache(idx, idx->batch_cache);
   blob_cache_deinit(idx->batch_cache);
   sqlite3_free(idx->batch_cache);
   idx->batch_cache = NULL;
@@ -612,7 +1337,7 @@ int diskann_abort_batch(DiskAnnIndex *idx) {
 }
 
 /*
-** Delete a vector from the index.
+** Immediate delete (DISKANN_DELETE_IMMEDIATE, and purging a tombstone).
 **
 ** Algorithm (conservative — no graph repair):
 ** 1. Load target node's BLOB to read its edge list
@@ -625,10 +1350,11 @@ int diskann_abort_batch(DiskAnnIndex *idx) {
 ** the NEIGHBOR's own rowid. This should be the deleted node's rowid. Our
 ** implementation fixes this.
 */
-int diskann_delete(DiskAnnIndex *idx, int64_t id) {
+static int tombstone_count_add(DiskAnnIndex *idx, int64_t delta);
+
+static int delete_node(DiskAnnIndex *idx, int64_t id) {
   BlobSpot *target_blob = NULL;
   BlobSpot *edge_blob = NULL;
-  char *sql = NULL;
   sqlite3_stmt *stmt = NULL;
   int rc = DISKANN_OK;
 
@@ -640,16 +1366,8 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
    * When called from vtab xUpdate, there's already an active SQL statement
    * so SAVEPOINT fails with SQLITE_BUSY. That's OK — the vtab's implicit
    * transaction provides atomicity. */
-  int savepoint_active = 0;
-  sql = sqlite3_mprintf("SAVEPOINT diskann_delete_%s", idx->index_name);
-  if (!sql)
-    return DISKANN_ERROR_NOMEM;
-  rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
-  sqlite3_free(sql);
-  sql = NULL;
-  if (rc == SQLITE_OK) {
-    savepoint_active = 1;
-  }
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_DELETE);
 
   /* Open read-only BlobSpot for target node */
   rc = blob_spot_create(idx, &target_blob, (uint64_t)id, idx->block_size,
@@ -661,13 +1379,16 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
   if (rc != DISKANN_OK)
     goto rollback;
 
-  /* Read target node data */
-  rc = blob_spot_reload(idx, target_blob, (uint64_t)id, idx->block_size);
+  /* Only the target's edge rowids are needed: skip its vectors */
+  rc = node_bin_load_adjacency(idx, target_blob, (uint64_t)id);
   if (rc != DISKANN_OK)
     goto rollback;
+  int was_tombstone = node_bin_is_tombstone(idx, target_blob);
 
   /* Read edge count and clean up back-edges from neighbors */
   uint16_t n_edges = node_bin_edges(idx, target_blob);
+  int64_t live_neighbor = 0; /* entry point replacement if id is the entry */
+  int has_live_neighbor = 0;
 
   if (n_edges > 0) {
     /* Create writable BlobSpot (initial rowid = target, which exists) */
@@ -680,12 +1401,17 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
       uint64_t edge_rowid;
       node_bin_edge(idx, target_blob, (int)i, &edge_rowid, NULL, NULL);
 
-      rc = blob_spot_reload(idx, edge_blob, edge_rowid, idx->block_size);
+      /* Check the neighbor's adjacency before reading the whole block */
+      rc = node_bin_load_adjacency(idx, edge_blob, edge_rowid);
       if (rc == DISKANN_ROW_NOT_FOUND) {
         continue; /* Zombie edge — neighbor already deleted */
       }
       if (rc != DISKANN_OK)
         goto rollback;
+      if (!has_live_neighbor) {
+        live_neighbor = (int64_t)edge_rowid;
+        has_live_neighbor = 1;
+      }
 
       /* Find back-edge pointing to the deleted node (NOT the neighbor's own id)
        */
@@ -694,6 +1420,10 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
         continue; /* No back-edge (unidirectional or already removed) */
       }
 
+      /* Deleting swaps in the last edge's vector: load the full block */
+      rc = blob_spot_reload(idx, edge_blob, edge_rowid, idx->block_size);
+      if (rc != DISKANN_OK)
+        goto rollback;
       node_bin_delete_edge(idx, edge_blob, del_idx);
       rc = blob_spot_flush(idx, edge_blob);
       if (rc != DISKANN_OK)
@@ -709,25 +1439,15 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
   target_blob = NULL;
 
   /* Delete shadow table row */
-  sql = sqlite3_mprintf("DELETE FROM \"%w\".%s WHERE id = ?", idx->db_name,
-                        idx->shadow_name);
-  if (!sql) {
-    rc = DISKANN_ERROR_NOMEM;
-    goto rollback;
-  }
-
-  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
-  sqlite3_free(sql);
-  sql = NULL;
-  if (rc != SQLITE_OK) {
-    rc = DISKANN_ERROR;
+  stmt = diskann_stmt(idx, DISKANN_STMT_DELETE_ROW);
+  if (!stmt) {
+    rc = DISKANN_ERROR;
     goto rollback;
   }
 
   sqlite3_bind_int64(stmt, 1, id);
   rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
-  stmt = NULL;
+  sqlite3_reset(stmt);
 
   if (rc != SQLITE_DONE) {
     rc = DISKANN_ERROR;
@@ -740,39 +1460,598 @@ int diskann_delete(DiskAnnIndex *idx, int64_t id) {
     goto rollback;
   }
 
-  /* Release SAVEPOINT — commit */
-  if (savepoint_active) {
-    sql = sqlite3_mprintf("RELEASE diskann_delete_%s", idx->index_name);
-    if (!sql) {
-      rc = DISKANN_ERROR_NOMEM;
+  /* A cached copy would resurrect the node for later searches */
+  blob_cache_remove(idx->read_cache, (uint64_t)id);
+
+  rc = diskann_pq_remove_vector(idx, id);
+  if (rc != DISKANN_OK) {
+    goto rollback;
+  }
+  diskann_labels_remove(idx->labels, id);
+  if (was_tombstone) {
+    rc = tombstone_count_add(idx, -1);
+    if (rc != DISKANN_OK) {
+      goto rollback;
+    }
+  }
+
+  /* Deleting the entry point hands it to a live neighbor (close to the
+  ** old medoid); with no neighbors left, fall back to random starts */
+  if (idx->has_entry && idx->entry_rowid == id) {
+    rc = has_live_neighbor ? diskann_set_entry_point(idx, live_neighbor)
+                           : diskann_clear_entry_point(idx);
+    if (rc != DISKANN_OK) {
       goto rollback;
     }
-    rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
-    sqlite3_free(sql);
-    return (rc == SQLITE_OK) ? DISKANN_OK : DISKANN_ERROR;
   }
-  return DISKANN_OK;
+
+  /* Release SAVEPOINT — commit */
+  return diskann_end_savepoint(idx, DISKANN_SAVEPOINT_DELETE, savepoint_active,
+                               DISKANN_OK);
 
 rollback:
   if (target_blob)
     blob_spot_free(target_blob);
   if (edge_blob)
     blob_spot_free(edge_blob);
-  if (stmt)
-    sqlite3_finalize(stmt);
 
-  if (savepoint_active) {
-    sql = sqlite3_mprintf("ROLLBACK TO diskann_delete_%s; "
-                          "RELEASE diskann_delete_%s",
-                          idx->index_name, idx->index_name);
-    if (sql) {
-      sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
-      sqlite3_free(sql);
+  return diskann_end_savepoint(idx, DISKANN_SAVEPOINT_DELETE, savepoint_active,
+                               rc);
+}
+
+/**************************************************************************
+** Tombstone deletes (DISKANN_DELETE_TOMBSTONE)
+**
+** A tombstone is a flag in the node's own block (NODE_FLAG_TOMBSTONE), so
+** searches on every connection see it as soon as it commits and a
+** rollback takes it back. The "tombstones" metadata key counts them for
+** the consolidation trigger.
+**************************************************************************/
+
+static int exec_index_sql(const DiskAnnIndex *idx, char *sql) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Run a cached statement that returns no rows */
+static int step_stmt(DiskAnnIndex *idx, DiskAnnStmtId id) {
+  sqlite3_stmt *stmt = diskann_stmt(idx, id);
+  if (!stmt) {
+    return DISKANN_ERROR;
+  }
+  int rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  return rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+}
+
+int diskann_begin_savepoint(DiskAnnIndex *idx, DiskAnnSavepoint sp) {
+  return step_stmt(idx, SAVEPOINT_STMT(sp, 0)) == DISKANN_OK;
+}
+
+int diskann_end_savepoint(DiskAnnIndex *idx, DiskAnnSavepoint sp, int active,
+                          int rc) {
+  if (!active) {
+    return rc;
+  }
+  blob_cache_release_handles(idx->batch_cache);
+  if (rc != DISKANN_OK) {
+    step_stmt(idx, SAVEPOINT_STMT(sp, 2));
+  }
+  int release_rc = step_stmt(idx, SAVEPOINT_STMT(sp, 1));
+  return rc == DISKANN_OK ? release_rc : rc;
+}
+
+/* Read an integer metadata key into *value (0 when absent) */
+static int load_metadata_int(const DiskAnnIndex *idx, const char *key,
+                             int64_t *value) {
+  sqlite3_stmt *stmt = NULL;
+  char *sql = sqlite3_mprintf("SELECT value FROM \"%w\".\"%w_metadata\" "
+                              "WHERE key = ?",
+                              idx->db_name, idx->index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  *value = rc == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+  sqlite3_finalize(stmt);
+  return rc == SQLITE_ROW || rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Adjust the persisted tombstone count (never below zero) */
+static int tombstone_count_add(DiskAnnIndex *idx, int64_t delta) {
+  sqlite3_stmt *stmt = diskann_stmt(idx, DISKANN_STMT_TOMBSTONE_ADD);
+  if (!stmt) {
+    return DISKANN_ERROR;
+  }
+  sqlite3_bind_int64(stmt, 1, delta);
+  int rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  return rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Set the tombstone flag in id's block: a single block write */
+static int tombstone_node(DiskAnnIndex *idx, int64_t id) {
+  BlobSpot *spot = NULL;
+
+  /* A batch-cached copy of the block would later be flushed over the flag */
+  blob_cache_remove(idx->batch_cache, (uint64_t)id);
+
+  int rc = blob_spot_create(idx, &spot, (uint64_t)id, idx->block_size,
+                            DISKANN_BLOB_WRITABLE);
+  if (rc == DISKANN_OK) {
+    rc = blob_spot_reload(idx, spot, (uint64_t)id, idx->block_size);
+  }
+  if (rc == DISKANN_ROW_NOT_FOUND ||
+      (rc == DISKANN_OK && node_bin_is_tombstone(idx, spot))) {
+    rc = DISKANN_ERROR_NOTFOUND;
+  }
+  if (rc == DISKANN_OK) {
+    node_bin_set_flags(idx, spot,
+                       node_bin_flags(idx, spot) | NODE_FLAG_TOMBSTONE);
+    rc = blob_spot_flush(idx, spot);
+  }
+  blob_spot_free(spot);
+  return rc;
+}
+
+static int delete_tombstone(DiskAnnIndex *idx, int64_t id) {
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_DELETE);
+  int rc = tombstone_node(idx, id);
+  if (rc == DISKANN_OK) {
+    rc = tombstone_count_add(idx, 1);
+  }
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_DELETE, savepoint_active,
+                             rc);
+  if (rc != DISKANN_OK || idx->consolidate_at == 0) {
+    return rc;
+  }
+
+  int64_t count;
+  rc = load_metadata_int(idx, "tombstones", &count);
+  if (rc == DISKANN_OK && count >= (int64_t)idx->consolidate_at) {
+    int n = diskann_consolidate(idx);
+    rc = n < 0 ? n : DISKANN_OK;
+  }
+  return rc;
+}
+
+static int queue_delete(DiskAnnIndex *idx, int64_t id);
+
+int diskann_delete(DiskAnnIndex *idx, int64_t id) {
+  if (!idx || diskann_is_read_only(idx))
+    return DISKANN_ERROR_INVALID;
+  if (idx->delete_mode == DISKANN_DELETE_TOMBSTONE) {
+    return delete_tombstone(idx, id);
+  }
+  if (idx->deferred_deletes) {
+    return queue_delete(idx, id);
+  }
+  return delete_node(idx, id);
+}
+
+int diskann_set_delete_mode(DiskAnnIndex *idx, int mode,
+                            uint32_t consolidate_at) {
+  if (!idx || diskann_is_read_only(idx) ||
+      (mode != DISKANN_DELETE_IMMEDIATE && mode != DISKANN_DELETE_TOMBSTONE)) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  int rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                              "delete_mode", mode);
+  if (rc == DISKANN_OK) {
+    rc = store_metadata_int(idx->db, idx->db_name, idx->index_name,
+                            "consolidate_threshold", consolidate_at);
+  }
+  if (rc == DISKANN_OK && mode == DISKANN_DELETE_TOMBSTONE) {
+    /* Builds that ignore the flag would return tombstoned rows */
+    rc = exec_index_sql(
+        idx, sqlite3_mprintf("UPDATE \"%w\".\"%w_metadata\" SET value = %d "
+                             "WHERE key = 'format_version' AND value < %d",
+                             idx->db_name, idx->index_name,
+                             FORMAT_VERSION_TOMBSTONES,
+                             FORMAT_VERSION_TOMBSTONES));
+  }
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  idx->delete_mode = mode;
+  idx->consolidate_at = consolidate_at;
+  return DISKANN_OK;
+}
+
+int diskann_node_exists(DiskAnnIndex *idx, int64_t id) {
+  BlobSpot *spot = NULL;
+  int rc = blob_spot_create(idx, &spot, (uint64_t)id, idx->block_size,
+                            DISKANN_BLOB_READONLY);
+  if (rc == DISKANN_OK) {
+    rc = blob_spot_seek(idx, spot, (uint64_t)id);
+  }
+  if (rc == DISKANN_OK) {
+    rc = blob_spot_read_range(idx, spot, 0, NODE_METADATA_SIZE);
+  }
+  if (rc == DISKANN_OK) {
+    rc = diskann_node_is_live(idx, spot);
+  } else if (rc == DISKANN_ROW_NOT_FOUND) {
+    rc = 0;
+  }
+  blob_spot_free(spot);
+  return rc;
+}
+
+int diskann_node_is_live(const DiskAnnIndex *idx, const BlobSpot *spot) {
+  if (node_bin_is_tombstone(idx, spot)) {
+    return 0;
+  }
+  return !idx->deferred_deletes ||
+         !diskann_bitmap_contains(idx->deferred_deletes->set,
+                                  (int64_t)spot->rowid);
+}
+
+int diskann_purge_tombstone(DiskAnnIndex *idx, int64_t id) {
+  int rc = diskann_node_exists(idx, id);
+  if (rc < 0) {
+    return rc;
+  }
+  if (rc == 1) {
+    return DISKANN_ERROR_EXISTS;
+  }
+  return delete_node(idx, id); /* NOTFOUND when there is no block at all */
+}
+
+/*
+** Collect every tombstoned rowid into dead, reading only node headers, in
+** rowid order.
+*/
+static int collect_tombstones(DiskAnnIndex *idx, DiskAnnBitmap *dead) {
+  sqlite3_stmt *stmt = NULL;
+  BlobSpot *spot = NULL;
+  char *sql = sqlite3_mprintf("SELECT id FROM \"%w\".%s ORDER BY id",
+                              idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t rowid = sqlite3_column_int64(stmt, 0);
+    rc = spot ? DISKANN_OK
+              : blob_spot_create(idx, &spot, (uint64_t)rowid, idx->block_size,
+                                 DISKANN_BLOB_READONLY);
+    if (rc == DISKANN_OK) {
+      rc = blob_spot_seek(idx, spot, (uint64_t)rowid);
+    }
+    if (rc == DISKANN_OK) {
+      rc = blob_spot_read_range(idx, spot, 0, NODE_METADATA_SIZE);
+    }
+    if (rc == DISKANN_OK && node_bin_is_tombstone(idx, spot)) {
+      rc = diskann_bitmap_add(dead, rowid);
+    }
+    if (rc != DISKANN_OK) {
+      break;
+    }
+  }
+  if (rc == SQLITE_DONE) {
+    rc = DISKANN_OK;
+  } else if (rc > 0) {
+    rc = DISKANN_ERROR;
+  }
+
+  sqlite3_finalize(stmt);
+  blob_spot_free(spot);
+  return rc;
+}
+
+/*
+** Delete the rows in dead with their PQ codes and labels. An entry point
+** among them is re-picked.
+*/
+static int drop_nodes(DiskAnnIndex *idx, const DiskAnnBitmap *dead) {
+  sqlite3_stmt *stmt = NULL;
+  DiskAnnBitmapIter it;
+  int64_t rowid;
+  char *sql = sqlite3_mprintf("DELETE FROM \"%w\".%s WHERE id = ?",
+                              idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+
+  rc = DISKANN_OK;
+  diskann_bitmap_iter_init(&it, dead);
+  while (rc == DISKANN_OK && diskann_bitmap_next(&it, &rowid)) {
+    sqlite3_bind_int64(stmt, 1, rowid);
+    rc = sqlite3_step(stmt) == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+    sqlite3_reset(stmt);
+    if (rc == DISKANN_OK) {
+      blob_cache_remove(idx->read_cache, (uint64_t)rowid);
+      blob_cache_remove(idx->batch_cache, (uint64_t)rowid);
+      diskann_labels_remove(idx->labels, rowid);
+      rc = diskann_pq_remove_vector(idx, rowid);
     }
   }
+  sqlite3_finalize(stmt);
+
+  if (rc == DISKANN_OK && idx->has_entry &&
+      diskann_bitmap_contains(dead, idx->entry_rowid)) {
+    rc = diskann_refresh_entry_point(idx);
+  }
+  return rc;
+}
+
+/* drop_nodes() for every tombstone, resetting the tombstone count */
+static int drop_tombstones(DiskAnnIndex *idx, const DiskAnnBitmap *dead) {
+  int rc = drop_nodes(idx, dead);
+  if (rc == DISKANN_OK) {
+    rc = exec_index_sql(idx,
+                        sqlite3_mprintf("DELETE FROM \"%w\".\"%w_metadata\" "
+                                        "WHERE key = 'tombstones'",
+                                        idx->db_name, idx->index_name));
+  }
   return rc;
 }
 
+void diskann_discard_cached_state(DiskAnnIndex *idx) {
+  blob_cache_clear(idx->read_cache);
+  blob_cache_clear(idx->batch_cache);
+  (void)diskann_labels_reload(idx);
+}
+
+int diskann_consolidate(DiskAnnIndex *idx) {
+  DiskAnnBitmap dead;
+  int64_t count;
+
+  if (!idx || diskann_is_read_only(idx)) {
+    return DISKANN_ERROR_INVALID;
+  }
+  int rc = load_metadata_int(idx, "tombstones", &count);
+  if (rc != DISKANN_OK || count == 0) {
+    return rc;
+  }
+
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_CONSOLIDATE);
+  diskann_bitmap_init(&dead);
+  rc = collect_tombstones(idx, &dead);
+  if (rc == DISKANN_OK && dead.count > 0) {
+    rc = diskann_consolidate_edges(idx, &dead, NULL);
+  }
+  if (rc == DISKANN_OK) {
+    rc = drop_tombstones(idx, &dead);
+  }
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_CONSOLIDATE,
+                             savepoint_active, rc);
+  if (rc != DISKANN_OK) {
+    diskann_discard_cached_state(idx);
+  }
+
+  int n = (int)(dead.count > INT_MAX ? INT_MAX : dead.count);
+  diskann_bitmap_deinit(&dead);
+  return rc == DISKANN_OK ? n : rc;
+}
+
+/*
+** Remove tombstoned rows before diskann_build() rebuilds the graph: the
+** rebuild drops every edge, so no rewiring is needed.
+*/
+int diskann_drop_tombstones(DiskAnnIndex *idx) {
+  DiskAnnBitmap dead;
+  int64_t count;
+  int rc = load_metadata_int(idx, "tombstones", &count);
+  if (rc != DISKANN_OK || count == 0) {
+    return rc;
+  }
+  diskann_bitmap_init(&dead);
+  rc = collect_tombstones(idx, &dead);
+  if (rc == DISKANN_OK) {
+    rc = drop_tombstones(idx, &dead);
+  }
+  diskann_bitmap_deinit(&dead);
+  return rc;
+}
+
+/**************************************************************************
+** Bulk deletes
+**************************************************************************/
+
+/*
+** Load each id's header and edge list: existing ids go into dead, their
+** neighbors into affected, and *n_tombstones counts tombstones among them.
+*/
+static int collect_batch(DiskAnnIndex *idx, const int64_t *ids, int n,
+                         DiskAnnBitmap *dead, DiskAnnBitmap *affected,
+                         int64_t *n_tombstones) {
+  BlobSpot *spot = NULL;
+  int rc = DISKANN_OK;
+
+  *n_tombstones = 0;
+  for (int i = 0; i < n && rc == DISKANN_OK; i++) {
+    if (diskann_bitmap_contains(dead, ids[i])) {
+      continue;
+    }
+    if (!spot) {
+      rc = blob_spot_create(idx, &spot, (uint64_t)ids[i], idx->block_size,
+                            DISKANN_BLOB_READONLY);
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        rc = DISKANN_OK;
+        continue;
+      }
+      if (rc != DISKANN_OK) {
+        break;
+      }
+    }
+    rc = node_bin_load_adjacency(idx, spot, (uint64_t)ids[i]);
+    if (rc == DISKANN_ROW_NOT_FOUND) {
+      rc = DISKANN_OK;
+      continue;
+    }
+    if (rc != DISKANN_OK) {
+      break;
+    }
+    *n_tombstones += node_bin_is_tombstone(idx, spot);
+    rc = diskann_bitmap_add(dead, ids[i]);
+    int n_edges = (int)node_bin_edges(idx, spot);
+    for (int e = 0; e < n_edges && rc == DISKANN_OK; e++) {
+      uint64_t edge_rowid;
+      node_bin_edge(idx, spot, e, &edge_rowid, NULL, NULL);
+      rc = diskann_bitmap_add(affected, (int64_t)edge_rowid);
+    }
+  }
+
+  blob_spot_free(spot);
+  return rc;
+}
+
+int diskann_delete_batch(DiskAnnIndex *idx, const int64_t *ids, int n) {
+  DiskAnnBitmap dead, affected;
+  int64_t n_tombstones = 0;
+
+  if (!idx || diskann_is_read_only(idx) || n < 0 || (n > 0 && !ids)) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_DELETE_BATCH);
+  diskann_bitmap_init(&dead);
+  diskann_bitmap_init(&affected);
+  int rc = collect_batch(idx, ids, n, &dead, &affected, &n_tombstones);
+  if (rc == DISKANN_OK && dead.count > 0) {
+    rc = diskann_consolidate_edges(idx, &dead, &affected);
+  }
+  if (rc == DISKANN_OK) {
+    rc = drop_nodes(idx, &dead);
+  }
+  if (rc == DISKANN_OK && n_tombstones > 0) {
+    rc = tombstone_count_add(idx, -n_tombstones);
+  }
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_DELETE_BATCH,
+                             savepoint_active, rc);
+  if (rc != DISKANN_OK) {
+    diskann_discard_cached_state(idx);
+  }
+
+  int deleted = (int)dead.count;
+  diskann_bitmap_deinit(&dead);
+  diskann_bitmap_deinit(&affected);
+  return rc == DISKANN_OK ? deleted : rc;
+}
+
+static void deferred_deletes_free(DiskAnnIndex *idx) {
+  DeferredDeleteList *list = idx->deferred_deletes;
+  if (!list) {
+    return;
+  }
+  diskann_bitmap_deinit(list->set);
+  sqlite3_free(list->set);
+  sqlite3_free(list->ids);
+  sqlite3_free(list);
+  idx->deferred_deletes = NULL;
+}
+
+static int deferred_deletes_alloc(DiskAnnIndex *idx) {
+  DeferredDeleteList *list =
+      (DeferredDeleteList *)sqlite3_malloc(sizeof(DeferredDeleteList));
+  if (!list) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(list, 0, sizeof(*list));
+  list->set = (DiskAnnBitmap *)sqlite3_malloc(sizeof(DiskAnnBitmap));
+  if (!list->set) {
+    sqlite3_free(list);
+    return DISKANN_ERROR_NOMEM;
+  }
+  diskann_bitmap_init(list->set);
+  idx->deferred_deletes = list;
+  return DISKANN_OK;
+}
+
+/* Queue a live id; NOTFOUND when it has no block or is already queued */
+static int queue_delete(DiskAnnIndex *idx, int64_t id) {
+  DeferredDeleteList *list = idx->deferred_deletes;
+  int rc = diskann_node_exists(idx, id);
+  if (rc <= 0) {
+    return rc == 0 ? DISKANN_ERROR_NOTFOUND : rc;
+  }
+  if (list->count == list->capacity) {
+    int capacity = list->capacity ? list->capacity * 2 : 256;
+    int64_t *ids = (int64_t *)sqlite3_realloc64(
+        list->ids, (uint64_t)capacity * sizeof(int64_t));
+    if (!ids) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    list->ids = ids;
+    list->capacity = capacity;
+  }
+  rc = diskann_bitmap_add(list->set, id);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  list->ids[list->count++] = id;
+  /* A cached copy would be returned by the next search */
+  blob_cache_remove(idx->read_cache, (uint64_t)id);
+  return DISKANN_OK;
+}
+
+int diskann_flush_deletes(DiskAnnIndex *idx) {
+  DeferredDeleteList *list = idx->deferred_deletes;
+  if (!list || list->count == 0) {
+    return DISKANN_OK;
+  }
+  int rc = diskann_delete_batch(idx, list->ids, list->count);
+  if (rc < 0) {
+    return rc;
+  }
+  return diskann_deferred_delete_truncate(idx, 0);
+}
+
+int diskann_deferred_delete_count(const DiskAnnIndex *idx) {
+  return idx->deferred_deletes ? idx->deferred_deletes->count : 0;
+}
+
+int diskann_deferred_delete_truncate(DiskAnnIndex *idx, int count) {
+  DeferredDeleteList *list = idx->deferred_deletes;
+  DiskAnnBitmap kept;
+  int rc = DISKANN_OK;
+
+  if (!list || count >= list->count) {
+    return DISKANN_OK;
+  }
+  /* The set has no removal: rebuild it from the kept ids */
+  diskann_bitmap_init(&kept);
+  for (int i = 0; i < count && rc == DISKANN_OK; i++) {
+    rc = diskann_bitmap_add(&kept, list->ids[i]);
+  }
+  if (rc != DISKANN_OK) {
+    diskann_bitmap_deinit(&kept);
+    return rc;
+  }
+  diskann_bitmap_deinit(list->set);
+  *list->set = kept;
+  list->count = count < 0 ? 0 : count;
+  return DISKANN_OK;
+}
+
 int diskann_drop_index(sqlite3 *db, const char *db_name,
                        const char *index_name) {
   char *sql = NULL;
@@ -858,6 +2137,21 @@ int diskann_drop_index(sqlite3 *db, const char *db_name,
     return DISKANN_ERROR;
   }
 
+  /* Drop PQ tables (only exist after diskann_pq_build()) */
+  sql = sqlite3_mprintf("DROP TABLE IF EXISTS \"%w\".\"%w_pq\"; "
+                        "DROP TABLE IF EXISTS \"%w\".\"%w_pq_codebook\"",
+                        db_name, index_name, db_name, index_name);
+  if (!sql)
+    return DISKANN_ERROR_NOMEM;
+
+  rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    if (err_msg)
+      sqlite3_free(err_msg);
+    return DISKANN_ERROR;
+  }
+
   return DISKANN_OK;
 }
 
@@ -902,5 +2196,47 @@ int diskann_clear_index(sqlite3 *db, const char *db_name,
     return DISKANN_ERROR;
   }
 
+  /* An empty index has no entry point, tombstones or recall curve */
+  sql = sqlite3_mprintf("DELETE FROM \"%w\".\"%w_metadata\" "
+                        "WHERE key IN ('entry_rowid', 'tombstones') "
+                        "OR key LIKE 'recall\\_%%' ESCAPE '\\'",
+                        db_name, index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
+  sqlite3_free(sql);
+
+  if (rc != SQLITE_OK) {
+    if (err_msg) {
+      sqlite3_free(err_msg);
+    }
+    return DISKANN_ERROR;
+  }
+
+  /* Delete PQ codes too; the trained codebook stays valid for new data */
+  rc = index_table_exists(db, db_name, index_name, "pq");
+  if (rc < 0) {
+    return DISKANN_ERROR;
+  }
+  if (rc == 1) {
+    sql = sqlite3_mprintf("DELETE FROM \"%w\".\"%w_pq\"", db_name,
+                          index_name);
+    if (!sql) {
+      return DISKANN_ERROR_NOMEM;
+    }
+
+    rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
+    sqlite3_free(sql);
+
+    if (rc != SQLITE_OK) {
+      if (err_msg) {
+        sqlite3_free(err_msg);
+      }
+      return DISKANN_ERROR;
+    }
+  }
+
   return DISKANN_OK;
 }
@@ -0,0 +1,294 @@
+/*
+** DiskANN rowid bitmap
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "diskann_bitmap.h"
+#include "diskann.h"
+#include "diskann_sqlite.h"
+#include <string.h>
+
+#define BITMAP_KEY(rowid) ((uint64_t)(rowid) >> 16)
+#define BITMAP_LOW(rowid) ((uint16_t)((uint64_t)(rowid)&0xFFFFu))
+
+/**************************************************************************
+** Containers
+**************************************************************************/
+
+/*
+** Index of the container for key, or of the position it would be
+** inserted at (*found = 0). Checks the last container first: filters
+** arrive in rowid order.
+*/
+static uint32_t find_container(const DiskAnnBitmap *bitmap, uint64_t key,
+                               int *found) {
+  uint32_t n = bitmap->n_containers;
+  if (n > 0 && bitmap->containers[n - 1].key <= key) {
+    *found = bitmap->containers[n - 1].key == key;
+    return *found ? n - 1 : n;
+  }
+  uint32_t lo = 0, hi = n;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (bitmap->containers[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *found = lo < n && bitmap->containers[lo].key == key;
+  return lo;
+}
+
+/* Position of low in a sorted array container, or its insertion point */
+static uint32_t array_find(const DiskAnnBitmapContainer *c, uint16_t low,
+                           int *found) {
+  if (c->count > 0 && c->array[c->count - 1] <= low) {
+    *found = c->array[c->count - 1] == low;
+    return *found ? c->count - 1 : c->count;
+  }
+  uint32_t lo = 0, hi = c->count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (c->array[mid] < low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *found = lo < c->count && c->array[lo] == low;
+  return lo;
+}
+
+/* Replace a full array container with the equivalent bitset */
+static int container_to_bitset(DiskAnnBitmapContainer *c) {
+  uint64_t *bits = (uint64_t *)sqlite3_malloc64(DISKANN_BITMAP_WORDS *
+                                                sizeof(uint64_t));
+  if (!bits) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(bits, 0, DISKANN_BITMAP_WORDS * sizeof(uint64_t));
+  for (uint32_t i = 0; i < c->count; i++) {
+    bits[c->array[i] >> 6] |= 1ULL << (c->array[i] & 63);
+  }
+  sqlite3_free(c->array);
+  c->array = NULL;
+  c->capacity = 0;
+  c->bits = bits;
+  return DISKANN_OK;
+}
+
+/* Add low to a container; *added = 1 when it was not yet a member */
+static int container_add(DiskAnnBitmapContainer *c, uint16_t low, int *added) {
+  int found;
+  *added = 0;
+
+  if (c->bits) {
+    uint64_t mask = 1ULL << (low & 63);
+    if (!(c->bits[low >> 6] & mask)) {
+      c->bits[low >> 6] |= mask;
+      c->count++;
+      *added = 1;
+    }
+    return DISKANN_OK;
+  }
+
+  uint32_t pos = array_find(c, low, &found);
+  if (found) {
+    return DISKANN_OK;
+  }
+  if (c->count == DISKANN_BITMAP_ARRAY_MAX) {
+    int rc = container_to_bitset(c);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+    return container_add(c, low, added);
+  }
+  if (c->count == c->capacity) {
+    uint32_t cap = c->capacity ? c->capacity * 2 : 4;
+    if (cap > DISKANN_BITMAP_ARRAY_MAX) {
+      cap = DISKANN_BITMAP_ARRAY_MAX;
+    }
+    uint16_t *array = (uint16_t *)sqlite3_realloc64(
+        c->array, (uint64_t)cap * sizeof(uint16_t));
+    if (!array) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    c->array = array;
+    c->capacity = cap;
+  }
+  memmove(c->array + pos + 1, c->array + pos,
+          (size_t)(c->count - pos) * sizeof(uint16_t));
+  c->array[pos] = low;
+  c->count++;
+  *added = 1;
+  return DISKANN_OK;
+}
+
+/**************************************************************************
+** Public API
+**************************************************************************/
+
+void diskann_bitmap_init(DiskAnnBitmap *bitmap) {
+  memset(bitmap, 0, sizeof(*bitmap));
+}
+
+void diskann_bitmap_deinit(DiskAnnBitmap *bitmap) {
+  for (uint32_t i = 0; i < bitmap->n_containers; i++) {
+    sqlite3_free(bitmap->containers[i].array);
+    sqlite3_free(bitmap->containers[i].bits);
+  }
+  sqlite3_free(bitmap->containers);
+  memset(bitmap, 0, sizeof(*bitmap));
+}
+
+int diskann_bitmap_copy(DiskAnnBitmap *dst, const DiskAnnBitmap *src) {
+  diskann_bitmap_init(dst);
+  if (src->n_containers == 0) {
+    return DISKANN_OK;
+  }
+  dst->containers = (DiskAnnBitmapContainer *)sqlite3_malloc64(
+      (uint64_t)src->n_containers * sizeof(DiskAnnBitmapContainer));
+  if (!dst->containers) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  dst->cap_containers = src->n_containers;
+  for (uint32_t i = 0; i < src->n_containers; i++) {
+    const DiskAnnBitmapContainer *from = &src->containers[i];
+    DiskAnnBitmapContainer *to = &dst->containers[i];
+    *to = *from;
+    to->array = NULL;
+    to->bits = NULL;
+    if (from->bits) {
+      to->bits = (uint64_t *)sqlite3_malloc64(DISKANN_BITMAP_WORDS *
+                                              sizeof(uint64_t));
+      if (to->bits) {
+        memcpy(to->bits, from->bits, DISKANN_BITMAP_WORDS * sizeof(uint64_t));
+      }
+    } else {
+      to->capacity = from->count;
+      to->array = (uint16_t *)sqlite3_malloc64(
+          (uint64_t)(from->count ? from->count : 1) * sizeof(uint16_t));
+      if (to->array) {
+        memcpy(to->array, from->array, from->count * sizeof(uint16_t));
+      }
+    }
+    dst->n_containers = i + 1;
+    if (!to->bits && !to->array) {
+      diskann_bitmap_deinit(dst);
+      return DISKANN_ERROR_NOMEM;
+    }
+  }
+  dst->count = src->count;
+  return DISKANN_OK;
+}
+
+int diskann_bitmap_add(DiskAnnBitmap *bitmap, int64_t rowid) {
+  uint64_t key = BITMAP_KEY(rowid);
+  int found, added;
+
+  uint32_t pos = find_container(bitmap, key, &found);
+  if (!found) {
+    if (bitmap->n_containers == bitmap->cap_containers) {
+      uint32_t cap = bitmap->cap_containers ? bitmap->cap_containers * 2 : 4;
+      DiskAnnBitmapContainer *containers =
+          (DiskAnnBitmapContainer *)sqlite3_realloc64(
+              bitmap->containers,
+              (uint64_t)cap * sizeof(DiskAnnBitmapContainer));
+      if (!containers) {
+        return DISKANN_ERROR_NOMEM;
+      }
+      bitmap->containers = containers;
+      bitmap->cap_containers = cap;
+    }
+    DiskAnnBitmapContainer *c = &bitmap->containers[pos];
+    memmove(c + 1, c,
+            (size_t)(bitmap->n_containers - pos) *
+                sizeof(DiskAnnBitmapContainer));
+    memset(c, 0, sizeof(*c));
+    c->key = key;
+    bitmap->n_containers++;
+  }
+
+  DiskAnnBitmapContainer *c = &bitmap->containers[pos];
+  int rc = container_add(c, BITMAP_LOW(rowid), &added);
+  if (rc != DISKANN_OK) {
+    if (c->count == 0) {
+      /* Drop the container created above */
+      memmove(c, c + 1,
+              (size_t)(bitmap->n_containers - pos - 1) *
+                  sizeof(DiskAnnBitmapContainer));
+      bitmap->n_containers--;
+    }
+    return rc;
+  }
+  bitmap->count += (uint64_t)added;
+  return DISKANN_OK;
+}
+
+int diskann_bitmap_contains(const DiskAnnBitmap *bitmap, int64_t rowid) {
+  int found;
+  uint32_t pos = find_container(bitmap, BITMAP_KEY(rowid), &found);
+  if (!found) {
+    return 0;
+  }
+  const DiskAnnBitmapContainer *c = &bitmap->containers[pos];
+  uint16_t low = BITMAP_LOW(rowid);
+  if (c->bits) {
+    return (c->bits[low >> 6] >> (low & 63)) & 1;
+  }
+  (void)array_find(c, low, &found);
+  return found;
+}
+
+size_t diskann_bitmap_bytes(const DiskAnnBitmap *bitmap) {
+  size_t bytes =
+      (size_t)bitmap->cap_containers * sizeof(DiskAnnBitmapContainer);
+  for (uint32_t i = 0; i < bitmap->n_containers; i++) {
+    const DiskAnnBitmapContainer *c = &bitmap->containers[i];
+    bytes += c->bits ? DISKANN_BITMAP_WORDS * sizeof(uint64_t)
+                     : (size_t)c->capacity * sizeof(uint16_t);
+  }
+  return bytes;
+}
+
+void diskann_bitmap_iter_init(DiskAnnBitmapIter *it,
+                              const DiskAnnBitmap *bitmap) {
+  it->bitmap = bitmap;
+  it->container = 0;
+  it->pos = 0;
+}
+
+int diskann_bitmap_next(DiskAnnBitmapIter *it, int64_t *rowid) {
+  const DiskAnnBitmap *bitmap = it->bitmap;
+
+  while (it->container < bitmap->n_containers) {
+    const DiskAnnBitmapContainer *c = &bitmap->containers[it->container];
+    uint64_t base = c->key << 16;
+
+    if (c->array) {
+      if (it->pos < c->count) {
+        *rowid = (int64_t)(base | c->array[it->pos++]);
+        return 1;
+      }
+    } else if (c->bits) {
+      while (it->pos < DISKANN_BITMAP_WORDS * 64) {
+        uint64_t word = c->bits[it->pos >> 6] >> (it->pos & 63);
+        if (word == 0) {
+          it->pos = (it->pos | 63) + 1; /* rest of this word is empty */
+          continue;
+        }
+        while (!(word & 1)) {
+          word >>= 1;
+          it->pos++;
+        }
+        *rowid = (int64_t)(base | it->pos++);
+        return 1;
+      }
+    }
+    it->container++;
+    it->pos = 0;
+  }
+  return 0;
+}
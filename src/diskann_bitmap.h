@@ -0,0 +1,103 @@
+/*
+** DiskANN rowid bitmap
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** Compressed set of int64 rowids in the style of roaring bitmaps, used to
+** hold the rows matching a metadata filter.
+**
+** Design:
+** - Rowids are split into a 48-bit key (rowid >> 16) and 16 low bits;
+**   each key owns a container, kept in a key-sorted array
+** - A container is a sorted uint16 array while it holds at most
+**   DISKANN_BITMAP_ARRAY_MAX members, and a 65536-bit bitset (8KB) after
+**   that, so sparse and dense ranges both stay compact
+** - Membership is a binary search over containers, then a binary search
+**   (array) or one bit test (bitset)
+** - Appending in ascending rowid order (e.g. from ORDER BY rowid) never
+**   moves existing containers or members
+*/
+#ifndef DISKANN_BITMAP_H
+#define DISKANN_BITMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Array containers convert to bitsets past this many members */
+#define DISKANN_BITMAP_ARRAY_MAX 4096
+#define DISKANN_BITMAP_WORDS 1024 /* 65536 bits */
+
+/*
+** Memory ownership:
+** - array / bits: owned by the container (exactly one is non-NULL)
+*/
+typedef struct DiskAnnBitmapContainer {
+  uint64_t key;      /* (uint64_t)rowid >> 16 */
+  uint32_t count;    /* Members */
+  uint32_t capacity; /* Allocated array slots (array form only) */
+  uint16_t *array;   /* Sorted low 16 bits, NULL in bitset form */
+  uint64_t *bits;    /* DISKANN_BITMAP_WORDS words, NULL in array form */
+} DiskAnnBitmapContainer;
+
+/*
+** Memory ownership:
+** - containers: owned array, sorted by key (freed in deinit)
+*/
+typedef struct DiskAnnBitmap {
+  DiskAnnBitmapContainer *containers;
+  uint32_t n_containers;
+  uint32_t cap_containers;
+  uint64_t count; /* Members across all containers */
+} DiskAnnBitmap;
+
+/* Iteration state for diskann_bitmap_next() */
+typedef struct DiskAnnBitmapIter {
+  const DiskAnnBitmap *bitmap;
+  uint32_t container;
+  uint32_t pos; /* Next array index or bit index within the container */
+} DiskAnnBitmapIter;
+
+/* Initialize an empty bitmap (no allocation) */
+void diskann_bitmap_init(DiskAnnBitmap *bitmap);
+
+/* Free all containers; the bitmap is empty and reusable afterwards */
+void diskann_bitmap_deinit(DiskAnnBitmap *bitmap);
+
+/*
+** Initialize dst as a copy of src. Returns DISKANN_OK or
+** DISKANN_ERROR_NOMEM (dst is then empty).
+*/
+int diskann_bitmap_copy(DiskAnnBitmap *dst, const DiskAnnBitmap *src);
+
+/*
+** Add rowid (no-op if present). Returns DISKANN_OK or DISKANN_ERROR_NOMEM
+** (the bitmap is unchanged on failure).
+*/
+int diskann_bitmap_add(DiskAnnBitmap *bitmap, int64_t rowid);
+
+/* Is rowid a member? */
+int diskann_bitmap_contains(const DiskAnnBitmap *bitmap, int64_t rowid);
+
+/* Bytes held by the containers (for cache accounting) */
+size_t diskann_bitmap_bytes(const DiskAnnBitmap *bitmap);
+
+/*
+** Iterate members in ascending (uint64_t)rowid order, so negative rowids
+** come last. The bitmap must not change during iteration.
+*/
+void diskann_bitmap_iter_init(DiskAnnBitmapIter *it,
+                              const DiskAnnBitmap *bitmap);
+
+/* Store the next member in *rowid and return 1, or return 0 at the end */
+int diskann_bitmap_next(DiskAnnBitmapIter *it, int64_t *rowid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_BITMAP_H */
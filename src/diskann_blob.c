@@ -8,6 +8,7 @@
 */
 #include "diskann_blob.h"
 #include "diskann.h"
+#include "diskann_cache.h"
 #include "diskann_internal.h"
 #include "diskann_sqlite.h"
 #include <assert.h>
@@ -33,6 +34,10 @@ static int convert_sqlite_error(DiskAnnIndex *idx, int rc) {
   return DISKANN_ERROR;
 }
 
+/* Buffer bytes a BlobPool keeps for reuse (about one insert walk of
+** typical blocks) */
+#define BLOB_POOL_BYTES (4 * 1024 * 1024)
+
 int blob_spot_create(DiskAnnIndex *idx, BlobSpot **out, uint64_t rowid,
                      uint32_t buffer_size, int is_writable) {
   BlobSpot *spot = NULL;
@@ -99,26 +104,15 @@ cleanup:
   return rc;
 }
 
-int blob_spot_reload(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
-                     uint32_t buffer_size) {
+/*
+** Point spot's handle at rowid without reading: reopens an aborted
+** handle, or sqlite3_blob_reopen()s for a different rowid (which marks
+** the buffer uninitialized).
+*/
+static int blob_spot_position(DiskAnnIndex *idx, BlobSpot *spot,
+                              uint64_t rowid) {
   int rc;
 
-  /* Validate inputs */
-  if (!idx || !spot) {
-    return DISKANN_ERROR_INVALID;
-  }
-  assert(spot->pBlob != NULL || spot->is_aborted);
-
-  /* Runtime check for buffer size mismatch (prevents buffer overflow) */
-  if (spot->buffer_size != buffer_size) {
-    return DISKANN_ERROR_INVALID;
-  }
-
-  /* If already loaded and same rowid, nothing to do */
-  if (spot->rowid == rowid && spot->is_initialized) {
-    return DISKANN_OK;
-  }
-
   /* Handle aborted BLOB - need to close and reopen */
   if (spot->is_aborted) {
     if (spot->pBlob) {
@@ -156,23 +150,260 @@ int blob_spot_reload(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
     spot->is_initialized = 0;
   }
 
-  /* Read BLOB data into buffer */
-  int sqlite_rc = sqlite3_blob_read(spot->pBlob, spot->buffer, (int)buffer_size,
-                                    0 /* offset */
-  );
+  return DISKANN_OK;
+}
+
+/*
+** Point the pool's handle at rowid, opening it when closed. A failed
+** reopen leaves the handle unusable, so it is closed; SQLITE_ABORT (the
+** handle had already been aborted) is retried with a fresh one.
+*/
+static int blob_pool_seek(DiskAnnIndex *idx, BlobPool *pool,
+                          uint64_t rowid) {
+  int sqlite_rc;
 
+  if (pool->pBlob) {
+    if (pool->rowid == rowid) {
+      return DISKANN_OK;
+    }
+    sqlite_rc = sqlite3_blob_reopen(pool->pBlob, (sqlite3_int64)rowid);
+    if (sqlite_rc == SQLITE_OK) {
+      pool->rowid = rowid;
+      return DISKANN_OK;
+    }
+    int rc = convert_sqlite_error(idx, sqlite_rc);
+    blob_pool_release_handle(pool);
+    if (sqlite_rc != SQLITE_ABORT) {
+      return rc;
+    }
+  }
+
+  sqlite_rc = sqlite3_blob_open(idx->db, idx->db_name, idx->shadow_name,
+                                "data", (sqlite3_int64)rowid, 1, &pool->pBlob);
+  if (sqlite_rc != SQLITE_OK) {
+    pool->pBlob = NULL;
+    return convert_sqlite_error(idx, sqlite_rc);
+  }
+  pool->rowid = rowid;
+  return DISKANN_OK;
+}
+
+/*
+** Read or write n bytes at offset of rowid through the pool's handle,
+** from or into data. Writes to the shadow table expire open handles; an
+** expired one fails with SQLITE_ABORT and is reopened once.
+*/
+static int blob_pool_io(DiskAnnIndex *idx, BlobPool *pool, uint64_t rowid,
+                        uint8_t *data, uint32_t offset, uint32_t n,
+                        int write) {
+  for (int attempt = 0;; attempt++) {
+    int rc = blob_pool_seek(idx, pool, rowid);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+    int sqlite_rc =
+        write ? sqlite3_blob_write(pool->pBlob, data, (int)n, (int)offset)
+              : sqlite3_blob_read(pool->pBlob, data, (int)n, (int)offset);
+    if (sqlite_rc == SQLITE_OK) {
+      return DISKANN_OK;
+    }
+    blob_pool_release_handle(pool);
+    if (sqlite_rc != SQLITE_ABORT || attempt > 0) {
+      return DISKANN_ERROR;
+    }
+  }
+}
+
+int blob_spot_reload(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
+                     uint32_t buffer_size) {
+  int rc;
+
+  /* Validate inputs */
+  if (!idx || !spot) {
+    return DISKANN_ERROR_INVALID;
+  }
+  assert(spot->pBlob != NULL || spot->is_aborted);
+
+  /* Runtime check for buffer size mismatch (prevents buffer overflow) */
+  if (spot->buffer_size != buffer_size) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  /* If already loaded and same rowid, nothing to do */
+  if (spot->rowid == rowid && spot->is_initialized && !spot->is_partial) {
+    return DISKANN_OK;
+  }
+
+  if (spot->pool && !spot->pBlob) {
+    /* Pooled spot: read through the pool's handle */
+    rc = blob_pool_io(idx, spot->pool, rowid, spot->buffer, 0, buffer_size,
+                      0);
+    if (rc != DISKANN_OK) {
+      spot->is_initialized = 0;
+      return rc;
+    }
+    spot->rowid = rowid;
+  } else {
+    rc = blob_spot_position(idx, spot, rowid);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+
+    /* Read BLOB data into buffer */
+    int sqlite_rc = sqlite3_blob_read(spot->pBlob, spot->buffer,
+                                      (int)buffer_size, 0 /* offset */
+    );
+
+    if (sqlite_rc != SQLITE_OK) {
+      spot->is_aborted = 1;
+      spot->is_initialized = 0;
+      return DISKANN_ERROR;
+    }
+  }
+
+  /* Success */
+  idx->num_reads++;
+  idx->num_read_bytes += buffer_size;
+  spot->is_initialized = 1;
+  spot->is_partial = 0;
+  spot->n_dirty = 0;
+  return DISKANN_OK;
+}
+
+int blob_spot_seek(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid) {
+  if (!idx || !spot) {
+    return DISKANN_ERROR_INVALID;
+  }
+  assert(spot->pBlob != NULL || spot->is_aborted);
+
+  int rc = blob_spot_position(idx, spot, rowid);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  spot->is_initialized = 0;
+  spot->is_partial = 1;
+  return DISKANN_OK;
+}
+
+int blob_spot_read_range(DiskAnnIndex *idx, BlobSpot *spot, uint32_t offset,
+                         uint32_t n) {
+  if (!idx || !spot) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (offset > spot->buffer_size || n > spot->buffer_size - offset) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (n == 0 || !spot->is_partial) {
+    return DISKANN_OK; /* full buffer already holds every range */
+  }
+  if (!spot->pBlob) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  int sqlite_rc = sqlite3_blob_read(spot->pBlob, spot->buffer + offset, (int)n,
+                                    (int)offset);
   if (sqlite_rc != SQLITE_OK) {
     spot->is_aborted = 1;
     spot->is_initialized = 0;
     return DISKANN_ERROR;
   }
 
-  /* Success */
   idx->num_reads++;
+  idx->num_read_bytes += n;
   spot->is_initialized = 1;
   return DISKANN_OK;
 }
 
+void blob_spot_mark_dirty(BlobSpot *spot, uint32_t offset, uint32_t n) {
+  assert(offset <= spot->buffer_size && n <= spot->buffer_size - offset);
+  if (n == 0) {
+    return;
+  }
+  uint32_t start = offset;
+  uint32_t end = offset + n;
+
+  /* Absorb every range the new one overlaps or touches */
+  for (int i = 0; i < spot->n_dirty;) {
+    if (start <= spot->dirty_end[i] && spot->dirty_start[i] <= end) {
+      if (spot->dirty_start[i] < start) {
+        start = spot->dirty_start[i];
+      }
+      if (spot->dirty_end[i] > end) {
+        end = spot->dirty_end[i];
+      }
+      spot->n_dirty--;
+      spot->dirty_start[i] = spot->dirty_start[spot->n_dirty];
+      spot->dirty_end[i] = spot->dirty_end[spot->n_dirty];
+    } else {
+      i++;
+    }
+  }
+
+  if (spot->n_dirty == BLOB_SPOT_DIRTY_RANGES) {
+    /* Full: take the nearest range out and mark it merged with this one,
+    ** gap included */
+    int nearest = 0;
+    uint32_t best_gap = UINT32_MAX;
+    for (int i = 0; i < spot->n_dirty; i++) {
+      uint32_t gap = spot->dirty_end[i] < start ? start - spot->dirty_end[i]
+                                                : spot->dirty_start[i] - end;
+      if (gap < best_gap) {
+        best_gap = gap;
+        nearest = i;
+      }
+    }
+    if (spot->dirty_start[nearest] < start) {
+      start = spot->dirty_start[nearest];
+    }
+    if (spot->dirty_end[nearest] > end) {
+      end = spot->dirty_end[nearest];
+    }
+    spot->n_dirty--;
+    spot->dirty_start[nearest] = spot->dirty_start[spot->n_dirty];
+    spot->dirty_end[nearest] = spot->dirty_end[spot->n_dirty];
+    blob_spot_mark_dirty(spot, start, end - start);
+    return;
+  }
+  spot->dirty_start[spot->n_dirty] = start;
+  spot->dirty_end[spot->n_dirty] = end;
+  spot->n_dirty++;
+}
+
+/* Write spot's dirty ranges (or its whole buffer) through pBlob */
+static int write_dirty(sqlite3_blob *pBlob, const BlobSpot *spot) {
+  if (spot->n_dirty == 0) {
+    return sqlite3_blob_write(pBlob, spot->buffer, (int)spot->buffer_size,
+                              0);
+  }
+  for (int i = 0; i < spot->n_dirty; i++) {
+    uint32_t start = spot->dirty_start[i];
+    int sqlite_rc =
+        sqlite3_blob_write(pBlob, spot->buffer + start,
+                           (int)(spot->dirty_end[i] - start), (int)start);
+    if (sqlite_rc != SQLITE_OK) {
+      return sqlite_rc;
+    }
+  }
+  return SQLITE_OK;
+}
+
+/* Pooled spot: write the dirty ranges through the pool's handle */
+static int write_dirty_pooled(DiskAnnIndex *idx, BlobSpot *spot) {
+  if (spot->n_dirty == 0) {
+    return blob_pool_io(idx, spot->pool, spot->rowid, spot->buffer, 0,
+                        spot->buffer_size, 1);
+  }
+  for (int i = 0; i < spot->n_dirty; i++) {
+    uint32_t start = spot->dirty_start[i];
+    int rc = blob_pool_io(idx, spot->pool, spot->rowid, spot->buffer + start,
+                          start, spot->dirty_end[i] - start, 1);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  return DISKANN_OK;
+}
+
 int blob_spot_flush(DiskAnnIndex *idx, BlobSpot *spot) {
   /* Validate inputs */
   if (!idx || !spot) {
@@ -183,15 +414,24 @@ int blob_spot_flush(DiskAnnIndex *idx, BlobSpot *spot) {
   }
   /* Ensure buffer is initialized before writing (prevents writing uninitialized
    * memory) */
-  if (!spot->is_initialized) {
+  if (!spot->is_initialized || spot->is_partial) {
     return DISKANN_ERROR_INVALID;
   }
 
+  /* Pooled spot: write through the pool's handle */
+  int sqlite_rc;
+  if (spot->pool && !spot->pBlob) {
+    int rc = write_dirty_pooled(idx, spot);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+    goto written;
+  }
+
   /* Reopen blob handle if it was closed or expired.
   ** Handles are closed by blob_cache_release_handles() to avoid blocking
   ** COMMIT, and expired by insert_shadow_row() which invalidates all open
   ** handles on the shadow table. */
-  int sqlite_rc;
   if (spot->pBlob == NULL || spot->is_aborted) {
     /* Handle already closed or expired — must reopen */
     if (spot->pBlob) {
@@ -201,9 +441,7 @@ int blob_spot_flush(DiskAnnIndex *idx, BlobSpot *spot) {
     goto reopen;
   }
 
-  sqlite_rc = sqlite3_blob_write(spot->pBlob, spot->buffer,
-                                 (int)spot->buffer_size, 0 /* offset */
-  );
+  sqlite_rc = write_dirty(spot->pBlob, spot);
 
   if (sqlite_rc == SQLITE_ABORT) {
     sqlite3_blob_close(spot->pBlob);
@@ -219,17 +457,56 @@ int blob_spot_flush(DiskAnnIndex *idx, BlobSpot *spot) {
     }
     spot->is_aborted = 0;
 
-    sqlite_rc = sqlite3_blob_write(spot->pBlob, spot->buffer,
-                                   (int)spot->buffer_size, 0 /* offset */
-    );
+    sqlite_rc = write_dirty(spot->pBlob, spot);
   }
 
   if (sqlite_rc != SQLITE_OK) {
     return DISKANN_ERROR;
   }
 
+written:
   /* Update statistics */
   idx->num_writes++;
+  if (spot->n_dirty == 0) {
+    idx->num_write_bytes += spot->buffer_size;
+  }
+  for (int i = 0; i < spot->n_dirty; i++) {
+    idx->num_write_bytes += spot->dirty_end[i] - spot->dirty_start[i];
+  }
+  spot->n_dirty = 0;
+
+  /* The shared read cache holds a copy of the old block */
+  blob_cache_remove(idx->read_cache, spot->rowid);
+  return DISKANN_OK;
+}
+
+int blob_spot_copy(const BlobSpot *src, BlobSpot **out) {
+  if (!src || !out || !src->is_initialized || src->is_partial) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+
+  BlobSpot *spot = (BlobSpot *)sqlite3_malloc(sizeof(BlobSpot));
+  if (!spot) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(spot, 0, sizeof(BlobSpot));
+
+  spot->buffer = (uint8_t *)sqlite3_malloc((int)src->buffer_size);
+  if (!spot->buffer) {
+    sqlite3_free(spot);
+    return DISKANN_ERROR_NOMEM;
+  }
+  memcpy(spot->buffer, src->buffer, src->buffer_size);
+
+  spot->rowid = src->rowid;
+  spot->buffer_size = src->buffer_size;
+  spot->is_writable = 0;
+  spot->is_initialized = 1;
+  spot->is_aborted = 1; /* no handle: reload would reopen */
+  spot->refcount = 1;
+
+  *out = spot;
   return DISKANN_OK;
 }
 
@@ -257,8 +534,19 @@ void blob_spot_free(BlobSpot *spot) {
     spot->pBlob = NULL;
   }
 
-  /* Free buffer */
-  if (spot->buffer) {
+  /* Keep a pooled spot's buffer for the next blob_spot_load() */
+  BlobPool *pool = spot->pool;
+  if (pool && pool->n_free < pool->capacity) {
+    spot->is_initialized = 0;
+    spot->is_aborted = 1;
+    spot->is_partial = 0;
+    spot->n_dirty = 0;
+    pool->free[pool->n_free++] = spot;
+    return;
+  }
+
+  /* Free buffer (a mapped one belongs to its snapshot) */
+  if (spot->buffer && !spot->is_mapped) {
     sqlite3_free(spot->buffer);
     spot->buffer = NULL;
   }
@@ -266,3 +554,89 @@ void blob_spot_free(BlobSpot *spot) {
   /* Free structure */
   sqlite3_free(spot);
 }
+
+/* Pool for idx's blocks, created on first use */
+static BlobPool *blob_pool_get(DiskAnnIndex *idx) {
+  if (idx->blob_pool) {
+    return idx->blob_pool;
+  }
+  BlobPool *pool = (BlobPool *)sqlite3_malloc(sizeof(BlobPool));
+  if (!pool) {
+    return NULL;
+  }
+  memset(pool, 0, sizeof(BlobPool));
+  pool->buffer_size = idx->block_size;
+  pool->capacity = (int)(BLOB_POOL_BYTES / idx->block_size);
+  if (pool->capacity > 0) {
+    pool->free = (BlobSpot **)sqlite3_malloc64((sqlite3_uint64)pool->capacity *
+                                               sizeof(BlobSpot *));
+    if (!pool->free) {
+      sqlite3_free(pool);
+      return NULL;
+    }
+  }
+  idx->blob_pool = pool;
+  return pool;
+}
+
+int blob_spot_load(DiskAnnIndex *idx, BlobSpot **out, uint64_t rowid) {
+  if (!idx || !out || idx->block_size == 0) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+
+  BlobPool *pool = blob_pool_get(idx);
+  if (!pool) {
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  BlobSpot *spot;
+  if (pool->n_free > 0) {
+    spot = pool->free[--pool->n_free];
+  } else {
+    spot = (BlobSpot *)sqlite3_malloc(sizeof(BlobSpot));
+    if (!spot) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    memset(spot, 0, sizeof(BlobSpot));
+    spot->buffer = (uint8_t *)sqlite3_malloc((int)pool->buffer_size);
+    if (!spot->buffer) {
+      sqlite3_free(spot);
+      return DISKANN_ERROR_NOMEM;
+    }
+    spot->buffer_size = pool->buffer_size;
+    spot->is_writable = 1;
+    spot->is_aborted = 1; /* no handle of its own */
+    spot->pool = pool;
+  }
+  spot->rowid = rowid;
+  spot->refcount = 1;
+
+  int rc = blob_spot_reload(idx, spot, rowid, idx->block_size);
+  if (rc != DISKANN_OK) {
+    blob_spot_free(spot);
+    return rc;
+  }
+  *out = spot;
+  return DISKANN_OK;
+}
+
+void blob_pool_release_handle(BlobPool *pool) {
+  if (pool && pool->pBlob) {
+    sqlite3_blob_close(pool->pBlob);
+    pool->pBlob = NULL;
+  }
+}
+
+void blob_pool_free(BlobPool *pool) {
+  if (!pool) {
+    return;
+  }
+  blob_pool_release_handle(pool);
+  for (int i = 0; i < pool->n_free; i++) {
+    sqlite3_free(pool->free[i]->buffer);
+    sqlite3_free(pool->free[i]);
+  }
+  sqlite3_free(pool->free);
+  sqlite3_free(pool);
+}
@@ -20,6 +20,9 @@
 extern "C" {
 #endif
 
+/* Dirty byte ranges a BlobSpot tracks before merging neighbors */
+#define BLOB_SPOT_DIRTY_RANGES 8
+
 /*
 ** BlobSpot - Handle for incremental BLOB I/O
 **
@@ -28,7 +31,8 @@ extern "C" {
 **
 ** Memory ownership:
 ** - pBlob: owned by this struct (closed in blob_spot_free)
-** - pBuffer: owned by this struct (freed in blob_spot_free)
+** - pBuffer: owned by this struct (freed in blob_spot_free), unless
+**   is_mapped
 ** - All other fields: simple values
 */
 typedef struct BlobSpot {
@@ -39,11 +43,44 @@ typedef struct BlobSpot {
   int is_writable;      /* 1 if opened for writing, 0 for reading */
   int is_initialized;   /* 1 if buffer contains valid data */
   int is_aborted;       /* 1 if BLOB operations have been aborted */
+  int is_partial;       /* 1 if only ranges read by blob_spot_read_range()
+                        ** are valid (see blob_spot_seek()) */
+  int is_mapped;        /* 1 if buffer points into a read-only snapshot
+                        ** mapping (not owned, see diskann_snapshot.h) */
   int refcount;         /* Reference count (>0 = alive). Decremented by
                         ** blob_spot_free(); actual free when reaching 0.
                         ** Incremented by blob_cache_put/get. */
+  struct BlobPool *pool; /* Pool the spot returns to on its last free
+                         ** (NULL = not pooled, see blob_spot_load()) */
+  /* Byte ranges [start, end) changed since the last load or flush (see
+  ** blob_spot_mark_dirty()); 0 ranges flushes the whole buffer */
+  uint32_t dirty_start[BLOB_SPOT_DIRTY_RANGES];
+  uint32_t dirty_end[BLOB_SPOT_DIRTY_RANGES];
+  int n_dirty;
 } BlobSpot;
 
+/*
+** BlobPool - recycled writable BlobSpots of one index
+**
+** An insert walk loads a few hundred blocks, each of which stays
+** referenced until the new node's links are written. Pooled spots own no
+** BLOB handle: they read and flush through the pool's one writable
+** handle, moved between rows with sqlite3_blob_reopen(), and their
+** buffers go back to the pool instead of being freed.
+**
+** An open handle blocks COMMIT, so operations that load pooled spots
+** close the shared handle with blob_pool_release_handle() before they
+** return; the next load reopens it.
+*/
+typedef struct BlobPool {
+  sqlite3_blob *pBlob;  /* Shared writable handle (NULL when closed) */
+  uint64_t rowid;       /* Row pBlob points at */
+  uint32_t buffer_size; /* Buffer size of every pooled spot */
+  BlobSpot **free;      /* Released spots, buffers kept */
+  int n_free;
+  int capacity; /* Most spots kept (BLOB_POOL_BYTES of buffers) */
+} BlobPool;
+
 /*
 ** BLOB access modes (values passed to blob_spot_create is_writable parameter)
 */
@@ -101,11 +138,40 @@ int blob_spot_create(DiskAnnIndex *idx, BlobSpot **out, uint64_t rowid,
 int blob_spot_reload(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
                      uint32_t buffer_size);
 
+/*
+** Partial reads: position the handle without reading, then fetch only
+** the byte ranges a caller needs.
+**
+** blob_spot_seek() points spot at rowid and marks it partial: until the
+** next blob_spot_reload(), only ranges fetched with blob_spot_read_range()
+** hold valid data (the node layer knows which ones it read). On a fully
+** loaded spot, blob_spot_read_range() is a no-op.
+**
+** Both return DISKANN_OK, DISKANN_ROW_NOT_FOUND (seek), DISKANN_ERROR_INVALID
+** for out-of-range requests, or DISKANN_ERROR. A partial spot must not be
+** flushed or copied.
+*/
+int blob_spot_seek(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid);
+int blob_spot_read_range(DiskAnnIndex *idx, BlobSpot *spot, uint32_t offset,
+                         uint32_t n);
+
+/*
+** Record that bytes [offset, offset + n) of spot's buffer changed.
+**
+** The node layer marks what each edit touches (an edge slot, its
+** metadata, the edge count), so a flush rewrites those bytes instead of
+** the whole block and dirties only the pages they sit on. Ranges that
+** overlap or touch are merged; past BLOB_SPOT_DIRTY_RANGES, a new range
+** is merged with its nearest neighbor, covering the gap between them.
+*/
+void blob_spot_mark_dirty(BlobSpot *spot, uint32_t offset, uint32_t n);
+
 /*
 ** Flush BlobSpot buffer to database.
 **
-** Writes the buffer contents back to the BLOB in the shadow table.
-** Only works if BlobSpot was opened with is_writable=1.
+** Writes the buffer's dirty ranges back to the BLOB in the shadow table,
+** or the whole buffer when none were marked (callers that edit the
+** buffer directly). Only works if BlobSpot was opened with is_writable=1.
 **
 ** Parameters:
 **   idx   - Index handle
@@ -117,6 +183,45 @@ int blob_spot_reload(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
 */
 int blob_spot_flush(DiskAnnIndex *idx, BlobSpot *spot);
 
+/*
+** Create a handle-less copy of a loaded BlobSpot.
+**
+** The copy owns its own buffer, has no BLOB handle and is marked aborted
+** (a later blob_spot_reload() would reopen one). Used to keep blocks in
+** the shared read cache without holding SQLite BLOB handles open.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR_INVALID if src is NULL, not initialized or partial
+**   DISKANN_ERROR_NOMEM if allocation fails
+**
+** Caller takes ownership of the copy and must call blob_spot_free().
+*/
+int blob_spot_copy(const BlobSpot *src, BlobSpot **out);
+
+/*
+** Load a writable BlobSpot for rowid from the index's pool.
+**
+** Like blob_spot_create() + blob_spot_reload() with is_writable=1 and
+** idx->block_size, but the spot reuses a released buffer when the pool
+** has one and reads through the pool's shared handle. blob_spot_reload()
+** and blob_spot_flush() on the spot go through that handle too; an
+** expired or aborted handle is reopened once, as blob_spot_flush() does
+** for its own.
+**
+** Returns DISKANN_OK, DISKANN_ERROR_NOMEM, DISKANN_ROW_NOT_FOUND or
+** DISKANN_ERROR. The caller owns one reference (blob_spot_free()).
+*/
+int blob_spot_load(DiskAnnIndex *idx, BlobSpot **out, uint64_t rowid);
+
+/* Close the pool's shared handle, if open (NULL safe). Pooled spots keep
+** their buffers; the next read or flush reopens the handle. */
+void blob_pool_release_handle(BlobPool *pool);
+
+/* Free the pool and its released spots. Every pooled spot must have been
+** released first (NULL safe). */
+void blob_pool_free(BlobPool *pool);
+
 /*
 ** Increment BlobSpot reference count.
 **
@@ -129,7 +234,8 @@ void blob_spot_addref(BlobSpot *spot);
 ** Decrement BlobSpot reference count and free when it reaches zero.
 **
 ** Closes the BLOB handle and frees the buffer only when no references
-** remain. Safe to call with NULL.
+** remain; a pooled spot goes back to its pool while the pool has room.
+** Safe to call with NULL.
 **
 ** Parameters:
 **   spot - BlobSpot to release (can be NULL)
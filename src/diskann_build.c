@@ -0,0 +1,769 @@
+/*
+** DiskANN Build — parallel in-memory graph construction
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** diskann_insert() links one node at a time through the shadow table: a
+** SAVEPOINT, a BLOB-backed beam search and one flush per accepted
+** neighbor. diskann_build() instead loads every stored vector, builds the
+** Vamana graph in RAM and writes each node block exactly once.
+**
+** Construction follows the prefix-doubling scheme of parallel Vamana:
+** - The medoid is linked first; the other nodes follow in a fixed
+**   pseudo-random order, in rounds that double in size (1, 2, 4, ...,
+**   capped at BUILD_ROUND_FRACTION of the index).
+** - Phase A: every node of a round runs a beam search over the nodes
+**   linked by earlier rounds and builds its own adjacency from the
+**   visited list (diskann_insert()'s Phase 1). Nodes of the current round
+**   are unreachable until Phase B, so workers only read shared adjacency.
+** - Phase B: the back-edges (visited -> new) are sorted by target and
+**   split at target boundaries, so each worker owns the nodes it edits
+**   (diskann_insert()'s Phase 2).
+** Neither phase takes a lock, and workers never allocate: all scratch is
+** sized and allocated up front on the calling thread.
+**
+** Edge replacement and pruning mirror replace_edge_idx()/prune_edges() in
+** diskann_insert.c (same alpha rule and DISKANN_MIN_DEGREE) on exact
+** float32 distances.
+*/
+#include "diskann.h"
+#include "diskann_cache.h"
+#include "diskann_internal.h"
+#include "diskann_node.h"
+#include "diskann_sqlite.h"
+#include "diskann_thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Round size cap: 1/BUILD_ROUND_FRACTION of the index, at most
+** BUILD_MAX_ROUND nodes (bounds the per-round visited-list storage) */
+#define BUILD_ROUND_FRACTION 50
+#define BUILD_MAX_ROUND 16384
+
+/* Visited-list cap per search, as a multiple of insert_list_size */
+#define BUILD_VISIT_FACTOR 2
+
+/* Insertion-order seed: deterministic so rebuilds of the same data match */
+#define BUILD_ORDER_SEED 0x9E3779B97F4A7C15ULL
+
+/**************************************************************************
+** In-memory graph
+**************************************************************************/
+
+/* One back-edge candidate collected in Phase A, applied in Phase B */
+typedef struct BuildBackEdge {
+  uint32_t target; /* visited node that may gain an edge */
+  uint32_t source; /* node linked this round */
+  float distance;
+} BuildBackEdge;
+
+/*
+** Nodes are addressed by dense ids 0..n-1 in ascending rowid order.
+**
+** Memory ownership: every pointer is owned (sqlite3_malloc'd) and released
+** by build_graph_deinit().
+*/
+typedef struct BuildGraph {
+  const DiskAnnIndex *idx;
+  uint32_t n;
+  uint32_t max_edges;  /* node_edges_max_count(idx) */
+  uint32_t list_size;  /* beam width (insert_list_size) */
+  uint32_t max_visit;  /* visited-list cap per search */
+  uint32_t start;      /* medoid: search entry and first linked node */
+  int64_t *rowids;     /* n */
+  float *vectors;      /* n * dims */
+  float *inv_norms;    /* n, cosine only (NULL otherwise) */
+  uint32_t *degree;    /* n */
+  uint32_t *edges;     /* n * max_edges */
+  float *edge_dists;   /* n * max_edges */
+  uint32_t *order;     /* n, insertion order (order[0] = start) */
+
+  /* Current round: order[round_begin .. round_begin + round_len) */
+  uint32_t round_begin;
+  uint32_t round_len;
+  uint32_t round_cap;
+  uint32_t *visit_ids;     /* round_cap * max_visit */
+  float *visit_dists;      /* round_cap * max_visit */
+  uint32_t *n_visit;       /* round_cap */
+  BuildBackEdge *back;     /* round_cap * max_visit */
+} BuildGraph;
+
+/* Per-thread search scratch and work assignment */
+typedef struct BuildWorker {
+  BuildGraph *g;
+  uint32_t index;     /* worker number */
+  uint32_t n_workers;
+  uint32_t *marks;    /* n entries, == stamp once seen by this search */
+  uint32_t stamp;
+  uint32_t *beam;     /* list_size ids, ascending by beam_dists */
+  float *beam_dists;
+  uint8_t *expanded;  /* list_size flags, parallel to beam */
+  uint32_t n_beam;
+  uint32_t begin;     /* Phase B: back[begin .. end) */
+  uint32_t end;
+} BuildWorker;
+
+static const float *build_vector(const BuildGraph *g, uint32_t id) {
+  return g->vectors + (size_t)id * g->idx->dimensions;
+}
+
+static float build_inv_norm(const BuildGraph *g, uint32_t id) {
+  return g->inv_norms ? g->inv_norms[id] : 0.0f;
+}
+
+static float build_distance(const BuildGraph *g, uint32_t a, uint32_t b) {
+  return diskann_index_distance_normed(g->idx, build_vector(g, a),
+                                       build_inv_norm(g, a),
+                                       build_vector(g, b),
+                                       build_inv_norm(g, b));
+}
+
+static void build_graph_deinit(BuildGraph *g) {
+  sqlite3_free(g->rowids);
+  sqlite3_free(g->vectors);
+  sqlite3_free(g->inv_norms);
+  sqlite3_free(g->degree);
+  sqlite3_free(g->edges);
+  sqlite3_free(g->edge_dists);
+  sqlite3_free(g->order);
+  sqlite3_free(g->visit_ids);
+  sqlite3_free(g->visit_dists);
+  sqlite3_free(g->n_visit);
+  sqlite3_free(g->back);
+  memset(g, 0, sizeof(*g));
+}
+
+/**************************************************************************
+** Edge replacement and pruning (see diskann_insert.c)
+**************************************************************************/
+
+/*
+** Slot for an edge node -> new_id: an existing edge to new_id, degree to
+** append, the worst edge new_id beats, or -1 when new_id is dominated.
+*/
+static int build_replace_edge_idx(const BuildGraph *g, uint32_t node,
+                                  uint32_t new_id, float node_to_new) {
+  const uint32_t *edges = g->edges + (size_t)node * g->max_edges;
+  const float *dists = g->edge_dists + (size_t)node * g->max_edges;
+  int n_edges = (int)g->degree[node];
+  int i_replace = -1;
+  float node_to_replace = 0.0f;
+
+  for (int i = n_edges - 1; i >= 0; i--) {
+    if (edges[i] == new_id) {
+      return i;
+    }
+    float edge_to_new = build_distance(g, new_id, edges[i]);
+    if (node_to_new > diskann_alpha_threshold(g->idx, edge_to_new)) {
+      return -1;
+    }
+    if (node_to_new < dists[i] &&
+        (i_replace == -1 || node_to_replace < dists[i])) {
+      node_to_replace = dists[i];
+      i_replace = i;
+    }
+  }
+
+  if ((uint32_t)n_edges < g->max_edges) {
+    return n_edges;
+  }
+  return i_replace;
+}
+
+/* Drop edges of node dominated by the edge at i_inserted (swap-remove,
+** like node_bin_delete_edge()) down to DISKANN_MIN_DEGREE */
+static void build_prune_edges(BuildGraph *g, uint32_t node, int i_inserted) {
+  uint32_t *edges = g->edges + (size_t)node * g->max_edges;
+  float *dists = g->edge_dists + (size_t)node * g->max_edges;
+  uint32_t n_edges = g->degree[node];
+  uint32_t hint = edges[i_inserted];
+  uint32_t i = 0;
+
+  while (i < n_edges) {
+    if (edges[i] == hint) {
+      i++;
+      continue;
+    }
+    if (n_edges <= DISKANN_MIN_DEGREE) {
+      break;
+    }
+    float hint_to_edge = build_distance(g, hint, edges[i]);
+    if (dists[i] > diskann_alpha_threshold(g->idx, hint_to_edge)) {
+      n_edges--;
+      edges[i] = edges[n_edges];
+      dists[i] = dists[n_edges];
+    } else {
+      i++;
+    }
+  }
+  g->degree[node] = n_edges;
+}
+
+static void build_add_edge(BuildGraph *g, uint32_t node, uint32_t new_id,
+                           float distance) {
+  int i = build_replace_edge_idx(g, node, new_id, distance);
+  if (i < 0) {
+    return;
+  }
+  size_t slot = (size_t)node * g->max_edges + (size_t)i;
+  if ((uint32_t)i == g->degree[node]) {
+    g->degree[node]++;
+  }
+  g->edges[slot] = new_id;
+  g->edge_dists[slot] = distance;
+  build_prune_edges(g, node, i);
+}
+
+/**************************************************************************
+** In-memory beam search
+**************************************************************************/
+
+/* Insert id into the sorted beam. Returns its position, or list_size when
+** the beam is full and distance does not beat the worst entry. */
+static uint32_t build_beam_insert(BuildWorker *w, uint32_t id,
+                                  float distance) {
+  uint32_t cap = w->g->list_size;
+  if (w->n_beam == cap && distance >= w->beam_dists[cap - 1]) {
+    return cap;
+  }
+  uint32_t pos = w->n_beam < cap ? w->n_beam : cap - 1;
+  while (pos > 0 && w->beam_dists[pos - 1] > distance) {
+    w->beam[pos] = w->beam[pos - 1];
+    w->beam_dists[pos] = w->beam_dists[pos - 1];
+    w->expanded[pos] = w->expanded[pos - 1];
+    pos--;
+  }
+  w->beam[pos] = id;
+  w->beam_dists[pos] = distance;
+  w->expanded[pos] = 0;
+  if (w->n_beam < cap) {
+    w->n_beam++;
+  }
+  return pos;
+}
+
+/*
+** Greedy beam search for node p from g->start over the linked graph.
+** Writes the expanded nodes and their distances to p into out_ids and
+** out_dists (at most max_visit) and returns how many there are.
+*/
+static uint32_t build_search(BuildWorker *w, uint32_t p, uint32_t *out_ids,
+                             float *out_dists) {
+  const BuildGraph *g = w->g;
+  uint32_t n_visit = 0;
+  uint32_t cursor = 0; /* every beam entry before cursor is expanded */
+
+  if (++w->stamp == 0) {
+    memset(w->marks, 0, (size_t)g->n * sizeof(uint32_t));
+    w->stamp = 1;
+  }
+  w->n_beam = 0;
+  w->marks[g->start] = w->stamp;
+  build_beam_insert(w, g->start, build_distance(g, p, g->start));
+
+  while (n_visit < g->max_visit) {
+    while (cursor < w->n_beam && w->expanded[cursor]) {
+      cursor++;
+    }
+    if (cursor == w->n_beam) {
+      break;
+    }
+    uint32_t cur = w->beam[cursor];
+    w->expanded[cursor] = 1;
+    out_ids[n_visit] = cur;
+    out_dists[n_visit] = w->beam_dists[cursor];
+    n_visit++;
+
+    const uint32_t *edges = g->edges + (size_t)cur * g->max_edges;
+    for (uint32_t i = 0; i < g->degree[cur]; i++) {
+      uint32_t e = edges[i];
+      if (w->marks[e] == w->stamp) {
+        continue;
+      }
+      w->marks[e] = w->stamp;
+      uint32_t pos = build_beam_insert(w, e, build_distance(g, p, e));
+      if (pos < cursor) {
+        cursor = pos;
+      }
+    }
+  }
+  return n_visit;
+}
+
+/**************************************************************************
+** Worker pool
+**************************************************************************/
+
+/* Phase A: search for and link this worker's share of the round */
+static void build_link_round(void *arg) {
+  BuildWorker *w = (BuildWorker *)arg;
+  BuildGraph *g = w->g;
+  for (uint32_t k = w->index; k < g->round_len; k += w->n_workers) {
+    uint32_t p = g->order[g->round_begin + k];
+    uint32_t *ids = g->visit_ids + (size_t)k * g->max_visit;
+    float *dists = g->visit_dists + (size_t)k * g->max_visit;
+    uint32_t n_visit = build_search(w, p, ids, dists);
+    g->n_visit[k] = n_visit;
+    for (uint32_t i = 0; i < n_visit; i++) {
+      build_add_edge(g, p, ids[i], dists[i]);
+    }
+  }
+}
+
+/* Phase B: apply back-edges back[begin .. end) (whole targets only) */
+static void build_back_round(void *arg) {
+  BuildWorker *w = (BuildWorker *)arg;
+  BuildGraph *g = w->g;
+  for (uint32_t j = w->begin; j < w->end; j++) {
+    const BuildBackEdge *e = &g->back[j];
+    build_add_edge(g, e->target, e->source, e->distance);
+  }
+}
+
+static void build_run(BuildWorker *workers, uint32_t n_workers,
+                      DiskAnnWorkerFn fn) {
+  for (uint32_t i = 0; i < n_workers; i++) {
+    workers[i].n_workers = n_workers;
+  }
+  diskann_parallel_run(fn, workers, sizeof(BuildWorker), n_workers);
+}
+
+/**************************************************************************
+** Construction
+**************************************************************************/
+
+static int back_edge_cmp(const void *a, const void *b) {
+  const BuildBackEdge *x = (const BuildBackEdge *)a;
+  const BuildBackEdge *y = (const BuildBackEdge *)b;
+  if (x->target != y->target) {
+    return x->target < y->target ? -1 : 1;
+  }
+  if (x->source != y->source) {
+    return x->source < y->source ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Medoid: the node closest to the mean (cosine compares directions; L2
+** otherwise, matching diskann_refresh_entry_point()) */
+static int build_pick_start(BuildGraph *g) {
+  const DiskAnnIndex *idx = g->idx;
+  double *sum = (double *)sqlite3_malloc64((uint64_t)idx->dimensions *
+                                           sizeof(double));
+  float *mean = (float *)sqlite3_malloc64(idx->dimensions * sizeof(float));
+  if (!sum || !mean) {
+    sqlite3_free(sum);
+    sqlite3_free(mean);
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(sum, 0, (size_t)idx->dimensions * sizeof(double));
+  for (uint32_t i = 0; i < g->n; i++) {
+    const float *v = build_vector(g, i);
+    for (uint32_t d = 0; d < idx->dimensions; d++) {
+      sum[d] += v[d];
+    }
+  }
+  for (uint32_t d = 0; d < idx->dimensions; d++) {
+    mean[d] = (float)(sum[d] / g->n);
+  }
+
+  DiskAnnDistanceFn dist = diskann_simd_distance_fn(
+      idx->simd_level, idx->metric == DISKANN_METRIC_COSINE
+                           ? DISKANN_METRIC_COSINE
+                           : DISKANN_METRIC_EUCLIDEAN);
+  float best_dist = dist(mean, build_vector(g, 0), idx->dimensions);
+  g->start = 0;
+  for (uint32_t i = 1; i < g->n; i++) {
+    float d = dist(mean, build_vector(g, i), idx->dimensions);
+    if (d < best_dist) {
+      best_dist = d;
+      g->start = i;
+    }
+  }
+
+  sqlite3_free(sum);
+  sqlite3_free(mean);
+  return DISKANN_OK;
+}
+
+/* Start first, then every other node in a seeded Fisher-Yates order */
+static void build_shuffle_order(BuildGraph *g) {
+  uint64_t rng = BUILD_ORDER_SEED;
+  for (uint32_t i = 0; i < g->n; i++) {
+    g->order[i] = i;
+  }
+  g->order[0] = g->start;
+  g->order[g->start] = 0;
+  for (uint32_t i = g->n - 1; i > 1; i--) {
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t j = 1 + (uint32_t)((rng >> 33) % i);
+    uint32_t tmp = g->order[i];
+    g->order[i] = g->order[j];
+    g->order[j] = tmp;
+  }
+}
+
+static int build_graph_alloc(BuildGraph *g) {
+  const DiskAnnIndex *idx = g->idx;
+  uint64_t n = g->n;
+  uint64_t slots = n * g->max_edges;
+  uint64_t visits = (uint64_t)g->round_cap * g->max_visit;
+
+  g->degree = (uint32_t *)sqlite3_malloc64(n * sizeof(uint32_t));
+  g->edges = (uint32_t *)sqlite3_malloc64(slots * sizeof(uint32_t));
+  g->edge_dists = (float *)sqlite3_malloc64(slots * sizeof(float));
+  g->order = (uint32_t *)sqlite3_malloc64(n * sizeof(uint32_t));
+  g->visit_ids = (uint32_t *)sqlite3_malloc64(visits * sizeof(uint32_t));
+  g->visit_dists = (float *)sqlite3_malloc64(visits * sizeof(float));
+  g->n_visit =
+      (uint32_t *)sqlite3_malloc64((uint64_t)g->round_cap * sizeof(uint32_t));
+  g->back =
+      (BuildBackEdge *)sqlite3_malloc64(visits * sizeof(BuildBackEdge));
+  if (idx->metric == DISKANN_METRIC_COSINE) {
+    g->inv_norms = (float *)sqlite3_malloc64(n * sizeof(float));
+    if (!g->inv_norms) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    for (uint32_t i = 0; i < g->n; i++) {
+      g->inv_norms[i] = diskann_index_inv_norm(idx, build_vector(g, i));
+    }
+  }
+  if (!g->degree || !g->edges || !g->edge_dists || !g->order ||
+      !g->visit_ids || !g->visit_dists || !g->n_visit || !g->back) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(g->degree, 0, (size_t)n * sizeof(uint32_t));
+  return DISKANN_OK;
+}
+
+/* Split back[0 .. n_back) into n_workers ranges that never share a target */
+static void build_partition_back(const BuildGraph *g, uint32_t n_back,
+                                 BuildWorker *workers, uint32_t n_workers) {
+  uint32_t begin = 0;
+  for (uint32_t t = 0; t < n_workers; t++) {
+    uint32_t end = t + 1 == n_workers
+                       ? n_back
+                       : (uint32_t)((uint64_t)n_back * (t + 1) / n_workers);
+    if (end < begin) {
+      end = begin;
+    }
+    while (end > 0 && end < n_back &&
+           g->back[end].target == g->back[end - 1].target) {
+      end++;
+    }
+    workers[t].begin = begin;
+    workers[t].end = end;
+    begin = end;
+  }
+}
+
+static int build_graph_link(BuildGraph *g, uint32_t n_threads,
+                            const DiskAnnBuildConfig *config) {
+  BuildWorker workers[DISKANN_MAX_THREADS];
+  int rc = DISKANN_OK;
+
+  memset(workers, 0, sizeof(workers));
+  for (uint32_t t = 0; t < n_threads; t++) {
+    BuildWorker *w = &workers[t];
+    w->g = g;
+    w->index = t;
+    w->marks = (uint32_t *)sqlite3_malloc64((uint64_t)g->n *
+                                            sizeof(uint32_t));
+    w->beam = (uint32_t *)sqlite3_malloc64((uint64_t)g->list_size *
+                                           sizeof(uint32_t));
+    w->beam_dists =
+        (float *)sqlite3_malloc64((uint64_t)g->list_size * sizeof(float));
+    w->expanded = (uint8_t *)sqlite3_malloc64(g->list_size);
+    if (!w->marks || !w->beam || !w->beam_dists || !w->expanded) {
+      rc = DISKANN_ERROR_NOMEM;
+      goto out;
+    }
+    memset(w->marks, 0, (size_t)g->n * sizeof(uint32_t));
+  }
+
+  uint32_t linked = 1; /* order[0] = start needs no search */
+  if (config && config->progress) {
+    config->progress(linked, g->n, config->progress_ctx);
+  }
+  while (linked < g->n) {
+    uint32_t len = linked < g->round_cap ? linked : g->round_cap;
+    if (len > g->n - linked) {
+      len = g->n - linked;
+    }
+    g->round_begin = linked;
+    g->round_len = len;
+    uint32_t n_workers = len < n_threads ? len : n_threads;
+
+    build_run(workers, n_workers, build_link_round);
+
+    uint32_t n_back = 0;
+    for (uint32_t k = 0; k < len; k++) {
+      uint32_t p = g->order[linked + k];
+      const uint32_t *ids = g->visit_ids + (size_t)k * g->max_visit;
+      const float *dists = g->visit_dists + (size_t)k * g->max_visit;
+      for (uint32_t i = 0; i < g->n_visit[k]; i++) {
+        g->back[n_back].target = ids[i];
+        g->back[n_back].source = p;
+        g->back[n_back].distance = dists[i];
+        n_back++;
+      }
+    }
+    qsort(g->back, n_back, sizeof(BuildBackEdge), back_edge_cmp);
+    build_partition_back(g, n_back, workers, n_workers);
+    build_run(workers, n_workers, build_back_round);
+
+    linked += len;
+    if (config && config->progress) {
+      config->progress(linked, g->n, config->progress_ctx);
+    }
+  }
+
+out:
+  for (uint32_t t = 0; t < n_threads; t++) {
+    sqlite3_free(workers[t].marks);
+    sqlite3_free(workers[t].beam);
+    sqlite3_free(workers[t].beam_dists);
+    sqlite3_free(workers[t].expanded);
+  }
+  return rc;
+}
+
+/**************************************************************************
+** Load and store
+**************************************************************************/
+
+static int build_exec(const DiskAnnIndex *idx, char *sql) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+static int build_prepare(const DiskAnnIndex *idx, char *sql,
+                         sqlite3_stmt **stmt) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, stmt, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Load every rowid and vector, ascending by rowid. Sets g->n (0 when the
+** index is empty). */
+static int build_load_vectors(BuildGraph *g) {
+  const DiskAnnIndex *idx = g->idx;
+  sqlite3_stmt *stmt = NULL;
+  int64_t count;
+  int rc;
+
+  rc = build_prepare(idx,
+                     sqlite3_mprintf("SELECT COUNT(*) FROM \"%w\".%s",
+                                     idx->db_name, idx->shadow_name),
+                     &stmt);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  if (sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_finalize(stmt);
+    return DISKANN_ERROR;
+  }
+  count = sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+  if (count <= 0) {
+    g->n = 0;
+    return DISKANN_OK;
+  }
+  if (count > INT32_MAX) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  g->rowids = (int64_t *)sqlite3_malloc64((uint64_t)count * sizeof(int64_t));
+  g->vectors = (float *)sqlite3_malloc64((uint64_t)count * idx->dimensions *
+                                         sizeof(float));
+  if (!g->rowids || !g->vectors) {
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  rc = build_prepare(idx,
+                     sqlite3_mprintf("SELECT id, data FROM \"%w\".%s "
+                                     "ORDER BY id",
+                                     idx->db_name, idx->shadow_name),
+                     &stmt);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  g->n = 0;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const uint8_t *data = (const uint8_t *)sqlite3_column_blob(stmt, 1);
+    int n_bytes = sqlite3_column_bytes(stmt, 1);
+    if ((int64_t)g->n == count || !data ||
+        (uint32_t)n_bytes < NODE_METADATA_SIZE + idx->nNodeVectorSize) {
+      rc = SQLITE_CORRUPT;
+      break;
+    }
+    g->rowids[g->n] = sqlite3_column_int64(stmt, 0);
+    diskann_vector_decode(idx, data + NODE_METADATA_SIZE,
+                          g->vectors + (size_t)g->n * idx->dimensions);
+    g->n++;
+  }
+  sqlite3_finalize(stmt);
+  return rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Rewrite every node block in rowid order through one writable handle */
+static int build_store_blocks(BuildGraph *g, DiskAnnIndex *idx) {
+  sqlite3_blob *blob = NULL;
+  BlobSpot spot = {0};
+  int rc = DISKANN_OK;
+
+  spot.buffer = (uint8_t *)sqlite3_malloc64(idx->block_size);
+  if (!spot.buffer) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  spot.buffer_size = idx->block_size;
+
+  for (uint32_t i = 0; i < g->n; i++) {
+    const uint32_t *edges = g->edges + (size_t)i * g->max_edges;
+    const float *dists = g->edge_dists + (size_t)i * g->max_edges;
+    sqlite3_int64 rowid = (sqlite3_int64)g->rowids[i];
+
+    node_bin_init(idx, &spot, (uint64_t)rowid, build_vector(g, i));
+    for (uint32_t j = 0; j < g->degree[i]; j++) {
+      node_bin_replace_edge(idx, &spot, (int)j, (uint64_t)g->rowids[edges[j]],
+                            dists[j], build_vector(g, edges[j]));
+    }
+
+    int sqlite_rc =
+        blob ? sqlite3_blob_reopen(blob, rowid)
+             : sqlite3_blob_open(idx->db, idx->db_name, idx->shadow_name,
+                                 "data", rowid, 1, &blob);
+    if (sqlite_rc == SQLITE_OK) {
+      sqlite_rc =
+          sqlite3_blob_write(blob, spot.buffer, (int)idx->block_size, 0);
+    }
+    if (sqlite_rc != SQLITE_OK) {
+      rc = DISKANN_ERROR;
+      break;
+    }
+    idx->num_writes++;
+    idx->num_write_bytes += idx->block_size;
+  }
+
+  if (blob) {
+    sqlite3_blob_close(blob);
+  }
+  sqlite3_free(spot.buffer);
+  return rc;
+}
+
+/**************************************************************************
+** Public build API
+**************************************************************************/
+
+int diskann_build(DiskAnnIndex *idx, const DiskAnnBuildConfig *config) {
+  BuildGraph g;
+  int savepoint_active = 0;
+  int rc;
+
+  memset(&g, 0, sizeof(g));
+  if (!idx || diskann_is_read_only(idx) || idx->batch_cache) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  uint32_t n_threads = config ? config->num_threads : 0;
+  if (n_threads == 0) {
+    n_threads = diskann_cpu_count();
+  }
+  if (n_threads > DISKANN_MAX_THREADS) {
+    n_threads = DISKANN_MAX_THREADS;
+  }
+
+  /* Load and write inside one SAVEPOINT (nests inside any caller
+  ** transaction), so the graph is replaced atomically */
+  rc = build_exec(idx, sqlite3_mprintf("SAVEPOINT diskann_build_%s",
+                                       idx->index_name));
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  savepoint_active = 1;
+
+  /* Tombstoned rows go for good: the new graph never links them */
+  rc = diskann_drop_tombstones(idx);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  g.idx = idx;
+  rc = build_load_vectors(&g);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  if (g.n == 0) {
+    rc = diskann_clear_entry_point(idx);
+    goto out;
+  }
+
+  g.max_edges = node_edges_max_count(idx);
+  g.list_size = idx->insert_list_size > 0 ? idx->insert_list_size : 1;
+  g.max_visit = BUILD_VISIT_FACTOR * g.list_size;
+  g.round_cap = g.n / BUILD_ROUND_FRACTION;
+  if (g.round_cap < 1) {
+    g.round_cap = 1;
+  }
+  if (g.round_cap > BUILD_MAX_ROUND) {
+    g.round_cap = BUILD_MAX_ROUND;
+  }
+  if (n_threads > g.round_cap) {
+    n_threads = g.round_cap;
+  }
+
+  rc = build_graph_alloc(&g);
+  if (rc == DISKANN_OK) {
+    rc = build_pick_start(&g);
+  }
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  build_shuffle_order(&g);
+
+  rc = build_graph_link(&g, n_threads, config);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  /* An INT8 range derived from the data comes from every vector */
+  rc = diskann_prepare_quant_range(idx, g.vectors, g.n);
+  if (rc == DISKANN_OK) {
+    rc = build_store_blocks(&g, idx);
+  }
+  if (rc == DISKANN_OK) {
+    rc = diskann_set_entry_point(idx, g.rowids[g.start]);
+  }
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  if (g.rowids[g.n - 1] > idx->cached_max_rowid) {
+    idx->cached_max_rowid = g.rowids[g.n - 1];
+  }
+
+out:
+  if (savepoint_active && rc == DISKANN_OK) {
+    rc = build_exec(idx, sqlite3_mprintf("RELEASE diskann_build_%s",
+                                         idx->index_name));
+  }
+  if (savepoint_active && rc != DISKANN_OK) {
+    build_exec(idx, sqlite3_mprintf("ROLLBACK TO diskann_build_%s; "
+                                    "RELEASE diskann_build_%s",
+                                    idx->index_name, idx->index_name));
+  }
+  /* Every block was rewritten behind the read cache */
+  blob_cache_clear(idx->read_cache);
+  build_graph_deinit(&g);
+  return rc;
+}
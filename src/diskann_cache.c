@@ -10,16 +10,42 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* Largest slot count: keeps the 2x bucket array within int range */
+#define BLOB_CACHE_MAX_SLOTS (1 << 28)
+
+/* Fibonacci hashing: top index_bits bits of rowid * 2^64/phi */
+static int index_home(const BlobCache *cache, uint64_t rowid) {
+  return (int)((rowid * 0x9E3779B97F4A7C15ULL) >> (64 - cache->index_bits));
+}
+
+static int index_mask(const BlobCache *cache) {
+  return (1 << cache->index_bits) - 1;
+}
+
 /*
-** Initialize cache with given capacity.
+** Shared init: allocate slot arrays for capacity entries plus a bucket
+** array of at least 2 * capacity (power of 2, so probes stay short).
 */
-int blob_cache_init(BlobCache *cache, int capacity) {
+static int cache_init(BlobCache *cache, int capacity, uint64_t max_bytes) {
   if (!cache || capacity <= 0) {
     return DISKANN_ERROR;
   }
 
   memset(cache, 0, sizeof(BlobCache));
+  cache->head = -1; /* deinit-safe if an allocation below fails */
+  cache->tail = -1;
+  if (capacity > BLOB_CACHE_MAX_SLOTS) {
+    capacity = BLOB_CACHE_MAX_SLOTS;
+  }
   cache->capacity = capacity;
+  cache->n_slots = capacity;
+  cache->max_bytes = max_bytes;
+
+  int bits = 1;
+  while ((1 << bits) < 2 * capacity) {
+    bits++;
+  }
+  cache->index_bits = bits;
 
   /* Allocate parallel arrays */
   cache->slots =
@@ -28,50 +54,107 @@ int blob_cache_init(BlobCache *cache, int capacity) {
       (uint64_t *)sqlite3_malloc64((uint64_t)capacity * sizeof(uint64_t));
   cache->next = (int *)sqlite3_malloc64((uint64_t)capacity * sizeof(int));
   cache->prev = (int *)sqlite3_malloc64((uint64_t)capacity * sizeof(int));
+  cache->index = (int *)sqlite3_malloc64(((uint64_t)1 << bits) * sizeof(int));
 
-  if (!cache->slots || !cache->rowids || !cache->next || !cache->prev) {
+  if (!cache->slots || !cache->rowids || !cache->next || !cache->prev ||
+      !cache->index) {
     blob_cache_deinit(cache);
     return DISKANN_ERROR_NOMEM;
   }
 
-  /* Initialize arrays */
+  /* Initialize arrays: every slot starts on the free list */
   memset(cache->slots, 0, (size_t)capacity * sizeof(BlobSpot *));
   memset(cache->rowids, 0, (size_t)capacity * sizeof(uint64_t));
   for (int i = 0; i < capacity; i++) {
-    cache->next[i] = -1;
+    cache->next[i] = i + 1 < capacity ? i + 1 : -1;
     cache->prev[i] = -1;
   }
-
-  cache->head = -1;
-  cache->tail = -1;
-  cache->count = 0;
-  cache->hits = 0;
-  cache->misses = 0;
+  memset(cache->index, 0xFF, ((size_t)1 << bits) * sizeof(int)); /* -1 */
+  cache->free_head = 0;
 
   return DISKANN_OK;
 }
 
 /*
-** Find index of entry with given rowid.
-** Returns index if found, -1 otherwise.
+** Initialize cache with given capacity.
 */
-static int find_entry(const BlobCache *cache, uint64_t rowid) {
-  assert(cache);
+int blob_cache_init(BlobCache *cache, int capacity) {
+  return cache_init(cache, capacity, 0);
+}
 
-  /* Linear search (fast for ~100 entries, ~10 cache lines) */
-  for (int idx = cache->head; idx != -1; idx = cache->next[idx]) {
-    if (cache->rowids[idx] == rowid) {
-      return idx;
+/*
+** Initialize cache with a byte budget.
+*/
+int blob_cache_init_bytes(BlobCache *cache, uint64_t max_bytes,
+                          uint32_t block_size) {
+  if (!cache || block_size == 0) {
+    return DISKANN_ERROR;
+  }
+  uint64_t capacity = max_bytes / BLOB_CACHE_ENTRY_BYTES(block_size);
+  if (capacity == 0) {
+    return DISKANN_ERROR;
+  }
+  if (capacity > BLOB_CACHE_MAX_SLOTS) {
+    capacity = BLOB_CACHE_MAX_SLOTS;
+  }
+  return cache_init(cache, (int)capacity, max_bytes);
+}
+
+/*
+** Find the bucket holding rowid.
+** Returns bucket position if found, -1 otherwise.
+*/
+static int index_find(const BlobCache *cache, uint64_t rowid) {
+  assert(cache && cache->index);
+
+  int mask = index_mask(cache);
+  for (int pos = index_home(cache, rowid);; pos = (pos + 1) & mask) {
+    int slot = cache->index[pos];
+    if (slot == -1) {
+      return -1;
+    }
+    if (cache->rowids[slot] == rowid) {
+      return pos;
     }
   }
-  return -1;
+}
+
+/* Add slot (holding a rowid not yet indexed) to the hash index */
+static void index_insert(BlobCache *cache, int slot) {
+  int mask = index_mask(cache);
+  int pos = index_home(cache, cache->rowids[slot]);
+  while (cache->index[pos] != -1) {
+    pos = (pos + 1) & mask;
+  }
+  cache->index[pos] = slot;
+}
+
+/*
+** Empty bucket pos. Backward-shift deletion: later entries of the probe
+** run move up, so lookups never need tombstones.
+*/
+static void index_delete_at(BlobCache *cache, int pos) {
+  int mask = index_mask(cache);
+  int hole = pos;
+
+  for (int j = (hole + 1) & mask; cache->index[j] != -1; j = (j + 1) & mask) {
+    int home = index_home(cache, cache->rowids[cache->index[j]]);
+    /* Entry at j may fill the hole unless its home lies in (hole, j] */
+    int stays = hole <= j ? (home > hole && home <= j)
+                          : (home > hole || home <= j);
+    if (!stays) {
+      cache->index[hole] = cache->index[j];
+      hole = j;
+    }
+  }
+  cache->index[hole] = -1;
 }
 
 /*
 ** Remove entry at given index from LRU chain (does not free memory).
 */
 static void remove_from_chain(BlobCache *cache, int idx) {
-  assert(cache && idx >= 0 && idx < cache->capacity);
+  assert(cache && idx >= 0 && idx < cache->n_slots);
 
   int p = cache->prev[idx];
   int n = cache->next[idx];
@@ -98,7 +181,7 @@ static void remove_from_chain(BlobCache *cache, int idx) {
 ** Insert entry at head of LRU chain (most recently used).
 */
 static void insert_at_head(BlobCache *cache, int idx) {
-  assert(cache && idx >= 0 && idx < cache->capacity);
+  assert(cache && idx >= 0 && idx < cache->n_slots);
 
   cache->next[idx] = cache->head;
   cache->prev[idx] = -1;
@@ -118,7 +201,7 @@ static void insert_at_head(BlobCache *cache, int idx) {
 ** Promote entry to head (most recently used).
 */
 static void promote_to_head(BlobCache *cache, int idx) {
-  assert(cache && idx >= 0 && idx < cache->capacity);
+  assert(cache && idx >= 0 && idx < cache->n_slots);
 
   if (idx == cache->head) {
     return; /* Already at head */
@@ -128,103 +211,204 @@ static void promote_to_head(BlobCache *cache, int idx) {
   insert_at_head(cache, idx);
 }
 
+static uint64_t entry_bytes(const BlobSpot *spot) {
+  return spot ? BLOB_CACHE_ENTRY_BYTES(spot->buffer_size) : 0;
+}
+
 /*
-** Get BlobSpot for given rowid.
+** Drop the entry in slot idx whose bucket is pos: unindex, unlink,
+** release the cache's reference and return the slot to the free list.
+**
+** Releases the cache's refcount reference. The BlobSpot is freed only if
+** no other references remain (e.g., no DiskAnnNode in an active search
+** context holds a reference).
 */
-BlobSpot *blob_cache_get(BlobCache *cache, uint64_t rowid) {
-  if (!cache) {
-    return NULL;
-  }
-
-  int idx = find_entry(cache, rowid);
+static void drop_entry(BlobCache *cache, int pos, int idx) {
+  index_delete_at(cache, pos);
+  remove_from_chain(cache, idx);
 
-  if (idx == -1) {
-    cache->misses++;
-    return NULL;
+  if (cache->slots[idx] != NULL) {
+    cache->bytes -= entry_bytes(cache->slots[idx]);
+    blob_spot_free(cache->slots[idx]);
+    cache->slots[idx] = NULL;
   }
+  cache->rowids[idx] = 0;
+  cache->next[idx] = cache->free_head;
+  cache->free_head = idx;
+  cache->count--;
+}
 
-  cache->hits++;
-  promote_to_head(cache, idx);
-  blob_spot_addref(cache->slots[idx]); /* Caller gets a reference */
-  return cache->slots[idx];
+/* Evict the LRU entry */
+static void evict_tail(BlobCache *cache) {
+  assert(cache->tail != -1);
+  int idx = cache->tail;
+  int pos = index_find(cache, cache->rowids[idx]);
+  assert(pos != -1);
+  drop_entry(cache, pos, idx);
+  cache->evictions++;
 }
 
 /*
-** Find free slot index or allocate one by evicting LRU entry.
-** Returns index to use, always valid.
-**
-** Releases the cache's refcount reference on eviction. The BlobSpot is
-** freed only if no other references remain (e.g., no DiskAnnNode in an
-** active search context holds a reference).
+** Get BlobSpot for given rowid.
 */
-static int get_free_slot(BlobCache *cache) {
-  assert(cache);
-
-  if (cache->count < cache->capacity) {
-    /* Use next available slot */
-    return cache->count;
+BlobSpot *blob_cache_get(BlobCache *cache, uint64_t rowid) {
+  if (!cache || !cache->index) {
+    return NULL;
   }
 
-  /* Cache is full - evict tail (LRU) */
-  assert(cache->tail != -1);
-  int idx = cache->tail;
+  sqlite3_mutex_enter(cache->mutex);
+  int pos = index_find(cache, rowid);
 
-  /* Release cache's reference — frees BlobSpot only if last ref */
-  if (cache->slots[idx] != NULL) {
-    blob_spot_free(cache->slots[idx]);
-    cache->slots[idx] = NULL;
+  if (pos == -1) {
+    cache->misses++;
+    sqlite3_mutex_leave(cache->mutex);
+    return NULL;
   }
 
-  remove_from_chain(cache, idx);
-  cache->count--; /* Will be re-incremented in put */
-  return idx;
+  int idx = cache->index[pos];
+  BlobSpot *spot = cache->slots[idx];
+  cache->hits++;
+  promote_to_head(cache, idx);
+  blob_spot_addref(spot); /* Caller gets a reference */
+  sqlite3_mutex_leave(cache->mutex);
+  return spot;
 }
 
 /*
-** Put BlobSpot into cache.
+** Put BlobSpot into cache (caller holds the mutex).
 */
-void blob_cache_put(BlobCache *cache, uint64_t rowid, BlobSpot *spot) {
-  if (!cache) {
-    return;
-  }
-
+static void cache_put(BlobCache *cache, uint64_t rowid, BlobSpot *spot) {
   /* Check if rowid already exists */
-  int idx = find_entry(cache, rowid);
+  int pos = index_find(cache, rowid);
 
-  if (idx != -1) {
+  if (pos != -1) {
     /* Update existing entry */
+    int idx = cache->index[pos];
     if (cache->slots[idx] == spot) {
       /* Same pointer — no ref change needed, just promote */
       promote_to_head(cache, idx);
       return;
     }
     if (cache->slots[idx] != NULL) {
+      cache->bytes -= entry_bytes(cache->slots[idx]);
       blob_spot_free(cache->slots[idx]); /* Release old ref */
     }
     cache->slots[idx] = spot;
     if (spot) {
       blob_spot_addref(spot); /* Cache takes a reference */
+      cache->bytes += entry_bytes(spot);
     }
     promote_to_head(cache, idx);
     return;
   }
 
-  /* Allocate new slot (may evict LRU, releasing its ref) */
-  idx = get_free_slot(cache);
-  assert(idx >= 0 && idx < cache->capacity);
+  /* Make room: count limit (capacity may be lowered after init) and byte
+  ** budget. An entry larger than the whole budget still gets cached. */
+  uint64_t cost = entry_bytes(spot);
+  while (cache->count > 0 &&
+         (cache->count >= cache->capacity || cache->free_head == -1 ||
+          (cache->max_bytes && cache->bytes + cost > cache->max_bytes))) {
+    evict_tail(cache);
+  }
+
+  int idx = cache->free_head;
+  assert(idx >= 0 && idx < cache->n_slots);
+  cache->free_head = cache->next[idx];
 
   cache->slots[idx] = spot;
   cache->rowids[idx] = rowid;
   cache->count++;
+  index_insert(cache, idx);
 
   /* Cache takes a reference */
   if (spot) {
     blob_spot_addref(spot);
+    cache->bytes += cost;
   }
 
   insert_at_head(cache, idx);
 }
 
+/*
+** Put BlobSpot into cache.
+*/
+void blob_cache_put(BlobCache *cache, uint64_t rowid, BlobSpot *spot) {
+  if (!cache || !cache->index) {
+    return;
+  }
+  sqlite3_mutex_enter(cache->mutex);
+  cache_put(cache, rowid, spot);
+  sqlite3_mutex_leave(cache->mutex);
+}
+
+/*
+** Remove the entry for rowid.
+*/
+void blob_cache_remove(BlobCache *cache, uint64_t rowid) {
+  if (!cache || !cache->index) {
+    return;
+  }
+
+  sqlite3_mutex_enter(cache->mutex);
+  int pos = index_find(cache, rowid);
+  if (pos != -1) {
+    drop_entry(cache, pos, cache->index[pos]);
+  }
+  sqlite3_mutex_leave(cache->mutex);
+}
+
+/*
+** Drop every entry, releasing the cache's references.
+*/
+void blob_cache_clear(BlobCache *cache) {
+  if (!cache || !cache->index) {
+    return;
+  }
+  sqlite3_mutex_enter(cache->mutex);
+
+  for (int idx = cache->head; idx != -1;) {
+    int next = cache->next[idx];
+    if (cache->slots[idx] != NULL) {
+      blob_spot_free(cache->slots[idx]);
+      cache->slots[idx] = NULL;
+    }
+    idx = next;
+  }
+
+  memset(cache->rowids, 0, (size_t)cache->n_slots * sizeof(uint64_t));
+  for (int i = 0; i < cache->n_slots; i++) {
+    cache->next[i] = i + 1 < cache->n_slots ? i + 1 : -1;
+    cache->prev[i] = -1;
+  }
+  memset(cache->index, 0xFF, ((size_t)1 << cache->index_bits) * sizeof(int));
+
+  cache->count = 0;
+  cache->bytes = 0;
+  cache->head = -1;
+  cache->tail = -1;
+  cache->free_head = 0;
+  sqlite3_mutex_leave(cache->mutex);
+}
+
+void blob_cache_enable_mutex(BlobCache *cache) {
+  if (cache && !cache->mutex) {
+    cache->mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+  }
+}
+
+void blob_cache_release(BlobCache *cache, BlobSpot *spot) {
+  if (!spot) {
+    return;
+  }
+  if (!cache) {
+    blob_spot_free(spot);
+    return;
+  }
+  sqlite3_mutex_enter(cache->mutex);
+  blob_spot_free(spot);
+  sqlite3_mutex_leave(cache->mutex);
+}
+
 /*
 ** Close all blob handles in the cache, preserving buffer data.
 ** Marks each BlobSpot as aborted so blob_spot_reload() will reopen.
@@ -256,7 +440,7 @@ void blob_cache_deinit(BlobCache *cache) {
   }
 
   /* Release cache's reference on all BlobSpots */
-  if (cache->slots) {
+  if (cache->slots && cache->next) {
     for (int idx = cache->head; idx != -1;) {
       int next = cache->next[idx];
       if (cache->slots[idx] != NULL) {
@@ -268,22 +452,12 @@ void blob_cache_deinit(BlobCache *cache) {
   }
 
   /* Free arrays */
-  if (cache->slots) {
-    sqlite3_free(cache->slots);
-    cache->slots = NULL;
-  }
-  if (cache->rowids) {
-    sqlite3_free(cache->rowids);
-    cache->rowids = NULL;
-  }
-  if (cache->next) {
-    sqlite3_free(cache->next);
-    cache->next = NULL;
-  }
-  if (cache->prev) {
-    sqlite3_free(cache->prev);
-    cache->prev = NULL;
-  }
+  sqlite3_free(cache->slots);
+  sqlite3_free(cache->rowids);
+  sqlite3_free(cache->next);
+  sqlite3_free(cache->prev);
+  sqlite3_free(cache->index);
+  sqlite3_mutex_free(cache->mutex);
 
   memset(cache, 0, sizeof(BlobCache));
 }
@@ -9,10 +9,16 @@
 ** construction. Caching reduces 400GB → 160GB BLOB I/O on 25k vectors.
 **
 ** Design:
-** - Simple LRU eviction with doubly-linked list (array-based, not pointers)
-** - Linear search for get (100 entries = ~10 cache lines, fast enough)
+** - LRU eviction with a doubly-linked list (array-based, not pointers)
+** - Open-addressing rowid → slot index (linear probing, backward-shift
+**   deletion), so get/put/remove are O(1) at 10k-100k entries
+** - Capacity is an entry count, optionally bounded by a byte budget
+**   (blob_cache_init_bytes); each entry costs its buffer plus the
+**   BlobSpot header
 ** - Ownership via BlobSpot refcount: cache takes a ref on put/get,
 **   releases on eviction/deinit. BlobSpot freed when refcount reaches 0.
+** - Optional mutex (blob_cache_enable_mutex) serializes get/put/remove/
+**   clear/release so threads can share one cache of handle-less copies
 */
 #ifndef DISKANN_CACHE_H
 #define DISKANN_CACHE_H
@@ -28,7 +34,7 @@ extern "C" {
 ** BlobCache - LRU cache for BlobSpot instances
 **
 ** Memory ownership:
-** - slots, rowids, next, prev: owned by cache (freed in deinit)
+** - slots, rowids, next, prev, index: owned by cache (freed in deinit)
 ** - BlobSpot instances: managed via refcount. Cache takes a ref on
 **   put/get, releases on eviction/deinit. BlobSpot freed when last
 **   ref is released (refcount reaches 0).
@@ -36,22 +42,36 @@ extern "C" {
 ** LRU implementation:
 ** - head: most recently used (MRU)
 ** - tail: least recently used (LRU)
-** - Eviction: remove tail when cache is full
+** - Eviction: remove tail while the cache is at capacity or the new
+**   entry would exceed max_bytes
 ** - Promotion: move to head on cache hit
+** - Unused slots are chained through next[] from free_head
 */
 typedef struct BlobCache {
-  BlobSpot **slots; /* Array of BlobSpot pointers (size = capacity) */
-  uint64_t *rowids; /* Parallel array of rowids (size = capacity) */
-  int *next;        /* Next index in LRU chain (-1 = end) */
+  BlobSpot **slots; /* Array of BlobSpot pointers (size = n_slots) */
+  uint64_t *rowids; /* Parallel array of rowids (size = n_slots) */
+  int *next;        /* Next index in LRU chain / free list (-1 = end) */
   int *prev;        /* Previous index in LRU chain (-1 = end) */
-  int capacity;     /* Maximum entries */
+  int *index;       /* Hash index: slot per bucket (-1 = empty) */
+  int index_bits;   /* log2 of bucket count (>= 2 buckets per slot) */
+  int n_slots;      /* Allocated slots */
+  int capacity;     /* Maximum entries (<= n_slots) */
   int count;        /* Current entries */
   int head;         /* Index of MRU entry (-1 if empty) */
   int tail;         /* Index of LRU entry (-1 if empty) */
-  int hits;         /* Cache hit counter */
-  int misses;       /* Cache miss counter */
+  int free_head;    /* First unused slot (-1 if none) */
+  uint64_t max_bytes; /* Byte budget (0 = count limit only) */
+  uint64_t bytes;     /* Bytes held by cached entries */
+  uint64_t hits;      /* Cache hit counter */
+  uint64_t misses;    /* Cache miss counter */
+  uint64_t evictions; /* Entries evicted to make room */
+  sqlite3_mutex *mutex; /* Owned; NULL = single-threaded use only */
 } BlobCache;
 
+/* Bytes charged for one cached BlobSpot of the given buffer size */
+#define BLOB_CACHE_ENTRY_BYTES(buffer_size)                                    \
+  ((uint64_t)(buffer_size) + (uint64_t)sizeof(BlobSpot))
+
 /*
 ** Initialize cache with given capacity.
 **
@@ -67,6 +87,21 @@ typedef struct BlobCache {
 */
 int blob_cache_init(BlobCache *cache, int capacity);
 
+/*
+** Initialize cache with a byte budget.
+**
+** Sizes the cache for max_bytes worth of block_size entries (at least
+** one) and evicts by bytes as well as count, so mixed-size entries stay
+** within budget.
+**
+** Returns:
+**   DISKANN_OK on success
+**   DISKANN_ERROR if cache is NULL or max_bytes/block_size is 0
+**   DISKANN_ERROR_NOMEM if allocation fails
+*/
+int blob_cache_init_bytes(BlobCache *cache, uint64_t max_bytes,
+                          uint32_t block_size);
+
 /*
 ** Get BlobSpot for given rowid (NULL if not found).
 **
@@ -98,6 +133,19 @@ BlobSpot *blob_cache_get(BlobCache *cache, uint64_t rowid);
 */
 void blob_cache_put(BlobCache *cache, uint64_t rowid, BlobSpot *spot);
 
+/*
+** Drop the entry for rowid, if any, releasing the cache's reference.
+**
+** Used to invalidate cached copies of a block that was rewritten or
+** deleted. NULL safe; absent rowids are a no-op.
+*/
+void blob_cache_remove(BlobCache *cache, uint64_t rowid);
+
+/*
+** Drop every entry (keeping the allocated capacity). NULL safe.
+*/
+void blob_cache_clear(BlobCache *cache);
+
 /*
 ** Close all blob handles in the cache, preserving buffer data.
 **
@@ -110,6 +158,21 @@ void blob_cache_put(BlobCache *cache, uint64_t rowid, BlobSpot *spot);
 */
 void blob_cache_release_handles(BlobCache *cache);
 
+/*
+** Allocate the cache's mutex so several threads may share it (see
+** diskann_search_batch()). Shared entries must be handle-less copies, and
+** references obtained from blob_cache_get() must be dropped with
+** blob_cache_release(). Without SQLite mutex support this is a no-op.
+*/
+void blob_cache_enable_mutex(BlobCache *cache);
+
+/*
+** Drop a reference obtained from blob_cache_get() (or a put's copy) under
+** the cache's mutex. NULL cache falls back to blob_spot_free(); NULL spot
+** is a no-op.
+*/
+void blob_cache_release(BlobCache *cache, BlobSpot *spot);
+
 /*
 ** Free cache resources.
 **
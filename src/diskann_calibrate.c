@@ -0,0 +1,229 @@
+/*
+** DiskANN Calibrate — measured recall curve for sizing search beams
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** The beam a search needs for a given recall depends on the data, not
+** just the row count: sqrt(n) is too narrow for some indexes and several
+** times too wide for others. diskann_calibrate() measures instead. It
+** samples stored rows as queries, takes their true neighbors from one
+** exact scan, and runs graph searches at search list sizes growing by
+** half each step until every query finds all of its neighbors. The
+** (size, recall@k) pairs go to the metadata table; searches then pick
+** the smallest size that meets their recall target (see
+** effective_search_list_size() in diskann_search.c).
+**
+** A sampled row is its own nearest neighbor at distance 0, so both the
+** exact and the graph results ask for k + 1 rows and drop the query row.
+*/
+#include "diskann.h"
+#include "diskann_internal.h"
+#include "diskann_search.h"
+#include <math.h>
+#include <string.h>
+
+#define CALIBRATE_DEFAULT_QUERIES 100
+#define CALIBRATE_DEFAULT_K 10
+#define CALIBRATE_DEFAULT_TARGET 0.95f
+#define CALIBRATE_MAX_QUERIES 10000
+#define CALIBRATE_MAX_K 1000
+
+/* Drop row id from results (or the farthest row when id is absent), so
+** at most n - 1 remain. Returns the remaining count. */
+static int drop_query_row(DiskAnnResult *results, int n, int64_t id) {
+  for (int i = 0; i < n; i++) {
+    if (results[i].id == id) {
+      memmove(results + i, results + i + 1,
+              (size_t)(n - i - 1) * sizeof(DiskAnnResult));
+      return n - 1;
+    }
+  }
+  return n > 0 ? n - 1 : 0;
+}
+
+/* Rows of found that are in truth */
+static int count_hits(const DiskAnnResult *found, int n_found,
+                      const DiskAnnResult *truth, int n_truth) {
+  int hits = 0;
+  for (int i = 0; i < n_found; i++) {
+    for (int j = 0; j < n_truth; j++) {
+      if (found[i].id == truth[j].id) {
+        hits++;
+        break;
+      }
+    }
+  }
+  return hits;
+}
+
+/* MAX(rowid) of the shadow table, 0 when empty */
+static int64_t shadow_max_rowid(DiskAnnIndex *idx) {
+  sqlite3_stmt *stmt = diskann_stmt(idx, DISKANN_STMT_MAX_ROWID);
+  if (!stmt) {
+    return 0;
+  }
+  int64_t max_rowid = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    max_rowid = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_reset(stmt);
+  return max_rowid;
+}
+
+/*
+** Recall@k of graph searches with search_list candidates over the
+** n_queries sampled queries: found hits / true neighbors, into *recall.
+*/
+static int measure_recall(DiskAnnIndex *idx, const float *queries,
+                          const int64_t *ids, int n_queries, int k,
+                          int search_list, const DiskAnnResult *truth,
+                          const int *n_truth, DiskAnnResult *found,
+                          float *recall) {
+  uint64_t hits = 0;
+  uint64_t total = 0;
+  for (int q = 0; q < n_queries; q++) {
+    int n = diskann_search_graph_knn(
+        idx, queries + (size_t)q * idx->dimensions, k + 1, search_list, found);
+    if (n < 0) {
+      return n;
+    }
+    n = drop_query_row(found, n, ids[q]);
+    if (n > k) {
+      n = k;
+    }
+    hits += (uint64_t)count_hits(found, n, truth + (size_t)q * (size_t)(k + 1),
+                                 n_truth[q]);
+    total += (uint64_t)n_truth[q];
+  }
+  *recall = total ? (float)((double)hits / (double)total) : 1.0f;
+  return DISKANN_OK;
+}
+
+int diskann_calibrate(DiskAnnIndex *idx,
+                      const DiskAnnCalibrateConfig *config) {
+  float *queries = NULL;
+  int64_t *ids = NULL;
+  DiskAnnResult *truth = NULL;
+  int *n_truth = NULL;
+  DiskAnnResult *found = NULL;
+  DiskAnnRecallCurve curve;
+  int rc;
+
+  /* Batch mode holds edges that are not on disk yet */
+  if (!idx || diskann_is_read_only(idx) || idx->batch_cache) {
+    return DISKANN_ERROR_INVALID;
+  }
+  uint32_t n_queries = config && config->n_queries ? config->n_queries
+                                                   : CALIBRATE_DEFAULT_QUERIES;
+  uint32_t k = config && config->k ? config->k : CALIBRATE_DEFAULT_K;
+  float target = config && config->recall_target != 0.0f
+                     ? config->recall_target
+                     : CALIBRATE_DEFAULT_TARGET;
+  if (n_queries > CALIBRATE_MAX_QUERIES || k > CALIBRATE_MAX_K ||
+      !(target > 0.0f && target <= 1.0f)) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  /* Searches run here are not the application's: keep them out of
+  ** diskann_stats() */
+  DiskAnnCounters saved = idx->counters;
+  uint64_t saved_reads = idx->num_reads;
+  uint64_t saved_read_bytes = idx->num_read_bytes;
+
+  memset(&curve, 0, sizeof(curve));
+  curve.k = k;
+  curve.target = target;
+  curve.rows = shadow_max_rowid(idx);
+
+  size_t per_query = (size_t)k + 1;
+  queries = (float *)sqlite3_malloc64((uint64_t)n_queries * idx->dimensions *
+                                      sizeof(float));
+  ids = (int64_t *)sqlite3_malloc64(n_queries * sizeof(int64_t));
+  truth = (DiskAnnResult *)sqlite3_malloc64((uint64_t)n_queries * per_query *
+                                            sizeof(DiskAnnResult));
+  n_truth = (int *)sqlite3_malloc64(n_queries * sizeof(int));
+  found = (DiskAnnResult *)sqlite3_malloc64(per_query * sizeof(DiskAnnResult));
+  if (!queries || !ids || !truth || !n_truth || !found) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+
+  int n_sampled = diskann_sample_rows(idx, (int)n_queries, queries, ids);
+  if (n_sampled <= 0) {
+    rc = n_sampled; /* 0: empty index, nothing to measure */
+    goto out;
+  }
+
+  /* True neighbors of every query, from one pass over the rows */
+  rc = diskann_search_exact_multi(idx, queries, n_sampled, idx->dimensions,
+                                  (int)k + 1, truth, n_truth, NULL);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  int has_neighbors = 0;
+  for (int q = 0; q < n_sampled; q++) {
+    n_truth[q] = drop_query_row(truth + (size_t)q * per_query, n_truth[q],
+                                ids[q]);
+    if (n_truth[q] > (int)k) {
+      n_truth[q] = (int)k;
+    }
+    has_neighbors |= n_truth[q] > 0;
+  }
+  if (!has_neighbors) {
+    rc = 0; /* a single row: no neighbors to find */
+    goto out;
+  }
+
+  /* Widen by half a step at a time until every neighbor is found; a
+  ** beam as large as the index cannot find more */
+  uint64_t search_list = k + 1;
+  while (curve.n_points < DISKANN_MAX_RECALL_POINTS) {
+    float recall;
+    rc = measure_recall(idx, queries, ids, n_sampled, (int)k,
+                        (int)search_list, truth, n_truth, found, &recall);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+    curve.search_list_size[curve.n_points] = (uint32_t)search_list;
+    curve.recall[curve.n_points] = recall;
+    curve.n_points++;
+    if (recall >= 1.0f || search_list >= (uint64_t)curve.rows) {
+      break;
+    }
+    search_list += (search_list + 1) / 2;
+  }
+
+  rc = diskann_store_recall_curve(idx, &curve);
+  if (rc == DISKANN_OK) {
+    rc = curve.n_points;
+  }
+
+out:
+  idx->counters = saved;
+  idx->num_reads = saved_reads;
+  idx->num_read_bytes = saved_read_bytes;
+  sqlite3_free(queries);
+  sqlite3_free(ids);
+  sqlite3_free(truth);
+  sqlite3_free(n_truth);
+  sqlite3_free(found);
+  return rc;
+}
+
+int diskann_recall_curve(const DiskAnnIndex *idx, uint32_t *search_list_sizes,
+                         float *recalls, int max_points) {
+  if (!idx || max_points < 0) {
+    return DISKANN_ERROR_INVALID;
+  }
+  const DiskAnnRecallCurve *curve = &idx->recall;
+  for (int i = 0; i < curve->n_points && i < max_points; i++) {
+    if (search_list_sizes) {
+      search_list_sizes[i] = curve->search_list_size[i];
+    }
+    if (recalls) {
+      recalls[i] = curve->recall[i];
+    }
+  }
+  return curve->n_points;
+}
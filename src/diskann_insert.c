@@ -8,13 +8,18 @@
 */
 #define _POSIX_C_SOURCE 199309L
 #include "diskann.h"
+#include "diskann_bitmap.h"
 #include "diskann_blob.h"
 #include "diskann_cache.h"
 #include "diskann_internal.h"
+#include "diskann_label.h"
 #include "diskann_node.h"
+#include "diskann_pq.h"
 #include "diskann_search.h"
 #include "diskann_sqlite.h"
+#include "diskann_stats.h"
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -52,6 +57,198 @@ static long elapsed_us(const struct timespec *start,
          (long)(end->tv_nsec - start->tv_nsec) / 1000L;
 }
 
+/**************************************************************************
+** Pairwise distance memo
+**
+** One insert asks for the same distances several times: the walk scores
+** the new node against every visited node, phase 1 offers each visited
+** node to the new node (comparing it with the new node's edges) and then
+** prunes with it (comparing the same pairs again), and phase 2 compares
+** the new node with the edges of every visited node. DiskAnnDistMemo
+** keeps these by unordered rowid pair for the length of one insert (or
+** one deferred-edge repair), seeded with the walks' exact distances.
+**
+** Open addressing with linear probing, kept at most half full. A slot is
+** occupied when its stamp is the current one, so clearing is O(1) (as in
+** VisitedSet). Past DIST_MEMO_MAX_CAPACITY the memo stops taking new
+** pairs; lookups go on working.
+**************************************************************************/
+
+#define DIST_MEMO_INITIAL_CAPACITY 1024
+#define DIST_MEMO_MAX_CAPACITY (1 << 17)
+
+typedef struct DistMemoSlot {
+  uint64_t lo, hi; /* rowid pair, lo <= hi */
+  float distance;
+  uint32_t stamp; /* == memo stamp when occupied */
+} DistMemoSlot;
+
+struct DiskAnnDistMemo {
+  DistMemoSlot *slots;
+  uint32_t capacity; /* power of 2 */
+  uint32_t count;
+  uint32_t stamp; /* never 0 */
+};
+
+static uint32_t dist_memo_hash(uint64_t lo, uint64_t hi) {
+  uint64_t h = (lo * 0x9E3779B97F4A7C15ULL ^ hi) * 0xBF58476D1CE4E5B9ULL;
+  return (uint32_t)(h >> 32);
+}
+
+/* Slot holding (lo, hi), or the empty slot where it would go */
+static DistMemoSlot *dist_memo_find(const DiskAnnDistMemo *memo, uint64_t lo,
+                                    uint64_t hi) {
+  uint32_t mask = memo->capacity - 1;
+  uint32_t probe = dist_memo_hash(lo, hi) & mask;
+  while (memo->slots[probe].stamp == memo->stamp &&
+         (memo->slots[probe].lo != lo || memo->slots[probe].hi != hi)) {
+    probe = (probe + 1) & mask;
+  }
+  return &memo->slots[probe];
+}
+
+static int dist_memo_alloc(DiskAnnDistMemo *memo, uint32_t capacity) {
+  memo->slots =
+      (DistMemoSlot *)sqlite3_malloc64(capacity * sizeof(DistMemoSlot));
+  if (!memo->slots) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(memo->slots, 0, capacity * sizeof(DistMemoSlot));
+  memo->capacity = capacity;
+  memo->count = 0;
+  memo->stamp = 1;
+  return DISKANN_OK;
+}
+
+/* Rehash into twice the capacity */
+static int dist_memo_grow(DiskAnnDistMemo *memo) {
+  DiskAnnDistMemo grown;
+  if (dist_memo_alloc(&grown, memo->capacity * 2) != DISKANN_OK) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  for (uint32_t i = 0; i < memo->capacity; i++) {
+    const DistMemoSlot *old = &memo->slots[i];
+    if (old->stamp == memo->stamp) {
+      DistMemoSlot *slot = dist_memo_find(&grown, old->lo, old->hi);
+      *slot = *old;
+      slot->stamp = grown.stamp;
+      grown.count++;
+    }
+  }
+  sqlite3_free(memo->slots);
+  *memo = grown;
+  return DISKANN_OK;
+}
+
+/* The index's memo, created on first use; NULL when out of memory
+** (inserts then compute every distance) */
+#ifdef TESTING
+DiskAnnDistMemo *
+#else
+static DiskAnnDistMemo *
+#endif
+dist_memo_acquire(DiskAnnIndex *idx) {
+  if (!idx->dist_memo) {
+    DiskAnnDistMemo *memo =
+        (DiskAnnDistMemo *)sqlite3_malloc64(sizeof(DiskAnnDistMemo));
+    if (!memo) {
+      return NULL;
+    }
+    if (dist_memo_alloc(memo, DIST_MEMO_INITIAL_CAPACITY) != DISKANN_OK) {
+      sqlite3_free(memo);
+      return NULL;
+    }
+    idx->dist_memo = memo;
+  }
+  return idx->dist_memo;
+}
+
+/* Empty the memo in O(1); slots are only rewritten when the stamp wraps */
+#ifdef TESTING
+void
+#else
+static void
+#endif
+dist_memo_clear(DiskAnnDistMemo *memo) {
+  if (!memo) {
+    return;
+  }
+  memo->count = 0;
+  if (++memo->stamp == 0) {
+    memset(memo->slots, 0, memo->capacity * sizeof(DistMemoSlot));
+    memo->stamp = 1;
+  }
+}
+
+/*
+** Slot for the pair (a, b), found with one probe sequence: it holds their
+** distance when dist_memo_known(), otherwise it is reserved for
+** dist_memo_fill(), which must come before any other memo call. NULL
+** without a memo, or when the memo is full and the pair is not in it.
+*/
+static DistMemoSlot *dist_memo_slot(DiskAnnDistMemo *memo, uint64_t a,
+                                    uint64_t b) {
+  if (!memo) {
+    return NULL;
+  }
+  uint64_t lo = a < b ? a : b;
+  uint64_t hi = a < b ? b : a;
+  DistMemoSlot *slot = dist_memo_find(memo, lo, hi);
+  if (slot->stamp != memo->stamp && (memo->count + 1) * 2 > memo->capacity) {
+    if (memo->capacity >= DIST_MEMO_MAX_CAPACITY ||
+        dist_memo_grow(memo) != DISKANN_OK) {
+      return NULL;
+    }
+    slot = dist_memo_find(memo, lo, hi);
+  }
+  slot->lo = lo; /* no-op when known; harmless on an empty slot */
+  slot->hi = hi;
+  return slot;
+}
+
+static int dist_memo_known(const DiskAnnDistMemo *memo,
+                           const DistMemoSlot *slot) {
+  return slot && slot->stamp == memo->stamp;
+}
+
+/* Store distance in a slot from dist_memo_slot() (NULL safe) */
+static void dist_memo_fill(DiskAnnDistMemo *memo, DistMemoSlot *slot,
+                           float distance) {
+  if (slot) {
+    if (slot->stamp != memo->stamp) {
+      slot->stamp = memo->stamp;
+      memo->count++;
+    }
+    slot->distance = distance;
+  }
+}
+
+#ifdef TESTING
+/* Test helpers: the stored distance of (a, b), returning 0 when unknown,
+** and storing one (dropped when the memo is full) */
+int dist_memo_get(DiskAnnDistMemo *memo, uint64_t a, uint64_t b,
+                  float *out) {
+  DistMemoSlot *slot = dist_memo_slot(memo, a, b);
+  if (!dist_memo_known(memo, slot)) {
+    return 0;
+  }
+  *out = slot->distance;
+  return 1;
+}
+
+void dist_memo_put(DiskAnnDistMemo *memo, uint64_t a, uint64_t b,
+                   float distance) {
+  dist_memo_fill(memo, dist_memo_slot(memo, a, b), distance);
+}
+#endif
+
+void diskann_dist_memo_free(DiskAnnDistMemo *memo) {
+  if (memo) {
+    sqlite3_free(memo->slots);
+    sqlite3_free(memo);
+  }
+}
+
 /**************************************************************************
 ** Edge replacement decision
 **
@@ -61,28 +258,52 @@ static long elapsed_us(const struct timespec *start,
 ** - Returns replacement index for worst existing edge
 ** - Returns -1 if new edge is dominated (skip)
 **
+** In a label-aware index (diskann_label.h) a new edge to a node with the
+** same label can only be dominated by an existing edge with that label.
+**
+** Distances found in memo (NULL for none) are used instead of being
+** computed, and computed ones are added to it.
+**
 ** Float32-only: no V1 format branches, no VectorPair.
 **************************************************************************/
 
-static int replace_edge_idx(const DiskAnnIndex *idx, BlobSpot *node_blob,
-                            uint64_t new_rowid, const float *new_vector,
+static int replace_edge_idx(const DiskAnnIndex *idx, DiskAnnDistMemo *memo,
+                            BlobSpot *node_blob, uint64_t new_rowid,
+                            const float *new_vector, float new_inv_norm,
                             float *out_distance) {
   int n_edges = (int)node_bin_edges(idx, node_blob);
   int max_edges = (int)node_edges_max_count(idx);
   int i_replace = -1;
   float node_to_replace = 0.0f;
+  uint32_t node_label = diskann_labels_get(idx->labels,
+                                           (int64_t)node_blob->rowid);
+  int same_label = node_label != DISKANN_LABEL_NONE &&
+                   diskann_labels_get(idx->labels, (int64_t)new_rowid) ==
+                       node_label;
+
+  /* Caller may pass 0 when the norm isn't at hand; compute it once here
+  ** rather than per distance below */
+  if (new_inv_norm == 0.0f && idx->metric == DISKANN_METRIC_COSINE) {
+    new_inv_norm = diskann_index_inv_norm(idx, new_vector);
+  }
 
-  const float *node_vector = node_bin_vector(idx, node_blob);
-  float node_to_new =
-      diskann_distance(node_vector, new_vector, idx->dimensions, idx->metric);
+  float node_to_new;
+  DistMemoSlot *known = dist_memo_slot(memo, node_blob->rowid, new_rowid);
+  if (dist_memo_known(memo, known)) {
+    node_to_new = known->distance;
+  } else {
+    node_to_new = diskann_vector_distance(
+        idx, new_vector, new_inv_norm, node_bin_vector_data(idx, node_blob),
+        node_bin_inv_norm(idx, node_blob));
+    dist_memo_fill(memo, known, node_to_new);
+  }
   *out_distance = node_to_new;
 
   for (int i = n_edges - 1; i >= 0; i--) {
     uint64_t edge_rowid;
     float node_to_edge;
-    const float *edge_vector;
 
-    node_bin_edge(idx, node_blob, i, &edge_rowid, &node_to_edge, &edge_vector);
+    node_bin_edge(idx, node_blob, i, &edge_rowid, &node_to_edge, NULL);
     if (edge_rowid == new_rowid) {
       /* Zombie or duplicate edge — replace it */
       return i;
@@ -90,9 +311,19 @@ static int replace_edge_idx(const DiskAnnIndex *idx, BlobSpot *node_blob,
 
     /* No V1 branch — V3 always has stored distances */
 
-    float edge_to_new =
-        diskann_distance(edge_vector, new_vector, idx->dimensions, idx->metric);
-    if (node_to_new > idx->pruning_alpha * edge_to_new) {
+    float edge_to_new;
+    known = dist_memo_slot(memo, edge_rowid, new_rowid);
+    if (dist_memo_known(memo, known)) {
+      edge_to_new = known->distance;
+    } else {
+      edge_to_new = diskann_edge_distance(
+          idx, new_vector, new_inv_norm, node_bin_edge_data(idx, node_blob, i),
+          node_bin_edge_inv_norm(idx, node_blob, i));
+      dist_memo_fill(memo, known, edge_to_new);
+    }
+    if (node_to_new > diskann_alpha_threshold(idx, edge_to_new) &&
+        (!same_label ||
+         diskann_labels_get(idx->labels, (int64_t)edge_rowid) == node_label)) {
       /* New edge is dominated by existing edge */
       return -1;
     }
@@ -117,32 +348,38 @@ static int replace_edge_idx(const DiskAnnIndex *idx, BlobSpot *node_blob,
 **   dist(node, E) > alpha * dist(new_edge, E)
 **
 ** This maintains graph diversity by preventing redundant edges to
-** clustered nodes.
+** clustered nodes. In a label-aware index an edge to a node with the
+** node's own label is only pruned by a new edge with that label too
+** (Filtered-Vamana), so every label's subgraph stays navigable.
+**
+** replace_edge_idx() has usually just put the distances between the new
+** edge and the others into memo.
 **************************************************************************/
 
-static void prune_edges(const DiskAnnIndex *idx, BlobSpot *node_blob,
-                        int i_inserted) {
+static void prune_edges(const DiskAnnIndex *idx, DiskAnnDistMemo *memo,
+                        BlobSpot *node_blob, int i_inserted) {
   int n_edges = (int)node_bin_edges(idx, node_blob);
 
   assert(0 <= i_inserted && i_inserted < n_edges);
 
-  /*
-  ** Minimum degree to maintain graph connectivity
-  ** Research shows MIN_DEGREE >= 8 prevents disconnected components at scale
-  */
-  const int MIN_DEGREE = 8;
-
   uint64_t hint_rowid;
-  const float *hint_vector;
-  node_bin_edge(idx, node_blob, i_inserted, &hint_rowid, NULL, &hint_vector);
+  node_bin_edge(idx, node_blob, i_inserted, &hint_rowid, NULL, NULL);
+  const uint8_t *hint_data = node_bin_edge_data(idx, node_blob, i_inserted);
+  float hint_inv_norm = node_bin_edge_inv_norm(idx, node_blob, i_inserted);
+
+  /* Same-label edges the hint may not prune (label-aware indexes only) */
+  uint32_t keep_label = diskann_labels_get(idx->labels,
+                                           (int64_t)node_blob->rowid);
+  if (diskann_labels_get(idx->labels, (int64_t)hint_rowid) == keep_label) {
+    keep_label = DISKANN_LABEL_NONE;
+  }
 
   int i = 0;
   while (i < n_edges) {
     uint64_t edge_rowid;
     float node_to_edge;
-    const float *edge_vector;
 
-    node_bin_edge(idx, node_blob, i, &edge_rowid, &node_to_edge, &edge_vector);
+    node_bin_edge(idx, node_blob, i, &edge_rowid, &node_to_edge, NULL);
 
     if (hint_rowid == edge_rowid) {
       i++;
@@ -150,15 +387,36 @@ static void prune_edges(const DiskAnnIndex *idx, BlobSpot *node_blob,
     }
 
     /* Stop pruning if we've reached minimum degree */
-    if (n_edges <= MIN_DEGREE) {
+    if (n_edges <= DISKANN_MIN_DEGREE) {
       break;
     }
+    if (keep_label != DISKANN_LABEL_NONE &&
+        diskann_labels_get(idx->labels, (int64_t)edge_rowid) == keep_label) {
+      i++;
+      continue;
+    }
 
     /* No V1 branch */
 
-    float hint_to_edge = diskann_distance(hint_vector, edge_vector,
-                                          idx->dimensions, idx->metric);
-    if (node_to_edge > idx->pruning_alpha * hint_to_edge) {
+    /* Squared L2 is never negative: a hint_to_edge at or past bound
+    ** cannot prune, so its sum may stop there. nextafterf keeps bound
+    ** strictly above node_to_edge / alpha despite the float rounding. */
+    float hint_to_edge;
+    DistMemoSlot *known = dist_memo_slot(memo, hint_rowid, edge_rowid);
+    if (dist_memo_known(memo, known)) {
+      hint_to_edge = known->distance;
+    } else {
+      float bound =
+          nextafterf((float)(node_to_edge / idx->pruning_alpha), INFINITY);
+      hint_to_edge = diskann_edge_pair_distance_bounded(
+          idx, hint_data, hint_inv_norm,
+          node_bin_edge_data(idx, node_blob, i),
+          node_bin_edge_inv_norm(idx, node_blob, i), bound);
+      if (hint_to_edge < bound || !idx->l2_bounded) { /* exact */
+        dist_memo_fill(memo, known, hint_to_edge);
+      }
+    }
+    if (node_to_edge > diskann_alpha_threshold(idx, hint_to_edge)) {
       node_bin_delete_edge(idx, node_blob, i);
       n_edges--;
     } else {
@@ -174,27 +432,26 @@ static void prune_edges(const DiskAnnIndex *idx, BlobSpot *node_blob,
 ** Shadow row insertion
 **************************************************************************/
 
-static int insert_shadow_row(DiskAnnIndex *idx, int64_t id) {
-  sqlite3_stmt *stmt = NULL;
+/* Insert the shadow row for id. data is a complete block_size node block,
+** or NULL for a zeroed block that the caller fills through a blob handle. */
+static int insert_shadow_row(DiskAnnIndex *idx, int64_t id,
+                             const uint8_t *data) {
+  sqlite3_stmt *stmt = diskann_stmt(idx, DISKANN_STMT_INSERT_ROW);
   int rc;
 
-  char *sql = sqlite3_mprintf(
-      "INSERT INTO \"%w\".%s (id, data) VALUES (?, zeroblob(%d))", idx->db_name,
-      idx->shadow_name, (int)idx->block_size);
-  if (!sql) {
-    return DISKANN_ERROR_NOMEM;
-  }
-
-  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
-  sqlite3_free(sql);
-  if (rc != SQLITE_OK) {
+  if (!stmt) {
     return DISKANN_ERROR;
   }
 
   sqlite3_bind_int64(stmt, 1, id);
+  if (data) {
+    sqlite3_bind_blob(stmt, 2, data, (int)idx->block_size, SQLITE_STATIC);
+  } else {
+    sqlite3_bind_zeroblob(stmt, 2, (int)idx->block_size);
+  }
 
   rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
 
   if (rc == SQLITE_CONSTRAINT) {
     return DISKANN_ERROR_EXISTS;
@@ -210,20 +467,111 @@ static int insert_shadow_row(DiskAnnIndex *idx, int64_t id) {
 ** Public insert API
 **************************************************************************/
 
-int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
-                   uint32_t dims) {
+/* Phase 1 for one neighbor: offer spot as an edge of the new node.
+** scratch holds one decoded vector for half-precision indexes. */
+static void link_forward(const DiskAnnIndex *idx, DiskAnnDistMemo *memo,
+                         BlobSpot *new_blob, BlobSpot *spot, float *scratch) {
+  const float *spot_vector = node_bin_vector_float(idx, spot, scratch);
+  float distance;
+  int i_replace =
+      replace_edge_idx(idx, memo, new_blob, spot->rowid, spot_vector,
+                       node_bin_inv_norm(idx, spot), &distance);
+  if (i_replace == -1) {
+    return;
+  }
+  node_bin_replace_edge(idx, new_blob, i_replace, spot->rowid, distance,
+                        spot_vector);
+  prune_edges(idx, memo, new_blob, i_replace);
+}
+
+/* Phase 2 for one neighbor: offer the new node as an edge of spot, deferred
+** in batch mode. *n_flushes counts immediate block writes. */
+static int link_back(DiskAnnIndex *idx, DiskAnnDistMemo *memo,
+                     BlobSpot *spot, int64_t id, const float *vector,
+                     float inv_norm, int *n_flushes) {
+  float distance;
+  int i_replace = replace_edge_idx(idx, memo, spot, (uint64_t)id, vector,
+                                   inv_norm, &distance);
+  if (i_replace == -1) {
+    return DISKANN_OK;
+  }
+
+  if (idx->deferred_edges) {
+    /* Batch mode: defer edge. On NOMEM, fall through to immediate
+    ** flush path. */
+    int add_rc = deferred_edge_list_add(
+        idx->deferred_edges, (int64_t)spot->rowid, id, distance, vector);
+    if (add_rc == DISKANN_OK) {
+      return DISKANN_OK;
+    }
+    /* NOMEM or other error — fall through to immediate path */
+  }
+
+  /* Non-batch mode OR deferred add failed: immediate flush */
+  node_bin_replace_edge(idx, spot, i_replace, (uint64_t)id, distance, vector);
+  prune_edges(idx, memo, spot, i_replace);
+  (*n_flushes)++;
+  return blob_spot_flush(idx, spot);
+}
+
+/* Writable spot for rowid through cache (cached copies are the current
+** ones in batch mode). The caller owns one reference. */
+static int load_cached_spot(DiskAnnIndex *idx, BlobCache *cache,
+                            uint64_t rowid, BlobSpot **out) {
+  BlobSpot *spot = blob_cache_get(cache, rowid);
+  int rc = DISKANN_OK;
+  if (!spot) {
+    rc = blob_spot_load(idx, &spot, rowid);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  rc = blob_spot_reload(idx, spot, rowid, idx->block_size);
+  if (rc != DISKANN_OK) {
+    blob_spot_free(spot);
+    return rc;
+  }
+  blob_cache_put(cache, rowid, spot);
+  *out = spot;
+  return DISKANN_OK;
+}
+
+/* Nearest batch members offered to each node of diskann_insert_batch() */
+#define INSERT_BATCH_CANDIDATES 8
+
+/*
+** How diskann_insert_batch() links one node: its shadow row (and PQ code)
+** already exists, the walk starts from a row the batch picked (never an
+** unlinked batch member), and the nearest batch members are offered as
+** neighbors alongside the visited nodes.
+*/
+typedef struct InsertBatchNode {
+  uint64_t start_rowid;
+  int first; /* Index was empty: no walk, link batch members only */
+  const int64_t *candidates;
+  int n_candidates;
+} InsertBatchNode;
+
+static int insert_node(DiskAnnIndex *idx, int64_t id, const float *vector,
+                       uint32_t dims, const InsertBatchNode *batch) {
   DiskAnnSearchCtx ctx = {0};
+  DiskAnnSearchCtx label_ctx = {0}; /* walk of the new node's label */
+  DiskAnnSearchCtx *walks[2] = {&ctx, &label_ctx};
+  int n_walks = 1;
   BlobSpot *new_blob = NULL;
   BlobCache cache = {0};
   BlobCache *active_cache = NULL; /* Points to batch_cache or &cache */
   int cache_initialized = 0;
-  char *savepoint_sql = NULL;
   uint64_t start_rowid = 0;
   int rc;
   int first = 0;
   int ctx_valid = 0;
   int savepoint_active = 0;
   int deferred_save_count = 0;
+  BlobSpot *batch_spots[INSERT_BATCH_CANDIDATES];
+  int n_batch_spots = 0;
+  float *scratch = NULL; /* decoded neighbor vector, half-precision only */
+  DiskAnnDistMemo *memo = NULL;
 
   /* Timing instrumentation (zero cost when disabled) */
   int timing = insert_timing_enabled();
@@ -236,16 +584,29 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
     clock_gettime(CLOCK_MONOTONIC, &t_entry);
   }
 
-  /* Validate inputs */
-  if (!idx)
+  /* Validate inputs (readers never write) */
+  if (!idx || diskann_is_read_only(idx))
     return DISKANN_ERROR_INVALID;
   if (!vector)
     return DISKANN_ERROR_INVALID;
   if (dims != idx->dimensions)
     return DISKANN_ERROR_DIMENSION;
+  uint64_t start_us = diskann_clock_us();
 
-  /* Select random start node BEFORE inserting (avoids zombie confusion) */
-  rc = diskann_select_random_shadow_row(idx, &start_rowid);
+  if (batch) {
+    /* diskann_insert_batch(): rows, batch mode and savepoint are set up */
+    start_rowid = batch->start_rowid;
+    first = batch->first;
+    active_cache = idx->batch_cache;
+    if (timing) {
+      clock_gettime(CLOCK_MONOTONIC, &t_random);
+      t_savepoint = t_random;
+    }
+    goto search;
+  }
+
+  /* Select start node BEFORE inserting (avoids zombie confusion) */
+  rc = diskann_select_start_row(idx, &start_rowid);
 
   if (rc == SQLITE_DONE) {
     first = 1;
@@ -263,24 +624,20 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
    * When called from vtab xUpdate, there's already an active SQL statement
    * so SAVEPOINT fails with SQLITE_BUSY. That's OK — the vtab's implicit
    * transaction provides atomicity for shadow table operations. */
-  savepoint_sql =
-      sqlite3_mprintf("SAVEPOINT diskann_insert_%s", idx->index_name);
-  if (!savepoint_sql) {
-    return DISKANN_ERROR_NOMEM;
-  }
-  rc = sqlite3_exec(idx->db, savepoint_sql, NULL, NULL, NULL);
-
-  sqlite3_free(savepoint_sql);
-  savepoint_sql = NULL;
-  if (rc == SQLITE_OK) {
-    savepoint_active = 1;
-  }
+  savepoint_active = diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_INSERT);
   /* If SAVEPOINT failed (e.g., SQLITE_BUSY from vtab context), continue
    * without it — the caller's transaction provides atomicity. */
   if (timing) {
     clock_gettime(CLOCK_MONOTONIC, &t_savepoint);
   }
 
+  /* An INT8 range derived from the data must exist before edges do */
+  rc = diskann_prepare_quant_range(idx, vector, 1);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+search:
   /* Search for neighbors (skip if first node) */
   if (!first) {
     /* Use batch cache if in batch mode, otherwise create per-insert cache */
@@ -297,7 +654,8 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
       active_cache = &cache;
     }
 
-    rc = diskann_search_ctx_init(&ctx, vector, (int)idx->insert_list_size, 1,
+    rc = diskann_search_ctx_init(&ctx, idx, vector,
+                                 (int)idx->insert_list_size, 1,
                                  DISKANN_BLOB_WRITABLE);
 
     if (rc != DISKANN_OK) {
@@ -305,12 +663,42 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
     }
     ctx_valid = 1;
 
-    rc = diskann_search_internal(idx, &ctx, start_rowid, active_cache);
+    rc = diskann_search_from(idx, &ctx, start_rowid, active_cache);
+    if (rc == SQLITE_DONE) {
+      /* Stale entry point on an index that turned out to be empty */
+      first = 1;
+      rc = DISKANN_OK;
+    }
 
     if (rc != DISKANN_OK) {
       goto out;
     }
 
+    /* Label-aware index: also link to the nearest nodes of the new node's
+    ** label, found by a walk that stays in the label's subgraph */
+    uint32_t label = diskann_labels_get(idx->labels, id);
+    int64_t label_entry;
+    if (!first && diskann_labels_entry(idx->labels, label, &label_entry) &&
+        label_entry != id) {
+      rc = diskann_search_ctx_init(&label_ctx, idx, vector,
+                                   (int)idx->search_list_size, 1,
+                                   DISKANN_BLOB_WRITABLE);
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+      n_walks = 2;
+      label_ctx.label = label;
+      rc = diskann_search_internal(idx, &label_ctx, (uint64_t)label_entry,
+                                   active_cache);
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        /* Stale label entry point: link by the main walk only */
+        rc = DISKANN_OK;
+      }
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+    }
+
     /* Count visited nodes for timing log */
     if (timing) {
       for (DiskAnnNode *v = ctx.visited_list; v != NULL; v = v->next) {
@@ -322,58 +710,105 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
     clock_gettime(CLOCK_MONOTONIC, &t_search);
   }
 
+  if (batch) {
+    /* The row exists and may have back-edges from earlier batch members;
+    ** load the batch members to offer as neighbors */
+    rc = load_cached_spot(idx, active_cache, (uint64_t)id, &new_blob);
+    for (int i = 0; rc == DISKANN_OK && i < batch->n_candidates; i++) {
+      rc = load_cached_spot(idx, active_cache,
+                            (uint64_t)batch->candidates[i],
+                            &batch_spots[n_batch_spots]);
+      if (rc == DISKANN_OK) {
+        n_batch_spots++;
+      }
+    }
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+    if (timing) {
+      clock_gettime(CLOCK_MONOTONIC, &t_shadow);
+    }
+    goto link;
+  }
+
   /* Insert shadow row */
-  rc = insert_shadow_row(idx, id);
+  rc = insert_shadow_row(idx, id, NULL);
 
   if (rc != DISKANN_OK) {
     goto out;
   }
 
-  /* Create BlobSpot for new row, load zeroblob, then initialize node */
-  rc = blob_spot_create(idx, &new_blob, (uint64_t)id, idx->block_size,
-                        DISKANN_BLOB_WRITABLE);
+  /* Load the new row's zeroblob, then initialize node */
+  rc = blob_spot_load(idx, &new_blob, (uint64_t)id);
 
   if (rc != DISKANN_OK) {
     goto out;
   }
 
-  rc = blob_spot_reload(idx, new_blob, (uint64_t)id, idx->block_size);
+  node_bin_init(idx, new_blob, (uint64_t)id, vector);
 
+  rc = diskann_pq_add_vector(idx, id, vector);
   if (rc != DISKANN_OK) {
     goto out;
   }
-
-  node_bin_init(idx, new_blob, (uint64_t)id, vector);
   if (timing) {
     clock_gettime(CLOCK_MONOTONIC, &t_shadow);
   }
 
   if (first) {
-    /* First node: no edges to build, just flush and return */
+    /* First node: no edges to build, just flush and make it the entry
+    ** point until a refresh picks a more central one */
     rc = blob_spot_flush(idx, new_blob);
     if (rc != DISKANN_OK) {
       goto out;
     }
-    rc = DISKANN_OK;
+    rc = diskann_set_entry_point(idx, id);
     goto out;
   }
 
-  /* Phase 1: add visited nodes as edges to the NEW node */
-  for (DiskAnnNode *visited = ctx.visited_list; visited != NULL;
-       visited = visited->next) {
-    int i_replace;
-    float distance;
-
-    const float *visited_vector = node_bin_vector(idx, visited->blob_spot);
-
-    i_replace = replace_edge_idx(idx, new_blob, visited->rowid, visited_vector,
-                                 &distance);
-    if (i_replace == -1) {
+link:
+  /* The walks scored the new node against every node they visited */
+  memo = dist_memo_acquire(idx);
+  dist_memo_clear(memo);
+  for (int w = 0; memo && w < n_walks; w++) {
+    for (DiskAnnNode *visited = walks[w]->visited_list; visited != NULL;
+         visited = visited->next) {
+      dist_memo_fill(memo, dist_memo_slot(memo, (uint64_t)id, visited->rowid),
+                     visited->distance);
+    }
+  }
+  if (idx->vector_type != DISKANN_VECTOR_FLOAT32) {
+    scratch = (float *)sqlite3_malloc64(idx->dimensions * sizeof(float));
+    if (!scratch) {
+      rc = DISKANN_ERROR_NOMEM;
+      goto out;
+    }
+  }
+  /* Phase 1: add visited nodes as edges to the NEW node. Nodes both walks
+  ** visited are linked once, through the main walk's blob. */
+  for (int w = 0; w < n_walks; w++) {
+    for (DiskAnnNode *visited = walks[w]->visited_list; visited != NULL;
+         visited = visited->next) {
+      if (w > 0 && diskann_search_ctx_visited(&ctx, visited->rowid)) {
+        continue;
+      }
+      if (!diskann_node_is_live(idx, visited->blob_spot)) {
+        continue; /* About to be deleted anyway */
+      }
+      link_forward(idx, memo, new_blob, visited->blob_spot, scratch);
+    }
+  }
+  /* Batch members the walks did not reach (edges to batch members not
+  ** linked yet are fine: their blocks hold their vectors) */
+  for (int i = 0; i < n_batch_spots; i++) {
+    uint64_t rowid = batch_spots[i]->rowid;
+    if ((ctx_valid && diskann_search_ctx_visited(&ctx, rowid)) ||
+        (n_walks > 1 && diskann_search_ctx_visited(&label_ctx, rowid))) {
+      blob_spot_free(batch_spots[i]); /* Linked above */
+      batch_spots[i] = NULL;
       continue;
     }
-    node_bin_replace_edge(idx, new_blob, i_replace, visited->rowid, distance,
-                          visited_vector);
-    prune_edges(idx, new_blob, i_replace);
+    link_forward(idx, memo, new_blob, batch_spots[i], scratch);
   }
   if (timing) {
     clock_gettime(CLOCK_MONOTONIC, &t_phase1);
@@ -381,39 +816,30 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
 
   /* Phase 2: add NEW node as edge to visited nodes */
   deferred_save_count = idx->deferred_edges ? idx->deferred_edges->count : 0;
-  for (DiskAnnNode *visited = ctx.visited_list; visited != NULL;
-       visited = visited->next) {
-    int i_replace;
-    float distance;
-
-    i_replace = replace_edge_idx(idx, visited->blob_spot, (uint64_t)id, vector,
-                                 &distance);
-    if (i_replace == -1) {
-      continue;
-    }
-
-    if (idx->deferred_edges &&
-        idx->deferred_edges->count < idx->deferred_edges->capacity) {
-      /* Batch mode + capacity: defer edge. On NOMEM (vector copy failed),
-      ** fall through to immediate flush path. */
-      int add_rc = deferred_edge_list_add(
-          idx->deferred_edges, (int64_t)visited->rowid, id, distance, vector);
-      if (add_rc == DISKANN_OK) {
+  for (int w = 0; w < n_walks; w++) {
+    for (DiskAnnNode *visited = walks[w]->visited_list; visited != NULL;
+         visited = visited->next) {
+      if (w > 0 && diskann_search_ctx_visited(&ctx, visited->rowid)) {
         continue;
       }
-      /* NOMEM or other error — fall through to immediate path */
+      if (!diskann_node_is_live(idx, visited->blob_spot)) {
+        continue; /* About to be deleted anyway */
+      }
+      rc = link_back(idx, memo, visited->blob_spot, id, vector,
+                     ctx.query_inv_norm, &phase2_flushes);
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
     }
-
-    /* Non-batch mode OR spillover OR deferred add failed: immediate flush */
-    node_bin_replace_edge(idx, visited->blob_spot, i_replace, (uint64_t)id,
-                          distance, vector);
-    prune_edges(idx, visited->blob_spot, i_replace);
-
-    rc = blob_spot_flush(idx, visited->blob_spot);
-    if (rc != DISKANN_OK) {
-      goto out;
+  }
+  for (int i = 0; i < n_batch_spots; i++) {
+    if (batch_spots[i]) {
+      rc = link_back(idx, memo, batch_spots[i], id, vector,
+                     ctx.query_inv_norm, &phase2_flushes);
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
     }
-    phase2_flushes++;
   }
   if (timing) {
     clock_gettime(CLOCK_MONOTONIC, &t_phase2);
@@ -431,6 +857,15 @@ int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
     blob_cache_put(idx->batch_cache, (uint64_t)id, new_blob);
   }
 
+  /* Deferred edges at their budget: repair this chunk now */
+  if (idx->deferred_edges && deferred_edge_list_bytes(idx->deferred_edges) >=
+                                 idx->deferred_edges->budget) {
+    rc = diskann_batch_repair_edges(idx, idx->deferred_edges);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  }
+
   /* Update cached max rowid for dynamic search list scaling */
   if (id > idx->cached_max_rowid) {
     idx->cached_max_rowid = id;
@@ -447,41 +882,38 @@ out:
   if (rc != DISKANN_OK && idx->deferred_edges) {
     deferred_edge_list_truncate(idx->deferred_edges, deferred_save_count);
   }
-
-  /* Release or rollback SAVEPOINT */
-  if (savepoint_active) {
-    char *sp_sql;
-    if (rc == DISKANN_OK) {
-      sp_sql = sqlite3_mprintf("RELEASE SAVEPOINT diskann_insert_%s",
-                               idx->index_name);
-    } else {
-      sp_sql = sqlite3_mprintf("ROLLBACK TO SAVEPOINT diskann_insert_%s",
-                               idx->index_name);
-    }
-    if (sp_sql) {
-      sqlite3_exec(idx->db, sp_sql, NULL, NULL, NULL);
-      sqlite3_free(sp_sql);
-      /* After rollback, also release the savepoint */
-      if (rc != DISKANN_OK) {
-        char *rel_sql = sqlite3_mprintf("RELEASE SAVEPOINT diskann_insert_%s",
-                                        idx->index_name);
-        if (rel_sql) {
-          sqlite3_exec(idx->db, rel_sql, NULL, NULL, NULL);
-          sqlite3_free(rel_sql);
-        }
-      }
-    }
+  if (rc == DISKANN_OK) {
+    idx->entry_inserts++;
   }
 
+  sqlite3_free(scratch);
   if (new_blob) {
     blob_spot_free(new_blob);
   }
+  for (int i = 0; i < n_batch_spots; i++) {
+    if (batch_spots[i]) {
+      blob_spot_free(batch_spots[i]);
+    }
+  }
   if (cache_initialized) {
+    diskann_stats_fold_cache(idx, &cache);
     blob_cache_deinit(&cache);
   }
   if (ctx_valid) {
     diskann_search_ctx_deinit(&ctx);
   }
+  if (n_walks > 1) {
+    diskann_search_ctx_deinit(&label_ctx);
+  }
+  blob_pool_release_handle(idx->blob_pool);
+
+  /* Release or rollback SAVEPOINT. Blob handles must be closed first:
+  ** releasing the outermost savepoint commits, which fails while any
+  ** handle is open and would leave the transaction running. */
+  diskann_end_savepoint(idx, DISKANN_SAVEPOINT_INSERT, savepoint_active, rc);
+  if (rc == DISKANN_OK) {
+    diskann_stats_insert(idx, diskann_clock_us() - start_us);
+  }
 
   /* Emit timing log line (only on success for non-first inserts) */
   if (timing && !first && rc == DISKANN_OK) {
@@ -489,16 +921,317 @@ out:
     fprintf(
         stderr,
         "DISKANN_TIMING: %lld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
-        "%d,%d,%d,%d\n",
+        "%llu,%llu,%d,%d\n",
         (long long)id, elapsed_us(&t_entry, &t_exit),
         elapsed_us(&t_entry, &t_random), elapsed_us(&t_random, &t_savepoint),
         elapsed_us(&t_savepoint, &t_search), elapsed_us(&t_search, &t_shadow),
         elapsed_us(&t_shadow, &t_phase1), elapsed_us(&t_phase1, &t_phase2),
         elapsed_us(&t_phase2, &t_flush_new), elapsed_us(&t_flush_new, &t_exit),
-        active_cache ? active_cache->hits : 0,
-        active_cache ? active_cache->misses : 0, visited_count, phase2_flushes);
+        (unsigned long long)(active_cache ? active_cache->hits : 0),
+        (unsigned long long)(active_cache ? active_cache->misses : 0),
+        visited_count, phase2_flushes);
+  }
+
+  return rc;
+}
+
+/* Reusing a tombstoned or queued-for-deletion id removes the old node
+** first. That drops id's label, which the caller may already have set for
+** the new node. */
+static int purge_for_reuse(DiskAnnIndex *idx, int64_t id) {
+  uint32_t label = diskann_labels_get(idx->labels, id);
+  int rc = diskann_flush_deletes(idx);
+  if (rc == DISKANN_OK) {
+    rc = diskann_purge_tombstone(idx, id);
+    if (rc == DISKANN_ERROR_NOTFOUND) {
+      rc = DISKANN_OK; /* The flush deleted it */
+    }
+  }
+  if (rc == DISKANN_OK && label != DISKANN_LABEL_NONE) {
+    rc = diskann_labels_put(idx->labels, id, label);
+  }
+  return rc;
+}
+
+int diskann_insert(DiskAnnIndex *idx, int64_t id, const float *vector,
+                   uint32_t dims) {
+  int rc = insert_node(idx, id, vector, dims, NULL);
+  if (rc == DISKANN_ERROR_EXISTS && purge_for_reuse(idx, id) == DISKANN_OK) {
+    rc = insert_node(idx, id, vector, dims, NULL);
+  }
+  return rc;
+}
+
+/*
+** Vector-only ingest for diskann_build(): the node block is written with
+** zero edges in a single INSERT, and the graph is not touched.
+*/
+static int insert_vector_node(DiskAnnIndex *idx, int64_t id,
+                              const float *vector, uint32_t dims) {
+  BlobSpot spot = {0};
+  int rc;
+
+  if (!idx || diskann_is_read_only(idx) || !vector) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (dims != idx->dimensions) {
+    return DISKANN_ERROR_DIMENSION;
+  }
+
+  spot.buffer = (uint8_t *)sqlite3_malloc64(idx->block_size);
+  if (!spot.buffer) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  spot.buffer_size = idx->block_size;
+  node_bin_init(idx, &spot, (uint64_t)id, vector);
+
+  rc = insert_shadow_row(idx, id, spot.buffer);
+  if (rc == DISKANN_OK) {
+    rc = diskann_pq_add_vector(idx, id, vector);
+  }
+  if (rc == DISKANN_OK && id > idx->cached_max_rowid) {
+    idx->cached_max_rowid = id;
+  }
+
+  sqlite3_free(spot.buffer);
+  return rc;
+}
+
+int diskann_insert_vector(DiskAnnIndex *idx, int64_t id, const float *vector,
+                          uint32_t dims) {
+  int rc = insert_vector_node(idx, id, vector, dims);
+  if (rc == DISKANN_ERROR_EXISTS && purge_for_reuse(idx, id) == DISKANN_OK) {
+    rc = insert_vector_node(idx, id, vector, dims);
+  }
+  return rc;
+}
+
+/**************************************************************************
+** Array insert
+**
+** diskann_insert_batch() writes every shadow row first with one prepared
+** statement, then links the nodes in order under a single savepoint. Each
+** node is offered its nearest batch members (found CPU-side, no I/O) as
+** well as the nodes its walk visits, so a batch of similar vectors links
+** to itself even where the graph does not lead to the new rows yet.
+**************************************************************************/
+
+/* Batch members compared pairwise for candidates (cost is linear in n) */
+#define INSERT_BATCH_WINDOW 512
+
+/* Write one zero-edge block per id, reusing tombstoned or queued ids.
+** *n_rows counts the rows written. */
+static int insert_batch_rows(DiskAnnIndex *idx, const int64_t *ids,
+                             const float *vectors, int n, int *n_rows) {
+  sqlite3_stmt *stmt = diskann_stmt(idx, DISKANN_STMT_INSERT_ROW);
+  BlobSpot spot = {0};
+  if (!stmt) {
+    return DISKANN_ERROR;
+  }
+  spot.buffer = (uint8_t *)sqlite3_malloc64(idx->block_size);
+  if (!spot.buffer) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  spot.buffer_size = idx->block_size;
+
+  int rc = DISKANN_OK;
+  for (int i = 0; rc == DISKANN_OK && i < n; i++) {
+    const float *vector = vectors + (size_t)i * idx->dimensions;
+    node_bin_init(idx, &spot, (uint64_t)ids[i], vector);
+    sqlite3_bind_int64(stmt, 1, ids[i]);
+    sqlite3_bind_blob(stmt, 2, spot.buffer, (int)idx->block_size,
+                      SQLITE_STATIC);
+    int step_rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (step_rc == SQLITE_CONSTRAINT) {
+      rc = purge_for_reuse(idx, ids[i]);
+      step_rc = rc == DISKANN_OK ? sqlite3_step(stmt) : SQLITE_CONSTRAINT;
+      sqlite3_reset(stmt);
+    }
+    if (step_rc == SQLITE_CONSTRAINT) {
+      rc = DISKANN_ERROR_EXISTS; /* Live node, or repeated in ids */
+    } else if (step_rc != SQLITE_DONE) {
+      rc = DISKANN_ERROR;
+    } else {
+      rc = diskann_pq_add_vector(idx, ids[i], vector);
+    }
+    if (rc == DISKANN_OK) {
+      (*n_rows)++;
+      if (ids[i] > idx->cached_max_rowid) {
+        idx->cached_max_rowid = ids[i];
+      }
+    }
+  }
+
+  sqlite3_free(spot.buffer);
+  return rc;
+}
+
+/* Keep the INSERT_BATCH_CANDIDATES nearest in row i, sorted by distance */
+static void offer_candidate(int *cand, float *cand_dist, int *n_cand, int i,
+                            int j, float distance) {
+  int *row = cand + (size_t)i * INSERT_BATCH_CANDIDATES;
+  float *row_dist = cand_dist + (size_t)i * INSERT_BATCH_CANDIDATES;
+  int n = n_cand[i];
+  if (n == INSERT_BATCH_CANDIDATES && distance >= row_dist[n - 1]) {
+    return;
+  }
+  int pos = n < INSERT_BATCH_CANDIDATES ? n : n - 1;
+  while (pos > 0 && row_dist[pos - 1] > distance) {
+    row[pos] = row[pos - 1];
+    row_dist[pos] = row_dist[pos - 1];
+    pos--;
+  }
+  row[pos] = j;
+  row_dist[pos] = distance;
+  if (n < INSERT_BATCH_CANDIDATES) {
+    n_cand[i] = n + 1;
+  }
+}
+
+/* Nearest batch members of each node: row i of cand (INSERT_BATCH_CANDIDATES
+** wide) holds n_cand[i] batch positions, nearest first, comparing nodes
+** within INSERT_BATCH_WINDOW windows */
+static int find_batch_candidates(const DiskAnnIndex *idx, const float *vectors,
+                                 int n, int *cand, int *n_cand) {
+  float *cand_dist = (float *)sqlite3_malloc64(
+      (sqlite3_uint64)n * INSERT_BATCH_CANDIDATES * sizeof(float));
+  float *inv_norms =
+      (float *)sqlite3_malloc64((sqlite3_uint64)n * sizeof(float));
+  if (!cand_dist || !inv_norms) {
+    sqlite3_free(cand_dist);
+    sqlite3_free(inv_norms);
+    return DISKANN_ERROR_NOMEM;
+  }
+  for (int i = 0; i < n; i++) {
+    n_cand[i] = 0;
+    inv_norms[i] =
+        idx->metric == DISKANN_METRIC_COSINE
+            ? diskann_index_inv_norm(idx, vectors + (size_t)i * idx->dimensions)
+            : 0.0f;
+  }
+
+  for (int base = 0; base < n; base += INSERT_BATCH_WINDOW) {
+    int end = n - base < INSERT_BATCH_WINDOW ? n : base + INSERT_BATCH_WINDOW;
+    for (int i = base; i < end; i++) {
+      const float *a = vectors + (size_t)i * idx->dimensions;
+      for (int j = i + 1; j < end; j++) {
+        float d = diskann_index_distance_normed(
+            idx, a, inv_norms[i], vectors + (size_t)j * idx->dimensions,
+            inv_norms[j]);
+        offer_candidate(cand, cand_dist, n_cand, i, j, d);
+        offer_candidate(cand, cand_dist, n_cand, j, i, d);
+      }
+    }
+  }
+
+  sqlite3_free(cand_dist);
+  sqlite3_free(inv_norms);
+  return DISKANN_OK;
+}
+
+int diskann_insert_batch(DiskAnnIndex *idx, const int64_t *ids,
+                         const float *vectors, int n, uint32_t dims) {
+  uint64_t start_rowid = 0;
+  int *cand = NULL;
+  int *n_cand = NULL;
+  int first = 0;
+  int own_batch = 0;
+  int deferred_save_count = 0;
+  int n_rows = 0;
+
+  if (!idx || diskann_is_read_only(idx) || n < 0 ||
+      (n > 0 && (!ids || !vectors))) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (dims != idx->dimensions) {
+    return DISKANN_ERROR_DIMENSION;
+  }
+  if (n == 0) {
+    return DISKANN_OK;
   }
 
+  /* Fallback start row, picked before the new rows exist */
+  int rc = diskann_select_start_row(idx, &start_rowid);
+  if (rc == SQLITE_DONE) {
+    first = 1;
+  } else if (rc != DISKANN_OK) {
+    return DISKANN_ERROR;
+  }
+
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_INSERT_BATCH);
+  if (!idx->batch_cache) {
+    rc = diskann_begin_batch(idx, 0);
+    own_batch = rc == DISKANN_OK;
+  } else if (idx->deferred_edges) {
+    deferred_save_count = idx->deferred_edges->count;
+  }
+
+  if (rc == DISKANN_OK) {
+    rc = diskann_prepare_quant_range(idx, vectors, (uint64_t)n);
+  }
+  if (rc == DISKANN_OK) {
+    rc = insert_batch_rows(idx, ids, vectors, n, &n_rows);
+  }
+  if (rc == DISKANN_OK && first) {
+    /* Empty index: the first member is the entry point and the others
+    ** reach it through their batch candidates */
+    rc = diskann_set_entry_point(idx, ids[0]);
+    start_rowid = (uint64_t)ids[0];
+  }
+  if (rc == DISKANN_OK) {
+    cand = (int *)sqlite3_malloc64((sqlite3_uint64)n *
+                                   INSERT_BATCH_CANDIDATES * sizeof(int));
+    n_cand = (int *)sqlite3_malloc64((sqlite3_uint64)n * sizeof(int));
+    rc = cand && n_cand ? find_batch_candidates(idx, vectors, n, cand, n_cand)
+                        : DISKANN_ERROR_NOMEM;
+  }
+  for (int i = 0; rc == DISKANN_OK && i < n; i++) {
+    const int *row = cand + (size_t)i * INSERT_BATCH_CANDIDATES;
+    int64_t cand_ids[INSERT_BATCH_CANDIDATES];
+    InsertBatchNode node = {
+        .start_rowid = start_rowid,
+        .first = first && i == 0,
+        .candidates = cand_ids,
+        .n_candidates = n_cand[i],
+    };
+    for (int c = n_cand[i] - 1; c >= 0; c--) {
+      cand_ids[c] = ids[row[c]];
+      if (row[c] < i) {
+        /* Walk from the nearest linked member: it starts next to the
+        ** node's neighborhood and converges in a few hops */
+        node.start_rowid = (uint64_t)ids[row[c]];
+      }
+    }
+    rc = insert_node(idx, ids[i], vectors + (size_t)i * idx->dimensions,
+                     dims, &node);
+  }
+  sqlite3_free(cand);
+  sqlite3_free(n_cand);
+
+  if (own_batch) {
+    /* Applies deferred work inside the savepoint */
+    int end_rc = rc == DISKANN_OK ? diskann_end_batch(idx)
+                                  : diskann_abort_batch(idx);
+    if (rc == DISKANN_OK) {
+      rc = end_rc;
+    }
+  } else if (rc != DISKANN_OK && idx->deferred_edges) {
+    deferred_edge_list_truncate(idx->deferred_edges, deferred_save_count);
+  }
+
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_INSERT_BATCH,
+                             savepoint_active, rc);
+  if (rc != DISKANN_OK) {
+    for (int i = 0; i < n_rows; i++) {
+      (void)diskann_pq_remove_vector(idx, ids[i]);
+    }
+    if (first) {
+      idx->has_entry = 0; /* Rolled back with the rows */
+    }
+    diskann_discard_cached_state(idx);
+  }
   return rc;
 }
 
@@ -508,22 +1241,36 @@ out:
 ** During batch mode, Phase 2 back-edges are pre-filtered and deferred
 ** into this list. At diskann_end_batch(), diskann_batch_repair_edges()
 ** sorts by target, loads each node once, re-checks acceptance, applies
-** edges with pruning, and flushes once per target.
+** edges with pruning, and flushes once per target. An insert that leaves
+** the list at its byte budget runs the same repair early, so large batches
+** are repaired in sorted chunks rather than falling back to per-edge
+** flushes.
 **************************************************************************/
 
-int deferred_edge_list_init(DeferredEdgeList *list, int capacity,
+int deferred_edge_list_init(DeferredEdgeList *list, uint64_t budget,
                             uint32_t vector_size) {
-  if (!list || capacity <= 0 || vector_size == 0) {
+  if (!list || budget == 0 || vector_size == 0) {
     return DISKANN_ERROR_INVALID;
   }
-  list->edges = (DeferredEdge *)sqlite3_malloc64((sqlite3_uint64)capacity *
-                                                 sizeof(DeferredEdge));
-  if (!list->edges) {
+  memset(list, 0, sizeof(*list));
+  list->vector_size = vector_size;
+  list->budget = budget;
+  return DISKANN_OK;
+}
+
+/* Make room for one more entry in *array (doubling from 256). */
+static int grow_array(void **array, uint32_t *capacity, uint32_t count,
+                      size_t elem_size) {
+  if (count < *capacity) {
+    return DISKANN_OK;
+  }
+  uint32_t n = *capacity ? *capacity * 2 : 256;
+  void *p = sqlite3_realloc64(*array, (sqlite3_uint64)n * elem_size);
+  if (!p) {
     return DISKANN_ERROR_NOMEM;
   }
-  list->count = 0;
-  list->capacity = capacity;
-  list->vector_size = vector_size;
+  *array = p;
+  *capacity = n;
   return DISKANN_OK;
 }
 
@@ -533,53 +1280,71 @@ int deferred_edge_list_add(DeferredEdgeList *list, int64_t target_rowid,
   if (!list || !vector) {
     return DISKANN_ERROR_INVALID;
   }
-  if (list->count >= list->capacity) {
-    return DISKANN_ERROR; /* At capacity — caller should spillover */
+  uint32_t capacity = (uint32_t)list->capacity;
+  int rc = grow_array((void **)&list->edges, &capacity, (uint32_t)list->count,
+                      sizeof(DeferredEdge));
+  list->capacity = (int)capacity;
+  if (rc != DISKANN_OK) {
+    return rc;
   }
-  float *vec_copy = (float *)sqlite3_malloc((int)list->vector_size);
-  if (!vec_copy) {
-    return DISKANN_ERROR_NOMEM;
+
+  /* One insert defers its edges back to back: reuse its slot */
+  uint32_t slot = list->n_vectors;
+  if (list->count > 0) {
+    const DeferredEdge *last = &list->edges[list->count - 1];
+    if (last->inserted_rowid == inserted_rowid &&
+        memcmp(deferred_edge_vector(list, last), vector, list->vector_size) ==
+            0) {
+      slot = last->vector_slot;
+    }
+  }
+  if (slot == list->n_vectors) {
+    rc = grow_array((void **)&list->vectors, &list->vectors_capacity,
+                    list->n_vectors, list->vector_size);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+    memcpy(list->vectors + (size_t)slot * list->vector_size, vector,
+           list->vector_size);
+    list->n_vectors++;
   }
-  memcpy(vec_copy, vector, list->vector_size);
 
   DeferredEdge *e = &list->edges[list->count];
   e->target_rowid = target_rowid;
   e->inserted_rowid = inserted_rowid;
   e->distance = distance;
-  e->vector = vec_copy;
+  e->vector_slot = slot;
   list->count++;
   return DISKANN_OK;
 }
 
+uint64_t deferred_edge_list_bytes(const DeferredEdgeList *list) {
+  return (uint64_t)list->count * sizeof(DeferredEdge) +
+         (uint64_t)list->n_vectors * list->vector_size;
+}
+
 void deferred_edge_list_truncate(DeferredEdgeList *list, int saved_count) {
   if (!list || saved_count < 0 || saved_count >= list->count) {
     return;
   }
-  for (int i = saved_count; i < list->count; i++) {
-    if (list->edges[i].vector) {
-      sqlite3_free(list->edges[i].vector);
-      list->edges[i].vector = NULL;
-    }
-  }
   list->count = saved_count;
+  /* Slots are handed out in edge order */
+  list->n_vectors =
+      saved_count > 0 ? list->edges[saved_count - 1].vector_slot + 1 : 0;
 }
 
 void deferred_edge_list_deinit(DeferredEdgeList *list) {
   if (!list) {
     return;
   }
-  if (list->edges) {
-    for (int i = 0; i < list->count; i++) {
-      if (list->edges[i].vector) {
-        sqlite3_free(list->edges[i].vector);
-        list->edges[i].vector = NULL;
-      }
-    }
-    sqlite3_free(list->edges);
-    list->edges = NULL;
-  }
+  sqlite3_free(list->edges);
+  sqlite3_free(list->vectors);
+  list->edges = NULL;
+  list->vectors = NULL;
   list->count = 0;
   list->capacity = 0;
+  list->n_vectors = 0;
+  list->vectors_capacity = 0;
 }
 
 static int cmp_target_rowid(const void *a, const void *b) {
@@ -597,12 +1362,14 @@ int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list) {
     return DISKANN_OK;
   }
 
-  /* Sort by target_rowid for grouping */
+  /* Sort by target_rowid for grouping (slots stay valid) */
   qsort(list->edges, (size_t)list->count, sizeof(DeferredEdge),
         cmp_target_rowid);
 
   int rc = DISKANN_OK;
   int i = 0;
+  DiskAnnDistMemo *memo = dist_memo_acquire(idx);
+  dist_memo_clear(memo);
 
   while (i < list->count) {
     int64_t target = list->edges[i].target_rowid;
@@ -621,8 +1388,7 @@ int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list) {
       spot->is_initialized = 0;
       spot->is_aborted = 1;
     } else {
-      rc = blob_spot_create(idx, &spot, (uint64_t)target, idx->block_size,
-                            DISKANN_BLOB_WRITABLE);
+      rc = blob_spot_load(idx, &spot, (uint64_t)target);
       if (rc != DISKANN_OK) {
         break;
       }
@@ -636,13 +1402,15 @@ int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list) {
     /* Apply all deferred edges to this target */
     while (i < list->count && list->edges[i].target_rowid == target) {
       DeferredEdge *e = &list->edges[i];
+      const float *vector = deferred_edge_vector(list, e);
       float dist;
-      int i_replace = replace_edge_idx(idx, spot, (uint64_t)e->inserted_rowid,
-                                       e->vector, &dist);
+      int i_replace =
+          replace_edge_idx(idx, memo, spot, (uint64_t)e->inserted_rowid,
+                           vector, 0.0f, &dist);
       if (i_replace != -1) {
         node_bin_replace_edge(idx, spot, i_replace, (uint64_t)e->inserted_rowid,
-                              dist, e->vector);
-        prune_edges(idx, spot, i_replace);
+                              dist, vector);
+        prune_edges(idx, memo, spot, i_replace);
       }
       i++;
     }
@@ -655,5 +1423,221 @@ int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list) {
     }
   }
 
+  blob_pool_release_handle(idx->blob_pool);
+
+  /* Drained either way: after a failure the caller rolls the batch back */
+  list->count = 0;
+  list->n_vectors = 0;
+  return rc;
+}
+
+/**************************************************************************
+** Tombstone consolidation
+**
+** FreshDiskANN-style repair: a live node p that loses edges to deleted
+** nodes is offered each deleted neighbor's own live neighbors as
+** candidates, through the same replace/prune rule as an insert. Every
+** affected node is rewritten once, and each deleted block is read once
+** while it stays in a bounded cache of handle-less copies.
+**************************************************************************/
+
+#define CONSOLIDATE_CACHE_BYTES (64ULL * 1024 * 1024)
+
+/* Pass 1: the live nodes with at least one edge into dead, header reads
+** only */
+static int collect_affected(DiskAnnIndex *idx, const DiskAnnBitmap *dead,
+                            DiskAnnBitmap *affected) {
+  sqlite3_stmt *stmt = NULL;
+  BlobSpot *reader = NULL;
+  char *sql = sqlite3_mprintf("SELECT id FROM \"%w\".%s ORDER BY id",
+                              idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t rowid = sqlite3_column_int64(stmt, 0);
+    if (diskann_bitmap_contains(dead, rowid)) {
+      continue;
+    }
+    rc = reader ? DISKANN_OK
+                : blob_spot_create(idx, &reader, (uint64_t)rowid,
+                                   idx->block_size, DISKANN_BLOB_READONLY);
+    if (rc == DISKANN_OK) {
+      rc = node_bin_load_adjacency(idx, reader, (uint64_t)rowid);
+    }
+    if (rc != DISKANN_OK) {
+      break;
+    }
+    int n_edges = (int)node_bin_edges(idx, reader);
+    for (int i = 0; i < n_edges; i++) {
+      uint64_t edge_rowid;
+      node_bin_edge(idx, reader, i, &edge_rowid, NULL, NULL);
+      if (diskann_bitmap_contains(dead, (int64_t)edge_rowid)) {
+        rc = diskann_bitmap_add(affected, rowid);
+        break;
+      }
+    }
+    if (rc != DISKANN_OK) {
+      break;
+    }
+  }
+  if (rc == SQLITE_DONE) {
+    rc = DISKANN_OK;
+  } else if (rc > 0) {
+    rc = DISKANN_ERROR;
+  }
+
+  sqlite3_finalize(stmt);
+  blob_spot_free(reader);
+  return rc;
+}
+
+/* A deleted node's full block, from dead_cache or read through loader.
+** The caller releases the returned reference with blob_spot_free(). */
+static int load_dead_block(DiskAnnIndex *idx, BlobCache *dead_cache,
+                           BlobSpot **loader, uint64_t rowid,
+                           BlobSpot **out) {
+  *out = blob_cache_get(dead_cache, rowid);
+  if (*out) {
+    return DISKANN_OK;
+  }
+  int rc = *loader ? DISKANN_OK
+                   : blob_spot_create(idx, loader, rowid, idx->block_size,
+                                      DISKANN_BLOB_READONLY);
+  if (rc == DISKANN_OK) {
+    rc = blob_spot_reload(idx, *loader, rowid, idx->block_size);
+  }
+  if (rc == DISKANN_OK) {
+    rc = blob_spot_copy(*loader, out);
+  }
+  if (rc == DISKANN_OK) {
+    blob_cache_put(dead_cache, rowid, *out);
+  }
+  return rc;
+}
+
+int diskann_consolidate_edges(DiskAnnIndex *idx, const DiskAnnBitmap *dead,
+                              const DiskAnnBitmap *affected) {
+  DiskAnnBitmap scanned;
+  DiskAnnBitmapIter it;
+  BlobCache dead_cache = {0};
+  BlobSpot *spot = NULL;
+  BlobSpot *loader = NULL;
+  uint64_t *dead_edges = NULL;
+  float *candidate = NULL;
+  int64_t p;
+  uint32_t max_edges = node_edges_max_count(idx);
+
+  int rc = DISKANN_OK;
+  diskann_bitmap_init(&scanned);
+  if (!affected) {
+    rc = collect_affected(idx, dead, &scanned);
+    affected = &scanned;
+  }
+  if (rc != DISKANN_OK || affected->count == 0) {
+    diskann_bitmap_deinit(&scanned);
+    return rc;
+  }
+
+  rc = blob_cache_init_bytes(&dead_cache, CONSOLIDATE_CACHE_BYTES,
+                             idx->block_size);
+  if (rc != DISKANN_OK) {
+    diskann_bitmap_deinit(&scanned);
+    return rc;
+  }
+  dead_edges = (uint64_t *)sqlite3_malloc64(max_edges * sizeof(uint64_t));
+  candidate = (float *)sqlite3_malloc64(idx->dimensions * sizeof(float));
+  if (!dead_edges || !candidate) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+
+  /* Pass 2: rewrite each affected node once, in rowid order */
+  diskann_bitmap_iter_init(&it, affected);
+  while (diskann_bitmap_next(&it, &p)) {
+    if (diskann_bitmap_contains(dead, p)) {
+      continue;
+    }
+    rc = spot ? DISKANN_OK
+              : blob_spot_create(idx, &spot, (uint64_t)p, idx->block_size,
+                                 DISKANN_BLOB_WRITABLE);
+    if (rc == DISKANN_OK) {
+      rc = blob_spot_reload(idx, spot, (uint64_t)p, idx->block_size);
+    }
+    if (rc == DISKANN_ROW_NOT_FOUND) {
+      /* Zombie edge of a caller-supplied set: nothing to repair */
+      blob_spot_free(spot);
+      spot = NULL;
+      continue;
+    }
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+
+    /* Drop the dead edges first so they can't dominate candidates */
+    int n_dead = 0;
+    for (int i = (int)node_bin_edges(idx, spot) - 1; i >= 0; i--) {
+      uint64_t edge_rowid;
+      node_bin_edge(idx, spot, i, &edge_rowid, NULL, NULL);
+      if (diskann_bitmap_contains(dead, (int64_t)edge_rowid)) {
+        dead_edges[n_dead++] = edge_rowid;
+        node_bin_delete_edge(idx, spot, i);
+      }
+    }
+
+    for (int d = 0; d < n_dead; d++) {
+      BlobSpot *dead_block;
+      rc = load_dead_block(idx, &dead_cache, &loader, dead_edges[d],
+                           &dead_block);
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        continue;
+      }
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+      int n_edges = (int)node_bin_edges(idx, dead_block);
+      for (int i = 0; i < n_edges; i++) {
+        uint64_t c;
+        float distance;
+        node_bin_edge(idx, dead_block, i, &c, NULL, NULL);
+        if (c == (uint64_t)p || diskann_bitmap_contains(dead, (int64_t)c)) {
+          continue;
+        }
+        diskann_edge_decode(idx, node_bin_edge_data(idx, dead_block, i),
+                            candidate);
+        int i_replace = replace_edge_idx(
+            idx, NULL, spot, c, candidate,
+            node_bin_edge_inv_norm(idx, dead_block, i), &distance);
+        if (i_replace == -1) {
+          continue;
+        }
+        node_bin_replace_edge(idx, spot, i_replace, c, distance, candidate);
+        prune_edges(idx, NULL, spot, i_replace);
+      }
+      blob_spot_free(dead_block);
+    }
+
+    rc = blob_spot_flush(idx, spot);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+    blob_cache_remove(idx->read_cache, (uint64_t)p);
+    blob_cache_remove(idx->batch_cache, (uint64_t)p);
+  }
+  rc = DISKANN_OK;
+
+out:
+  blob_spot_free(spot);
+  blob_spot_free(loader);
+  blob_cache_deinit(&dead_cache);
+  sqlite3_free(dead_edges);
+  sqlite3_free(candidate);
+  diskann_bitmap_deinit(&scanned);
   return rc;
 }
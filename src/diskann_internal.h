@@ -13,17 +13,94 @@
 #define DISKANN_INTERNAL_H
 
 #include "diskann.h"
+#include "diskann_simd.h"
 #include "diskann_sqlite.h"
+#include <stddef.h>
 #include <stdint.h>
 
 /* Forward declaration to avoid circular include:
 ** diskann_cache.h → diskann_blob.h → diskann_internal.h */
 typedef struct BlobCache BlobCache;
+typedef struct DiskAnnPq DiskAnnPq;
+typedef struct DiskAnnLabels DiskAnnLabels;
+typedef struct DiskAnnBitmap DiskAnnBitmap;
+typedef struct BlobSpot BlobSpot;
+typedef struct BlobPool BlobPool;
+typedef struct DiskAnnDistMemo DiskAnnDistMemo;
+typedef struct DiskAnnSnapshot DiskAnnSnapshot;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+** Savepoints opened by single- and multi-row changes, named
+** diskann_<name>_<index> (see diskann_begin_savepoint()).
+*/
+typedef enum DiskAnnSavepoint {
+  DISKANN_SAVEPOINT_INSERT,
+  DISKANN_SAVEPOINT_INSERT_BATCH,
+  DISKANN_SAVEPOINT_DELETE,
+  DISKANN_SAVEPOINT_DELETE_BATCH,
+  DISKANN_SAVEPOINT_CONSOLIDATE,
+  DISKANN_SAVEPOINT_OPTIMIZE,
+  DISKANN_SAVEPOINT_CALIBRATE,
+  DISKANN_SAVEPOINT_COUNT
+} DiskAnnSavepoint;
+
+/*
+** SQL run on every insert, delete or search, prepared once per handle
+** (see diskann_stmt()). Each savepoint has a SAVEPOINT, RELEASE and
+** ROLLBACK TO statement starting at DISKANN_STMT_SAVEPOINT.
+*/
+typedef enum DiskAnnStmtId {
+  DISKANN_STMT_RANDOM_ROW,    /* rowid at or after a random rowid */
+  DISKANN_STMT_FIRST_ROW,     /* lowest rowid */
+  DISKANN_STMT_MAX_ROWID,     /* MAX(rowid) of the shadow table */
+  DISKANN_STMT_DATA_VERSION,  /* PRAGMA data_version */
+  DISKANN_STMT_INSERT_ROW,    /* shadow row: id, data */
+  DISKANN_STMT_DELETE_ROW,    /* shadow row: id */
+  DISKANN_STMT_TOMBSTONE_ADD, /* "tombstones" metadata += delta */
+  DISKANN_STMT_PQ_INSERT,     /* PQ code: id, code */
+  DISKANN_STMT_PQ_DELETE,     /* PQ code: id */
+  DISKANN_STMT_QUANT_RANGE,   /* stored INT8 range, NULLs when absent */
+  DISKANN_STMT_SAVEPOINT,
+  DISKANN_STMT_COUNT = DISKANN_STMT_SAVEPOINT + 3 * DISKANN_SAVEPOINT_COUNT
+} DiskAnnStmtId;
+
+/*
+** Recall@k measured by diskann_calibrate() at ascending search list
+** sizes ("recall_*" metadata keys). n_points == 0: not calibrated.
+*/
+typedef struct DiskAnnRecallCurve {
+  int n_points;
+  uint32_t search_list_size[DISKANN_MAX_RECALL_POINTS];
+  float recall[DISKANN_MAX_RECALL_POINTS];
+  uint32_t k;      /* recall@k measured */
+  float target;    /* default recall target of searches */
+  int64_t rows;    /* MAX(rowid) when measured */
+} DiskAnnRecallCurve;
+
+/* Latency histogram buckets: 4 per power of two microseconds, the last
+** open-ended (about 33 s); see diskann_stats.c */
+#define DISKANN_LATENCY_BUCKETS 96
+
+/*
+** Counters behind diskann_stats() (see diskann_stats.h). Plain
+** increments: a handle is used by one thread at a time.
+*/
+typedef struct DiskAnnCounters {
+  uint64_t searches;      /* queries answered, graph or exact scan */
+  uint64_t nodes_visited; /* nodes visited by graph walks */
+  uint64_t visited[DISKANN_STATS_VISITED_BUCKETS]; /* walks by visit count */
+  uint64_t zombie_edges;  /* edges to missing rows met by walks */
+  uint64_t inserts;       /* successful graph inserts */
+  uint64_t insert_cache_hits;   /* per-insert and batch block caches */
+  uint64_t insert_cache_misses;
+  uint64_t search_us[DISKANN_LATENCY_BUCKETS]; /* search latency */
+  uint64_t insert_us[DISKANN_LATENCY_BUCKETS]; /* insert latency */
+} DiskAnnCounters;
+
 /*
 ** Internal DiskAnnIndex structure
 **
@@ -32,103 +109,264 @@ extern "C" {
 ** - db: borrowed reference (owned by caller)
 ** - db_name, index_name, shadow_name: owned by this struct (must free)
 ** - All other fields: owned by this struct
+**
+** A reader (diskann_open_reader()) borrows index_name, shadow_name, pq,
+** labels, read_cache and snapshot from its shared handle and owns only
+** db_name, its statements and its search context. The borrowed pointers
+** are re-read from the shared handle before each search
+** (diskann_reader_sync()).
 */
 struct DiskAnnIndex {
   sqlite3 *db;       /* Database connection (borrowed) */
   char *db_name;     /* Database schema name (e.g., "main") - malloc'd */
   char *index_name;  /* Index name - malloc'd */
   char *shadow_name; /* Shadow table name (e.g., "idx_shadow") - malloc'd */
+  DiskAnnIndex *shared; /* Handle a reader borrows from; NULL otherwise */
 
   /* Index configuration (loaded from metadata) */
   uint32_t dimensions;       /* Vector dimensionality */
   uint8_t metric;            /* Distance metric (DISKANN_METRIC_*) */
   uint32_t max_neighbors;    /* Max edges per node */
   uint32_t search_list_size; /* Search beam width */
+  uint32_t beam_width;       /* Nodes expanded per search hop (not stored) */
+  uint32_t exact_scan_max_rows; /* Scan instead of walk up to this many rows
+                                ** (not stored) */
   uint32_t insert_list_size; /* Insert beam width */
   uint32_t block_size;       /* Node block size in bytes */
   double pruning_alpha;      /* Edge pruning threshold (default 1.2) */
 
+  /* Edge vector encoding (DISKANN_EDGE_*) and INT8 quantization params:
+  ** value = quant_min + code * quant_scale, code in [0, 255] */
+  uint8_t edge_type;
+  float quant_min;
+  float quant_scale;
+  /* Range taken from the data ("quant_auto" metadata) rather than
+  ** configured; quant_unsettled: the stored range may be missing or rolled
+  ** back, so it is re-read before edges are written (see
+  ** diskann_prepare_quant_range()) */
+  uint8_t quant_auto;
+  uint8_t quant_unsettled;
+
+  /* Element type of stored node vectors and FLOAT32 edge slots
+  ** (DISKANN_VECTOR_*, "vector_type" metadata) */
+  uint8_t vector_type;
+
   /* Derived layout fields (computed from config at open time) */
-  uint32_t nNodeVectorSize; /* dims * sizeof(float) for float32 */
-  uint32_t nEdgeVectorSize; /* Same as nNodeVectorSize for float32-only */
+  uint32_t nNodeVectorSize; /* dims * bytes per stored element */
+  uint32_t nEdgeVectorSize; /* dims * bytes per encoded edge dimension */
+
+  /* Distance kernel for metric, selected once at open time (see
+  ** diskann_simd.h). NULL falls back to scalar diskann_distance(). */
+  DiskAnnDistanceFn distance;
+  DiskAnnDistanceFn dot; /* a·b kernel, used with stored cosine norms */
+  /* Early-abandon squared L2; NULL unless euclidean over float32 vectors */
+  DiskAnnBoundedDistanceFn l2_bounded;
+  /* Float32 query against a stored half-precision vector: squared L2 for
+  ** euclidean, a·b otherwise. NULL for float32 indexes. */
+  DiskAnnHalfDistanceFn half_distance;
+  int simd_level; /* DISKANN_SIMD_* level the kernels came from */
 
   /* Statistics (for debugging/profiling) */
   uint64_t num_reads;  /* Number of BLOB reads */
   uint64_t num_writes; /* Number of BLOB writes */
+  uint64_t num_read_bytes; /* Bytes read by full and partial BLOB reads */
+  uint64_t num_write_bytes; /* Bytes written by BLOB flushes */
+  DiskAnnCounters counters; /* Search/insert counters (diskann_stats()) */
 
   /* Cached max rowid for dynamic search list scaling (updated on insert) */
   int64_t cached_max_rowid;
 
+  /* Beam sizes for recall targets (see diskann_calibrate()) */
+  DiskAnnRecallCurve recall;
+
+  /* Beam-search entry point (approximate medoid), persisted as the
+  ** "entry_rowid" metadata key. has_entry == 0 falls back to a random
+  ** row. Re-picked at diskann_end_batch() once entry_inserts reaches
+  ** entry_refresh_at; the threshold doubles after each refresh. */
+  int64_t entry_rowid;
+  int has_entry;
+  uint32_t entry_inserts;    /* successful inserts since last refresh */
+  uint32_t entry_refresh_at; /* entry_inserts that triggers a refresh */
+
+  /* diskann_delete() behavior (DISKANN_DELETE_*, "delete_mode" metadata)
+  ** and the tombstone count that triggers diskann_consolidate()
+  ** ("consolidate_threshold" metadata, 0 = explicit calls only) */
+  int delete_mode;
+  uint32_t consolidate_at;
+
+  /* In-memory PQ routing codes (see diskann_pq.h); NULL = disabled */
+  DiskAnnPq *pq;
+
+  /* Per-row labels of a LABEL metadata column (see diskann_label.h);
+  ** NULL = label-aware graph disabled */
+  DiskAnnLabels *labels;
+
+  /* Memory-mapped snapshot the blocks are read from (see
+  ** diskann_snapshot.h); NULL = blocks come from the shadow table. A
+  ** snapshot handle has no connection (db == NULL). */
+  DiskAnnSnapshot *snapshot;
+
+  /* Shared read-side node cache for diskann_search() (NULL = disabled,
+  ** see diskann_set_cache_budget()). Holds handle-less block copies;
+  ** entries are dropped when this handle rewrites or deletes a block, and
+  ** the whole cache is cleared on diskann_abort_batch() or when the
+  ** database data version shows a commit from another connection. */
+  BlobCache *read_cache;
+  int64_t read_cache_data_version; /* PRAGMA data_version at last check */
+
+  /* Pooled search context reused by diskann_search() (NULL until the first
+  ** search, or while a search has it checked out) */
+  struct DiskAnnSearchCtx *search_pool;
+
+  /* Writable spots recycled across insert walks (NULL until the first
+  ** insert; see BlobPool in diskann_blob.h) */
+  BlobPool *blob_pool;
+
+  /* Pairwise distances of the current insert or deferred-edge repair
+  ** (NULL until the first insert; see diskann_insert.c) */
+  DiskAnnDistMemo *dist_memo;
+
   /* Batch mode: persistent cache across multiple inserts */
   BlobCache *batch_cache;                  /* NULL when not in batch mode */
   struct DeferredEdgeList *deferred_edges; /* NULL when not in batch mode */
+  struct DeferredDeleteList *deferred_deletes; /* NULL unless queued */
+
+  /* Prepared statements by DiskAnnStmtId, NULL until first use */
+  sqlite3_stmt *stmts[DISKANN_STMT_COUNT];
 };
 
+/*
+** The cached statement for id, prepared on first use. Callers bind, step
+** and sqlite3_reset() it before returning: an active statement would keep
+** a RELEASE from committing. Returns NULL if it cannot be prepared.
+*/
+sqlite3_stmt *diskann_stmt(DiskAnnIndex *idx, DiskAnnStmtId id);
+
+/* Finalize every cached statement (before the connection closes) */
+void diskann_stmts_finalize(DiskAnnIndex *idx);
+
+/*
+** Make reader a search-only view of idx on db (see diskann_open_reader()).
+** reader takes ownership of db_name; everything else it would own starts
+** empty. Counters start at zero.
+*/
+void diskann_reader_init(DiskAnnIndex *reader, DiskAnnIndex *idx, sqlite3 *db,
+                         char *db_name);
+
+/* Free what diskann_reader_init() left reader owning (not reader itself) */
+void diskann_reader_deinit(DiskAnnIndex *reader);
+
+/*
+** Re-borrow what the shared handle may have replaced or moved since the
+** last call: PQ codes, labels, read cache, entry point, row count, recall
+** curve and INT8 range. Every public search entry point calls this first,
+** so a reader never keeps a pointer the shared handle has freed (e.g. by
+** diskann_set_cache_budget() or diskann_pq_build()). No-op on a handle
+** that is not a reader.
+*/
+void diskann_reader_sync(DiskAnnIndex *reader);
+
+/* Readers and snapshots only search: writes return DISKANN_ERROR_INVALID */
+static inline int diskann_is_read_only(const DiskAnnIndex *idx) {
+  return idx->shared != NULL || idx->snapshot != NULL;
+}
+
+/*
+** Fill the fields derived from a loaded configuration: vector sizes,
+** distance kernels, the default pruning alpha and the per-handle search
+** settings. Called by diskann_open_index() and diskann_open_snapshot().
+*/
+void diskann_init_derived(DiskAnnIndex *idx);
+
 /*
 ** Deferred back-edge for lazy batch repair.
 **
 ** During batch insert, Phase 2 (back-edges to visited neighbors) is deferred.
 ** Each DeferredEdge records a candidate edge to apply later in a single
-** repair pass at diskann_end_batch().
-**
-** Memory ownership:
-** - vector: OWNED copy (malloc'd), freed by truncate/deinit
+** repair pass at diskann_end_batch(). The inserted node's vector lives in
+** the list's vector arena, shared by every edge of that insert.
 */
 typedef struct DeferredEdge {
   int64_t target_rowid;   /* Existing node to add back-edge TO */
   int64_t inserted_rowid; /* Newly-inserted node (edge source) */
   float distance;         /* Precomputed dist(target, inserted) */
-  float *vector;          /* OWNED copy of inserted node's vector */
+  uint32_t vector_slot;   /* Inserted node's vector in the arena */
 } DeferredEdge;
 
 /*
-** Growable array of deferred edges with fixed capacity.
-** Initialized in diskann_begin_batch(), consumed by
-*diskann_batch_repair_edges(),
-** freed in diskann_end_batch().
+** Growable array of deferred edges plus an arena holding each inserted
+** vector once. Initialized in diskann_begin_batch(), drained by
+** diskann_batch_repair_edges() whenever the bytes in use reach budget
+** (and at diskann_end_batch()), freed in diskann_end_batch().
 */
 typedef struct DeferredEdgeList {
-  DeferredEdge *edges;  /* Array of deferred edges (malloc'd) */
-  int count;            /* Current number of entries */
-  int capacity;         /* Max entries (fixed at init) */
-  uint32_t vector_size; /* Bytes per vector copy (= idx->nNodeVectorSize) */
+  DeferredEdge *edges;       /* Array of deferred edges (malloc'd) */
+  int count;                 /* Current number of entries */
+  int capacity;              /* Allocated entries */
+  unsigned char *vectors;    /* Vector arena, vector_size bytes per slot */
+  uint32_t n_vectors;        /* Slots in use */
+  uint32_t vectors_capacity; /* Allocated slots */
+  uint32_t vector_size;      /* Bytes per float32 vector */
+  uint64_t budget;           /* Bytes in use that trigger an early repair */
 } DeferredEdgeList;
 
-/* Default capacity for deferred edge list.
-** Supports ~960 inserts at 13% acceptance × 130 visited nodes. */
-#define DEFERRED_EDGE_LIST_DEFAULT_CAPACITY 16384
-
 /*
-** Initialize a deferred edge list with given capacity.
-** Returns DISKANN_OK on success, DISKANN_ERROR_NOMEM on allocation failure.
+** Initialize an empty deferred edge list that asks for a repair once
+** deferred_edge_list_bytes() reaches budget.
+** Returns DISKANN_OK, or DISKANN_ERROR_INVALID for a zero budget or size.
 */
-int deferred_edge_list_init(DeferredEdgeList *list, int capacity,
+int deferred_edge_list_init(DeferredEdgeList *list, uint64_t budget,
                             uint32_t vector_size);
 
 /*
-** Add a deferred edge. Copies vector (vector_size bytes).
-** Returns DISKANN_OK on success.
-** Returns DISKANN_ERROR if list is at capacity (caller should spillover).
-** Returns DISKANN_ERROR_NOMEM if vector copy allocation fails.
+** Add a deferred edge. The vector (vector_size bytes) is copied into the
+** arena unless it repeats the previous edge's inserted node.
+** Returns DISKANN_OK, or DISKANN_ERROR_NOMEM if the list cannot grow
+** (caller should apply the edge immediately).
 */
 int deferred_edge_list_add(DeferredEdgeList *list, int64_t target_rowid,
                            int64_t inserted_rowid, float distance,
                            const float *vector);
 
+/* Vector of e's inserted node */
+static inline const float *deferred_edge_vector(const DeferredEdgeList *list,
+                                                const DeferredEdge *e) {
+  return (const float *)(list->vectors +
+                         (size_t)e->vector_slot * list->vector_size);
+}
+
+/* Bytes of edges and vectors in use, compared against list->budget */
+uint64_t deferred_edge_list_bytes(const DeferredEdgeList *list);
+
 /*
-** Truncate list to saved_count, freeing vectors of discarded entries.
-** Used for rollback safety: save count before insert, truncate on failure.
+** Truncate list to saved_count, dropping the vectors only those entries
+** used. Used for rollback safety: save count before insert, truncate on
+** failure.
 */
 void deferred_edge_list_truncate(DeferredEdgeList *list, int saved_count);
 
 /*
-** Free all entries (including vector copies) and the list array.
+** Free the edge array and vector arena.
 ** Safe to call on a zeroed list. Does NOT free the list struct itself.
 */
 void deferred_edge_list_deinit(DeferredEdgeList *list);
 
+/* Default deferred edge budget of diskann_begin_batch() */
+#define DEFERRED_EDGE_LIST_DEFAULT_BUDGET (64ULL * 1024 * 1024)
+
+/*
+** Deletes queued by DISKANN_BATCH_DEFERRED_DELETES, in arrival order (so a
+** savepoint rollback can truncate them) plus a set for lookups.
+*/
+typedef struct DeferredDeleteList {
+  int64_t *ids;
+  int count;
+  int capacity;
+  DiskAnnBitmap *set; /* Same ids, rebuilt on truncate */
+} DeferredDeleteList;
+
 /*
-** Apply all deferred edges in a single repair pass.
+** Apply all deferred edges in a single repair pass and empty the list.
 ** Sorts by target_rowid, groups, loads each target once via batch_cache,
 ** re-checks acceptance with replace_edge_idx(), applies + prunes, flushes once.
 ** Must be called while idx->batch_cache is still alive.
@@ -136,6 +374,121 @@ void deferred_edge_list_deinit(DeferredEdgeList *list);
 */
 int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list);
 
+/* Free an index's pairwise distance memo (NULL safe) */
+void diskann_dist_memo_free(DiskAnnDistMemo *memo);
+
+/*
+** Rewire the graph around the rowids in dead (see diskann_consolidate()):
+** every live node with an edge into dead drops it and is offered the dead
+** nodes' live neighbors instead, in one pass in rowid order. affected
+** lists the nodes to repair, or NULL to find them with a scan of every
+** node header. The dead rows themselves are left for the caller to delete.
+** Returns DISKANN_OK or an error code.
+*/
+int diskann_consolidate_edges(DiskAnnIndex *idx, const DiskAnnBitmap *dead,
+                              const DiskAnnBitmap *affected);
+
+/*
+** Is id a live node of idx? 1 if its block exists without a tombstone and
+** is not queued for deletion, 0 if not, or a negative error code.
+*/
+int diskann_node_exists(DiskAnnIndex *idx, int64_t id);
+
+/*
+** Should searches return the node in spot? 0 when it is tombstoned or
+** queued for deletion (it is still routed through).
+*/
+int diskann_node_is_live(const DiskAnnIndex *idx, const BlobSpot *spot);
+
+/*
+** Apply the deletes queued by DISKANN_BATCH_DEFERRED_DELETES now (see
+** diskann_delete_batch()). No-op without a queue.
+*/
+int diskann_flush_deletes(DiskAnnIndex *idx);
+
+/* Queued delete count, and dropping the deletes queued after it (savepoint
+** rollback). Both are no-ops without a queue; truncating returns
+** DISKANN_OK or DISKANN_ERROR_NOMEM. */
+int diskann_deferred_delete_count(const DiskAnnIndex *idx);
+int diskann_deferred_delete_truncate(DiskAnnIndex *idx, int count);
+
+/*
+** SAVEPOINT diskann_<name>_<index> around a multi-row change. The vtab's
+** own transaction stands in when the savepoint cannot be opened
+** (SQLITE_BUSY inside xUpdate), so begin returns whether one is active.
+** diskann_end_savepoint() rolls back when rc is an error and returns rc,
+** or the RELEASE error. Releasing the outermost savepoint commits, so
+** batch cache handles are closed first.
+*/
+int diskann_begin_savepoint(DiskAnnIndex *idx, DiskAnnSavepoint sp);
+int diskann_end_savepoint(DiskAnnIndex *idx, DiskAnnSavepoint sp, int active,
+                          int rc);
+
+/* A failed multi-row change was rolled back: drop cached blocks and
+** reload labels, which may be stale */
+void diskann_discard_cached_state(DiskAnnIndex *idx);
+
+/*
+** Remove a tombstoned node right away (diskann_insert() reusing its id).
+** Returns DISKANN_OK once removed, DISKANN_ERROR_EXISTS if id is a live
+** node, DISKANN_ERROR_NOTFOUND if it has no block, or an error code.
+*/
+int diskann_purge_tombstone(DiskAnnIndex *idx, int64_t id);
+
+/*
+** Delete every tombstoned row without rewiring edges, for diskann_build()
+** which replaces the whole graph. Must run inside the caller's savepoint.
+*/
+int diskann_drop_tombstones(DiskAnnIndex *idx);
+
+/*
+** Minimum degree kept by edge pruning to maintain graph connectivity.
+** Research shows >= 8 prevents disconnected components at scale.
+*/
+#define DISKANN_MIN_DEGREE 8
+
+/* Entry point refresh schedule: first refresh after this many inserts */
+#define DISKANN_ENTRY_REFRESH_MIN_INSERTS 64
+
+/*
+** Persist rowid as the index entry point ("entry_rowid" metadata) and
+** cache it on idx. Resets idx->entry_inserts.
+** Returns DISKANN_OK or an error code.
+*/
+int diskann_set_entry_point(DiskAnnIndex *idx, int64_t rowid);
+
+/*
+** Forget the entry point (metadata row and cached value), e.g. when the
+** index becomes empty. Returns DISKANN_OK or an error code.
+*/
+int diskann_clear_entry_point(DiskAnnIndex *idx);
+
+/*
+** Re-read the stored entry point into idx, after another connection
+** rebuilt the graph (see diskann_shards_build()). Returns DISKANN_OK or an
+** error code.
+*/
+int diskann_reload_entry_point(DiskAnnIndex *idx);
+
+/*
+** Make idx hold the stored INT8 edge range of an index created without
+** one (quant_auto). Before edges are written, pass the vectors being
+** inserted: when no range is stored yet it is derived from them and
+** stored in the caller's savepoint. Searches pass none and only pick up a
+** range another handle stored. A no-op for configured ranges.
+** Returns DISKANN_OK or an error code.
+*/
+int diskann_prepare_quant_range(DiskAnnIndex *idx, const float *vectors,
+                                uint64_t n);
+
+/*
+** Replace the stored recall curve ("recall_*" metadata) with curve, in
+** one savepoint, and cache it on idx. Returns DISKANN_OK or an error code
+** (idx and the metadata are then unchanged).
+*/
+int diskann_store_recall_curve(DiskAnnIndex *idx,
+                               const DiskAnnRecallCurve *curve);
+
 /*
 ** Metadata table name format: {index_name}_metadata
 ** Schema:
@@ -149,6 +502,15 @@ int diskann_batch_repair_edges(DiskAnnIndex *idx, DeferredEdgeList *list);
 **   "search_list_size"   - search beam width
 **   "insert_list_size"   - insert beam width
 **   "block_size"         - node block size in bytes
+**   "entry_rowid"        - beam-search entry point (optional)
+**   "delete_mode"        - DISKANN_DELETE_* (optional, default immediate)
+**   "consolidate_threshold" - tombstones that trigger consolidation
+**   "tombstones"         - tombstoned rows awaiting consolidation
+**   "recall_points"      - recall curve points (optional, with
+**   "recall_l_<i>"         their search list sizes,
+**   "recall_x1e6_<i>"      recall@k * 1e6,
+**   "recall_k", "recall_target_x1e6" and "recall_rows";
+**                          see DiskAnnRecallCurve)
 */
 
 #ifdef __cplusplus
@@ -0,0 +1,338 @@
+/*
+** DiskANN label-aware graph (Filtered-Vamana)
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "diskann_label.h"
+#include "diskann.h"
+#include "diskann_sqlite.h"
+#include <string.h>
+
+#define LABEL_MAP_MIN_SLOTS 64
+
+/**************************************************************************
+** Hash map
+**************************************************************************/
+
+static uint32_t map_home(const DiskAnnLabelMap *map, uint64_t key) {
+  return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (map->n_slots - 1);
+}
+
+static void map_deinit(DiskAnnLabelMap *map) {
+  sqlite3_free(map->keys);
+  sqlite3_free(map->values);
+  sqlite3_free(map->used);
+  memset(map, 0, sizeof(*map));
+}
+
+/* Slot holding key, or -1 */
+static int64_t map_find(const DiskAnnLabelMap *map, uint64_t key) {
+  if (map->n_slots == 0) {
+    return -1;
+  }
+  uint32_t mask = map->n_slots - 1;
+  for (uint32_t i = map_home(map, key);; i = (i + 1) & mask) {
+    if (!map->used[i]) {
+      return -1;
+    }
+    if (map->keys[i] == key) {
+      return (int64_t)i;
+    }
+  }
+}
+
+/* Insert a key known to be absent; the map has a free slot */
+static void map_insert_new(DiskAnnLabelMap *map, uint64_t key,
+                           uint64_t value) {
+  uint32_t mask = map->n_slots - 1;
+  uint32_t i = map_home(map, key);
+  while (map->used[i]) {
+    i = (i + 1) & mask;
+  }
+  map->keys[i] = key;
+  map->values[i] = value;
+  map->used[i] = 1;
+  map->count++;
+}
+
+static int map_resize(DiskAnnLabelMap *map, uint32_t n_slots) {
+  DiskAnnLabelMap grown = {0};
+  grown.keys = (uint64_t *)sqlite3_malloc64(n_slots * sizeof(uint64_t));
+  grown.values = (uint64_t *)sqlite3_malloc64(n_slots * sizeof(uint64_t));
+  grown.used = (uint8_t *)sqlite3_malloc64(n_slots);
+  if (!grown.keys || !grown.values || !grown.used) {
+    map_deinit(&grown);
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(grown.used, 0, n_slots);
+  grown.n_slots = n_slots;
+
+  for (uint32_t i = 0; i < map->n_slots; i++) {
+    if (map->used[i]) {
+      map_insert_new(&grown, map->keys[i], map->values[i]);
+    }
+  }
+  map_deinit(map);
+  *map = grown;
+  return DISKANN_OK;
+}
+
+static int map_put(DiskAnnLabelMap *map, uint64_t key, uint64_t value) {
+  int64_t slot = map_find(map, key);
+  if (slot >= 0) {
+    map->values[slot] = value;
+    return DISKANN_OK;
+  }
+  if ((map->count + 1) * 2 > map->n_slots) {
+    uint32_t n_slots = map->n_slots ? map->n_slots * 2 : LABEL_MAP_MIN_SLOTS;
+    if (n_slots < map->n_slots) {
+      return DISKANN_ERROR_NOMEM; /* 2^32 slots */
+    }
+    int rc = map_resize(map, n_slots);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  map_insert_new(map, key, value);
+  return DISKANN_OK;
+}
+
+/* Empty a slot, shifting later members of its probe run back into it */
+static void map_delete_slot(DiskAnnLabelMap *map, uint32_t hole) {
+  uint32_t mask = map->n_slots - 1;
+  uint32_t i = (hole + 1) & mask;
+
+  map->used[hole] = 0;
+  map->count--;
+  while (map->used[i]) {
+    uint32_t home = map_home(map, map->keys[i]);
+    /* i may fill the hole unless its home lies cyclically in (hole, i] */
+    int stays = hole <= i ? (hole < home && home <= i)
+                          : (hole < home || home <= i);
+    if (!stays) {
+      map->keys[hole] = map->keys[i];
+      map->values[hole] = map->values[i];
+      map->used[hole] = 1;
+      map->used[i] = 0;
+      hole = i;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+/**************************************************************************
+** Label values
+**************************************************************************/
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t n) {
+  const uint8_t *p = (const uint8_t *)data;
+  for (size_t i = 0; i < n; i++) {
+    hash = (hash ^ p[i]) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t diskann_label_hash(sqlite3_value *value, int affinity) {
+  int type = sqlite3_value_type(value);
+  uint32_t hash = 2166136261u;
+  uint8_t tag;
+
+  if (type == SQLITE_NULL) {
+    return DISKANN_LABEL_NONE;
+  }
+  if (affinity == DISKANN_LABEL_AFFINITY_NUMERIC && type == SQLITE_TEXT) {
+    type = sqlite3_value_numeric_type(value);
+  } else if (affinity == DISKANN_LABEL_AFFINITY_TEXT &&
+             (type == SQLITE_INTEGER || type == SQLITE_FLOAT)) {
+    type = SQLITE_TEXT;
+  }
+
+  if (type == SQLITE_FLOAT) {
+    /* Integral reals compare equal to integers: hash them as one */
+    double d = sqlite3_value_double(value);
+    if (d >= -9.2e18 && d <= 9.2e18 && d == (double)(int64_t)d) {
+      type = SQLITE_INTEGER;
+    } else {
+      tag = 'r';
+      hash = fnv1a(fnv1a(hash, &tag, 1), &d, sizeof(d));
+    }
+  }
+  if (type == SQLITE_INTEGER) {
+    int64_t v = sqlite3_value_type(value) == SQLITE_FLOAT
+                    ? (int64_t)sqlite3_value_double(value)
+                    : sqlite3_value_int64(value);
+    tag = 'i';
+    hash = fnv1a(fnv1a(hash, &tag, 1), &v, sizeof(v));
+  } else if (type == SQLITE_TEXT) {
+    const unsigned char *text = sqlite3_value_text(value);
+    tag = 't';
+    hash = fnv1a(fnv1a(hash, &tag, 1), text,
+                 text ? (size_t)sqlite3_value_bytes(value) : 0);
+  } else if (type == SQLITE_BLOB) {
+    const void *blob = sqlite3_value_blob(value);
+    tag = 'b';
+    hash = fnv1a(fnv1a(hash, &tag, 1), blob,
+                 blob ? (size_t)sqlite3_value_bytes(value) : 0);
+  }
+  return hash == DISKANN_LABEL_NONE ? 1 : hash;
+}
+
+/**************************************************************************
+** Label map
+**************************************************************************/
+
+int diskann_labels_put(DiskAnnLabels *labels, int64_t rowid, uint32_t label) {
+  if (label == DISKANN_LABEL_NONE) {
+    diskann_labels_remove(labels, rowid);
+    return DISKANN_OK;
+  }
+  if (diskann_labels_get(labels, rowid) != label) {
+    /* Relabeling: hand the old label's entry point on first */
+    diskann_labels_remove(labels, rowid);
+  }
+  int has_entry = map_find(&labels->entry, label) >= 0;
+  if (!has_entry) {
+    int rc = map_put(&labels->entry, label, (uint64_t)rowid);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  int rc = map_put(&labels->rows, (uint64_t)rowid, label);
+  if (rc != DISKANN_OK && !has_entry) {
+    map_delete_slot(&labels->entry, (uint32_t)map_find(&labels->entry, label));
+  }
+  return rc;
+}
+
+uint32_t diskann_labels_get(const DiskAnnLabels *labels, int64_t rowid) {
+  if (!labels) {
+    return DISKANN_LABEL_NONE;
+  }
+  int64_t slot = map_find(&labels->rows, (uint64_t)rowid);
+  return slot < 0 ? DISKANN_LABEL_NONE : (uint32_t)labels->rows.values[slot];
+}
+
+void diskann_labels_remove(DiskAnnLabels *labels, int64_t rowid) {
+  if (!labels) {
+    return;
+  }
+  int64_t slot = map_find(&labels->rows, (uint64_t)rowid);
+  if (slot < 0) {
+    return;
+  }
+  uint32_t label = (uint32_t)labels->rows.values[slot];
+  map_delete_slot(&labels->rows, (uint32_t)slot);
+
+  int64_t entry = map_find(&labels->entry, label);
+  if (entry < 0 || labels->entry.values[entry] != (uint64_t)rowid) {
+    return;
+  }
+  /* The entry point left: any other row with the label takes over. A scan
+  ** of the map, but only for deletes of entry points. */
+  for (uint32_t i = 0; i < labels->rows.n_slots; i++) {
+    if (labels->rows.used[i] && labels->rows.values[i] == label) {
+      labels->entry.values[entry] = labels->rows.keys[i];
+      return;
+    }
+  }
+  map_delete_slot(&labels->entry, (uint32_t)entry);
+}
+
+int diskann_labels_entry(const DiskAnnLabels *labels, uint32_t label,
+                         int64_t *rowid) {
+  if (!labels || label == DISKANN_LABEL_NONE) {
+    return 0;
+  }
+  int64_t slot = map_find(&labels->entry, label);
+  if (slot < 0) {
+    return 0;
+  }
+  *rowid = (int64_t)labels->entry.values[slot];
+  return 1;
+}
+
+void diskann_labels_free(DiskAnnLabels *labels) {
+  if (!labels) {
+    return;
+  }
+  map_deinit(&labels->rows);
+  map_deinit(&labels->entry);
+  sqlite3_free(labels->column);
+  sqlite3_free(labels);
+}
+
+/**************************************************************************
+** Loading
+**************************************************************************/
+
+/* Fill an empty map from the _attrs table */
+static int labels_load(DiskAnnIndex *idx, DiskAnnLabels *labels) {
+  sqlite3_stmt *stmt = NULL;
+  int rc;
+
+  char *sql = sqlite3_mprintf("SELECT rowid, \"%w\" FROM \"%w\".\"%w_attrs\"",
+                              labels->column, idx->db_name, idx->index_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    uint32_t label =
+        diskann_label_hash(sqlite3_column_value(stmt, 1), labels->affinity);
+    rc = diskann_labels_put(labels, sqlite3_column_int64(stmt, 0), label);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  }
+  rc = rc == SQLITE_DONE ? DISKANN_OK : DISKANN_ERROR;
+
+out:
+  sqlite3_finalize(stmt);
+  return rc;
+}
+
+int diskann_labels_enable(DiskAnnIndex *idx, const char *column,
+                          int affinity) {
+  DiskAnnLabels *labels =
+      (DiskAnnLabels *)sqlite3_malloc64(sizeof(DiskAnnLabels));
+  if (!labels) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(labels, 0, sizeof(*labels));
+  labels->affinity = affinity;
+  labels->column = sqlite3_mprintf("%s", column);
+  if (!labels->column) {
+    diskann_labels_free(labels);
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  int rc = labels_load(idx, labels);
+  if (rc != DISKANN_OK) {
+    diskann_labels_free(labels);
+    return rc;
+  }
+  diskann_labels_free(idx->labels);
+  idx->labels = labels;
+  return DISKANN_OK;
+}
+
+int diskann_labels_reload(DiskAnnIndex *idx) {
+  DiskAnnLabels *labels = idx->labels;
+  if (!labels) {
+    return DISKANN_OK;
+  }
+  map_deinit(&labels->rows);
+  map_deinit(&labels->entry);
+  int rc = labels_load(idx, labels);
+  if (rc != DISKANN_OK) {
+    map_deinit(&labels->rows);
+    map_deinit(&labels->entry);
+  }
+  return rc;
+}
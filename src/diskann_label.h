@@ -0,0 +1,125 @@
+/*
+** DiskANN label-aware graph (Filtered-Vamana)
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** A virtual table may declare one metadata column as LABEL:
+**
+**   CREATE VIRTUAL TABLE t USING diskann(dimension=64, category TEXT LABEL)
+**
+** Every row's value in that column becomes a 32-bit label, and the graph
+** is built so that a filter "category = ?" can stay inside the subgraph of
+** matching rows instead of wading through rejected nodes:
+** - Edge pruning never lets a node drop a same-label neighbor in favor of
+**   a neighbor with a different label (the FilteredRobustPrune rule)
+** - Each label keeps an entry point, and inserts also link the new node
+**   to the nodes found by a walk restricted to its label
+** - Searches with an equality filter on the label start at that label's
+**   entry point and only expand nodes carrying the label
+**
+** Labels are hashes of the column value, so two values can share one.
+** That only shapes the graph: results are still gated by the exact
+** filter. Rows whose value is NULL carry DISKANN_LABEL_NONE.
+**
+** The map lives in RAM only and is rebuilt from the _attrs table when the
+** index is opened (and after a rollback). Rows written by other
+** connections meanwhile stay unlabeled here, which costs graph quality,
+** never correctness.
+*/
+#ifndef DISKANN_LABEL_H
+#define DISKANN_LABEL_H
+
+#include "diskann_internal.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISKANN_LABEL_NONE 0
+
+/* How SQLite compares the LABEL column (its declared type's affinity) */
+#define DISKANN_LABEL_AFFINITY_NONE 0    /* BLOB: values compare as stored */
+#define DISKANN_LABEL_AFFINITY_TEXT 1    /* TEXT: numbers compare as text */
+#define DISKANN_LABEL_AFFINITY_NUMERIC 2 /* INTEGER / REAL */
+
+/*
+** Open-addressing hash map with uint64 keys and values (linear probing,
+** kept at most half full, backward-shift deletion).
+**
+** Memory ownership: keys, values and used are owned arrays.
+*/
+typedef struct DiskAnnLabelMap {
+  uint64_t *keys;
+  uint64_t *values;
+  uint8_t *used;    /* 1 = slot occupied */
+  uint32_t n_slots; /* power of 2, 0 until the first put */
+  uint32_t count;
+} DiskAnnLabelMap;
+
+/*
+** Memory ownership: column (sqlite3_mprintf'd) and both maps are owned
+** and released by diskann_labels_free().
+*/
+typedef struct DiskAnnLabels {
+  char *column;          /* LABEL column of the _attrs table */
+  int affinity;          /* DISKANN_LABEL_AFFINITY_* */
+  DiskAnnLabelMap rows;  /* rowid -> label */
+  DiskAnnLabelMap entry; /* label -> entry point rowid */
+} DiskAnnLabels;
+
+/*
+** Label of a column value, DISKANN_LABEL_NONE for NULL. Values that
+** compare equal under the column's affinity get the same label (e.g. 3
+** and 3.0 in a numeric column, 5 and '5' in a TEXT column). May apply
+** numeric affinity to value in place (sqlite3_value_numeric_type()).
+*/
+uint32_t diskann_label_hash(sqlite3_value *value, int affinity);
+
+/*
+** Enable label-aware mode on idx: load every row's label from the _attrs
+** column into idx->labels (replacing any previous map).
+** Returns DISKANN_OK, DISKANN_ERROR_NOMEM or DISKANN_ERROR.
+*/
+int diskann_labels_enable(DiskAnnIndex *idx, const char *column,
+                          int affinity);
+
+/*
+** Rebuild idx->labels from the _attrs table, e.g. after a rollback undid
+** inserts and deletes the map already reflects. No-op when disabled.
+** Returns DISKANN_OK or an error code (the map is then left empty).
+*/
+int diskann_labels_reload(DiskAnnIndex *idx);
+
+/* Free a label map (NULL-safe) */
+void diskann_labels_free(DiskAnnLabels *labels);
+
+/*
+** Set rowid's label (DISKANN_LABEL_NONE removes it). The first row of a
+** label becomes its entry point. Returns DISKANN_OK or DISKANN_ERROR_NOMEM
+** (rowid is then left unlabeled).
+*/
+int diskann_labels_put(DiskAnnLabels *labels, int64_t rowid, uint32_t label);
+
+/* rowid's label, DISKANN_LABEL_NONE if unknown (labels may be NULL) */
+uint32_t diskann_labels_get(const DiskAnnLabels *labels, int64_t rowid);
+
+/*
+** Forget rowid (no-op if unknown or labels is NULL). When it was its
+** label's entry point, another row with the label takes over.
+*/
+void diskann_labels_remove(DiskAnnLabels *labels, int64_t rowid);
+
+/*
+** Store the entry point of label in *rowid and return 1, or return 0 if
+** no row carries it (labels may be NULL).
+*/
+int diskann_labels_entry(const DiskAnnLabels *labels, uint32_t label,
+                         int64_t *rowid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_LABEL_H */
@@ -16,6 +16,30 @@
 ** Layout calculation
 **************************************************************************/
 
+uint32_t diskann_vector_element_size(uint8_t vector_type) {
+  switch (vector_type) {
+  case DISKANN_VECTOR_FLOAT32:
+    return (uint32_t)sizeof(float);
+  case DISKANN_VECTOR_FLOAT16:
+  case DISKANN_VECTOR_BFLOAT16:
+    return (uint32_t)sizeof(uint16_t);
+  default:
+    return 0;
+  }
+}
+
+uint32_t diskann_edge_vector_size(uint8_t edge_type, uint8_t vector_type,
+                                  uint32_t dims) {
+  switch (edge_type) {
+  case DISKANN_EDGE_FLOAT32:
+    return dims * diskann_vector_element_size(vector_type);
+  case DISKANN_EDGE_INT8:
+    return diskann_vector_element_size(vector_type) ? dims : 0;
+  default:
+    return 0;
+  }
+}
+
 uint32_t node_edges_max_count(const DiskAnnIndex *idx) {
   uint32_t node_overhead = NODE_METADATA_SIZE + idx->nNodeVectorSize;
   uint32_t edge_overhead = idx->nEdgeVectorSize + EDGE_METADATA_SIZE;
@@ -40,16 +64,52 @@ void node_bin_init(const DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
   assert(NODE_METADATA_SIZE + idx->nNodeVectorSize <= spot->buffer_size);
 
   memset(spot->buffer, 0, spot->buffer_size);
+  blob_spot_mark_dirty(spot, 0, spot->buffer_size);
   write_le64(spot->buffer, rowid);
   /* Edge count is zero after memset — no need to write explicitly */
 
-  memcpy(spot->buffer + NODE_METADATA_SIZE, vector, idx->nNodeVectorSize);
+  diskann_vector_encode(idx, vector, spot->buffer + NODE_METADATA_SIZE);
+
+  if (idx->metric == DISKANN_METRIC_COSINE) {
+    float inv_norm = diskann_index_inv_norm(idx, vector);
+    uint32_t raw;
+    memcpy(&raw, &inv_norm, sizeof(float));
+    write_le32(spot->buffer + NODE_INV_NORM_OFFSET, raw);
+  }
 }
 
 const float *node_bin_vector(const DiskAnnIndex *idx, const BlobSpot *spot) {
+  assert(idx->vector_type == DISKANN_VECTOR_FLOAT32);
+
+  return (const float *)node_bin_vector_data(idx, spot);
+}
+
+const uint8_t *node_bin_vector_data(const DiskAnnIndex *idx,
+                                    const BlobSpot *spot) {
   assert(NODE_METADATA_SIZE + idx->nNodeVectorSize <= spot->buffer_size);
+  (void)idx;
+
+  return spot->buffer + NODE_METADATA_SIZE;
+}
 
-  return (const float *)(spot->buffer + NODE_METADATA_SIZE);
+const float *node_bin_vector_float(const DiskAnnIndex *idx,
+                                   const BlobSpot *spot, float *scratch) {
+  const uint8_t *data = node_bin_vector_data(idx, spot);
+  if (idx->vector_type == DISKANN_VECTOR_FLOAT32) {
+    return (const float *)data;
+  }
+  diskann_vector_decode(idx, data, scratch);
+  return scratch;
+}
+
+float node_bin_inv_norm(const DiskAnnIndex *idx, const BlobSpot *spot) {
+  assert(NODE_METADATA_SIZE <= spot->buffer_size);
+  (void)idx;
+
+  uint32_t raw = read_le32(spot->buffer + NODE_INV_NORM_OFFSET);
+  float inv_norm;
+  memcpy(&inv_norm, &raw, sizeof(float));
+  return inv_norm;
 }
 
 uint16_t node_bin_edges(const DiskAnnIndex *idx, const BlobSpot *spot) {
@@ -59,6 +119,22 @@ uint16_t node_bin_edges(const DiskAnnIndex *idx, const BlobSpot *spot) {
   return read_le16(spot->buffer + sizeof(uint64_t));
 }
 
+uint16_t node_bin_flags(const DiskAnnIndex *idx, const BlobSpot *spot) {
+  assert(NODE_METADATA_SIZE <= spot->buffer_size);
+  (void)idx;
+
+  return read_le16(spot->buffer + NODE_FLAGS_OFFSET);
+}
+
+void node_bin_set_flags(const DiskAnnIndex *idx, BlobSpot *spot,
+                        uint16_t flags) {
+  assert(NODE_METADATA_SIZE <= spot->buffer_size);
+  (void)idx;
+
+  write_le16(spot->buffer + NODE_FLAGS_OFFSET, flags);
+  blob_spot_mark_dirty(spot, NODE_FLAGS_OFFSET, sizeof(uint16_t));
+}
+
 void node_bin_edge(const DiskAnnIndex *idx, const BlobSpot *spot, int edge_idx,
                    uint64_t *rowid, float *distance, const float **vector) {
   uint32_t meta_offset = node_edges_metadata_offset(idx);
@@ -77,13 +153,33 @@ void node_bin_edge(const DiskAnnIndex *idx, const BlobSpot *spot, int edge_idx,
     memcpy(distance, &raw, sizeof(float));
   }
   if (vector != NULL) {
-    uint32_t vec_offset = NODE_METADATA_SIZE + idx->nNodeVectorSize +
-                          (uint32_t)edge_idx * (uint32_t)idx->nEdgeVectorSize;
-    assert(vec_offset + idx->nEdgeVectorSize <= meta_offset);
-    *vector = (const float *)(spot->buffer + vec_offset);
+    assert(idx->edge_type == DISKANN_EDGE_FLOAT32 &&
+           idx->vector_type == DISKANN_VECTOR_FLOAT32);
+    *vector = (const float *)node_bin_edge_data(idx, spot, edge_idx);
   }
 }
 
+const uint8_t *node_bin_edge_data(const DiskAnnIndex *idx,
+                                  const BlobSpot *spot, int edge_idx) {
+  uint32_t vec_offset = NODE_METADATA_SIZE + idx->nNodeVectorSize +
+                        (uint32_t)edge_idx * (uint32_t)idx->nEdgeVectorSize;
+  assert(vec_offset + idx->nEdgeVectorSize <= node_edges_metadata_offset(idx));
+  return spot->buffer + vec_offset;
+}
+
+float node_bin_edge_inv_norm(const DiskAnnIndex *idx, const BlobSpot *spot,
+                             int edge_idx) {
+  uint32_t meta_offset = node_edges_metadata_offset(idx);
+  assert(meta_offset + (uint32_t)(edge_idx + 1) * EDGE_METADATA_SIZE <=
+         spot->buffer_size);
+
+  uint32_t raw = read_le32(spot->buffer + meta_offset +
+                           (size_t)edge_idx * EDGE_METADATA_SIZE);
+  float inv_norm;
+  memcpy(&inv_norm, &raw, sizeof(float));
+  return inv_norm;
+}
+
 int node_bin_edge_find_idx(const DiskAnnIndex *idx, const BlobSpot *spot,
                            uint64_t rowid) {
   int n_edges = node_bin_edges(idx, spot);
@@ -97,6 +193,16 @@ int node_bin_edge_find_idx(const DiskAnnIndex *idx, const BlobSpot *spot,
   return -1;
 }
 
+/* 1/|v| of the vector INT8 codes decode to, or 0 for a zero vector */
+static float int8_inv_norm(const DiskAnnIndex *idx, const uint8_t *codes) {
+  float sq = 0.0f;
+  for (uint32_t i = 0; i < idx->dimensions; i++) {
+    float v = idx->quant_min + (float)codes[i] * idx->quant_scale;
+    sq += v * v;
+  }
+  return sq > 0.0f ? 1.0f / sqrtf(sq) : 0.0f;
+}
+
 void node_bin_replace_edge(const DiskAnnIndex *idx, BlobSpot *spot,
                            int replace_idx, uint64_t rowid, float distance,
                            const float *vector) {
@@ -120,9 +226,21 @@ void node_bin_replace_edge(const DiskAnnIndex *idx, BlobSpot *spot,
   assert(edge_meta_offset + EDGE_METADATA_SIZE <= spot->buffer_size);
 
   /* Write edge vector */
-  memcpy(spot->buffer + edge_vec_offset, vector, idx->nEdgeVectorSize);
+  diskann_edge_encode(idx, vector, spot->buffer + edge_vec_offset);
+
+  /* Write edge metadata: [inv_norm(4)] [distance(4)] [rowid(8)]. The norm
+  ** is of the vector edge distances see: INT8 slots score the dequantized
+  ** codes, not vector. */
+  float inv_norm = 0.0f;
+  if (idx->metric == DISKANN_METRIC_COSINE) {
+    inv_norm = idx->edge_type == DISKANN_EDGE_INT8
+                   ? int8_inv_norm(idx, spot->buffer + edge_vec_offset)
+                   : diskann_index_inv_norm(idx, vector);
+  }
+  uint32_t norm_raw;
+  memcpy(&norm_raw, &inv_norm, sizeof(float));
+  write_le32(spot->buffer + edge_meta_offset, norm_raw);
 
-  /* Write edge metadata: [padding(4)] [distance(4)] [rowid(8)] */
   uint32_t dist_raw;
   memcpy(&dist_raw, &distance, sizeof(float));
   write_le32(spot->buffer + edge_meta_offset + sizeof(uint32_t), dist_raw);
@@ -130,6 +248,10 @@ void node_bin_replace_edge(const DiskAnnIndex *idx, BlobSpot *spot,
 
   /* Update edge count */
   write_le16(spot->buffer + sizeof(uint64_t), n_edges);
+
+  blob_spot_mark_dirty(spot, edge_vec_offset, idx->nEdgeVectorSize);
+  blob_spot_mark_dirty(spot, edge_meta_offset, EDGE_METADATA_SIZE);
+  blob_spot_mark_dirty(spot, sizeof(uint64_t), sizeof(uint16_t));
 }
 
 void node_bin_delete_edge(const DiskAnnIndex *idx, BlobSpot *spot,
@@ -153,10 +275,13 @@ void node_bin_delete_edge(const DiskAnnIndex *idx, BlobSpot *spot,
             idx->nEdgeVectorSize);
     memmove(spot->buffer + del_meta, spot->buffer + last_meta,
             EDGE_METADATA_SIZE);
+    blob_spot_mark_dirty(spot, del_vec, idx->nEdgeVectorSize);
+    blob_spot_mark_dirty(spot, del_meta, EDGE_METADATA_SIZE);
   }
 
-  /* Decrement edge count */
+  /* Decrement edge count (the last slot is unused from now on) */
   write_le16(spot->buffer + sizeof(uint64_t), (uint16_t)(n_edges - 1));
+  blob_spot_mark_dirty(spot, sizeof(uint64_t), sizeof(uint16_t));
 }
 
 void node_bin_prune_edges(const DiskAnnIndex *idx, BlobSpot *spot,
@@ -165,6 +290,39 @@ void node_bin_prune_edges(const DiskAnnIndex *idx, BlobSpot *spot,
   (void)idx;
 
   write_le16(spot->buffer + sizeof(uint64_t), (uint16_t)n_pruned);
+  blob_spot_mark_dirty(spot, sizeof(uint64_t), sizeof(uint16_t));
+}
+
+int node_bin_load_adjacency(DiskAnnIndex *idx, BlobSpot *spot,
+                            uint64_t rowid) {
+  int rc = blob_spot_seek(idx, spot, rowid);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  rc = blob_spot_read_range(idx, spot, 0, NODE_METADATA_SIZE);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+
+  uint32_t n_edges = node_bin_edges(idx, spot);
+  uint32_t max_edges = node_edges_max_count(idx);
+  if (n_edges > max_edges) {
+    n_edges = max_edges; /* corrupt count: stay inside the block */
+  }
+  return blob_spot_read_range(idx, spot, node_edges_metadata_offset(idx),
+                              n_edges * EDGE_METADATA_SIZE);
+}
+
+int node_bin_load_vector(DiskAnnIndex *idx, BlobSpot *spot) {
+  return blob_spot_read_range(idx, spot, NODE_METADATA_SIZE,
+                              idx->nNodeVectorSize);
+}
+
+int node_bin_load_edge_vector(DiskAnnIndex *idx, BlobSpot *spot,
+                              int edge_idx) {
+  uint32_t offset = NODE_METADATA_SIZE + idx->nNodeVectorSize +
+                    (uint32_t)edge_idx * idx->nEdgeVectorSize;
+  return blob_spot_read_range(idx, spot, offset, idx->nEdgeVectorSize);
 }
 
 /**************************************************************************
@@ -180,6 +338,24 @@ float diskann_distance_l2(const float *a, const float *b, uint32_t dims) {
   return sum;
 }
 
+float diskann_distance_l2_bounded(const float *a, const float *b,
+                                  uint32_t dims, float bound) {
+  float sum = 0.0f;
+  uint32_t i = 0;
+  while (i < dims) {
+    uint32_t end = dims - i > DISKANN_ABANDON_BLOCK ? i + DISKANN_ABANDON_BLOCK
+                                                    : dims;
+    for (; i < end; i++) {
+      float diff = a[i] - b[i];
+      sum += diff * diff;
+    }
+    if (sum >= bound) {
+      return sum; /* the rest only adds: the full sum is >= bound too */
+    }
+  }
+  return sum;
+}
+
 float diskann_distance_cosine(const float *a, const float *b, uint32_t dims) {
   float dot = 0.0f, norm_a = 0.0f, norm_b = 0.0f;
   for (uint32_t i = 0; i < dims; i++) {
@@ -194,6 +370,18 @@ float diskann_distance_cosine(const float *a, const float *b, uint32_t dims) {
   return 1.0f - dot / denom;
 }
 
+float diskann_dot_product(const float *a, const float *b, uint32_t dims) {
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+float diskann_distance_dot(const float *a, const float *b, uint32_t dims) {
+  return -diskann_dot_product(a, b, dims);
+}
+
 float diskann_distance(const float *a, const float *b, uint32_t dims,
                        uint8_t metric) {
   switch (metric) {
@@ -201,12 +389,319 @@ float diskann_distance(const float *a, const float *b, uint32_t dims,
     return diskann_distance_l2(a, b, dims);
   case DISKANN_METRIC_COSINE:
     return diskann_distance_cosine(a, b, dims);
+  case DISKANN_METRIC_DOT:
+    return diskann_distance_dot(a, b, dims);
   default:
     assert(0 && "unsupported distance metric");
     return 0.0f;
   }
 }
 
+float diskann_index_inv_norm(const DiskAnnIndex *idx, const float *v) {
+  float sq = idx->dot ? idx->dot(v, v, idx->dimensions)
+                      : diskann_dot_product(v, v, idx->dimensions);
+  if (sq <= 0.0f) {
+    return 0.0f;
+  }
+  return 1.0f / sqrtf(sq);
+}
+
+float diskann_distance_l2_f16(const float *a, const uint16_t *b,
+                              uint32_t dims) {
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i++) {
+    float diff = a[i] - diskann_f16_to_f32(b[i]);
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+float diskann_dot_product_f16(const float *a, const uint16_t *b,
+                              uint32_t dims) {
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i++) {
+    sum += a[i] * diskann_f16_to_f32(b[i]);
+  }
+  return sum;
+}
+
+float diskann_distance_l2_bf16(const float *a, const uint16_t *b,
+                               uint32_t dims) {
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i++) {
+    float diff = a[i] - diskann_bf16_to_f32(b[i]);
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+float diskann_dot_product_bf16(const float *a, const uint16_t *b,
+                               uint32_t dims) {
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i++) {
+    sum += a[i] * diskann_bf16_to_f32(b[i]);
+  }
+  return sum;
+}
+
+/**************************************************************************
+** Edge vector encoding
+**************************************************************************/
+
+static uint8_t quantize_int8(const DiskAnnIndex *idx, float v) {
+  float q = (v - idx->quant_min) / idx->quant_scale;
+  if (!(q > 0.0f)) {
+    return 0; /* also catches NaN */
+  }
+  if (q >= 255.0f) {
+    return 255;
+  }
+  return (uint8_t)(q + 0.5f);
+}
+
+void diskann_edge_encode(const DiskAnnIndex *idx, const float *vector,
+                         uint8_t *out) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32) {
+    diskann_vector_encode(idx, vector, out);
+    return;
+  }
+  assert(idx->edge_type == DISKANN_EDGE_INT8);
+  for (uint32_t i = 0; i < idx->dimensions; i++) {
+    out[i] = quantize_int8(idx, vector[i]);
+  }
+}
+
+void diskann_edge_decode(const DiskAnnIndex *idx, const uint8_t *data,
+                         float *out) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32) {
+    diskann_vector_decode(idx, data, out);
+    return;
+  }
+  assert(idx->edge_type == DISKANN_EDGE_INT8);
+  for (uint32_t i = 0; i < idx->dimensions; i++) {
+    out[i] = idx->quant_min + (float)data[i] * idx->quant_scale;
+  }
+}
+
+/* Finish a cosine distance from partial sums, preferring stored norms */
+static float cosine_from_parts(float dot, float a_inv, float b_inv, float aa,
+                               float bb) {
+  if (a_inv == 0.0f) {
+    a_inv = aa > 0.0f ? 1.0f / sqrtf(aa) : 0.0f;
+  }
+  if (b_inv == 0.0f) {
+    b_inv = bb > 0.0f ? 1.0f / sqrtf(bb) : 0.0f;
+  }
+  if (a_inv == 0.0f || b_inv == 0.0f) {
+    return 0.0f; /* zero vector, same convention as diskann_distance_cosine */
+  }
+  return 1.0f - dot * a_inv * b_inv;
+}
+
+/*
+** Asymmetric distance: the float32 side is exact, the edge side is
+** dequantized on the fly (one multiply-add per dimension).
+*/
+float diskann_edge_distance_int8(const DiskAnnIndex *idx, const float *q,
+                                 float q_inv, const uint8_t *codes,
+                                 float codes_inv) {
+  const float lo = idx->quant_min;
+  const float step = idx->quant_scale;
+  const uint32_t dims = idx->dimensions;
+
+  if (idx->metric == DISKANN_METRIC_EUCLIDEAN) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < dims; i++) {
+      float diff = q[i] - (lo + (float)codes[i] * step);
+      sum += diff * diff;
+    }
+    return sum;
+  }
+
+  float dot = 0.0f, qq = 0.0f, vv = 0.0f;
+  int need_norms = idx->metric == DISKANN_METRIC_COSINE &&
+                   (q_inv == 0.0f || codes_inv == 0.0f);
+  for (uint32_t i = 0; i < dims; i++) {
+    float v = lo + (float)codes[i] * step;
+    dot += q[i] * v;
+    if (need_norms) {
+      qq += q[i] * q[i];
+      vv += v * v;
+    }
+  }
+  if (idx->metric == DISKANN_METRIC_DOT) {
+    return -dot;
+  }
+  return cosine_from_parts(dot, q_inv, codes_inv, qq, vv);
+}
+
+/*
+** Both sides quantized (edge-to-edge distances during pruning). For L2 the
+** offset cancels, so only code differences are accumulated.
+*/
+float diskann_edge_pair_distance_int8(const DiskAnnIndex *idx,
+                                      const uint8_t *a, float a_inv,
+                                      const uint8_t *b, float b_inv) {
+  const float lo = idx->quant_min;
+  const float step = idx->quant_scale;
+  const uint32_t dims = idx->dimensions;
+
+  if (idx->metric == DISKANN_METRIC_EUCLIDEAN) {
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < dims; i++) {
+      int32_t diff = (int32_t)a[i] - (int32_t)b[i];
+      sum += diff * diff;
+    }
+    return (float)sum * step * step;
+  }
+
+  float dot = 0.0f, aa = 0.0f, bb = 0.0f;
+  int need_norms = idx->metric == DISKANN_METRIC_COSINE &&
+                   (a_inv == 0.0f || b_inv == 0.0f);
+  for (uint32_t i = 0; i < dims; i++) {
+    float va = lo + (float)a[i] * step;
+    float vb = lo + (float)b[i] * step;
+    dot += va * vb;
+    if (need_norms) {
+      aa += va * va;
+      bb += vb * vb;
+    }
+  }
+  if (idx->metric == DISKANN_METRIC_DOT) {
+    return -dot;
+  }
+  return cosine_from_parts(dot, a_inv, b_inv, aa, bb);
+}
+
+/**************************************************************************
+** Stored vectors
+**************************************************************************/
+
+/* Half-precision elements decoded per kernel call by the pair distance */
+#define HALF_DECODE_CHUNK 64
+
+void diskann_elements_decode(uint8_t vector_type, const uint8_t *in,
+                             uint32_t n, float *out) {
+  if (vector_type == DISKANN_VECTOR_FLOAT32) {
+    memcpy(out, in, (size_t)n * sizeof(float));
+    return;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    uint16_t h;
+    memcpy(&h, in + (size_t)i * sizeof(h), sizeof(h));
+    out[i] = vector_type == DISKANN_VECTOR_FLOAT16 ? diskann_f16_to_f32(h)
+                                                   : diskann_bf16_to_f32(h);
+  }
+}
+
+void diskann_vector_encode(const DiskAnnIndex *idx, const float *vector,
+                           uint8_t *out) {
+  if (idx->vector_type == DISKANN_VECTOR_FLOAT32) {
+    memcpy(out, vector, (size_t)idx->dimensions * sizeof(float));
+    return;
+  }
+  for (uint32_t i = 0; i < idx->dimensions; i++) {
+    uint16_t h = idx->vector_type == DISKANN_VECTOR_FLOAT16
+                     ? diskann_f32_to_f16(vector[i])
+                     : diskann_f32_to_bf16(vector[i]);
+    memcpy(out + (size_t)i * sizeof(h), &h, sizeof(h));
+  }
+}
+
+void diskann_vector_decode(const DiskAnnIndex *idx, const uint8_t *data,
+                           float *out) {
+  diskann_elements_decode(idx->vector_type, data, idx->dimensions, out);
+}
+
+/* The index's mixed kernel (L2 for euclidean, a·b otherwise) */
+static DiskAnnHalfDistanceFn half_kernel(const DiskAnnIndex *idx) {
+  if (idx->half_distance) {
+    return idx->half_distance;
+  }
+  if (idx->vector_type == DISKANN_VECTOR_FLOAT16) {
+    return idx->metric == DISKANN_METRIC_EUCLIDEAN ? diskann_distance_l2_f16
+                                                   : diskann_dot_product_f16;
+  }
+  return idx->metric == DISKANN_METRIC_EUCLIDEAN ? diskann_distance_l2_bf16
+                                                 : diskann_dot_product_bf16;
+}
+
+/* Distance from a kernel sum: squared L2 as is, a·b per metric */
+static float half_kernel_distance(const DiskAnnIndex *idx, float sum,
+                                  float a_inv, float b_inv) {
+  switch (idx->metric) {
+  case DISKANN_METRIC_EUCLIDEAN:
+    return sum;
+  case DISKANN_METRIC_DOT:
+    return -sum;
+  default:
+    return 1.0f - sum * a_inv * b_inv;
+  }
+}
+
+float diskann_vector_distance_half(const DiskAnnIndex *idx, const float *q,
+                                   float q_inv, const uint8_t *v,
+                                   float v_inv) {
+  const uint16_t *h = (const uint16_t *)v;
+  const uint32_t dims = idx->dimensions;
+
+  if (idx->metric == DISKANN_METRIC_COSINE &&
+      (q_inv == 0.0f || v_inv == 0.0f)) {
+    /* Missing norm (zero vector): accumulate both norms here */
+    float dot = 0.0f, qq = 0.0f, vv = 0.0f;
+    for (uint32_t i = 0; i < dims; i++) {
+      float x = idx->vector_type == DISKANN_VECTOR_FLOAT16
+                    ? diskann_f16_to_f32(h[i])
+                    : diskann_bf16_to_f32(h[i]);
+      dot += q[i] * x;
+      qq += q[i] * q[i];
+      vv += x * x;
+    }
+    return cosine_from_parts(dot, q_inv, v_inv, qq, vv);
+  }
+  return half_kernel_distance(idx, half_kernel(idx)(q, h, dims), q_inv,
+                              v_inv);
+}
+
+/*
+** Both sides stored (edge-to-edge distances during pruning): a is decoded
+** a chunk at a time on the stack and scored against b by the mixed kernel.
+*/
+float diskann_vector_pair_distance_half(const DiskAnnIndex *idx,
+                                        const uint8_t *a, float a_inv,
+                                        const uint8_t *b, float b_inv) {
+  const uint16_t *hb = (const uint16_t *)b;
+  const uint32_t dims = idx->dimensions;
+  float chunk[HALF_DECODE_CHUNK];
+
+  if (idx->metric == DISKANN_METRIC_COSINE &&
+      (a_inv == 0.0f || b_inv == 0.0f)) {
+    float dot = 0.0f, aa = 0.0f, bb = 0.0f;
+    for (uint32_t i = 0; i < dims; i += HALF_DECODE_CHUNK) {
+      uint32_t n = dims - i < HALF_DECODE_CHUNK ? dims - i : HALF_DECODE_CHUNK;
+      diskann_elements_decode(idx->vector_type, a + (size_t)i * 2, n, chunk);
+      for (uint32_t j = 0; j < n; j++) {
+        float y = idx->vector_type == DISKANN_VECTOR_FLOAT16
+                      ? diskann_f16_to_f32(hb[i + j])
+                      : diskann_bf16_to_f32(hb[i + j]);
+        dot += chunk[j] * y;
+        aa += chunk[j] * chunk[j];
+        bb += y * y;
+      }
+    }
+    return cosine_from_parts(dot, a_inv, b_inv, aa, bb);
+  }
+
+  DiskAnnHalfDistanceFn kernel = half_kernel(idx);
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < dims; i += HALF_DECODE_CHUNK) {
+    uint32_t n = dims - i < HALF_DECODE_CHUNK ? dims - i : HALF_DECODE_CHUNK;
+    diskann_elements_decode(idx->vector_type, a + (size_t)i * 2, n, chunk);
+    sum += kernel(chunk, hb + i, n);
+  }
+  return half_kernel_distance(idx, sum, a_inv, b_inv);
+}
+
 /**************************************************************************
 ** Buffer management
 **************************************************************************/
@@ -264,6 +759,8 @@ DiskAnnNode *diskann_node_alloc(uint64_t rowid) {
   node->visited = 0;
   node->next = NULL;
   node->blob_spot = NULL;
+  node->beam_idx = -1;
+  node->queue_idx = -1;
   return node;
 }
 
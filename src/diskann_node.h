@@ -10,7 +10,7 @@
 ** - Little-endian serialization (read/write LE16/32/64)
 ** - Node BLOB binary format (init, read vector, edge CRUD)
 ** - Layout calculation (metadata size, max edges, offsets)
-** - Distance functions (L2, cosine)
+** - Distance functions (L2, cosine, inner product)
 ** - Buffer management (sorted insert/delete)
 ** - Node alloc/free
 */
@@ -29,11 +29,27 @@ extern "C" {
 /*
 ** V3 format constants (only format we support)
 **
-** Node metadata: 16 bytes (u64 rowid + u64 edge count in low 16 bits)
-** Edge metadata: 16 bytes (4b padding + 4b distance + 8b rowid)
+** Node metadata: 16 bytes (u64 rowid + u16 edge count + u16 flags +
+**                f32 inverse norm)
+** Edge metadata: 16 bytes (4b f32 inverse norm + 4b distance + 8b rowid)
+**
+** The inverse norm (1/|v|) is only written for cosine indexes. Zero means
+** "not stored" (pre-existing blocks, zero vectors, other metrics), and
+** readers fall back to computing the norm from the vector.
 */
 #define NODE_METADATA_SIZE 16
 #define EDGE_METADATA_SIZE 16
+#define NODE_FLAGS_OFFSET 10    /* u16 within node metadata */
+#define NODE_INV_NORM_OFFSET 12 /* f32 within node metadata */
+
+/*
+** Node flags. The field was reserved (always zero) before tombstones, so
+** older blocks read as live nodes.
+** - NODE_FLAG_TOMBSTONE: deleted by diskann_delete() in tombstone mode.
+**   The block keeps routing searches until diskann_consolidate() rewires
+**   its in-neighbors and removes it, but is never returned or linked to.
+*/
+#define NODE_FLAG_TOMBSTONE 0x0001
 
 /**************************************************************************
 ** Little-endian serialization (inline for performance)
@@ -77,6 +93,86 @@ static inline void write_le64(uint8_t *p, uint64_t v) {
   p[7] = (uint8_t)(v >> 56);
 }
 
+/**************************************************************************
+** Half-precision conversion (inline for the scalar kernels)
+**
+** Stored 16-bit elements are in host byte order, like float32 vectors.
+** Encoders round to nearest even; decoders are exact.
+**************************************************************************/
+
+static inline float diskann_f16_to_f32(uint16_t h) {
+  uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+  uint32_t exp = (h >> 10) & 0x1fu;
+  uint32_t mant = h & 0x3ffu;
+  uint32_t bits;
+  if (exp == 0x1fu) {
+    bits = sign | 0x7f800000u | (mant << 13); /* inf, NaN */
+  } else if (exp != 0) {
+    bits = sign | ((exp + 112u) << 23) | (mant << 13);
+  } else if (mant == 0) {
+    bits = sign;
+  } else {
+    /* Subnormal: normalize into a float32 exponent */
+    exp = 113;
+    while (!(mant & 0x400u)) {
+      mant <<= 1;
+      exp--;
+    }
+    bits = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static inline uint16_t diskann_f32_to_f16(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000u;
+  uint32_t mant = x & 0x7fffffu;
+  int32_t exp = (int32_t)((x >> 23) & 0xffu);
+  if (exp == 0xff) {
+    return (uint16_t)(sign | 0x7c00u | (mant ? 0x200u : 0u));
+  }
+  exp -= 127 - 15;
+  if (exp >= 0x1f) {
+    return (uint16_t)(sign | 0x7c00u); /* overflow: infinity */
+  }
+  uint32_t shift = 13;
+  if (exp <= 0) {
+    if (exp < -10) {
+      return (uint16_t)sign; /* below half the smallest subnormal */
+    }
+    mant |= 0x800000u;
+    shift = (uint32_t)(14 - exp);
+    exp = 0;
+  }
+  uint32_t h = ((uint32_t)exp << 10) | (mant >> shift);
+  uint32_t rest = mant & ((1u << shift) - 1u);
+  uint32_t halfway = 1u << (shift - 1u);
+  if (rest > halfway || (rest == halfway && (h & 1u))) {
+    h++; /* a carry rounds up into the exponent, as it should */
+  }
+  return (uint16_t)(sign | h);
+}
+
+static inline float diskann_bf16_to_f32(uint16_t h) {
+  uint32_t bits = (uint32_t)h << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static inline uint16_t diskann_f32_to_bf16(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  if ((x & 0x7fffffffu) > 0x7f800000u) {
+    return (uint16_t)((x >> 16) | 0x40u); /* keep NaN a (quiet) NaN */
+  }
+  x += 0x7fffu + ((x >> 16) & 1u);
+  return (uint16_t)(x >> 16);
+}
+
 /**************************************************************************
 ** DiskAnnNode — represents a single node in the graph
 **************************************************************************/
@@ -88,18 +184,36 @@ struct DiskAnnNode {
   int visited;         /* Has this node been visited during search? */
   DiskAnnNode *next;   /* Next node in visited list (linked list) */
   BlobSpot *blob_spot; /* BLOB handle for node data (NULL if not loaded) */
+  int beam_idx;        /* Position in the search beam heap, -1 = none */
+  int queue_idx;       /* Position in the unvisited heap, -1 = none */
+  float distance;      /* Distance to the query, exact once visited */
 };
 
 /**************************************************************************
 ** Layout calculation helpers
 **
-** Node BLOB layout (V3, float32-only):
-**   [0..15]   Node metadata: rowid(8) + edge_count(8, low 16 bits used)
-**   [16..]    Node vector: dims * sizeof(float)
-**   [..]      Edge vectors: max_edges * nEdgeVectorSize
+** Node BLOB layout (V3):
+**   [0..15]   Node metadata: rowid(8) + edge_count(2) + reserved(2) +
+**             inv_norm(4)
+**   [16..]    Node vector: dims elements of idx->vector_type
+**   [..]      Edge vectors: max_edges * nEdgeVectorSize (vector_type
+**             elements or int8 codes depending on idx->edge_type)
 **   [..]      Edge metadata: max_edges * EDGE_METADATA_SIZE
 **************************************************************************/
 
+/*
+** Bytes per stored element of a vector type (DISKANN_VECTOR_*).
+** Returns 0 for an unknown type.
+*/
+uint32_t diskann_vector_element_size(uint8_t vector_type);
+
+/*
+** Bytes needed to store one edge vector of the given encoding in an index
+** of the given vector type. Returns 0 for an unknown edge or vector type.
+*/
+uint32_t diskann_edge_vector_size(uint8_t edge_type, uint8_t vector_type,
+                                  uint32_t dims);
+
 /*
 ** Calculate max number of edges that fit in a block.
 ** Returns 0 if block is too small (caller must check).
@@ -121,8 +235,10 @@ uint32_t node_edges_metadata_offset(const DiskAnnIndex *idx);
 **************************************************************************/
 
 /*
-** Initialize a node BLOB: write rowid, zero edge count, copy vector data.
-** Clears the entire buffer first (zero-fills unused space).
+** Initialize a node BLOB: write rowid, zero edge count, encode the vector
+** per idx->vector_type. Clears the entire buffer first (zero-fills unused
+** space). For cosine indexes the vector's inverse norm is stored in the
+** node metadata.
 */
 void node_bin_init(const DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
                    const float *vector);
@@ -130,23 +246,73 @@ void node_bin_init(const DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid,
 /*
 ** Get a read-only pointer to the node's vector data (zero-copy).
 ** Returns pointer into the BlobSpot buffer — valid until buffer changes.
+** Only valid for DISKANN_VECTOR_FLOAT32 indexes; use
+** node_bin_vector_data() or node_bin_vector_float() otherwise.
 */
 const float *node_bin_vector(const DiskAnnIndex *idx, const BlobSpot *spot);
 
+/*
+** Pointer to the stored node vector (zero-copy into buffer). Score it with
+** diskann_vector_distance().
+*/
+const uint8_t *node_bin_vector_data(const DiskAnnIndex *idx,
+                                    const BlobSpot *spot);
+
+/*
+** The node vector as float32: a pointer into the buffer for float32
+** indexes, otherwise decoded into scratch (dims floats) and scratch.
+*/
+const float *node_bin_vector_float(const DiskAnnIndex *idx,
+                                   const BlobSpot *spot, float *scratch);
+
+/*
+** Stored inverse norm of the node vector (0 = not stored, see above).
+*/
+float node_bin_inv_norm(const DiskAnnIndex *idx, const BlobSpot *spot);
+
 /*
 ** Read edge count from node BLOB.
 */
 uint16_t node_bin_edges(const DiskAnnIndex *idx, const BlobSpot *spot);
 
+/*
+** Read / write the node flags (NODE_FLAG_*). Needs only the node metadata,
+** so partially loaded spots qualify.
+*/
+uint16_t node_bin_flags(const DiskAnnIndex *idx, const BlobSpot *spot);
+void node_bin_set_flags(const DiskAnnIndex *idx, BlobSpot *spot,
+                        uint16_t flags);
+
+/* Is the node tombstoned (see NODE_FLAG_TOMBSTONE)? */
+static inline int node_bin_is_tombstone(const DiskAnnIndex *idx,
+                                        const BlobSpot *spot) {
+  return (node_bin_flags(idx, spot) & NODE_FLAG_TOMBSTONE) != 0;
+}
+
 /*
 ** Read edge at index. Any output parameter can be NULL if not needed.
 ** - rowid: target node ID
 ** - distance: distance to target (float stored as LE u32)
-** - vector: pointer to edge vector data (zero-copy into buffer)
+** - vector: pointer to edge vector data (zero-copy into buffer). Only valid
+**   for DISKANN_EDGE_FLOAT32 edges of DISKANN_VECTOR_FLOAT32 indexes; use
+**   node_bin_edge_data() otherwise.
 */
 void node_bin_edge(const DiskAnnIndex *idx, const BlobSpot *spot, int edge_idx,
                    uint64_t *rowid, float *distance, const float **vector);
 
+/*
+** Pointer to the encoded edge vector at index (zero-copy into buffer).
+** Interpret with diskann_edge_distance() / diskann_edge_decode().
+*/
+const uint8_t *node_bin_edge_data(const DiskAnnIndex *idx,
+                                  const BlobSpot *spot, int edge_idx);
+
+/*
+** Stored inverse norm of the edge vector at index (0 = not stored).
+*/
+float node_bin_edge_inv_norm(const DiskAnnIndex *idx, const BlobSpot *spot,
+                             int edge_idx);
+
 /*
 ** Find edge index by target rowid. Returns -1 if not found.
 */
@@ -155,7 +321,8 @@ int node_bin_edge_find_idx(const DiskAnnIndex *idx, const BlobSpot *spot,
 
 /*
 ** Replace edge at position, or append if position == edge_count.
-** Copies vector data and writes metadata.
+** Encodes the float32 vector per idx->edge_type and writes metadata
+** (including the inverse norm for cosine indexes).
 */
 void node_bin_replace_edge(const DiskAnnIndex *idx, BlobSpot *spot,
                            int replace_idx, uint64_t rowid, float distance,
@@ -173,6 +340,21 @@ void node_bin_delete_edge(const DiskAnnIndex *idx, BlobSpot *spot,
 void node_bin_prune_edges(const DiskAnnIndex *idx, BlobSpot *spot,
                           int n_pruned);
 
+/*
+** Partial loads (see blob_spot_seek()). Readers that only need part of a
+** block fetch just those bytes:
+** - node_bin_load_adjacency: seek to rowid and read the node metadata plus
+**   the used edge metadata, enough for node_bin_edges(), edge rowids,
+**   distances and edge inverse norms.
+** - node_bin_load_vector: the node's own vector (node_bin_vector()).
+** - node_bin_load_edge_vector: one edge vector (node_bin_edge_data()).
+** On a fully loaded spot the last two are no-ops, so callers can use them
+** unconditionally. Returns DISKANN_OK or a BLOB I/O error code.
+*/
+int node_bin_load_adjacency(DiskAnnIndex *idx, BlobSpot *spot, uint64_t rowid);
+int node_bin_load_vector(DiskAnnIndex *idx, BlobSpot *spot);
+int node_bin_load_edge_vector(DiskAnnIndex *idx, BlobSpot *spot, int edge_idx);
+
 /**************************************************************************
 ** Distance functions
 **************************************************************************/
@@ -182,18 +364,254 @@ void node_bin_prune_edges(const DiskAnnIndex *idx, BlobSpot *spot,
 */
 float diskann_distance_l2(const float *a, const float *b, uint32_t dims);
 
+/*
+** diskann_distance_l2() with early abandon (see DiskAnnBoundedDistanceFn):
+** the exact distance when it is below bound, otherwise a value >= bound.
+*/
+float diskann_distance_l2_bounded(const float *a, const float *b,
+                                  uint32_t dims, float bound);
+
 /*
 ** Cosine distance: 1.0 - cosine_similarity.
 ** Returns 0.0 for identical directions, 2.0 for opposite.
 */
 float diskann_distance_cosine(const float *a, const float *b, uint32_t dims);
 
+/*
+** Inner-product distance: -a·b, so that smaller is closer like the other
+** metrics. Intended for maximum inner product search over unnormalized
+** vectors; values can be negative.
+*/
+float diskann_distance_dot(const float *a, const float *b, uint32_t dims);
+
 /*
 ** Dispatch distance calculation by metric type.
 */
 float diskann_distance(const float *a, const float *b, uint32_t dims,
                        uint8_t metric);
 
+/*
+** Inner product a·b (scalar reference for the SIMD dot kernels).
+*/
+float diskann_dot_product(const float *a, const float *b, uint32_t dims);
+
+/*
+** Inverse L2 norm 1/|v| using the index's dot kernel. Returns 0 for a zero
+** vector (matching the "not stored" convention).
+*/
+float diskann_index_inv_norm(const DiskAnnIndex *idx, const float *v);
+
+/*
+** Distance using the index's runtime-selected kernel. Hot loops call this
+** instead of diskann_distance() to skip the per-call metric switch.
+*/
+static inline float diskann_index_distance(const DiskAnnIndex *idx,
+                                           const float *a, const float *b) {
+  if (idx->distance) {
+    return idx->distance(a, b, idx->dimensions);
+  }
+  return diskann_distance(a, b, idx->dimensions, idx->metric);
+}
+
+/*
+** Distance with known inverse norms (0 = unknown). For cosine with both
+** norms known this is a single dot product; otherwise it is identical to
+** diskann_index_distance().
+*/
+static inline float diskann_index_distance_normed(const DiskAnnIndex *idx,
+                                                  const float *a, float a_inv,
+                                                  const float *b,
+                                                  float b_inv) {
+  if (idx->metric == DISKANN_METRIC_COSINE && a_inv > 0.0f && b_inv > 0.0f) {
+    float dot = idx->dot ? idx->dot(a, b, idx->dimensions)
+                         : diskann_dot_product(a, b, idx->dimensions);
+    return 1.0f - dot * a_inv * b_inv;
+  }
+  return diskann_index_distance(idx, a, b);
+}
+
+/**************************************************************************
+** Stored vectors
+**
+** Node vectors (and FLOAT32 edge slots) hold dims elements of
+** idx->vector_type. Half-precision elements are scored by mixed kernels
+** that convert them in registers (idx->half_distance).
+**************************************************************************/
+
+/* Encode a float32 vector into the index's vector type */
+void diskann_vector_encode(const DiskAnnIndex *idx, const float *vector,
+                           uint8_t *out);
+
+/* Decode n elements of vector_type into floats; in may be unaligned (a
+** row or argument straight from SQLite) */
+void diskann_elements_decode(uint8_t vector_type, const uint8_t *in,
+                             uint32_t n, float *out);
+
+/* Decode a stored vector into dims floats */
+void diskann_vector_decode(const DiskAnnIndex *idx, const uint8_t *data,
+                           float *out);
+
+/* Half-precision slow paths (see inline wrappers below) */
+float diskann_vector_distance_half(const DiskAnnIndex *idx, const float *q,
+                                   float q_inv, const uint8_t *v,
+                                   float v_inv);
+float diskann_vector_pair_distance_half(const DiskAnnIndex *idx,
+                                        const uint8_t *a, float a_inv,
+                                        const uint8_t *b, float b_inv);
+
+/*
+** Distance from a float32 vector q to a stored vector. Inverse norms
+** follow diskann_index_distance_normed() (0 = unknown).
+*/
+static inline float diskann_vector_distance(const DiskAnnIndex *idx,
+                                            const float *q, float q_inv,
+                                            const uint8_t *v, float v_inv) {
+  if (idx->vector_type == DISKANN_VECTOR_FLOAT32) {
+    return diskann_index_distance_normed(idx, q, q_inv, (const float *)v,
+                                         v_inv);
+  }
+  return diskann_vector_distance_half(idx, q, q_inv, v, v_inv);
+}
+
+/*
+** Distance between two stored vectors of the same index.
+*/
+static inline float diskann_vector_pair_distance(const DiskAnnIndex *idx,
+                                                 const uint8_t *a,
+                                                 float a_inv,
+                                                 const uint8_t *b,
+                                                 float b_inv) {
+  if (idx->vector_type == DISKANN_VECTOR_FLOAT32) {
+    return diskann_index_distance_normed(idx, (const float *)a, a_inv,
+                                         (const float *)b, b_inv);
+  }
+  return diskann_vector_pair_distance_half(idx, a, a_inv, b, b_inv);
+}
+
+/*
+** diskann_vector_distance() for callers that discard any result >= bound.
+** Euclidean float32 indexes stop summing once the partial sum reaches
+** bound and return it (see DiskAnnBoundedDistanceFn); results below bound
+** are exact. Other metrics and vector types score in full.
+*/
+static inline float diskann_vector_distance_bounded(const DiskAnnIndex *idx,
+                                                    const float *q,
+                                                    float q_inv,
+                                                    const uint8_t *v,
+                                                    float v_inv,
+                                                    float bound) {
+  if (idx->l2_bounded) {
+    return idx->l2_bounded(q, (const float *)v, idx->dimensions, bound);
+  }
+  return diskann_vector_distance(idx, q, q_inv, v, v_inv);
+}
+
+/*
+** Scalar reference kernels for stored half-precision vectors (b), the
+** DISKANN_SIMD_SCALAR entries of diskann_simd.h.
+*/
+float diskann_distance_l2_f16(const float *a, const uint16_t *b,
+                              uint32_t dims);
+float diskann_dot_product_f16(const float *a, const uint16_t *b,
+                              uint32_t dims);
+float diskann_distance_l2_bf16(const float *a, const uint16_t *b,
+                               uint32_t dims);
+float diskann_dot_product_bf16(const float *a, const uint16_t *b,
+                               uint32_t dims);
+
+/**************************************************************************
+** Edge vector encoding
+**
+** Edge slots are either a copy of the stored node vector (FLOAT32: no
+** conversion beyond the index's vector_type) or INT8 codes with
+** value = quant_min + code * quant_scale. Quantized distances are only used
+** for navigation; search reranks visited nodes with their own vector.
+**************************************************************************/
+
+/*
+** Encode a float32 vector into an edge slot (values outside the INT8 range
+** are clamped).
+*/
+void diskann_edge_encode(const DiskAnnIndex *idx, const float *vector,
+                         uint8_t *out);
+
+/*
+** Decode an edge slot into dims floats.
+*/
+void diskann_edge_decode(const DiskAnnIndex *idx, const uint8_t *data,
+                         float *out);
+
+/* Quantized slow paths (see inline wrappers below) */
+float diskann_edge_distance_int8(const DiskAnnIndex *idx, const float *q,
+                                 float q_inv, const uint8_t *codes,
+                                 float codes_inv);
+float diskann_edge_pair_distance_int8(const DiskAnnIndex *idx,
+                                      const uint8_t *a, float a_inv,
+                                      const uint8_t *b, float b_inv);
+
+/*
+** Distance from a float32 vector q to an encoded edge vector. Inverse norms
+** follow diskann_index_distance_normed() (0 = unknown).
+*/
+static inline float diskann_edge_distance(const DiskAnnIndex *idx,
+                                          const float *q, float q_inv,
+                                          const uint8_t *edge,
+                                          float edge_inv) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32) {
+    return diskann_vector_distance(idx, q, q_inv, edge, edge_inv);
+  }
+  return diskann_edge_distance_int8(idx, q, q_inv, edge, edge_inv);
+}
+
+/*
+** Distance between two encoded edge vectors of the same index.
+*/
+static inline float diskann_edge_pair_distance(const DiskAnnIndex *idx,
+                                               const uint8_t *a, float a_inv,
+                                               const uint8_t *b,
+                                               float b_inv) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32) {
+    return diskann_vector_pair_distance(idx, a, a_inv, b, b_inv);
+  }
+  return diskann_edge_pair_distance_int8(idx, a, a_inv, b, b_inv);
+}
+
+/*
+** Bounded variants of the two functions above; INT8 edges score in full
+** (see diskann_vector_distance_bounded()).
+*/
+static inline float diskann_edge_distance_bounded(const DiskAnnIndex *idx,
+                                                  const float *q, float q_inv,
+                                                  const uint8_t *edge,
+                                                  float edge_inv,
+                                                  float bound) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32) {
+    return diskann_vector_distance_bounded(idx, q, q_inv, edge, edge_inv,
+                                           bound);
+  }
+  return diskann_edge_distance_int8(idx, q, q_inv, edge, edge_inv);
+}
+
+static inline float diskann_edge_pair_distance_bounded(
+    const DiskAnnIndex *idx, const uint8_t *a, float a_inv, const uint8_t *b,
+    float b_inv, float bound) {
+  if (idx->edge_type == DISKANN_EDGE_FLOAT32 && idx->l2_bounded) {
+    return idx->l2_bounded((const float *)a, (const float *)b,
+                           idx->dimensions, bound);
+  }
+  return diskann_edge_pair_distance(idx, a, a_inv, b, b_inv);
+}
+
+/*
+** Alpha-scaled occlusion threshold for distance d. Alpha > 1 relaxes
+** pruning; for negative distances (DISKANN_METRIC_DOT) "relaxed" means
+** closer to zero, so divide instead of multiply.
+*/
+static inline double diskann_alpha_threshold(const DiskAnnIndex *idx,
+                                             float d) {
+  return d >= 0.0f ? idx->pruning_alpha * d : d / idx->pruning_alpha;
+}
+
 /**************************************************************************
 ** Buffer management — sorted array insert/delete
 **************************************************************************/
@@ -224,7 +642,7 @@ void buffer_delete(uint8_t *buf, int size, int delete_idx, int item_size);
 
 /*
 ** Allocate a new DiskAnnNode with the given rowid.
-** Initializes: visited=0, next=NULL, blob_spot=NULL.
+** Initializes: visited=0, next=NULL, blob_spot=NULL, heap positions -1.
 ** Returns NULL on allocation failure.
 */
 DiskAnnNode *diskann_node_alloc(uint64_t rowid);
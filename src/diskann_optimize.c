@@ -0,0 +1,311 @@
+/*
+** DiskANN Optimize — locality-ordered rewrite of the shadow table
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** Shadow rows are written in insertion order, so the blocks of graph
+** neighbors land on unrelated pages and every hop of a cold search is a
+** random read. diskann_optimize() rewrites every row in breadth-first
+** order from the entry point; components the walk does not reach follow,
+** each walked from its smallest rowid.
+**
+** Node ids stay user rowids: edges, labels, PQ codes, filters and the
+** virtual table all address nodes by rowid. What the rewrite changes is
+** where SQLite puts each block: a block larger than a page lives in
+** overflow pages allocated when the row is written, so rows written in
+** walk order keep the blocks of neighbors on nearby pages. The refill
+** also repacks pages left sparse by deletes.
+**
+** Rows are staged in a private temporary database (SQLite deletes its
+** file on close), then the shadow table is cleared and refilled inside
+** one SAVEPOINT. VACUUM copies rows back in rowid order, so optimize
+** after vacuuming, not before.
+*/
+#include "diskann.h"
+#include "diskann_bitmap.h"
+#include "diskann_blob.h"
+#include "diskann_internal.h"
+#include "diskann_node.h"
+#include "diskann_sqlite.h"
+#include <limits.h>
+#include <string.h>
+
+/* Every shadow rowid, ascending, into *ids (sqlite3_malloc'd) and the set
+** present */
+static int collect_rowids(DiskAnnIndex *idx, DiskAnnBitmap *present,
+                          int64_t **ids, uint64_t *n) {
+  sqlite3_stmt *stmt = NULL;
+  uint64_t capacity = 0;
+  int rc = DISKANN_OK;
+
+  *ids = NULL;
+  *n = 0;
+  char *sql = sqlite3_mprintf("SELECT id FROM \"%w\".\"%w\" ORDER BY id",
+                              idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int sqlite_rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (sqlite_rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  while ((sqlite_rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t id = sqlite3_column_int64(stmt, 0);
+    if (*n == capacity) {
+      uint64_t grown = capacity ? capacity * 2 : 1024;
+      int64_t *p = (int64_t *)sqlite3_realloc64(*ids, grown * sizeof(int64_t));
+      if (!p) {
+        rc = DISKANN_ERROR_NOMEM;
+        break;
+      }
+      *ids = p;
+      capacity = grown;
+    }
+    (*ids)[(*n)++] = id;
+    rc = diskann_bitmap_add(present, id);
+    if (rc != DISKANN_OK) {
+      break;
+    }
+  }
+  if (rc == DISKANN_OK && sqlite_rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+  }
+  sqlite3_finalize(stmt);
+  return rc;
+}
+
+/*
+** Fill order[0..n) with the rows of ids in breadth-first order over the
+** graph: from the entry point first, then from each row not yet reached.
+** Edges to rows missing from present are ignored.
+*/
+static int locality_order(DiskAnnIndex *idx, const int64_t *ids, uint64_t n,
+                          const DiskAnnBitmap *present, int64_t *order) {
+  DiskAnnBitmap seen;
+  BlobSpot *spot = NULL;
+  uint64_t head = 0, tail = 0, next_root = 0;
+  uint32_t max_edges = node_edges_max_count(idx);
+  int rc = DISKANN_OK;
+
+  diskann_bitmap_init(&seen);
+  if (idx->has_entry && diskann_bitmap_contains(present, idx->entry_rowid)) {
+    rc = diskann_bitmap_add(&seen, idx->entry_rowid);
+    order[tail++] = idx->entry_rowid;
+  }
+
+  while (rc == DISKANN_OK && tail < n) {
+    if (head == tail) {
+      /* Walk exhausted: start the next unreached component */
+      while (diskann_bitmap_contains(&seen, ids[next_root])) {
+        next_root++;
+      }
+      rc = diskann_bitmap_add(&seen, ids[next_root]);
+      order[tail++] = ids[next_root];
+      continue;
+    }
+
+    uint64_t rowid = (uint64_t)order[head++];
+    if (!spot) {
+      rc = blob_spot_create(idx, &spot, rowid, idx->block_size,
+                            DISKANN_BLOB_READONLY);
+      if (rc != DISKANN_OK) {
+        break;
+      }
+    }
+    rc = node_bin_load_adjacency(idx, spot, rowid);
+    if (rc != DISKANN_OK) {
+      break;
+    }
+    uint32_t n_edges = node_bin_edges(idx, spot);
+    if (n_edges > max_edges) {
+      n_edges = max_edges; /* corrupt count: stay inside the block */
+    }
+    for (uint32_t e = 0; e < n_edges && rc == DISKANN_OK; e++) {
+      uint64_t target;
+      node_bin_edge(idx, spot, (int)e, &target, NULL, NULL);
+      if (diskann_bitmap_contains(present, (int64_t)target) &&
+          !diskann_bitmap_contains(&seen, (int64_t)target)) {
+        rc = diskann_bitmap_add(&seen, (int64_t)target);
+        order[tail++] = (int64_t)target;
+      }
+    }
+  }
+
+  if (spot) {
+    blob_spot_free(spot);
+  }
+  diskann_bitmap_deinit(&seen);
+  return rc;
+}
+
+/* Prepare sql on db into *stmt: DISKANN_OK, or DISKANN_ERROR[_NOMEM] */
+static int prepare_sql(sqlite3 *db, char *sql, sqlite3_stmt **stmt) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(db, sql, -1, stmt, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+/* Copy the rows of order, in order, into the table "stage" of stage */
+static int stage_rows(DiskAnnIndex *idx, sqlite3 *stage, const int64_t *order,
+                      uint64_t n) {
+  sqlite3_stmt *read = NULL;
+  sqlite3_stmt *write = NULL;
+  int rc;
+
+  if (sqlite3_exec(stage,
+                   "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF;"
+                   "CREATE TABLE stage(id INTEGER, data BLOB); BEGIN",
+                   NULL, NULL, NULL) != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  rc = prepare_sql(idx->db,
+                   sqlite3_mprintf("SELECT data FROM \"%w\".\"%w\" "
+                                   "WHERE id = ?",
+                                   idx->db_name, idx->shadow_name),
+                   &read);
+  if (rc == DISKANN_OK) {
+    rc = prepare_sql(stage,
+                     sqlite3_mprintf("INSERT INTO stage(id, data) "
+                                     "VALUES (?, ?)"),
+                     &write);
+  }
+  for (uint64_t i = 0; i < n && rc == DISKANN_OK; i++) {
+    sqlite3_bind_int64(read, 1, order[i]);
+    if (sqlite3_step(read) != SQLITE_ROW) {
+      rc = DISKANN_ERROR;
+      break;
+    }
+    /* The row's blob stays valid until read is reset */
+    sqlite3_bind_int64(write, 1, order[i]);
+    sqlite3_bind_value(write, 2, sqlite3_column_value(read, 0));
+    if (sqlite3_step(write) != SQLITE_DONE) {
+      rc = DISKANN_ERROR;
+    }
+    sqlite3_reset(write);
+    sqlite3_reset(read);
+  }
+  sqlite3_finalize(read);
+  sqlite3_finalize(write);
+  if (rc == DISKANN_OK &&
+      sqlite3_exec(stage, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+    rc = DISKANN_ERROR;
+  }
+  return rc;
+}
+
+/* Clear the shadow table and refill it from stage in staging order */
+static int refill_rows(DiskAnnIndex *idx, sqlite3 *stage) {
+  sqlite3_stmt *read = NULL;
+  sqlite3_stmt *write = NULL;
+  int rc;
+
+  char *sql = sqlite3_mprintf("DELETE FROM \"%w\".\"%w\"", idx->db_name,
+                              idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL) == SQLITE_OK
+           ? DISKANN_OK
+           : DISKANN_ERROR;
+  sqlite3_free(sql);
+  if (rc == DISKANN_OK) {
+    rc = prepare_sql(stage,
+                     sqlite3_mprintf("SELECT id, data FROM stage "
+                                     "ORDER BY rowid"),
+                     &read);
+  }
+  if (rc == DISKANN_OK) {
+    rc = prepare_sql(idx->db,
+                     sqlite3_mprintf("INSERT INTO \"%w\".\"%w\" (id, data) "
+                                     "VALUES (?, ?)",
+                                     idx->db_name, idx->shadow_name),
+                     &write);
+  }
+  int sqlite_rc = SQLITE_DONE;
+  while (rc == DISKANN_OK && (sqlite_rc = sqlite3_step(read)) == SQLITE_ROW) {
+    sqlite3_bind_int64(write, 1, sqlite3_column_int64(read, 0));
+    sqlite3_bind_value(write, 2, sqlite3_column_value(read, 1));
+    if (sqlite3_step(write) != SQLITE_DONE) {
+      rc = DISKANN_ERROR;
+    }
+    sqlite3_reset(write);
+  }
+  if (rc == DISKANN_OK && sqlite_rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+  }
+  sqlite3_finalize(read);
+  sqlite3_finalize(write);
+  return rc;
+}
+
+int diskann_optimize(DiskAnnIndex *idx) {
+  DiskAnnBitmap present;
+  int64_t *ids = NULL;
+  int64_t *order = NULL;
+  uint64_t n = 0;
+  sqlite3 *stage = NULL;
+
+  /* Batch mode holds edges and deletes that are not on disk yet */
+  if (!idx || diskann_is_read_only(idx) || idx->batch_cache) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  /* Tombstoned rows would be rewritten only to be removed later */
+  int rc = diskann_consolidate(idx);
+  if (rc < 0) {
+    return rc;
+  }
+
+  diskann_bitmap_init(&present);
+  rc = collect_rowids(idx, &present, &ids, &n);
+  if (rc != DISKANN_OK || n == 0) {
+    goto out;
+  }
+  order = (int64_t *)sqlite3_malloc64(n * sizeof(int64_t));
+  if (!order) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+  rc = locality_order(idx, ids, n, &present, order);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  sqlite3_free(ids); /* rows are addressed through order from here */
+  ids = NULL;
+  diskann_bitmap_deinit(&present);
+
+  /* "" opens a private on-disk database, removed when closed */
+  if (sqlite3_open_v2("", &stage, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                      NULL) != SQLITE_OK) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+  rc = stage_rows(idx, stage, order, n);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  int savepoint_active =
+      diskann_begin_savepoint(idx, DISKANN_SAVEPOINT_OPTIMIZE);
+  rc = refill_rows(idx, stage);
+  rc = diskann_end_savepoint(idx, DISKANN_SAVEPOINT_OPTIMIZE,
+                             savepoint_active, rc);
+  if (rc != DISKANN_OK) {
+    diskann_discard_cached_state(idx);
+  }
+
+out:
+  sqlite3_close(stage);
+  sqlite3_free(order);
+  sqlite3_free(ids);
+  diskann_bitmap_deinit(&present);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  return (int)(n > INT_MAX ? INT_MAX : n);
+}
@@ -0,0 +1,814 @@
+/*
+** DiskANN product quantization (PQ) routing codes
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "diskann_pq.h"
+#include "diskann.h"
+#include "diskann_internal.h"
+#include "diskann_node.h"
+#include "diskann_sqlite.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+/* Lloyd iterations per subvector. Codes only steer traversal (visited
+** nodes are reranked exactly), so a short schedule is plenty. */
+#define PQ_KMEANS_ITERATIONS 10
+
+/* Reservoir seed: deterministic so rebuilds of the same data match */
+#define PQ_SAMPLE_SEED 0x5DEECE66DULL
+
+/**************************************************************************
+** Codebook
+**************************************************************************/
+
+static uint32_t sub_len(const DiskAnnPq *pq, uint32_t m) {
+  return pq->offsets[m + 1] - pq->offsets[m];
+}
+
+static const float *centroid(const DiskAnnPq *pq, uint32_t m, uint32_t c) {
+  return pq->centroids + (size_t)DISKANN_PQ_CENTROIDS * pq->offsets[m] +
+         (size_t)c * sub_len(pq, m);
+}
+
+static float *centroid_mut(DiskAnnPq *pq, uint32_t m, uint32_t c) {
+  return pq->centroids + (size_t)DISKANN_PQ_CENTROIDS * pq->offsets[m] +
+         (size_t)c * sub_len(pq, m);
+}
+
+/* Nearest centroid of subvector m (sub points at the subvector's dims) */
+static uint8_t nearest_centroid(const DiskAnnPq *pq, uint32_t m,
+                                const float *sub) {
+  uint32_t len = sub_len(pq, m);
+  uint32_t best = 0;
+  float best_dist = pq->l2(sub, centroid(pq, m, 0), len);
+  for (uint32_t c = 1; c < DISKANN_PQ_CENTROIDS; c++) {
+    float d = pq->l2(sub, centroid(pq, m, c), len);
+    if (d < best_dist) {
+      best_dist = d;
+      best = c;
+    }
+  }
+  return (uint8_t)best;
+}
+
+/* 1/|v|, or 0 for a zero vector (matches diskann_index_inv_norm) */
+static float pq_inv_norm(const DiskAnnPq *pq, const float *v) {
+  float norm_sq = pq->dot(v, v, pq->dims);
+  return norm_sq > 0.0f ? 1.0f / sqrtf(norm_sq) : 0.0f;
+}
+
+int diskann_pq_create(DiskAnnPq **out, uint32_t dims, uint8_t metric,
+                      uint32_t n_subvectors, const float *centroids) {
+  DiskAnnPq *pq;
+  size_t centroid_bytes;
+
+  if (!out || dims == 0 || n_subvectors == 0 || n_subvectors > dims ||
+      metric > DISKANN_METRIC_DOT) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+
+  pq = (DiskAnnPq *)sqlite3_malloc(sizeof(DiskAnnPq));
+  if (!pq) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(pq, 0, sizeof(DiskAnnPq));
+  pq->dims = dims;
+  pq->n_subvectors = n_subvectors;
+  pq->metric = metric;
+
+  const DiskAnnDistanceKernels *k = diskann_simd_kernels(diskann_simd_level());
+  pq->l2 = k->l2;
+  pq->dot = k->dot;
+
+  /* Spread any remainder across subvectors: lengths differ by at most 1 */
+  pq->offsets = (uint32_t *)sqlite3_malloc64((uint64_t)(n_subvectors + 1) *
+                                             sizeof(uint32_t));
+  centroid_bytes = (size_t)DISKANN_PQ_CENTROIDS * dims * sizeof(float);
+  pq->centroids = (float *)sqlite3_malloc64(centroid_bytes);
+  if (!pq->offsets || !pq->centroids) {
+    diskann_pq_free(pq);
+    return DISKANN_ERROR_NOMEM;
+  }
+  for (uint32_t m = 0; m <= n_subvectors; m++) {
+    pq->offsets[m] = (uint32_t)((uint64_t)dims * m / n_subvectors);
+  }
+  if (centroids) {
+    memcpy(pq->centroids, centroids, centroid_bytes);
+  } else {
+    memset(pq->centroids, 0, centroid_bytes);
+  }
+
+  *out = pq;
+  return DISKANN_OK;
+}
+
+void diskann_pq_free(DiskAnnPq *pq) {
+  if (!pq) {
+    return;
+  }
+  sqlite3_free(pq->offsets);
+  sqlite3_free(pq->centroids);
+  sqlite3_free(pq->rowids);
+  sqlite3_free(pq->codes);
+  sqlite3_free(pq->slots);
+  sqlite3_free(pq);
+}
+
+int diskann_pq_train(DiskAnnPq **out, uint32_t dims, uint8_t metric,
+                     uint32_t n_subvectors, const float *samples,
+                     uint32_t n_samples) {
+  DiskAnnPq *pq = NULL;
+  float *normed = NULL;
+  float *sums = NULL;
+  uint32_t *counts = NULL;
+  int rc;
+
+  if (!out || !samples || n_samples == 0) {
+    return DISKANN_ERROR_INVALID;
+  }
+  rc = diskann_pq_create(&pq, dims, metric, n_subvectors, NULL);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+
+  /* Cosine codebooks live on the unit sphere */
+  const float *data = samples;
+  if (metric == DISKANN_METRIC_COSINE) {
+    normed = (float *)sqlite3_malloc64((uint64_t)n_samples * dims *
+                                       sizeof(float));
+    if (!normed) {
+      rc = DISKANN_ERROR_NOMEM;
+      goto out;
+    }
+    for (uint32_t i = 0; i < n_samples; i++) {
+      const float *src = samples + (size_t)i * dims;
+      float inv = pq_inv_norm(pq, src);
+      for (uint32_t d = 0; d < dims; d++) {
+        normed[(size_t)i * dims + d] = src[d] * inv;
+      }
+    }
+    data = normed;
+  }
+
+  uint32_t max_len = 0;
+  for (uint32_t m = 0; m < n_subvectors; m++) {
+    if (sub_len(pq, m) > max_len) {
+      max_len = sub_len(pq, m);
+    }
+  }
+  sums = (float *)sqlite3_malloc64((uint64_t)DISKANN_PQ_CENTROIDS * max_len *
+                                   sizeof(float));
+  counts = (uint32_t *)sqlite3_malloc64(DISKANN_PQ_CENTROIDS *
+                                        sizeof(uint32_t));
+  if (!sums || !counts) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+
+  for (uint32_t m = 0; m < n_subvectors; m++) {
+    uint32_t off = pq->offsets[m];
+    uint32_t len = sub_len(pq, m);
+
+    /* Seed with evenly spaced samples (repeats when n_samples < 256) */
+    for (uint32_t c = 0; c < DISKANN_PQ_CENTROIDS; c++) {
+      uint32_t s = (uint32_t)((uint64_t)c * n_samples / DISKANN_PQ_CENTROIDS);
+      memcpy(centroid_mut(pq, m, c), data + (size_t)s * dims + off,
+             len * sizeof(float));
+    }
+
+    for (int iter = 0; iter < PQ_KMEANS_ITERATIONS; iter++) {
+      memset(sums, 0, (size_t)DISKANN_PQ_CENTROIDS * len * sizeof(float));
+      memset(counts, 0, DISKANN_PQ_CENTROIDS * sizeof(uint32_t));
+
+      for (uint32_t i = 0; i < n_samples; i++) {
+        const float *sub = data + (size_t)i * dims + off;
+        uint8_t c = nearest_centroid(pq, m, sub);
+        float *acc = sums + (size_t)c * len;
+        for (uint32_t d = 0; d < len; d++) {
+          acc[d] += sub[d];
+        }
+        counts[c]++;
+      }
+
+      /* Empty clusters keep their previous centroid */
+      for (uint32_t c = 0; c < DISKANN_PQ_CENTROIDS; c++) {
+        if (counts[c] == 0) {
+          continue;
+        }
+        float *cent = centroid_mut(pq, m, c);
+        float inv_count = 1.0f / (float)counts[c];
+        for (uint32_t d = 0; d < len; d++) {
+          cent[d] = sums[(size_t)c * len + d] * inv_count;
+        }
+      }
+    }
+  }
+
+  *out = pq;
+  pq = NULL;
+  rc = DISKANN_OK;
+
+out:
+  diskann_pq_free(pq);
+  sqlite3_free(normed);
+  sqlite3_free(sums);
+  sqlite3_free(counts);
+  return rc;
+}
+
+int diskann_pq_encode(const DiskAnnPq *pq, const float *vector,
+                      uint8_t *code) {
+  float *normed = NULL;
+
+  if (pq->metric == DISKANN_METRIC_COSINE) {
+    normed = (float *)sqlite3_malloc64((uint64_t)pq->dims * sizeof(float));
+    if (!normed) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    float inv = pq_inv_norm(pq, vector);
+    for (uint32_t d = 0; d < pq->dims; d++) {
+      normed[d] = vector[d] * inv;
+    }
+    vector = normed;
+  }
+
+  for (uint32_t m = 0; m < pq->n_subvectors; m++) {
+    code[m] = nearest_centroid(pq, m, vector + pq->offsets[m]);
+  }
+
+  sqlite3_free(normed);
+  return DISKANN_OK;
+}
+
+void diskann_pq_query_table(const DiskAnnPq *pq, const float *query,
+                            float query_inv_norm, float *table) {
+  for (uint32_t m = 0; m < pq->n_subvectors; m++) {
+    const float *sub = query + pq->offsets[m];
+    uint32_t len = sub_len(pq, m);
+    float *row = table + (size_t)m * DISKANN_PQ_CENTROIDS;
+
+    for (uint32_t c = 0; c < DISKANN_PQ_CENTROIDS; c++) {
+      const float *cent = centroid(pq, m, c);
+      switch (pq->metric) {
+      case DISKANN_METRIC_COSINE:
+        /* Sum over subvectors is 1 - q̂·x̂; fold the 1 into the first row */
+        row[c] = (m == 0 ? 1.0f : 0.0f) -
+                 pq->dot(sub, cent, len) * query_inv_norm;
+        break;
+      case DISKANN_METRIC_DOT:
+        row[c] = -pq->dot(sub, cent, len);
+        break;
+      default:
+        row[c] = pq->l2(sub, cent, len);
+        break;
+      }
+    }
+  }
+}
+
+/**************************************************************************
+** rowid -> code map
+**
+** Codes are stored densely (rowids[i], codes[i * n_subvectors]) so the
+** table is ~n_subvectors bytes per node; an open-addressing index of
+** uint32 slots maps rowids to dense positions. Deletes swap the last
+** entry into the hole and use backward-shift deletion in the index, so
+** no tombstones accumulate.
+**************************************************************************/
+
+#define PQ_MIN_SLOTS 64
+
+static uint32_t pq_hash(int64_t rowid, uint32_t mask) {
+  uint64_t h = (uint64_t)rowid * 0x9E3779B97F4A7C15ULL;
+  return (uint32_t)(h >> 32) & mask;
+}
+
+/* Bucket holding rowid, or the empty bucket where it would go */
+static uint32_t pq_find_bucket(const DiskAnnPq *pq, int64_t rowid) {
+  uint32_t mask = pq->n_slots - 1;
+  uint32_t b = pq_hash(rowid, mask);
+  while (pq->slots[b] != 0 && pq->rowids[pq->slots[b] - 1] != rowid) {
+    b = (b + 1) & mask;
+  }
+  return b;
+}
+
+static int pq_resize_slots(DiskAnnPq *pq, uint32_t n_slots) {
+  uint32_t *slots =
+      (uint32_t *)sqlite3_malloc64((uint64_t)n_slots * sizeof(uint32_t));
+  if (!slots) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(slots, 0, (size_t)n_slots * sizeof(uint32_t));
+  sqlite3_free(pq->slots);
+  pq->slots = slots;
+  pq->n_slots = n_slots;
+
+  for (uint32_t i = 0; i < pq->count; i++) {
+    pq->slots[pq_find_bucket(pq, pq->rowids[i])] = i + 1;
+  }
+  return DISKANN_OK;
+}
+
+static int pq_grow_entries(DiskAnnPq *pq) {
+  uint32_t capacity = pq->capacity ? pq->capacity * 2 : PQ_MIN_SLOTS;
+  int64_t *rowids = (int64_t *)sqlite3_realloc64(
+      pq->rowids, (uint64_t)capacity * sizeof(int64_t));
+  if (!rowids) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  pq->rowids = rowids;
+
+  uint8_t *codes = (uint8_t *)sqlite3_realloc64(
+      pq->codes, (uint64_t)capacity * pq->n_subvectors);
+  if (!codes) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  pq->codes = codes;
+  pq->capacity = capacity;
+  return DISKANN_OK;
+}
+
+int diskann_pq_put(DiskAnnPq *pq, int64_t rowid, const uint8_t *code) {
+  int rc;
+
+  /* Keep the index at most half full */
+  if ((uint64_t)(pq->count + 1) * 2 > pq->n_slots) {
+    rc = pq_resize_slots(pq, pq->n_slots ? pq->n_slots * 2 : PQ_MIN_SLOTS);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+
+  uint32_t b = pq_find_bucket(pq, rowid);
+  if (pq->slots[b] != 0) {
+    memcpy(pq->codes + (size_t)(pq->slots[b] - 1) * pq->n_subvectors, code,
+           pq->n_subvectors);
+    return DISKANN_OK;
+  }
+
+  if (pq->count == pq->capacity) {
+    rc = pq_grow_entries(pq);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  pq->rowids[pq->count] = rowid;
+  memcpy(pq->codes + (size_t)pq->count * pq->n_subvectors, code,
+         pq->n_subvectors);
+  pq->count++;
+  pq->slots[b] = pq->count;
+  return DISKANN_OK;
+}
+
+const uint8_t *diskann_pq_get(const DiskAnnPq *pq, int64_t rowid) {
+  if (pq->n_slots == 0) {
+    return NULL;
+  }
+  uint32_t slot = pq->slots[pq_find_bucket(pq, rowid)];
+  if (slot == 0) {
+    return NULL;
+  }
+  return pq->codes + (size_t)(slot - 1) * pq->n_subvectors;
+}
+
+void diskann_pq_remove(DiskAnnPq *pq, int64_t rowid) {
+  if (pq->n_slots == 0) {
+    return;
+  }
+  uint32_t mask = pq->n_slots - 1;
+  uint32_t i = pq_find_bucket(pq, rowid);
+  if (pq->slots[i] == 0) {
+    return;
+  }
+
+  /* Move the last dense entry into the hole (re-point its bucket first,
+  ** while its rowid is still unique in the dense array) */
+  uint32_t hole = pq->slots[i] - 1;
+  uint32_t last = pq->count - 1;
+  if (hole != last) {
+    uint32_t last_bucket = pq_find_bucket(pq, pq->rowids[last]);
+    pq->rowids[hole] = pq->rowids[last];
+    memcpy(pq->codes + (size_t)hole * pq->n_subvectors,
+           pq->codes + (size_t)last * pq->n_subvectors, pq->n_subvectors);
+    pq->slots[last_bucket] = hole + 1;
+  }
+  pq->count--;
+
+  /* Backward-shift deletion: pull later entries of the probe run into the
+  ** gap unless their home bucket lies cyclically in (i, j] */
+  pq->slots[i] = 0;
+  uint32_t j = i;
+  for (;;) {
+    j = (j + 1) & mask;
+    if (pq->slots[j] == 0) {
+      break;
+    }
+    uint32_t home = pq_hash(pq->rowids[pq->slots[j] - 1], mask);
+    int movable = (j > i) ? (home <= i || home > j) : (home <= i && home > j);
+    if (movable) {
+      pq->slots[i] = pq->slots[j];
+      pq->slots[j] = 0;
+      i = j;
+    }
+  }
+}
+
+/**************************************************************************
+** Persistence
+**************************************************************************/
+
+/* 1 if {index}_{suffix} exists, 0 if not, negative on error */
+static int pq_table_exists(const DiskAnnIndex *idx, const char *suffix) {
+  sqlite3_stmt *stmt = NULL;
+  char *sql = sqlite3_mprintf("SELECT 1 FROM \"%w\".sqlite_master WHERE "
+                              "type='table' AND name='%q_%q'",
+                              idx->db_name, idx->index_name, suffix);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
+  rc = sqlite3_step(stmt);
+  sqlite3_finalize(stmt);
+  if (rc == SQLITE_ROW) {
+    return 1;
+  }
+  return rc == SQLITE_DONE ? 0 : DISKANN_ERROR;
+}
+
+static int pq_exec(const DiskAnnIndex *idx, char *sql) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_exec(idx->db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+static int pq_prepare(const DiskAnnIndex *idx, char *sql,
+                      sqlite3_stmt **stmt) {
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  int rc = sqlite3_prepare_v2(idx->db, sql, -1, stmt, NULL);
+  sqlite3_free(sql);
+  return rc == SQLITE_OK ? DISKANN_OK : DISKANN_ERROR;
+}
+
+int diskann_pq_load(DiskAnnIndex *idx) {
+  sqlite3_stmt *stmt = NULL;
+  DiskAnnPq *pq = NULL;
+  int rc;
+
+  rc = pq_table_exists(idx, "pq_codebook");
+  if (rc <= 0) {
+    return rc; /* 0 = PQ never built: not an error */
+  }
+
+  rc = pq_prepare(idx,
+                  sqlite3_mprintf("SELECT n_subvectors, centroids FROM "
+                                  "\"%w\".\"%w_pq_codebook\" WHERE id = 1",
+                                  idx->db_name, idx->index_name),
+                  &stmt);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  if (sqlite3_step(stmt) != SQLITE_ROW) {
+    rc = DISKANN_OK; /* Empty codebook table: PQ disabled */
+    goto out;
+  }
+  int64_t n_subvectors = sqlite3_column_int64(stmt, 0);
+  const void *centroids = sqlite3_column_blob(stmt, 1);
+  size_t expected =
+      (size_t)DISKANN_PQ_CENTROIDS * idx->dimensions * sizeof(float);
+  if (n_subvectors <= 0 || n_subvectors > (int64_t)idx->dimensions ||
+      !centroids || (size_t)sqlite3_column_bytes(stmt, 1) != expected) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+  rc = diskann_pq_create(&pq, idx->dimensions, idx->metric,
+                         (uint32_t)n_subvectors, (const float *)centroids);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+
+  rc = pq_prepare(idx,
+                  sqlite3_mprintf("SELECT id, code FROM \"%w\".\"%w_pq\"",
+                                  idx->db_name, idx->index_name),
+                  &stmt);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const uint8_t *code = (const uint8_t *)sqlite3_column_blob(stmt, 1);
+    if (!code ||
+        (uint32_t)sqlite3_column_bytes(stmt, 1) != pq->n_subvectors) {
+      rc = DISKANN_ERROR;
+      goto out;
+    }
+    rc = diskann_pq_put(pq, sqlite3_column_int64(stmt, 0), code);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  }
+  if (rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+
+  diskann_pq_free(idx->pq);
+  idx->pq = pq;
+  pq = NULL;
+  rc = DISKANN_OK;
+
+out:
+  if (stmt) {
+    sqlite3_finalize(stmt);
+  }
+  diskann_pq_free(pq);
+  return rc;
+}
+
+/* Prepare the INSERT used to persist codes into {index}_pq */
+static int pq_prepare_code_insert(const DiskAnnIndex *idx,
+                                  sqlite3_stmt **stmt) {
+  return pq_prepare(idx,
+                    sqlite3_mprintf("INSERT OR REPLACE INTO \"%w\".\"%w_pq\" "
+                                    "(id, code) VALUES (?, ?)",
+                                    idx->db_name, idx->index_name),
+                    stmt);
+}
+
+/* Encode one vector, persist it with a pq_prepare_code_insert() (or cached)
+** statement and add it to pq's map */
+static int pq_store_code(sqlite3_stmt *insert, DiskAnnPq *pq, int64_t rowid,
+                         const float *vector, uint8_t *code_buf) {
+  int rc = diskann_pq_encode(pq, vector, code_buf);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+
+  sqlite3_bind_int64(insert, 1, rowid);
+  sqlite3_bind_blob(insert, 2, code_buf, (int)pq->n_subvectors,
+                    SQLITE_STATIC);
+  rc = sqlite3_step(insert);
+  sqlite3_reset(insert);
+  if (rc != SQLITE_DONE) {
+    return DISKANN_ERROR;
+  }
+
+  return diskann_pq_put(pq, rowid, code_buf);
+}
+
+int diskann_pq_add_vector(DiskAnnIndex *idx, int64_t rowid,
+                          const float *vector) {
+  sqlite3_stmt *insert = NULL;
+  uint8_t *code = NULL;
+  int rc;
+
+  if (!idx->pq) {
+    return DISKANN_OK;
+  }
+  insert = diskann_stmt(idx, DISKANN_STMT_PQ_INSERT);
+  if (!insert) {
+    return DISKANN_ERROR;
+  }
+  code = (uint8_t *)sqlite3_malloc64(idx->pq->n_subvectors);
+  if (!code) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  rc = pq_store_code(insert, idx->pq, rowid, vector, code);
+  sqlite3_free(code);
+  return rc;
+}
+
+int diskann_pq_remove_vector(DiskAnnIndex *idx, int64_t rowid) {
+  sqlite3_stmt *stmt = NULL;
+  int rc;
+
+  if (!idx->pq) {
+    return DISKANN_OK;
+  }
+  stmt = diskann_stmt(idx, DISKANN_STMT_PQ_DELETE);
+  if (!stmt) {
+    return DISKANN_ERROR;
+  }
+  sqlite3_bind_int64(stmt, 1, rowid);
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  if (rc != SQLITE_DONE) {
+    return DISKANN_ERROR;
+  }
+
+  diskann_pq_remove(idx->pq, rowid);
+  return DISKANN_OK;
+}
+
+/* Decode the node vector of a raw shadow row into float32 */
+static int pq_row_vector(const DiskAnnIndex *idx, sqlite3_stmt *stmt, int col,
+                         float *out) {
+  const uint8_t *data = (const uint8_t *)sqlite3_column_blob(stmt, col);
+  int n_bytes = sqlite3_column_bytes(stmt, col);
+  if (!data || (uint32_t)n_bytes < NODE_METADATA_SIZE + idx->nNodeVectorSize) {
+    return DISKANN_ERROR;
+  }
+  diskann_vector_decode(idx, data + NODE_METADATA_SIZE, out);
+  return DISKANN_OK;
+}
+
+int diskann_pq_build(DiskAnnIndex *idx, uint32_t n_subvectors,
+                     uint32_t sample_size) {
+  sqlite3_stmt *stmt = NULL;
+  sqlite3_stmt *insert = NULL;
+  DiskAnnPq *pq = NULL;
+  float *samples = NULL;
+  float *vector = NULL;
+  uint8_t *code = NULL;
+  int savepoint_active = 0;
+  int rc;
+
+  if (!idx || diskann_is_read_only(idx) || n_subvectors == 0 ||
+      n_subvectors > idx->dimensions) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (sample_size == 0) {
+    sample_size = DISKANN_PQ_DEFAULT_SAMPLE_SIZE;
+  }
+
+  samples = (float *)sqlite3_malloc64((uint64_t)sample_size *
+                                      idx->dimensions * sizeof(float));
+  vector = (float *)sqlite3_malloc64(idx->dimensions * sizeof(float));
+  code = (uint8_t *)sqlite3_malloc64(n_subvectors);
+  if (!samples || !vector || !code) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+
+  /* Pass 1: reservoir-sample training vectors */
+  rc = pq_prepare(idx,
+                  sqlite3_mprintf("SELECT data FROM \"%w\".%s", idx->db_name,
+                                  idx->shadow_name),
+                  &stmt);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  uint64_t n_seen = 0;
+  uint64_t rng = PQ_SAMPLE_SEED;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    uint64_t target = n_seen;
+    if (n_seen >= sample_size) {
+      rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+      target = (rng >> 33) % (n_seen + 1);
+    }
+    n_seen++;
+    if (target >= sample_size) {
+      continue;
+    }
+    rc = pq_row_vector(idx, stmt, 0, samples + target * idx->dimensions);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  }
+  if (rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+  if (n_seen == 0) {
+    rc = DISKANN_ERROR_NOTFOUND; /* nothing to train on */
+    goto out;
+  }
+
+  rc = diskann_pq_train(&pq, idx->dimensions, idx->metric, n_subvectors,
+                        samples,
+                        (uint32_t)(n_seen < sample_size ? n_seen
+                                                        : sample_size));
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  sqlite3_free(samples);
+  samples = NULL;
+
+  /* Pass 2: persist codebook + codes atomically (SAVEPOINT nests inside
+  ** any caller transaction) */
+  rc = pq_exec(idx, sqlite3_mprintf("SAVEPOINT diskann_pq_build_%s",
+                                    idx->index_name));
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  savepoint_active = 1;
+
+  rc = pq_exec(idx, sqlite3_mprintf(
+                        "CREATE TABLE IF NOT EXISTS \"%w\".\"%w_pq\" ("
+                        "id INTEGER PRIMARY KEY, code BLOB NOT NULL)",
+                        idx->db_name, idx->index_name));
+  if (rc == DISKANN_OK) {
+    rc = pq_exec(idx, sqlite3_mprintf(
+                          "CREATE TABLE IF NOT EXISTS "
+                          "\"%w\".\"%w_pq_codebook\" ("
+                          "id INTEGER PRIMARY KEY, "
+                          "n_subvectors INTEGER NOT NULL, "
+                          "centroids BLOB NOT NULL)",
+                          idx->db_name, idx->index_name));
+  }
+  if (rc == DISKANN_OK) {
+    rc = pq_exec(idx, sqlite3_mprintf("DELETE FROM \"%w\".\"%w_pq\"",
+                                      idx->db_name, idx->index_name));
+  }
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  rc = pq_prepare(idx,
+                  sqlite3_mprintf("INSERT OR REPLACE INTO "
+                                  "\"%w\".\"%w_pq_codebook\" "
+                                  "(id, n_subvectors, centroids) "
+                                  "VALUES (1, ?, ?)",
+                                  idx->db_name, idx->index_name),
+                  &insert);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  sqlite3_bind_int64(insert, 1, (int64_t)n_subvectors);
+  sqlite3_bind_blob64(insert, 2, pq->centroids,
+                      (sqlite3_uint64)DISKANN_PQ_CENTROIDS *
+                          idx->dimensions * sizeof(float),
+                      SQLITE_STATIC);
+  rc = sqlite3_step(insert);
+  sqlite3_finalize(insert);
+  insert = NULL;
+  if (rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+
+  rc = pq_prepare(idx,
+                  sqlite3_mprintf("SELECT id, data FROM \"%w\".%s",
+                                  idx->db_name, idx->shadow_name),
+                  &stmt);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  rc = pq_prepare_code_insert(idx, &insert);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t rowid = sqlite3_column_int64(stmt, 0);
+    rc = pq_row_vector(idx, stmt, 1, vector);
+    if (rc == DISKANN_OK) {
+      rc = pq_store_code(insert, pq, rowid, vector, code);
+    }
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  }
+  if (rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+  sqlite3_finalize(insert);
+  insert = NULL;
+
+  rc = pq_exec(idx, sqlite3_mprintf("RELEASE diskann_pq_build_%s",
+                                    idx->index_name));
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  savepoint_active = 0;
+
+  diskann_pq_free(idx->pq);
+  idx->pq = pq;
+  pq = NULL;
+
+out:
+  if (stmt) {
+    sqlite3_finalize(stmt);
+  }
+  if (insert) {
+    sqlite3_finalize(insert);
+  }
+  if (savepoint_active) {
+    pq_exec(idx, sqlite3_mprintf("ROLLBACK TO diskann_pq_build_%s; "
+                                 "RELEASE diskann_pq_build_%s",
+                                 idx->index_name, idx->index_name));
+  }
+  diskann_pq_free(pq);
+  sqlite3_free(samples);
+  sqlite3_free(vector);
+  sqlite3_free(code);
+  return rc;
+}
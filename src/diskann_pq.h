@@ -0,0 +1,143 @@
+/*
+** DiskANN product quantization (PQ) routing codes
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** Every beam-search hop scores all edges of the expanded node. With PQ
+** enabled, those candidate distances come from a compact per-node code
+** (n_subvectors bytes) held in RAM instead of the full edge vectors:
+** the query is turned into a lookup table once, and each candidate then
+** costs n_subvectors table lookups. Visited nodes are still re-scored with
+** their exact float32 vector, so returned distances stay exact.
+**
+** Layout:
+** - The vector is split into n_subvectors contiguous ranges; each range
+**   has DISKANN_PQ_CENTROIDS centroids trained with k-means, and a code
+**   byte picks the nearest one.
+** - Cosine indexes quantize unit-normalized vectors, so the lookup table
+**   sums to 1 - cos(q, x).
+**
+** Persistence (both shadow tables are created by diskann_pq_build()):
+**   {index}_pq          (id INTEGER PRIMARY KEY, code BLOB NOT NULL)
+**   {index}_pq_codebook (id INTEGER PRIMARY KEY, n_subvectors INTEGER NOT
+**                        NULL, centroids BLOB NOT NULL)
+** diskann_open_index() loads the codebook and all codes when present.
+** Nodes without a code (e.g. inserted by an older build) fall back to the
+** edge vector stored in the block.
+*/
+#ifndef DISKANN_PQ_H
+#define DISKANN_PQ_H
+
+#include "diskann_internal.h"
+#include "diskann_simd.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISKANN_PQ_CENTROIDS 256 /* one code byte per subvector */
+
+/*
+** Trained codebook plus the in-memory rowid -> code map.
+**
+** Memory ownership: every pointer is owned (sqlite3_malloc'd) and released
+** by diskann_pq_free().
+*/
+typedef struct DiskAnnPq {
+  uint32_t dims;
+  uint32_t n_subvectors;
+  uint8_t metric;       /* DISKANN_METRIC_* the codebook was trained for */
+  uint32_t *offsets;    /* n_subvectors + 1 dimension boundaries */
+  float *centroids;     /* subvector m, centroid c at
+                        ** centroids[CENTROIDS * offsets[m] + c * len_m] */
+  DiskAnnDistanceFn l2; /* kernels used for training and lookup tables */
+  DiskAnnDistanceFn dot;
+
+  /* Dense code storage (swap-remove on delete) */
+  int64_t *rowids;    /* count entries */
+  uint8_t *codes;     /* count * n_subvectors bytes */
+  uint32_t count;
+  uint32_t capacity;
+
+  /* Open-addressing hash: slot index + 1, 0 = empty */
+  uint32_t *slots;
+  uint32_t n_slots; /* power of 2, kept at most half full */
+} DiskAnnPq;
+
+/*
+** Train a codebook with k-means over n_samples vectors (row-major, dims
+** floats each). The returned DiskAnnPq has an empty code map.
+**
+** Returns DISKANN_OK, DISKANN_ERROR_INVALID for bad parameters or
+** DISKANN_ERROR_NOMEM.
+*/
+int diskann_pq_train(DiskAnnPq **out, uint32_t dims, uint8_t metric,
+                     uint32_t n_subvectors, const float *samples,
+                     uint32_t n_samples);
+
+/*
+** Create a DiskAnnPq with an empty code map around an existing codebook
+** (used when loading). centroids must hold DISKANN_PQ_CENTROIDS * dims
+** floats and is copied; NULL leaves the codebook zeroed.
+*/
+int diskann_pq_create(DiskAnnPq **out, uint32_t dims, uint8_t metric,
+                      uint32_t n_subvectors, const float *centroids);
+
+/* Free a DiskAnnPq (NULL-safe). */
+void diskann_pq_free(DiskAnnPq *pq);
+
+/*
+** Encode a vector into n_subvectors code bytes.
+** Returns DISKANN_OK or DISKANN_ERROR_NOMEM (cosine needs a scratch copy).
+*/
+int diskann_pq_encode(const DiskAnnPq *pq, const float *vector,
+                      uint8_t *code);
+
+/*
+** Fill an asymmetric-distance lookup table for a query:
+** n_subvectors * DISKANN_PQ_CENTROIDS floats. query_inv_norm is 1/|q| for
+** cosine indexes (ignored otherwise).
+*/
+void diskann_pq_query_table(const DiskAnnPq *pq, const float *query,
+                            float query_inv_norm, float *table);
+
+/* Approximate distance of a code from a query lookup table. */
+static inline float diskann_pq_table_distance(const DiskAnnPq *pq,
+                                              const float *table,
+                                              const uint8_t *code) {
+  float sum = 0.0f;
+  for (uint32_t m = 0; m < pq->n_subvectors; m++) {
+    sum += table[m * DISKANN_PQ_CENTROIDS + code[m]];
+  }
+  return sum;
+}
+
+/*
+** Code map. diskann_pq_put copies the code and replaces any existing one.
+** diskann_pq_get returns NULL when rowid has no code.
+*/
+int diskann_pq_put(DiskAnnPq *pq, int64_t rowid, const uint8_t *code);
+const uint8_t *diskann_pq_get(const DiskAnnPq *pq, int64_t rowid);
+void diskann_pq_remove(DiskAnnPq *pq, int64_t rowid);
+
+/*
+** Persistence helpers (operate on idx->pq and the _pq shadow tables).
+**
+** diskann_pq_load: load codebook + codes if the tables exist; leaves
+**   idx->pq NULL otherwise. Returns DISKANN_OK or an error code.
+** diskann_pq_add_vector: encode, persist and map the code for a new node
+**   (no-op when idx->pq is NULL).
+** diskann_pq_remove_vector: drop a node's code (no-op when idx->pq is NULL).
+*/
+int diskann_pq_load(DiskAnnIndex *idx);
+int diskann_pq_add_vector(DiskAnnIndex *idx, int64_t rowid,
+                          const float *vector);
+int diskann_pq_remove_vector(DiskAnnIndex *idx, int64_t rowid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_PQ_H */
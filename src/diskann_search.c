@@ -11,9 +11,15 @@
 #include "diskann_blob.h"
 #include "diskann_cache.h"
 #include "diskann_internal.h"
+#include "diskann_label.h"
 #include "diskann_node.h"
+#include "diskann_pq.h"
 #include "diskann_sqlite.h"
+#include "diskann_snapshot.h"
+#include "diskann_stats.h"
+#include "diskann_thread.h"
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,8 +28,6 @@
 ** VisitedSet — O(1) hash set for visited tracking (build speed optimization)
 **************************************************************************/
 
-#define VISITED_SET_EMPTY 0xFFFFFFFFFFFFFFFFULL
-
 /* FNV-1a hash for 64-bit integers */
 static uint64_t hash_rowid(uint64_t rowid) { return rowid * 0x100000001b3ULL; }
 
@@ -40,6 +44,30 @@ static int next_power_of_2(int n) {
   return n + 1;
 }
 
+/* Allocate empty slot arrays; returns DISKANN_OK or DISKANN_ERROR_NOMEM */
+static int visited_set_alloc(VisitedSet *set, int capacity) {
+  set->capacity = capacity;
+  set->count = 0;
+  set->stamp = 1;
+  set->rowids =
+      (uint64_t *)sqlite3_malloc64((uint64_t)capacity * sizeof(uint64_t));
+  set->stamps =
+      (uint32_t *)sqlite3_malloc64((uint64_t)capacity * sizeof(uint32_t));
+  set->states = (uint8_t *)sqlite3_malloc64((uint32_t)capacity);
+
+  if (!set->rowids || !set->stamps || !set->states) {
+    sqlite3_free(set->rowids);
+    sqlite3_free(set->stamps);
+    sqlite3_free(set->states);
+    set->rowids = NULL;
+    set->stamps = NULL;
+    set->states = NULL;
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(set->stamps, 0, (size_t)capacity * sizeof(uint32_t));
+  return DISKANN_OK;
+}
+
 /* Initialize hash set with power-of-2 capacity */
 #ifdef TESTING
 void
@@ -49,77 +77,125 @@ static void
 visited_set_init(VisitedSet *set, int capacity) {
   assert(set);
   assert(capacity > 0 && (capacity & (capacity - 1)) == 0); /* power of 2 */
+  (void)visited_set_alloc(set, capacity); /* rowids == NULL on failure */
+}
 
-  set->capacity = capacity;
-  set->count = 0;
-  set->rowids =
-      (uint64_t *)sqlite3_malloc64((uint64_t)capacity * sizeof(uint64_t));
+/* Slot holding rowid, or the empty slot where it would go */
+static int visited_set_find(const VisitedSet *set, uint64_t rowid) {
+  uint64_t hash = hash_rowid(rowid);
+  int mask = set->capacity - 1;
+  int probe = (int)(hash & (uint64_t)mask);
+
+  /* Linear probe until we find rowid or empty slot; the set is kept at
+  ** most half full, so this terminates */
+  while (set->stamps[probe] == set->stamp && set->rowids[probe] != rowid) {
+    probe = (probe + 1) & mask;
+  }
+  return probe;
+}
 
-  if (set->rowids) {
-    for (int i = 0; i < capacity; i++) {
-      set->rowids[i] = VISITED_SET_EMPTY;
+/* Rehash into twice the capacity (current-generation entries only) */
+static int visited_set_grow(VisitedSet *set) {
+  VisitedSet grown;
+  if (set->capacity > (1 << 29) ||
+      visited_set_alloc(&grown, set->capacity * 2) != DISKANN_OK) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  for (int i = 0; i < set->capacity; i++) {
+    if (set->stamps[i] == set->stamp) {
+      int slot = visited_set_find(&grown, set->rowids[i]);
+      grown.rowids[slot] = set->rowids[i];
+      grown.stamps[slot] = grown.stamp;
+      grown.states[slot] = set->states[i];
+      grown.count++;
     }
   }
+  sqlite3_free(set->rowids);
+  sqlite3_free(set->stamps);
+  sqlite3_free(set->states);
+  *set = grown;
+  return DISKANN_OK;
+}
+
+/* VISITED_SET_QUEUED / VISITED_SET_VISITED, or 0 if rowid is absent */
+#ifdef TESTING
+uint8_t
+#else
+static uint8_t
+#endif
+visited_set_state(const VisitedSet *set, uint64_t rowid) {
+  if (!set || !set->rowids) {
+    return 0;
+  }
+  int slot = visited_set_find(set, rowid);
+  return set->stamps[slot] == set->stamp ? set->states[slot] : 0;
 }
 
-/* Check if rowid is in the set (returns 1 if found, 0 otherwise) */
+/*
+** Insert rowid or update its state. Grows the table past half load.
+** Returns DISKANN_OK or DISKANN_ERROR_NOMEM (rowid not added).
+*/
 #ifdef TESTING
 int
 #else
 static int
 #endif
-visited_set_contains(const VisitedSet *set, uint64_t rowid) {
+visited_set_put(VisitedSet *set, uint64_t rowid, uint8_t state) {
   if (!set || !set->rowids) {
-    return 0;
+    return DISKANN_ERROR_NOMEM;
   }
 
-  uint64_t hash = hash_rowid(rowid);
-  int idx = (int)(hash & (uint64_t)(set->capacity - 1));
+  int slot = visited_set_find(set, rowid);
+  if (set->stamps[slot] == set->stamp) {
+    set->states[slot] = state; /* already present */
+    return DISKANN_OK;
+  }
 
-  /* Linear probe until we find rowid or empty slot */
-  for (int i = 0; i < set->capacity; i++) {
-    int probe = (idx + i) & (set->capacity - 1);
-    if (set->rowids[probe] == VISITED_SET_EMPTY) {
-      return 0; /* Not found */
-    }
-    if (set->rowids[probe] == rowid) {
-      return 1; /* Found */
+  if ((set->count + 1) * 2 > set->capacity) {
+    if (visited_set_grow(set) != DISKANN_OK) {
+      return DISKANN_ERROR_NOMEM;
     }
+    slot = visited_set_find(set, rowid);
   }
+  set->rowids[slot] = rowid;
+  set->stamps[slot] = set->stamp;
+  set->states[slot] = state;
+  set->count++;
+  return DISKANN_OK;
+}
+
+/* Check if rowid is in the set in any state (returns 1 if found) */
+#ifdef TESTING
+int
+#else
+static int
+#endif
+visited_set_contains(const VisitedSet *set, uint64_t rowid) {
+  return visited_set_state(set, rowid) != 0;
+}
 
-  return 0; /* Table full, not found */
+#ifdef TESTING
+/* Mark rowid visited (idempotent - safe to add same rowid twice) */
+void visited_set_add(VisitedSet *set, uint64_t rowid) {
+  (void)visited_set_put(set, rowid, VISITED_SET_VISITED);
 }
+#endif
 
-/* Add rowid to the set (idempotent - safe to add same rowid twice) */
+/* Empty the set in O(1); stamps are only rewritten when the counter wraps */
 #ifdef TESTING
 void
 #else
 static void
 #endif
-visited_set_add(VisitedSet *set, uint64_t rowid) {
+visited_set_clear(VisitedSet *set) {
   if (!set || !set->rowids) {
     return;
   }
-
-  uint64_t hash = hash_rowid(rowid);
-  int idx = (int)(hash & (uint64_t)(set->capacity - 1));
-
-  /* Linear probe until we find empty slot or existing rowid */
-  for (int i = 0; i < set->capacity; i++) {
-    int probe = (idx + i) & (set->capacity - 1);
-    if (set->rowids[probe] == VISITED_SET_EMPTY) {
-      set->rowids[probe] = rowid;
-      set->count++;
-      return;
-    }
-    if (set->rowids[probe] == rowid) {
-      return; /* Already in set */
-    }
+  set->count = 0;
+  if (++set->stamp == 0) {
+    memset(set->stamps, 0, (size_t)set->capacity * sizeof(uint32_t));
+    set->stamp = 1;
   }
-
-  /* Table full - should never happen with dynamic capacity (1.3×
-   * max_candidates) */
-  assert(0 && "VisitedSet full - increase capacity");
 }
 
 /* Free hash set resources */
@@ -131,7 +207,11 @@ static void
 visited_set_deinit(VisitedSet *set) {
   if (set && set->rowids) {
     sqlite3_free(set->rowids);
+    sqlite3_free(set->stamps);
+    sqlite3_free(set->states);
     set->rowids = NULL;
+    set->stamps = NULL;
+    set->states = NULL;
     set->count = 0;
   }
 }
@@ -145,56 +225,264 @@ visited_set_deinit(VisitedSet *set) {
 ** Search context — static helpers
 **************************************************************************/
 
-/* Check if a node has already been visited (now uses O(1) hash set) */
-static int search_ctx_is_visited(const DiskAnnSearchCtx *ctx, uint64_t rowid) {
-  return visited_set_contains(&ctx->visited_set, rowid);
+/*
+** Take a node from the context's pool, adding a chunk when it is empty.
+** Initializes: visited=0, next=NULL, blob_spot=NULL. Returns NULL on
+** allocation failure.
+*/
+static DiskAnnNode *search_ctx_node_alloc(DiskAnnSearchCtx *ctx,
+                                          uint64_t rowid) {
+  if (ctx->free_nodes == NULL) {
+    DiskAnnNodeChunk *chunk =
+        (DiskAnnNodeChunk *)sqlite3_malloc64(sizeof(DiskAnnNodeChunk));
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = ctx->node_chunks;
+    ctx->node_chunks = chunk;
+    for (int i = 0; i < DISKANN_NODE_CHUNK_SIZE; i++) {
+      chunk->nodes[i].next = ctx->free_nodes;
+      ctx->free_nodes = &chunk->nodes[i];
+    }
+  }
+
+  DiskAnnNode *node = ctx->free_nodes;
+  ctx->free_nodes = node->next;
+  node->rowid = rowid;
+  node->visited = 0;
+  node->next = NULL;
+  node->blob_spot = NULL;
+  node->beam_idx = -1;
+  node->queue_idx = -1;
+  return node;
 }
 
-/* Check if a node is already in the candidate queue */
-static int search_ctx_has_candidate(const DiskAnnSearchCtx *ctx,
-                                    uint64_t rowid) {
-  for (int i = 0; i < ctx->n_candidates; i++) {
-    if (ctx->candidates[i]->rowid == rowid) {
-      return 1;
+/* Return a node to the pool, dropping its BlobSpot reference (if any) */
+static void search_ctx_node_free(DiskAnnSearchCtx *ctx, DiskAnnNode *node) {
+  if (node->blob_spot != NULL) {
+    blob_spot_free(node->blob_spot);
+    node->blob_spot = NULL;
+  }
+  node->next = ctx->free_nodes;
+  ctx->free_nodes = node;
+}
+
+/* Return every node of the previous query to the pool */
+static void search_ctx_recycle(DiskAnnSearchCtx *ctx) {
+  /* Unvisited candidates (visited ones are in the visited list) */
+  for (int i = 0; i < ctx->n_unvisited; i++) {
+    search_ctx_node_free(ctx, ctx->queue[i]);
+  }
+
+  DiskAnnNode *node = ctx->visited_list;
+  while (node != NULL) {
+    DiskAnnNode *next = node->next;
+    search_ctx_node_free(ctx, node);
+    node = next;
+  }
+
+  ctx->n_candidates = 0;
+  ctx->n_top_candidates = 0;
+  ctx->visited_list = NULL;
+  ctx->n_unvisited = 0;
+}
+
+/*
+** Binary heaps over parallel node/distance arrays. The beam is a max-heap
+** (furthest candidate at the root), the queue a min-heap; each node keeps
+** its index in both so it can be removed from the middle.
+*/
+#define HEAP_QUEUE 0
+#define HEAP_BEAM 1
+
+static void heap_place(DiskAnnNode **nodes, float *dists, int i,
+                       DiskAnnNode *node, float dist, int kind) {
+  nodes[i] = node;
+  dists[i] = dist;
+  if (kind == HEAP_BEAM) {
+    node->beam_idx = i;
+  } else {
+    node->queue_idx = i;
+  }
+}
+
+/* Does a belong above b? */
+static int heap_above(float a, float b, int kind) {
+  return kind == HEAP_BEAM ? a > b : a < b;
+}
+
+/* Put (node, dist) at hole i and restore heap order around it */
+static void heap_fix(DiskAnnNode **nodes, float *dists, int n, int i,
+                     DiskAnnNode *node, float dist, int kind) {
+  while (i > 0 && heap_above(dist, dists[(i - 1) / 2], kind)) {
+    int parent = (i - 1) / 2;
+    heap_place(nodes, dists, i, nodes[parent], dists[parent], kind);
+    i = parent;
+  }
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= n) {
+      break;
     }
+    if (child + 1 < n && heap_above(dists[child + 1], dists[child], kind)) {
+      child++;
+    }
+    if (!heap_above(dists[child], dist, kind)) {
+      break;
+    }
+    heap_place(nodes, dists, i, nodes[child], dists[child], kind);
+    i = child;
   }
-  return 0;
+  heap_place(nodes, dists, i, node, dist, kind);
+}
+
+static void heap_push(DiskAnnNode **nodes, float *dists, int *n,
+                      DiskAnnNode *node, float dist, int kind) {
+  (*n)++;
+  heap_fix(nodes, dists, *n, *n - 1, node, dist, kind);
+}
+
+/* Remove the entry at index i (its node's position is reset to -1) */
+static void heap_remove(DiskAnnNode **nodes, float *dists, int *n, int i,
+                        int kind) {
+  DiskAnnNode *removed = nodes[i];
+  (*n)--;
+  if (i < *n) {
+    heap_fix(nodes, dists, *n, i, nodes[*n], dists[*n], kind);
+  }
+  if (kind == HEAP_BEAM) {
+    removed->beam_idx = -1;
+  } else {
+    removed->queue_idx = -1;
+  }
+}
+
+/*
+** DiskAnnResultHeap — (rowid, distance) min-heap for resumable walks
+*/
+
+/* Push (rowid, distance). Returns DISKANN_OK or DISKANN_ERROR_NOMEM. */
+static int result_heap_push(DiskAnnResultHeap *heap, int64_t rowid,
+                            float distance) {
+  if (heap->n == heap->cap) {
+    int cap = heap->cap ? heap->cap * 2 : 256;
+    DiskAnnResult *items = (DiskAnnResult *)sqlite3_realloc64(
+        heap->items, (uint64_t)cap * sizeof(DiskAnnResult));
+    if (!items) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    heap->items = items;
+    heap->cap = cap;
+  }
+  int i = heap->n++;
+  while (i > 0 && heap->items[(i - 1) / 2].distance > distance) {
+    heap->items[i] = heap->items[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap->items[i].id = rowid;
+  heap->items[i].distance = distance;
+  return DISKANN_OK;
+}
+
+/* Remove the closest pair (the heap must not be empty) */
+static DiskAnnResult result_heap_pop(DiskAnnResultHeap *heap) {
+  DiskAnnResult top = heap->items[0];
+  DiskAnnResult last = heap->items[--heap->n];
+  int i = 0;
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= heap->n) {
+      break;
+    }
+    if (child + 1 < heap->n &&
+        heap->items[child + 1].distance < heap->items[child].distance) {
+      child++;
+    }
+    if (heap->items[child].distance >= last.distance) {
+      break;
+    }
+    heap->items[i] = heap->items[child];
+    i = child;
+  }
+  if (heap->n > 0) {
+    heap->items[i] = last;
+  }
+  return top;
+}
+
+/*
+** Keep a scored candidate that is not (or no longer) in the beam, so a
+** resumed walk can start from it. Best effort: on NOMEM it is forgotten.
+*/
+static void search_ctx_spill(DiskAnnSearchCtx *ctx, uint64_t rowid,
+                             float distance) {
+  if (result_heap_push(&ctx->spill, (int64_t)rowid, distance) != DISKANN_OK) {
+    return;
+  }
+  (void)visited_set_put(&ctx->visited_set, rowid, VISITED_SET_SPILLED);
+}
+
+/* Has this rowid been queued (even if since evicted) or visited? A node
+** that fell out of the full beam cannot requalify: the beam threshold
+** only tightens */
+static int search_ctx_is_seen(const DiskAnnSearchCtx *ctx, uint64_t rowid) {
+  return visited_set_contains(&ctx->visited_set, rowid);
+}
+
+int diskann_search_ctx_visited(const DiskAnnSearchCtx *ctx, uint64_t rowid) {
+  return visited_set_state(&ctx->visited_set, rowid) == VISITED_SET_VISITED;
 }
 
 /*
-** Return insertion position for a candidate, or -1 if it shouldn't be added.
-** Drops the unused pIndex parameter from the original libSQL version.
+** Would a candidate at this distance enter the beam? Ties with the
+** furthest member of a full beam are rejected.
 */
 static int search_ctx_should_add(const DiskAnnSearchCtx *ctx,
                                  float candidate_dist) {
-  return distance_buffer_insert_idx(ctx->distances, ctx->n_candidates,
-                                    ctx->max_candidates, candidate_dist);
+  return ctx->n_candidates < ctx->max_candidates ||
+         candidate_dist < ctx->distances[0];
 }
 
 /*
 ** Mark a node as visited: set visited flag, prepend to visited list,
 ** add to hash set, and insert into top-K results if distance qualifies.
+** The node leaves the unvisited queue (if still in it) but stays in the
+** beam. Tombstoned or queued-for-deletion nodes (live == 0) are visited
+** but never results.
 */
 static void search_ctx_mark_visited(DiskAnnSearchCtx *ctx, DiskAnnNode *node,
-                                    float distance) {
-  assert(ctx->n_unvisited > 0);
+                                    float distance, int live) {
   assert(node->visited == 0);
 
   node->visited = 1;
-  ctx->n_unvisited--;
+  node->distance = distance;
+  if (node->queue_idx >= 0) {
+    heap_remove(ctx->queue, ctx->queue_distances, &ctx->n_unvisited,
+                node->queue_idx, HEAP_QUEUE);
+  }
 
   node->next = ctx->visited_list;
   ctx->visited_list = node;
+  ctx->n_visited++;
+  ctx->stale_visits++; /* until it enters the top-K below */
 
-  /* Add to hash set for O(1) future lookups */
-  visited_set_add(&ctx->visited_set, node->rowid);
+  /* Present as QUEUED already, so this never allocates */
+  (void)visited_set_put(&ctx->visited_set, node->rowid, VISITED_SET_VISITED);
 
   /* Filter gate: skip top-K insertion if filter rejects this rowid.
   ** Node is still visited (graph bridge) — only result set is filtered. */
+  if (!live) {
+    return;
+  }
   if (ctx->filter_fn &&
       !ctx->filter_fn((int64_t)node->rowid, ctx->filter_ctx)) {
     return;
   }
+  if (ctx->streaming) {
+    /* Best effort, like the walk itself: a match dropped on NOMEM is
+    ** simply not returned */
+    (void)result_heap_push(&ctx->found, (int64_t)node->rowid, distance);
+  }
 
   int insert_idx =
       distance_buffer_insert_idx(ctx->top_distances, ctx->n_top_candidates,
@@ -211,91 +499,147 @@ static void search_ctx_mark_visited(DiskAnnSearchCtx *ctx, DiskAnnNode *node,
   if (ctx->n_top_candidates < ctx->max_top_candidates) {
     ctx->n_top_candidates++;
   }
+  ctx->stale_visits = 0;
 }
 
 static int search_ctx_has_unvisited(const DiskAnnSearchCtx *ctx) {
   return ctx->n_unvisited > 0;
 }
 
-static void search_ctx_get_candidate(DiskAnnSearchCtx *ctx, int i,
-                                     DiskAnnNode **node, float *distance) {
-  assert(0 <= i && i < ctx->n_candidates);
-  *node = ctx->candidates[i];
-  *distance = ctx->distances[i];
+/*
+** Has the walk stopped paying off? With ctx->patience set, a full top-K
+** that the last patience visits did not change is taken as final: the
+** beam is still closing in on the query, but on nodes no closer than
+** the k-th result. Resumable walks always exhaust the beam.
+*/
+static int search_ctx_converged(const DiskAnnSearchCtx *ctx) {
+  return ctx->patience > 0 && !ctx->streaming &&
+         ctx->n_top_candidates == ctx->max_top_candidates &&
+         ctx->stale_visits >= ctx->patience;
 }
 
-/* Delete a candidate (zombie edge handling). Frees the node. */
-static void search_ctx_delete_candidate(DiskAnnSearchCtx *ctx, int i) {
+/*
+** Take the closest unvisited candidate (the root of the queue) off the
+** queue. It stays in the beam until search_ctx_mark_visited() or
+** search_ctx_delete_candidate(); nothing may evict the beam in between.
+*/
+static void search_ctx_take_candidate(DiskAnnSearchCtx *ctx,
+                                      DiskAnnNode **node, float *distance) {
   assert(ctx->n_unvisited > 0);
-  assert(!ctx->candidates[i]->visited);
-  assert(ctx->candidates[i]->blob_spot == NULL);
-
-  diskann_node_free(ctx->candidates[i]);
-  buffer_delete((uint8_t *)ctx->candidates, ctx->n_candidates, i,
-                (int)sizeof(DiskAnnNode *));
-  buffer_delete((uint8_t *)ctx->distances, ctx->n_candidates, i,
-                (int)sizeof(float));
-
-  ctx->n_candidates--;
-  ctx->n_unvisited--;
+  *node = ctx->queue[0];
+  *distance = ctx->queue_distances[0];
+  heap_remove(ctx->queue, ctx->queue_distances, &ctx->n_unvisited, 0,
+              HEAP_QUEUE);
 }
 
-/*
-** Insert a candidate at position. If the buffer is full, the furthest
-** candidate is evicted (freed if unvisited).
-*/
-static void search_ctx_insert_candidate(DiskAnnSearchCtx *ctx, int insert_idx,
-                                        DiskAnnNode *candidate,
-                                        float distance) {
-  DiskAnnNode *last = NULL;
-  buffer_insert((uint8_t *)ctx->candidates, ctx->n_candidates,
-                ctx->max_candidates, insert_idx, (int)sizeof(DiskAnnNode *),
-                (const uint8_t *)&candidate, (uint8_t *)&last);
-  buffer_insert((uint8_t *)ctx->distances, ctx->n_candidates,
-                ctx->max_candidates, insert_idx, (int)sizeof(float),
-                (const uint8_t *)&distance, NULL);
+/* Delete an unvisited candidate (zombie edge handling). Frees the node. */
+static void search_ctx_delete_candidate(DiskAnnSearchCtx *ctx,
+                                        DiskAnnNode *node) {
+  assert(!node->visited);
 
-  if (ctx->n_candidates < ctx->max_candidates) {
-    ctx->n_candidates++;
+  if (node->queue_idx >= 0) {
+    heap_remove(ctx->queue, ctx->queue_distances, &ctx->n_unvisited,
+                node->queue_idx, HEAP_QUEUE);
   }
+  heap_remove(ctx->candidates, ctx->distances, &ctx->n_candidates,
+              node->beam_idx, HEAP_BEAM);
+  search_ctx_node_free(ctx, node);
+}
 
-  if (last != NULL && !last->visited) {
-    assert(last->blob_spot == NULL);
-    ctx->n_unvisited--;
-    diskann_node_free(last);
+/* Make room for width hop slots; new slots start empty */
+static int search_ctx_reserve_hop(DiskAnnSearchCtx *ctx, int width) {
+  if (width <= ctx->cap_hop) {
+    return DISKANN_OK;
+  }
+  DiskAnnHopSlot *hop = (DiskAnnHopSlot *)sqlite3_realloc64(
+      ctx->hop, (uint64_t)width * sizeof(DiskAnnHopSlot));
+  if (!hop) {
+    return DISKANN_ERROR_NOMEM;
   }
-  ctx->n_unvisited++;
+  memset(hop + ctx->cap_hop, 0,
+         (size_t)(width - ctx->cap_hop) * sizeof(DiskAnnHopSlot));
+  ctx->hop = hop;
+  ctx->cap_hop = width;
+  return DISKANN_OK;
 }
 
 /*
-** Find the closest unvisited candidate. The candidates array is sorted
-** by distance, so we return the first unvisited one.
+** Add a candidate that passed search_ctx_should_add(). If the beam is
+** full, the furthest candidate is evicted (freed if unvisited).
+** Returns DISKANN_OK, or DISKANN_ERROR_NOMEM if the rowid could not be
+** recorded (the candidate is then dropped and freed).
 */
-static int search_ctx_find_closest_unvisited(const DiskAnnSearchCtx *ctx) {
-  for (int i = 0; i < ctx->n_candidates; i++) {
-    if (!ctx->candidates[i]->visited) {
-      return i;
+static int search_ctx_insert_candidate(DiskAnnSearchCtx *ctx,
+                                       DiskAnnNode *candidate,
+                                       float distance) {
+  if (visited_set_put(&ctx->visited_set, candidate->rowid,
+                      VISITED_SET_QUEUED) != DISKANN_OK) {
+    search_ctx_node_free(ctx, candidate);
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  if (ctx->n_candidates == ctx->max_candidates) {
+    DiskAnnNode *last = ctx->candidates[0];
+    float last_distance = ctx->distances[0];
+    heap_remove(ctx->candidates, ctx->distances, &ctx->n_candidates, 0,
+                HEAP_BEAM);
+    if (!last->visited) {
+      assert(last->blob_spot == NULL);
+      heap_remove(ctx->queue, ctx->queue_distances, &ctx->n_unvisited,
+                  last->queue_idx, HEAP_QUEUE);
+      if (ctx->streaming) {
+        search_ctx_spill(ctx, last->rowid, last_distance);
+      }
+      search_ctx_node_free(ctx, last);
     }
   }
-  return -1;
+
+  heap_push(ctx->candidates, ctx->distances, &ctx->n_candidates, candidate,
+            distance, HEAP_BEAM);
+  heap_push(ctx->queue, ctx->queue_distances, &ctx->n_unvisited, candidate,
+            distance, HEAP_QUEUE);
+  return DISKANN_OK;
 }
 
 /**************************************************************************
 ** Search context — public functions
 **************************************************************************/
 
-int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const float *query,
-                            int max_candidates, int max_top, int blob_mode) {
+int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const DiskAnnIndex *idx,
+                            const float *query, int max_candidates,
+                            int max_top, int blob_mode) {
+  memset(ctx, 0, sizeof(*ctx));
+  int rc = diskann_search_ctx_reset(ctx, idx, query, max_candidates, max_top,
+                                    blob_mode);
+  if (rc != DISKANN_OK) {
+    diskann_search_ctx_deinit(ctx);
+    memset(ctx, 0, sizeof(*ctx));
+  }
+  return rc;
+}
+
+int diskann_search_ctx_reset(DiskAnnSearchCtx *ctx, const DiskAnnIndex *idx,
+                             const float *query, int max_candidates,
+                             int max_top, int blob_mode) {
+  search_ctx_recycle(ctx);
+
   ctx->query = query;
-  ctx->n_candidates = 0;
+  ctx->query_inv_norm = idx->metric == DISKANN_METRIC_COSINE
+                            ? diskann_index_inv_norm(idx, query)
+                            : 0.0f;
   ctx->max_candidates = max_candidates;
-  ctx->n_top_candidates = 0;
   ctx->max_top_candidates = max_top;
-  ctx->visited_list = NULL;
-  ctx->n_unvisited = 0;
   ctx->blob_mode = blob_mode;
   ctx->filter_fn = NULL;
   ctx->filter_ctx = NULL;
+  ctx->label = DISKANN_LABEL_NONE;
+  ctx->pq_table = NULL;
+  ctx->streaming = 0;
+  ctx->spill.n = 0;
+  ctx->found.n = 0;
+  ctx->n_visited = 0;
+  ctx->patience = 0;
+  ctx->stale_visits = 0;
 
   /* Initialize hash set for O(1) visited checks.
    *
@@ -303,74 +647,164 @@ int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const float *query,
    * (~max_degree edges), so the total number of unique visited nodes can
    * reach max_candidates * max_degree. Using 8x max_candidates as a
    * practical upper bound, plus load factor headroom for open addressing.
+   * A pooled set that is already large enough is just cleared.
    */
   int required_capacity = max_candidates * 8;
   int capacity = next_power_of_2(required_capacity);
   if (capacity < 1024)
     capacity = 1024;
-  visited_set_init(&ctx->visited_set, capacity);
-
-  ctx->distances = (float *)sqlite3_malloc(max_candidates * (int)sizeof(float));
-  ctx->candidates = (DiskAnnNode **)sqlite3_malloc(max_candidates *
-                                                   (int)sizeof(DiskAnnNode *));
-  ctx->top_distances = (float *)sqlite3_malloc(max_top * (int)sizeof(float));
-  ctx->top_candidates =
-      (DiskAnnNode **)sqlite3_malloc(max_top * (int)sizeof(DiskAnnNode *));
-
-  if (ctx->distances && ctx->candidates && ctx->top_distances &&
-      ctx->top_candidates && ctx->visited_set.rowids) {
-    return DISKANN_OK;
+  if (ctx->visited_set.rowids && ctx->visited_set.capacity >= capacity) {
+    visited_set_clear(&ctx->visited_set);
+  } else {
+    visited_set_deinit(&ctx->visited_set);
+    visited_set_init(&ctx->visited_set, capacity);
+    if (!ctx->visited_set.rowids) {
+      return DISKANN_ERROR_NOMEM;
+    }
   }
 
-  /* Allocation failure — clean up partial allocations */
-  visited_set_deinit(&ctx->visited_set);
-  if (ctx->distances)
+  if (max_candidates > ctx->cap_candidates) {
     sqlite3_free(ctx->distances);
-  if (ctx->candidates)
     sqlite3_free(ctx->candidates);
-  if (ctx->top_distances)
+    sqlite3_free(ctx->queue_distances);
+    sqlite3_free(ctx->queue);
+    ctx->cap_candidates = 0;
+    ctx->distances =
+        (float *)sqlite3_malloc(max_candidates * (int)sizeof(float));
+    ctx->candidates = (DiskAnnNode **)sqlite3_malloc(
+        max_candidates * (int)sizeof(DiskAnnNode *));
+    ctx->queue_distances =
+        (float *)sqlite3_malloc(max_candidates * (int)sizeof(float));
+    ctx->queue = (DiskAnnNode **)sqlite3_malloc(max_candidates *
+                                                (int)sizeof(DiskAnnNode *));
+    if (!ctx->distances || !ctx->candidates || !ctx->queue_distances ||
+        !ctx->queue) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    ctx->cap_candidates = max_candidates;
+  }
+
+  if (max_top > ctx->cap_top) {
     sqlite3_free(ctx->top_distances);
-  if (ctx->top_candidates)
     sqlite3_free(ctx->top_candidates);
-  ctx->distances = NULL;
-  ctx->candidates = NULL;
-  ctx->top_distances = NULL;
-  ctx->top_candidates = NULL;
-
-  return DISKANN_ERROR_NOMEM;
-}
+    ctx->cap_top = 0;
+    ctx->top_distances = (float *)sqlite3_malloc(max_top * (int)sizeof(float));
+    ctx->top_candidates =
+        (DiskAnnNode **)sqlite3_malloc(max_top * (int)sizeof(DiskAnnNode *));
+    if (!ctx->top_distances || !ctx->top_candidates) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    ctx->cap_top = max_top;
+  }
 
-void diskann_search_ctx_deinit(DiskAnnSearchCtx *ctx) {
-  /* Free unvisited candidates still in the array (visited ones are in
-   * the visited list and will be freed below) */
-  for (int i = 0; i < ctx->n_candidates; i++) {
-    if (!ctx->candidates[i]->visited) {
-      diskann_node_free(ctx->candidates[i]);
+  /* PQ routing only for queries; inserts keep exact edge distances so
+  ** graph construction quality does not depend on the codebook */
+  if (idx->pq != NULL && blob_mode == DISKANN_BLOB_READONLY) {
+    uint64_t len = (uint64_t)idx->pq->n_subvectors * DISKANN_PQ_CENTROIDS;
+    if (len > ctx->pq_buf_len) {
+      sqlite3_free(ctx->pq_buf);
+      ctx->pq_buf_len = 0;
+      ctx->pq_buf = (float *)sqlite3_malloc64(len * sizeof(float));
+      if (!ctx->pq_buf) {
+        return DISKANN_ERROR_NOMEM;
+      }
+      ctx->pq_buf_len = len;
     }
+    ctx->pq_table = ctx->pq_buf;
+    diskann_pq_query_table(idx->pq, query, ctx->query_inv_norm,
+                           ctx->pq_table);
   }
 
-  /* Free all visited nodes */
-  DiskAnnNode *node = ctx->visited_list;
-  while (node != NULL) {
-    DiskAnnNode *next = node->next;
-    diskann_node_free(node);
-    node = next;
+  return DISKANN_OK;
+}
+
+void diskann_search_ctx_deinit(DiskAnnSearchCtx *ctx) {
+  /* Drop BlobSpot references held by nodes, then free the pool */
+  search_ctx_recycle(ctx);
+  DiskAnnNodeChunk *chunk = ctx->node_chunks;
+  while (chunk != NULL) {
+    DiskAnnNodeChunk *next = chunk->next;
+    sqlite3_free(chunk);
+    chunk = next;
   }
+  ctx->node_chunks = NULL;
+  ctx->free_nodes = NULL;
 
   /* Free hash set */
   visited_set_deinit(&ctx->visited_set);
 
+  for (int i = 0; i < ctx->cap_hop; i++) {
+    if (ctx->hop[i].spot) {
+      blob_spot_free(ctx->hop[i].spot);
+    }
+  }
+  sqlite3_free(ctx->hop);
+  ctx->hop = NULL;
+  ctx->cap_hop = 0;
+
   sqlite3_free(ctx->candidates);
   sqlite3_free(ctx->distances);
+  sqlite3_free(ctx->queue);
+  sqlite3_free(ctx->queue_distances);
   sqlite3_free(ctx->top_candidates);
   sqlite3_free(ctx->top_distances);
+  sqlite3_free(ctx->pq_buf);
+  sqlite3_free(ctx->spill.items);
+  sqlite3_free(ctx->found.items);
+}
+
+int diskann_search_ctx_acquire(DiskAnnIndex *idx, DiskAnnSearchCtx **out,
+                               const float *query, int max_candidates,
+                               int max_top) {
+  DiskAnnSearchCtx *ctx = idx->search_pool;
+  int rc;
+
+  *out = NULL;
+  if (ctx) {
+    idx->search_pool = NULL; /* checked out */
+    rc = diskann_search_ctx_reset(ctx, idx, query, max_candidates, max_top,
+                                  DISKANN_BLOB_READONLY);
+    if (rc != DISKANN_OK) {
+      diskann_search_ctx_deinit(ctx);
+      sqlite3_free(ctx);
+      return rc;
+    }
+    *out = ctx;
+    return DISKANN_OK;
+  }
+
+  ctx = (DiskAnnSearchCtx *)sqlite3_malloc64(sizeof(DiskAnnSearchCtx));
+  if (!ctx) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  rc = diskann_search_ctx_init(ctx, idx, query, max_candidates, max_top,
+                               DISKANN_BLOB_READONLY);
+  if (rc != DISKANN_OK) {
+    sqlite3_free(ctx);
+    return rc;
+  }
+  *out = ctx;
+  return DISKANN_OK;
+}
+
+void diskann_search_ctx_release(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx) {
+  if (!ctx) {
+    return;
+  }
+  search_ctx_recycle(ctx);
+  if (idx->search_pool == NULL) {
+    idx->search_pool = ctx;
+    return;
+  }
+  diskann_search_ctx_deinit(ctx);
+  sqlite3_free(ctx);
 }
 
 /**************************************************************************
 ** Random start node selection
 **************************************************************************/
 
-int diskann_select_random_shadow_row(const DiskAnnIndex *idx, uint64_t *rowid) {
+int diskann_select_random_shadow_row(DiskAnnIndex *idx, uint64_t *rowid) {
   sqlite3_stmt *stmt = NULL;
   int rc;
 
@@ -390,28 +824,18 @@ int diskann_select_random_shadow_row(const DiskAnnIndex *idx, uint64_t *rowid) {
   ** Not perfectly uniform when there are rowid gaps (from deletes),
   ** but uniform enough for beam search starting point selection.
   */
-  char *sql = sqlite3_mprintf("SELECT rowid FROM \"%w\".%s "
-                              "WHERE rowid >= (ABS(RANDOM()) %% "
-                              "(SELECT MAX(rowid) FROM \"%w\".%s)) + 1 LIMIT 1",
-                              idx->db_name, idx->shadow_name, idx->db_name,
-                              idx->shadow_name);
-  if (sql == NULL) {
-    return DISKANN_ERROR_NOMEM;
-  }
-
-  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, 0);
-  sqlite3_free(sql);
-  if (rc != SQLITE_OK) {
+  stmt = diskann_stmt(idx, DISKANN_STMT_RANDOM_ROW);
+  if (stmt == NULL) {
     return DISKANN_ERROR;
   }
 
   rc = sqlite3_step(stmt);
   if (rc == SQLITE_ROW) {
     *rowid = (uint64_t)sqlite3_column_int64(stmt, 0);
-    sqlite3_finalize(stmt);
+    sqlite3_reset(stmt);
     return DISKANN_OK;
   }
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
 
   if (rc != SQLITE_DONE) {
     return DISKANN_ERROR;
@@ -419,169 +843,621 @@ int diskann_select_random_shadow_row(const DiskAnnIndex *idx, uint64_t *rowid) {
 
   /* SQLITE_DONE: either empty table or random target past all rowids.
   ** Fallback to first row — O(log n), reads leftmost B-tree leaf. */
-  sql = sqlite3_mprintf("SELECT rowid FROM \"%w\".%s LIMIT 1", idx->db_name,
-                        idx->shadow_name);
-  if (sql == NULL) {
-    return DISKANN_ERROR_NOMEM;
-  }
-
-  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, 0);
-  sqlite3_free(sql);
-  if (rc != SQLITE_OK) {
+  stmt = diskann_stmt(idx, DISKANN_STMT_FIRST_ROW);
+  if (stmt == NULL) {
     return DISKANN_ERROR;
   }
 
   rc = sqlite3_step(stmt);
   if (rc == SQLITE_ROW) {
     *rowid = (uint64_t)sqlite3_column_int64(stmt, 0);
-    sqlite3_finalize(stmt);
+    sqlite3_reset(stmt);
     return DISKANN_OK;
   }
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
 
   /* SQLITE_DONE here = truly empty table */
   return rc;
 }
 
 /**************************************************************************
-** Core beam search
+** Entry point
+**
+** A fixed, central start node (approximate medoid) replaces the random
+** start row: fewer hops to reach the query's neighborhood, steadier
+** latency, and no SQL round-trip before the search.
 **************************************************************************/
 
-int diskann_search_internal(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
-                            uint64_t start_rowid, BlobCache *cache) {
-  DiskAnnNode *start = NULL;
-  BlobSpot *reusable_blob = NULL;
-  int rc;
+/* Nodes sampled when re-picking the entry point */
+#define ENTRY_SAMPLE_SIZE 256
 
-  start = diskann_node_alloc(start_rowid);
-  if (start == NULL) {
-    rc = DISKANN_ERROR_NOMEM;
-    goto out;
+int diskann_select_start_row(DiskAnnIndex *idx, uint64_t *rowid) {
+  if (idx->has_entry) {
+    *rowid = (uint64_t)idx->entry_rowid;
+    return DISKANN_OK;
   }
-
-  /* Check cache for start node */
-  if (cache) {
-    start->blob_spot = blob_cache_get(cache, start_rowid);
+  if (idx->snapshot) {
+    return SQLITE_DONE; /* exported with an entry unless empty */
   }
+  return diskann_select_random_shadow_row(idx, rowid);
+}
 
-  if (start->blob_spot == NULL) {
-    rc = blob_spot_create(idx, &start->blob_spot, start_rowid, idx->block_size,
-                          ctx->blob_mode);
-    if (rc != DISKANN_OK) {
-      goto out;
-    }
-
-    rc = blob_spot_reload(idx, start->blob_spot, start_rowid, idx->block_size);
-    if (rc != DISKANN_OK) {
-      goto out;
-    }
+int diskann_sample_rows(DiskAnnIndex *idx, int n_samples, float *vectors,
+                        int64_t *ids) {
+  sqlite3_stmt *stmt = NULL;
+  int n = 0;
+  int rc;
 
-    /* Add to cache on miss */
-    if (cache) {
-      blob_cache_put(cache, start_rowid, start->blob_spot);
-    }
+  /* Rowid range for random seeks (O(log n) each, no table scan) */
+  char *sql = sqlite3_mprintf("SELECT MIN(id), MAX(id) FROM \"%w\".%s",
+                              idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
   }
-
-  const float *start_vec = node_bin_vector(idx, start->blob_spot);
-  float start_distance =
-      diskann_distance(ctx->query, start_vec, idx->dimensions, idx->metric);
-
-  /* In READONLY mode, steal the blob for reuse across candidates */
-  if (ctx->blob_mode == DISKANN_BLOB_READONLY) {
-    assert(start->blob_spot != NULL);
-    reusable_blob = start->blob_spot;
-    start->blob_spot = NULL;
+  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
   }
+  if (sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_finalize(stmt);
+    return DISKANN_ERROR;
+  }
+  if (sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+    sqlite3_finalize(stmt);
+    return 0; /* empty index */
+  }
+  int64_t min_id = sqlite3_column_int64(stmt, 0);
+  int64_t max_id = sqlite3_column_int64(stmt, 1);
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+  uint64_t span = (uint64_t)max_id - (uint64_t)min_id + 1; /* 0 = all */
 
-  /* Transfer ownership of start node to the search context */
-  search_ctx_insert_candidate(ctx, 0, start, start_distance);
-  start = NULL;
+  sql = sqlite3_mprintf("SELECT id, data FROM \"%w\".%s WHERE id >= ? "
+                        "ORDER BY id LIMIT 1",
+                        idx->db_name, idx->shadow_name);
+  if (!sql) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    return DISKANN_ERROR;
+  }
 
-  while (search_ctx_has_unvisited(ctx)) {
-    DiskAnnNode *candidate;
-    BlobSpot *candidate_blob;
-    float distance;
-    int i_candidate = search_ctx_find_closest_unvisited(ctx);
-    search_ctx_get_candidate(ctx, i_candidate, &candidate, &distance);
-
-    rc = DISKANN_OK;
-    if (reusable_blob != NULL) {
-      rc = blob_spot_reload(idx, reusable_blob, candidate->rowid,
-                            idx->block_size);
-      candidate_blob = reusable_blob;
-    } else {
-      /* Check cache first (WRITABLE mode during insert) */
-      if (cache && candidate->blob_spot == NULL) {
-        candidate->blob_spot = blob_cache_get(cache, candidate->rowid);
+  for (int i = 0; i < n_samples; i++) {
+    uint64_t r;
+    sqlite3_randomness((int)sizeof(r), &r);
+    sqlite3_bind_int64(stmt, 1,
+                       (int64_t)((uint64_t)min_id + (span ? r % span : r)));
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+      const uint8_t *data = (const uint8_t *)sqlite3_column_blob(stmt, 1);
+      int n_bytes = sqlite3_column_bytes(stmt, 1);
+      /* Tombstoned rows are on their way out */
+      if (data &&
+          (uint32_t)n_bytes >= NODE_METADATA_SIZE + idx->nNodeVectorSize &&
+          !(read_le16(data + NODE_FLAGS_OFFSET) & NODE_FLAG_TOMBSTONE)) {
+        diskann_vector_decode(idx, data + NODE_METADATA_SIZE,
+                              vectors + (size_t)n * idx->dimensions);
+        ids[n++] = sqlite3_column_int64(stmt, 0);
       }
+    } else if (rc != SQLITE_DONE) {
+      sqlite3_finalize(stmt);
+      return DISKANN_ERROR;
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  return n;
+}
 
-      if (candidate->blob_spot == NULL) {
-        rc = blob_spot_create(idx, &candidate->blob_spot, candidate->rowid,
-                              idx->block_size, ctx->blob_mode);
-        if (rc == DISKANN_OK) {
-          rc = blob_spot_reload(idx, candidate->blob_spot, candidate->rowid,
-                                idx->block_size);
-        }
+int diskann_refresh_entry_point(DiskAnnIndex *idx) {
+  float *samples = NULL;
+  int64_t *sample_ids = NULL;
+  double *sum = NULL;
+  float *mean = NULL;
+  int rc;
 
-        /* Add to cache on miss */
-        if (rc == DISKANN_OK && cache) {
-          blob_cache_put(cache, candidate->rowid, candidate->blob_spot);
-        }
+  if (!idx || diskann_is_read_only(idx)) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  samples = (float *)sqlite3_malloc64((uint64_t)ENTRY_SAMPLE_SIZE *
+                                      idx->dimensions * sizeof(float));
+  sample_ids =
+      (int64_t *)sqlite3_malloc64(ENTRY_SAMPLE_SIZE * sizeof(int64_t));
+  sum = (double *)sqlite3_malloc64((uint64_t)idx->dimensions * sizeof(double));
+  mean = (float *)sqlite3_malloc64(idx->dimensions * sizeof(float));
+  if (!samples || !sample_ids || !sum || !mean) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+  memset(sum, 0, (size_t)idx->dimensions * sizeof(double));
+
+  /* Tombstoned rows are never a medoid */
+  int n_samples =
+      diskann_sample_rows(idx, ENTRY_SAMPLE_SIZE, samples, sample_ids);
+  if (n_samples < 0) {
+    rc = n_samples;
+    goto out;
+  }
+  if (n_samples == 0) {
+    uint64_t any;
+    rc = diskann_select_random_shadow_row(idx, &any);
+    if (rc == SQLITE_DONE) {
+      rc = diskann_clear_entry_point(idx); /* empty index */
+    }
+    /* otherwise only gaps hit; keep the current entry point */
+    goto out;
+  }
+  for (int i = 0; i < n_samples; i++) {
+    const float *v = samples + (size_t)i * idx->dimensions;
+    for (uint32_t d = 0; d < idx->dimensions; d++) {
+      sum[d] += v[d];
+    }
+  }
+
+  /* Medoid of the sample: the node closest to the sample mean (cosine
+  ** compares directions; L2 otherwise, also for DOT, where "closest by
+  ** inner product" would just favor large norms) */
+  for (uint32_t d = 0; d < idx->dimensions; d++) {
+    mean[d] = (float)(sum[d] / n_samples);
+  }
+  DiskAnnDistanceFn dist = diskann_simd_distance_fn(
+      idx->simd_level, idx->metric == DISKANN_METRIC_COSINE
+                           ? DISKANN_METRIC_COSINE
+                           : DISKANN_METRIC_EUCLIDEAN);
+  int best = 0;
+  float best_dist = dist(mean, samples, idx->dimensions);
+  for (int i = 1; i < n_samples; i++) {
+    float d = dist(mean, samples + (size_t)i * idx->dimensions,
+                   idx->dimensions);
+    if (d < best_dist) {
+      best_dist = d;
+      best = i;
+    }
+  }
+
+  rc = diskann_set_entry_point(idx, sample_ids[best]);
+  if (rc == DISKANN_OK && idx->entry_refresh_at < (1u << 30)) {
+    idx->entry_refresh_at *= 2;
+  }
+
+out:
+  sqlite3_free(samples);
+  sqlite3_free(sample_ids);
+  sqlite3_free(sum);
+  sqlite3_free(mean);
+  return rc;
+}
+
+/**************************************************************************
+** Shared read cache (see diskann_set_cache_budget())
+**************************************************************************/
+
+/*
+** Return the read cache usable by this search, or NULL. Clears the cache
+** first when another connection has committed since the last search
+** (PRAGMA data_version ignores this connection's own commits, which
+** invalidate entries directly). On error the cache is bypassed.
+**
+** Every search starts here, so it also picks up an INT8 range another
+** handle derived since this one opened (see diskann_prepare_quant_range()).
+*/
+static BlobCache *read_cache_for_search(DiskAnnIndex *idx) {
+  BlobCache *cache = idx->read_cache;
+  sqlite3_stmt *stmt = NULL;
+  (void)diskann_prepare_quant_range(idx, NULL, 0);
+  if (!cache) {
+    return NULL;
+  }
+
+  stmt = diskann_stmt(idx, DISKANN_STMT_DATA_VERSION);
+  if (!stmt) {
+    return NULL;
+  }
+  if (sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_reset(stmt);
+    return NULL;
+  }
+  int64_t version = sqlite3_column_int64(stmt, 0);
+  sqlite3_reset(stmt);
+
+  if (version != idx->read_cache_data_version) {
+    blob_cache_clear(cache);
+    idx->read_cache_data_version = version;
+  }
+  return cache;
+}
+
+/*
+** Blocks at least this large are read partially when there is no read
+** cache: adjacency first, then only the vectors the search scores. Below
+** it, one full read is cheaper than several small ones.
+*/
+#define PARTIAL_READ_MIN_BLOCK_SIZE 8192
+
+/*
+** READONLY block load. A snapshot handle points the reusable spot at the
+** mapped block. Otherwise serves rowid from the read cache when possible,
+** otherwise reads it through the reusable handle (created on first use)
+** and caches a handle-less copy. *hit receives the cache reference on a
+** hit (release with blob_spot_free()); *out points at the loaded block.
+**
+** Without a cache, large blocks are loaded partially (node metadata and
+** edge metadata only); callers fetch vectors with node_bin_load_vector()
+** and node_bin_load_edge_vector() before touching them.
+**
+** Copies are not cached inside a write transaction: a rollback would
+** leave them stale.
+*/
+static int read_block(DiskAnnIndex *idx, BlobCache *cache, uint64_t rowid,
+                      BlobSpot **reusable, BlobSpot **hit, BlobSpot **out) {
+  int rc;
+
+  if (idx->snapshot) {
+    *hit = NULL; /* the mapping needs no cache */
+    rc = diskann_snapshot_load(idx->snapshot, rowid, reusable);
+    *out = *reusable;
+    return rc;
+  }
+
+  *hit = blob_cache_get(cache, rowid);
+  if (*hit) {
+    *out = *hit;
+    return DISKANN_OK;
+  }
+
+  if (*reusable == NULL) {
+    rc = blob_spot_create(idx, reusable, rowid, idx->block_size,
+                          DISKANN_BLOB_READONLY);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  if (!cache && idx->block_size >= PARTIAL_READ_MIN_BLOCK_SIZE) {
+    rc = node_bin_load_adjacency(idx, *reusable, rowid);
+    *out = *reusable;
+    return rc;
+  }
+
+  rc = blob_spot_reload(idx, *reusable, rowid, idx->block_size);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+
+  if (cache && sqlite3_txn_state(idx->db, idx->db_name) != SQLITE_TXN_WRITE) {
+    BlobSpot *copy = NULL;
+    if (blob_spot_copy(*reusable, &copy) == DISKANN_OK) {
+      blob_cache_put(cache, rowid, copy); /* best effort on NOMEM */
+      blob_cache_release(cache, copy);
+    }
+  }
+  *out = *reusable;
+  return DISKANN_OK;
+}
+
+/*
+** Close the reusable spot's handle between searches (an open handle would
+** keep the read transaction alive) but keep it and its buffer for the next
+** query. The buffer is marked stale: the row may change before then.
+*/
+static void park_read_blob(BlobSpot *spot) {
+  if (spot && spot->pBlob) {
+    sqlite3_blob_close(spot->pBlob);
+    spot->pBlob = NULL;
+    spot->is_aborted = 1;
+    spot->is_initialized = 0;
+  }
+}
+
+/**************************************************************************
+** Core beam search
+**************************************************************************/
+
+/*
+** Load the block of a hop slot's node into slot->block. READONLY slots
+** read through their own reusable spot (see read_block()); WRITABLE nodes
+** keep a pooled spot of their own (see blob_spot_load()), shared through
+** the cache.
+*/
+static int load_hop_slot(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                         BlobCache *cache, DiskAnnHopSlot *slot) {
+  DiskAnnNode *node = slot->node;
+  int rc = DISKANN_OK;
+
+  if (ctx->blob_mode == DISKANN_BLOB_READONLY) {
+    return read_block(idx, cache, node->rowid, &slot->spot, &slot->hit,
+                      &slot->block);
+  }
+
+  /* Check cache first (WRITABLE mode during insert) */
+  if (cache && node->blob_spot == NULL) {
+    node->blob_spot = blob_cache_get(cache, node->rowid);
+  }
+
+  if (node->blob_spot == NULL) {
+    rc = blob_spot_load(idx, &node->blob_spot, node->rowid);
+
+    /* Add to cache on miss */
+    if (rc == DISKANN_OK && cache) {
+      blob_cache_put(cache, node->rowid, node->blob_spot);
+    }
+  }
+  slot->block = node->blob_spot;
+  return rc;
+}
+
+/* Drop the hop's cache references and any nodes it did not visit */
+static void release_hop(DiskAnnSearchCtx *ctx, BlobCache *cache, int n_hop) {
+  for (int i = 0; i < n_hop; i++) {
+    DiskAnnHopSlot *slot = &ctx->hop[i];
+    blob_cache_release(cache, slot->hit);
+    slot->hit = NULL;
+    slot->block = NULL;
+    if (slot->node && !slot->node->visited) {
+      search_ctx_delete_candidate(ctx, slot->node);
+    }
+    slot->node = NULL;
+  }
+}
+
+/* Score a loaded node's edges and queue those that enter the beam */
+static int expand_node(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                       BlobSpot *block) {
+  int n_edges = node_bin_edges(idx, block);
+  /* A full beam rejects anything >= its furthest distance, so scoring may
+  ** stop there; streaming spills keep rejected distances and need them
+  ** exact. */
+  float bound = ctx->n_candidates >= ctx->max_candidates && !ctx->streaming
+                    ? ctx->distances[0]
+                    : INFINITY;
+  for (int i = 0; i < n_edges; i++) {
+    uint64_t edge_rowid;
+    node_bin_edge(idx, block, i, &edge_rowid, NULL, NULL);
+
+    if (search_ctx_is_seen(ctx, edge_rowid)) {
+      continue;
+    }
+    /* A label-restricted walk stays inside the label's subgraph */
+    if (ctx->label != DISKANN_LABEL_NONE &&
+        diskann_labels_get(idx->labels, (int64_t)edge_rowid) != ctx->label) {
+      continue;
+    }
+
+    /* Score from the in-RAM PQ code when there is one; nodes without a
+    ** code fall back to the edge vector stored in this block */
+    const uint8_t *code =
+        ctx->pq_table ? diskann_pq_get(idx->pq, (int64_t)edge_rowid) : NULL;
+    if (!code) {
+      int rc = node_bin_load_edge_vector(idx, block, i);
+      if (rc != DISKANN_OK) {
+        return rc;
+      }
+    }
+    float edge_distance =
+        code ? diskann_pq_table_distance(idx->pq, ctx->pq_table, code)
+             : diskann_edge_distance_bounded(
+                   idx, ctx->query, ctx->query_inv_norm,
+                   node_bin_edge_data(idx, block, i),
+                   node_bin_edge_inv_norm(idx, block, i), bound);
+    if (!search_ctx_should_add(ctx, edge_distance)) {
+      if (ctx->streaming) {
+        search_ctx_spill(ctx, edge_rowid, edge_distance);
       }
-      candidate_blob = candidate->blob_spot;
+      continue;
     }
 
-    if (rc == DISKANN_ROW_NOT_FOUND) {
-      /* Zombie edge — deleted node. Remove candidate and continue. */
-      search_ctx_delete_candidate(ctx, i_candidate);
+    DiskAnnNode *new_candidate = search_ctx_node_alloc(ctx, edge_rowid);
+    if (new_candidate == NULL) {
       continue;
-    } else if (rc != DISKANN_OK) {
-      goto out;
     }
 
-    /* Float32-only: no pNode != pEdge recalculation needed */
-    search_ctx_mark_visited(ctx, candidate, distance);
+    (void)search_ctx_insert_candidate(ctx, new_candidate, edge_distance);
+  }
+  return DISKANN_OK;
+}
 
-    int n_edges = node_bin_edges(idx, candidate_blob);
-    for (int i = 0; i < n_edges; i++) {
-      uint64_t edge_rowid;
-      const float *edge_vector;
-      node_bin_edge(idx, candidate_blob, i, &edge_rowid, NULL, &edge_vector);
+/* Nodes expanded per hop: see diskann_set_beam_width() */
+static int search_ctx_hop_width(const DiskAnnIndex *idx,
+                                const DiskAnnSearchCtx *ctx) {
+  if (ctx->blob_mode == DISKANN_BLOB_READONLY && idx->beam_width > 1) {
+    return (int)idx->beam_width;
+  }
+  return 1;
+}
 
-      if (search_ctx_is_visited(ctx, edge_rowid) ||
-          search_ctx_has_candidate(ctx, edge_rowid)) {
-        continue;
-      }
+/* Close the READONLY hop handles between walks (see park_read_blob()) */
+static void search_ctx_park(DiskAnnSearchCtx *ctx) {
+  for (int i = 0; i < ctx->cap_hop; i++) {
+    park_read_blob(ctx->hop[i].spot);
+  }
+}
 
-      float edge_distance = diskann_distance(ctx->query, edge_vector,
-                                             idx->dimensions, idx->metric);
-      int insert_idx = search_ctx_should_add(ctx, edge_distance);
-      if (insert_idx < 0) {
-        continue;
+/*
+** Expand the closest unvisited candidates, a hop at a time, until the
+** beam holds none or the top-K converged. Shared by the first walk from
+** a start node and by resumed walks (diskann_search_stream_next()).
+*/
+static int search_ctx_walk(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                           BlobCache *cache) {
+  int width = search_ctx_hop_width(idx, ctx);
+  int n_hop = 0;
+  int rc = search_ctx_reserve_hop(ctx, width);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  while (search_ctx_has_unvisited(ctx) && !search_ctx_converged(ctx)) {
+    DiskAnnHopSlot *hop = ctx->hop;
+    int order[DISKANN_MAX_BEAM_WIDTH];
+
+    /* Take the closest unvisited candidates, closest first */
+    for (n_hop = 0; n_hop < width && search_ctx_has_unvisited(ctx); n_hop++) {
+      search_ctx_take_candidate(ctx, &hop[n_hop].node, &hop[n_hop].distance);
+      order[n_hop] = n_hop;
+    }
+
+    /* Fetch their blocks in rowid order, for B-tree locality */
+    for (int i = 1; i < n_hop; i++) {
+      int o = order[i];
+      int j = i;
+      for (; j > 0 && hop[order[j - 1]].node->rowid > hop[o].node->rowid;
+           j--) {
+        order[j] = order[j - 1];
+      }
+      order[j] = o;
+    }
+    for (int i = 0; i < n_hop; i++) {
+      DiskAnnHopSlot *slot = &hop[order[i]];
+      rc = load_hop_slot(idx, ctx, cache, slot);
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        /* Zombie edge — deleted node. Remove candidate and continue. */
+        idx->counters.zombie_edges++;
+        search_ctx_delete_candidate(ctx, slot->node);
+        slot->node = NULL;
+      } else if (rc != DISKANN_OK) {
+        goto out;
       }
+    }
 
-      DiskAnnNode *new_candidate = diskann_node_alloc(edge_rowid);
-      if (new_candidate == NULL) {
+    /* Visit every loaded node before scoring edges: visited nodes are
+    ** never freed by beam eviction */
+    for (int i = 0; i < n_hop; i++) {
+      DiskAnnHopSlot *slot = &hop[i];
+      if (!slot->node) {
         continue;
       }
+      /* Quantized edges and PQ codes only approximate the distance;
+      ** rerank with the node's own float32 vector now that its block is
+      ** loaded, so top-K results carry exact distances */
+      if (idx->edge_type != DISKANN_EDGE_FLOAT32 || ctx->pq_table) {
+        rc = node_bin_load_vector(idx, slot->block);
+        if (rc != DISKANN_OK) {
+          goto out;
+        }
+        slot->distance = diskann_vector_distance(
+            idx, ctx->query, ctx->query_inv_norm,
+            node_bin_vector_data(idx, slot->block),
+            node_bin_inv_norm(idx, slot->block));
+      }
+      search_ctx_mark_visited(ctx, slot->node, slot->distance,
+                              diskann_node_is_live(idx, slot->block));
+    }
 
-      search_ctx_insert_candidate(ctx, insert_idx, new_candidate,
-                                  edge_distance);
+    for (int i = 0; i < n_hop; i++) {
+      if (hop[i].node) {
+        rc = expand_node(idx, ctx, hop[i].block);
+        if (rc != DISKANN_OK) {
+          goto out;
+        }
+      }
     }
+
+    release_hop(ctx, cache, n_hop);
+    n_hop = 0;
   }
 
   rc = DISKANN_OK;
 
 out:
-  if (start != NULL) {
-    diskann_node_free(start);
+  release_hop(ctx, cache, n_hop);
+  search_ctx_park(ctx);
+  return rc;
+}
+
+int diskann_search_internal(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                            uint64_t start_rowid, BlobCache *cache) {
+  DiskAnnNode *start = NULL;
+  BlobSpot *cache_hit = NULL;
+  BlobSpot *start_blob;
+  int rc = search_ctx_reserve_hop(ctx, search_ctx_hop_width(idx, ctx));
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+
+  start = search_ctx_node_alloc(ctx, start_rowid);
+  if (start == NULL) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto out;
+  }
+
+  if (ctx->blob_mode == DISKANN_BLOB_READONLY) {
+    /* READONLY: nodes hold no blob; hop slots reuse one handle each
+    ** across candidates and the cache (if any) keeps block copies */
+    rc = read_block(idx, cache, start_rowid, &ctx->hop[0].spot, &cache_hit,
+                    &start_blob);
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+  } else {
+    /* Check cache for start node */
+    if (cache) {
+      start->blob_spot = blob_cache_get(cache, start_rowid);
+    }
+
+    if (start->blob_spot == NULL) {
+      rc = blob_spot_load(idx, &start->blob_spot, start_rowid);
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+
+      /* Add to cache on miss */
+      if (cache) {
+        blob_cache_put(cache, start_rowid, start->blob_spot);
+      }
+    }
+    start_blob = start->blob_spot;
+  }
+
+  rc = node_bin_load_vector(idx, start_blob);
+  if (rc != DISKANN_OK) {
+    goto out;
+  }
+  float start_distance = diskann_vector_distance(
+      idx, ctx->query, ctx->query_inv_norm,
+      node_bin_vector_data(idx, start_blob),
+      node_bin_inv_norm(idx, start_blob));
+  blob_cache_release(cache, cache_hit);
+  cache_hit = NULL;
+
+  /* Transfer ownership of start node to the search context */
+  rc = search_ctx_insert_candidate(ctx, start, start_distance);
+  start = NULL;
+  if (rc != DISKANN_OK) {
+    goto out;
   }
-  if (reusable_blob != NULL) {
-    blob_spot_free(reusable_blob);
+
+  return search_ctx_walk(idx, ctx, cache);
+
+out:
+  if (start != NULL) {
+    search_ctx_node_free(ctx, start);
   }
+  blob_cache_release(cache, cache_hit);
+  search_ctx_park(ctx);
   return rc;
 }
 
+int diskann_search_from(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                        uint64_t start_rowid, BlobCache *cache) {
+  int rc = diskann_search_internal(idx, ctx, start_rowid, cache);
+  if (rc != DISKANN_ROW_NOT_FOUND || !idx->has_entry ||
+      start_rowid != (uint64_t)idx->entry_rowid) {
+    return rc;
+  }
+
+  /* Stale entry point: forget it (the next refresh persists a new one) and
+  ** restart from a random row. The failed start never entered ctx. */
+  idx->has_entry = 0;
+  rc = diskann_select_random_shadow_row(idx, &start_rowid);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  return diskann_search_internal(idx, ctx, start_rowid, cache);
+}
+
 /**************************************************************************
 ** Dynamic search list size scaling
 **
@@ -591,6 +1467,11 @@ out:
 **
 ** Uses MAX(rowid) as a fast O(log n) proxy for row count — overestimates
 ** when there are gaps from deletes, which is the safe direction (wider beam).
+**
+** A calibrated index (diskann_calibrate()) sizes the beam from its
+** measured recall curve instead, unless the query sets search_list_size.
+** Growth since calibration is measured in MAX(rowid) on both sides, so
+** rowid gaps cancel out.
 **************************************************************************/
 
 /*
@@ -602,37 +1483,66 @@ static int64_t refresh_max_rowid(DiskAnnIndex *idx) {
   sqlite3_stmt *stmt = NULL;
   int64_t max_rowid = 0;
 
-  char *sql = sqlite3_mprintf("SELECT MAX(rowid) FROM \"%w\".%s", idx->db_name,
-                              idx->shadow_name);
-  if (!sql)
-    return 0;
-
-  int rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, 0);
-  sqlite3_free(sql);
-  if (rc != SQLITE_OK)
+  stmt = diskann_stmt(idx, DISKANN_STMT_MAX_ROWID);
+  if (!stmt)
     return 0;
 
   if (sqlite3_step(stmt) == SQLITE_ROW) {
     max_rowid = sqlite3_column_int64(stmt, 0);
   }
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
   idx->cached_max_rowid = max_rowid;
   return max_rowid;
 }
 
+/*
+** Beam size for recall@k >= target on curve: the smallest measured size
+** reaching it (the largest when none does), widened by sqrt(n / rows)
+** for growth since calibration and by k / curve->k for a larger k,
+** and never below k.
+*/
+static int calibrated_search_list_size(const DiskAnnRecallCurve *curve,
+                                       float target, int64_t n, int k) {
+  int i = 0;
+  while (i < curve->n_points - 1 && curve->recall[i] < target) {
+    i++;
+  }
+  double size = curve->search_list_size[i];
+  if (n > curve->rows) {
+    size *= sqrt((double)n / (double)curve->rows);
+  }
+  if (k > 0 && (uint32_t)k > curve->k) {
+    size *= (double)k / curve->k;
+  }
+  if (size > INT_MAX) {
+    return INT_MAX;
+  }
+  int beam = (int)ceil(size);
+  return beam > k ? beam : k;
+}
+
 #ifdef TESTING
 int
 #else
 static int
 #endif
-effective_search_list_size(DiskAnnIndex *idx) {
-  int configured = (int)idx->search_list_size;
+effective_search_list_size(DiskAnnIndex *idx,
+                           const DiskAnnSearchParams *params, int k) {
+  int configured = params && params->search_list_size
+                       ? (int)params->search_list_size
+                       : (int)idx->search_list_size;
 
   /* Use cached value, refresh from DB on first call */
   int64_t n = idx->cached_max_rowid;
   if (n <= 0) {
     n = refresh_max_rowid(idx);
   }
+  if (idx->recall.n_points > 0 && !(params && params->search_list_size)) {
+    float target = params && params->recall_target > 0.0f
+                       ? params->recall_target
+                       : idx->recall.target;
+    return calibrated_search_list_size(&idx->recall, target, n, k);
+  }
   if (n <= 0)
     return configured;
 
@@ -640,76 +1550,401 @@ effective_search_list_size(DiskAnnIndex *idx) {
   return scaled > configured ? scaled : configured;
 }
 
+/* DiskAnnSearchParams.patience, 0 without params */
+static uint32_t search_patience(const DiskAnnSearchParams *params) {
+  return params ? params->patience : 0;
+}
+
 /**************************************************************************
-** Public search API
+** Exact scan
+**
+** Small indexes and small filter sets are answered by scoring every
+** candidate row instead of walking the graph: the scan streams rows in
+** rowid order, reads only each block's node header and vector (never its
+** edge slots), and keeps each query's k closest rows in a bounded
+** max-heap. Blocks already in the read cache are scored from memory; the
+** scan adds none. Several queries share one pass over the rows.
 **************************************************************************/
 
-int diskann_search(DiskAnnIndex *idx, const float *query, uint32_t dims, int k,
-                   DiskAnnResult *results) {
-  DiskAnnSearchCtx ctx;
-  uint64_t start_rowid = 0;
-  int rc;
-
-  /* Validate inputs */
-  if (!idx)
-    return DISKANN_ERROR_INVALID;
-  if (!query)
-    return DISKANN_ERROR_INVALID;
-  if (!results)
-    return DISKANN_ERROR_INVALID;
-  if (k < 0)
-    return DISKANN_ERROR_INVALID;
-  if (dims != idx->dimensions)
-    return DISKANN_ERROR_DIMENSION;
-  if (k == 0)
-    return 0;
+/* Restore the max-heap property (largest distance on top) below heap[i] */
+static void topk_sift_down(DiskAnnResult *heap, int n, int i) {
+  for (;;) {
+    int largest = i;
+    int l = 2 * i + 1, r = l + 1;
+    if (l < n && heap[l].distance > heap[largest].distance)
+      largest = l;
+    if (r < n && heap[r].distance > heap[largest].distance)
+      largest = r;
+    if (largest == i)
+      return;
+    DiskAnnResult tmp = heap[i];
+    heap[i] = heap[largest];
+    heap[largest] = tmp;
+    i = largest;
+  }
+}
 
-  /* Find a random start node */
-  rc = diskann_select_random_shadow_row(idx, &start_rowid);
-  if (rc == SQLITE_DONE) {
-    /* Empty table — return 0 results */
-    return 0;
+/* Offer a row to a max-heap of at most k results, n of them used */
+static void topk_push(DiskAnnResult *heap, int *n, int k, int64_t rowid,
+                      float distance) {
+  if (*n == k) {
+    if (distance >= heap[0].distance)
+      return;
+    heap[0].id = rowid;
+    heap[0].distance = distance;
+    topk_sift_down(heap, k, 0);
+    return;
   }
-  if (rc != DISKANN_OK) {
-    return DISKANN_ERROR;
+  int i = (*n)++;
+  while (i > 0 && heap[(i - 1) / 2].distance < distance) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
   }
+  heap[i].id = rowid;
+  heap[i].distance = distance;
+}
 
-  /* Scale search beam width based on index size */
-  int search_list = effective_search_list_size(idx);
+/* Heapsort a max-heap in place into ascending distance order */
+static void topk_sort(DiskAnnResult *heap, int n) {
+  for (int end = n - 1; end > 0; end--) {
+    DiskAnnResult tmp = heap[0];
+    heap[0] = heap[end];
+    heap[end] = tmp;
+    topk_sift_down(heap, end, 0);
+  }
+}
 
-  /* Initialize search context */
-  rc = diskann_search_ctx_init(&ctx, query, search_list, k,
-                               DISKANN_BLOB_READONLY);
+/*
+** Score rows for n_queries queries, k results each into results[q * k]
+** with their counts in counts[q]. Scans the rows of filter when given,
+** otherwise every row of the shadow table (or snapshot) that filter_fn (if
+** any) accepts.
+** Rows without a block (attribute rows of deleted vectors) and tombstoned
+** or queued-for-deletion rows are skipped.
+** Returns DISKANN_OK or a negative error code.
+*/
+static int exact_scan(DiskAnnIndex *idx, const float *queries, int n_queries,
+                      int k, DiskAnnResult *results, int *counts,
+                      const DiskAnnBitmap *filter, DiskAnnFilterFn filter_fn,
+                      void *filter_ctx) {
+  BlobCache *cache = read_cache_for_search(idx);
+  sqlite3_stmt *stmt = NULL;
+  BlobSpot *spot = NULL;
+  BlobSpot *hit = NULL;
+  float one_norm = 0.0f;
+  float *inv_norms = &one_norm;
+  DiskAnnBitmapIter it;
+  const DiskAnnSnapshot *snap = idx->snapshot;
+  uint64_t next = 0;
+  int64_t rowid;
+  int rc = DISKANN_OK;
+
+  for (int q = 0; q < n_queries; q++) {
+    counts[q] = 0;
+  }
+  if (n_queries > 1) {
+    inv_norms = (float *)sqlite3_malloc64((uint64_t)n_queries * sizeof(float));
+    if (!inv_norms) {
+      return DISKANN_ERROR_NOMEM;
+    }
+  }
+  for (int q = 0; q < n_queries; q++) {
+    inv_norms[q] = idx->metric == DISKANN_METRIC_COSINE
+                       ? diskann_index_inv_norm(
+                             idx, queries + (size_t)q * idx->dimensions)
+                       : 0.0f;
+  }
+
+  if (filter) {
+    diskann_bitmap_iter_init(&it, filter);
+  } else if (!snap) {
+    char *sql =
+        sqlite3_mprintf("SELECT id FROM \"%w\".\"%w\" ORDER BY id",
+                        idx->db_name, idx->shadow_name);
+    if (!sql) {
+      rc = DISKANN_ERROR_NOMEM;
+      goto out;
+    }
+    int sqlite_rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+    sqlite3_free(sql);
+    if (sqlite_rc != SQLITE_OK) {
+      rc = DISKANN_ERROR;
+      goto out;
+    }
+  }
+
+  for (;;) {
+    if (filter) {
+      if (!diskann_bitmap_next(&it, &rowid))
+        break;
+    } else if (snap) {
+      if (next == snap->n_rows)
+        break;
+      rowid = snap->rowids[next++];
+      if (filter_fn && !filter_fn(rowid, filter_ctx))
+        continue;
+    } else {
+      int step = sqlite3_step(stmt);
+      if (step == SQLITE_DONE)
+        break;
+      if (step != SQLITE_ROW) {
+        rc = DISKANN_ERROR;
+        goto out;
+      }
+      rowid = sqlite3_column_int64(stmt, 0);
+      if (filter_fn && !filter_fn(rowid, filter_ctx))
+        continue;
+    }
+
+    /* Node header (inverse norm) and vector only */
+    const BlobSpot *block = hit = blob_cache_get(cache, (uint64_t)rowid);
+    if (snap) {
+      rc = diskann_snapshot_load(snap, (uint64_t)rowid, &spot);
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        rc = DISKANN_OK;
+        continue;
+      }
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+      block = spot;
+    } else if (!hit) {
+      if (spot) {
+        rc = blob_spot_seek(idx, spot, (uint64_t)rowid);
+      } else {
+        rc = blob_spot_create(idx, &spot, (uint64_t)rowid, idx->block_size,
+                              DISKANN_BLOB_READONLY);
+        if (rc == DISKANN_OK) {
+          rc = blob_spot_seek(idx, spot, (uint64_t)rowid);
+        }
+      }
+      if (rc == DISKANN_ROW_NOT_FOUND) {
+        rc = DISKANN_OK;
+        continue;
+      }
+      if (rc == DISKANN_OK) {
+        rc = blob_spot_read_range(idx, spot, 0,
+                                  NODE_METADATA_SIZE + idx->nNodeVectorSize);
+      }
+      if (rc != DISKANN_OK) {
+        goto out;
+      }
+      block = spot;
+    }
+
+    if (!diskann_node_is_live(idx, block)) {
+      blob_cache_release(cache, hit);
+      hit = NULL;
+      continue;
+    }
+    const uint8_t *vector = node_bin_vector_data(idx, block);
+    float inv_norm = node_bin_inv_norm(idx, block);
+    for (int q = 0; q < n_queries; q++) {
+      /* A full top-k rejects anything >= its furthest distance */
+      DiskAnnResult *heap = results + (size_t)q * (size_t)k;
+      float bound = counts[q] == k ? heap[0].distance : INFINITY;
+      float distance = diskann_vector_distance_bounded(
+          idx, queries + (size_t)q * idx->dimensions, inv_norms[q], vector,
+          inv_norm, bound);
+      topk_push(results + (size_t)q * (size_t)k, &counts[q], k, rowid,
+                distance);
+    }
+    blob_cache_release(cache, hit);
+    hit = NULL;
+  }
+
+  for (int q = 0; q < n_queries; q++) {
+    topk_sort(results + (size_t)q * (size_t)k, counts[q]);
+  }
+
+out:
+  blob_cache_release(cache, hit);
+  if (spot) {
+    blob_spot_free(spot);
+  }
+  sqlite3_finalize(stmt);
+  if (inv_norms != &one_norm) {
+    sqlite3_free(inv_norms);
+  }
+  return rc;
+}
+
+/*
+** Should an unfiltered search scan idx instead of walking its graph? See
+** diskann_set_exact_scan_threshold(), unless params decides.
+*/
+static int plan_exact_scan(DiskAnnIndex *idx,
+                           const DiskAnnSearchParams *params) {
+  if (params && params->exact != DISKANN_SEARCH_AUTO) {
+    return params->exact == DISKANN_SEARCH_EXACT;
+  }
+  int64_t n = idx->cached_max_rowid;
+  if (n <= 0) {
+    n = refresh_max_rowid(idx);
+  }
+  /* MAX(rowid) overestimates the row count: gaps favor the graph */
+  return n > 0 && (uint64_t)n <= idx->exact_scan_max_rows;
+}
+
+/* One exact-scan query: the result count or a negative error code */
+static int exact_scan_one(DiskAnnIndex *idx, const float *query, int k,
+                          DiskAnnResult *results, const DiskAnnBitmap *filter,
+                          DiskAnnFilterFn filter_fn, void *filter_ctx) {
+  int n = 0;
+  int rc = exact_scan(idx, query, 1, k, results, &n, filter, filter_fn,
+                      filter_ctx);
+  return rc == DISKANN_OK ? n : rc;
+}
+
+int diskann_search_exact(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                         int k, DiskAnnResult *results,
+                         DiskAnnFilterFn filter_fn, void *filter_ctx) {
+  if (!idx || !query || !results)
+    return DISKANN_ERROR_INVALID;
+  if (k < 0)
+    return DISKANN_ERROR_INVALID;
+  if (dims != idx->dimensions)
+    return DISKANN_ERROR_DIMENSION;
+  if (k == 0)
+    return 0;
+  diskann_reader_sync(idx);
+  uint64_t start = diskann_clock_us();
+  int n = exact_scan_one(idx, query, k, results, NULL, filter_fn, filter_ctx);
+  if (n >= 0) {
+    diskann_stats_searches(idx, diskann_clock_us() - start, 1);
+  }
+  return n;
+}
+
+int diskann_search_exact_multi(DiskAnnIndex *idx, const float *queries,
+                               int n_queries, uint32_t dims, int k,
+                               DiskAnnResult *results, int *n_results,
+                               const DiskAnnBitmap *filter) {
+  if (!idx || !queries || !results || !n_results)
+    return DISKANN_ERROR_INVALID;
+  if (n_queries < 0 || k < 0)
+    return DISKANN_ERROR_INVALID;
+  if (dims != idx->dimensions)
+    return DISKANN_ERROR_DIMENSION;
+  if (n_queries == 0 || k == 0 || (filter && filter->count == 0)) {
+    for (int q = 0; q < n_queries; q++) {
+      n_results[q] = 0;
+    }
+    return DISKANN_OK;
+  }
+  diskann_reader_sync(idx);
+  uint64_t start = diskann_clock_us();
+  int rc = exact_scan(idx, queries, n_queries, k, results, n_results, filter,
+                      NULL, NULL);
+  if (rc == DISKANN_OK) {
+    diskann_stats_searches(idx, diskann_clock_us() - start, n_queries);
+  }
+  return rc;
+}
+
+/**************************************************************************
+** Public search API
+**************************************************************************/
+
+/*
+** Beam search for one validated query from start_rowid through cache,
+** copying up to k results; patience as DiskAnnSearchParams.patience.
+** Returns the result count or a negative error code.
+*/
+static int search_knn(DiskAnnIndex *idx, const float *query, int k,
+                      int search_list, uint32_t patience, uint64_t start_rowid,
+                      BlobCache *cache, DiskAnnResult *results) {
+  DiskAnnSearchCtx *ctx = NULL;
+
+  /* Borrow the index's pooled search context */
+  int rc = diskann_search_ctx_acquire(idx, &ctx, query, search_list, k);
   if (rc != DISKANN_OK) {
     return rc;
   }
-  /* Run beam search (no cache for read-only user queries) */
-  rc = diskann_search_internal(idx, &ctx, start_rowid, NULL);
+  ctx->patience = patience;
+  rc = diskann_search_from(idx, ctx, start_rowid, cache);
   if (rc != DISKANN_OK) {
-    diskann_search_ctx_deinit(&ctx);
-    return rc;
+    diskann_search_ctx_release(idx, ctx);
+    return rc == SQLITE_DONE ? 0 : rc;
   }
+  diskann_stats_walk(idx, ctx->n_visited);
 
   /* Copy top-K results to caller's array */
-  int n_results = k < ctx.n_top_candidates ? k : ctx.n_top_candidates;
+  int n_results = k < ctx->n_top_candidates ? k : ctx->n_top_candidates;
   for (int i = 0; i < n_results; i++) {
-    results[i].id = (int64_t)ctx.top_candidates[i]->rowid;
-    results[i].distance = ctx.top_distances[i];
+    results[i].id = (int64_t)ctx->top_candidates[i]->rowid;
+    results[i].distance = ctx->top_distances[i];
   }
 
-  diskann_search_ctx_deinit(&ctx);
+  diskann_search_ctx_release(idx, ctx);
+  return n_results;
+}
+
+int diskann_search_graph_knn(DiskAnnIndex *idx, const float *query, int k,
+                             int search_list, DiskAnnResult *results) {
+  uint64_t start_rowid = 0;
+  diskann_reader_sync(idx);
+  int rc = diskann_select_start_row(idx, &start_rowid);
+  if (rc == SQLITE_DONE) {
+    return 0;
+  }
+  if (rc != DISKANN_OK) {
+    return DISKANN_ERROR;
+  }
+  return search_knn(idx, query, k, search_list, 0, start_rowid,
+                    read_cache_for_search(idx), results);
+}
+
+/*
+** Filtered beam search from start_rowid into results, optionally expanding
+** only nodes carrying label. Returns the result count (0 for an index
+** found empty) or a negative error code.
+*/
+static int search_filtered_from(DiskAnnIndex *idx, const float *query, int k,
+                                int max_candidates, uint32_t patience,
+                                uint64_t start_rowid, uint32_t label,
+                                DiskAnnFilterFn filter_fn, void *filter_ctx,
+                                DiskAnnResult *results) {
+  DiskAnnSearchCtx *ctx = NULL;
+
+  /* Borrow the pooled search context and attach the filter */
+  int rc = diskann_search_ctx_acquire(idx, &ctx, query, max_candidates, k);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  ctx->filter_fn = filter_fn;
+  ctx->filter_ctx = filter_ctx;
+  ctx->label = label;
+  ctx->patience = patience;
+
+  /* Run beam search */
+  rc = diskann_search_from(idx, ctx, start_rowid, read_cache_for_search(idx));
+  if (rc != DISKANN_OK) {
+    diskann_search_ctx_release(idx, ctx);
+    return rc == SQLITE_DONE ? 0 : rc;
+  }
+  diskann_stats_walk(idx, ctx->n_visited);
+
+  /* Copy top-K results to caller's array */
+  int n_results = k < ctx->n_top_candidates ? k : ctx->n_top_candidates;
+  for (int i = 0; i < n_results; i++) {
+    results[i].id = (int64_t)ctx->top_candidates[i]->rowid;
+    results[i].distance = ctx->top_distances[i];
+  }
 
+  diskann_search_ctx_release(idx, ctx);
   return n_results;
 }
 
-int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
-                            uint32_t dims, int k, DiskAnnResult *results,
-                            DiskAnnFilterFn filter_fn, void *filter_ctx) {
-  DiskAnnSearchCtx ctx;
+/* diskann_search_ex() without the latency sample */
+static int search_one(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                      int k, const DiskAnnSearchParams *params,
+                      DiskAnnResult *results, DiskAnnFilterFn filter_fn,
+                      void *filter_ctx) {
   uint64_t start_rowid = 0;
   int rc;
 
-  /* Same validation as diskann_search() */
+  /* Validate inputs */
   if (!idx)
     return DISKANN_ERROR_INVALID;
   if (!query)
@@ -722,50 +1957,678 @@ int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
     return DISKANN_ERROR_DIMENSION;
   if (k == 0)
     return 0;
-
-  /* NULL filter → fall through to unfiltered search */
-  if (!filter_fn) {
-    return diskann_search(idx, query, dims, k, results);
+  diskann_reader_sync(idx);
+  if (plan_exact_scan(idx, params)) {
+    return exact_scan_one(idx, query, k, results, NULL, filter_fn,
+                          filter_ctx);
   }
 
-  /* Find a random start node */
-  rc = diskann_select_random_shadow_row(idx, &start_rowid);
+  /* Start from the entry point (random row if none yet) */
+  rc = diskann_select_start_row(idx, &start_rowid);
   if (rc == SQLITE_DONE) {
-    return 0; /* Empty table */
+    /* Empty table — return 0 results */
+    return 0;
   }
   if (rc != DISKANN_OK) {
     return DISKANN_ERROR;
   }
 
-  /* Scale beam based on index size, then widen for filtered-out candidates */
-  uint32_t base_beam = (uint32_t)effective_search_list_size(idx);
-  uint32_t beam = base_beam * 2;
+  /* Scale search beam width based on index size, and run the beam search
+  ** through the shared read cache, if enabled */
+  int search_list = effective_search_list_size(idx, params, k);
+  if (!filter_fn) {
+    return search_knn(idx, query, k, search_list, search_patience(params),
+                      start_rowid, read_cache_for_search(idx), results);
+  }
+
+  /* Widen the beam for filtered-out candidates */
+  uint32_t beam = (uint32_t)search_list * 2;
   uint32_t k_scaled = (uint32_t)k * 4;
   int max_candidates = (int)(beam > k_scaled ? beam : k_scaled);
 
-  /* Initialize search context with filter */
-  rc = diskann_search_ctx_init(&ctx, query, max_candidates, k,
-                               DISKANN_BLOB_READONLY);
+  return search_filtered_from(idx, query, k, max_candidates,
+                              search_patience(params), start_rowid,
+                              DISKANN_LABEL_NONE, filter_fn, filter_ctx,
+                              results);
+}
+
+int diskann_search_ex(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                      int k, const DiskAnnSearchParams *params,
+                      DiskAnnResult *results, DiskAnnFilterFn filter_fn,
+                      void *filter_ctx) {
+  uint64_t start = diskann_clock_us();
+  int n = search_one(idx, query, dims, k, params, results, filter_fn,
+                     filter_ctx);
+  if (n >= 0) {
+    diskann_stats_searches(idx, diskann_clock_us() - start, 1);
+  }
+  return n;
+}
+
+int diskann_search(DiskAnnIndex *idx, const float *query, uint32_t dims, int k,
+                   DiskAnnResult *results) {
+  return diskann_search_ex(idx, query, dims, k, NULL, results, NULL, NULL);
+}
+
+int diskann_search_filtered(DiskAnnIndex *idx, const float *query,
+                            uint32_t dims, int k, DiskAnnResult *results,
+                            DiskAnnFilterFn filter_fn, void *filter_ctx) {
+  /* NULL filter → unfiltered search */
+  return diskann_search_ex(idx, query, dims, k, NULL, results, filter_fn,
+                           filter_ctx);
+}
+
+/**************************************************************************
+** Planned search over a filter bitmap
+**
+** A filter matching few rows, or any filter on an index small enough to be
+** scanned whole, is answered by scoring exactly those rows: a graph walk
+** would spend most of its hops on rejected nodes and still miss matches,
+** while the scan reads no more blocks than the walk would.
+** Broader filters walk the graph with the bitmap as the filter; when every
+** match carries one label, the walk starts at that label's entry point and
+** stays in its subgraph, where nearly every expanded node is a match.
+**************************************************************************/
+
+/* Filters with at most this many matches per beam slot are scanned... */
+#define FILTER_EXACT_ROWS_PER_BEAM_SLOT 4
+/* ...as are those matching under 1/FILTER_GRAPH_MIN_SELECTIVITY_INV of it */
+#define FILTER_GRAPH_MIN_SELECTIVITY_INV 50
+
+#ifdef TESTING
+int
+#else
+static int
+#endif
+filter_plan_exact_scan(DiskAnnIndex *idx, uint64_t n_matches,
+                       const DiskAnnSearchParams *params) {
+  uint64_t beam = (uint64_t)effective_search_list_size(idx, params, 0);
+  if (n_matches <= FILTER_EXACT_ROWS_PER_BEAM_SLOT * beam ||
+      plan_exact_scan(idx, params)) {
+    return 1;
+  }
+  /* MAX(rowid) overestimates the row count, which only favors the scan */
+  int64_t n_rows = idx->cached_max_rowid;
+  return n_rows > 0 &&
+         n_matches * FILTER_GRAPH_MIN_SELECTIVITY_INV < (uint64_t)n_rows;
+}
+
+static int bitmap_filter(int64_t rowid, void *ctx) {
+  return diskann_bitmap_contains((const DiskAnnBitmap *)ctx, rowid);
+}
+
+/*
+** Walk label's subgraph from its entry point. The beam needs no widening:
+** only other filter terms can reject the nodes it expands.
+*/
+static int search_label_subgraph(DiskAnnIndex *idx, const float *query, int k,
+                                 DiskAnnResult *results,
+                                 const DiskAnnBitmap *filter, uint32_t label,
+                                 const DiskAnnSearchParams *params) {
+  int64_t entry;
+  if (!diskann_labels_entry(idx->labels, label, &entry)) {
+    return 0;
+  }
+  int beam = effective_search_list_size(idx, params, k);
+  return search_filtered_from(idx, query, k, beam > k ? beam : k,
+                              search_patience(params), (uint64_t)entry, label,
+                              bitmap_filter, (void *)filter, results);
+}
+
+/* diskann_search_bitmap() without the latency sample */
+static int search_bitmap_one(DiskAnnIndex *idx, const float *query,
+                             uint32_t dims, int k, DiskAnnResult *results,
+                             const DiskAnnBitmap *filter, uint32_t label,
+                             const DiskAnnSearchParams *params) {
+  if (!idx || !query || !results || !filter)
+    return DISKANN_ERROR_INVALID;
+  if (k < 0)
+    return DISKANN_ERROR_INVALID;
+  if (dims != idx->dimensions)
+    return DISKANN_ERROR_DIMENSION;
+  if (k == 0 || filter->count == 0)
+    return 0;
+
+  diskann_reader_sync(idx);
+  if (filter_plan_exact_scan(idx, filter->count, params)) {
+    return exact_scan_one(idx, query, k, results, filter, NULL, NULL);
+  }
+  if (label != DISKANN_LABEL_NONE && idx->labels) {
+    /* A subgraph the walk could not fill (disconnected by deletes, or a
+    ** stale entry point) falls back to the whole graph */
+    int n = search_label_subgraph(idx, query, k, results, filter, label,
+                                  params);
+    uint64_t want = (uint64_t)k < filter->count ? (uint64_t)k : filter->count;
+    if (n >= 0 && (uint64_t)n >= want) {
+      return n;
+    }
+    if (n < 0 && n != DISKANN_ROW_NOT_FOUND) {
+      return n;
+    }
+  }
+  return search_one(idx, query, dims, k, params, results, bitmap_filter,
+                    (void *)filter);
+}
+
+int diskann_search_bitmap(DiskAnnIndex *idx, const float *query,
+                          uint32_t dims, int k, DiskAnnResult *results,
+                          const DiskAnnBitmap *filter, uint32_t label,
+                          const DiskAnnSearchParams *params) {
+  uint64_t start = diskann_clock_us();
+  int n = search_bitmap_one(idx, query, dims, k, results, filter, label,
+                            params);
+  if (n >= 0) {
+    diskann_stats_searches(idx, diskann_clock_us() - start, 1);
+  }
+  return n;
+}
+
+/**************************************************************************
+** Resumable search (DiskAnnSearchStream)
+**************************************************************************/
+
+/*
+** Drop the spent beam (every member is visited once a walk ends) and walk
+** again from the closest spilled candidates.
+*/
+static int search_ctx_resume(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                             BlobCache *cache) {
+  for (int i = 0; i < ctx->n_candidates; i++) {
+    assert(ctx->candidates[i]->visited);
+    ctx->candidates[i]->beam_idx = -1;
+  }
+  ctx->n_candidates = 0;
+
+  while (ctx->spill.n > 0 && ctx->n_candidates < ctx->max_candidates) {
+    DiskAnnResult next = result_heap_pop(&ctx->spill);
+    /* Spilled twice, or requeued already */
+    if (visited_set_state(&ctx->visited_set, (uint64_t)next.id) !=
+        VISITED_SET_SPILLED) {
+      continue;
+    }
+    DiskAnnNode *node = search_ctx_node_alloc(ctx, (uint64_t)next.id);
+    if (!node) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    int rc = search_ctx_insert_candidate(ctx, node, next.distance);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+  return search_ctx_walk(idx, ctx, cache);
+}
+
+/*
+** Reset the stream's context for a walk over label's subgraph (or the
+** whole graph for DISKANN_LABEL_NONE) and run it. Ends the stream for an
+** empty index; a label without an entry point leaves nothing to return.
+*/
+static int stream_walk(DiskAnnSearchStream *stream, uint32_t label) {
+  DiskAnnIndex *idx = stream->idx;
+  DiskAnnSearchCtx *ctx = stream->ctx;
+  uint64_t start_rowid = 0;
+  uint32_t n_visited = ctx->n_visited; /* a fallback walk adds to it */
+  int rc;
+
+  rc = diskann_search_ctx_reset(ctx, idx, stream->query,
+                                stream->max_candidates, 1,
+                                DISKANN_BLOB_READONLY);
   if (rc != DISKANN_OK) {
     return rc;
   }
-  ctx.filter_fn = filter_fn;
-  ctx.filter_ctx = filter_ctx;
+  ctx->n_visited = n_visited;
+  ctx->streaming = 1;
+  ctx->filter_fn = stream->filter ? bitmap_filter : NULL;
+  ctx->filter_ctx = (void *)stream->filter;
+  ctx->label = label;
+
+  if (label != DISKANN_LABEL_NONE) {
+    int64_t entry;
+    if (!diskann_labels_entry(idx->labels, label, &entry)) {
+      return DISKANN_OK;
+    }
+    start_rowid = (uint64_t)entry;
+  } else {
+    rc = diskann_select_start_row(idx, &start_rowid);
+    if (rc == SQLITE_DONE) {
+      stream->done = 1;
+      return DISKANN_OK;
+    }
+    if (rc != DISKANN_OK) {
+      return DISKANN_ERROR;
+    }
+  }
 
-  /* Run beam search */
-  rc = diskann_search_internal(idx, &ctx, start_rowid, NULL);
-  if (rc != DISKANN_OK) {
-    diskann_search_ctx_deinit(&ctx);
+  rc = diskann_search_from(idx, ctx, start_rowid, read_cache_for_search(idx));
+  if (rc == SQLITE_DONE) {
+    stream->done = 1;
+    return DISKANN_OK;
+  }
+  /* A stale label entry point: the fallback walks the whole graph */
+  if (rc == DISKANN_ROW_NOT_FOUND && label != DISKANN_LABEL_NONE) {
+    return DISKANN_OK;
+  }
+  return rc;
+}
+
+static int stream_open(DiskAnnIndex *idx, const float *query, uint32_t dims,
+                       int64_t limit, float max_distance,
+                       const DiskAnnBitmap *filter, uint32_t label,
+                       const DiskAnnSearchParams *params,
+                       DiskAnnSearchStream **out) {
+  DiskAnnSearchStream *stream;
+  int rc;
+
+  *out = NULL;
+  if (!idx || !query)
+    return DISKANN_ERROR_INVALID;
+  if (dims != idx->dimensions)
+    return DISKANN_ERROR_DIMENSION;
+
+  diskann_reader_sync(idx);
+  stream = (DiskAnnSearchStream *)sqlite3_malloc64(sizeof(*stream));
+  if (!stream) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(stream, 0, sizeof(*stream));
+  stream->idx = idx;
+  stream->filter = filter;
+  stream->label = idx->labels ? label : DISKANN_LABEL_NONE;
+  stream->remaining = limit < 0 ? INT64_MAX : limit;
+  stream->max_distance = max_distance;
+  stream->query = (float *)sqlite3_malloc64(dims * sizeof(float));
+  if (!stream->query) {
+    sqlite3_free(stream);
+    return DISKANN_ERROR_NOMEM;
+  }
+  memcpy(stream->query, query, dims * sizeof(float));
+  *out = stream;
+
+  if (stream->remaining == 0 || (filter && filter->count == 0)) {
+    stream->done = 1;
+    return DISKANN_OK;
+  }
+
+  /* Planned like diskann_search() / diskann_search_bitmap(): small sets
+  ** are scanned whole, up front */
+  uint64_t n_rows = filter ? filter->count : 0;
+  int exact = filter ? filter_plan_exact_scan(idx, n_rows, params)
+                     : plan_exact_scan(idx, params);
+  if (exact) {
+    if (!filter) {
+      int64_t max_rowid = idx->cached_max_rowid;
+      n_rows = (uint64_t)(max_rowid > 0 ? max_rowid : refresh_max_rowid(idx));
+    }
+    if ((uint64_t)stream->remaining < n_rows) {
+      n_rows = (uint64_t)stream->remaining;
+    }
+    if (n_rows > INT_MAX) {
+      n_rows = INT_MAX;
+    }
+    stream->started = 1;
+    if (n_rows == 0) {
+      stream->done = 1; /* empty index */
+      return DISKANN_OK;
+    }
+    stream->rows =
+        (DiskAnnResult *)sqlite3_malloc64(n_rows * sizeof(DiskAnnResult));
+    if (!stream->rows) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    rc = exact_scan(idx, stream->query, 1, (int)n_rows, stream->rows,
+                    &stream->n_rows, filter, NULL, NULL);
     return rc;
   }
 
-  /* Copy top-K results to caller's array */
-  int n_results = k < ctx.n_top_candidates ? k : ctx.n_top_candidates;
-  for (int i = 0; i < n_results; i++) {
-    results[i].id = (int64_t)ctx.top_candidates[i]->rowid;
-    results[i].distance = ctx.top_distances[i];
+  int beam = effective_search_list_size(idx, params, 0);
+  if (filter && stream->label == DISKANN_LABEL_NONE) {
+    beam *= 2; /* widened for rejected nodes, as diskann_search_filtered() */
   }
+  stream->max_candidates = beam;
+  return diskann_search_ctx_acquire(idx, &stream->ctx, stream->query, beam, 1);
+}
 
-  diskann_search_ctx_deinit(&ctx);
-  return n_results;
+int diskann_search_stream_open(DiskAnnIndex *idx, const float *query,
+                               uint32_t dims, int64_t limit,
+                               float max_distance, const DiskAnnBitmap *filter,
+                               uint32_t label,
+                               const DiskAnnSearchParams *params,
+                               DiskAnnSearchStream **out) {
+  uint64_t start = diskann_clock_us();
+  int rc = stream_open(idx, query, dims, limit, max_distance, filter, label,
+                       params, out);
+  if (*out) {
+    (*out)->busy_us += diskann_clock_us() - start;
+  }
+  return rc;
+}
+
+/*
+** Should the label walk, now spent, give way to a whole-graph walk? Only
+** while the filter has rows it did not return.
+*/
+static int stream_should_fall_back(const DiskAnnSearchStream *stream) {
+  return stream->label != DISKANN_LABEL_NONE && !stream->fell_back &&
+         stream->filter &&
+         (uint64_t)stream->emitted.count < stream->filter->count;
+}
+
+static int stream_next(DiskAnnSearchStream *stream, DiskAnnResult *row) {
+  int rc;
+
+  if (stream->rows || stream->done) {
+    if (stream->pos >= stream->n_rows ||
+        stream->rows[stream->pos].distance > stream->max_distance) {
+      stream->done = 1;
+    }
+    if (stream->done) {
+      return 0;
+    }
+    *row = stream->rows[stream->pos++];
+    return 1;
+  }
+
+  if (!stream->started) {
+    stream->started = 1;
+    if (stream->label != DISKANN_LABEL_NONE) {
+      visited_set_init(&stream->emitted, 1024);
+      if (!stream->emitted.rowids) {
+        return DISKANN_ERROR_NOMEM;
+      }
+    }
+    rc = stream_walk(stream, stream->label);
+    if (rc != DISKANN_OK) {
+      return rc;
+    }
+  }
+
+  while (!stream->done && stream->remaining > 0) {
+    DiskAnnSearchCtx *ctx = stream->ctx;
+    float frontier =
+        ctx->spill.n > 0 ? ctx->spill.items[0].distance : INFINITY;
+
+    /* A visited match no unexpanded candidate can beat */
+    if (ctx->found.n > 0 && ctx->found.items[0].distance <= frontier) {
+      DiskAnnResult next = result_heap_pop(&ctx->found);
+      if (next.distance > stream->max_distance) {
+        break; /* nothing left is closer */
+      }
+      if (stream->emitted.rowids) {
+        if (stream->fell_back) {
+          if (visited_set_contains(&stream->emitted, (uint64_t)next.id)) {
+            continue;
+          }
+        } else if (visited_set_put(&stream->emitted, (uint64_t)next.id,
+                                   VISITED_SET_VISITED) != DISKANN_OK) {
+          return DISKANN_ERROR_NOMEM;
+        }
+      }
+      stream->remaining--;
+      *row = next;
+      return 1;
+    }
+
+    if (ctx->spill.n > 0 && frontier <= stream->max_distance) {
+      rc = search_ctx_resume(stream->idx, ctx,
+                             read_cache_for_search(stream->idx));
+      if (rc != DISKANN_OK) {
+        return rc;
+      }
+      continue;
+    }
+    if (ctx->found.n == 0 && stream_should_fall_back(stream)) {
+      stream->fell_back = 1;
+      stream->max_candidates *= 2;
+      rc = stream_walk(stream, DISKANN_LABEL_NONE);
+      if (rc != DISKANN_OK) {
+        return rc;
+      }
+      continue;
+    }
+    break;
+  }
+
+  stream->done = 1;
+  return 0;
+}
+
+int diskann_search_stream_next(DiskAnnSearchStream *stream,
+                               DiskAnnResult *row) {
+  if (!stream || !row)
+    return DISKANN_ERROR_INVALID;
+
+  uint64_t start = diskann_clock_us();
+  int rc = stream_next(stream, row);
+  stream->busy_us += diskann_clock_us() - start;
+  return rc;
+}
+
+void diskann_search_stream_close(DiskAnnSearchStream *stream) {
+  if (!stream) {
+    return;
+  }
+  /* One search, timed over open and every next() */
+  if (stream->started) {
+    diskann_stats_searches(stream->idx, stream->busy_us, 1);
+    if (stream->ctx) {
+      diskann_stats_walk(stream->idx, stream->ctx->n_visited);
+    }
+  }
+  diskann_search_ctx_release(stream->idx, stream->ctx);
+  visited_set_deinit(&stream->emitted);
+  sqlite3_free(stream->rows);
+  sqlite3_free(stream->query);
+  sqlite3_free(stream);
+}
+
+/**************************************************************************
+** Batched search
+**
+** Workers split the queries round-robin. Each one searches through a
+** reader of the caller's handle (see diskann_reader_init()) bound to its
+** own read-only connection, with its own pooled search context. The
+** caller's read cache is shared under its mutex.
+**************************************************************************/
+
+typedef struct SearchBatchJob {
+  const float *queries;
+  int n_queries;
+  int k;
+  int search_list;
+  uint32_t patience;
+  uint64_t start_rowid;
+  BlobCache *cache;
+  DiskAnnResult *results;
+  int *n_results;
+} SearchBatchJob;
+
+typedef struct SearchBatchWorker {
+  const SearchBatchJob *job;
+  DiskAnnIndex idx; /* reader of the caller's handle, db owned */
+  uint32_t index;
+  uint32_t n_workers;
+  int rc;
+} SearchBatchWorker;
+
+static void search_batch_worker(void *arg) {
+  SearchBatchWorker *w = (SearchBatchWorker *)arg;
+  const SearchBatchJob *job = w->job;
+
+  for (int q = (int)w->index; q < job->n_queries; q += (int)w->n_workers) {
+    uint64_t start = diskann_clock_us();
+    int n = search_knn(&w->idx, job->queries + (size_t)q * w->idx.dimensions,
+                       job->k, job->search_list, job->patience,
+                       job->start_rowid, job->cache,
+                       job->results + (size_t)q * (size_t)job->k);
+    if (n < 0) {
+      w->rc = n;
+      return;
+    }
+    diskann_stats_searches(&w->idx, diskann_clock_us() - start, 1);
+    job->n_results[q] = n;
+  }
+}
+
+/* Bind a worker to a new read-only connection to filename, or to the
+** mapping of a snapshot handle */
+static int search_batch_open_worker(SearchBatchWorker *w, DiskAnnIndex *idx,
+                                    const char *filename) {
+  sqlite3 *db = NULL;
+
+  if (idx->snapshot) {
+    diskann_reader_init(&w->idx, idx, NULL, NULL);
+    return DISKANN_OK;
+  }
+
+  if (sqlite3_open_v2(filename, &db, SQLITE_OPEN_READONLY, NULL) !=
+      SQLITE_OK) {
+    sqlite3_close(db);
+    return DISKANN_ERROR;
+  }
+  diskann_reader_init(&w->idx, idx, db, sqlite3_mprintf("main"));
+  w->idx.read_cache = NULL; /* passed explicitly: the data_version check
+                            ** belongs to the caller's connection */
+  return w->idx.db_name ? DISKANN_OK : DISKANN_ERROR_NOMEM;
+}
+
+/* Release a worker's connection and context, folding its I/O and search
+** counters into the caller's handle */
+static void search_batch_close_worker(SearchBatchWorker *w, DiskAnnIndex *idx) {
+  sqlite3 *db = w->idx.db;
+  diskann_reader_deinit(&w->idx);
+  sqlite3_close(db);
+  idx->num_reads += w->idx.num_reads;
+  idx->num_read_bytes += w->idx.num_read_bytes;
+  diskann_counters_merge(&idx->counters, &w->idx.counters);
+}
+
+int diskann_search_batch(DiskAnnIndex *idx, const float *queries,
+                         int n_queries, uint32_t dims, int k,
+                         DiskAnnResult *results, int *n_results,
+                         uint32_t num_threads) {
+  return diskann_search_batch_ex(idx, queries, n_queries, dims, k, NULL,
+                                 results, n_results, num_threads);
+}
+
+int diskann_search_batch_ex(DiskAnnIndex *idx, const float *queries,
+                            int n_queries, uint32_t dims, int k,
+                            const DiskAnnSearchParams *params,
+                            DiskAnnResult *results, int *n_results,
+                            uint32_t num_threads) {
+  SearchBatchWorker *workers = NULL;
+  SearchBatchJob job;
+  uint32_t n_workers;
+  uint32_t n_open = 0;
+  uint64_t start_rowid = 0;
+  int rc;
+
+  if (!idx || !queries || !results || !n_results)
+    return DISKANN_ERROR_INVALID;
+  if (n_queries < 0 || k < 0)
+    return DISKANN_ERROR_INVALID;
+  if (dims != idx->dimensions)
+    return DISKANN_ERROR_DIMENSION;
+
+  for (int q = 0; q < n_queries; q++) {
+    n_results[q] = 0;
+  }
+  if (n_queries == 0 || k == 0) {
+    return DISKANN_OK;
+  }
+
+  diskann_reader_sync(idx);
+  if (plan_exact_scan(idx, params)) {
+    /* One pass over the rows scores every query */
+    uint64_t start = diskann_clock_us();
+    rc = exact_scan(idx, queries, n_queries, k, results, n_results, NULL, NULL,
+                    NULL);
+    if (rc == DISKANN_OK) {
+      diskann_stats_searches(idx, diskann_clock_us() - start, n_queries);
+    }
+    return rc;
+  }
+
+  rc = diskann_select_start_row(idx, &start_rowid);
+  if (rc == SQLITE_DONE) {
+    return DISKANN_OK; /* empty index */
+  }
+  if (rc != DISKANN_OK) {
+    return DISKANN_ERROR;
+  }
+
+  job.queries = queries;
+  job.n_queries = n_queries;
+  job.k = k;
+  job.search_list = effective_search_list_size(idx, params, k);
+  job.patience = search_patience(params);
+  job.start_rowid = start_rowid;
+  job.cache = read_cache_for_search(idx);
+  job.results = results;
+  job.n_results = n_results;
+
+  n_workers = num_threads ? num_threads : diskann_cpu_count();
+  if (n_workers > (uint32_t)n_queries) {
+    n_workers = (uint32_t)n_queries;
+  }
+  if (n_workers > DISKANN_MAX_THREADS) {
+    n_workers = DISKANN_MAX_THREADS;
+  }
+
+  /* Snapshot workers read the mapping and need no connection */
+  const char *filename =
+      idx->db ? sqlite3_db_filename(idx->db, idx->db_name) : NULL;
+  int parallel =
+      n_workers > 1 &&
+      (idx->snapshot ||
+       (filename && filename[0] && sqlite3_threadsafe() &&
+        sqlite3_txn_state(idx->db, idx->db_name) != SQLITE_TXN_WRITE));
+  if (parallel) {
+    workers = (SearchBatchWorker *)sqlite3_malloc64(
+        (uint64_t)n_workers * sizeof(SearchBatchWorker));
+    if (!workers) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    memset(workers, 0, (size_t)n_workers * sizeof(SearchBatchWorker));
+    for (; n_open < n_workers; n_open++) {
+      SearchBatchWorker *w = &workers[n_open];
+      w->job = &job;
+      w->index = n_open;
+      w->n_workers = n_workers;
+      if (search_batch_open_worker(w, idx, filename) != DISKANN_OK) {
+        search_batch_close_worker(w, idx);
+        break;
+      }
+    }
+    /* A worker connection failed to open: fall back to the caller's */
+    parallel = n_open == n_workers;
+  }
+
+  if (parallel) {
+    diskann_parallel_run(search_batch_worker, workers,
+                         sizeof(SearchBatchWorker), n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+      if (rc == DISKANN_OK && workers[i].rc != DISKANN_OK) {
+        rc = workers[i].rc;
+      }
+    }
+  } else {
+    for (int q = 0; q < n_queries; q++) {
+      uint64_t start = diskann_clock_us();
+      int n = search_knn(idx, queries + (size_t)q * dims, k, job.search_list,
+                         job.patience, start_rowid, job.cache,
+                         results + (size_t)q * (size_t)k);
+      if (n < 0) {
+        rc = n;
+        break;
+      }
+      diskann_stats_searches(idx, diskann_clock_us() - start, 1);
+      n_results[q] = n;
+    }
+  }
+
+  for (uint32_t i = 0; i < n_open; i++) {
+    search_batch_close_worker(&workers[i], idx);
+  }
+  sqlite3_free(workers);
+  return rc;
 }
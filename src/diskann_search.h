@@ -7,14 +7,17 @@
 ** MIT License
 **
 ** This module provides:
-** - DiskAnnSearchCtx — context for beam search traversal
+** - DiskAnnSearchCtx — context for beam search traversal (pooled per index)
 ** - diskann_search_internal() — core beam search (shared by search & insert)
 ** - diskann_select_random_shadow_row() — random start node selection
+** - diskann_select_start_row() / diskann_search_from() — entry point start
 ** - diskann_search() — public k-NN search API
+** - DiskAnnSearchStream — resumable search for the virtual table cursor
 */
 #ifndef DISKANN_SEARCH_H
 #define DISKANN_SEARCH_H
 
+#include "diskann_bitmap.h"
 #include "diskann_blob.h"
 #include "diskann_internal.h"
 #include "diskann_node.h"
@@ -28,56 +31,146 @@ extern "C" {
 typedef struct BlobCache BlobCache;
 
 /*
-** VisitedSet — O(1) hash set for visited tracking (build speed optimization)
+** VisitedSet — O(1) rowid -> search state map (queued or visited)
 **
-** Uses open addressing with linear probing and FNV-1a hash.
-** Capacity must be power of 2 for fast modulo via bitwise AND.
-** Empty slots marked with 0xFFFFFFFFFFFFFFFF sentinel.
+** Uses open addressing with linear probing and FNV-1a hash, kept at most
+** half full (doubles as needed). Capacity must be power of 2 for fast
+** modulo via bitwise AND. A slot is occupied when stamps[slot] == stamp;
+** visited_set_clear() bumps the stamp, so a pooled set is emptied in O(1)
+** instead of being rewritten.
 **
 ** Memory ownership:
-** - rowids: owned array (malloc'd, freed in deinit)
+** - rowids, stamps, states: owned arrays (malloc'd, freed in deinit)
 */
+#define VISITED_SET_QUEUED 1  /* entered the beam (may since be evicted) */
+#define VISITED_SET_VISITED 2 /* expanded */
+#define VISITED_SET_SPILLED 3 /* scored, outside the beam (resumable walks) */
+
 typedef struct VisitedSet {
-  uint64_t *rowids; /* Hash table (0xFFFFFFFFFFFFFFFF = empty) */
+  uint64_t *rowids; /* Hash table, valid where stamps[i] == stamp */
+  uint32_t *stamps; /* Generation that wrote each slot (0 = never) */
+  uint8_t *states;  /* VISITED_SET_QUEUED or VISITED_SET_VISITED */
+  uint32_t stamp;   /* Current generation, never 0 */
   int capacity;     /* Power of 2 (default 256) */
   int count;        /* Number of entries */
 } VisitedSet;
 
+/* Nodes per pooled allocation (see DiskAnnSearchCtx.node_chunks) */
+#define DISKANN_NODE_CHUNK_SIZE 256
+
+typedef struct DiskAnnNodeChunk {
+  struct DiskAnnNodeChunk *next;
+  DiskAnnNode nodes[DISKANN_NODE_CHUNK_SIZE];
+} DiskAnnNodeChunk;
+
+/*
+** One node expanded in the current hop of a beam search. A hop takes the
+** beam_width closest unvisited candidates (see diskann_set_beam_width()),
+** loads all their blocks, then scores all their edges. READONLY slots own
+** a reusable spot; node, hit and block only live for one hop.
+*/
+typedef struct DiskAnnHopSlot {
+  DiskAnnNode *node; /* taken off the unvisited queue, NULL once dropped */
+  float distance;
+  BlobSpot *spot;  /* owned READONLY spot, reused across hops and queries */
+  BlobSpot *hit;   /* read-cache reference held for this hop, or NULL */
+  BlobSpot *block; /* loaded block: hit, spot or node->blob_spot */
+} DiskAnnHopSlot;
+
+/*
+** Growable min-heap of (rowid, distance) pairs, closest at items[0].
+** Memory ownership: items is owned (freed with the search context).
+*/
+typedef struct DiskAnnResultHeap {
+  DiskAnnResult *items;
+  int n;
+  int cap;
+} DiskAnnResultHeap;
+
 /*
 ** Search context — manages candidates, visited nodes, and top-K results
 ** during beam search traversal.
 **
+** The beam (the max_candidates closest nodes seen so far) is a max-heap,
+** so the eviction threshold is candidates[0]. Its unvisited members are
+** also in a min-heap, so the next node to expand is queue[0]. Nodes record
+** their position in both heaps (DiskAnnNode.beam_idx / queue_idx) for
+** O(log L) removal, and visited_set answers "already queued or visited"
+** in O(1): a query costs O(hops * degree * log L).
+**
+** A context can be reset and reused for another query: nodes come from a
+** chunked pool and are recycled rather than freed, and the arrays only
+** grow. diskann_search() keeps one per index (see
+** diskann_search_ctx_acquire()), so steady-state queries make no heap
+** allocations of their own.
+**
 ** Memory ownership:
 ** - query: borrowed pointer (NOT owned, NOT freed)
-** - candidates / distances: owned parallel arrays (malloc'd)
+** - candidates / distances: owned parallel arrays (beam max-heap)
+** - queue / queue_distances: owned parallel arrays (unvisited min-heap)
 ** - top_candidates / top_distances: owned parallel arrays (malloc'd)
-** - visited_list: linked list of visited DiskAnnNodes (all freed in deinit)
-** - visited_set: hash set for O(1) visited checks (freed in deinit)
-** - Unvisited candidates in the candidates array are also freed in deinit
+** - visited_list: linked list of visited DiskAnnNodes (pool-owned)
+** - visited_set: rowid state map (freed in deinit)
+** - pq_buf: owned PQ lookup table storage; pq_table points into it when
+**   the query routes with PQ codes, NULL otherwise
+** - node_chunks: owned node pool; free_nodes links the unused nodes
+** - hop: owned array of cap_hop slots; each READONLY slot spot is reused
+**   across queries, and its handle is closed after every search
+** - spill / found: owned heaps, only filled by resumable walks (streaming)
 */
 typedef struct DiskAnnSearchCtx {
   const float *query;       /* borrowed, not owned */
-  DiskAnnNode **candidates; /* sorted by distance ascending */
+  float query_inv_norm;     /* 1/|query| for cosine, else 0 */
+  DiskAnnNode **candidates; /* beam max-heap, furthest first */
   float *distances;         /* parallel to candidates */
   int n_candidates;
-  int max_candidates;           /* = searchL or insertL */
+  int max_candidates;       /* = searchL or insertL */
+  DiskAnnNode **queue;      /* unvisited beam members, min-heap */
+  float *queue_distances;   /* parallel to queue */
   DiskAnnNode **top_candidates; /* top-K exact results */
   float *top_distances;
   int n_top_candidates;
   int max_top_candidates;    /* = k */
   DiskAnnNode *visited_list; /* linked list of visited nodes */
-  VisitedSet visited_set;    /* hash set for O(1) visited checks */
-  int n_unvisited;
+  uint32_t n_visited;        /* nodes visited since the last reset */
+  uint32_t patience;         /* stop after this many visits that left the
+                             ** top-K unchanged (0 = exhaust the beam) */
+  uint32_t stale_visits;     /* visits since the top-K last changed */
+  VisitedSet visited_set;    /* queued / visited state per rowid */
+  int n_unvisited;           /* = queue size */
   int blob_mode;             /* DISKANN_BLOB_READONLY or WRITABLE */
   DiskAnnFilterFn filter_fn; /* NULL = no filter (accept all) */
   void *filter_ctx;          /* Opaque context for filter_fn */
+  uint32_t label; /* expand only nodes with this label (diskann_label.h),
+                  ** DISKANN_LABEL_NONE = all */
+  float *pq_table;           /* PQ query lookup table, NULL = edge vectors */
+
+  /* Reusable storage (capacities, not per-query sizes) */
+  int cap_candidates;
+  int cap_top;
+  float *pq_buf;
+  uint64_t pq_buf_len; /* floats */
+  DiskAnnNodeChunk *node_chunks;
+  DiskAnnNode *free_nodes;
+  DiskAnnHopSlot *hop;
+  int cap_hop;
+
+  /* Resumable walks (see DiskAnnSearchStream): every scored candidate
+  ** that is not in the beam goes to spill, and every visited match to
+  ** found, instead of being forgotten */
+  int streaming;
+  DiskAnnResultHeap spill; /* unexpanded candidates outside the beam */
+  DiskAnnResultHeap found; /* visited matches not yet returned */
 } DiskAnnSearchCtx;
 
 /*
-** Initialize search context. Allocates candidate and top-K arrays.
+** Initialize search context. Allocates candidate and top-K arrays and, for
+** cosine indexes, computes the query's inverse norm once. READONLY searches
+** on an index with PQ codes also build the query's PQ lookup table.
 **
 ** Parameters:
 **   ctx             - context to initialize (must not be NULL)
+**   idx             - index the query will run against
 **   query           - query vector (borrowed, must outlive ctx)
 **   max_candidates  - beam width (searchL for search, insertL for insert)
 **   max_top         - number of top results to track (k)
@@ -85,8 +178,20 @@ typedef struct DiskAnnSearchCtx {
 **
 ** Returns DISKANN_OK on success, DISKANN_ERROR_NOMEM on allocation failure.
 */
-int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const float *query,
-                            int max_candidates, int max_top, int blob_mode);
+int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const DiskAnnIndex *idx,
+                            const float *query, int max_candidates,
+                            int max_top, int blob_mode);
+
+/*
+** Reuse an initialized context for another query, with the same parameters
+** as diskann_search_ctx_init(). Nodes from the previous query return to
+** the pool; arrays are reallocated only when they are too small.
+**
+** Returns DISKANN_OK or DISKANN_ERROR_NOMEM (ctx stays valid for deinit).
+*/
+int diskann_search_ctx_reset(DiskAnnSearchCtx *ctx, const DiskAnnIndex *idx,
+                             const float *query, int max_candidates,
+                             int max_top, int blob_mode);
 
 /*
 ** Free all resources owned by the search context.
@@ -94,6 +199,26 @@ int diskann_search_ctx_init(DiskAnnSearchCtx *ctx, const float *query,
 */
 void diskann_search_ctx_deinit(DiskAnnSearchCtx *ctx);
 
+/* Was rowid expanded (visited) by the search that ran on ctx? */
+int diskann_search_ctx_visited(const DiskAnnSearchCtx *ctx, uint64_t rowid);
+
+/*
+** Borrow the index's pooled READONLY search context, reset for query. The
+** pool holds one context; a nested search (e.g. from a filter callback)
+** gets a fresh one. Return it with diskann_search_ctx_release().
+**
+** Returns DISKANN_OK or DISKANN_ERROR_NOMEM.
+*/
+int diskann_search_ctx_acquire(DiskAnnIndex *idx, DiskAnnSearchCtx **out,
+                               const float *query, int max_candidates,
+                               int max_top);
+
+/*
+** Recycle ctx's nodes and hand it back to the index pool (or free it when
+** the pool is occupied). NULL-safe.
+*/
+void diskann_search_ctx_release(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx);
+
 /*
 ** Select a random row from the shadow table as search entry point.
 **
@@ -102,25 +227,183 @@ void diskann_search_ctx_deinit(DiskAnnSearchCtx *ctx);
 **   SQLITE_DONE (101) if the table is empty (not an error)
 **   Negative error code on failure
 */
-int diskann_select_random_shadow_row(const DiskAnnIndex *idx, uint64_t *rowid);
+int diskann_select_random_shadow_row(DiskAnnIndex *idx, uint64_t *rowid);
+
+/*
+** Select the beam-search start node: the cached entry point when set,
+** otherwise a random row. No SQL runs when the entry point is cached.
+**
+** Returns DISKANN_OK, SQLITE_DONE for an empty index, or a negative error.
+*/
+int diskann_select_start_row(DiskAnnIndex *idx, uint64_t *rowid);
 
 /*
 ** Core beam search algorithm. Traverses the DiskANN graph starting from
 ** start_rowid, populating ctx with candidates and top-K results.
 **
 ** Used by both search (READONLY mode) and insert (WRITABLE mode).
+** READONLY searches expand idx->beam_width nodes per hop; WRITABLE
+** searches one.
 **
 ** Parameters:
 **   idx        - Index handle
 **   ctx        - Search context (receives results)
 **   start_rowid- Starting node for beam search
-**   cache      - Optional BLOB cache (NULL = no caching)
+**   cache      - Optional BLOB cache (NULL = no caching). READONLY
+**                searches store handle-less block copies in it (the
+**                shared read cache); WRITABLE searches share live spots.
 **
 ** Returns DISKANN_OK on success, negative error code on failure.
 */
 int diskann_search_internal(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
                             uint64_t start_rowid, BlobCache *cache);
 
+/*
+** diskann_search_internal() from a diskann_select_start_row() result. If the
+** start node was the cached entry point and no longer exists (deleted by
+** another connection, or a rolled-back transaction), the cached entry is
+** dropped and the search restarts once from a random row.
+**
+** Returns DISKANN_OK, SQLITE_DONE if the fallback found the index empty, or
+** a negative error code.
+*/
+int diskann_search_from(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
+                        uint64_t start_rowid, BlobCache *cache);
+
+/*
+** Graph k-NN search of a validated query with exactly search_list
+** candidates in the beam: no widening and no exact-scan planning, for
+** diskann_calibrate(). Returns the result count or a negative error code.
+*/
+int diskann_search_graph_knn(DiskAnnIndex *idx, const float *query, int k,
+                             int search_list, DiskAnnResult *results);
+
+/*
+** Up to n_samples random stored rows that are not tombstoned: their
+** vectors decoded to float32 into vectors (n_samples * dimensions) and
+** their rowids into ids. Rows are picked by random rowid seeks, so a row
+** may be picked twice. Returns the number picked (0 for an empty index)
+** or a negative error code.
+*/
+int diskann_sample_rows(DiskAnnIndex *idx, int n_samples, float *vectors,
+                        int64_t *ids);
+
+/*
+** Filtered k-NN search restricted to the rows in filter. Plans by the
+** filter's size: few matches (relative to the beam width, or to the index
+** size) are scored exactly, one block read each; broader filters run
+** diskann_search_filtered() with the bitmap as the filter. Results are
+** sorted by distance.
+**
+** label is the label every row in filter carries (an equality filter on
+** the LABEL column, see diskann_label.h), or DISKANN_LABEL_NONE. Graph
+** walks then stay in that label's subgraph. params as for
+** diskann_search_ex() (NULL = the handle's settings).
+**
+** Returns the result count, or a negative error code.
+*/
+int diskann_search_bitmap(DiskAnnIndex *idx, const float *query,
+                          uint32_t dims, int k, DiskAnnResult *results,
+                          const DiskAnnBitmap *filter, uint32_t label,
+                          const DiskAnnSearchParams *params);
+
+/*
+** diskann_shards_search() over the rows in filter: rowids are global, so
+** one bitmap serves every shard (the virtual table's metadata filters).
+** Returns the result count, or a negative error code
+** (DISKANN_ERROR_INVALID if filter is NULL).
+*/
+int diskann_shards_search_bitmap(DiskAnnShards *shards, const float *query,
+                                 uint32_t dims, int k,
+                                 const DiskAnnSearchParams *params,
+                                 const DiskAnnBitmap *filter,
+                                 DiskAnnResult *results,
+                                 uint32_t num_threads);
+
+/*
+** Exact k-NN for n_queries queries in one pass over the index: the rows of
+** filter when given, otherwise every row. Query q's results go to
+** results[q * k] (sorted, n_results[q] of them). Used by the virtual
+** table's "exact" column; see diskann_search_exact().
+**
+** Returns DISKANN_OK or a negative error code.
+*/
+int diskann_search_exact_multi(DiskAnnIndex *idx, const float *queries,
+                               int n_queries, uint32_t dims, int k,
+                               DiskAnnResult *results, int *n_results,
+                               const DiskAnnBitmap *filter);
+
+/*
+** Resumable k-NN search, one row at a time (the virtual table cursor).
+**
+** The first call to diskann_search_stream_next() runs the usual beam walk,
+** but keeps every scored candidate that falls outside the beam. Visited
+** matches are returned closest first while none lies beyond the closest
+** unexpanded candidate; after that, or when they run out, the walk resumes
+** with a fresh beam of the closest spilled candidates. So rows come out in
+** close to distance order, and the walk only goes as far as the caller
+** keeps asking. Indexes and filters small enough for the exact scan (see
+** diskann_set_exact_scan_threshold() and diskann_search_bitmap()) are
+** scanned up front instead.
+**
+** A label walk (label != DISKANN_LABEL_NONE) that runs dry before the
+** filter's rows do falls back to walking the whole graph, skipping rows it
+** already returned.
+**
+** Memory ownership:
+** - ctx: pooled search context, held until close
+** - query: owned copy
+** - filter: borrowed, must outlive the stream
+** - rows: owned exact-scan results
+** - emitted: rows returned by a label walk, for the fallback
+*/
+typedef struct DiskAnnSearchStream {
+  DiskAnnIndex *idx;
+  DiskAnnSearchCtx *ctx;
+  float *query;
+  const DiskAnnBitmap *filter; /* NULL = every row */
+  uint32_t label;
+  int max_candidates; /* beam size of each walk */
+  int64_t remaining;  /* rows left before the limit */
+  float max_distance; /* no row further away is returned */
+  DiskAnnResult *rows; /* exact scan results (sorted), or NULL */
+  int n_rows;
+  int pos;
+  VisitedSet emitted;
+  int started;
+  int fell_back; /* label walk replaced by a whole-graph walk */
+  int done;
+  uint64_t busy_us; /* time spent in open and next, for diskann_stats() */
+} DiskAnnSearchStream;
+
+/*
+** Open a stream of at most limit rows (< 0 = unlimited), none further
+** than max_distance (INFINITY = no bound), from the rows of filter (NULL =
+** every row) of which all carry label (or DISKANN_LABEL_NONE). params as
+** for diskann_search_ex() (NULL = the handle's settings) are applied now,
+** along with the exact scan threshold; a walk starts on the first
+** diskann_search_stream_next().
+**
+** Returns DISKANN_OK, DISKANN_ERROR_DIMENSION, DISKANN_ERROR_NOMEM, or an
+** exact scan's error.
+*/
+int diskann_search_stream_open(DiskAnnIndex *idx, const float *query,
+                               uint32_t dims, int64_t limit,
+                               float max_distance, const DiskAnnBitmap *filter,
+                               uint32_t label,
+                               const DiskAnnSearchParams *params,
+                               DiskAnnSearchStream **out);
+
+/*
+** Store the next row in *row. Returns 1, 0 at the end of the stream, or a
+** negative error code.
+*/
+int diskann_search_stream_next(DiskAnnSearchStream *stream,
+                               DiskAnnResult *row);
+
+/* Return the search context to the index pool and free stream. NULL-safe. */
+void diskann_search_stream_close(DiskAnnSearchStream *stream);
+
 /*
 ** Test helpers for hash set unit tests.
 ** These expose internal static functions for testing purposes.
@@ -129,7 +412,12 @@ int diskann_search_internal(DiskAnnIndex *idx, DiskAnnSearchCtx *ctx,
 void visited_set_init(VisitedSet *set, int capacity);
 int visited_set_contains(const VisitedSet *set, uint64_t rowid);
 void visited_set_add(VisitedSet *set, uint64_t rowid);
+void visited_set_clear(VisitedSet *set);
+uint8_t visited_set_state(const VisitedSet *set, uint64_t rowid);
+int visited_set_put(VisitedSet *set, uint64_t rowid, uint8_t state);
 void visited_set_deinit(VisitedSet *set);
+int filter_plan_exact_scan(DiskAnnIndex *idx, uint64_t n_matches,
+                           const DiskAnnSearchParams *params);
 #endif
 
 #ifdef __cplusplus
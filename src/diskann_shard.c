@@ -0,0 +1,525 @@
+/*
+** DiskANN partitioned indexes — hash-routed shards with fan-out search
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** A DiskAnnShards is N ordinary index handles on one connection, one per
+** schema (see "Partitioned indexes" in diskann.h). Writes go to the shard
+** a rowid hashes to. A search asks every shard for its own top k into a
+** scratch array kept across calls, then merges the sorted per-shard lists.
+**
+** Concurrent searches need one connection per worker: a connection runs
+** one statement at a time. Each shard gets a read-only connection to its
+** file and a reader of its handle (diskann_open_reader()), opened by the
+** first concurrent search and kept, so a fan-out costs thread starts and
+** no connection setup. Readers re-borrow their shard handle's entry point,
+** row count and caches at each search (diskann_reader_sync()), so rows
+** inserted since they opened size the beam and the exact-scan plan.
+** Readers share their shard's read cache; their I/O and search counters
+** are folded into the shard's handle after each search, so diskann_stats()
+** on a shard sees them.
+**
+** diskann_shards_build() likewise gives each worker its own read-write
+** connection and handle, and the shard handles re-read the entry point
+** the builds stored.
+*/
+#include "diskann.h"
+#include "diskann_cache.h"
+#include "diskann_internal.h"
+#include "diskann_label.h"
+#include "diskann_search.h"
+#include "diskann_stats.h"
+#include "diskann_thread.h"
+#include <string.h>
+
+struct DiskAnnShards {
+  sqlite3 *db;
+  int n_shards;
+  DiskAnnIndex **indexes; /* n_shards handles on db */
+
+  /* Concurrent search (NULL until the first one) */
+  sqlite3 **reader_dbs;  /* read-only connection per shard */
+  DiskAnnIndex **readers; /* reader of indexes[i] on reader_dbs[i] */
+
+  /* Per-shard results of the last search: shard i fills
+  ** scratch[i * scratch_k ...] with n_found[i] rows */
+  DiskAnnResult *scratch;
+  int *n_found;
+  int scratch_k;
+};
+
+typedef struct ShardSearchWorker {
+  DiskAnnShards *shards;
+  DiskAnnIndex **handles; /* readers, or the shard handles themselves */
+  const float *query;
+  int k;
+  const DiskAnnSearchParams *params;
+  const DiskAnnBitmap *filter; /* NULL = unfiltered */
+  uint32_t index;
+  uint32_t n_workers;
+  int rc;
+} ShardSearchWorker;
+
+typedef struct ShardBuildWorker {
+  DiskAnnShards *shards;
+  DiskAnnBuildConfig config; /* threads per shard, no progress callback */
+  uint32_t index;
+  uint32_t n_workers;
+  int rc;
+} ShardBuildWorker;
+
+/**************************************************************************
+** Open / close
+**************************************************************************/
+
+static void close_readers(DiskAnnShards *shards) {
+  if (!shards->readers) {
+    return;
+  }
+  for (int i = 0; i < shards->n_shards; i++) {
+    diskann_close_index(shards->readers[i]);
+    sqlite3_close(shards->reader_dbs[i]);
+  }
+  sqlite3_free(shards->readers);
+  sqlite3_free(shards->reader_dbs);
+  shards->readers = NULL;
+  shards->reader_dbs = NULL;
+}
+
+void diskann_close_shards(DiskAnnShards *shards) {
+  if (!shards) {
+    return;
+  }
+  /* Readers borrow the shard handles' state: close them first */
+  close_readers(shards);
+  for (int i = 0; i < shards->n_shards; i++) {
+    diskann_close_index(shards->indexes[i]);
+  }
+  sqlite3_free(shards->indexes);
+  sqlite3_free(shards->scratch);
+  sqlite3_free(shards->n_found);
+  sqlite3_free(shards);
+}
+
+int diskann_open_shards(sqlite3 *db, const char *const *db_names,
+                        int n_shards, const char *index_name,
+                        DiskAnnShards **out) {
+  if (!out) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+  if (!db || !db_names || !index_name || n_shards < 1 ||
+      n_shards > DISKANN_MAX_SHARDS) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  DiskAnnShards *shards =
+      (DiskAnnShards *)sqlite3_malloc64(sizeof(DiskAnnShards));
+  if (!shards) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(shards, 0, sizeof(DiskAnnShards));
+  shards->db = db;
+  shards->indexes = (DiskAnnIndex **)sqlite3_malloc64(
+      (uint64_t)n_shards * sizeof(DiskAnnIndex *));
+  shards->n_found = (int *)sqlite3_malloc64((uint64_t)n_shards * sizeof(int));
+  if (!shards->indexes || !shards->n_found) {
+    diskann_close_shards(shards);
+    return DISKANN_ERROR_NOMEM;
+  }
+
+  int rc = DISKANN_OK;
+  for (int i = 0; i < n_shards; i++) {
+    rc = db_names[i] ? diskann_open_index(db, db_names[i], index_name,
+                                          &shards->indexes[i])
+                     : DISKANN_ERROR_INVALID;
+    if (rc != DISKANN_OK) {
+      break;
+    }
+    shards->n_shards++;
+    /* Merged distances must be comparable */
+    const DiskAnnIndex *first = shards->indexes[0];
+    if (shards->indexes[i]->dimensions != first->dimensions ||
+        shards->indexes[i]->metric != first->metric) {
+      rc = DISKANN_ERROR_INVALID;
+      break;
+    }
+  }
+  if (rc != DISKANN_OK) {
+    diskann_close_shards(shards);
+    return rc;
+  }
+  *out = shards;
+  return DISKANN_OK;
+}
+
+/**************************************************************************
+** Routing
+**************************************************************************/
+
+int diskann_shard_for(const DiskAnnShards *shards, int64_t id, int *shard) {
+  if (!shards || !shard) {
+    return DISKANN_ERROR_INVALID;
+  }
+  /* splitmix64 finalizer: consecutive rowids spread evenly */
+  uint64_t h = (uint64_t)id;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  *shard = (int)(h % (uint64_t)shards->n_shards);
+  return DISKANN_OK;
+}
+
+int diskann_shard_count(const DiskAnnShards *shards) {
+  return shards ? shards->n_shards : 0;
+}
+
+DiskAnnIndex *diskann_shard_index(DiskAnnShards *shards, int i) {
+  if (!shards || i < 0 || i >= shards->n_shards) {
+    return NULL;
+  }
+  return shards->indexes[i];
+}
+
+int diskann_shards_insert(DiskAnnShards *shards, int64_t id,
+                          const float *vector, uint32_t dims) {
+  int shard;
+  int rc = diskann_shard_for(shards, id, &shard);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  return diskann_insert(shards->indexes[shard], id, vector, dims);
+}
+
+int diskann_shards_delete(DiskAnnShards *shards, int64_t id) {
+  int shard;
+  int rc = diskann_shard_for(shards, id, &shard);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  return diskann_delete(shards->indexes[shard], id);
+}
+
+/**************************************************************************
+** Fan-out search
+**************************************************************************/
+
+/* Whether every shard has a file other connections can open, on a
+** SQLite built for threads */
+static int shards_have_files(const DiskAnnShards *shards) {
+  if (!sqlite3_threadsafe()) {
+    return 0;
+  }
+  for (int i = 0; i < shards->n_shards; i++) {
+    const char *filename =
+        sqlite3_db_filename(shards->db, shards->indexes[i]->db_name);
+    if (!filename || !filename[0]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Whether shards can be searched on their own connections: each one has
+** a file, and none has writes only the caller's connection can see */
+static int can_search_concurrently(const DiskAnnShards *shards) {
+  if (!shards_have_files(shards)) {
+    return 0;
+  }
+  for (int i = 0; i < shards->n_shards; i++) {
+    if (sqlite3_txn_state(shards->db, shards->indexes[i]->db_name) ==
+        SQLITE_TXN_WRITE) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Open a read-only connection and a reader per shard. On failure nothing
+** stays open. */
+static int open_readers(DiskAnnShards *shards) {
+  int n = shards->n_shards;
+  shards->reader_dbs =
+      (sqlite3 **)sqlite3_malloc64((uint64_t)n * sizeof(sqlite3 *));
+  shards->readers =
+      (DiskAnnIndex **)sqlite3_malloc64((uint64_t)n * sizeof(DiskAnnIndex *));
+  if (!shards->reader_dbs || !shards->readers) {
+    sqlite3_free(shards->reader_dbs);
+    sqlite3_free(shards->readers);
+    shards->reader_dbs = NULL;
+    shards->readers = NULL;
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(shards->reader_dbs, 0, (size_t)n * sizeof(sqlite3 *));
+  memset(shards->readers, 0, (size_t)n * sizeof(DiskAnnIndex *));
+
+  int rc = DISKANN_OK;
+  for (int i = 0; i < n && rc == DISKANN_OK; i++) {
+    DiskAnnIndex *idx = shards->indexes[i];
+    const char *filename = sqlite3_db_filename(shards->db, idx->db_name);
+    if (sqlite3_open_v2(filename, &shards->reader_dbs[i],
+                        SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+      rc = DISKANN_ERROR;
+      break;
+    }
+    rc = diskann_open_reader(idx, shards->reader_dbs[i], "main",
+                             &shards->readers[i]);
+  }
+  if (rc != DISKANN_OK) {
+    close_readers(shards);
+  }
+  return rc;
+}
+
+/* Move a reader's I/O and search counters to its shard's handle */
+static void fold_reader_counters(DiskAnnIndex *idx, DiskAnnIndex *reader) {
+  idx->num_reads += reader->num_reads;
+  idx->num_read_bytes += reader->num_read_bytes;
+  diskann_counters_merge(&idx->counters, &reader->counters);
+  reader->num_reads = 0;
+  reader->num_read_bytes = 0;
+  memset(&reader->counters, 0, sizeof(reader->counters));
+}
+
+static void shard_search_worker(void *arg) {
+  ShardSearchWorker *w = (ShardSearchWorker *)arg;
+  DiskAnnShards *shards = w->shards;
+
+  for (int i = (int)w->index; i < shards->n_shards;
+       i += (int)w->n_workers) {
+    DiskAnnResult *out = shards->scratch + (size_t)i * (size_t)w->k;
+    uint32_t dims = shards->indexes[i]->dimensions;
+    int n = w->filter ? diskann_search_bitmap(w->handles[i], w->query, dims,
+                                              w->k, out, w->filter,
+                                              DISKANN_LABEL_NONE, w->params)
+                      : diskann_search_ex(w->handles[i], w->query, dims,
+                                          w->k, w->params, out, NULL, NULL);
+    if (n < 0) {
+      w->rc = n;
+      return;
+    }
+    shards->n_found[i] = n;
+  }
+}
+
+/* k-way merge of the sorted per-shard lists into results */
+static int merge_shard_results(const DiskAnnShards *shards, int k,
+                               DiskAnnResult *results) {
+  int head[DISKANN_MAX_SHARDS] = {0};
+  int n = 0;
+  while (n < k) {
+    int best = -1;
+    float best_distance = 0.0f;
+    for (int i = 0; i < shards->n_shards; i++) {
+      if (head[i] < shards->n_found[i]) {
+        float d = shards->scratch[(size_t)i * (size_t)k + (size_t)head[i]]
+                      .distance;
+        if (best < 0 || d < best_distance) {
+          best = i;
+          best_distance = d;
+        }
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    results[n++] =
+        shards->scratch[(size_t)best * (size_t)k + (size_t)head[best]++];
+  }
+  return n;
+}
+
+/* diskann_shards_search_bitmap(), filter NULL = unfiltered */
+static int shards_search(DiskAnnShards *shards, const float *query,
+                         uint32_t dims, int k,
+                         const DiskAnnSearchParams *params,
+                         const DiskAnnBitmap *filter, DiskAnnResult *results,
+                         uint32_t num_threads) {
+  ShardSearchWorker workers[DISKANN_MAX_SHARDS];
+
+  if (!shards || !query || !results || k < 0) {
+    return DISKANN_ERROR_INVALID;
+  }
+  if (dims != shards->indexes[0]->dimensions) {
+    return DISKANN_ERROR_DIMENSION;
+  }
+  if (k == 0) {
+    return 0;
+  }
+
+  /* Per-shard result lists, reused across searches */
+  if (k > shards->scratch_k) {
+    DiskAnnResult *scratch = (DiskAnnResult *)sqlite3_realloc64(
+        shards->scratch,
+        (uint64_t)shards->n_shards * (uint64_t)k * sizeof(DiskAnnResult));
+    if (!scratch) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    shards->scratch = scratch;
+    shards->scratch_k = k;
+  }
+
+  uint32_t n_workers = num_threads ? num_threads : (uint32_t)shards->n_shards;
+  if (n_workers > (uint32_t)shards->n_shards) {
+    n_workers = (uint32_t)shards->n_shards;
+  }
+  int concurrent = n_workers > 1 && can_search_concurrently(shards) &&
+                   (shards->readers || open_readers(shards) == DISKANN_OK);
+  if (!concurrent) {
+    n_workers = 1;
+  }
+
+  for (uint32_t i = 0; i < n_workers; i++) {
+    workers[i].shards = shards;
+    workers[i].handles = concurrent ? shards->readers : shards->indexes;
+    workers[i].query = query;
+    workers[i].k = k;
+    workers[i].params = params;
+    workers[i].filter = filter;
+    workers[i].index = i;
+    workers[i].n_workers = n_workers;
+    workers[i].rc = DISKANN_OK;
+  }
+  diskann_parallel_run(shard_search_worker, workers, sizeof(ShardSearchWorker),
+                       n_workers);
+
+  int rc = DISKANN_OK;
+  for (uint32_t i = 0; i < n_workers; i++) {
+    if (rc == DISKANN_OK && workers[i].rc != DISKANN_OK) {
+      rc = workers[i].rc;
+    }
+  }
+  if (concurrent) {
+    for (int i = 0; i < shards->n_shards; i++) {
+      fold_reader_counters(shards->indexes[i], shards->readers[i]);
+    }
+  }
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+  return merge_shard_results(shards, k, results);
+}
+
+int diskann_shards_search(DiskAnnShards *shards, const float *query,
+                          uint32_t dims, int k,
+                          const DiskAnnSearchParams *params,
+                          DiskAnnResult *results, uint32_t num_threads) {
+  return shards_search(shards, query, dims, k, params, NULL, results,
+                       num_threads);
+}
+
+int diskann_shards_search_bitmap(DiskAnnShards *shards, const float *query,
+                                 uint32_t dims, int k,
+                                 const DiskAnnSearchParams *params,
+                                 const DiskAnnBitmap *filter,
+                                 DiskAnnResult *results,
+                                 uint32_t num_threads) {
+  if (!filter) {
+    return DISKANN_ERROR_INVALID;
+  }
+  return shards_search(shards, query, dims, k, params, filter, results,
+                       num_threads);
+}
+
+/**************************************************************************
+** Parallel build
+**************************************************************************/
+
+/* Build shard i on a new read-write connection to its file */
+static int build_shard_on_own_connection(DiskAnnShards *shards, int i,
+                                         const DiskAnnBuildConfig *config) {
+  const DiskAnnIndex *idx = shards->indexes[i];
+  const char *filename = sqlite3_db_filename(shards->db, idx->db_name);
+  sqlite3 *db = NULL;
+  DiskAnnIndex *own = NULL;
+
+  int rc = sqlite3_open_v2(filename, &db, SQLITE_OPEN_READWRITE, NULL) ==
+                   SQLITE_OK
+               ? DISKANN_OK
+               : DISKANN_ERROR;
+  if (rc == DISKANN_OK) {
+    rc = diskann_open_index(db, "main", idx->index_name, &own);
+  }
+  if (rc == DISKANN_OK) {
+    rc = diskann_build(own, config);
+  }
+  diskann_close_index(own);
+  sqlite3_close(db);
+  return rc;
+}
+
+static void shard_build_worker(void *arg) {
+  ShardBuildWorker *w = (ShardBuildWorker *)arg;
+  for (int i = (int)w->index; i < w->shards->n_shards;
+       i += (int)w->n_workers) {
+    int rc = build_shard_on_own_connection(w->shards, i, &w->config);
+    if (rc != DISKANN_OK) {
+      w->rc = rc;
+      return;
+    }
+  }
+}
+
+int diskann_shards_build(DiskAnnShards *shards,
+                         const DiskAnnBuildConfig *config) {
+  ShardBuildWorker workers[DISKANN_MAX_SHARDS];
+
+  if (!shards) {
+    return DISKANN_ERROR_INVALID;
+  }
+  for (int i = 0; i < shards->n_shards; i++) {
+    if (shards->indexes[i]->batch_cache) {
+      return DISKANN_ERROR_INVALID;
+    }
+  }
+
+  uint32_t n_threads = config ? config->num_threads : 0;
+  if (n_threads == 0) {
+    n_threads = diskann_cpu_count();
+  }
+  uint32_t n_workers = n_threads < (uint32_t)shards->n_shards
+                           ? n_threads
+                           : (uint32_t)shards->n_shards;
+
+  /* Other connections cannot write while this one holds a transaction */
+  if (n_workers < 2 || !shards_have_files(shards) ||
+      !sqlite3_get_autocommit(shards->db)) {
+    for (int i = 0; i < shards->n_shards; i++) {
+      int rc = diskann_build(shards->indexes[i], config);
+      if (rc != DISKANN_OK) {
+        return rc;
+      }
+    }
+    return DISKANN_OK;
+  }
+
+  for (uint32_t i = 0; i < n_workers; i++) {
+    memset(&workers[i].config, 0, sizeof(workers[i].config));
+    workers[i].shards = shards;
+    workers[i].config.num_threads = n_threads / n_workers;
+    workers[i].index = i;
+    workers[i].n_workers = n_workers;
+    workers[i].rc = DISKANN_OK;
+  }
+  diskann_parallel_run(shard_build_worker, workers, sizeof(ShardBuildWorker),
+                       n_workers);
+
+  int rc = DISKANN_OK;
+  for (uint32_t i = 0; i < n_workers; i++) {
+    if (rc == DISKANN_OK && workers[i].rc != DISKANN_OK) {
+      rc = workers[i].rc;
+    }
+  }
+
+  /* The shard handles still point at the old graphs' entry points */
+  for (int i = 0; i < shards->n_shards; i++) {
+    DiskAnnIndex *idx = shards->indexes[i];
+    blob_cache_clear(idx->read_cache);
+    int reload_rc = diskann_reload_entry_point(idx);
+    if (rc == DISKANN_OK) {
+      rc = reload_rc;
+    }
+  }
+  return rc;
+}
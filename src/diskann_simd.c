@@ -0,0 +1,809 @@
+/*
+** DiskANN SIMD distance kernels with runtime CPU dispatch
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** Each ISA block below is compiled with GCC/Clang target attributes, so
+** AVX2/AVX-512 code lives in the same translation unit as the scalar
+** fallback and is only ever called after the CPU reports support.
+*/
+#include "diskann_simd.h"
+#include "diskann.h"
+#include "diskann_node.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if !defined(DISKANN_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) &&  \
+    (defined(__x86_64__) || defined(__i386__))
+#define DISKANN_SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if !defined(DISKANN_NO_SIMD) && defined(__aarch64__)
+#define DISKANN_SIMD_ARM 1
+#include <arm_neon.h>
+#endif
+
+/**************************************************************************
+** Scalar kernels (reference implementations live in diskann_node.c)
+**************************************************************************/
+
+static const DiskAnnDistanceKernels scalar_kernels = {
+    .level = DISKANN_SIMD_SCALAR,
+    .name = "scalar",
+    .l2 = diskann_distance_l2,
+    .dot = diskann_dot_product,
+    .neg_dot = diskann_distance_dot,
+    .cosine = diskann_distance_cosine,
+    .l2_f16 = diskann_distance_l2_f16,
+    .dot_f16 = diskann_dot_product_f16,
+    .l2_bf16 = diskann_distance_l2_bf16,
+    .dot_bf16 = diskann_dot_product_bf16,
+    .l2_bounded = diskann_distance_l2_bounded};
+
+/* Shared epilogue for the cosine kernels: same zero-norm semantics as the
+** scalar reference (zero vector → distance 0). */
+static float cosine_from_sums(float dot, float norm_a, float norm_b) {
+  float denom = sqrtf(norm_a) * sqrtf(norm_b);
+  if (denom == 0.0f) {
+    return 0.0f;
+  }
+  return 1.0f - dot / denom;
+}
+
+/**************************************************************************
+** x86: AVX2 + FMA
+**
+** Two accumulators over 16 floats per iteration hide FMA latency; the
+** remainder (< 8 dims) is handled in scalar code.
+**************************************************************************/
+
+#ifdef DISKANN_SIMD_X86
+
+#define DISKANN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define DISKANN_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#define DISKANN_TARGET_AVX512 __attribute__((target("avx512f")))
+
+DISKANN_TARGET_AVX2 static inline float hsum256(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  __m128 shuf = _mm_movehdup_ps(lo);
+  __m128 sums = _mm_add_ps(lo, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+DISKANN_TARGET_AVX2 static float l2_avx2(const float *a, const float *b,
+                                         uint32_t dims) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 16 <= dims; i += 16) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 d1 =
+        _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 8 <= dims; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum256(_mm256_add_ps(acc0, acc1));
+  for (; i < dims; i++) {
+    float diff = a[i] - b[i];
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+/* l2_avx2() plus a running-sum check every DISKANN_ABANDON_BLOCK dims */
+DISKANN_TARGET_AVX2 static float l2_bounded_avx2(const float *a,
+                                                 const float *b, uint32_t dims,
+                                                 float bound) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  uint32_t i = 0;
+  while (i + 16 <= dims) {
+    uint32_t end =
+        dims - i > DISKANN_ABANDON_BLOCK ? i + DISKANN_ABANDON_BLOCK : dims;
+    for (; i + 16 <= end; i += 16) {
+      __m256 d0 =
+          _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+      __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8),
+                                _mm256_loadu_ps(b + i + 8));
+      acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+      acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    }
+    if (end < dims) {
+      float partial = hsum256(_mm256_add_ps(acc0, acc1));
+      if (partial >= bound) {
+        return partial;
+      }
+    }
+  }
+  for (; i + 8 <= dims; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum256(_mm256_add_ps(acc0, acc1));
+  for (; i < dims; i++) {
+    float diff = a[i] - b[i];
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+DISKANN_TARGET_AVX2 static float dot_avx2(const float *a, const float *b,
+                                          uint32_t dims) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 16 <= dims; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  for (; i + 8 <= dims; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+  }
+  float sum = hsum256(_mm256_add_ps(acc0, acc1));
+  for (; i < dims; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+DISKANN_TARGET_AVX2 static float cosine_avx2(const float *a, const float *b,
+                                             uint32_t dims) {
+  __m256 dot = _mm256_setzero_ps();
+  __m256 na = _mm256_setzero_ps();
+  __m256 nb = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 8 <= dims; i += 8) {
+    __m256 va = _mm256_loadu_ps(a + i);
+    __m256 vb = _mm256_loadu_ps(b + i);
+    dot = _mm256_fmadd_ps(va, vb, dot);
+    na = _mm256_fmadd_ps(va, va, na);
+    nb = _mm256_fmadd_ps(vb, vb, nb);
+  }
+  float s_dot = hsum256(dot), s_na = hsum256(na), s_nb = hsum256(nb);
+  for (; i < dims; i++) {
+    s_dot += a[i] * b[i];
+    s_na += a[i] * a[i];
+    s_nb += b[i] * b[i];
+  }
+  return cosine_from_sums(s_dot, s_na, s_nb);
+}
+
+DISKANN_TARGET_AVX2 static float neg_dot_avx2(const float *a, const float *b,
+                                              uint32_t dims) {
+  return -dot_avx2(a, b, dims);
+}
+
+/*
+** Mixed-precision kernels: 8 stored elements widen to one __m256 (F16C
+** VCVTPH2PS for binary16, a 16-bit shift for bfloat16). The binary16 pair
+** is only handed out when the CPU also reports F16C.
+*/
+DISKANN_TARGET_AVX2_F16C static inline __m256 load8_f16(const uint16_t *p) {
+  return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+DISKANN_TARGET_AVX2 static inline __m256 load8_bf16(const uint16_t *p) {
+  __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+}
+
+/* Squared L2 / dot product of a against 16-bit b widened by LOAD8 */
+#define HALF_KERNELS_AVX2(SUFFIX, TARGET, LOAD8, TO_F32)                       \
+  TARGET static float l2_##SUFFIX##_avx2(const float *a,                       \
+                                         const uint16_t *b, uint32_t dims) {   \
+    __m256 acc0 = _mm256_setzero_ps();                                         \
+    __m256 acc1 = _mm256_setzero_ps();                                         \
+    uint32_t i = 0;                                                            \
+    for (; i + 16 <= dims; i += 16) {                                          \
+      __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), LOAD8(b + i));         \
+      __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), LOAD8(b + i + 8)); \
+      acc0 = _mm256_fmadd_ps(d0, d0, acc0);                                    \
+      acc1 = _mm256_fmadd_ps(d1, d1, acc1);                                    \
+    }                                                                          \
+    for (; i + 8 <= dims; i += 8) {                                            \
+      __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), LOAD8(b + i));         \
+      acc0 = _mm256_fmadd_ps(d0, d0, acc0);                                    \
+    }                                                                          \
+    float sum = hsum256(_mm256_add_ps(acc0, acc1));                            \
+    for (; i < dims; i++) {                                                    \
+      float diff = a[i] - TO_F32(b[i]);                                        \
+      sum += diff * diff;                                                      \
+    }                                                                          \
+    return sum;                                                                \
+  }                                                                            \
+  TARGET static float dot_##SUFFIX##_avx2(const float *a,                      \
+                                          const uint16_t *b, uint32_t dims) {  \
+    __m256 acc0 = _mm256_setzero_ps();                                         \
+    __m256 acc1 = _mm256_setzero_ps();                                         \
+    uint32_t i = 0;                                                            \
+    for (; i + 16 <= dims; i += 16) {                                          \
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), LOAD8(b + i), acc0);      \
+      acc1 =                                                                   \
+          _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), LOAD8(b + i + 8), acc1); \
+    }                                                                          \
+    for (; i + 8 <= dims; i += 8) {                                            \
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), LOAD8(b + i), acc0);      \
+    }                                                                          \
+    float sum = hsum256(_mm256_add_ps(acc0, acc1));                            \
+    for (; i < dims; i++) {                                                    \
+      sum += a[i] * TO_F32(b[i]);                                              \
+    }                                                                          \
+    return sum;                                                                \
+  }
+
+HALF_KERNELS_AVX2(f16, DISKANN_TARGET_AVX2_F16C, load8_f16,
+                  diskann_f16_to_f32)
+HALF_KERNELS_AVX2(bf16, DISKANN_TARGET_AVX2, load8_bf16, diskann_bf16_to_f32)
+
+static const DiskAnnDistanceKernels avx2_kernels = {
+    .level = DISKANN_SIMD_AVX2,
+    .name = "avx2",
+    .l2 = l2_avx2,
+    .dot = dot_avx2,
+    .neg_dot = neg_dot_avx2,
+    .cosine = cosine_avx2,
+    .l2_f16 = l2_f16_avx2,
+    .dot_f16 = dot_f16_avx2,
+    .l2_bf16 = l2_bf16_avx2,
+    .dot_bf16 = dot_bf16_avx2,
+    .l2_bounded = l2_bounded_avx2};
+
+/**************************************************************************
+** x86: AVX-512F
+**
+** The tail uses a masked load instead of a scalar loop, so any dims value
+** runs entirely in vector registers.
+**************************************************************************/
+
+DISKANN_TARGET_AVX512 static inline __mmask16 tail_mask(uint32_t remaining) {
+  return (__mmask16)((1u << remaining) - 1u);
+}
+
+DISKANN_TARGET_AVX512 static float l2_avx512(const float *a, const float *b,
+                                             uint32_t dims) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 32 <= dims; i += 32) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16),
+                              _mm512_loadu_ps(b + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 16 <= dims; i += 16) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  if (i < dims) {
+    __mmask16 m = tail_mask(dims - i);
+    __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i),
+                              _mm512_maskz_loadu_ps(m, b + i));
+    acc1 = _mm512_fmadd_ps(d0, d0, acc1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+/* l2_avx512() plus a running-sum check every DISKANN_ABANDON_BLOCK dims */
+DISKANN_TARGET_AVX512 static float l2_bounded_avx512(const float *a,
+                                                     const float *b,
+                                                     uint32_t dims,
+                                                     float bound) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  uint32_t i = 0;
+  while (i + 32 <= dims) {
+    uint32_t end =
+        dims - i > DISKANN_ABANDON_BLOCK ? i + DISKANN_ABANDON_BLOCK : dims;
+    for (; i + 32 <= end; i += 32) {
+      __m512 d0 =
+          _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+      __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16),
+                                _mm512_loadu_ps(b + i + 16));
+      acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+      acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    }
+    if (end < dims) {
+      float partial = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+      if (partial >= bound) {
+        return partial;
+      }
+    }
+  }
+  for (; i + 16 <= dims; i += 16) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  if (i < dims) {
+    __mmask16 m = tail_mask(dims - i);
+    __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i),
+                              _mm512_maskz_loadu_ps(m, b + i));
+    acc1 = _mm512_fmadd_ps(d0, d0, acc1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+DISKANN_TARGET_AVX512 static float dot_avx512(const float *a, const float *b,
+                                              uint32_t dims) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 32 <= dims; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16),
+                           _mm512_loadu_ps(b + i + 16), acc1);
+  }
+  for (; i + 16 <= dims; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+  }
+  if (i < dims) {
+    __mmask16 m = tail_mask(dims - i);
+    acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i),
+                           _mm512_maskz_loadu_ps(m, b + i), acc1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+DISKANN_TARGET_AVX512 static float cosine_avx512(const float *a,
+                                                 const float *b,
+                                                 uint32_t dims) {
+  __m512 dot = _mm512_setzero_ps();
+  __m512 na = _mm512_setzero_ps();
+  __m512 nb = _mm512_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 16 <= dims; i += 16) {
+    __m512 va = _mm512_loadu_ps(a + i);
+    __m512 vb = _mm512_loadu_ps(b + i);
+    dot = _mm512_fmadd_ps(va, vb, dot);
+    na = _mm512_fmadd_ps(va, va, na);
+    nb = _mm512_fmadd_ps(vb, vb, nb);
+  }
+  if (i < dims) {
+    __mmask16 m = tail_mask(dims - i);
+    __m512 va = _mm512_maskz_loadu_ps(m, a + i);
+    __m512 vb = _mm512_maskz_loadu_ps(m, b + i);
+    dot = _mm512_fmadd_ps(va, vb, dot);
+    na = _mm512_fmadd_ps(va, va, na);
+    nb = _mm512_fmadd_ps(vb, vb, nb);
+  }
+  return cosine_from_sums(_mm512_reduce_add_ps(dot), _mm512_reduce_add_ps(na),
+                          _mm512_reduce_add_ps(nb));
+}
+
+DISKANN_TARGET_AVX512 static float neg_dot_avx512(const float *a,
+                                                  const float *b,
+                                                  uint32_t dims) {
+  return -dot_avx512(a, b, dims);
+}
+
+/*
+** Mixed-precision kernels: 16 stored elements widen to one __m512 (both
+** conversions are AVX-512F). A masked 16-bit load needs AVX-512BW, so the
+** tail is copied into a zero-padded buffer instead; zero lanes add nothing
+** to either sum.
+*/
+DISKANN_TARGET_AVX512 static inline __m512 load16_f16(const uint16_t *p) {
+  return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)p));
+}
+
+DISKANN_TARGET_AVX512 static inline __m512 load16_bf16(const uint16_t *p) {
+  __m512i wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)p));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(wide, 16));
+}
+
+#define HALF_KERNELS_AVX512(SUFFIX, LOAD16)                                    \
+  DISKANN_TARGET_AVX512 static float l2_##SUFFIX##_avx512(                     \
+      const float *a, const uint16_t *b, uint32_t dims) {                      \
+    __m512 acc0 = _mm512_setzero_ps();                                         \
+    __m512 acc1 = _mm512_setzero_ps();                                         \
+    uint32_t i = 0;                                                            \
+    for (; i + 16 <= dims; i += 16) {                                          \
+      __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), LOAD16(b + i));        \
+      acc0 = _mm512_fmadd_ps(d0, d0, acc0);                                    \
+    }                                                                          \
+    if (i < dims) {                                                            \
+      uint16_t tail[16] = {0};                                                 \
+      memcpy(tail, b + i, (dims - i) * sizeof(uint16_t));                      \
+      __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(tail_mask(dims - i),     \
+                                                      a + i),                  \
+                                LOAD16(tail));                                 \
+      acc1 = _mm512_fmadd_ps(d0, d0, acc1);                                    \
+    }                                                                          \
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));                    \
+  }                                                                            \
+  DISKANN_TARGET_AVX512 static float dot_##SUFFIX##_avx512(                    \
+      const float *a, const uint16_t *b, uint32_t dims) {                      \
+    __m512 acc0 = _mm512_setzero_ps();                                         \
+    __m512 acc1 = _mm512_setzero_ps();                                         \
+    uint32_t i = 0;                                                            \
+    for (; i + 16 <= dims; i += 16) {                                          \
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), LOAD16(b + i), acc0);     \
+    }                                                                          \
+    if (i < dims) {                                                            \
+      uint16_t tail[16] = {0};                                                 \
+      memcpy(tail, b + i, (dims - i) * sizeof(uint16_t));                      \
+      acc1 = _mm512_fmadd_ps(                                                  \
+          _mm512_maskz_loadu_ps(tail_mask(dims - i), a + i), LOAD16(tail),     \
+          acc1);                                                               \
+    }                                                                          \
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));                    \
+  }
+
+HALF_KERNELS_AVX512(f16, load16_f16)
+HALF_KERNELS_AVX512(bf16, load16_bf16)
+
+static const DiskAnnDistanceKernels avx512_kernels = {
+    .level = DISKANN_SIMD_AVX512,
+    .name = "avx512",
+    .l2 = l2_avx512,
+    .dot = dot_avx512,
+    .neg_dot = neg_dot_avx512,
+    .cosine = cosine_avx512,
+    .l2_f16 = l2_f16_avx512,
+    .dot_f16 = dot_f16_avx512,
+    .l2_bf16 = l2_bf16_avx512,
+    .dot_bf16 = dot_bf16_avx512,
+    .l2_bounded = l2_bounded_avx512};
+
+#endif /* DISKANN_SIMD_X86 */
+
+/**************************************************************************
+** ARM: NEON (baseline on AArch64, so no runtime check is needed)
+**************************************************************************/
+
+#ifdef DISKANN_SIMD_ARM
+
+static float l2_neon(const float *a, const float *b, uint32_t dims) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= dims; i += 8) {
+    float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    acc0 = vfmaq_f32(acc0, d0, d0);
+    acc1 = vfmaq_f32(acc1, d1, d1);
+  }
+  for (; i + 4 <= dims; i += 4) {
+    float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    acc0 = vfmaq_f32(acc0, d0, d0);
+  }
+  float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+  for (; i < dims; i++) {
+    float diff = a[i] - b[i];
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+/* l2_neon() plus a running-sum check every DISKANN_ABANDON_BLOCK dims */
+static float l2_bounded_neon(const float *a, const float *b, uint32_t dims,
+                             float bound) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  while (i + 8 <= dims) {
+    uint32_t end =
+        dims - i > DISKANN_ABANDON_BLOCK ? i + DISKANN_ABANDON_BLOCK : dims;
+    for (; i + 8 <= end; i += 8) {
+      float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+      float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+      acc0 = vfmaq_f32(acc0, d0, d0);
+      acc1 = vfmaq_f32(acc1, d1, d1);
+    }
+    if (end < dims) {
+      float partial = vaddvq_f32(vaddq_f32(acc0, acc1));
+      if (partial >= bound) {
+        return partial;
+      }
+    }
+  }
+  for (; i + 4 <= dims; i += 4) {
+    float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    acc0 = vfmaq_f32(acc0, d0, d0);
+  }
+  float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+  for (; i < dims; i++) {
+    float diff = a[i] - b[i];
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+static float dot_neon(const float *a, const float *b, uint32_t dims) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= dims; i += 8) {
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  for (; i + 4 <= dims; i += 4) {
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+  float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+  for (; i < dims; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+static float cosine_neon(const float *a, const float *b, uint32_t dims) {
+  float32x4_t dot = vdupq_n_f32(0.0f);
+  float32x4_t na = vdupq_n_f32(0.0f);
+  float32x4_t nb = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= dims; i += 4) {
+    float32x4_t va = vld1q_f32(a + i);
+    float32x4_t vb = vld1q_f32(b + i);
+    dot = vfmaq_f32(dot, va, vb);
+    na = vfmaq_f32(na, va, va);
+    nb = vfmaq_f32(nb, vb, vb);
+  }
+  float s_dot = vaddvq_f32(dot), s_na = vaddvq_f32(na), s_nb = vaddvq_f32(nb);
+  for (; i < dims; i++) {
+    s_dot += a[i] * b[i];
+    s_na += a[i] * a[i];
+    s_nb += b[i] * b[i];
+  }
+  return cosine_from_sums(s_dot, s_na, s_nb);
+}
+
+static float neg_dot_neon(const float *a, const float *b, uint32_t dims) {
+  return -dot_neon(a, b, dims);
+}
+
+/* Mixed-precision kernels: 4 stored elements widen to one float32x4_t
+** (FCVTL for binary16, a 16-bit SHLL for bfloat16) */
+static inline float32x4_t load4_f16(const uint16_t *p) {
+  return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+}
+
+static inline float32x4_t load4_bf16(const uint16_t *p) {
+  return vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(p), 16));
+}
+
+#define HALF_KERNELS_NEON(SUFFIX, LOAD4, TO_F32)                               \
+  static float l2_##SUFFIX##_neon(const float *a, const uint16_t *b,           \
+                                  uint32_t dims) {                             \
+    float32x4_t acc0 = vdupq_n_f32(0.0f);                                      \
+    float32x4_t acc1 = vdupq_n_f32(0.0f);                                      \
+    uint32_t i = 0;                                                            \
+    for (; i + 8 <= dims; i += 8) {                                            \
+      float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), LOAD4(b + i));              \
+      float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4), LOAD4(b + i + 4));      \
+      acc0 = vfmaq_f32(acc0, d0, d0);                                          \
+      acc1 = vfmaq_f32(acc1, d1, d1);                                          \
+    }                                                                          \
+    for (; i + 4 <= dims; i += 4) {                                            \
+      float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), LOAD4(b + i));              \
+      acc0 = vfmaq_f32(acc0, d0, d0);                                          \
+    }                                                                          \
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));                             \
+    for (; i < dims; i++) {                                                    \
+      float diff = a[i] - TO_F32(b[i]);                                        \
+      sum += diff * diff;                                                      \
+    }                                                                          \
+    return sum;                                                                \
+  }                                                                            \
+  static float dot_##SUFFIX##_neon(const float *a, const uint16_t *b,          \
+                                   uint32_t dims) {                            \
+    float32x4_t acc0 = vdupq_n_f32(0.0f);                                      \
+    float32x4_t acc1 = vdupq_n_f32(0.0f);                                      \
+    uint32_t i = 0;                                                            \
+    for (; i + 8 <= dims; i += 8) {                                            \
+      acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), LOAD4(b + i));                  \
+      acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), LOAD4(b + i + 4));          \
+    }                                                                          \
+    for (; i + 4 <= dims; i += 4) {                                            \
+      acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), LOAD4(b + i));                  \
+    }                                                                          \
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));                             \
+    for (; i < dims; i++) {                                                    \
+      sum += a[i] * TO_F32(b[i]);                                              \
+    }                                                                          \
+    return sum;                                                                \
+  }
+
+HALF_KERNELS_NEON(f16, load4_f16, diskann_f16_to_f32)
+HALF_KERNELS_NEON(bf16, load4_bf16, diskann_bf16_to_f32)
+
+static const DiskAnnDistanceKernels neon_kernels = {
+    .level = DISKANN_SIMD_NEON,
+    .name = "neon",
+    .l2 = l2_neon,
+    .dot = dot_neon,
+    .neg_dot = neg_dot_neon,
+    .cosine = cosine_neon,
+    .l2_f16 = l2_f16_neon,
+    .dot_f16 = dot_f16_neon,
+    .l2_bf16 = l2_bf16_neon,
+    .dot_bf16 = dot_bf16_neon,
+    .l2_bounded = l2_bounded_neon};
+
+#endif /* DISKANN_SIMD_ARM */
+
+/**************************************************************************
+** Runtime detection and dispatch
+**************************************************************************/
+
+/* Highest level the hardware (and this build) supports */
+static int detect_hw_level(void) {
+#if defined(DISKANN_SIMD_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return DISKANN_SIMD_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return DISKANN_SIMD_AVX2;
+  }
+#elif defined(DISKANN_SIMD_ARM)
+  return DISKANN_SIMD_NEON;
+#endif
+  return DISKANN_SIMD_SCALAR;
+}
+
+/* Parse DISKANN_SIMD env override. Returns -1 if unset or unrecognized. */
+static int parse_simd_env(void) {
+  const char *env = getenv("DISKANN_SIMD");
+  if (env == NULL || env[0] == '\0') {
+    return -1;
+  }
+  if (strcmp(env, "scalar") == 0)
+    return DISKANN_SIMD_SCALAR;
+  if (strcmp(env, "neon") == 0)
+    return DISKANN_SIMD_NEON;
+  if (strcmp(env, "avx2") == 0)
+    return DISKANN_SIMD_AVX2;
+  if (strcmp(env, "avx512") == 0)
+    return DISKANN_SIMD_AVX512;
+  return -1;
+}
+
+/* Does the CPU convert binary16 (F16C on x86; always on AArch64)? */
+static int detect_hw_f16c(void) {
+#if defined(DISKANN_SIMD_X86)
+  unsigned int eax, ebx, ecx, edx;
+  return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C) != 0;
+#else
+  return 1;
+#endif
+}
+
+/* Kernel table compiled in for level, whether or not the CPU has it */
+static const DiskAnnDistanceKernels *compiled_kernels(int level) {
+  switch (level) {
+  case DISKANN_SIMD_SCALAR:
+    return &scalar_kernels;
+#ifdef DISKANN_SIMD_ARM
+  case DISKANN_SIMD_NEON:
+    return &neon_kernels;
+#endif
+#ifdef DISKANN_SIMD_X86
+  case DISKANN_SIMD_AVX2:
+    return &avx2_kernels;
+  case DISKANN_SIMD_AVX512:
+    return &avx512_kernels;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+/* What the host supports, detected once per process. Search workers and
+** shard threads open handles concurrently, so detection runs under
+** pthread_once (InitOnceExecuteOnce on Windows) instead of racing. */
+typedef struct SimdHost {
+  int hw_level; /* highest level the CPU and this build support */
+  int selected; /* hw_level lowered by DISKANN_SIMD */
+  int f16c;     /* binary16 conversion available */
+} SimdHost;
+
+static SimdHost host;
+
+static void detect_host(void) {
+  host.hw_level = detect_hw_level();
+  host.f16c = detect_hw_f16c();
+  int level = host.hw_level;
+  int requested = parse_simd_env();
+  if (requested >= 0 && requested < level) {
+    level = requested;
+  }
+  /* Walk down to the nearest level compiled in for this architecture
+  ** (e.g., DISKANN_SIMD=neon on x86 lands on scalar) */
+  while (level > DISKANN_SIMD_SCALAR && compiled_kernels(level) == NULL) {
+    level--;
+  }
+  host.selected = level;
+}
+
+#ifdef _WIN32
+static INIT_ONCE host_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK detect_host_once(PINIT_ONCE once, PVOID param,
+                                      PVOID *context) {
+  (void)once;
+  (void)param;
+  (void)context;
+  detect_host();
+  return TRUE;
+}
+
+static const SimdHost *simd_host(void) {
+  InitOnceExecuteOnce(&host_once, detect_host_once, NULL, NULL);
+  return &host;
+}
+#else
+static pthread_once_t host_once = PTHREAD_ONCE_INIT;
+
+static const SimdHost *simd_host(void) {
+  pthread_once(&host_once, detect_host);
+  return &host;
+}
+#endif
+
+const DiskAnnDistanceKernels *diskann_simd_kernels(int level) {
+  if (level > simd_host()->hw_level) {
+    return NULL;
+  }
+  return compiled_kernels(level);
+}
+
+int diskann_simd_level(void) { return simd_host()->selected; }
+
+DiskAnnHalfDistanceFn diskann_simd_half_fn(int level, uint8_t vector_type,
+                                           uint8_t metric) {
+  const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+  if (k == NULL ||
+      (vector_type == DISKANN_VECTOR_FLOAT16 && !simd_host()->f16c)) {
+    k = &scalar_kernels;
+  }
+  int l2 = metric == DISKANN_METRIC_EUCLIDEAN;
+  switch (vector_type) {
+  case DISKANN_VECTOR_FLOAT16:
+    return l2 ? k->l2_f16 : k->dot_f16;
+  case DISKANN_VECTOR_BFLOAT16:
+    return l2 ? k->l2_bf16 : k->dot_bf16;
+  default:
+    return NULL;
+  }
+}
+
+DiskAnnDistanceFn diskann_simd_distance_fn(int level, uint8_t metric) {
+  const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+  if (k == NULL) {
+    k = &scalar_kernels;
+  }
+  switch (metric) {
+  case DISKANN_METRIC_EUCLIDEAN:
+    return k->l2;
+  case DISKANN_METRIC_COSINE:
+    return k->cosine;
+  case DISKANN_METRIC_DOT:
+    return k->neg_dot;
+  default:
+    return NULL;
+  }
+}
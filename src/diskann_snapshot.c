@@ -0,0 +1,428 @@
+/*
+** DiskANN read-only graph snapshots
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#define _POSIX_C_SOURCE 200809L
+#include "diskann_snapshot.h"
+#include "diskann.h"
+#include "diskann_blob.h"
+#include "diskann_internal.h"
+#include "diskann_sqlite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**************************************************************************
+** Lookup
+**************************************************************************/
+
+/* Index of rowid in snap->rowids, or -1 */
+static int64_t snapshot_find(const DiskAnnSnapshot *snap, int64_t rowid) {
+  if (snap->n_rows == 0) {
+    return -1;
+  }
+  if (snap->dense) {
+    if (rowid < snap->rowids[0]) {
+      return -1;
+    }
+    uint64_t i = (uint64_t)rowid - (uint64_t)snap->rowids[0];
+    return i < snap->n_rows ? (int64_t)i : -1;
+  }
+  uint64_t lo = 0, hi = snap->n_rows;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (snap->rowids[mid] < rowid) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < snap->n_rows && snap->rowids[lo] == rowid ? (int64_t)lo : -1;
+}
+
+uint8_t *diskann_snapshot_block(const DiskAnnSnapshot *snap, int64_t rowid) {
+  int64_t i = snapshot_find(snap, rowid);
+  if (i < 0) {
+    return NULL;
+  }
+  return snap->blocks + (size_t)i * snap->block_size;
+}
+
+int diskann_snapshot_load(const DiskAnnSnapshot *snap, uint64_t rowid,
+                          BlobSpot **spot) {
+  uint8_t *block = diskann_snapshot_block(snap, (int64_t)rowid);
+  if (!block) {
+    return DISKANN_ROW_NOT_FOUND;
+  }
+  if (*spot == NULL) {
+    BlobSpot *s = (BlobSpot *)sqlite3_malloc(sizeof(BlobSpot));
+    if (!s) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    memset(s, 0, sizeof(BlobSpot));
+    s->buffer_size = snap->block_size;
+    s->is_aborted = 1; /* never backed by a BLOB handle */
+    s->is_mapped = 1;
+    s->refcount = 1;
+    *spot = s;
+  }
+  (*spot)->buffer = block;
+  (*spot)->rowid = rowid;
+  (*spot)->is_initialized = 1;
+  return DISKANN_OK;
+}
+
+/**************************************************************************
+** Export
+**************************************************************************/
+
+/* Append rowid to a growable array */
+static int rowids_push(int64_t **rowids, uint64_t *n, uint64_t *capacity,
+                       int64_t rowid) {
+  if (*n == *capacity) {
+    uint64_t grown = *capacity ? *capacity * 2 : 1024;
+    int64_t *p =
+        (int64_t *)sqlite3_realloc64(*rowids, grown * sizeof(int64_t));
+    if (!p) {
+      return DISKANN_ERROR_NOMEM;
+    }
+    *rowids = p;
+    *capacity = grown;
+  }
+  (*rowids)[(*n)++] = rowid;
+  return DISKANN_OK;
+}
+
+/* Replace path with the finished temporary file */
+static int snapshot_install(const char *tmp, const char *path) {
+#ifdef _WIN32
+  return MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) ? DISKANN_OK
+                                                           : DISKANN_ERROR_IO;
+#else
+  return rename(tmp, path) == 0 ? DISKANN_OK : DISKANN_ERROR_IO;
+#endif
+}
+
+int diskann_export_snapshot(DiskAnnIndex *idx, const char *path) {
+  static const uint8_t zeros[DISKANN_SNAPSHOT_PAGE];
+  DiskAnnSnapshotHeader header;
+  DiskAnnSnapshot found;
+  sqlite3_stmt *stmt = NULL;
+  int64_t *rowids = NULL;
+  uint64_t n_rows = 0, capacity = 0;
+  FILE *f = NULL;
+  char *tmp = NULL;
+  int rc = DISKANN_OK;
+
+  /* Deletes queued in batch mode are not on disk yet */
+  if (!idx || !path || !idx->db || idx->batch_cache) {
+    return DISKANN_ERROR_INVALID;
+  }
+  /* The header carries the INT8 range the stored edges were encoded in */
+  rc = diskann_prepare_quant_range(idx, NULL, 0);
+  if (rc != DISKANN_OK) {
+    return rc;
+  }
+
+  char *sql = sqlite3_mprintf("SELECT id, data FROM \"%w\".\"%w\" ORDER BY id",
+                              idx->db_name, idx->shadow_name);
+  tmp = sqlite3_mprintf("%s.tmp", path);
+  if (!sql || !tmp) {
+    sqlite3_free(sql);
+    sqlite3_free(tmp);
+    return DISKANN_ERROR_NOMEM;
+  }
+  int sqlite_rc = sqlite3_prepare_v2(idx->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (sqlite_rc != SQLITE_OK) {
+    sqlite3_free(tmp);
+    return DISKANN_ERROR;
+  }
+
+  f = fopen(tmp, "wb");
+  if (!f) {
+    rc = DISKANN_ERROR_IO;
+    goto out;
+  }
+
+  /* Header page first (rewritten at the end), then blocks in one pass of
+  ** one statement, so blocks and rowids come from the same read */
+  if (fwrite(zeros, 1, sizeof(zeros), f) != sizeof(zeros)) {
+    rc = DISKANN_ERROR_IO;
+    goto out;
+  }
+  while ((sqlite_rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const void *data = sqlite3_column_blob(stmt, 1);
+    int bytes = sqlite3_column_bytes(stmt, 1);
+    if (!data || bytes != (int)idx->block_size) {
+      rc = DISKANN_ERROR;
+      goto out;
+    }
+    rc = rowids_push(&rowids, &n_rows, &capacity,
+                     sqlite3_column_int64(stmt, 0));
+    if (rc != DISKANN_OK) {
+      goto out;
+    }
+    if (fwrite(data, 1, (size_t)bytes, f) != (size_t)bytes) {
+      rc = DISKANN_ERROR_IO;
+      goto out;
+    }
+  }
+  if (sqlite_rc != SQLITE_DONE) {
+    rc = DISKANN_ERROR;
+    goto out;
+  }
+  if (n_rows > 0 &&
+      fwrite(rowids, sizeof(int64_t), (size_t)n_rows, f) != (size_t)n_rows) {
+    rc = DISKANN_ERROR_IO;
+    goto out;
+  }
+
+  /* Keep the handle's entry point if the file holds it, else the first
+  ** row: a snapshot cannot fall back to a random row */
+  memset(&found, 0, sizeof(found));
+  found.rowids = rowids;
+  found.n_rows = n_rows;
+  int64_t entry = 0;
+  if (idx->has_entry && snapshot_find(&found, idx->entry_rowid) >= 0) {
+    entry = idx->entry_rowid;
+  } else if (n_rows > 0) {
+    entry = rowids[0];
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DISKANN_SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = DISKANN_SNAPSHOT_VERSION;
+  header.byte_order = DISKANN_SNAPSHOT_BYTE_ORDER;
+  header.dimensions = idx->dimensions;
+  header.max_neighbors = idx->max_neighbors;
+  header.search_list_size = idx->search_list_size;
+  header.insert_list_size = idx->insert_list_size;
+  header.block_size = idx->block_size;
+  header.metric = idx->metric;
+  header.edge_type = idx->edge_type;
+  header.vector_type = idx->vector_type;
+  header.quant_min = idx->quant_min;
+  header.quant_scale = idx->quant_scale;
+  header.pruning_alpha = idx->pruning_alpha;
+  header.entry_rowid = entry;
+  header.n_rows = n_rows;
+  header.blocks_offset = DISKANN_SNAPSHOT_PAGE;
+  header.rowids_offset =
+      header.blocks_offset + n_rows * (uint64_t)idx->block_size;
+  header.file_size = header.rowids_offset + n_rows * sizeof(int64_t);
+  if (fseek(f, 0, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(header), 1, f) != 1) {
+    rc = DISKANN_ERROR_IO;
+    goto out;
+  }
+
+out:
+  sqlite3_finalize(stmt);
+  sqlite3_free(rowids);
+  if (f && fclose(f) != 0 && rc == DISKANN_OK) {
+    rc = DISKANN_ERROR_IO;
+  }
+  if (rc == DISKANN_OK) {
+    rc = snapshot_install(tmp, path);
+  }
+  if (rc != DISKANN_OK) {
+    remove(tmp);
+  }
+  sqlite3_free(tmp);
+  return rc;
+}
+
+/**************************************************************************
+** Open
+**************************************************************************/
+
+/* Map path read-only into snap->base / size / os_handle */
+static int snapshot_map(DiskAnnSnapshot *snap, const char *path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER size;
+  if (file == INVALID_HANDLE_VALUE) {
+    return DISKANN_ERROR_IO;
+  }
+  if (!GetFileSizeEx(file, &size) ||
+      (uint64_t)size.QuadPart < sizeof(DiskAnnSnapshotHeader)) {
+    CloseHandle(file);
+    return DISKANN_ERROR_VERSION;
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping) {
+    return DISKANN_ERROR_IO;
+  }
+  void *base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!base) {
+    CloseHandle(mapping);
+    return DISKANN_ERROR_IO;
+  }
+  snap->base = (uint8_t *)base;
+  snap->size = (uint64_t)size.QuadPart;
+  snap->os_handle = mapping;
+  return DISKANN_OK;
+#else
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return DISKANN_ERROR_IO;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return DISKANN_ERROR_IO;
+  }
+  if ((uint64_t)st.st_size < sizeof(DiskAnnSnapshotHeader)) {
+    close(fd);
+    return DISKANN_ERROR_VERSION;
+  }
+  void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); /* the mapping keeps the file */
+  if (base == MAP_FAILED) {
+    return DISKANN_ERROR_IO;
+  }
+  snap->base = (uint8_t *)base;
+  snap->size = (uint64_t)st.st_size;
+  return DISKANN_OK;
+#endif
+}
+
+void diskann_snapshot_close(DiskAnnSnapshot *snap) {
+  if (!snap) {
+    return;
+  }
+  if (snap->base) {
+#ifdef _WIN32
+    UnmapViewOfFile(snap->base);
+    CloseHandle((HANDLE)snap->os_handle);
+#else
+    munmap(snap->base, (size_t)snap->size);
+#endif
+  }
+  sqlite3_free(snap);
+}
+
+/*
+** Check the header against the file and the layouts this build reads.
+** Returns DISKANN_OK, DISKANN_ERROR_VERSION for another format, or
+** DISKANN_ERROR for a damaged file.
+*/
+static int snapshot_validate(const DiskAnnSnapshot *snap,
+                             const DiskAnnSnapshotHeader *h) {
+  if (memcmp(h->magic, DISKANN_SNAPSHOT_MAGIC, sizeof(h->magic)) != 0 ||
+      h->version != DISKANN_SNAPSHOT_VERSION ||
+      h->byte_order != DISKANN_SNAPSHOT_BYTE_ORDER) {
+    return DISKANN_ERROR_VERSION;
+  }
+  if (h->dimensions == 0 || h->block_size == 0 ||
+      h->metric > DISKANN_METRIC_DOT || h->edge_type > DISKANN_EDGE_INT8 ||
+      h->vector_type > DISKANN_VECTOR_BFLOAT16) {
+    return DISKANN_ERROR;
+  }
+  /* Sections in order, inside the file, without overflow */
+  uint64_t n = h->n_rows;
+  if (h->blocks_offset < sizeof(*h) || h->blocks_offset > h->file_size ||
+      h->file_size != snap->size || h->rowids_offset % sizeof(int64_t) ||
+      n > (h->file_size - h->blocks_offset) / h->block_size ||
+      h->rowids_offset != h->blocks_offset + n * h->block_size ||
+      n > (h->file_size - h->rowids_offset) / sizeof(int64_t) ||
+      h->file_size != h->rowids_offset + n * sizeof(int64_t)) {
+    return DISKANN_ERROR;
+  }
+  return DISKANN_OK;
+}
+
+int diskann_open_snapshot(const char *path, DiskAnnIndex **out) {
+  DiskAnnSnapshotHeader h;
+  DiskAnnSnapshot *snap = NULL;
+  DiskAnnIndex *idx = NULL;
+  int rc;
+
+  if (!out) {
+    return DISKANN_ERROR_INVALID;
+  }
+  *out = NULL;
+  if (!path) {
+    return DISKANN_ERROR_INVALID;
+  }
+
+  snap = (DiskAnnSnapshot *)sqlite3_malloc(sizeof(DiskAnnSnapshot));
+  if (!snap) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  memset(snap, 0, sizeof(*snap));
+  rc = snapshot_map(snap, path);
+  if (rc != DISKANN_OK) {
+    goto fail;
+  }
+  memcpy(&h, snap->base, sizeof(h));
+  rc = snapshot_validate(snap, &h);
+  if (rc != DISKANN_OK) {
+    goto fail;
+  }
+
+  snap->rowids = (const int64_t *)(snap->base + h.rowids_offset);
+  snap->blocks = snap->base + h.blocks_offset;
+  snap->n_rows = h.n_rows;
+  snap->block_size = h.block_size;
+  snap->dense = 1;
+  for (uint64_t i = 1; i < h.n_rows; i++) {
+    if (snap->rowids[i] <= snap->rowids[i - 1]) {
+      rc = DISKANN_ERROR; /* lookups need ascending rowids */
+      goto fail;
+    }
+    if (snap->rowids[i] != snap->rowids[i - 1] + 1) {
+      snap->dense = 0;
+    }
+  }
+  if (h.n_rows > 0 && snapshot_find(snap, h.entry_rowid) < 0) {
+    rc = DISKANN_ERROR;
+    goto fail;
+  }
+
+  idx = (DiskAnnIndex *)malloc(sizeof(DiskAnnIndex));
+  if (!idx) {
+    rc = DISKANN_ERROR_NOMEM;
+    goto fail;
+  }
+  memset(idx, 0, sizeof(DiskAnnIndex));
+  idx->dimensions = h.dimensions;
+  idx->metric = (uint8_t)h.metric;
+  idx->max_neighbors = h.max_neighbors;
+  idx->search_list_size = h.search_list_size;
+  idx->insert_list_size = h.insert_list_size;
+  idx->block_size = h.block_size;
+  idx->pruning_alpha = h.pruning_alpha;
+  idx->edge_type = (uint8_t)h.edge_type;
+  idx->vector_type = (uint8_t)h.vector_type;
+  idx->quant_min = h.quant_min;
+  idx->quant_scale = h.quant_scale;
+  diskann_init_derived(idx);
+
+  /* Everything searches ask SQLite for is known up front */
+  idx->has_entry = h.n_rows > 0;
+  idx->entry_rowid = h.entry_rowid;
+  idx->cached_max_rowid = h.n_rows > 0 ? snap->rowids[h.n_rows - 1] : 0;
+  idx->snapshot = snap;
+  *out = idx;
+  return DISKANN_OK;
+
+fail:
+  diskann_snapshot_close(snap);
+  return rc;
+}
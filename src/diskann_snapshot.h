@@ -0,0 +1,96 @@
+/*
+** DiskANN read-only graph snapshots
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** diskann_export_snapshot() copies every node block of an index into a
+** flat file that diskann_open_snapshot() maps read-only. Searches on the
+** snapshot handle read blocks in place from the mapping: no BLOB handle,
+** no B-tree descent and no copy into a BlobSpot buffer. SQLite stays the
+** source of truth; a snapshot is a point-in-time copy, rebuilt by
+** exporting again (the new file replaces the old one by rename, so open
+** mappings of the old file stay valid).
+**
+** File layout (host byte order, checked on open):
+**   [0, DISKANN_SNAPSHOT_PAGE)      DiskAnnSnapshotHeader, zero padded
+**   blocks_offset (page aligned)    n_rows blocks, block_size bytes each,
+**                                   in ascending rowid order
+**   rowids_offset                   n_rows int64 rowids, ascending
+**
+** Block i belongs to rowids[i]. Rowids without gaps are found by
+** subtraction, others by binary search.
+*/
+#ifndef DISKANN_SNAPSHOT_H
+#define DISKANN_SNAPSHOT_H
+
+#include "diskann_blob.h"
+#include "diskann_internal.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISKANN_SNAPSHOT_MAGIC "DANNSNAP"
+#define DISKANN_SNAPSHOT_VERSION 1
+#define DISKANN_SNAPSHOT_PAGE 4096
+#define DISKANN_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/* On-disk header; every field has a fixed width, with no padding holes */
+typedef struct DiskAnnSnapshotHeader {
+  char magic[8];       /* DISKANN_SNAPSHOT_MAGIC, not NUL terminated */
+  uint32_t version;    /* DISKANN_SNAPSHOT_VERSION */
+  uint32_t byte_order; /* DISKANN_SNAPSHOT_BYTE_ORDER as written */
+  uint32_t dimensions;
+  uint32_t max_neighbors;
+  uint32_t search_list_size;
+  uint32_t insert_list_size;
+  uint32_t block_size;
+  uint32_t metric;      /* DISKANN_METRIC_* */
+  uint32_t edge_type;   /* DISKANN_EDGE_* */
+  uint32_t vector_type; /* DISKANN_VECTOR_*; 0 (float32) in older files */
+  float quant_min; /* INT8 edge range, as on the index handle */
+  float quant_scale;
+  double pruning_alpha;
+  int64_t entry_rowid; /* search entry point (a rowid in the file) */
+  uint64_t n_rows;
+  uint64_t blocks_offset;
+  uint64_t rowids_offset;
+  uint64_t file_size;
+} DiskAnnSnapshotHeader;
+
+/*
+** An open mapping. Memory ownership: the mapping is released by
+** diskann_snapshot_close(); rowids and blocks point into it.
+*/
+typedef struct DiskAnnSnapshot {
+  uint8_t *base; /* whole file, mapped read-only */
+  uint64_t size;
+  const int64_t *rowids; /* n_rows, ascending */
+  uint8_t *blocks;       /* n_rows * block_size */
+  uint64_t n_rows;
+  uint32_t block_size;
+  int dense;       /* rowids[i] == rowids[0] + i for every row */
+  void *os_handle; /* Windows file mapping handle; NULL elsewhere */
+} DiskAnnSnapshot;
+
+/* Block of rowid in the mapping, or NULL if the snapshot lacks it */
+uint8_t *diskann_snapshot_block(const DiskAnnSnapshot *snap, int64_t rowid);
+
+/*
+** Point *spot at rowid's mapped block, creating the spot on first use
+** (release it with blob_spot_free(), which leaves the mapping alone).
+** Returns DISKANN_OK, DISKANN_ROW_NOT_FOUND or DISKANN_ERROR_NOMEM.
+*/
+int diskann_snapshot_load(const DiskAnnSnapshot *snap, uint64_t rowid,
+                          BlobSpot **spot);
+
+/* Unmap snap and free it. NULL-safe. */
+void diskann_snapshot_close(DiskAnnSnapshot *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_SNAPSHOT_H */
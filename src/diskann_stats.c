@@ -0,0 +1,485 @@
+/*
+** DiskANN statistics — counters, latency histograms and the
+** "<table>_stats" virtual table
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#define _POSIX_C_SOURCE 199309L
+#include "diskann_stats.h"
+#include "diskann.h"
+#include "diskann_cache.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t diskann_clock_us(void) {
+#ifdef _WIN32
+  LARGE_INTEGER now, freq;
+  QueryPerformanceCounter(&now);
+  QueryPerformanceFrequency(&freq);
+  uint64_t ticks = (uint64_t)now.QuadPart;
+  uint64_t hz = (uint64_t)freq.QuadPart;
+  return ticks / hz * 1000000u + ticks % hz * 1000000u / hz;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+/**************************************************************************
+** Histograms
+**
+** Latency bucket b holds durations in [lo(b), lo(b) + width(b)) us: one
+** bucket per microsecond below 4, then 4 per power of two, so any sample
+** is within 12.5% of its bucket's midpoint.
+**************************************************************************/
+
+static int floor_log2(uint64_t v) {
+  int b = 0;
+  while (v >>= 1) {
+    b++;
+  }
+  return b;
+}
+
+static int latency_bucket(uint64_t us) {
+  if (us < 4) {
+    return (int)us;
+  }
+  int b = floor_log2(us);
+  int bucket = (b - 1) * 4 + (int)((us >> (b - 2)) & 3);
+  return bucket < DISKANN_LATENCY_BUCKETS ? bucket
+                                          : DISKANN_LATENCY_BUCKETS - 1;
+}
+
+/* Midpoint of bucket (its lower bound for the open-ended last one) */
+static double latency_bucket_value(int bucket) {
+  if (bucket < 4) {
+    return (double)bucket;
+  }
+  int b = bucket / 4 + 1;
+  double width = (double)((uint64_t)1 << (b - 2));
+  double lo = (double)(4 + bucket % 4) * width;
+  return bucket == DISKANN_LATENCY_BUCKETS - 1 ? lo : lo + width / 2;
+}
+
+/* The q-quantile (0 < q <= 1) of a histogram, 0 when it is empty */
+static double latency_quantile(const uint64_t *hist, double q) {
+  uint64_t total = 0;
+  for (int i = 0; i < DISKANN_LATENCY_BUCKETS; i++) {
+    total += hist[i];
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+  /* Rank of the sample, 1-based: ceil(q * total) */
+  uint64_t rank = (uint64_t)((double)total * q);
+  if ((double)rank < (double)total * q || rank == 0) {
+    rank++;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < DISKANN_LATENCY_BUCKETS; i++) {
+    seen += hist[i];
+    if (seen >= rank) {
+      return latency_bucket_value(i);
+    }
+  }
+  return latency_bucket_value(DISKANN_LATENCY_BUCKETS - 1);
+}
+
+/**************************************************************************
+** Recording
+**************************************************************************/
+
+void diskann_stats_searches(DiskAnnIndex *idx, uint64_t elapsed_us, int n) {
+  if (n <= 0) {
+    return;
+  }
+  uint64_t per_query = elapsed_us / (uint64_t)n;
+  idx->counters.searches += (uint64_t)n;
+  idx->counters.search_us[latency_bucket(per_query)] += (uint64_t)n;
+}
+
+void diskann_stats_walk(DiskAnnIndex *idx, uint32_t n_visited) {
+  int bucket = n_visited > 1 ? floor_log2(n_visited) : 0;
+  if (bucket >= DISKANN_STATS_VISITED_BUCKETS) {
+    bucket = DISKANN_STATS_VISITED_BUCKETS - 1;
+  }
+  idx->counters.nodes_visited += n_visited;
+  idx->counters.visited[bucket]++;
+}
+
+void diskann_stats_insert(DiskAnnIndex *idx, uint64_t elapsed_us) {
+  idx->counters.inserts++;
+  idx->counters.insert_us[latency_bucket(elapsed_us)]++;
+}
+
+void diskann_stats_fold_cache(DiskAnnIndex *idx, const BlobCache *cache) {
+  if (cache) {
+    idx->counters.insert_cache_hits += cache->hits;
+    idx->counters.insert_cache_misses += cache->misses;
+  }
+}
+
+void diskann_counters_merge(DiskAnnCounters *into,
+                            const DiskAnnCounters *from) {
+  into->searches += from->searches;
+  into->nodes_visited += from->nodes_visited;
+  for (int i = 0; i < DISKANN_STATS_VISITED_BUCKETS; i++) {
+    into->visited[i] += from->visited[i];
+  }
+  into->zombie_edges += from->zombie_edges;
+  into->inserts += from->inserts;
+  into->insert_cache_hits += from->insert_cache_hits;
+  into->insert_cache_misses += from->insert_cache_misses;
+  for (int i = 0; i < DISKANN_LATENCY_BUCKETS; i++) {
+    into->search_us[i] += from->search_us[i];
+    into->insert_us[i] += from->insert_us[i];
+  }
+}
+
+/**************************************************************************
+** Public API
+**************************************************************************/
+
+int diskann_stats(DiskAnnIndex *idx, DiskAnnStats *out) {
+  if (!idx || !out) {
+    return DISKANN_ERROR_INVALID;
+  }
+  const DiskAnnCounters *c = &idx->counters;
+
+  diskann_reader_sync(idx);
+  memset(out, 0, sizeof(*out));
+  out->blocks_read = idx->num_reads;
+  out->blocks_written = idx->num_writes;
+  out->bytes_read = idx->num_read_bytes;
+  out->bytes_written = idx->num_write_bytes;
+  if (idx->read_cache) {
+    sqlite3_mutex_enter(idx->read_cache->mutex);
+    out->read_cache_hits = idx->read_cache->hits;
+    out->read_cache_misses = idx->read_cache->misses;
+    sqlite3_mutex_leave(idx->read_cache->mutex);
+  }
+  /* A batch in progress has not folded its cache yet */
+  out->insert_cache_hits = c->insert_cache_hits;
+  out->insert_cache_misses = c->insert_cache_misses;
+  if (idx->batch_cache) {
+    out->insert_cache_hits += idx->batch_cache->hits;
+    out->insert_cache_misses += idx->batch_cache->misses;
+  }
+  out->searches = c->searches;
+  out->nodes_visited = c->nodes_visited;
+  memcpy(out->visited, c->visited, sizeof(out->visited));
+  out->zombie_edges = c->zombie_edges;
+  out->inserts = c->inserts;
+  out->search_p50_us = latency_quantile(c->search_us, 0.50);
+  out->search_p99_us = latency_quantile(c->search_us, 0.99);
+  out->insert_p50_us = latency_quantile(c->insert_us, 0.50);
+  out->insert_p99_us = latency_quantile(c->insert_us, 0.99);
+  return DISKANN_OK;
+}
+
+int diskann_stats_reset(DiskAnnIndex *idx) {
+  if (!idx) {
+    return DISKANN_ERROR_INVALID;
+  }
+  idx->num_reads = 0;
+  idx->num_writes = 0;
+  idx->num_read_bytes = 0;
+  idx->num_write_bytes = 0;
+  memset(&idx->counters, 0, sizeof(idx->counters));
+  if (idx->batch_cache) {
+    /* Its counts are added at diskann_end_batch() */
+    idx->counters.insert_cache_hits -= idx->batch_cache->hits;
+    idx->counters.insert_cache_misses -= idx->batch_cache->misses;
+  }
+  return DISKANN_OK;
+}
+
+/**************************************************************************
+** "<table>_stats" virtual table
+**
+** An eponymous-only module registered per diskann table (no CREATE
+** VIRTUAL TABLE needed): SELECT stat, value FROM <table>_stats. The
+** module's DiskAnnStatsLink is shared with the table, which clears it
+** when its handle closes; SQLite keeps the module (and the link) alive
+** while a statement still uses it.
+**************************************************************************/
+
+struct DiskAnnStatsLink {
+  DiskAnnIndex *idx; /* NULL once the table's handle closed */
+  int refs;          /* table + module */
+};
+
+static void stats_link_release(void *p) {
+  DiskAnnStatsLink *link = (DiskAnnStatsLink *)p;
+  if (--link->refs == 0) {
+    sqlite3_free(link);
+  }
+}
+
+/* A fixed output row: a counter, or a value derived from counters. The
+** visited[] buckets follow the fixed rows. */
+typedef enum StatsKind {
+  STATS_U64,  /* uint64_t at offset */
+  STATS_REAL, /* double at offset */
+  STATS_RATIO /* u64 at offset / (it + u64 at offset2), NULL if 0 */
+} StatsKind;
+
+typedef struct StatsRow {
+  const char *name;
+  StatsKind kind;
+  size_t offset;
+  size_t offset2;
+} StatsRow;
+
+#define STATS_U64_ROW(field)                                                   \
+  { #field, STATS_U64, offsetof(DiskAnnStats, field), 0 }
+#define STATS_REAL_ROW(field)                                                  \
+  { #field, STATS_REAL, offsetof(DiskAnnStats, field), 0 }
+
+static const StatsRow stats_rows[] = {
+    STATS_U64_ROW(blocks_read),
+    STATS_U64_ROW(blocks_written),
+    STATS_U64_ROW(bytes_read),
+    STATS_U64_ROW(bytes_written),
+    STATS_U64_ROW(read_cache_hits),
+    STATS_U64_ROW(read_cache_misses),
+    {"read_cache_hit_rate", STATS_RATIO,
+     offsetof(DiskAnnStats, read_cache_hits),
+     offsetof(DiskAnnStats, read_cache_misses)},
+    STATS_U64_ROW(insert_cache_hits),
+    STATS_U64_ROW(insert_cache_misses),
+    {"insert_cache_hit_rate", STATS_RATIO,
+     offsetof(DiskAnnStats, insert_cache_hits),
+     offsetof(DiskAnnStats, insert_cache_misses)},
+    STATS_U64_ROW(searches),
+    STATS_U64_ROW(nodes_visited),
+    STATS_U64_ROW(zombie_edges),
+    STATS_REAL_ROW(search_p50_us),
+    STATS_REAL_ROW(search_p99_us),
+    STATS_U64_ROW(inserts),
+    STATS_REAL_ROW(insert_p50_us),
+    STATS_REAL_ROW(insert_p99_us),
+};
+
+#define STATS_N_FIXED ((int)(sizeof(stats_rows) / sizeof(stats_rows[0])))
+#define STATS_N_ROWS (STATS_N_FIXED + DISKANN_STATS_VISITED_BUCKETS)
+
+typedef struct stats_vtab {
+  sqlite3_vtab base;
+  DiskAnnStatsLink *link;
+} stats_vtab;
+
+typedef struct stats_cursor {
+  sqlite3_vtab_cursor base;
+  DiskAnnStats stats;
+  int row;
+} stats_cursor;
+
+static int statsConnect(sqlite3 *db, void *pAux, int argc,
+                        const char *const *argv, sqlite3_vtab **ppVtab,
+                        char **pzErr) {
+  (void)argc;
+  (void)argv;
+  (void)pzErr;
+  int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(stat TEXT, value)");
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  stats_vtab *p = sqlite3_malloc(sizeof(*p));
+  if (!p) {
+    return SQLITE_NOMEM;
+  }
+  memset(p, 0, sizeof(*p));
+  p->link = (DiskAnnStatsLink *)pAux; /* the module holds a reference */
+  *ppVtab = &p->base;
+  return SQLITE_OK;
+}
+
+static int statsDisconnect(sqlite3_vtab *pVtab) {
+  sqlite3_free(pVtab);
+  return SQLITE_OK;
+}
+
+static int statsBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
+  (void)pVtab;
+  pInfo->estimatedCost = (double)STATS_N_ROWS;
+  pInfo->estimatedRows = STATS_N_ROWS;
+  return SQLITE_OK;
+}
+
+static int statsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  (void)pVtab;
+  stats_cursor *cur = sqlite3_malloc(sizeof(*cur));
+  if (!cur) {
+    return SQLITE_NOMEM;
+  }
+  memset(cur, 0, sizeof(*cur));
+  *ppCursor = &cur->base;
+  return SQLITE_OK;
+}
+
+static int statsClose(sqlite3_vtab_cursor *pCursor) {
+  sqlite3_free(pCursor);
+  return SQLITE_OK;
+}
+
+static int statsFilter(sqlite3_vtab_cursor *pCursor, int idxNum,
+                       const char *idxStr, int argc, sqlite3_value **argv) {
+  (void)idxNum;
+  (void)idxStr;
+  (void)argc;
+  (void)argv;
+  stats_cursor *cur = (stats_cursor *)pCursor;
+  stats_vtab *p = (stats_vtab *)pCursor->pVtab;
+  if (!p->link->idx) {
+    sqlite3_free(p->base.zErrMsg);
+    p->base.zErrMsg =
+        sqlite3_mprintf("diskann: the table of this stats view is not open");
+    return SQLITE_ERROR;
+  }
+  (void)diskann_stats(p->link->idx, &cur->stats);
+  cur->row = 0;
+  return SQLITE_OK;
+}
+
+static int statsNext(sqlite3_vtab_cursor *pCursor) {
+  ((stats_cursor *)pCursor)->row++;
+  return SQLITE_OK;
+}
+
+static int statsEof(sqlite3_vtab_cursor *pCursor) {
+  return ((stats_cursor *)pCursor)->row >= STATS_N_ROWS;
+}
+
+static uint64_t stats_u64(const DiskAnnStats *s, size_t offset) {
+  uint64_t v;
+  memcpy(&v, (const char *)s + offset, sizeof(v));
+  return v;
+}
+
+static void stats_value(sqlite3_context *ctx, const DiskAnnStats *s,
+                        const StatsRow *row) {
+  switch (row->kind) {
+  case STATS_U64:
+    sqlite3_result_int64(ctx, (sqlite3_int64)stats_u64(s, row->offset));
+    break;
+  case STATS_REAL: {
+    double v;
+    memcpy(&v, (const char *)s + row->offset, sizeof(v));
+    sqlite3_result_double(ctx, v);
+    break;
+  }
+  case STATS_RATIO: {
+    uint64_t hits = stats_u64(s, row->offset);
+    uint64_t total = hits + stats_u64(s, row->offset2);
+    if (total == 0) {
+      sqlite3_result_null(ctx);
+    } else {
+      sqlite3_result_double(ctx, (double)hits / (double)total);
+    }
+    break;
+  }
+  }
+}
+
+static int statsColumn(sqlite3_vtab_cursor *pCursor, sqlite3_context *ctx,
+                       int col) {
+  stats_cursor *cur = (stats_cursor *)pCursor;
+  int bucket = cur->row - STATS_N_FIXED;
+
+  if (col == 0) {
+    if (bucket < 0) {
+      sqlite3_result_text(ctx, stats_rows[cur->row].name, -1, SQLITE_STATIC);
+    } else if (bucket < DISKANN_STATS_VISITED_BUCKETS - 1) {
+      /* Named by the bucket's exclusive upper bound */
+      sqlite3_result_text(ctx,
+                          sqlite3_mprintf("visited_lt_%llu",
+                                          1ULL << (bucket + 1)),
+                          -1, sqlite3_free);
+    } else {
+      sqlite3_result_text(ctx,
+                          sqlite3_mprintf("visited_ge_%llu", 1ULL << bucket),
+                          -1, sqlite3_free);
+    }
+  } else if (bucket < 0) {
+    stats_value(ctx, &cur->stats, &stats_rows[cur->row]);
+  } else {
+    sqlite3_result_int64(ctx, (sqlite3_int64)cur->stats.visited[bucket]);
+  }
+  return SQLITE_OK;
+}
+
+static int statsRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid) {
+  *pRowid = ((stats_cursor *)pCursor)->row + 1;
+  return SQLITE_OK;
+}
+
+/* xCreate NULL: eponymous-only, CREATE VIRTUAL TABLE is refused */
+static sqlite3_module statsModule = {
+    0,               /* iVersion */
+    NULL,            /* xCreate */
+    statsConnect,    /* xConnect */
+    statsBestIndex,  /* xBestIndex */
+    statsDisconnect, /* xDisconnect */
+    NULL,            /* xDestroy */
+    statsOpen,       /* xOpen */
+    statsClose,      /* xClose */
+    statsFilter,     /* xFilter */
+    statsNext,       /* xNext */
+    statsEof,        /* xEof */
+    statsColumn,     /* xColumn */
+    statsRowid,      /* xRowid */
+    NULL,            /* xUpdate */
+    NULL,            /* xBegin */
+    NULL,            /* xSync */
+    NULL,            /* xCommit */
+    NULL,            /* xRollback */
+    NULL,            /* xFindFunction */
+    NULL,            /* xRename */
+    NULL,            /* xSavepoint */
+    NULL,            /* xRelease */
+    NULL,            /* xRollbackTo */
+    NULL,            /* xShadowName */
+    NULL,            /* xIntegrity */
+};
+
+int diskann_stats_register(sqlite3 *db, const char *table_name,
+                           DiskAnnIndex *idx, DiskAnnStatsLink **link) {
+  *link = NULL;
+  char *name = sqlite3_mprintf("%s_stats", table_name);
+  DiskAnnStatsLink *l = sqlite3_malloc(sizeof(*l));
+  if (!name || !l) {
+    sqlite3_free(name);
+    sqlite3_free(l);
+    return SQLITE_NOMEM;
+  }
+  l->idx = idx;
+  l->refs = 2;
+  /* Replaces a module left by an earlier handle of the same table; on
+  ** failure SQLite has already released the module's reference */
+  int rc = sqlite3_create_module_v2(db, name, &statsModule, l,
+                                    stats_link_release);
+  sqlite3_free(name);
+  if (rc != SQLITE_OK) {
+    stats_link_release(l);
+    return rc;
+  }
+  *link = l;
+  return SQLITE_OK;
+}
+
+void diskann_stats_unlink(DiskAnnStatsLink *link) {
+  if (link) {
+    link->idx = NULL;
+    stats_link_release(link);
+  }
+}
@@ -0,0 +1,68 @@
+/*
+** DiskANN statistics — per-handle counters behind diskann_stats()
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** Every index handle keeps a DiskAnnCounters block (diskann_internal.h)
+** that searches and inserts bump with plain increments: a handle is used
+** by one thread at a time, and batch-search workers fold their counters
+** into the caller's handle when they finish. Latencies go into
+** log-linear histograms (4 buckets per power of two microseconds), so
+** recording a sample is a clock read and one increment.
+**
+** The virtual table registers an eponymous "<table>_stats" module per
+** table on its connection (diskann_stats_register()), which reads the
+** counters of the table's open handle as (stat, value) rows.
+*/
+#ifndef DISKANN_STATS_H
+#define DISKANN_STATS_H
+
+#include "diskann_internal.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Monotonic clock in microseconds */
+uint64_t diskann_clock_us(void);
+
+/* n searches answered in elapsed_us (several queries answered together
+** record their average time) */
+void diskann_stats_searches(DiskAnnIndex *idx, uint64_t elapsed_us, int n);
+
+/* One graph walk that visited n_visited nodes */
+void diskann_stats_walk(DiskAnnIndex *idx, uint32_t n_visited);
+
+/* One successful insert that took elapsed_us */
+void diskann_stats_insert(DiskAnnIndex *idx, uint64_t elapsed_us);
+
+/* Add the hit/miss counters of an insert-side block cache about to be
+** freed */
+void diskann_stats_fold_cache(DiskAnnIndex *idx, const BlobCache *cache);
+
+/* Add every counter of from into into */
+void diskann_counters_merge(DiskAnnCounters *into,
+                            const DiskAnnCounters *from);
+
+/* Handle lookup shared by a table and its "<table>_stats" module */
+typedef struct DiskAnnStatsLink DiskAnnStatsLink;
+
+/*
+** Register (or replace) the eponymous "<table>_stats" module on db,
+** reading idx. The caller keeps *link until diskann_stats_unlink().
+** Returns a SQLITE_* code.
+*/
+int diskann_stats_register(sqlite3 *db, const char *table_name,
+                           DiskAnnIndex *idx, DiskAnnStatsLink **link);
+
+/* Detach the closing handle: the module then reports an error until the
+** table is opened again (NULL safe) */
+void diskann_stats_unlink(DiskAnnStatsLink *link);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_STATS_H */
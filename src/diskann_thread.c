@@ -0,0 +1,93 @@
+/*
+** DiskANN worker threads
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#define _POSIX_C_SOURCE 200809L
+#include "diskann_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct WorkerStart {
+  DiskAnnWorkerFn fn;
+  void *arg;
+} WorkerStart;
+
+#ifdef _WIN32
+typedef HANDLE WorkerThread;
+
+static DWORD WINAPI worker_main(LPVOID p) {
+  WorkerStart *start = (WorkerStart *)p;
+  start->fn(start->arg);
+  return 0;
+}
+
+static int worker_start(WorkerThread *t, WorkerStart *start) {
+  *t = CreateThread(NULL, 0, worker_main, start, 0, NULL);
+  return *t != NULL;
+}
+
+static void worker_join(WorkerThread t) {
+  WaitForSingleObject(t, INFINITE);
+  CloseHandle(t);
+}
+
+uint32_t diskann_cpu_count(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors
+                                       : 1;
+}
+#else
+typedef pthread_t WorkerThread;
+
+static void *worker_main(void *p) {
+  WorkerStart *start = (WorkerStart *)p;
+  start->fn(start->arg);
+  return NULL;
+}
+
+static int worker_start(WorkerThread *t, WorkerStart *start) {
+  return pthread_create(t, NULL, worker_main, start) == 0;
+}
+
+static void worker_join(WorkerThread t) { pthread_join(t, NULL); }
+
+uint32_t diskann_cpu_count(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (uint32_t)n : 1;
+}
+#endif
+
+void diskann_parallel_run(DiskAnnWorkerFn fn, void *args, size_t arg_size,
+                          uint32_t n_workers) {
+  WorkerThread threads[DISKANN_MAX_THREADS];
+  WorkerStart starts[DISKANN_MAX_THREADS];
+  int started[DISKANN_MAX_THREADS];
+  char *base = (char *)args;
+
+  if (n_workers > DISKANN_MAX_THREADS) {
+    n_workers = DISKANN_MAX_THREADS;
+  }
+  for (uint32_t i = 1; i < n_workers; i++) {
+    starts[i].fn = fn;
+    starts[i].arg = base + i * arg_size;
+    started[i] = worker_start(&threads[i], &starts[i]);
+  }
+  if (n_workers > 0) {
+    fn(base);
+  }
+  for (uint32_t i = 1; i < n_workers; i++) {
+    if (started[i]) {
+      worker_join(threads[i]);
+    } else {
+      fn(base + i * arg_size);
+    }
+  }
+}
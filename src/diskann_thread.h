@@ -0,0 +1,42 @@
+/*
+** DiskANN worker threads — minimal portable fork/join helper
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+**
+** pthreads on POSIX, CreateThread on Windows. Locks come from SQLite
+** (sqlite3_mutex_alloc), so only thread start/join lives here.
+*/
+#ifndef DISKANN_THREAD_H
+#define DISKANN_THREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Upper bound on workers per diskann_parallel_run() call */
+#define DISKANN_MAX_THREADS 256
+
+typedef void (*DiskAnnWorkerFn)(void *arg);
+
+/* Number of online CPUs (at least 1). */
+uint32_t diskann_cpu_count(void);
+
+/*
+** Run fn on each of n_workers argument structs laid out arg_size bytes
+** apart from args, and return once all have finished. Worker 0 runs on
+** the calling thread; a worker whose thread fails to start runs inline
+** after the others, so callers never see a partial run. n_workers is
+** clamped to DISKANN_MAX_THREADS.
+*/
+void diskann_parallel_run(DiskAnnWorkerFn fn, void *args, size_t arg_size,
+                          uint32_t n_workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISKANN_THREAD_H */
@@ -8,16 +8,34 @@
 ** Supports CREATE, INSERT, SELECT (MATCH search), DELETE, DROP.
 **
 ** Schema: CREATE TABLE x(vector HIDDEN, distance HIDDEN, k HIDDEN,
-*search_list_size HIDDEN, meta1 TYPE, ...)
-** First 4 columns HIDDEN. Metadata columns visible in SELECT *.
+*search_list_size HIDDEN, query_index HIDDEN, exact HIDDEN, recall_target
+*HIDDEN, meta1 TYPE, ..., <table> HIDDEN)
+** First 7 columns HIDDEN. Metadata columns visible in SELECT *. The last,
+** named after the table, takes commands (FTS5-style).
 ** rowid via xRowid. MATCH on vector col for ANN search.
 **
 ** Usage:
 **   CREATE VIRTUAL TABLE t USING diskann(dimension=3, metric=euclidean, cat
 *TEXT);
+**   -- Sharded: one index per listed (ATTACHed) schema, rows routed by the
+**   -- PARTITION column, or by rowid without one (see diskann.h)
+**   CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:s2,
+**     tenant INTEGER PARTITION);
 **   INSERT INTO t(rowid, vector, cat) VALUES (1, X'...', 'landscape');
 **   SELECT rowid, distance, cat FROM t WHERE vector MATCH ?query AND k = 10;
+**   -- MATCH on n concatenated query vectors: k results per query, tagged
+**   SELECT query_index, rowid, distance FROM t WHERE vector MATCH ?queries;
+**   -- exact = 1 scans every (matching) row, exact = 0 always walks the graph
+**   SELECT rowid, distance FROM t WHERE vector MATCH ?query AND exact = 1;
+**   -- Beam sized for a recall@k target (once calibrated, see below)
+**   SELECT rowid FROM t WHERE vector MATCH ?query AND recall_target = 0.99;
+**   -- Range search: every row within 0.5 (no k = no row limit)
+**   SELECT rowid, distance FROM t WHERE vector MATCH ?query AND distance < 0.5;
 **   DELETE FROM t WHERE rowid = 1;
+**   -- Rewrite the graph in locality order (diskann_optimize())
+**   INSERT INTO t(t) VALUES ('optimize');
+**   -- Measure the recall curve searches size their beam from
+**   INSERT INTO t(t) VALUES ('calibrate');
 **   DROP TABLE t;
 */
 
@@ -32,13 +50,19 @@
 #endif
 
 #include "diskann.h"
+#include "diskann_bitmap.h"
 #include "diskann_cache.h"
 #include "diskann_internal.h"
+#include "diskann_label.h"
+#include "diskann_node.h"
+#include "diskann_search.h"
 #include "diskann_sqlite.h"
+#include "diskann_stats.h"
 #include "diskann_util.h"
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,6 +79,10 @@ SQLITE_EXTENSION_INIT1
 #define DISKANN_IDX_ROWID 0x08
 #define DISKANN_IDX_FILTER 0x10
 #define DISKANN_IDX_SEARCH_LIST_SIZE 0x20
+#define DISKANN_IDX_EXACT 0x40
+#define DISKANN_IDX_DISTANCE 0x80
+#define DISKANN_IDX_META 0x100 /* the query reads metadata columns */
+#define DISKANN_IDX_RECALL_TARGET 0x200
 
 /* Maximum number of filter constraints in a single query */
 #define DISKANN_MAX_FILTERS 16
@@ -64,14 +92,69 @@ SQLITE_EXTENSION_INIT1
 #define DISKANN_COL_DISTANCE 1
 #define DISKANN_COL_K 2
 #define DISKANN_COL_SEARCH_LIST_SIZE 3
-#define DISKANN_COL_META_START 4 /* First metadata column index */
+#define DISKANN_COL_QUERY_INDEX 4
+#define DISKANN_COL_EXACT 5
+#define DISKANN_COL_RECALL_TARGET 6
+#define DISKANN_COL_META_START 7 /* First metadata column index */
 
 /* Metadata column definition (parsed from CREATE VIRTUAL TABLE args) */
 typedef struct DiskAnnMetaCol {
   char *name; /* sqlite3_mprintf'd, owned */
   char *type; /* sqlite3_mprintf'd, owned */
+  int label;  /* 1 = declared LABEL (label-aware graph, diskann_label.h) */
+  int partition; /* 1 = declared PARTITION (routes rows to shards) */
 } DiskAnnMetaCol;
 
+/* _columns.label values: the role a column was declared with */
+#define DISKANN_COLUMN_LABEL 1
+#define DISKANN_COLUMN_PARTITION 2
+
+/* Filter bitmaps kept per vtab, least recently used evicted first */
+#define DISKANN_FILTER_CACHE_SIZE 8
+
+/*
+** Cached result of one filter expression with its bound values.
+** Memory ownership: key (sqlite3_mprintf'd) and rows are owned.
+*/
+typedef struct DiskAnnFilterCacheEntry {
+  char *key;          /* Filter SQL + bound values, NULL = unused slot */
+  DiskAnnBitmap rows; /* Matching _attrs rowids */
+  uint64_t last_used; /* filter_tick at the last hit */
+} DiskAnnFilterCacheEntry;
+
+/* Prepared filter queries kept per vtab, least recently used evicted */
+#define DISKANN_FILTER_STMT_CACHE_SIZE 8
+
+/*
+** Prepared "SELECT rowid FROM _attrs WHERE ..." for one xBestIndex idxStr.
+** Memory ownership: idx_str (sqlite3_mprintf'd) and stmt are owned.
+*/
+typedef struct DiskAnnFilterStmt {
+  char *idx_str;      /* idxStr the query was built from, NULL = unused */
+  sqlite3_stmt *stmt; /* Prepared filter query */
+  uint64_t last_used; /* filter_tick at the last use */
+} DiskAnnFilterStmt;
+
+/* Result rowids bound per run of the batched metadata SELECT */
+#define DISKANN_META_BATCH 64
+
+/* Streamed rows pulled per metadata fetch: the first chunk, doubling up
+** to the largest */
+#define DISKANN_META_CHUNK_MIN 16
+#define DISKANN_META_CHUNK_MAX 256
+
+/* A fetched metadata value. Text and blob bytes live in the cursor's
+** meta_bytes arena; a zeroed value is NULL. */
+typedef struct DiskAnnMetaValue {
+  int type; /* SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB */
+  int n;    /* Text/blob bytes */
+  union {
+    sqlite3_int64 i;
+    double r;
+    size_t off; /* Text/blob offset in meta_bytes */
+  } v;
+} DiskAnnMetaValue;
+
 /* Virtual table structure */
 typedef struct diskann_vtab {
   sqlite3_vtab base;
@@ -79,21 +162,63 @@ typedef struct diskann_vtab {
   char *db_name;
   char *table_name;
   DiskAnnIndex *idx;   /* Opened index (kept open for performance) */
+  /* shards= tables: one index per listed schema, in "<table>_shards"
+  ** order; idx is the first (owned by shards). NULL otherwise. */
+  DiskAnnShards *shards;
+  int partition_col; /* meta_cols index of the PARTITION column, or -1 */
+  sqlite3_stmt *partition_stmt; /* Cached SELECT of a row's partition key */
   uint32_t dimensions; /* Cached from idx for dim validation in xUpdate */
   int n_meta_cols;     /* 0 for vtabs without metadata columns */
   DiskAnnMetaCol
       *meta_cols; /* sqlite3_malloc'd array, NULL if n_meta_cols==0 */
+  int label_col;  /* meta_cols index of the LABEL column, or -1 */
+  int command_col; /* Column named after the table, or -1 when a column
+                   ** of that name already exists */
+  /* Materialized filters, valid while the database data version stays at
+  ** filter_data_version (any commit, from any connection, changes it) */
+  DiskAnnFilterCacheEntry filter_cache[DISKANN_FILTER_CACHE_SIZE];
+  uint64_t filter_tick;
+  unsigned int filter_data_version;
+  DiskAnnFilterStmt filter_stmts[DISKANN_FILTER_STMT_CACHE_SIZE];
+  sqlite3_stmt *meta_stmt; /* Cached batched SELECT from _attrs, or NULL */
+  sqlite3_stmt *attrs_delete_stmt; /* Cached DELETE from _attrs, or NULL */
+  /* Queued delete count at each open savepoint level (xSavepoint), so
+  ** xRollbackTo can drop the deletes queued after it */
+  int *savepoint_marks;
+  int n_savepoint_marks;
+  DiskAnnStatsLink *stats_link; /* "<table>_stats" view of idx, or NULL */
 } diskann_vtab;
 
-/* Cursor structure for iteration */
+/*
+** Cursor structure for iteration. A single-query MATCH streams its rows
+** (stream != NULL): the search resumes in xNext for as long as SQLite
+** keeps asking. ROWID lookups and multi-query MATCH fill results up front.
+**
+** When the query reads metadata columns, they are fetched for many rows
+** at once (cursor_fetch_meta()): all results, or for a stream, chunks of
+** rows pulled ahead into results.
+**
+** Memory ownership: results, query_index, stream, filter, meta and
+** meta_bytes are owned.
+*/
 typedef struct diskann_cursor {
   sqlite3_vtab_cursor base;
   DiskAnnResult *results;    /* Search results (sqlite3_malloc'd) */
+  int *query_index;          /* Per-result query, NULL for one query */
   int num_results;           /* Actual count from diskann_search() */
   int current;               /* Current position (0-based) */
-  sqlite3_stmt *meta_stmt;   /* Cached SELECT from _attrs, or NULL */
-  int64_t meta_cached_rowid; /* Rowid of last fetched metadata row */
-  int meta_has_row;          /* 1 if meta_stmt stepped to SQLITE_ROW */
+  DiskAnnSearchStream *stream; /* Streaming search, or NULL */
+  DiskAnnResult row;           /* Stream's current row */
+  int stream_eof;              /* Stream has no current row */
+  DiskAnnBitmap filter;        /* Stream's filter rows (it borrows them) */
+  int meta_used;               /* DISKANN_IDX_META: fetch metadata */
+  DiskAnnMetaValue *meta;      /* n_meta_cols values per results row */
+  int n_meta_rows;             /* results rows meta holds values for */
+  int meta_capacity;           /* Rows meta has room for */
+  unsigned char *meta_bytes;   /* Text/blob arena of meta */
+  size_t meta_bytes_used;
+  size_t meta_bytes_capacity;
+  int stream_chunk;            /* Rows the next stream refill pulls */
 } diskann_cursor;
 
 /* Forward declarations */
@@ -121,7 +246,14 @@ static int diskannBegin(sqlite3_vtab *pVtab);
 static int diskannSync(sqlite3_vtab *pVtab);
 static int diskannCommit(sqlite3_vtab *pVtab);
 static int diskannRollback(sqlite3_vtab *pVtab);
+static int diskannSavepoint(sqlite3_vtab *pVtab, int iSavepoint);
+static int diskannRelease(sqlite3_vtab *pVtab, int iSavepoint);
+static int diskannRollbackTo(sqlite3_vtab *pVtab, int iSavepoint);
 static int diskannShadowName(const char *zName);
+static void filter_cache_clear(diskann_vtab *p);
+static void filter_stmts_clear(diskann_vtab *p);
+static int vtab_route(diskann_vtab *p, int64_t rowid, sqlite3_value *key,
+                      DiskAnnIndex **out);
 
 /*
 ** Parse metric string to enum. Returns -1 on unknown metric.
@@ -136,6 +268,38 @@ static int parse_metric(const char *str) {
   return -1;
 }
 
+/*
+** Parse edge vector encoding string to enum. Returns -1 on unknown type.
+*/
+static int parse_edge_type(const char *str) {
+  if (strcmp(str, "float32") == 0)
+    return DISKANN_EDGE_FLOAT32;
+  if (strcmp(str, "int8") == 0)
+    return DISKANN_EDGE_INT8;
+  return -1;
+}
+
+/*
+** Parse stored vector element type to enum. Returns -1 on unknown type.
+*/
+static int parse_vector_type(const char *str) {
+  if (strcmp(str, "float32") == 0 || strcmp(str, "f32") == 0)
+    return DISKANN_VECTOR_FLOAT32;
+  if (strcmp(str, "float16") == 0 || strcmp(str, "f16") == 0)
+    return DISKANN_VECTOR_FLOAT16;
+  if (strcmp(str, "bfloat16") == 0 || strcmp(str, "bf16") == 0)
+    return DISKANN_VECTOR_BFLOAT16;
+  return -1;
+}
+
+static int parse_delete_mode(const char *str) {
+  if (strcmp(str, "immediate") == 0)
+    return DISKANN_DELETE_IMMEDIATE;
+  if (strcmp(str, "tombstone") == 0)
+    return DISKANN_DELETE_TOMBSTONE;
+  return -1;
+}
+
 /*
 ** Free a DiskAnnMetaCol array and all owned strings.
 */
@@ -157,6 +321,9 @@ static int is_reserved_column_name(const char *name) {
          sqlite3_stricmp(name, "distance") == 0 ||
          sqlite3_stricmp(name, "k") == 0 ||
          sqlite3_stricmp(name, "search_list_size") == 0 ||
+         sqlite3_stricmp(name, "query_index") == 0 ||
+         sqlite3_stricmp(name, "exact") == 0 ||
+         sqlite3_stricmp(name, "recall_target") == 0 ||
          sqlite3_stricmp(name, "rowid") == 0;
 }
 
@@ -170,6 +337,17 @@ static int is_valid_meta_type(const char *type) {
          sqlite3_stricmp(type, "BLOB") == 0;
 }
 
+/*
+** Affinity of a valid metadata column type, for diskann_label_hash().
+*/
+static int label_affinity(const char *type) {
+  if (sqlite3_stricmp(type, "TEXT") == 0)
+    return DISKANN_LABEL_AFFINITY_TEXT;
+  if (sqlite3_stricmp(type, "BLOB") == 0)
+    return DISKANN_LABEL_AFFINITY_NONE;
+  return DISKANN_LABEL_AFFINITY_NUMERIC;
+}
+
 /*
 ** Parse a string as uint32_t with error checking.
 ** Returns 0 on success, -1 on error.
@@ -193,9 +371,28 @@ static int parse_uint32(const char *str, uint32_t *out) {
   return 0;
 }
 
+/*
+** Parse a string as a finite float with error checking.
+** Returns 0 on success, -1 on error.
+*/
+static int parse_float(const char *str, float *out) {
+  char *endptr;
+  errno = 0;
+  double val = strtod(str, &endptr);
+
+  if (errno != 0 || endptr == str || *endptr != '\0' || !isfinite(val)) {
+    return -1;
+  }
+
+  *out = (float)val;
+  return 0;
+}
+
 /*
 ** Parse metadata column definitions from argv.
-** Non-key=value entries are treated as "name TYPE" column definitions.
+** Non-key=value entries are treated as "name TYPE [LABEL|PARTITION]"
+** column definitions; at most one column may be a LABEL, and one a
+** PARTITION.
 ** Validates names, types, rejects duplicates and reserved names.
 ** On success, *out_cols and *out_n are set (caller owns *out_cols).
 ** On failure, *pzErr is set and SQLITE_ERROR returned.
@@ -225,10 +422,16 @@ static int parse_meta_columns(const char *const *argv, int argc,
     if (strchr(argv[i], '='))
       continue;
 
-    /* Parse "name TYPE" */
+    /* Parse "name TYPE [LABEL|PARTITION]" */
     char name_buf[MAX_IDENTIFIER_LEN + 1];
     char type_buf[16];
-    if (sscanf(argv[i], "%64s %15s", name_buf, type_buf) != 2) {
+    char flag_buf[16];
+    int n_tokens = sscanf(argv[i], "%64s %15s %15s", name_buf, type_buf,
+                          flag_buf);
+    int partition =
+        n_tokens == 3 && sqlite3_stricmp(flag_buf, "PARTITION") == 0;
+    if (n_tokens < 2 || (n_tokens == 3 && !partition &&
+                         sqlite3_stricmp(flag_buf, "LABEL") != 0)) {
       *pzErr =
           sqlite3_mprintf("diskann: invalid column definition '%s'", argv[i]);
       free_meta_cols(cols, idx);
@@ -266,6 +469,21 @@ static int parse_meta_columns(const char *const *argv, int argc,
       return SQLITE_ERROR;
     }
 
+    if (n_tokens == 3) {
+      const char *flag = partition ? "PARTITION" : "LABEL";
+      for (int j = 0; j < idx; j++) {
+        if (partition ? cols[j].partition : cols[j].label) {
+          *pzErr = sqlite3_mprintf("diskann: only one %s column allowed "
+                                   "('%s' and '%s')",
+                                   flag, cols[j].name, name_buf);
+          free_meta_cols(cols, idx);
+          return SQLITE_ERROR;
+        }
+      }
+      cols[idx].label = !partition;
+      cols[idx].partition = partition;
+    }
+
     cols[idx].name = sqlite3_mprintf("%s", name_buf);
     cols[idx].type = sqlite3_mprintf("%s", type_buf);
     if (!cols[idx].name || !cols[idx].type) {
@@ -280,24 +498,184 @@ static int parse_meta_columns(const char *const *argv, int argc,
   return SQLITE_OK;
 }
 
+/* Shard schema names of a shards= table (each sqlite3_mprintf'd) */
+typedef struct ShardNames {
+  char **names;
+  int n;
+} ShardNames;
+
+static void free_shard_names(ShardNames *sn) {
+  for (int i = 0; i < sn->n; i++)
+    sqlite3_free(sn->names[i]);
+  sqlite3_free(sn->names);
+  sn->names = NULL;
+  sn->n = 0;
+}
+
+/* Append a copy of name to sn */
+static int shard_names_add(ShardNames *sn, const char *name, int len) {
+  char **names = sqlite3_realloc(sn->names, (sn->n + 1) * (int)sizeof(char *));
+  if (!names)
+    return SQLITE_NOMEM;
+  sn->names = names;
+  names[sn->n] = sqlite3_mprintf("%.*s", len, name);
+  if (!names[sn->n])
+    return SQLITE_NOMEM;
+  sn->n++;
+  return SQLITE_OK;
+}
+
+/*
+** Parse the value of shards=s1:s2:... into sn: 1..DISKANN_MAX_SHARDS
+** distinct schema names.
+** On failure, *pzErr is set and SQLITE_ERROR returned.
+*/
+static int parse_shard_names(const char *arg, ShardNames *sn, char **pzErr) {
+  const char *p = arg;
+  for (;;) {
+    const char *end = strchr(p, ':');
+    int len = end ? (int)(end - p) : (int)strlen(p);
+    char name[MAX_IDENTIFIER_LEN + 1];
+    snprintf(name, sizeof(name), "%.*s",
+             len > MAX_IDENTIFIER_LEN ? 0 : len, p);
+    if (!validate_identifier(name)) {
+      *pzErr = sqlite3_mprintf("diskann: invalid shards '%s'", arg);
+      return SQLITE_ERROR;
+    }
+    for (int i = 0; i < sn->n; i++) {
+      if (sqlite3_stricmp(sn->names[i], name) == 0) {
+        *pzErr = sqlite3_mprintf("diskann: duplicate shard '%s'", name);
+        return SQLITE_ERROR;
+      }
+    }
+    if (sn->n == DISKANN_MAX_SHARDS) {
+      *pzErr = sqlite3_mprintf("diskann: more than %d shards",
+                               DISKANN_MAX_SHARDS);
+      return SQLITE_ERROR;
+    }
+    if (shard_names_add(sn, name, len) != SQLITE_OK)
+      return SQLITE_NOMEM;
+    if (!end)
+      return SQLITE_OK;
+    p = end + 1;
+  }
+}
+
+/*
+** Read a table's shard schemas from "<table>_shards", in rowid order.
+** Leaves sn empty for tables without one (not sharded).
+*/
+static int read_shard_names(sqlite3 *db, const char *db_name,
+                            const char *table_name, ShardNames *sn) {
+  char *sql = sqlite3_mprintf(
+      "SELECT schema FROM \"%w\".\"%w_shards\" ORDER BY rowid", db_name,
+      table_name);
+  if (!sql)
+    return SQLITE_NOMEM;
+  sqlite3_stmt *stmt = NULL;
+  int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK)
+    return SQLITE_OK; /* no _shards table */
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const char *name = (const char *)sqlite3_column_text(stmt, 0);
+    rc = name ? shard_names_add(sn, name, (int)strlen(name)) : SQLITE_NOMEM;
+    if (rc != SQLITE_OK)
+      break;
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    free_shard_names(sn);
+    return rc == SQLITE_NOMEM ? SQLITE_NOMEM : SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Drop a table's shadow tables (best effort): its index in db_name, or
+** for a sharded table each shard's index plus the shard list and
+** metadata tables kept in db_name.
+*/
+static void drop_tables(sqlite3 *db, const char *db_name,
+                        const char *table_name, const ShardNames *sn) {
+  if (sn->n == 0) {
+    diskann_drop_index(db, db_name, table_name);
+    return;
+  }
+  for (int i = 0; i < sn->n; i++) {
+    diskann_drop_index(db, sn->names[i], table_name);
+  }
+  char *sql = sqlite3_mprintf(
+      "DROP TABLE IF EXISTS \"%w\".\"%w_shards\";"
+      "DROP TABLE IF EXISTS \"%w\".\"%w_attrs\";"
+      "DROP TABLE IF EXISTS \"%w\".\"%w_columns\"",
+      db_name, table_name, db_name, table_name, db_name, table_name);
+  if (sql) {
+    sqlite3_exec(db, sql, NULL, NULL, NULL);
+    sqlite3_free(sql);
+  }
+}
+
+/* Open table_name's index, or with shard names its shards (*idx = the
+** first shard) */
+static int open_indexes(sqlite3 *db, const char *db_name,
+                        const char *table_name, const ShardNames *sn,
+                        DiskAnnIndex **idx, DiskAnnShards **shards) {
+  *idx = NULL;
+  *shards = NULL;
+  if (sn->n == 0) {
+    return diskann_open_index(db, db_name, table_name, idx);
+  }
+  int rc = diskann_open_shards(db, (const char *const *)sn->names, sn->n,
+                               table_name, shards);
+  if (rc == DISKANN_OK) {
+    *idx = diskann_shard_index(*shards, 0);
+  }
+  return rc;
+}
+
+/* Close what open_indexes() opened (NULL safe) */
+static void close_indexes(DiskAnnIndex *idx, DiskAnnShards *shards) {
+  if (shards) {
+    diskann_close_shards(shards);
+  } else {
+    diskann_close_index(idx);
+  }
+}
+
 /*
 ** Shared init helper for xCreate and xConnect.
 ** Declares the vtab schema (with optional metadata columns),
 ** allocates the vtab struct, populates fields.
-** Takes ownership of meta_cols on success; caller must free on failure.
+** Takes ownership of meta_cols and shards (which owns idx, when given) on
+** success; caller must free on failure.
 */
 static int vtab_init(sqlite3 *db, const char *db_name, const char *table_name,
-                     DiskAnnIndex *idx, DiskAnnMetaCol *meta_cols,
-                     int n_meta_cols, sqlite3_vtab **ppVtab, char **pzErr) {
+                     DiskAnnIndex *idx, DiskAnnShards *shards,
+                     DiskAnnMetaCol *meta_cols, int n_meta_cols,
+                     sqlite3_vtab **ppVtab, char **pzErr) {
   int rc;
 
   /* Build dynamic declare_vtab schema string */
   sqlite3_str *s = sqlite3_str_new(db);
   sqlite3_str_appendall(s, "CREATE TABLE x(vector HIDDEN, distance HIDDEN, k "
-                           "HIDDEN, search_list_size HIDDEN");
+                           "HIDDEN, search_list_size HIDDEN, query_index "
+                           "HIDDEN, exact HIDDEN, recall_target HIDDEN");
   for (int i = 0; i < n_meta_cols; i++) {
     sqlite3_str_appendf(s, ", \"%w\" %s", meta_cols[i].name, meta_cols[i].type);
   }
+  int command_col = DISKANN_COL_META_START + n_meta_cols;
+  if (is_reserved_column_name(table_name)) {
+    command_col = -1;
+  }
+  for (int i = 0; i < n_meta_cols && command_col >= 0; i++) {
+    if (sqlite3_stricmp(meta_cols[i].name, table_name) == 0) {
+      command_col = -1;
+    }
+  }
+  if (command_col >= 0) {
+    sqlite3_str_appendf(s, ", \"%w\" HIDDEN", table_name);
+  }
   sqlite3_str_appendall(s, ")");
 
   char *schema = sqlite3_str_finish(s);
@@ -323,9 +701,13 @@ static int vtab_init(sqlite3 *db, const char *db_name, const char *table_name,
   pVtab->db_name = sqlite3_mprintf("%s", db_name);
   pVtab->table_name = sqlite3_mprintf("%s", table_name);
   pVtab->idx = idx;
+  pVtab->shards = shards;
+  pVtab->partition_col = -1;
   pVtab->dimensions = idx->dimensions;
   pVtab->n_meta_cols = n_meta_cols;
   pVtab->meta_cols = meta_cols; /* Takes ownership */
+  pVtab->label_col = -1;
+  pVtab->command_col = command_col;
 
   if (!pVtab->db_name || !pVtab->table_name) {
     sqlite3_free(pVtab->db_name);
@@ -336,25 +718,53 @@ static int vtab_init(sqlite3 *db, const char *db_name, const char *table_name,
     return SQLITE_NOMEM;
   }
 
+  /* Label-aware graph: load every row's label from _attrs */
+  for (int i = 0; i < n_meta_cols; i++) {
+    if (meta_cols[i].partition) {
+      pVtab->partition_col = i;
+    }
+    if (!meta_cols[i].label) {
+      continue;
+    }
+    rc = diskann_labels_enable(idx, meta_cols[i].name,
+                               label_affinity(meta_cols[i].type));
+    if (rc != DISKANN_OK) {
+      *pzErr = sqlite3_mprintf("diskann: failed to load labels (rc=%d)", rc);
+      sqlite3_free(pVtab->db_name);
+      sqlite3_free(pVtab->table_name);
+      sqlite3_free(pVtab);
+      return rc == DISKANN_ERROR_NOMEM ? SQLITE_NOMEM : SQLITE_ERROR;
+    }
+    pVtab->label_col = i;
+  }
+
+  /* The stats view is a diagnostic: a table opens without it. It shows
+  ** one handle, so sharded tables have none (see diskann_stats()). */
+  if (!shards) {
+    (void)diskann_stats_register(db, table_name, idx, &pVtab->stats_link);
+  }
+
   *ppVtab = &pVtab->base;
   return SQLITE_OK;
 }
 
 /*
-** xCreate — called for CREATE VIRTUAL TABLE.
-** Parses config from argv, creates shadow tables, opens index.
+** xCreate body: parses config from argv, creates shadow tables, opens
+** index. The shard names parsed into *sn are freed by the caller.
 */
-static int diskannCreate(sqlite3 *db, void *pAux, int argc,
-                         const char *const *argv, sqlite3_vtab **ppVtab,
-                         char **pzErr) {
+static int create_table(sqlite3 *db, int argc, const char *const *argv,
+                        ShardNames *sn, sqlite3_vtab **ppVtab,
+                        char **pzErr) {
   DiskAnnConfig config;
   DiskAnnIndex *idx = NULL;
+  DiskAnnShards *shards = NULL;
+  const char *shards_arg = NULL;
   DiskAnnMetaCol *meta_cols = NULL;
   int n_meta_cols = 0;
+  int delete_mode = DISKANN_DELETE_IMMEDIATE;
+  uint32_t consolidate_at = DISKANN_DEFAULT_CONSOLIDATE_THRESHOLD;
   int rc;
 
-  (void)pAux;
-
   /* Default configuration */
   config.dimensions = 0; /* Required */
   config.metric = DISKANN_METRIC_COSINE;
@@ -363,6 +773,10 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
   config.insert_list_size = 200;
   config.block_size =
       0; /* Auto-calculate based on dimensions and max_neighbors */
+  config.edge_type = DISKANN_EDGE_FLOAT32;
+  config.vector_type = DISKANN_VECTOR_FLOAT32;
+  config.quant_min = 0.0f; /* 0/0 = range taken from the data */
+  config.quant_max = 0.0f;
 
   if (argc < 3) {
     *pzErr = sqlite3_mprintf("diskann: missing arguments");
@@ -377,6 +791,11 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
     const char *param = argv[i];
     char key[64], value[64];
 
+    /* The shard list can outgrow value[] */
+    if (strncmp(param, "shards=", 7) == 0) {
+      shards_arg = param + 7;
+      continue;
+    }
     if (sscanf(param, "%63[^=]=%63s", key, value) == 2) {
       if (strcmp(key, "dimension") == 0) {
         if (parse_uint32(value, &config.dimensions) != 0) {
@@ -402,6 +821,43 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
           return SQLITE_ERROR;
         }
         config.insert_list_size = config.search_list_size * 2;
+      } else if (strcmp(key, "edge_type") == 0) {
+        int edge_type = parse_edge_type(value);
+        if (edge_type < 0) {
+          *pzErr = sqlite3_mprintf("diskann: invalid edge_type '%s'", value);
+          return SQLITE_ERROR;
+        }
+        config.edge_type = (uint8_t)edge_type;
+      } else if (strcmp(key, "vector_type") == 0) {
+        int vector_type = parse_vector_type(value);
+        if (vector_type < 0) {
+          *pzErr =
+              sqlite3_mprintf("diskann: invalid vector_type '%s'", value);
+          return SQLITE_ERROR;
+        }
+        config.vector_type = (uint8_t)vector_type;
+      } else if (strcmp(key, "quant_min") == 0) {
+        if (parse_float(value, &config.quant_min) != 0) {
+          *pzErr = sqlite3_mprintf("diskann: invalid quant_min '%s'", value);
+          return SQLITE_ERROR;
+        }
+      } else if (strcmp(key, "quant_max") == 0) {
+        if (parse_float(value, &config.quant_max) != 0) {
+          *pzErr = sqlite3_mprintf("diskann: invalid quant_max '%s'", value);
+          return SQLITE_ERROR;
+        }
+      } else if (strcmp(key, "delete_mode") == 0) {
+        delete_mode = parse_delete_mode(value);
+        if (delete_mode < 0) {
+          *pzErr = sqlite3_mprintf("diskann: invalid delete_mode '%s'", value);
+          return SQLITE_ERROR;
+        }
+      } else if (strcmp(key, "consolidate_threshold") == 0) {
+        if (parse_uint32(value, &consolidate_at) != 0) {
+          *pzErr = sqlite3_mprintf(
+              "diskann: invalid consolidate_threshold '%s'", value);
+          return SQLITE_ERROR;
+        }
       }
     }
   }
@@ -416,14 +872,67 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
   if (rc != SQLITE_OK)
     return rc;
 
-  /* Create index (shadow tables + metadata) */
-  rc = diskann_create_index(db, db_name, table_name, &config);
-  if (rc != DISKANN_OK && rc != DISKANN_ERROR_EXISTS) {
-    *pzErr = sqlite3_mprintf("diskann: failed to create index (rc=%d)", rc);
+  if (shards_arg) {
+    rc = parse_shard_names(shards_arg, sn, pzErr);
+    if (rc != SQLITE_OK) {
+      free_meta_cols(meta_cols, n_meta_cols);
+      return rc;
+    }
+  }
+  /* Labels live in one graph; a partition key picks a shard */
+  for (int i = 0; i < n_meta_cols; i++) {
+    if (meta_cols[i].label && sn->n > 0) {
+      *pzErr = sqlite3_mprintf("diskann: LABEL column '%s' cannot be "
+                               "used with shards",
+                               meta_cols[i].name);
+    } else if (meta_cols[i].partition && sn->n == 0) {
+      *pzErr = sqlite3_mprintf("diskann: PARTITION column '%s' needs "
+                               "shards",
+                               meta_cols[i].name);
+    } else {
+      continue;
+    }
     free_meta_cols(meta_cols, n_meta_cols);
     return SQLITE_ERROR;
   }
 
+  /* Create index (shadow tables + metadata), one per shard schema */
+  for (int i = 0; i < (sn->n > 0 ? sn->n : 1); i++) {
+    rc = diskann_create_index(db, sn->n > 0 ? sn->names[i] : db_name,
+                              table_name, &config);
+    if (rc != DISKANN_OK && rc != DISKANN_ERROR_EXISTS) {
+      *pzErr =
+          sqlite3_mprintf("diskann: failed to create index (rc=%d)", rc);
+      free_meta_cols(meta_cols, n_meta_cols);
+      if (i > 0) {
+        drop_tables(db, db_name, table_name, sn);
+      }
+      return SQLITE_ERROR;
+    }
+  }
+
+  /* The shard list, which xConnect opens */
+  if (sn->n > 0) {
+    sqlite3_str *s = sqlite3_str_new(db);
+    sqlite3_str_appendf(
+        s, "CREATE TABLE \"%w\".\"%w_shards\"(schema TEXT NOT NULL);",
+        db_name, table_name);
+    for (int i = 0; i < sn->n; i++) {
+      sqlite3_str_appendf(
+          s, "INSERT INTO \"%w\".\"%w_shards\"(schema) VALUES ('%q');",
+          db_name, table_name, sn->names[i]);
+    }
+    char *sql = sqlite3_str_finish(s);
+    rc = sql ? sqlite3_exec(db, sql, NULL, NULL, NULL) : SQLITE_NOMEM;
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+      *pzErr = sqlite3_mprintf("diskann: failed to create _shards table");
+      free_meta_cols(meta_cols, n_meta_cols);
+      drop_tables(db, db_name, table_name, sn);
+      return rc;
+    }
+  }
+
   /* Create Phase 2 shadow tables if we have metadata columns */
   if (n_meta_cols > 0) {
     char *sql = NULL;
@@ -431,11 +940,12 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
 
     /* Create _columns table: persists column definitions for xConnect */
     sql = sqlite3_mprintf("CREATE TABLE \"%w\".\"%w_columns\" ("
-                          "name TEXT NOT NULL, type TEXT NOT NULL)",
+                          "name TEXT NOT NULL, type TEXT NOT NULL, "
+                          "label INTEGER NOT NULL DEFAULT 0)",
                           db_name, table_name);
     if (!sql) {
       free_meta_cols(meta_cols, n_meta_cols);
-      diskann_drop_index(db, db_name, table_name);
+      drop_tables(db, db_name, table_name, sn);
       return SQLITE_NOMEM;
     }
     rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
@@ -446,18 +956,22 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
       if (err_msg)
         sqlite3_free(err_msg);
       free_meta_cols(meta_cols, n_meta_cols);
-      diskann_drop_index(db, db_name, table_name);
+      drop_tables(db, db_name, table_name, sn);
       return SQLITE_ERROR;
     }
 
     /* Insert column definitions into _columns */
     for (int i = 0; i < n_meta_cols; i++) {
-      sql = sqlite3_mprintf(
-          "INSERT INTO \"%w\".\"%w_columns\"(name, type) VALUES ('%q', '%q')",
-          db_name, table_name, meta_cols[i].name, meta_cols[i].type);
+      int role = meta_cols[i].label       ? DISKANN_COLUMN_LABEL
+                 : meta_cols[i].partition ? DISKANN_COLUMN_PARTITION
+                                          : 0;
+      sql = sqlite3_mprintf("INSERT INTO \"%w\".\"%w_columns\"(name, type, "
+                            "label) VALUES ('%q', '%q', %d)",
+                            db_name, table_name, meta_cols[i].name,
+                            meta_cols[i].type, role);
       if (!sql) {
         free_meta_cols(meta_cols, n_meta_cols);
-        diskann_drop_index(db, db_name, table_name);
+        drop_tables(db, db_name, table_name, sn);
         return SQLITE_NOMEM;
       }
       rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
@@ -466,7 +980,7 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
         if (err_msg)
           sqlite3_free(err_msg);
         free_meta_cols(meta_cols, n_meta_cols);
-        diskann_drop_index(db, db_name, table_name);
+        drop_tables(db, db_name, table_name, sn);
         return SQLITE_ERROR;
       }
     }
@@ -484,7 +998,7 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
     sql = sqlite3_str_finish(s);
     if (!sql) {
       free_meta_cols(meta_cols, n_meta_cols);
-      diskann_drop_index(db, db_name, table_name);
+      drop_tables(db, db_name, table_name, sn);
       return SQLITE_NOMEM;
     }
     rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
@@ -495,24 +1009,38 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
       if (err_msg)
         sqlite3_free(err_msg);
       free_meta_cols(meta_cols, n_meta_cols);
-      diskann_drop_index(db, db_name, table_name);
+      drop_tables(db, db_name, table_name, sn);
       return SQLITE_ERROR;
     }
   }
 
   /* Open the index */
-  rc = diskann_open_index(db, db_name, table_name, &idx);
+  rc = open_indexes(db, db_name, table_name, sn, &idx, &shards);
   if (rc != DISKANN_OK) {
     *pzErr = sqlite3_mprintf("diskann: failed to open index (rc=%d)", rc);
     free_meta_cols(meta_cols, n_meta_cols);
-    diskann_drop_index(db, db_name, table_name);
+    drop_tables(db, db_name, table_name, sn);
     return SQLITE_ERROR;
   }
+  for (int i = 0; delete_mode != DISKANN_DELETE_IMMEDIATE &&
+                  i < (shards ? sn->n : 1);
+       i++) {
+    rc = diskann_set_delete_mode(shards ? diskann_shard_index(shards, i) : idx,
+                                 delete_mode, consolidate_at);
+    if (rc != DISKANN_OK) {
+      *pzErr = sqlite3_mprintf("diskann: failed to set delete_mode (rc=%d)",
+                               rc);
+      close_indexes(idx, shards);
+      free_meta_cols(meta_cols, n_meta_cols);
+      drop_tables(db, db_name, table_name, sn);
+      return SQLITE_ERROR;
+    }
+  }
 
-  rc = vtab_init(db, db_name, table_name, idx, meta_cols, n_meta_cols, ppVtab,
-                 pzErr);
+  rc = vtab_init(db, db_name, table_name, idx, shards, meta_cols,
+                 n_meta_cols, ppVtab, pzErr);
   if (rc != SQLITE_OK) {
-    diskann_close_index(idx);
+    close_indexes(idx, shards);
     free_meta_cols(meta_cols, n_meta_cols);
     return rc;
   }
@@ -520,6 +1048,19 @@ static int diskannCreate(sqlite3 *db, void *pAux, int argc,
   return SQLITE_OK;
 }
 
+/*
+** xCreate — called for CREATE VIRTUAL TABLE.
+*/
+static int diskannCreate(sqlite3 *db, void *pAux, int argc,
+                         const char *const *argv, sqlite3_vtab **ppVtab,
+                         char **pzErr) {
+  ShardNames sn = {NULL, 0};
+  (void)pAux;
+  int rc = create_table(db, argc, argv, &sn, ppVtab, pzErr);
+  free_shard_names(&sn);
+  return rc;
+}
+
 /*
 ** xConnect — called when an existing vtab is reconnected (e.g., after reopen).
 ** Opens the existing index — does NOT parse config (config from metadata).
@@ -528,6 +1069,8 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
                           const char *const *argv, sqlite3_vtab **ppVtab,
                           char **pzErr) {
   DiskAnnIndex *idx = NULL;
+  DiskAnnShards *shards = NULL;
+  ShardNames sn = {NULL, 0};
   DiskAnnMetaCol *meta_cols = NULL;
   int n_meta_cols = 0;
   int rc;
@@ -543,26 +1086,37 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
   const char *db_name = argv[1];
   const char *table_name = argv[2];
 
-  /* Open existing index — config comes from persisted metadata */
-  rc = diskann_open_index(db, db_name, table_name, &idx);
+  /* Open existing index — config comes from persisted metadata. A
+  ** sharded table lists its shard schemas in _shards. */
+  rc = read_shard_names(db, db_name, table_name, &sn);
+  if (rc != SQLITE_OK) {
+    *pzErr = sqlite3_mprintf("diskann: failed to read shards");
+    return rc;
+  }
+  rc = open_indexes(db, db_name, table_name, &sn, &idx, &shards);
+  free_shard_names(&sn);
   if (rc != DISKANN_OK) {
     *pzErr = sqlite3_mprintf("diskann: index not found (rc=%d)", rc);
     return SQLITE_ERROR;
   }
 
   /* Read metadata column definitions from _columns table (Phase 2).
-  ** If _columns doesn't exist (Phase 1 index), n_meta_cols stays 0. */
-  char *col_sql = sqlite3_mprintf(
-      "SELECT name, type FROM \"%w\".\"%w_columns\"", db_name, table_name);
-  if (!col_sql) {
-    diskann_close_index(idx);
-    return SQLITE_NOMEM;
+  ** If _columns doesn't exist (Phase 1 index), n_meta_cols stays 0.
+  ** Tables created before LABEL columns have no label column. */
+  sqlite3_stmt *col_stmt = NULL;
+  rc = SQLITE_ERROR;
+  for (int with_label = 1; with_label >= 0 && rc != SQLITE_OK; with_label--) {
+    char *col_sql = sqlite3_mprintf(
+        "SELECT name, type, %s FROM \"%w\".\"%w_columns\"",
+        with_label ? "label" : "0", db_name, table_name);
+    if (!col_sql) {
+      close_indexes(idx, shards);
+      return SQLITE_NOMEM;
+    }
+    rc = sqlite3_prepare_v2(db, col_sql, -1, &col_stmt, NULL);
+    sqlite3_free(col_sql);
   }
 
-  sqlite3_stmt *col_stmt;
-  rc = sqlite3_prepare_v2(db, col_sql, -1, &col_stmt, NULL);
-  sqlite3_free(col_sql);
-
   if (rc == SQLITE_OK) {
     /* Count rows first */
     int count = 0;
@@ -574,7 +1128,7 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
       meta_cols = sqlite3_malloc(count * (int)sizeof(DiskAnnMetaCol));
       if (!meta_cols) {
         sqlite3_finalize(col_stmt);
-        diskann_close_index(idx);
+        close_indexes(idx, shards);
         return SQLITE_NOMEM;
       }
       memset(meta_cols, 0, (size_t)count * sizeof(DiskAnnMetaCol));
@@ -585,10 +1139,13 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
         const char *type = (const char *)sqlite3_column_text(col_stmt, 1);
         meta_cols[i].name = sqlite3_mprintf("%s", name);
         meta_cols[i].type = sqlite3_mprintf("%s", type);
+        int role = sqlite3_column_int(col_stmt, 2);
+        meta_cols[i].label = role == DISKANN_COLUMN_LABEL;
+        meta_cols[i].partition = role == DISKANN_COLUMN_PARTITION;
         if (!meta_cols[i].name || !meta_cols[i].type) {
           free_meta_cols(meta_cols, i + 1);
           sqlite3_finalize(col_stmt);
-          diskann_close_index(idx);
+          close_indexes(idx, shards);
           return SQLITE_NOMEM;
         }
         i++;
@@ -601,10 +1158,10 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
     n_meta_cols = 0;
   }
 
-  rc = vtab_init(db, db_name, table_name, idx, meta_cols, n_meta_cols, ppVtab,
-                 pzErr);
+  rc = vtab_init(db, db_name, table_name, idx, shards, meta_cols,
+                 n_meta_cols, ppVtab, pzErr);
   if (rc != SQLITE_OK) {
-    diskann_close_index(idx);
+    close_indexes(idx, shards);
     free_meta_cols(meta_cols, n_meta_cols);
     return rc;
   }
@@ -617,8 +1174,15 @@ static int diskannConnect(sqlite3 *db, void *pAux, int argc,
 */
 static int diskannDisconnect(sqlite3_vtab *pVtab) {
   diskann_vtab *p = (diskann_vtab *)pVtab;
-  diskann_close_index(p->idx);
+  diskann_stats_unlink(p->stats_link);
+  close_indexes(p->idx, p->shards);
   free_meta_cols(p->meta_cols, p->n_meta_cols);
+  filter_cache_clear(p);
+  filter_stmts_clear(p);
+  sqlite3_finalize(p->meta_stmt);
+  sqlite3_finalize(p->partition_stmt);
+  sqlite3_finalize(p->attrs_delete_stmt);
+  sqlite3_free(p->savepoint_marks);
   sqlite3_free(p->db_name);
   sqlite3_free(p->table_name);
   sqlite3_free(p);
@@ -631,15 +1195,34 @@ static int diskannDisconnect(sqlite3_vtab *pVtab) {
 */
 static int diskannDestroy(sqlite3_vtab *pVtab) {
   diskann_vtab *p = (diskann_vtab *)pVtab;
+  ShardNames sn = {NULL, 0};
+
+  /* The shard schemas, read before their handles go */
+  for (int i = 0; i < diskann_shard_count(p->shards); i++) {
+    const char *name = diskann_shard_index(p->shards, i)->db_name;
+    if (shard_names_add(&sn, name, (int)strlen(name)) != SQLITE_OK) {
+      free_shard_names(&sn);
+      return SQLITE_NOMEM;
+    }
+  }
 
   /* Close index first (releases blob handles before DROP) */
-  diskann_close_index(p->idx);
+  diskann_stats_unlink(p->stats_link);
+  close_indexes(p->idx, p->shards);
   p->idx = NULL;
+  p->shards = NULL;
+  filter_stmts_clear(p);
+  sqlite3_finalize(p->meta_stmt);
+  sqlite3_finalize(p->partition_stmt);
+  sqlite3_finalize(p->attrs_delete_stmt);
+  sqlite3_free(p->savepoint_marks);
 
   /* Drop all shadow tables (including Phase 2 _attrs/_columns) */
-  diskann_drop_index(p->db, p->db_name, p->table_name);
+  drop_tables(p->db, p->db_name, p->table_name, &sn);
+  free_shard_names(&sn);
 
   free_meta_cols(p->meta_cols, p->n_meta_cols);
+  filter_cache_clear(p);
   sqlite3_free(p->db_name);
   sqlite3_free(p->table_name);
   sqlite3_free(p);
@@ -647,39 +1230,153 @@ static int diskannDestroy(sqlite3_vtab *pVtab) {
 }
 
 /**************************************************************************
-** DiskAnnRowidSet — Pre-computed filter for beam search
+** Filter bitmaps — metadata filters materialized for beam search
 **
-** Built from SQL query on _attrs shadow table, used as DiskAnnFilterFn
-** callback context. Binary search on sorted rowid array.
+** The rowids matching a filter are collected from the _attrs shadow table
+** into a DiskAnnBitmap and kept in a small per-vtab cache keyed by the
+** filter SQL and its bound values, so repeated filters skip the scan.
+** Entries are only made outside write transactions (uncommitted rows
+** could roll back) and are dropped when the data version changes. The
+** filter queries themselves stay prepared, keyed by idxStr.
 **************************************************************************/
 
-typedef struct DiskAnnRowidSet {
-  int64_t *rowids; /* Sorted ascending, sqlite3_malloc'd */
-  int count;
-} DiskAnnRowidSet;
-
-/* Binary search callback — compatible with DiskAnnFilterFn signature */
-static int rowid_set_contains(int64_t rowid, void *ctx) {
-  DiskAnnRowidSet *set = (DiskAnnRowidSet *)ctx;
-  int lo = 0, hi = set->count - 1;
-  while (lo <= hi) {
-    int mid = lo + (hi - lo) / 2;
-    if (set->rowids[mid] == rowid)
-      return 1;
-    if (set->rowids[mid] < rowid)
-      lo = mid + 1;
-    else
-      hi = mid - 1;
+static void filter_cache_clear(diskann_vtab *p) {
+  for (int i = 0; i < DISKANN_FILTER_CACHE_SIZE; i++) {
+    sqlite3_free(p->filter_cache[i].key);
+    p->filter_cache[i].key = NULL;
+    diskann_bitmap_deinit(&p->filter_cache[i].rows);
   }
-  return 0;
 }
 
-static void rowid_set_free(DiskAnnRowidSet *set) {
-  if (set->rowids) {
-    sqlite3_free(set->rowids);
-    set->rowids = NULL;
+static void filter_stmts_clear(diskann_vtab *p) {
+  for (int i = 0; i < DISKANN_FILTER_STMT_CACHE_SIZE; i++) {
+    sqlite3_free(p->filter_stmts[i].idx_str);
+    p->filter_stmts[i].idx_str = NULL;
+    sqlite3_finalize(p->filter_stmts[i].stmt);
+    p->filter_stmts[i].stmt = NULL;
+  }
+}
+
+/*
+** Cache key: the filter SQL followed by each bound value, tagged with its
+** type (text and blobs length-prefixed so values cannot run together).
+** Returns NULL on NOMEM.
+*/
+static char *filter_cache_key(sqlite3 *db, const char *sql,
+                              sqlite3_value **values, int n_values) {
+  sqlite3_str *k = sqlite3_str_new(db);
+  sqlite3_str_appendall(k, sql);
+  for (int i = 0; i < n_values; i++) {
+    sqlite3_value *v = values[i];
+    switch (sqlite3_value_type(v)) {
+    case SQLITE_INTEGER:
+      sqlite3_str_appendf(k, "|i%lld", sqlite3_value_int64(v));
+      break;
+    case SQLITE_FLOAT:
+      sqlite3_str_appendf(k, "|r%!.17g", sqlite3_value_double(v));
+      break;
+    case SQLITE_TEXT:
+      sqlite3_str_appendf(k, "|t%d:", sqlite3_value_bytes(v));
+      sqlite3_str_append(k, (const char *)sqlite3_value_text(v),
+                         sqlite3_value_bytes(v));
+      break;
+    case SQLITE_BLOB: {
+      const unsigned char *b = (const unsigned char *)sqlite3_value_blob(v);
+      int n = sqlite3_value_bytes(v);
+      sqlite3_str_appendf(k, "|b%d:", n);
+      for (int j = 0; j < n; j++) {
+        sqlite3_str_appendf(k, "%02x", b[j]);
+      }
+      break;
+    }
+    default:
+      sqlite3_str_appendall(k, "|n");
+      break;
+    }
+  }
+  return sqlite3_str_finish(k);
+}
+
+/* Step the prepared filter query into rows */
+static int filter_materialize(sqlite3_stmt *stmt, DiskAnnBitmap *rows) {
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    if (diskann_bitmap_add(rows, sqlite3_column_int64(stmt, 0)) !=
+        DISKANN_OK) {
+      return SQLITE_NOMEM;
+    }
+  }
+  return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+/*
+** Rows matching the prepared filter query stmt with values bound, from the
+** cache or by running it. *out points at a cache entry or at scratch
+** (which the caller deinits either way). Returns an SQLite result code.
+*/
+static int filter_rows(diskann_vtab *p, sqlite3_stmt *stmt,
+                       sqlite3_value **values, int n_values,
+                       DiskAnnBitmap *scratch, const DiskAnnBitmap **out) {
+  unsigned int version = 0;
+  char *key = NULL;
+  int rc;
+
+  int cacheable =
+      sqlite3_txn_state(p->db, p->db_name) != SQLITE_TXN_WRITE &&
+      sqlite3_file_control(p->db, p->db_name, SQLITE_FCNTL_DATA_VERSION,
+                           &version) == SQLITE_OK;
+  if (cacheable) {
+    if (version != p->filter_data_version) {
+      filter_cache_clear(p);
+      p->filter_data_version = version;
+    }
+    key = filter_cache_key(p->db, sqlite3_sql(stmt), values, n_values);
+    if (!key) {
+      return SQLITE_NOMEM;
+    }
+    for (int i = 0; i < DISKANN_FILTER_CACHE_SIZE; i++) {
+      DiskAnnFilterCacheEntry *e = &p->filter_cache[i];
+      if (e->key && strcmp(e->key, key) == 0) {
+        e->last_used = ++p->filter_tick;
+        sqlite3_free(key);
+        *out = &e->rows;
+        return SQLITE_OK;
+      }
+    }
+  }
+
+  for (int i = 0; i < n_values; i++) {
+    sqlite3_bind_value(stmt, i + 1, values[i]);
   }
-  set->count = 0;
+  rc = filter_materialize(stmt, scratch);
+  if (rc != SQLITE_OK) {
+    goto out;
+  }
+  *out = scratch;
+
+  if (cacheable) {
+    /* Move scratch into the unused or least recently used slot */
+    DiskAnnFilterCacheEntry *victim = &p->filter_cache[0];
+    for (int i = 1; i < DISKANN_FILTER_CACHE_SIZE && victim->key; i++) {
+      if (!p->filter_cache[i].key ||
+          p->filter_cache[i].last_used < victim->last_used) {
+        victim = &p->filter_cache[i];
+      }
+    }
+    sqlite3_free(victim->key);
+    diskann_bitmap_deinit(&victim->rows);
+    victim->key = key;
+    victim->rows = *scratch;
+    victim->last_used = ++p->filter_tick;
+    diskann_bitmap_init(scratch);
+    key = NULL;
+    *out = &victim->rows;
+  }
+
+out:
+  sqlite3_reset(stmt);
+  sqlite3_free(key);
+  return rc;
 }
 
 /*
@@ -707,8 +1404,10 @@ static const char *constraint_op_to_sql(int op) {
 
 /*
 ** xBestIndex — query planning.
-** Recognizes MATCH (vector search), EQ on k, LIMIT, ROWID EQ,
-** and metadata filter constraints (EQ/GT/LT/GE/LE/NE on columns >= 3).
+** Recognizes MATCH (vector search), EQ on k, search_list_size, exact and
+** recall_target,
+** distance < / <= (range search), LIMIT, ROWID EQ, and metadata filter
+** constraints (EQ/GT/LT/GE/LE/NE on metadata columns).
 */
 static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
   diskann_vtab *pVt = (diskann_vtab *)pVtab;
@@ -716,11 +1415,12 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
 
   /* Pass 1: Find constraint positions.
   ** SQLite presents constraints in arbitrary order, but xFilter reads argv
-  ** in a fixed order (MATCH, K, SEARCH_LIST_SIZE, LIMIT, ROWID, then filters).
+  ** in a fixed order (MATCH, K, SEARCH_LIST_SIZE, EXACT, RECALL_TARGET,
+  ** DISTANCE, LIMIT, ROWID, then filters).
   ** We must assign argvIndex values that match xFilter's consumption order, not
   ** constraint array order. Record positions first, assign in pass 2. */
-  int i_match = -1, i_k = -1, i_search_list_size = -1, i_limit = -1,
-      i_rowid = -1;
+  int i_match = -1, i_k = -1, i_search_list_size = -1, i_exact = -1,
+      i_recall_target = -1, i_distance = -1, i_limit = -1, i_rowid = -1;
 
   /* Filter constraints on metadata columns */
   int n_filters = 0;
@@ -745,6 +1445,19 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
                c->iColumn == DISKANN_COL_SEARCH_LIST_SIZE) {
       i_search_list_size = i;
       idxNum |= DISKANN_IDX_SEARCH_LIST_SIZE;
+    } else if (c->op == SQLITE_INDEX_CONSTRAINT_EQ &&
+               c->iColumn == DISKANN_COL_EXACT) {
+      i_exact = i;
+      idxNum |= DISKANN_IDX_EXACT;
+    } else if (c->op == SQLITE_INDEX_CONSTRAINT_EQ &&
+               c->iColumn == DISKANN_COL_RECALL_TARGET) {
+      i_recall_target = i;
+      idxNum |= DISKANN_IDX_RECALL_TARGET;
+    } else if ((c->op == SQLITE_INDEX_CONSTRAINT_LT ||
+                c->op == SQLITE_INDEX_CONSTRAINT_LE) &&
+               c->iColumn == DISKANN_COL_DISTANCE && i_distance < 0) {
+      i_distance = i;
+      idxNum |= DISKANN_IDX_DISTANCE;
     } else if (c->op == SQLITE_INDEX_CONSTRAINT_LIMIT) {
       i_limit = i;
       idxNum |= DISKANN_IDX_LIMIT;
@@ -768,7 +1481,8 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
   }
 
   /* Pass 2: Assign argvIndex in the order xFilter consumes them.
-  ** Order: MATCH, K, SEARCH_LIST_SIZE, LIMIT, ROWID, then filter constraints.
+  ** Order: MATCH, K, SEARCH_LIST_SIZE, EXACT, RECALL_TARGET, DISTANCE,
+  ** LIMIT, ROWID, then filter constraints.
   */
   int next_argv = 1;
   if (i_match >= 0) {
@@ -783,6 +1497,19 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
     pInfo->aConstraintUsage[i_search_list_size].argvIndex = next_argv++;
     pInfo->aConstraintUsage[i_search_list_size].omit = 1;
   }
+  if (i_exact >= 0) {
+    pInfo->aConstraintUsage[i_exact].argvIndex = next_argv++;
+    pInfo->aConstraintUsage[i_exact].omit = 1;
+  }
+  if (i_recall_target >= 0) {
+    pInfo->aConstraintUsage[i_recall_target].argvIndex = next_argv++;
+    pInfo->aConstraintUsage[i_recall_target].omit = 1;
+  }
+  if (i_distance >= 0) {
+    /* The search stops past the bound; SQLite applies the exact < or <= */
+    pInfo->aConstraintUsage[i_distance].argvIndex = next_argv++;
+    pInfo->aConstraintUsage[i_distance].omit = 0;
+  }
   if (i_limit >= 0) {
     pInfo->aConstraintUsage[i_limit].argvIndex = next_argv++;
     pInfo->aConstraintUsage[i_limit].omit = 1;
@@ -812,6 +1539,12 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
     pInfo->needToFreeIdxStr = 1;
   }
 
+  /* Metadata columns read (bit 63 stands for every column past 62) */
+  if (pVt->n_meta_cols > 0 &&
+      (pInfo->colUsed >> DISKANN_COL_META_START) != 0) {
+    idxNum |= DISKANN_IDX_META;
+  }
+
   pInfo->idxNum = idxNum;
 
   if (idxNum & DISKANN_IDX_MATCH) {
@@ -830,37 +1563,683 @@ static int diskannBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo) {
 }
 
 /*
-** xOpen — allocate a cursor.
+** Search n_queries concatenated query vectors, k results each, into
+** pCur->results, compacted in query order with pCur->query_index set per
+** row. Unfiltered queries share diskann_search_batch()'s worker pool;
+** filtered ones run one after another. Returns the total result count or
+** a negative DISKANN_ERROR_* code. label is passed on to
+** diskann_search_bitmap(); DISKANN_SEARCH_EXACT scores every (matching)
+** row for all queries in one pass instead.
 */
-static int diskannOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
-  diskann_cursor *pCur;
-
-  (void)pVtab;
-
-  pCur = sqlite3_malloc(sizeof(*pCur));
-  if (!pCur) {
-    return SQLITE_NOMEM;
+static int search_multi(diskann_vtab *pVtab, diskann_cursor *pCur,
+                        const float *queries, int n_queries, int k,
+                        const DiskAnnBitmap *filter, uint32_t label,
+                        const DiskAnnSearchParams *params) {
+  uint32_t dims = pVtab->dimensions;
+  int total = 0;
+  int rc = DISKANN_OK;
+
+  int *counts = sqlite3_malloc64((uint64_t)n_queries * sizeof(int));
+  if (!counts) {
+    return DISKANN_ERROR_NOMEM;
+  }
+  if (pVtab->shards) {
+    /* Each query fans out to every shard, searched concurrently */
+    for (int q = 0; q < n_queries && rc == DISKANN_OK; q++) {
+      const float *query = queries + (size_t)q * dims;
+      DiskAnnResult *out = pCur->results + (size_t)q * (size_t)k;
+      int n = filter ? diskann_shards_search_bitmap(pVtab->shards, query,
+                                                    dims, k, params, filter,
+                                                    out, 0)
+                     : diskann_shards_search(pVtab->shards, query, dims, k,
+                                             params, out, 0);
+      if (n < 0) {
+        rc = n;
+      } else {
+        counts[q] = n;
+      }
+    }
+  } else if (params->exact == DISKANN_SEARCH_EXACT) {
+    rc = diskann_search_exact_multi(pVtab->idx, queries, n_queries, dims, k,
+                                    pCur->results, counts, filter);
+  } else if (filter) {
+    for (int q = 0; q < n_queries && rc == DISKANN_OK; q++) {
+      int n = diskann_search_bitmap(pVtab->idx, queries + (size_t)q * dims,
+                                    dims, k,
+                                    pCur->results + (size_t)q * (size_t)k,
+                                    filter, label, params);
+      if (n < 0) {
+        rc = n;
+      } else {
+        counts[q] = n;
+      }
+    }
+  } else {
+    rc = diskann_search_batch_ex(pVtab->idx, queries, n_queries, dims, k,
+                                 params, pCur->results, counts, 0);
+  }
+  if (rc != DISKANN_OK) {
+    goto out;
   }
-  memset(pCur, 0, sizeof(*pCur));
 
-  *ppCursor = &pCur->base;
+  for (int q = 0; q < n_queries; q++) {
+    total += counts[q];
+  }
+  if (total > 0) {
+    pCur->query_index = sqlite3_malloc64((uint64_t)total * sizeof(int));
+    if (!pCur->query_index) {
+      rc = DISKANN_ERROR_NOMEM;
+      goto out;
+    }
+  }
+
+  /* Slide each query's results down over the unused tail of the previous
+  ** query's k slots */
+  total = 0;
+  for (int q = 0; q < n_queries; q++) {
+    const DiskAnnResult *src = pCur->results + (size_t)q * (size_t)k;
+    for (int i = 0; i < counts[q]; i++) {
+      pCur->results[total] = src[i];
+      pCur->query_index[total] = q;
+      total++;
+    }
+  }
+
+out:
+  sqlite3_free(counts);
+  return rc == DISKANN_OK ? total : rc;
+}
+
+static int result_distance_cmp(const void *a, const void *b) {
+  float x = ((const DiskAnnResult *)a)->distance;
+  float y = ((const DiskAnnResult *)b)->distance;
+  return (x > y) - (x < y);
+}
+
+/*
+** Range search of a sharded table: every row within max_distance, pulled
+** from a stream on each shard in turn and sorted by distance into
+** pCur->results.
+*/
+static int shards_range_search(diskann_vtab *pVtab, diskann_cursor *pCur,
+                               const float *query, float max_distance,
+                               const DiskAnnBitmap *filter,
+                               const DiskAnnSearchParams *params) {
+  int capacity = 0;
+  int rc = DISKANN_OK;
+
+  for (int i = 0; i < diskann_shard_count(pVtab->shards) && rc == DISKANN_OK;
+       i++) {
+    DiskAnnSearchStream *stream = NULL;
+    rc = diskann_search_stream_open(diskann_shard_index(pVtab->shards, i),
+                                    query, pVtab->dimensions, -1,
+                                    max_distance, filter, DISKANN_LABEL_NONE,
+                                    params, &stream);
+    while (rc == DISKANN_OK) {
+      DiskAnnResult row;
+      int n = diskann_search_stream_next(stream, &row);
+      if (n <= 0) {
+        rc = n;
+        break;
+      }
+      if (pCur->num_results == capacity) {
+        int grown = capacity > 0 ? capacity * 2 : 64;
+        DiskAnnResult *results = sqlite3_realloc64(
+            pCur->results, (uint64_t)grown * sizeof(DiskAnnResult));
+        if (!results) {
+          rc = DISKANN_ERROR_NOMEM;
+          break;
+        }
+        pCur->results = results;
+        capacity = grown;
+      }
+      pCur->results[pCur->num_results++] = row;
+    }
+    diskann_search_stream_close(stream);
+  }
+  if (rc == DISKANN_OK) {
+    qsort(pCur->results, (size_t)pCur->num_results, sizeof(DiskAnnResult),
+          result_distance_cmp);
+  }
+  return rc;
+}
+
+/*
+** xOpen — allocate a cursor.
+*/
+static int diskannOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  diskann_cursor *pCur;
+
+  (void)pVtab;
+
+  pCur = sqlite3_malloc(sizeof(*pCur));
+  if (!pCur) {
+    return SQLITE_NOMEM;
+  }
+  memset(pCur, 0, sizeof(*pCur));
+
+  *ppCursor = &pCur->base;
   return SQLITE_OK;
 }
 
+/* Drop the previous search's results, stream and filter rows (the
+** metadata buffers are kept for the next search) */
+static void cursor_reset(diskann_cursor *pCur) {
+  pCur->n_meta_rows = 0;
+  pCur->meta_bytes_used = 0;
+  sqlite3_free(pCur->results);
+  pCur->results = NULL;
+  sqlite3_free(pCur->query_index);
+  pCur->query_index = NULL;
+  diskann_search_stream_close(pCur->stream);
+  pCur->stream = NULL;
+  diskann_bitmap_deinit(&pCur->filter);
+  pCur->num_results = 0;
+  pCur->current = 0;
+  pCur->stream_eof = 0;
+}
+
+/* Map a negative DISKANN_ERROR_* code to an SQLite result code */
+static int search_error_to_sqlite(int rc) {
+  return rc == DISKANN_ERROR_NOMEM ? SQLITE_NOMEM : SQLITE_ERROR;
+}
+
+/*
+** The batched metadata SELECT: every metadata column of the _attrs rows
+** whose rowids are bound to its DISKANN_META_BATCH parameters (unused ones
+** NULL), in rowid order. Prepared once per vtab.
+*/
+static int meta_stmt(diskann_vtab *pVtab, sqlite3_stmt **out) {
+  if (pVtab->meta_stmt) {
+    *out = pVtab->meta_stmt;
+    return SQLITE_OK;
+  }
+
+  sqlite3_str *ms = sqlite3_str_new(pVtab->db);
+  sqlite3_str_appendall(ms, "SELECT rowid");
+  for (int mi = 0; mi < pVtab->n_meta_cols; mi++) {
+    sqlite3_str_appendf(ms, ", \"%w\"", pVtab->meta_cols[mi].name);
+  }
+  sqlite3_str_appendf(ms, " FROM \"%w\".\"%w_attrs\" WHERE rowid IN (",
+                      pVtab->db_name, pVtab->table_name);
+  for (int i = 1; i <= DISKANN_META_BATCH; i++) {
+    sqlite3_str_appendf(ms, i > 1 ? ", ?%d" : "?%d", i);
+  }
+  sqlite3_str_appendall(ms, ") ORDER BY rowid");
+  char *meta_sql = sqlite3_str_finish(ms);
+  if (!meta_sql)
+    return SQLITE_NOMEM;
+
+  int rc = sqlite3_prepare_v3(pVtab->db, meta_sql, -1,
+                              SQLITE_PREPARE_PERSISTENT, &pVtab->meta_stmt,
+                              NULL);
+  sqlite3_free(meta_sql);
+  if (rc != SQLITE_OK) {
+    /* Metadata query failed - return error instead of silently returning
+     * NULLs */
+    const char *err = sqlite3_errmsg(pVtab->db);
+    sqlite3_free(pVtab->base.zErrMsg);
+    pVtab->base.zErrMsg = sqlite3_mprintf(
+        "Failed to prepare metadata query for table %s: %s (code %d)",
+        pVtab->table_name, err, rc);
+    pVtab->meta_stmt = NULL;
+    return rc;
+  }
+  *out = pVtab->meta_stmt;
+  return SQLITE_OK;
+}
+
+/* A results row by rowid, for merging with the rowid-ordered SELECT */
+typedef struct MetaRowRef {
+  int64_t id;
+  int row;
+} MetaRowRef;
+
+static int meta_row_ref_cmp(const void *a, const void *b) {
+  int64_t x = ((const MetaRowRef *)a)->id;
+  int64_t y = ((const MetaRowRef *)b)->id;
+  return (x > y) - (x < y);
+}
+
+/* Copy column col of stmt's row into *dst */
+static int meta_value_copy(diskann_cursor *pCur, sqlite3_stmt *stmt, int col,
+                           DiskAnnMetaValue *dst) {
+  dst->type = sqlite3_column_type(stmt, col);
+  switch (dst->type) {
+  case SQLITE_INTEGER:
+    dst->v.i = sqlite3_column_int64(stmt, col);
+    return SQLITE_OK;
+  case SQLITE_FLOAT:
+    dst->v.r = sqlite3_column_double(stmt, col);
+    return SQLITE_OK;
+  case SQLITE_TEXT:
+  case SQLITE_BLOB:
+    break;
+  default:
+    dst->type = 0;
+    return SQLITE_OK;
+  }
+
+  const void *bytes = dst->type == SQLITE_TEXT
+                          ? (const void *)sqlite3_column_text(stmt, col)
+                          : sqlite3_column_blob(stmt, col);
+  size_t n = (size_t)sqlite3_column_bytes(stmt, col);
+  if (!pCur->meta_bytes ||
+      pCur->meta_bytes_used + n > pCur->meta_bytes_capacity) {
+    size_t capacity =
+        pCur->meta_bytes_capacity ? pCur->meta_bytes_capacity * 2 : 4096;
+    while (capacity < pCur->meta_bytes_used + n) {
+      capacity *= 2;
+    }
+    unsigned char *grown =
+        (unsigned char *)sqlite3_realloc64(pCur->meta_bytes, capacity);
+    if (!grown) {
+      return SQLITE_NOMEM;
+    }
+    pCur->meta_bytes = grown;
+    pCur->meta_bytes_capacity = capacity;
+  }
+  if (n > 0) {
+    memcpy(pCur->meta_bytes + pCur->meta_bytes_used, bytes, n);
+  }
+  dst->n = (int)n;
+  dst->v.off = pCur->meta_bytes_used;
+  pCur->meta_bytes_used += n;
+  return SQLITE_OK;
+}
+
+/*
+** Fetch the metadata columns of every results row into pCur->meta: the
+** rowids are sorted and looked up DISKANN_META_BATCH at a time, so the
+** _attrs B-tree is read in one ordered pass however many rows there are.
+** Rows without an _attrs row read as NULL. Returns an SQLite result code.
+*/
+static int cursor_fetch_meta(diskann_vtab *pVtab, diskann_cursor *pCur) {
+  int n = pCur->num_results;
+  size_t n_cols = (size_t)pVtab->n_meta_cols;
+  sqlite3_stmt *stmt = NULL;
+  MetaRowRef *refs = NULL;
+
+  pCur->n_meta_rows = 0;
+  pCur->meta_bytes_used = 0;
+  if (n == 0) {
+    return SQLITE_OK;
+  }
+  int rc = meta_stmt(pVtab, &stmt);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  if (n > pCur->meta_capacity) {
+    DiskAnnMetaValue *grown = (DiskAnnMetaValue *)sqlite3_realloc64(
+        pCur->meta, (uint64_t)n * n_cols * sizeof(DiskAnnMetaValue));
+    if (!grown) {
+      return SQLITE_NOMEM;
+    }
+    pCur->meta = grown;
+    pCur->meta_capacity = n;
+  }
+  refs = (MetaRowRef *)sqlite3_malloc64((uint64_t)n * sizeof(MetaRowRef));
+  if (!refs) {
+    return SQLITE_NOMEM;
+  }
+  memset(pCur->meta, 0, (size_t)n * n_cols * sizeof(DiskAnnMetaValue));
+  for (int i = 0; i < n; i++) {
+    refs[i].id = pCur->results[i].id;
+    refs[i].row = i;
+  }
+  qsort(refs, (size_t)n, sizeof(MetaRowRef), meta_row_ref_cmp);
+
+  int i = 0;
+  while (i < n && rc == SQLITE_OK) {
+    /* Bind the next distinct rowids; a rowid can repeat across queries */
+    int start = i;
+    int n_bound = 0;
+    for (; i < n; i++) {
+      if (i > start && refs[i].id == refs[i - 1].id) {
+        continue;
+      }
+      if (n_bound == DISKANN_META_BATCH) {
+        break;
+      }
+      sqlite3_bind_int64(stmt, ++n_bound, refs[i].id);
+    }
+    for (int b = n_bound + 1; b <= DISKANN_META_BATCH; b++) {
+      sqlite3_bind_null(stmt, b);
+    }
+
+    /* Merge the rowid-ordered rows into refs[start, i) */
+    int j = start;
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW && rc == SQLITE_OK) {
+      int64_t rowid = sqlite3_column_int64(stmt, 0);
+      while (j < i && refs[j].id < rowid) {
+        j++;
+      }
+      for (; j < i && refs[j].id == rowid && rc == SQLITE_OK; j++) {
+        DiskAnnMetaValue *dst = pCur->meta + (size_t)refs[j].row * n_cols;
+        for (size_t c = 0; c < n_cols && rc == SQLITE_OK; c++) {
+          rc = meta_value_copy(pCur, stmt, (int)c + 1, &dst[c]);
+        }
+      }
+    }
+    if (rc == SQLITE_OK && step != SQLITE_DONE) {
+      rc = step;
+    }
+    sqlite3_reset(stmt);
+  }
+
+  sqlite3_free(refs);
+  if (rc == SQLITE_OK) {
+    pCur->n_meta_rows = n;
+  }
+  return rc;
+}
+
+/*
+** Pull the stream's next rows into results, a chunk that doubles up to
+** DISKANN_META_CHUNK_MAX rows, and fetch their metadata. num_results is 0
+** once the stream is exhausted.
+*/
+static int cursor_stream_fill(diskann_cursor *pCur) {
+  if (!pCur->results) {
+    pCur->results = (DiskAnnResult *)sqlite3_malloc64(
+        DISKANN_META_CHUNK_MAX * sizeof(DiskAnnResult));
+    if (!pCur->results) {
+      return SQLITE_NOMEM;
+    }
+    pCur->stream_chunk = DISKANN_META_CHUNK_MIN;
+  }
+
+  int n = 0;
+  pCur->num_results = 0;
+  pCur->current = 0;
+  while (n < pCur->stream_chunk) {
+    int rc = diskann_search_stream_next(pCur->stream, &pCur->results[n]);
+    if (rc < 0) {
+      return search_error_to_sqlite(rc);
+    }
+    if (rc == 0) {
+      break;
+    }
+    n++;
+  }
+  pCur->num_results = n;
+  if (pCur->stream_chunk < DISKANN_META_CHUNK_MAX) {
+    pCur->stream_chunk *= 2;
+  }
+  return cursor_fetch_meta((diskann_vtab *)pCur->base.pVtab, pCur);
+}
+
+/* Move a streaming cursor to the stream's next row */
+static int cursor_stream_step(diskann_cursor *pCur) {
+  if (pCur->meta_used) {
+    /* Rows come through results, with their metadata fetched per chunk */
+    if (++pCur->current >= pCur->num_results) {
+      int rc = cursor_stream_fill(pCur);
+      if (rc != SQLITE_OK) {
+        pCur->stream_eof = 1;
+        return rc;
+      }
+    }
+    pCur->stream_eof = pCur->current >= pCur->num_results;
+    if (!pCur->stream_eof) {
+      pCur->row = pCur->results[pCur->current];
+    }
+    return SQLITE_OK;
+  }
+
+  int rc = diskann_search_stream_next(pCur->stream, &pCur->row);
+  if (rc < 0) {
+    pCur->stream_eof = 1;
+    return search_error_to_sqlite(rc);
+  }
+  pCur->stream_eof = rc == 0;
+  return SQLITE_OK;
+}
+
+static int cursor_eof(const diskann_cursor *pCur) {
+  return pCur->stream ? pCur->stream_eof : pCur->current >= pCur->num_results;
+}
+
+/* The row the cursor is on (cursor_eof() must be false) */
+static const DiskAnnResult *cursor_row(const diskann_cursor *pCur) {
+  return pCur->stream ? &pCur->row : &pCur->results[pCur->current];
+}
+
 /*
 ** xClose — free cursor and results.
 */
 static int diskannClose(sqlite3_vtab_cursor *pCursor) {
   diskann_cursor *pCur = (diskann_cursor *)pCursor;
-  if (pCur->meta_stmt) {
-    sqlite3_finalize(pCur->meta_stmt);
-    pCur->meta_stmt = NULL;
-  }
-  sqlite3_free(pCur->results);
+  cursor_reset(pCur);
+  sqlite3_free(pCur->meta);
+  sqlite3_free(pCur->meta_bytes);
   sqlite3_free(pCur);
   return SQLITE_OK;
 }
 
+/*
+** The prepared filter query for idxStr's n_fc constraints (fc_col, fc_op),
+** from pVtab->filter_stmts or prepared and cached there. Returns an SQLite
+** result code.
+*/
+static int filter_stmt(diskann_vtab *pVtab, const char *idxStr, int n_fc,
+                       const int *fc_col, const int *fc_op,
+                       sqlite3_stmt **out) {
+  if (!idxStr) {
+    idxStr = "";
+  }
+  DiskAnnFilterStmt *victim = &pVtab->filter_stmts[0];
+  for (int i = 0; i < DISKANN_FILTER_STMT_CACHE_SIZE; i++) {
+    DiskAnnFilterStmt *e = &pVtab->filter_stmts[i];
+    if (e->idx_str && strcmp(e->idx_str, idxStr) == 0) {
+      e->last_used = ++pVtab->filter_tick;
+      *out = e->stmt;
+      return SQLITE_OK;
+    }
+    if (victim->idx_str &&
+        (!e->idx_str || e->last_used < victim->last_used)) {
+      victim = e;
+    }
+  }
+
+  /* Build SQL: SELECT rowid FROM _attrs WHERE col1 op1 ? AND ... */
+  sqlite3_str *fs = sqlite3_str_new(pVtab->db);
+  sqlite3_str_appendf(fs, "SELECT rowid FROM \"%w\".\"%w_attrs\" WHERE 1=1",
+                      pVtab->db_name, pVtab->table_name);
+  for (int fi = 0; fi < n_fc; fi++) {
+    const char *op_str = constraint_op_to_sql(fc_op[fi]);
+    if (op_str && fc_col[fi] >= 0 && fc_col[fi] < pVtab->n_meta_cols) {
+      sqlite3_str_appendf(fs, " AND \"%w\" %s ?",
+                          pVtab->meta_cols[fc_col[fi]].name, op_str);
+    }
+  }
+  sqlite3_str_appendall(fs, " ORDER BY rowid");
+  char *filter_sql = sqlite3_str_finish(fs);
+  char *key = sqlite3_mprintf("%s", idxStr);
+  if (!filter_sql || !key) {
+    sqlite3_free(filter_sql);
+    sqlite3_free(key);
+    return SQLITE_NOMEM;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  int rc = sqlite3_prepare_v3(pVtab->db, filter_sql, -1,
+                              SQLITE_PREPARE_PERSISTENT, &stmt, NULL);
+  sqlite3_free(filter_sql);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(key);
+    return rc;
+  }
+  sqlite3_free(victim->idx_str);
+  sqlite3_finalize(victim->stmt);
+  victim->idx_str = key;
+  victim->stmt = stmt;
+  victim->last_used = ++pVtab->filter_tick;
+  *out = stmt;
+  return SQLITE_OK;
+}
+
+/*
+** Rows matching the metadata filter constraints: idxStr's "col_offset:op"
+** pairs with their values in argv. *rows points at a filter cache entry or
+** at scratch. *label is the label of an equality on the LABEL column
+** (every match carries it), else DISKANN_LABEL_NONE. Returns an SQLite
+** result code.
+*/
+static int match_filter(diskann_vtab *pVtab, const char *idxStr,
+                        sqlite3_value **argv, DiskAnnBitmap *scratch,
+                        const DiskAnnBitmap **rows, uint32_t *label) {
+  /* Parse idxStr: comma-separated "col_offset:op" pairs */
+  int n_fc = 0;
+  int fc_col[DISKANN_MAX_FILTERS];
+  int fc_op[DISKANN_MAX_FILTERS];
+  if (idxStr) {
+    const char *p = idxStr;
+    while (*p && n_fc < DISKANN_MAX_FILTERS) {
+      fc_col[n_fc] = (int)strtol(p, (char **)&p, 10);
+      if (*p == ':')
+        p++;
+      fc_op[n_fc] = (int)strtol(p, (char **)&p, 10);
+      n_fc++;
+      if (*p == ',')
+        p++;
+    }
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  int rc = filter_stmt(pVtab, idxStr, n_fc, fc_col, fc_op, &stmt);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+
+  /* Matching rowids: cached bitmap, or materialized from _attrs */
+  rc = filter_rows(pVtab, stmt, argv, n_fc, scratch, rows);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+
+  /* Equality on the LABEL column: every match carries that label */
+  *label = DISKANN_LABEL_NONE;
+  for (int fi = 0; fi < n_fc && pVtab->label_col >= 0; fi++) {
+    if (fc_op[fi] == SQLITE_INDEX_CONSTRAINT_EQ &&
+        fc_col[fi] == pVtab->label_col) {
+      *label = diskann_label_hash(argv[fi], pVtab->idx->labels->affinity);
+      break;
+    }
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Run a MATCH search: k rows per query (< 0 = no limit, single query
+** only), none further than max_distance. One query opens a stream on the
+** cursor and moves it to the first row; several, or any on a sharded
+** table, fill pCur->results. argv
+** holds the filter values when idxNum has DISKANN_IDX_FILTER. Returns an
+** SQLite result code.
+*/
+static int match_search(diskann_vtab *pVtab, diskann_cursor *pCur,
+                        int idxNum, const char *idxStr, sqlite3_value **argv,
+                        const float *query, int n_queries, int64_t k,
+                        float max_distance,
+                        const DiskAnnSearchParams *params) {
+  DiskAnnBitmap scratch;
+  const DiskAnnBitmap *rows = NULL;
+  uint32_t label = DISKANN_LABEL_NONE;
+  int rc = SQLITE_OK;
+
+  diskann_bitmap_init(&scratch);
+  if (idxNum & DISKANN_IDX_FILTER) {
+    rc = match_filter(pVtab, idxStr, argv, &scratch, &rows, &label);
+    if (rc != SQLITE_OK) {
+      goto out;
+    }
+  }
+
+  if (pVtab->shards && k < 0) {
+    int src = shards_range_search(pVtab, pCur, query, max_distance, rows,
+                                  params);
+    rc = src == DISKANN_OK ? SQLITE_OK : search_error_to_sqlite(src);
+    goto out;
+  }
+
+  /* One query streams; a sharded table searches its shards up front */
+  if (n_queries == 1 && !pVtab->shards) {
+    /* The stream borrows its filter rows, and cache entries can be
+    ** evicted while it runs: the cursor keeps its own */
+    if (rows == &scratch) {
+      pCur->filter = scratch;
+      diskann_bitmap_init(&scratch);
+      rows = &pCur->filter;
+    } else if (rows) {
+      if (diskann_bitmap_copy(&pCur->filter, rows) != DISKANN_OK) {
+        rc = SQLITE_NOMEM;
+        goto out;
+      }
+      rows = &pCur->filter;
+    }
+    int src = diskann_search_stream_open(pVtab->idx, query, pVtab->dimensions,
+                                         k, max_distance, rows, label,
+                                         params, &pCur->stream);
+    if (src != DISKANN_OK) {
+      rc = search_error_to_sqlite(src);
+      goto out;
+    }
+    rc = cursor_stream_step(pCur);
+    goto out;
+  }
+
+  /* k results per query, filled in up front */
+  pCur->results = sqlite3_malloc64((uint64_t)n_queries * (uint64_t)k *
+                                   sizeof(DiskAnnResult));
+  if (!pCur->results) {
+    rc = SQLITE_NOMEM;
+    goto out;
+  }
+  int n = search_multi(pVtab, pCur, query, n_queries, (int)k, rows, label,
+                       params);
+  if (n < 0) {
+    rc = search_error_to_sqlite(n);
+    goto out;
+  }
+  pCur->num_results = n;
+
+out:
+  diskann_bitmap_deinit(&scratch);
+  return rc;
+}
+
+/*
+** The elements of a vector BLOB, stored in the table's vector_type, as
+** float32 for the C API. *n_elements gets the element count and *owned a
+** decoded copy for the caller to sqlite3_free(), or NULL when a float32
+** blob is used in place. Returns SQLITE_OK or SQLITE_NOMEM.
+*/
+static int vector_blob_floats(const diskann_vtab *p, sqlite3_value *value,
+                              const float **out, uint32_t *n_elements,
+                              float **owned) {
+  const uint8_t *blob = (const uint8_t *)sqlite3_value_blob(value);
+  int bytes = sqlite3_value_bytes(value);
+  uint8_t vector_type = p->idx->vector_type;
+  uint32_t n =
+      (uint32_t)((size_t)bytes / diskann_vector_element_size(vector_type));
+
+  *owned = NULL;
+  *n_elements = n;
+  if (vector_type == DISKANN_VECTOR_FLOAT32 || !blob || n == 0) {
+    *out = (const float *)blob;
+    return SQLITE_OK;
+  }
+  *owned = (float *)sqlite3_malloc64((uint64_t)n * sizeof(float));
+  if (!*owned) {
+    return SQLITE_NOMEM;
+  }
+  diskann_elements_decode(vector_type, blob, n, *owned);
+  *out = *owned;
+  return SQLITE_OK;
+}
+
 /*
 ** xFilter — execute search or ROWID lookup based on idxNum from xBestIndex.
 */
@@ -873,21 +2252,21 @@ static int diskannFilter(sqlite3_vtab_cursor *pCursor, int idxNum,
   (void)argc;
 
   /* Free previous results */
-  if (pCur->results) {
-    sqlite3_free(pCur->results);
-    pCur->results = NULL;
-  }
-  pCur->num_results = 0;
-  pCur->current = 0;
+  cursor_reset(pCur);
+  pCur->meta_used = (idxNum & DISKANN_IDX_META) != 0;
 
   if (idxNum & DISKANN_IDX_MATCH) {
     /* ANN search path */
-    const float *query = (const float *)sqlite3_value_blob(argv[next]);
-    int bytes = sqlite3_value_bytes(argv[next]);
-    uint32_t query_dims = (uint32_t)((size_t)bytes / sizeof(float));
+    const float *query = NULL;
+    float *query_owned = NULL;
+    uint32_t query_dims = 0;
+    if (vector_blob_floats(pVtab, argv[next], &query, &query_dims,
+                           &query_owned) != SQLITE_OK) {
+      return SQLITE_NOMEM;
+    }
     next++;
 
-    int k = 10; /* default */
+    int64_t k = -1; /* not given */
     if (idxNum & DISKANN_IDX_K) {
       k = sqlite3_value_int(argv[next]);
       if (k <= 0)
@@ -895,223 +2274,122 @@ static int diskannFilter(sqlite3_vtab_cursor *pCursor, int idxNum,
       next++;
     }
 
-    /* Override search beam width if specified */
-    uint32_t saved_search_list_size = pVtab->idx->search_list_size;
+    /* Per-query beam width override; the shared handle is not touched */
+    DiskAnnSearchParams params = {0};
     if (idxNum & DISKANN_IDX_SEARCH_LIST_SIZE) {
       int search_list_size = sqlite3_value_int(argv[next]);
       if (search_list_size > 0) {
-        pVtab->idx->search_list_size = (uint32_t)search_list_size;
+        params.search_list_size = (uint32_t)search_list_size;
       }
       next++;
     }
 
-    if (idxNum & DISKANN_IDX_LIMIT) {
-      int limit = sqlite3_value_int(argv[next]);
-      if (limit > 0 && limit < k)
-        k = limit;
+    /* exact = 1 scans instead of walking; exact = 0 never scans */
+    if (idxNum & DISKANN_IDX_EXACT) {
+      params.exact = sqlite3_value_int(argv[next]) != 0 ? DISKANN_SEARCH_EXACT
+                                                        : DISKANN_SEARCH_GRAPH;
       next++;
     }
-    /* Skip ROWID arg if also present (unlikely with MATCH, but be safe) */
-    if (idxNum & DISKANN_IDX_ROWID) {
+
+    /* recall_target = r sizes the beam from the calibrated recall curve */
+    if (idxNum & DISKANN_IDX_RECALL_TARGET) {
+      double target = sqlite3_value_double(argv[next]);
+      if (!(target > 0.0 && target <= 1.0)) {
+        sqlite3_free(query_owned);
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "diskann: recall_target must be in (0, 1], got %g", target);
+        return SQLITE_ERROR;
+      }
+      params.recall_target = (float)target;
       next++;
     }
 
-    if (!query || query_dims == 0) {
-      pCur->num_results = 0;
-      /* Restore original search_list_size */
-      pVtab->idx->search_list_size = saved_search_list_size;
-      return SQLITE_OK;
+    /* distance < bound or <= bound: rounded up to a float, SQLite
+    ** compares exactly */
+    float max_distance = INFINITY;
+    if (idxNum & DISKANN_IDX_DISTANCE) {
+      double bound = sqlite3_value_double(argv[next]);
+      max_distance = (float)bound;
+      if ((double)max_distance < bound) {
+        max_distance = nextafterf(max_distance, INFINITY);
+      }
+      next++;
     }
 
-    pCur->results = sqlite3_malloc(k * (int)sizeof(DiskAnnResult));
-    if (!pCur->results) {
-      /* Restore original search_list_size */
-      pVtab->idx->search_list_size = saved_search_list_size;
-      return SQLITE_NOMEM;
+    int64_t limit = 0;
+    if (idxNum & DISKANN_IDX_LIMIT) {
+      limit = sqlite3_value_int64(argv[next]);
+      next++;
+    }
+    /* Skip ROWID arg if also present (unlikely with MATCH, but be safe) */
+    if (idxNum & DISKANN_IDX_ROWID) {
+      next++;
     }
 
-    int rc;
-    if (idxNum & DISKANN_IDX_FILTER) {
-      /* Build rowid set from metadata filter constraints */
-      DiskAnnRowidSet rset = {NULL, 0};
-
-      /* Parse idxStr: comma-separated "col_offset:op" pairs */
-      int n_fc = 0;
-      int fc_col[DISKANN_MAX_FILTERS];
-      int fc_op[DISKANN_MAX_FILTERS];
-      if (idxStr) {
-        const char *p = idxStr;
-        while (*p && n_fc < DISKANN_MAX_FILTERS) {
-          fc_col[n_fc] = (int)strtol(p, (char **)&p, 10);
-          if (*p == ':')
-            p++;
-          fc_op[n_fc] = (int)strtol(p, (char **)&p, 10);
-          n_fc++;
-          if (*p == ',')
-            p++;
-        }
-      }
-
-      /* Build SQL: SELECT rowid FROM _attrs WHERE col1 op1 ? AND ... */
-      sqlite3_str *fs = sqlite3_str_new(pVtab->db);
-      sqlite3_str_appendf(fs, "SELECT rowid FROM \"%w\".\"%w_attrs\" WHERE 1=1",
-                          pVtab->db_name, pVtab->table_name);
-      for (int fi = 0; fi < n_fc; fi++) {
-        const char *op_str = constraint_op_to_sql(fc_op[fi]);
-        if (op_str && fc_col[fi] >= 0 && fc_col[fi] < pVtab->n_meta_cols) {
-          sqlite3_str_appendf(fs, " AND \"%w\" %s ?",
-                              pVtab->meta_cols[fc_col[fi]].name, op_str);
-        }
-      }
-      sqlite3_str_appendall(fs, " ORDER BY rowid");
-      char *filter_sql = sqlite3_str_finish(fs);
-      if (!filter_sql) {
-        sqlite3_free(pCur->results);
-        pCur->results = NULL;
-        return SQLITE_NOMEM;
-      }
-
-      /* Execute filter query */
-      sqlite3_stmt *fstmt;
-      rc = sqlite3_prepare_v2(pVtab->db, filter_sql, -1, &fstmt, NULL);
-      sqlite3_free(filter_sql);
-      if (rc != SQLITE_OK) {
-        sqlite3_free(pCur->results);
-        pCur->results = NULL;
-        return rc;
-      }
-
-      /* Bind filter values from argv */
-      for (int fi = 0; fi < n_fc; fi++) {
-        sqlite3_bind_value(fstmt, fi + 1, argv[next + fi]);
+    int rc = SQLITE_OK;
+    if (query && query_dims > 0) {
+      /* Several concatenated query vectors: k results per query */
+      int n_queries = 1;
+      if (query_dims > pVtab->dimensions &&
+          query_dims % pVtab->dimensions == 0) {
+        n_queries = (int)(query_dims / pVtab->dimensions);
       }
 
-      /* Collect rowids into dynamic array */
-      int cap = 64;
-      rset.rowids = sqlite3_malloc(cap * (int)sizeof(int64_t));
-      if (!rset.rowids) {
-        sqlite3_finalize(fstmt);
-        sqlite3_free(pCur->results);
-        pCur->results = NULL;
-        return SQLITE_NOMEM;
+      /* Without k, a single query streams until LIMIT or the distance
+      ** bound stops it; anything else returns 10 rows per query */
+      if (limit > 0 && (k < 0 || limit < k)) {
+        k = limit;
       }
-      rset.count = 0;
-
-      while (sqlite3_step(fstmt) == SQLITE_ROW) {
-        if (rset.count >= cap) {
-          cap *= 2;
-          int64_t *tmp =
-              sqlite3_realloc(rset.rowids, cap * (int)sizeof(int64_t));
-          if (!tmp) {
-            sqlite3_finalize(fstmt);
-            rowid_set_free(&rset);
-            sqlite3_free(pCur->results);
-            pCur->results = NULL;
-            return SQLITE_NOMEM;
-          }
-          rset.rowids = tmp;
-        }
-        rset.rowids[rset.count++] = sqlite3_column_int64(fstmt, 0);
+      if (k < 0 && (!(idxNum & DISKANN_IDX_DISTANCE) || n_queries > 1)) {
+        k = 10;
       }
-      sqlite3_finalize(fstmt);
-
-      /* Run filtered search */
-      rc = diskann_search_filtered(pVtab->idx, query, query_dims, k,
-                                   pCur->results, rowid_set_contains, &rset);
-      rowid_set_free(&rset);
-    } else {
-      /* Unfiltered search */
-      rc = diskann_search(pVtab->idx, query, query_dims, k, pCur->results);
+      rc = match_search(pVtab, pCur, idxNum, idxStr, argv + next, query,
+                        n_queries, k, max_distance, &params);
     }
+    sqlite3_free(query_owned);
 
-    /* Restore original search_list_size */
-    pVtab->idx->search_list_size = saved_search_list_size;
-
-    if (rc < 0) {
-      sqlite3_free(pCur->results);
-      pCur->results = NULL;
-      return SQLITE_ERROR;
+    if (rc != SQLITE_OK) {
+      cursor_reset(pCur);
+      return rc;
     }
-    pCur->num_results = rc; /* rc IS the count */
-    pCur->current = 0;
-    goto prepare_meta_stmt;
+    goto fetch_meta;
   }
 
   if (idxNum & DISKANN_IDX_ROWID) {
     /* ROWID scan — single-row lookup for DELETE support */
     sqlite_int64 target = sqlite3_value_int64(argv[next]);
 
-    /* Check if row exists in shadow table */
-    char *sql =
-        sqlite3_mprintf("SELECT 1 FROM \"%w\".\"%w_shadow\" WHERE id = ?",
-                        pVtab->db_name, pVtab->table_name);
-    if (!sql)
-      return SQLITE_NOMEM;
-
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(pVtab->db, sql, -1, &stmt, NULL);
-    sqlite3_free(sql);
+    /* Tombstoned rows are already deleted */
+    DiskAnnIndex *idx = NULL;
+    int rc = vtab_route(pVtab, target, NULL, &idx);
     if (rc != SQLITE_OK)
       return rc;
-
-    sqlite3_bind_int64(stmt, 1, target);
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    rc = idx ? diskann_node_exists(idx, target) : 0;
+    if (rc < 0)
+      return SQLITE_ERROR;
+    if (rc == 1) {
       pCur->results = sqlite3_malloc((int)sizeof(DiskAnnResult));
-      if (!pCur->results) {
-        sqlite3_finalize(stmt);
+      if (!pCur->results)
         return SQLITE_NOMEM;
-      }
       pCur->results[0].id = target;
       pCur->results[0].distance = 0.0f;
       pCur->num_results = 1;
     } else {
       pCur->num_results = 0;
     }
-    sqlite3_finalize(stmt);
     pCur->current = 0;
-    goto prepare_meta_stmt;
+    goto fetch_meta;
   }
 
   /* No MATCH, no ROWID → empty result set */
   pCur->num_results = 0;
   return SQLITE_OK;
 
-prepare_meta_stmt:
-  /* Prepare metadata SELECT statement if vtab has metadata columns */
-  if (pCur->meta_stmt) {
-    sqlite3_finalize(pCur->meta_stmt);
-    pCur->meta_stmt = NULL;
-  }
-  pCur->meta_cached_rowid = -1;
-  pCur->meta_has_row = 0;
-
-  if (pVtab->n_meta_cols > 0 && pCur->num_results > 0) {
-    sqlite3_str *ms = sqlite3_str_new(pVtab->db);
-    sqlite3_str_appendall(ms, "SELECT ");
-    for (int mi = 0; mi < pVtab->n_meta_cols; mi++) {
-      if (mi > 0)
-        sqlite3_str_appendall(ms, ", ");
-      sqlite3_str_appendf(ms, "\"%w\"", pVtab->meta_cols[mi].name);
-    }
-    sqlite3_str_appendf(ms, " FROM \"%w\".\"%w_attrs\" WHERE rowid = ?",
-                        pVtab->db_name, pVtab->table_name);
-    char *meta_sql = sqlite3_str_finish(ms);
-    if (!meta_sql)
-      return SQLITE_NOMEM;
-
-    int mrc =
-        sqlite3_prepare_v2(pVtab->db, meta_sql, -1, &pCur->meta_stmt, NULL);
-    sqlite3_free(meta_sql);
-    if (mrc != SQLITE_OK) {
-      /* Metadata query failed - return error instead of silently returning
-       * NULLs */
-      const char *err = sqlite3_errmsg(pVtab->db);
-      pVtab->base.zErrMsg = sqlite3_mprintf(
-          "Failed to prepare metadata query for table %s: %s (code %d)",
-          pVtab->table_name, err, mrc);
-      pCur->meta_stmt = NULL;
-      return mrc;
-    }
+fetch_meta:
+  /* A stream fetches metadata as it pulls rows; fill the rest up front */
+  if (pCur->meta_used && !pCur->stream) {
+    return cursor_fetch_meta(pVtab, pCur);
   }
   return SQLITE_OK;
 }
@@ -1121,6 +2399,9 @@ prepare_meta_stmt:
 */
 static int diskannNext(sqlite3_vtab_cursor *pCursor) {
   diskann_cursor *pCur = (diskann_cursor *)pCursor;
+  if (pCur->stream) {
+    return cursor_stream_step(pCur);
+  }
   pCur->current++;
   return SQLITE_OK;
 }
@@ -1129,8 +2410,7 @@ static int diskannNext(sqlite3_vtab_cursor *pCursor) {
 ** xEof — check if cursor is at end.
 */
 static int diskannEof(sqlite3_vtab_cursor *pCursor) {
-  diskann_cursor *pCur = (diskann_cursor *)pCursor;
-  return pCur->current >= pCur->num_results;
+  return cursor_eof((diskann_cursor *)pCursor);
 }
 
 /*
@@ -1143,7 +2423,7 @@ static int diskannColumn(sqlite3_vtab_cursor *pCursor, sqlite3_context *ctx,
                          int i) {
   diskann_cursor *pCur = (diskann_cursor *)pCursor;
 
-  if (pCur->current >= pCur->num_results)
+  if (cursor_eof(pCur))
     return SQLITE_ERROR;
 
   switch (i) {
@@ -1151,36 +2431,52 @@ static int diskannColumn(sqlite3_vtab_cursor *pCursor, sqlite3_context *ctx,
     sqlite3_result_null(ctx);
     break;
   case DISKANN_COL_DISTANCE:
-    sqlite3_result_double(ctx, (double)pCur->results[pCur->current].distance);
+    sqlite3_result_double(ctx, (double)cursor_row(pCur)->distance);
     break;
   case DISKANN_COL_K:
   case DISKANN_COL_SEARCH_LIST_SIZE:
-    /* Both K and SEARCH_LIST_SIZE are write-only (used in xFilter) */
+  case DISKANN_COL_EXACT:
+  case DISKANN_COL_RECALL_TARGET:
+    /* K, SEARCH_LIST_SIZE, EXACT and RECALL_TARGET are write-only (used in
+    ** xFilter) */
     sqlite3_result_null(ctx);
     break;
+  case DISKANN_COL_QUERY_INDEX:
+    sqlite3_result_int(
+        ctx, pCur->query_index ? pCur->query_index[pCur->current] : 0);
+    break;
   default: {
     /* Metadata column: col >= DISKANN_COL_META_START */
     int meta_idx = i - DISKANN_COL_META_START;
     diskann_vtab *pVtab = (diskann_vtab *)pCursor->pVtab;
-    if (meta_idx < 0 || meta_idx >= pVtab->n_meta_cols || !pCur->meta_stmt) {
+    if (meta_idx < 0 || meta_idx >= pVtab->n_meta_cols ||
+        pCur->current >= pCur->n_meta_rows) {
       sqlite3_result_null(ctx);
       break;
     }
 
-    /* Lazy fetch: only query _attrs when rowid changes */
-    int64_t current_rowid = pCur->results[pCur->current].id;
-    if (pCur->meta_cached_rowid != current_rowid) {
-      sqlite3_reset(pCur->meta_stmt);
-      sqlite3_bind_int64(pCur->meta_stmt, 1, current_rowid);
-      pCur->meta_has_row = (sqlite3_step(pCur->meta_stmt) == SQLITE_ROW);
-      pCur->meta_cached_rowid = current_rowid;
-    }
-
-    if (pCur->meta_has_row) {
-      sqlite3_result_value(ctx,
-                           sqlite3_column_value(pCur->meta_stmt, meta_idx));
-    } else {
+    /* Fetched with the rest of the rows (cursor_fetch_meta()) */
+    const DiskAnnMetaValue *v =
+        &pCur->meta[(size_t)pCur->current * (size_t)pVtab->n_meta_cols +
+                    (size_t)meta_idx];
+    switch (v->type) {
+    case SQLITE_INTEGER:
+      sqlite3_result_int64(ctx, v->v.i);
+      break;
+    case SQLITE_FLOAT:
+      sqlite3_result_double(ctx, v->v.r);
+      break;
+    case SQLITE_TEXT:
+      sqlite3_result_text(ctx, (const char *)pCur->meta_bytes + v->v.off,
+                          v->n, SQLITE_TRANSIENT);
+      break;
+    case SQLITE_BLOB:
+      sqlite3_result_blob(ctx, pCur->meta_bytes + v->v.off, v->n,
+                          SQLITE_TRANSIENT);
+      break;
+    default:
       sqlite3_result_null(ctx);
+      break;
     }
     break;
   }
@@ -1195,10 +2491,130 @@ static int diskannColumn(sqlite3_vtab_cursor *pCursor, sqlite3_context *ctx,
 static int diskannRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid) {
   diskann_cursor *pCur = (diskann_cursor *)pCursor;
 
-  if (pCur->current >= pCur->num_results)
+  if (cursor_eof(pCur))
+    return SQLITE_ERROR;
+
+  *pRowid = cursor_row(pCur)->id;
+  return SQLITE_OK;
+}
+
+/* Index handles of the table: its shards, or idx alone */
+static int vtab_n_indexes(const diskann_vtab *p) {
+  return p->shards ? diskann_shard_count(p->shards) : 1;
+}
+
+static DiskAnnIndex *vtab_index(diskann_vtab *p, int i) {
+  return p->shards ? diskann_shard_index(p->shards, i) : p->idx;
+}
+
+/* diskann_begin_batch() flags of a write transaction. Savepoints mark
+** one handle's delete queue, so shards delete immediately. */
+static int vtab_batch_flags(const diskann_vtab *p) {
+  return p->shards ? 0 : DISKANN_BATCH_DEFERRED_DELETES;
+}
+
+/*
+** Handle of the index row rowid belongs in, into *out: idx, or the shard
+** that the row's partition key (key, or when NULL the one stored in
+** _attrs) or else its rowid routes to. *out is NULL when a partitioned
+** row has no stored key (no such row).
+*/
+static int vtab_route(diskann_vtab *p, int64_t rowid, sqlite3_value *key,
+                      DiskAnnIndex **out) {
+  *out = p->idx;
+  if (!p->shards) {
+    return SQLITE_OK;
+  }
+  int64_t route = rowid;
+  if (p->partition_col >= 0) {
+    const DiskAnnMetaCol *col = &p->meta_cols[p->partition_col];
+    int affinity = label_affinity(col->type);
+    if (key) {
+      route = diskann_label_hash(key, affinity);
+    } else {
+      if (!p->partition_stmt) {
+        char *sql = sqlite3_mprintf(
+            "SELECT \"%w\" FROM \"%w\".\"%w_attrs\" WHERE rowid = ?",
+            col->name, p->db_name, p->table_name);
+        if (!sql) {
+          return SQLITE_NOMEM;
+        }
+        int rc = sqlite3_prepare_v3(p->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                                    &p->partition_stmt, NULL);
+        sqlite3_free(sql);
+        if (rc != SQLITE_OK) {
+          return rc;
+        }
+      }
+      sqlite3_bind_int64(p->partition_stmt, 1, rowid);
+      int rc = sqlite3_step(p->partition_stmt);
+      if (rc == SQLITE_ROW) {
+        route = diskann_label_hash(sqlite3_column_value(p->partition_stmt, 0),
+                                   affinity);
+      }
+      sqlite3_reset(p->partition_stmt);
+      if (rc == SQLITE_DONE) {
+        *out = NULL;
+        return SQLITE_OK;
+      }
+      if (rc != SQLITE_ROW) {
+        return rc;
+      }
+    }
+  }
+  int shard = 0;
+  if (diskann_shard_for(p->shards, route, &shard) != DISKANN_OK) {
     return SQLITE_ERROR;
+  }
+  *out = diskann_shard_index(p->shards, shard);
+  return SQLITE_OK;
+}
 
-  *pRowid = pCur->results[pCur->current].id;
+/*
+** INSERT INTO t(t) VALUES ('<command>'). Commands:
+**   optimize  - diskann_optimize(): rewrite the graph in locality order
+**   calibrate - diskann_calibrate() with its defaults: measure the recall
+**               curve searches size their beam from
+** Both must see every change on disk, so the transaction's batch (xBegin)
+** is closed around them. Queued deletes are refused rather than applied:
+** a later ROLLBACK TO could undo them but not requeue them.
+*/
+static int vtab_command(diskann_vtab *p, sqlite3_value *value) {
+  const char *cmd = (const char *)sqlite3_value_text(value);
+  int optimize = cmd && sqlite3_stricmp(cmd, "optimize") == 0;
+  if (!optimize && !(cmd && sqlite3_stricmp(cmd, "calibrate") == 0)) {
+    p->base.zErrMsg =
+        sqlite3_mprintf("diskann: unknown command '%s'", cmd ? cmd : "");
+    return SQLITE_ERROR;
+  }
+  const char *name = optimize ? "optimize" : "calibrate";
+  if (diskann_deferred_delete_count(p->idx) > 0) {
+    p->base.zErrMsg = sqlite3_mprintf(
+        "diskann: '%s' cannot follow a DELETE in the same transaction", name);
+    return SQLITE_ERROR;
+  }
+
+  /* A sharded table runs the command on each shard */
+  int rc = DISKANN_OK;
+  for (int i = 0; i < vtab_n_indexes(p) && rc >= 0; i++) {
+    DiskAnnIndex *idx = vtab_index(p, i);
+    int in_batch = idx->batch_cache != NULL;
+    rc = in_batch ? diskann_end_batch(idx) : DISKANN_OK;
+    if (rc == DISKANN_OK) {
+      rc = optimize ? diskann_optimize(idx) : diskann_calibrate(idx, NULL);
+    }
+    if (in_batch) {
+      int batch_rc = diskann_begin_batch(idx, vtab_batch_flags(p));
+      if (rc >= 0) {
+        rc = batch_rc;
+      }
+    }
+  }
+  if (rc < 0) {
+    p->base.zErrMsg =
+        sqlite3_mprintf("diskann: %s failed (rc=%d)", name, rc);
+    return rc == DISKANN_ERROR_NOMEM ? SQLITE_NOMEM : SQLITE_ERROR;
+  }
   return SQLITE_OK;
 }
 
@@ -1207,8 +2623,11 @@ static int diskannRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid) {
 **
 ** INSERT: argv[0]=NULL, argv[1]=rowid, argv[2]=vector, argv[3]=distance(NULL),
 **         argv[4]=k(NULL), argv[5]=search_list_size(NULL),
-*argv[6+i]=metadata[i].
-**         argc = 2 + 4 + n_meta_cols.
+**         argv[6]=query_index(NULL), argv[7]=exact(NULL),
+**         argv[8]=recall_target(NULL), argv[9+i]=metadata[i], then the
+**         command column (if declared). argc = 2 + 7 + n_meta_cols (+ 1).
+**         A non-NULL command column makes the INSERT a command instead
+**         (see vtab_command()).
 ** DELETE: argv[0]=rowid. argc = 1.
 */
 static int diskannUpdate(sqlite3_vtab *pVtab, int argc, sqlite3_value **argv,
@@ -1218,33 +2637,44 @@ static int diskannUpdate(sqlite3_vtab *pVtab, int argc, sqlite3_value **argv,
   if (argc == 1) {
     /* DELETE */
     sqlite_int64 rowid = sqlite3_value_int64(argv[0]);
-    int rc = diskann_delete(p->idx, rowid);
+    DiskAnnIndex *idx = NULL;
+    int rc = vtab_route(p, rowid, NULL, &idx); /* before _attrs goes */
+    if (rc != SQLITE_OK) {
+      return rc;
+    }
+    rc = idx ? diskann_delete(idx, rowid) : DISKANN_ERROR_NOTFOUND;
     /* NOTFOUND is not an error for DELETE — row may already be gone */
     if (rc != DISKANN_OK && rc != DISKANN_ERROR_NOTFOUND) {
       pVtab->zErrMsg = sqlite3_mprintf("diskann: delete failed (rc=%d)", rc);
       return SQLITE_ERROR;
     }
 
-    /* Delete metadata row from _attrs (if metadata columns exist) */
-    if (p->n_meta_cols > 0) {
+    /* Delete metadata row from _attrs (if metadata columns exist), with
+    ** one statement prepared per connection rather than per row */
+    if (p->n_meta_cols > 0 && !p->attrs_delete_stmt) {
       char *sql =
           sqlite3_mprintf("DELETE FROM \"%w\".\"%w_attrs\" WHERE rowid = ?",
                           p->db_name, p->table_name);
       if (sql) {
-        sqlite3_stmt *del_stmt;
-        if (sqlite3_prepare_v2(p->db, sql, -1, &del_stmt, NULL) == SQLITE_OK) {
-          sqlite3_bind_int64(del_stmt, 1, rowid);
-          sqlite3_step(del_stmt);
-          sqlite3_finalize(del_stmt);
-        }
+        sqlite3_prepare_v3(p->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                           &p->attrs_delete_stmt, NULL);
         sqlite3_free(sql);
       }
     }
+    if (p->attrs_delete_stmt) {
+      sqlite3_bind_int64(p->attrs_delete_stmt, 1, rowid);
+      sqlite3_step(p->attrs_delete_stmt);
+      sqlite3_reset(p->attrs_delete_stmt);
+    }
     return SQLITE_OK;
   }
 
   if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
     /* INSERT */
+    if (p->command_col >= 0 &&
+        sqlite3_value_type(argv[2 + p->command_col]) != SQLITE_NULL) {
+      return vtab_command(p, argv[2 + p->command_col]);
+    }
     if (sqlite3_value_type(argv[1]) == SQLITE_NULL) {
       pVtab->zErrMsg = sqlite3_mprintf("diskann: rowid required for INSERT");
       return SQLITE_ERROR;
@@ -1257,22 +2687,58 @@ static int diskannUpdate(sqlite3_vtab *pVtab, int argc, sqlite3_value **argv,
       return SQLITE_ERROR;
     }
 
-    const float *vec = (const float *)sqlite3_value_blob(argv[2]);
-    int bytes = sqlite3_value_bytes(argv[2]);
-    uint32_t dims = (uint32_t)((size_t)bytes / sizeof(float));
+    const float *vec = NULL;
+    float *vec_owned = NULL;
+    uint32_t dims = 0;
+    if (vector_blob_floats(p, argv[2], &vec, &dims, &vec_owned) !=
+        SQLITE_OK) {
+      return SQLITE_NOMEM;
+    }
 
     if (dims != p->dimensions) {
+      sqlite3_free(vec_owned);
       pVtab->zErrMsg =
           sqlite3_mprintf("diskann: dimension mismatch (got %u, expected %u)",
                           dims, p->dimensions);
       return SQLITE_ERROR;
     }
 
-    /* argv[3]=distance(NULL), argv[4]=k(NULL), argv[5]=search_list_size(NULL) —
-     *skip
-     ** argv[6+i] = metadata column i */
-    int rc = diskann_insert(p->idx, rowid, vec, dims);
+    /* argv[3]=distance(NULL), argv[4]=k(NULL), argv[5]=search_list_size(NULL),
+     ** argv[6]=query_index(NULL), argv[7]=exact(NULL),
+     ** argv[8]=recall_target(NULL) — skip
+     ** argv[9+i] = metadata column i */
+    DiskAnnIndex *idx = NULL;
+    int rc = vtab_route(
+        p, rowid,
+        p->partition_col >= 0
+            ? argv[2 + DISKANN_COL_META_START + p->partition_col]
+            : NULL,
+        &idx);
+    if (rc != SQLITE_OK) {
+      sqlite3_free(vec_owned);
+      return rc;
+    }
+    uint32_t old_label = DISKANN_LABEL_NONE;
+    if (p->label_col >= 0) {
+      /* Label first: the insert links the node along its label */
+      old_label = diskann_labels_get(p->idx->labels, rowid);
+      uint32_t label = diskann_label_hash(
+          argv[2 + DISKANN_COL_META_START + p->label_col],
+          p->idx->labels->affinity);
+      rc = diskann_labels_put(p->idx->labels, rowid, label);
+      if (rc != DISKANN_OK) {
+        sqlite3_free(vec_owned);
+        return SQLITE_NOMEM;
+      }
+    }
+    rc = diskann_insert(idx, rowid, vec, dims);
+    sqlite3_free(vec_owned);
     if (rc != DISKANN_OK) {
+      if (p->label_col >= 0) {
+        /* Restore the label of a row that already existed */
+        diskann_labels_remove(p->idx->labels, rowid);
+        (void)diskann_labels_put(p->idx->labels, rowid, old_label);
+      }
       pVtab->zErrMsg = sqlite3_mprintf("diskann: insert failed (rc=%d)", rc);
       return SQLITE_ERROR;
     }
@@ -1306,9 +2772,10 @@ static int diskannUpdate(sqlite3_vtab *pVtab, int argc, sqlite3_value **argv,
 
       sqlite3_bind_int64(ins_stmt, 1, rowid);
       for (int mi = 0; mi < p->n_meta_cols; mi++) {
-        /* argv[6+mi] = metadata column mi (after rowid, vector, distance, k,
-         * search_list_size) */
-        sqlite3_bind_value(ins_stmt, 2 + mi, argv[6 + mi]);
+        /* argv[2+DISKANN_COL_META_START+mi] = metadata column mi (after
+         * rowid, vector, distance, k, search_list_size, query_index) */
+        sqlite3_bind_value(ins_stmt, 2 + mi,
+                           argv[2 + DISKANN_COL_META_START + mi]);
       }
 
       rc = sqlite3_step(ins_stmt);
@@ -1321,8 +2788,8 @@ static int diskannUpdate(sqlite3_vtab *pVtab, int argc, sqlite3_value **argv,
 
     /* Release cached blob handles so they don't block COMMIT.
     ** Buffer data is preserved; handles reopen lazily on next access. */
-    if (p->idx->batch_cache) {
-      blob_cache_release_handles(p->idx->batch_cache);
+    if (idx->batch_cache) {
+      blob_cache_release_handles(idx->batch_cache);
     }
 
     *pRowid = rowid;
@@ -1341,7 +2808,10 @@ static int diskannShadowName(const char *zName) {
   return sqlite3_stricmp(zName, "shadow") == 0 ||
          sqlite3_stricmp(zName, "metadata") == 0 ||
          sqlite3_stricmp(zName, "attrs") == 0 ||
-         sqlite3_stricmp(zName, "columns") == 0;
+         sqlite3_stricmp(zName, "columns") == 0 ||
+         sqlite3_stricmp(zName, "shards") == 0 ||
+         sqlite3_stricmp(zName, "pq") == 0 ||
+         sqlite3_stricmp(zName, "pq_codebook") == 0;
 }
 
 /*
@@ -1355,30 +2825,41 @@ static int diskannShadowName(const char *zName) {
 */
 static int diskannBegin(sqlite3_vtab *pVtab) {
   diskann_vtab *p = (diskann_vtab *)pVtab;
-  /* Cache-only batch mode (no deferred edges) — lazy edges degrade recall
-  ** at small scale and the vtab path has no way to control batch size. */
-  int rc = diskann_begin_batch(p->idx, 0);
-  if (rc != DISKANN_OK) {
-    pVtab->zErrMsg = sqlite3_mprintf("diskann: begin_batch failed (rc=%d)", rc);
-    return SQLITE_ERROR;
+  /* No deferred edges — lazy edges degrade recall at small scale and the
+  ** vtab path has no way to control batch size. Deletes are queued so a
+  ** multi-row DELETE repairs each neighbor block once, at xSync. */
+  p->n_savepoint_marks = 0;
+  for (int i = 0; i < vtab_n_indexes(p); i++) {
+    int rc = diskann_begin_batch(vtab_index(p, i), vtab_batch_flags(p));
+    if (rc != DISKANN_OK) {
+      while (i-- > 0) {
+        diskann_abort_batch(vtab_index(p, i));
+      }
+      pVtab->zErrMsg =
+          sqlite3_mprintf("diskann: begin_batch failed (rc=%d)", rc);
+      return SQLITE_ERROR;
+    }
   }
   return SQLITE_OK;
 }
 
 /*
-** xSync — free batch cache and apply any deferred edges.
-** Called before xCommit. With lazy edges disabled (vtab path), this just
-** frees the persistent BlobCache.
+** xSync — apply queued deletes (and any deferred edges) and free the batch
+** cache. Called before xCommit.
 */
 static int diskannSync(sqlite3_vtab *pVtab) {
   diskann_vtab *p = (diskann_vtab *)pVtab;
-  if (!p->idx->batch_cache) {
-    return SQLITE_OK; /* Not in batch mode (shouldn't happen) */
-  }
-  int rc = diskann_end_batch(p->idx);
-  if (rc != DISKANN_OK) {
-    pVtab->zErrMsg = sqlite3_mprintf("diskann: batch sync failed (rc=%d)", rc);
-    return SQLITE_ERROR;
+  for (int i = 0; i < vtab_n_indexes(p); i++) {
+    DiskAnnIndex *idx = vtab_index(p, i);
+    if (!idx->batch_cache) {
+      continue; /* Not in batch mode (shouldn't happen) */
+    }
+    int rc = diskann_end_batch(idx);
+    if (rc != DISKANN_OK) {
+      pVtab->zErrMsg =
+          sqlite3_mprintf("diskann: batch sync failed (rc=%d)", rc);
+      return SQLITE_ERROR;
+    }
   }
   return SQLITE_OK;
 }
@@ -1392,18 +2873,84 @@ static int diskannCommit(sqlite3_vtab *pVtab) {
 }
 
 /*
-** xRollback — discard deferred edges without applying.
+** xRollback — discard deferred edges without applying, and rebuild the
+** label map (if any).
 ** Shadow table changes are being rolled back by SQLite, so deferred
 ** edges referencing those rows must NOT be applied.
 */
 static int diskannRollback(sqlite3_vtab *pVtab) {
   diskann_vtab *p = (diskann_vtab *)pVtab;
-  if (p->idx->batch_cache) {
-    diskann_abort_batch(p->idx);
+  for (int i = 0; i < vtab_n_indexes(p); i++) {
+    DiskAnnIndex *idx = vtab_index(p, i);
+    if (idx->batch_cache) {
+      diskann_abort_batch(idx);
+    }
+    /* The label map saw the rolled-back inserts and deletes */
+    (void)diskann_labels_reload(idx);
   }
   return SQLITE_OK;
 }
 
+/*
+** xSavepoint — remember how many deletes were queued at this level.
+*/
+static int diskannSavepoint(sqlite3_vtab *pVtab, int iSavepoint) {
+  diskann_vtab *p = (diskann_vtab *)pVtab;
+  if (iSavepoint < 0) {
+    return SQLITE_OK;
+  }
+  if (iSavepoint >= p->n_savepoint_marks) {
+    int *marks = (int *)sqlite3_realloc64(
+        p->savepoint_marks, (uint64_t)(iSavepoint + 1) * sizeof(int));
+    if (!marks) {
+      return SQLITE_NOMEM;
+    }
+    /* Levels skipped over (nested savepoints opened before this vtab
+    ** joined the transaction) had nothing queued yet */
+    for (int i = p->n_savepoint_marks; i < iSavepoint; i++) {
+      marks[i] = 0;
+    }
+    p->savepoint_marks = marks;
+  }
+  p->savepoint_marks[iSavepoint] = diskann_deferred_delete_count(p->idx);
+  p->n_savepoint_marks = iSavepoint + 1;
+  return SQLITE_OK;
+}
+
+/*
+** xRelease — the savepoint's queued deletes now belong to the enclosing
+** level.
+*/
+static int diskannRelease(sqlite3_vtab *pVtab, int iSavepoint) {
+  diskann_vtab *p = (diskann_vtab *)pVtab;
+  if (iSavepoint >= 0 && iSavepoint < p->n_savepoint_marks) {
+    p->n_savepoint_marks = iSavepoint;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** xRollbackTo — drop the deletes queued since the savepoint. Shadow rows
+** written since then are rolled back too, so cached blocks and labels
+** are refreshed.
+*/
+static int diskannRollbackTo(sqlite3_vtab *pVtab, int iSavepoint) {
+  diskann_vtab *p = (diskann_vtab *)pVtab;
+  if (iSavepoint < 0 || iSavepoint >= p->n_savepoint_marks) {
+    return SQLITE_OK;
+  }
+  int rc = diskann_deferred_delete_truncate(p->idx,
+                                            p->savepoint_marks[iSavepoint]);
+  p->n_savepoint_marks = iSavepoint + 1;
+  for (int i = 0; i < vtab_n_indexes(p); i++) {
+    DiskAnnIndex *idx = vtab_index(p, i);
+    blob_cache_clear(idx->read_cache);
+    blob_cache_clear(idx->batch_cache);
+    (void)diskann_labels_reload(idx);
+  }
+  return rc == DISKANN_OK ? SQLITE_OK : SQLITE_NOMEM;
+}
+
 /*
 ** Virtual table module definition (iVersion=3 for xShadowName)
 */
@@ -1423,14 +2970,14 @@ static sqlite3_module diskannModule = {
     diskannRowid,      /* xRowid */
     diskannUpdate,     /* xUpdate */
     diskannBegin,      /* xBegin — activate batch mode */
-    diskannSync,       /* xSync — apply deferred edges */
+    diskannSync,       /* xSync — apply deferred edges and deletes */
     diskannCommit,     /* xCommit — no-op (cleaned up by xSync) */
     diskannRollback,   /* xRollback — discard deferred edges */
     NULL,              /* xFindFunction */
     NULL,              /* xRename */
-    NULL,              /* xSavepoint */
-    NULL,              /* xRelease */
-    NULL,              /* xRollbackTo */
+    diskannSavepoint,  /* xSavepoint — mark queued deletes */
+    diskannRelease,    /* xRelease */
+    diskannRollbackTo, /* xRollbackTo — drop deletes queued since mark */
     diskannShadowName, /* xShadowName */
     NULL,              /* xIntegrity */
 };
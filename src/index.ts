@@ -15,6 +15,9 @@ import type {
   DiskAnnIndexOptions,
   NearestNeighborResult,
   SearchOptions,
+  Searcher,
+  VectorRow,
+  VectorType,
 } from "./types.js";
 
 /**
@@ -43,6 +46,79 @@ function isValidIdentifier(name: string): boolean {
   return /^[a-z_]\w*$/i.test(name);
 }
 
+/**
+ * Validate a vector and return it in a form bindable as a BLOB. Typed arrays
+ * are bound as they are; only number[] is copied.
+ *
+ * @param vector - Vector to validate
+ * @param what - Name used in the error message
+ */
+function toVectorParam(
+  vector: Float32Array | Uint16Array | number[],
+  what: string
+): Float32Array | Uint16Array {
+  if (
+    !vector ||
+    (!(vector instanceof Float32Array) &&
+      !(vector instanceof Uint16Array) &&
+      !Array.isArray(vector)) ||
+    vector.length === 0
+  ) {
+    throw new Error(`${what} must be non-empty array or Float32Array`);
+  }
+  // Uint16Array holds encoded halves
+  return vector instanceof Float32Array || vector instanceof Uint16Array
+    ? vector
+    : new Float32Array(vector);
+}
+
+/**
+ * Build the k-NN query for tableName (already validated). The query vector is
+ * the first parameter, followed by the returned params.
+ */
+function buildSearchQuery(
+  tableName: string,
+  k: number,
+  options?: SearchOptions
+): { sql: string; params: unknown[] } {
+  if (!Number.isInteger(k) || k <= 0) {
+    throw new Error(`Invalid k: ${k} (must be positive integer)`);
+  }
+
+  // Build SQL with optional search_list_size constraint
+  let sql = `
+    SELECT rowid, distance
+    FROM ${tableName}
+    WHERE vector MATCH ? AND k = ?`;
+
+  const params: unknown[] = [k];
+
+  // Add search_list_size constraint if specified
+  if (options?.searchListSize !== undefined) {
+    if (!Number.isInteger(options.searchListSize) || options.searchListSize <= 0) {
+      throw new Error(
+        `Invalid searchListSize: ${options.searchListSize} (must be positive integer)`
+      );
+    }
+    sql += ` AND search_list_size = ?`;
+    params.push(options.searchListSize);
+  }
+  if (options?.exact !== undefined) {
+    sql += ` AND exact = ?`;
+    params.push(options.exact ? 1 : 0);
+  }
+  if (options?.recallTarget !== undefined) {
+    if (!(options.recallTarget > 0 && options.recallTarget <= 1)) {
+      throw new Error(
+        `Invalid recallTarget: ${options.recallTarget} (must be in (0, 1])`
+      );
+    }
+    sql += ` AND recall_target = ?`;
+    params.push(options.recallTarget);
+  }
+  return { sql, params };
+}
+
 // Re-export types for convenience
 export type {
   DatabaseLike,
@@ -51,9 +127,11 @@ export type {
   MetadataColumn,
   MetadataColumnType,
   NearestNeighborResult,
-  // SearchOptions currently unused but exported for future API enhancements
   SearchOptions,
+  Searcher,
   StatementLike,
+  VectorRow,
+  VectorType,
 } from "./types.js";
 
 /**
@@ -166,6 +244,13 @@ export function createDiskAnnIndex(
     maxDegree = 32,
     buildSearchListSize = 100,
     normalizeVectors = false,
+    edgeType,
+    vectorType,
+    quantMin,
+    quantMax,
+    deleteMode,
+    consolidateThreshold,
+    shards,
     metadataColumns = [],
   } = options;
 
@@ -186,10 +271,63 @@ export function createDiskAnnIndex(
   if (!Number.isInteger(maxDegree) || maxDegree <= 0) {
     throw new Error(`Invalid maxDegree: ${maxDegree} (must be positive integer)`);
   }
+  if (edgeType !== undefined && !["float32", "int8"].includes(edgeType)) {
+    throw new Error(`Invalid edgeType: ${edgeType} (must be float32 or int8)`);
+  }
+  if (vectorType !== undefined && !["float32", "float16", "bfloat16"].includes(vectorType)) {
+    throw new Error(`Invalid vectorType: ${vectorType} (must be float32, float16, or bfloat16)`);
+  }
+  if (deleteMode !== undefined && !["immediate", "tombstone"].includes(deleteMode)) {
+    throw new Error(`Invalid deleteMode: ${deleteMode} (must be immediate or tombstone)`);
+  }
+  if (
+    consolidateThreshold !== undefined &&
+    (!Number.isInteger(consolidateThreshold) || consolidateThreshold < 0)
+  ) {
+    throw new Error(
+      `Invalid consolidateThreshold: ${consolidateThreshold} (must be non-negative integer)`
+    );
+  }
+  if (shards !== undefined) {
+    if (shards.length === 0) {
+      throw new Error("Invalid shards: must list at least one schema");
+    }
+    const seenShards = new Set<string>();
+    for (const shard of shards) {
+      if (!isValidIdentifier(shard)) {
+        throw new Error(
+          `Invalid shard schema name: ${shard} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+        );
+      }
+      if (seenShards.has(shard.toLowerCase())) {
+        throw new Error(`Duplicate shard schema name: ${shard}`);
+      }
+      seenShards.add(shard.toLowerCase());
+    }
+  }
+  for (const [name, value] of [
+    ["quantMin", quantMin],
+    ["quantMax", quantMax],
+  ] as const) {
+    if (value !== undefined && !Number.isFinite(value)) {
+      throw new Error(`Invalid ${name}: ${value} (must be a finite number)`);
+    }
+  }
 
   // Validate metadata columns
-  const reservedNames = ["vector", "distance", "k", "rowid"];
+  const reservedNames = [
+    "vector",
+    "distance",
+    "k",
+    "search_list_size",
+    "query_index",
+    "exact",
+    "recall_target",
+    "rowid",
+  ];
   const seenNames = new Set<string>();
+  let labelColumn: string | undefined;
+  let partitionColumn: string | undefined;
   for (const col of metadataColumns) {
     if (!isValidIdentifier(col.name)) {
       throw new Error(
@@ -198,12 +336,33 @@ export function createDiskAnnIndex(
     }
     if (reservedNames.includes(col.name.toLowerCase())) {
       throw new Error(
-        `Reserved column name: ${col.name} (cannot use vector, distance, k, or rowid)`
+        `Reserved column name: ${col.name} (cannot use vector, distance, k, search_list_size, query_index, exact, recall_target, or rowid)`
       );
     }
     if (seenNames.has(col.name.toLowerCase())) {
       throw new Error(`Duplicate metadata column name: ${col.name}`);
     }
+    if (col.label && labelColumn !== undefined) {
+      throw new Error(
+        `Only one LABEL metadata column allowed (${labelColumn} and ${col.name})`
+      );
+    }
+    if (col.label) {
+      labelColumn = col.name;
+    }
+    if (col.partition && partitionColumn !== undefined) {
+      throw new Error(
+        `Only one PARTITION metadata column allowed (${partitionColumn} and ${col.name})`
+      );
+    }
+    if (col.partition && col.label) {
+      throw new Error(
+        `Metadata column ${col.name} cannot be both LABEL and PARTITION`
+      );
+    }
+    if (col.partition) {
+      partitionColumn = col.name;
+    }
     seenNames.add(col.name.toLowerCase());
 
     if (!["TEXT", "INTEGER", "REAL", "BLOB"].includes(col.type)) {
@@ -222,10 +381,32 @@ export function createDiskAnnIndex(
     `build_search_list_size=${buildSearchListSize}`,
     `normalize_vectors=${normalizeVectors ? 1 : 0}`,
   ];
+  if (edgeType !== undefined) {
+    params.push(`edge_type=${edgeType}`);
+  }
+  if (vectorType !== undefined) {
+    params.push(`vector_type=${vectorType}`);
+  }
+  if (quantMin !== undefined) {
+    params.push(`quant_min=${quantMin}`);
+  }
+  if (quantMax !== undefined) {
+    params.push(`quant_max=${quantMax}`);
+  }
+  if (deleteMode !== undefined) {
+    params.push(`delete_mode=${deleteMode}`);
+  }
+  if (consolidateThreshold !== undefined) {
+    params.push(`consolidate_threshold=${consolidateThreshold}`);
+  }
+  if (shards !== undefined) {
+    params.push(`shards=${shards.join(":")}`);
+  }
 
   // Add metadata column definitions
   for (const col of metadataColumns) {
-    params.push(`${col.name} ${col.type}`);
+    const flag = col.label ? " LABEL" : col.partition ? " PARTITION" : "";
+    params.push(`${col.name} ${col.type}${flag}`);
   }
 
   const sql = `CREATE VIRTUAL TABLE ${tableName} USING diskann(${params.join(", ")})`;
@@ -238,7 +419,8 @@ export function createDiskAnnIndex(
  *
  * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
  * @param tableName - Name of the DiskANN virtual table
- * @param queryVector - Query vector as Float32Array or number[] (must match index dimension)
+ * @param queryVector - Query vector as Float32Array or number[] (must match index dimension),
+ *   or a Uint16Array from {@link encodeHalfVector} for float16/bfloat16 indexes
  * @param k - Number of neighbors to return (default: 10)
  * @returns Array of k nearest neighbors sorted by distance, including any metadata columns
  *
@@ -263,7 +445,7 @@ export function createDiskAnnIndex(
 export function searchNearest(
   db: DatabaseLike,
   tableName: string,
-  queryVector: Float32Array | number[],
+  queryVector: Float32Array | Uint16Array | number[],
   k = 10,
   options?: SearchOptions
 ): NearestNeighborResult[] {
@@ -274,41 +456,57 @@ export function searchNearest(
     );
   }
 
-  // Validate inputs
-  if (!queryVector || queryVector.length === 0) {
-    throw new Error("Query vector must be non-empty array or Float32Array");
-  }
-  if (!Number.isInteger(k) || k <= 0) {
-    throw new Error(`Invalid k: ${k} (must be positive integer)`);
-  }
-
-  // Convert to Float32Array if needed
-  const vecArray =
-    queryVector instanceof Float32Array ? queryVector : new Float32Array(queryVector);
-
-  // Build SQL with optional search_list_size constraint
-  let sql = `
-    SELECT rowid, distance
-    FROM ${tableName}
-    WHERE vector MATCH ? AND k = ?`;
+  const vecArray = toVectorParam(queryVector, "Query vector");
+  const { sql, params } = buildSearchQuery(tableName, k, options);
 
-  const params: unknown[] = [vecArray, k];
+  // Execute search
+  const stmt = db.prepare(sql);
+  const results = stmt.all(vecArray, ...params) as NearestNeighborResult[];
+  return results;
+}
 
-  // Add search_list_size constraint if specified
-  if (options?.searchListSize !== undefined) {
-    if (!Number.isInteger(options.searchListSize) || options.searchListSize <= 0) {
-      throw new Error(
-        `Invalid searchListSize: ${options.searchListSize} (must be positive integer)`
-      );
-    }
-    sql += ` AND search_list_size = ?`;
-    params.push(options.searchListSize);
+/**
+ * Prepare a k-NN search once and run it for many query vectors
+ *
+ * {@link searchNearest} builds and prepares its SQL on every call; a searcher
+ * does that once, so each `search()` only binds the query vector (typed
+ * arrays are bound without conversion) and steps the statement. Keep one per
+ * table and option set for as long as the database stays open.
+ *
+ * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
+ * @param tableName - Name of the DiskANN virtual table
+ * @param options - `k` (default: 10) and the other {@link SearchOptions}, fixed
+ *   for every search
+ * @returns A {@link Searcher} bound to db
+ *
+ * @example
+ * ```ts
+ * const searcher = createSearcher(db, "embeddings", { k: 20, searchListSize: 150 });
+ * for (const query of queries) {
+ *   const results = searcher.search(query);
+ * }
+ * ```
+ */
+export function createSearcher(
+  db: DatabaseLike,
+  tableName: string,
+  options: SearchOptions = {}
+): Searcher {
+  // Validate table name to prevent SQL injection
+  if (!isValidIdentifier(tableName)) {
+    throw new Error(
+      `Invalid table name: ${tableName} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+    );
   }
 
-  // Execute search
+  const { sql, params } = buildSearchQuery(tableName, options.k ?? 10, options);
   const stmt = db.prepare(sql);
-  const results = stmt.all(...params) as NearestNeighborResult[];
-  return results;
+  return {
+    search(queryVector) {
+      const vecArray = toVectorParam(queryVector, "Query vector");
+      return stmt.all(vecArray, ...params) as NearestNeighborResult[];
+    },
+  };
 }
 
 /**
@@ -319,7 +517,8 @@ export function searchNearest(
  * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
  * @param tableName - Name of the DiskANN virtual table
  * @param rowid - Unique row identifier for this vector
- * @param vector - Vector as Float32Array or number[] (must match index dimension)
+ * @param vector - Vector as Float32Array or number[] (must match index dimension),
+ *   or a Uint16Array from {@link encodeHalfVector} for float16/bfloat16 indexes
  *
  * @example
  * ```ts
@@ -336,7 +535,7 @@ export function insertVector(
   db: DatabaseLike,
   tableName: string,
   rowid: number,
-  vector: Float32Array | number[]
+  vector: Float32Array | Uint16Array | number[]
 ): void {
   // Validate table name to prevent SQL injection
   if (!isValidIdentifier(tableName)) {
@@ -345,22 +544,69 @@ export function insertVector(
     );
   }
 
-  if (
-    !vector ||
-    (!(vector instanceof Float32Array) && !Array.isArray(vector)) ||
-    vector.length === 0
-  ) {
-    throw new Error("Vector must be non-empty array or Float32Array");
-  }
-
-  // Convert to Float32Array if needed
-  const vecArray = vector instanceof Float32Array ? vector : new Float32Array(vector);
+  const vecArray = toVectorParam(vector, "Vector");
 
   // tableName is validated above, safe to interpolate
   const stmt = db.prepare(`INSERT INTO ${tableName}(rowid, vector) VALUES (?, ?)`);
   stmt.run(rowid, vecArray);
 }
 
+/**
+ * Insert many vectors into a DiskANN index in one transaction
+ *
+ * Prepares the INSERT once and binds each typed-array vector as it is. All
+ * rows go in under one savepoint (a transaction of its own when none is
+ * open), so the index keeps its batch block cache across the whole load
+ * instead of rebuilding it per row: much faster than one
+ * {@link insertVector} call per row. If any row fails, none are inserted.
+ *
+ * For indexes with metadata columns, use raw SQL inside a transaction.
+ *
+ * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
+ * @param tableName - Name of the DiskANN virtual table
+ * @param rows - Rows to insert; consumed once, so generators work
+ * @returns Number of rows inserted
+ *
+ * @example
+ * ```ts
+ * insertVectors(db, "embeddings", [
+ *   { id: 1, vector: new Float32Array([0.1, 0.2, 0.3]) },
+ *   { id: 2, vector: new Float32Array([0.3, 0.2, 0.1]) },
+ * ]);
+ * ```
+ */
+export function insertVectors(
+  db: DatabaseLike,
+  tableName: string,
+  rows: Iterable<VectorRow>
+): number {
+  // Validate table name to prevent SQL injection
+  if (!isValidIdentifier(tableName)) {
+    throw new Error(
+      `Invalid table name: ${tableName} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+    );
+  }
+
+  // tableName is validated above, safe to interpolate
+  const stmt = db.prepare(`INSERT INTO ${tableName}(rowid, vector) VALUES (?, ?)`);
+  let count = 0;
+  db.exec("SAVEPOINT diskann_insert_vectors");
+  try {
+    for (const { id, vector } of rows) {
+      if (typeof id !== "bigint" && !Number.isSafeInteger(id)) {
+        throw new Error(`Invalid id: ${id} (must be an integer)`);
+      }
+      stmt.run(id, toVectorParam(vector, "Vector"));
+      count++;
+    }
+  } catch (e) {
+    db.exec("ROLLBACK TO diskann_insert_vectors; RELEASE diskann_insert_vectors");
+    throw e;
+  }
+  db.exec("RELEASE diskann_insert_vectors");
+  return count;
+}
+
 /**
  * Delete a vector from a DiskANN index
  *
@@ -385,3 +631,175 @@ export function deleteVector(db: DatabaseLike, tableName: string, rowid: number)
   const stmt = db.prepare(`DELETE FROM ${tableName} WHERE rowid = ?`);
   stmt.run(rowid);
 }
+
+/**
+ * Delete many vectors from a DiskANN index in one statement
+ *
+ * The index removes them together at commit, rewriting each affected
+ * neighbor once, which is much faster than one `deleteVector()` call per row.
+ * Rowids that are not in the index are ignored.
+ *
+ * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
+ * @param tableName - Name of the DiskANN virtual table
+ * @param rowids - Row IDs of vectors to delete
+ *
+ * @example
+ * ```ts
+ * deleteVectors(db, "embeddings", [1, 2, 3]);
+ * ```
+ */
+export function deleteVectors(db: DatabaseLike, tableName: string, rowids: number[]): void {
+  // Validate table name to prevent SQL injection
+  if (!isValidIdentifier(tableName)) {
+    throw new Error(
+      `Invalid table name: ${tableName} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+    );
+  }
+  if (!rowids.every((rowid) => Number.isSafeInteger(rowid))) {
+    throw new Error("Invalid rowids: every rowid must be an integer");
+  }
+  if (rowids.length === 0) {
+    return;
+  }
+
+  // tableName is validated above, safe to interpolate
+  const stmt = db.prepare(
+    `DELETE FROM ${tableName} WHERE rowid IN (SELECT value FROM json_each(?))`
+  );
+  stmt.run(JSON.stringify(rowids));
+}
+
+/**
+ * Rewrite a DiskANN index so graph neighbors are stored near each other
+ *
+ * Removes tombstoned rows, then rewrites the index's rows in graph order so
+ * searches on a cold (not yet cached) database read nearby pages. Run it
+ * after bulk loads and after `VACUUM`, which undoes the ordering.
+ *
+ * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
+ * @param tableName - Name of the DiskANN virtual table
+ *
+ * @example
+ * ```ts
+ * optimizeIndex(db, "embeddings");
+ * ```
+ */
+export function optimizeIndex(db: DatabaseLike, tableName: string): void {
+  // Validate table name to prevent SQL injection
+  if (!isValidIdentifier(tableName)) {
+    throw new Error(
+      `Invalid table name: ${tableName} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+    );
+  }
+
+  // tableName is validated above, safe to interpolate
+  db.prepare(`INSERT INTO ${tableName}(${tableName}) VALUES ('optimize')`).run();
+}
+
+/**
+ * Measure a DiskANN index's recall curve so searches can size their beam
+ *
+ * Samples stored rows as queries, finds their true nearest neighbors with
+ * one exact scan, and measures graph-search recall at growing search list
+ * sizes. Searches then use the smallest size that meets their
+ * `recallTarget` (0.95 by default) instead of `sqrt(index_size)`. Run it
+ * after bulk loads and again after heavy changes.
+ *
+ * @param db - Database instance (supports node:sqlite, better-sqlite3, @photostructure/sqlite)
+ * @param tableName - Name of the DiskANN virtual table
+ *
+ * @example
+ * ```ts
+ * calibrateIndex(db, "embeddings");
+ * searchNearest(db, "embeddings", query, 10, { recallTarget: 0.99 });
+ * ```
+ */
+export function calibrateIndex(db: DatabaseLike, tableName: string): void {
+  // Validate table name to prevent SQL injection
+  if (!isValidIdentifier(tableName)) {
+    throw new Error(
+      `Invalid table name: ${tableName} (must be alphanumeric/underscore, start with letter/underscore, max ${MAX_IDENTIFIER_LEN} chars)`
+    );
+  }
+
+  // tableName is validated above, safe to interpolate
+  db.prepare(`INSERT INTO ${tableName}(${tableName}) VALUES ('calibrate')`).run();
+}
+
+// Scratch views for reading float32 bit patterns
+const f32Scratch = new Float32Array(1);
+const u32Scratch = new Uint32Array(f32Scratch.buffer);
+
+/** IEEE binary16 bits of x, rounded to nearest even (matches the C encoder) */
+function toFloat16Bits(x: number): number {
+  f32Scratch[0] = x;
+  const bits = u32Scratch[0];
+  const sign = (bits >>> 16) & 0x8000;
+  let mant = bits & 0x7fffff;
+  let exp = (bits >>> 23) & 0xff;
+  if (exp === 0xff) {
+    return sign | 0x7c00 | (mant ? 0x200 : 0); // inf, NaN
+  }
+  exp -= 127 - 15;
+  if (exp >= 0x1f) {
+    return sign | 0x7c00; // overflow: infinity
+  }
+  let shift = 13;
+  if (exp <= 0) {
+    if (exp < -10) {
+      return sign; // below half the smallest subnormal
+    }
+    mant |= 0x800000;
+    shift = 14 - exp;
+    exp = 0;
+  }
+  let h = (exp << 10) | (mant >>> shift);
+  const rest = mant & ((1 << shift) - 1);
+  const halfway = 1 << (shift - 1);
+  if (rest > halfway || (rest === halfway && h & 1)) {
+    h++;
+  }
+  return sign | h;
+}
+
+/** bfloat16 bits of x, rounded to nearest even (matches the C encoder) */
+function toBFloat16Bits(x: number): number {
+  f32Scratch[0] = x;
+  const bits = u32Scratch[0];
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return ((bits >>> 16) | 0x40) & 0xffff; // keep NaN a (quiet) NaN
+  }
+  return Math.floor((bits + 0x7fff + ((bits >>> 16) & 1)) / 0x10000) & 0xffff;
+}
+
+/**
+ * Encode a vector for a `vectorType: "float16"` or `"bfloat16"` index
+ *
+ * Those tables take vector BLOBs of two bytes per dimension for both
+ * `INSERT` and `MATCH`. Pass the result to {@link insertVector},
+ * {@link searchNearest}, or bind it directly in SQL.
+ *
+ * @param vector - Vector as Float32Array or number[]
+ * @param vectorType - Element type of the index
+ * @returns The encoded elements, in host byte order like Float32Array
+ *
+ * @example
+ * ```ts
+ * createDiskAnnIndex(db, "embeddings", { dimension: 3, vectorType: "float16" });
+ * insertVector(db, "embeddings", 1, encodeHalfVector([0.1, 0.2, 0.3], "float16"));
+ * ```
+ */
+export function encodeHalfVector(
+  vector: Float32Array | number[],
+  vectorType: Exclude<VectorType, "float32">
+): Uint16Array {
+  if (vectorType !== "float16" && vectorType !== "bfloat16") {
+    throw new Error(`Invalid vectorType: ${vectorType} (must be float16 or bfloat16)`);
+  }
+  const encode = vectorType === "float16" ? toFloat16Bits : toBFloat16Bits;
+  const out = new Uint16Array(vector.length);
+  for (let i = 0; i < vector.length; i++) {
+    out[i] = encode(vector[i]);
+  }
+  return out;
+}
@@ -83,6 +83,11 @@ export interface DatabaseLike {
  */
 export type DistanceMetric = "cosine" | "euclidean" | "dot";
 
+/**
+ * Element type of stored vectors
+ */
+export type VectorType = "float32" | "float16" | "bfloat16";
+
 /**
  * Metadata column types supported by virtual table
  */
@@ -101,6 +106,24 @@ export interface MetadataColumn {
    * SQLite column type
    */
   type: MetadataColumnType;
+
+  /**
+   * Build a label-aware graph for equality filters on this column
+   * (`category TEXT LABEL`). At most one column per index may set this.
+   *
+   * Edge pruning keeps same-label neighbors, and `column = ?` filters walk
+   * only the subgraph of matching rows, which keeps recall high for labels
+   * covering a small share of the index. Costs an extra label walk per
+   * insert.
+   */
+  label?: boolean;
+
+  /**
+   * Route rows to a shard by this column (`tenant INTEGER PARTITION`):
+   * rows with equal values share a shard. Requires `shards`; at most one
+   * column per index may set this, and it cannot be combined with `label`.
+   */
+  partition?: boolean;
 }
 
 /**
@@ -131,7 +154,7 @@ export interface DiskAnnIndexOptions {
    *
    * - `"euclidean"`: L2 distance (default, general use)
    * - `"cosine"`: Cosine similarity (recommended for text embeddings)
-   * - `"dot"`: Dot product (for pre-normalized vectors)
+   * - `"dot"`: Inner product; `distance` is `-(a·b)` (smaller is closer)
    *
    * @default "euclidean"
    * @example "cosine"  // Recommended for text embeddings
@@ -195,6 +218,84 @@ export interface DiskAnnIndexOptions {
    */
   blockSize?: number;
 
+  /**
+   * Storage encoding for the edge (neighbor) vectors in each node block
+   *
+   * **🔒 IMMUTABLE** - Requires index rebuild to change
+   *
+   * `"int8"` stores one byte per dimension instead of four, so roughly 4×
+   * more neighbors fit in each block read. Search re-scores visited nodes
+   * with their exact float32 vectors, so returned distances stay exact.
+   * Values outside `[quantMin, quantMax]` are clamped. Without an explicit
+   * range, it is taken from the first vectors inserted.
+   *
+   * @default "float32"
+   */
+  edgeType?: "float32" | "int8";
+
+  /**
+   * Element type of the stored vectors
+   *
+   * **🔒 IMMUTABLE** - Requires index rebuild to change
+   *
+   * `"float16"` (IEEE binary16) and `"bfloat16"` store two bytes per
+   * dimension instead of four, halving node blocks and edge slots so each
+   * block read carries about twice the neighbors. Distances are computed
+   * against the rounded vectors. The table then takes vector BLOBs in this
+   * type for both `INSERT` and `MATCH`: encode vectors with
+   * `encodeHalfVector()` and pass the resulting `Uint16Array` to
+   * `insertVector()` and `searchNearest()`.
+   *
+   * @default "float32"
+   */
+  vectorType?: VectorType;
+
+  /**
+   * Lower bound of the int8 quantization range (only used with `edgeType: "int8"`).
+   * Set both bounds or neither.
+   *
+   * @default derived from the first vectors inserted
+   */
+  quantMin?: number;
+
+  /**
+   * Upper bound of the int8 quantization range (only used with `edgeType: "int8"`).
+   * Set both bounds or neither.
+   *
+   * @default derived from the first vectors inserted
+   */
+  quantMax?: number;
+
+  /**
+   * How `DELETE` removes rows
+   *
+   * `"tombstone"` marks the row's node as deleted with a single block write;
+   * searches skip it right away, and tombstoned rows are removed from the
+   * graph in batches once `consolidateThreshold` of them accumulate.
+   * `"immediate"` unlinks each node as it is deleted.
+   *
+   * @default "immediate"
+   */
+  deleteMode?: "immediate" | "tombstone";
+
+  /**
+   * Number of tombstones that triggers consolidation (only used with
+   * `deleteMode: "tombstone"`; 0 never consolidates automatically)
+   *
+   * @default 1024
+   */
+  consolidateThreshold?: number;
+
+  /**
+   * Split the index over one shard per listed schema (typically
+   * databases ATTACHed to the connection, one file each). Rows are routed
+   * by rowid, or by the `partition` metadata column; searches fan out to
+   * every shard and merge. LABEL columns are not supported.
+   *
+   * @example ["s1", "s2"]
+   */
+  shards?: string[];
+
   /**
    * Whether to normalize vectors during insertion
    *
@@ -251,6 +352,36 @@ export interface NearestNeighborResult {
   [key: string]: unknown;
 }
 
+/**
+ * One row for {@link insertVectors}
+ */
+export interface VectorRow {
+  /**
+   * Unique row identifier (SQLite rowid)
+   */
+  id: number | bigint;
+
+  /**
+   * Vector as Float32Array or number[] (must match index dimension), or a
+   * Uint16Array from `encodeHalfVector()` for float16/bfloat16 indexes
+   */
+  vector: Float32Array | Uint16Array | number[];
+}
+
+/**
+ * A k-NN query prepared once by `createSearcher()` and run many times
+ */
+export interface Searcher {
+  /**
+   * Search for the nearest neighbors of queryVector
+   *
+   * @param queryVector - Query vector as Float32Array or number[] (must match
+   *   index dimension), or a Uint16Array for float16/bfloat16 indexes
+   * @returns The searcher's k nearest neighbors sorted by distance
+   */
+  search(queryVector: Float32Array | Uint16Array | number[]): NearestNeighborResult[];
+}
+
 /**
  * Options for controlling search behavior at query time
  *
@@ -289,4 +420,31 @@ export interface SearchOptions {
    * ```
    */
   searchListSize?: number;
+
+  /**
+   * Exact search: `true` scores every row instead of walking the graph,
+   * `false` always walks the graph
+   *
+   * **✅ RUNTIME MUTABLE** - Can be changed per-query without rebuilding
+   *
+   * By default, indexes of up to 2048 rows are scanned exactly and larger
+   * ones are walked. Forcing `true` on a large index is slow but yields the
+   * true nearest neighbors, e.g. as ground truth for recall measurements.
+   *
+   * @default Automatic (scan small indexes, walk large ones)
+   */
+  exact?: boolean;
+
+  /**
+   * Recall@k to size the search beam for, in (0, 1]
+   *
+   * **✅ RUNTIME MUTABLE** - Can be changed per-query without rebuilding
+   *
+   * Read off the recall curve measured by `calibrateIndex()`: the search
+   * uses the smallest measured beam that reached this recall. Ignored by
+   * indexes that were never calibrated, and when `searchListSize` is set.
+   *
+   * @default The calibrated target (0.95)
+   */
+  recallTarget?: number;
 }
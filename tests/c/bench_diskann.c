@@ -0,0 +1,625 @@
+/*
+** Native microbenchmarks for DiskANN hot paths
+**
+** Times the distance kernels of every SIMD level this host supports, the
+** VisitedSet and BlobCache primitives, and, on a synthetic in-memory index
+** per dataset size: diskann_build(), graph searches with and without a
+** warm read cache, single and batched diskann_insert(), and
+** diskann_batch_repair_edges(). Datasets and queries come from a fixed
+** seed, so two runs on one machine see the same inputs.
+**
+** Results go to stdout as CSV (default) or JSON, one record per
+** benchmark and size; progress goes to stderr:
+**   ./build/bench_diskann --sizes 10000,100000 --json > bench.json
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+
+/* Must be first - clock_gettime requires _POSIX_C_SOURCE on Linux */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <sqlite3.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "../../src/diskann.h"
+#include "../../src/diskann_blob.h"
+#include "../../src/diskann_cache.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_node.h"
+#include "../../src/diskann_search.h"
+#include "../../src/diskann_simd.h"
+
+/**************************************************************************
+** Configuration
+**************************************************************************/
+
+#define BENCH_DEFAULT_DIMS 128
+#define BENCH_DEFAULT_SEED 42
+#define BENCH_MAX_SIZES 8
+#define BENCH_MAX_NEIGHBORS 32
+#define BENCH_SEARCH_L 100
+#define BENCH_INSERT_L 100
+#define BENCH_K 10
+
+/* Kernel evaluations per timed repetition, and repetitions (best kept) */
+#define BENCH_KERNEL_OPS (1u << 20)
+#define BENCH_KERNEL_POOL 1024
+#define BENCH_REPS 5
+
+#define BENCH_QUERIES 1000
+#define BENCH_INSERTS 200
+
+/* Read cache budget of the warm search benchmark */
+#define BENCH_CACHE_BUDGET (256ULL * 1024 * 1024)
+
+typedef struct BenchOptions {
+  uint32_t sizes[BENCH_MAX_SIZES];
+  int n_sizes;
+  uint32_t dims;
+  uint32_t seed;
+  int json;
+  const char *filter; /* run benchmarks whose name contains this */
+} BenchOptions;
+
+static BenchOptions opts;
+static int n_emitted;
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER now, freq;
+  QueryPerformanceCounter(&now);
+  QueryPerformanceFrequency(&freq);
+  uint64_t ticks = (uint64_t)now.QuadPart;
+  uint64_t hz = (uint64_t)freq.QuadPart;
+  return ticks / hz * 1000000000u + ticks % hz * 1000000000u / hz;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint32_t next_u32(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return *state;
+}
+
+static float next_float(uint32_t *state) {
+  return (float)(next_u32(state) >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+/* n random vectors of opts.dims floats in [-1, 1), from seed */
+static float *gen_vectors(uint32_t n, uint32_t seed) {
+  size_t count = (size_t)n * opts.dims;
+  float *v = (float *)malloc(count * sizeof(float));
+  if (!v) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < count; i++) {
+    v[i] = next_float(&seed);
+  }
+  return v;
+}
+
+static int bench_enabled(const char *name) {
+  return !opts.filter || strstr(name, opts.filter) != NULL;
+}
+
+static void check(int rc, const char *what) {
+  if (rc != DISKANN_OK) {
+    fprintf(stderr, "bench: %s failed (rc=%d)\n", what, rc);
+    exit(1);
+  }
+}
+
+/* Print one result: ops operations took elapsed_ns */
+static void emit(const char *name, const char *variant, uint32_t size,
+                 uint64_t ops, uint64_t elapsed_ns) {
+  double ns_per_op = ops ? (double)elapsed_ns / (double)ops : 0.0;
+  double ops_per_sec = elapsed_ns ? (double)ops * 1e9 / (double)elapsed_ns
+                                  : 0.0;
+  if (opts.json) {
+    printf("%s\n    {\"benchmark\": \"%s\", \"variant\": \"%s\", "
+           "\"size\": %u, \"dims\": %u, \"ops\": %llu, "
+           "\"ns_per_op\": %.2f, \"ops_per_sec\": %.1f}",
+           n_emitted ? "," : "", name, variant, size, opts.dims,
+           (unsigned long long)ops, ns_per_op, ops_per_sec);
+  } else {
+    printf("%s,%s,%u,%u,%llu,%.2f,%.1f\n", name, variant, size, opts.dims,
+           (unsigned long long)ops, ns_per_op, ops_per_sec);
+  }
+  fflush(stdout);
+  n_emitted++;
+}
+
+/**************************************************************************
+** Distance kernels
+**************************************************************************/
+
+static volatile float kernel_sink;
+
+/* Best of BENCH_REPS runs of BENCH_KERNEL_OPS calls over the pool */
+static uint64_t time_kernel(DiskAnnDistanceFn fn, const float *query,
+                            const float *pool) {
+  uint64_t best = UINT64_MAX;
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    float acc = 0.0f;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_KERNEL_OPS; i++) {
+      const float *b = pool + (size_t)(i % BENCH_KERNEL_POOL) * opts.dims;
+      acc += fn(query, b, opts.dims);
+    }
+    uint64_t elapsed = now_ns() - start;
+    kernel_sink = acc;
+    if (elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best;
+}
+
+static uint64_t time_bounded_kernel(DiskAnnBoundedDistanceFn fn,
+                                    const float *query, const float *pool,
+                                    float bound) {
+  uint64_t best = UINT64_MAX;
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    float acc = 0.0f;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_KERNEL_OPS; i++) {
+      const float *b = pool + (size_t)(i % BENCH_KERNEL_POOL) * opts.dims;
+      acc += fn(query, b, opts.dims, bound);
+    }
+    uint64_t elapsed = now_ns() - start;
+    kernel_sink = acc;
+    if (elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best;
+}
+
+static uint64_t time_half_kernel(DiskAnnHalfDistanceFn fn, const float *query,
+                                 const uint16_t *pool) {
+  uint64_t best = UINT64_MAX;
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    float acc = 0.0f;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_KERNEL_OPS; i++) {
+      const uint16_t *b = pool + (size_t)(i % BENCH_KERNEL_POOL) * opts.dims;
+      acc += fn(query, b, opts.dims);
+    }
+    uint64_t elapsed = now_ns() - start;
+    kernel_sink = acc;
+    if (elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best;
+}
+
+static void bench_distance(void) {
+  float *pool = gen_vectors(BENCH_KERNEL_POOL, opts.seed);
+  float *query = gen_vectors(1, opts.seed + 1);
+  size_t count = (size_t)BENCH_KERNEL_POOL * opts.dims;
+  uint16_t *f16 = (uint16_t *)malloc(count * sizeof(uint16_t));
+  uint16_t *bf16 = (uint16_t *)malloc(count * sizeof(uint16_t));
+  if (!f16 || !bf16) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < count; i++) {
+    f16[i] = diskann_f32_to_f16(pool[i]);
+    bf16[i] = diskann_f32_to_bf16(pool[i]);
+  }
+
+  for (int level = 0; level < DISKANN_SIMD_LEVEL_COUNT; level++) {
+    const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+    if (!k) {
+      continue;
+    }
+    fprintf(stderr, "bench: distance kernels (%s)\n", k->name);
+    const struct {
+      const char *name;
+      DiskAnnDistanceFn fn;
+    } full[] = {{"distance_l2", k->l2},
+                {"distance_dot", k->dot},
+                {"distance_cosine", k->cosine}};
+    for (size_t i = 0; i < sizeof(full) / sizeof(full[0]); i++) {
+      if (full[i].fn && bench_enabled(full[i].name)) {
+        emit(full[i].name, k->name, 0, BENCH_KERNEL_OPS,
+             time_kernel(full[i].fn, query, pool));
+      }
+    }
+    /* A bound no vector reaches, then one every vector passes at once */
+    if (k->l2_bounded && bench_enabled("distance_l2_bounded")) {
+      emit("distance_l2_bounded", k->name, 0, BENCH_KERNEL_OPS,
+           time_bounded_kernel(k->l2_bounded, query, pool, INFINITY));
+      emit("distance_l2_bounded_abandon", k->name, 0, BENCH_KERNEL_OPS,
+           time_bounded_kernel(k->l2_bounded, query, pool, 0.0f));
+    }
+    if (k->l2_f16 && bench_enabled("distance_l2_f16")) {
+      emit("distance_l2_f16", k->name, 0, BENCH_KERNEL_OPS,
+           time_half_kernel(k->l2_f16, query, f16));
+    }
+    if (k->l2_bf16 && bench_enabled("distance_l2_bf16")) {
+      emit("distance_l2_bf16", k->name, 0, BENCH_KERNEL_OPS,
+           time_half_kernel(k->l2_bf16, query, bf16));
+    }
+  }
+  free(f16);
+  free(bf16);
+  free(query);
+  free(pool);
+}
+
+/**************************************************************************
+** VisitedSet and BlobCache
+**************************************************************************/
+
+/* size random rowids from seed */
+static uint64_t *gen_rowids(uint32_t size, uint32_t seed) {
+  uint64_t *ids = (uint64_t *)malloc((size_t)size * sizeof(uint64_t));
+  if (!ids) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    ids[i] = next_u32(&seed) % (size * 4u) + 1;
+  }
+  return ids;
+}
+
+static void bench_visited_set(uint32_t size) {
+  if (!bench_enabled("visited_set")) {
+    return;
+  }
+  fprintf(stderr, "bench: visited set (%u)\n", size);
+  uint64_t *ids = gen_rowids(size, opts.seed);
+  uint64_t *probes = gen_rowids(size, opts.seed + 1);
+  uint64_t best_put = UINT64_MAX;
+  uint64_t best_contains = UINT64_MAX;
+  int found = 0;
+
+  /* Starts small, as a search context's set does, and grows */
+  VisitedSet set;
+  visited_set_init(&set, 64);
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    visited_set_clear(&set);
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < size; i++) {
+      check(visited_set_put(&set, ids[i], 1), "visited_set_put");
+    }
+    uint64_t put = now_ns() - start;
+    start = now_ns();
+    for (uint32_t i = 0; i < size; i++) {
+      found += visited_set_contains(&set, probes[i]);
+    }
+    uint64_t contains = now_ns() - start;
+    best_put = put < best_put ? put : best_put;
+    best_contains = contains < best_contains ? contains : best_contains;
+  }
+  visited_set_deinit(&set);
+  kernel_sink = (float)found;
+  emit("visited_set_put", "", size, size, best_put);
+  emit("visited_set_contains", "", size, size, best_contains);
+  free(probes);
+  free(ids);
+}
+
+/* Handle-less BlobSpot with one reference, as blob_spot_create() leaves */
+static BlobSpot *mock_spot(void) {
+  BlobSpot *spot = (BlobSpot *)sqlite3_malloc(sizeof(BlobSpot));
+  if (!spot) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  memset(spot, 0, sizeof(*spot));
+  spot->refcount = 1;
+  return spot;
+}
+
+static void bench_blob_cache(uint32_t size) {
+  if (!bench_enabled("blob_cache")) {
+    return;
+  }
+  fprintf(stderr, "bench: blob cache (%u)\n", size);
+  uint64_t *ids = gen_rowids(size, opts.seed);
+  uint64_t *probes = gen_rowids(size, opts.seed + 1);
+  BlobSpot **spots = (BlobSpot **)malloc((size_t)size * sizeof(BlobSpot *));
+  if (!spots) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    spots[i] = mock_spot();
+  }
+  uint64_t best_put = UINT64_MAX;
+  uint64_t best_get = UINT64_MAX;
+
+  /* Half the keys fit, so puts evict and about half the gets miss */
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    BlobCache cache;
+    check(blob_cache_init(&cache, (int)(size / 2 + 1)), "blob_cache_init");
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < size; i++) {
+      blob_cache_put(&cache, ids[i], spots[i]);
+    }
+    uint64_t put = now_ns() - start;
+    start = now_ns();
+    for (uint32_t i = 0; i < size; i++) {
+      BlobSpot *hit = blob_cache_get(&cache, probes[i]);
+      if (hit) {
+        blob_spot_free(hit);
+      }
+    }
+    uint64_t get = now_ns() - start;
+    blob_cache_deinit(&cache);
+    best_put = put < best_put ? put : best_put;
+    best_get = get < best_get ? get : best_get;
+  }
+  emit("blob_cache_put", "", size, size, best_put);
+  emit("blob_cache_get", "", size, size, best_get);
+
+  for (uint32_t i = 0; i < size; i++) {
+    blob_spot_free(spots[i]);
+  }
+  free(spots);
+  free(probes);
+  free(ids);
+}
+
+/**************************************************************************
+** Index benchmarks
+**************************************************************************/
+
+/* An in-memory index of size vectors, built by diskann_build() */
+static DiskAnnIndex *build_index(sqlite3 *db, uint32_t size) {
+  DiskAnnConfig config = {.dimensions = opts.dims,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = BENCH_MAX_NEIGHBORS,
+                          .search_list_size = BENCH_SEARCH_L,
+                          .insert_list_size = BENCH_INSERT_L};
+  check(diskann_create_index(db, "main", "bench", &config), "create index");
+  DiskAnnIndex *idx = NULL;
+  check(diskann_open_index(db, "main", "bench", &idx), "open index");
+
+  fprintf(stderr, "bench: loading %u vectors\n", size);
+  float *vectors = gen_vectors(size, opts.seed);
+  check(sqlite3_exec(db, "BEGIN", NULL, NULL, NULL) == SQLITE_OK
+            ? DISKANN_OK
+            : DISKANN_ERROR,
+        "BEGIN");
+  for (uint32_t i = 0; i < size; i++) {
+    check(diskann_insert_vector(idx, (int64_t)i + 1,
+                                vectors + (size_t)i * opts.dims, opts.dims),
+          "diskann_insert_vector");
+  }
+  check(sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) == SQLITE_OK
+            ? DISKANN_OK
+            : DISKANN_ERROR,
+        "COMMIT");
+  free(vectors);
+
+  fprintf(stderr, "bench: building graph (%u)\n", size);
+  uint64_t start = now_ns();
+  check(diskann_build(idx, NULL), "diskann_build");
+  if (bench_enabled("build")) {
+    emit("build", "", size, size, now_ns() - start);
+  }
+  return idx;
+}
+
+/* One graph search per query; returns the elapsed time */
+static uint64_t run_searches(DiskAnnIndex *idx, const float *queries) {
+  DiskAnnSearchParams params = {.exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnResult results[BENCH_K];
+  uint64_t start = now_ns();
+  for (int q = 0; q < BENCH_QUERIES; q++) {
+    int n = diskann_search_ex(idx, queries + (size_t)q * opts.dims, opts.dims,
+                              BENCH_K, &params, results, NULL, NULL);
+    if (n < 0) {
+      check(n, "diskann_search_ex");
+    }
+  }
+  return now_ns() - start;
+}
+
+/*
+** Cold: every block is read through SQLite (a fresh handle, no read
+** cache). Warm: the handle's read cache holds the blocks of an earlier
+** pass over the same queries.
+*/
+static void bench_search(sqlite3 *db, DiskAnnIndex **idx, uint32_t size) {
+  if (!bench_enabled("search")) {
+    return;
+  }
+  fprintf(stderr, "bench: search (%u)\n", size);
+  float *queries = gen_vectors(BENCH_QUERIES, opts.seed + 7);
+
+  diskann_close_index(*idx);
+  check(diskann_open_index(db, "main", "bench", idx), "open index");
+  emit("search_cold", "", size, BENCH_QUERIES, run_searches(*idx, queries));
+
+  check(diskann_set_cache_budget(*idx, BENCH_CACHE_BUDGET),
+        "diskann_set_cache_budget");
+  (void)run_searches(*idx, queries);
+  emit("search_warm", "", size, BENCH_QUERIES, run_searches(*idx, queries));
+  check(diskann_set_cache_budget(*idx, 0), "diskann_set_cache_budget");
+  free(queries);
+}
+
+/* Inserts go after the dataset, under rowids from next_id */
+static void bench_insert(DiskAnnIndex *idx, uint32_t size, int64_t *next_id) {
+  float *vectors = gen_vectors(BENCH_INSERTS * 3, opts.seed + 11);
+
+  if (bench_enabled("insert_single")) {
+    fprintf(stderr, "bench: single inserts (%u)\n", size);
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_INSERTS; i++) {
+      check(diskann_insert(idx, (*next_id)++,
+                           vectors + (size_t)i * opts.dims, opts.dims),
+            "diskann_insert");
+    }
+    emit("insert_single", "", size, BENCH_INSERTS, now_ns() - start);
+  }
+
+  if (bench_enabled("insert_batch")) {
+    fprintf(stderr, "bench: batched inserts (%u)\n", size);
+    const float *batch = vectors + (size_t)BENCH_INSERTS * opts.dims;
+    uint64_t start = now_ns();
+    check(diskann_begin_batch(idx, 0), "diskann_begin_batch");
+    for (int i = 0; i < BENCH_INSERTS; i++) {
+      check(diskann_insert(idx, (*next_id)++,
+                           batch + (size_t)i * opts.dims, opts.dims),
+            "diskann_insert");
+    }
+    check(diskann_end_batch(idx), "diskann_end_batch");
+    emit("insert_batch", "", size, BENCH_INSERTS, now_ns() - start);
+  }
+
+  /* Deferred back-edges of one batch, repaired in one timed pass (ops
+  ** are edges) */
+  if (bench_enabled("repair_edges")) {
+    fprintf(stderr, "bench: deferred edge repair (%u)\n", size);
+    const float *batch = vectors + (size_t)BENCH_INSERTS * 2 * opts.dims;
+    check(diskann_begin_batch(idx, DISKANN_BATCH_DEFERRED_EDGES),
+          "diskann_begin_batch");
+    for (int i = 0; i < BENCH_INSERTS; i++) {
+      check(diskann_insert(idx, (*next_id)++,
+                           batch + (size_t)i * opts.dims, opts.dims),
+            "diskann_insert");
+    }
+    uint64_t n_edges =
+        idx->deferred_edges ? (uint64_t)idx->deferred_edges->count : 0;
+    uint64_t start = now_ns();
+    check(diskann_batch_repair_edges(idx, idx->deferred_edges),
+          "diskann_batch_repair_edges");
+    uint64_t elapsed = now_ns() - start;
+    check(diskann_end_batch(idx), "diskann_end_batch");
+    emit("repair_edges", "", size, n_edges, elapsed);
+  }
+  free(vectors);
+}
+
+static void bench_index(uint32_t size) {
+  if (!bench_enabled("build") && !bench_enabled("search") &&
+      !bench_enabled("insert") && !bench_enabled("repair_edges")) {
+    return;
+  }
+  sqlite3 *db = NULL;
+  if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+    fprintf(stderr, "bench: cannot open database\n");
+    exit(1);
+  }
+  DiskAnnIndex *idx = build_index(db, size);
+  int64_t next_id = (int64_t)size + 1;
+  bench_search(db, &idx, size);
+  bench_insert(idx, size, &next_id);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Main
+**************************************************************************/
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: bench_diskann [--sizes N[,N...]] [--dims D] [--seed S]\n"
+          "                     [--filter NAME] [--json]\n"
+          "  --sizes   dataset sizes (default 10000,100000)\n"
+          "  --dims    vector dimensions (default %d)\n"
+          "  --seed    dataset seed (default %d)\n"
+          "  --filter  only benchmarks whose name contains NAME\n"
+          "  --json    JSON instead of CSV\n",
+          BENCH_DEFAULT_DIMS, BENCH_DEFAULT_SEED);
+  exit(2);
+}
+
+static void parse_sizes(const char *arg) {
+  opts.n_sizes = 0;
+  while (*arg) {
+    char *end = NULL;
+    unsigned long v = strtoul(arg, &end, 10);
+    if (end == arg || v == 0 || v > 100000000ul ||
+        opts.n_sizes == BENCH_MAX_SIZES) {
+      usage();
+    }
+    opts.sizes[opts.n_sizes++] = (uint32_t)v;
+    arg = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',') {
+      usage();
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  opts.sizes[0] = 10000;
+  opts.sizes[1] = 100000;
+  opts.n_sizes = 2;
+  opts.dims = BENCH_DEFAULT_DIMS;
+  opts.seed = BENCH_DEFAULT_SEED;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--json") == 0) {
+      opts.json = 1;
+    } else if (strcmp(arg, "--sizes") == 0 && value) {
+      parse_sizes(value);
+      i++;
+    } else if (strcmp(arg, "--dims") == 0 && value) {
+      opts.dims = (uint32_t)strtoul(value, NULL, 10);
+      if (opts.dims == 0 || opts.dims > 16384) {
+        usage();
+      }
+      i++;
+    } else if (strcmp(arg, "--seed") == 0 && value) {
+      opts.seed = (uint32_t)strtoul(value, NULL, 10);
+      i++;
+    } else if (strcmp(arg, "--filter") == 0 && value) {
+      opts.filter = value;
+      i++;
+    } else {
+      usage();
+    }
+  }
+
+  const DiskAnnDistanceKernels *active =
+      diskann_simd_kernels(diskann_simd_level());
+  if (opts.json) {
+    printf("{\n  \"sqlite\": \"%s\",\n  \"simd\": \"%s\",\n  \"seed\": %u,\n"
+           "  \"results\": [",
+           sqlite3_libversion(), active ? active->name : "scalar", opts.seed);
+  } else {
+    printf("benchmark,variant,size,dims,ops,ns_per_op,ops_per_sec\n");
+  }
+
+  bench_distance();
+  for (int i = 0; i < opts.n_sizes; i++) {
+    bench_visited_set(opts.sizes[i]);
+    bench_blob_cache(opts.sizes[i]);
+  }
+  for (int i = 0; i < opts.n_sizes; i++) {
+    bench_index(opts.sizes[i]);
+  }
+
+  if (opts.json) {
+    printf("\n  ]\n}\n");
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+** Tests for diskann_bitmap.h/.c — the compressed rowid set used by
+** metadata filters.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_bitmap.h"
+#include "unity/unity.h"
+#include <stdlib.h>
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+void test_bitmap_empty(void) {
+  DiskAnnBitmap bm;
+  diskann_bitmap_init(&bm);
+  TEST_ASSERT_EQUAL_UINT64(0, bm.count);
+  TEST_ASSERT_FALSE(diskann_bitmap_contains(&bm, 0));
+
+  DiskAnnBitmapIter it;
+  int64_t rowid;
+  diskann_bitmap_iter_init(&it, &bm);
+  TEST_ASSERT_FALSE(diskann_bitmap_next(&it, &rowid));
+  diskann_bitmap_deinit(&bm);
+}
+
+/* Sparse random rowids (negative too) in arbitrary order, with repeats */
+void test_bitmap_sparse_random(void) {
+  enum { N = 5000 };
+  static uint64_t ref[N];
+  DiskAnnBitmap bm;
+  diskann_bitmap_init(&bm);
+
+  uint64_t state = 12345;
+  for (int i = 0; i < N; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    int64_t rowid = (int64_t)(state >> 20) - (1LL << 40);
+    ref[i] = (uint64_t)rowid;
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, rowid));
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, rowid));
+  }
+  TEST_ASSERT_EQUAL_UINT64(N, bm.count);
+
+  for (int i = 0; i < N; i++) {
+    TEST_ASSERT_TRUE(diskann_bitmap_contains(&bm, (int64_t)ref[i]));
+    TEST_ASSERT_FALSE(diskann_bitmap_contains(&bm, (int64_t)ref[i] + 1));
+  }
+
+  /* Iteration is ascending in unsigned order */
+  qsort(ref, N, sizeof(ref[0]), cmp_u64);
+  DiskAnnBitmapIter it;
+  int64_t rowid;
+  diskann_bitmap_iter_init(&it, &bm);
+  for (int i = 0; i < N; i++) {
+    TEST_ASSERT_TRUE(diskann_bitmap_next(&it, &rowid));
+    TEST_ASSERT_EQUAL_UINT64(ref[i], (uint64_t)rowid);
+  }
+  TEST_ASSERT_FALSE(diskann_bitmap_next(&it, &rowid));
+
+  diskann_bitmap_deinit(&bm);
+}
+
+/* A dense range turns array containers into bitsets and shrinks */
+void test_bitmap_dense_range(void) {
+  const int64_t first = 100000, n = 150000;
+  DiskAnnBitmap bm;
+  diskann_bitmap_init(&bm);
+
+  for (int64_t r = first; r < first + n; r += 2) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, r));
+  }
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)n / 2, bm.count);
+  TEST_ASSERT_NULL(bm.containers[1].array);
+  TEST_ASSERT_NOT_NULL(bm.containers[1].bits);
+  /* 8KB per 65536 rowids, far below 8 bytes per member */
+  TEST_ASSERT_TRUE(diskann_bitmap_bytes(&bm) < (size_t)n / 2 * 2);
+
+  TEST_ASSERT_FALSE(diskann_bitmap_contains(&bm, first - 2));
+  TEST_ASSERT_TRUE(diskann_bitmap_contains(&bm, first));
+  TEST_ASSERT_FALSE(diskann_bitmap_contains(&bm, first + 1));
+  TEST_ASSERT_TRUE(diskann_bitmap_contains(&bm, first + n - 2));
+  TEST_ASSERT_FALSE(diskann_bitmap_contains(&bm, first + n));
+
+  DiskAnnBitmapIter it;
+  int64_t rowid, expected = first;
+  diskann_bitmap_iter_init(&it, &bm);
+  while (diskann_bitmap_next(&it, &rowid)) {
+    TEST_ASSERT_EQUAL_INT64(expected, rowid);
+    expected += 2;
+  }
+  TEST_ASSERT_EQUAL_INT64(first + n, expected);
+
+  diskann_bitmap_deinit(&bm);
+  TEST_ASSERT_EQUAL_UINT32(0, bm.n_containers);
+}
+
+/* A copy has the same members in both container forms, and owns them */
+void test_bitmap_copy(void) {
+  DiskAnnBitmap bm, copy;
+  diskann_bitmap_init(&bm);
+  for (int64_t r = 0; r < 20000; r += 3) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, r)); /* bitset */
+  }
+  for (int64_t r = 70000; r < 70100; r++) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, r)); /* array */
+  }
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_copy(&copy, &bm));
+  TEST_ASSERT_EQUAL_UINT64(bm.count, copy.count);
+
+  DiskAnnBitmapIter a, b;
+  int64_t ra, rb;
+  diskann_bitmap_iter_init(&a, &bm);
+  diskann_bitmap_iter_init(&b, &copy);
+  while (diskann_bitmap_next(&a, &ra)) {
+    TEST_ASSERT_TRUE(diskann_bitmap_next(&b, &rb));
+    TEST_ASSERT_EQUAL_INT64(ra, rb);
+  }
+  TEST_ASSERT_FALSE(diskann_bitmap_next(&b, &rb));
+
+  diskann_bitmap_deinit(&bm);
+  TEST_ASSERT_TRUE(diskann_bitmap_contains(&copy, 70050));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&copy, 70200));
+  diskann_bitmap_deinit(&copy);
+}
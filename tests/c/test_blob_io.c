@@ -357,4 +357,363 @@ void test_blob_spot_create_null_output(void) {
   sqlite3_close(db);
 }
 
+/*
+** Test partial reads: seek reads nothing, read_range fills only its bytes,
+** and a later reload brings the full block back
+*/
+void test_blob_spot_partial_read(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+  BlobSpot *spot = NULL;
+
+  int rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+
+  idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+
+  uint8_t row1[4096], row2[4096];
+  for (int i = 0; i < 4096; i++) {
+    row1[i] = (uint8_t)i;
+    row2[i] = (uint8_t)(255 - i);
+  }
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 1, row1, 4096));
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 2, row2, 4096));
+
+  rc = blob_spot_create(idx, &spot, 1, 4096, 1);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 1, 4096));
+  uint64_t bytes = idx->num_read_bytes;
+
+  /* Seek to row 2 and read two ranges */
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_seek(idx, spot, 2));
+  TEST_ASSERT_EQUAL(1, spot->is_partial);
+  TEST_ASSERT_EQUAL(bytes, idx->num_read_bytes);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_read_range(idx, spot, 0, 16));
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_read_range(idx, spot, 4000, 96));
+  TEST_ASSERT_EQUAL_UINT64(bytes + 112, idx->num_read_bytes);
+  TEST_ASSERT_EQUAL_MEMORY(row2, spot->buffer, 16);
+  TEST_ASSERT_EQUAL_MEMORY(row2 + 4000, spot->buffer + 4000, 96);
+
+  /* Out of range, and partial spots can't be flushed or copied */
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    blob_spot_read_range(idx, spot, 4000, 97));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, blob_spot_flush(idx, spot));
+  BlobSpot *copy = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, blob_spot_copy(spot, &copy));
+
+  /* Reload of the same rowid reads the full block */
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 2, 4096));
+  TEST_ASSERT_EQUAL(0, spot->is_partial);
+  TEST_ASSERT_EQUAL_MEMORY(row2, spot->buffer, 4096);
+  /* Ranges on a full spot are free */
+  bytes = idx->num_read_bytes;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_read_range(idx, spot, 16, 64));
+  TEST_ASSERT_EQUAL_UINT64(bytes, idx->num_read_bytes);
+
+  /* Missing rows surface as ROW_NOT_FOUND, like reload */
+  TEST_ASSERT_EQUAL(DISKANN_ROW_NOT_FOUND, blob_spot_seek(idx, spot, 999));
+
+  blob_spot_free(spot);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Test pooled writable spots: reads and flushes go through the pool's
+** handle, and a released spot's buffer serves the next load
+*/
+void test_blob_spot_load_pooled(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+  BlobSpot *spot = NULL;
+
+  int rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+
+  idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+
+  uint32_t size = idx->block_size;
+  uint8_t *row1 = (uint8_t *)sqlite3_malloc((int)size);
+  uint8_t *row2 = (uint8_t *)sqlite3_malloc((int)size);
+  TEST_ASSERT_NOT_NULL(row1);
+  TEST_ASSERT_NOT_NULL(row2);
+  memset(row1, 0x11, size);
+  memset(row2, 0x22, size);
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 1, row1, size));
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 2, row2, size));
+
+  rc = blob_spot_load(idx, &spot, 1);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_NOT_NULL(idx->blob_pool);
+  TEST_ASSERT_TRUE(spot->pool == idx->blob_pool);
+  TEST_ASSERT_NULL(spot->pBlob);
+  TEST_ASSERT_EQUAL(1, spot->is_writable);
+  TEST_ASSERT_EQUAL_MEMORY(row1, spot->buffer, size);
+
+  /* Flush through the shared handle */
+  memset(spot->buffer, 0x33, size);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_flush(idx, spot));
+  TEST_ASSERT_NULL(spot->pBlob);
+
+  /* The last free keeps the spot for the next load */
+  BlobSpot *first = spot;
+  blob_spot_free(spot);
+  TEST_ASSERT_EQUAL(1, idx->blob_pool->n_free);
+  rc = blob_spot_load(idx, &spot, 2);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_TRUE(spot == first);
+  TEST_ASSERT_EQUAL(0, idx->blob_pool->n_free);
+  TEST_ASSERT_EQUAL_MEMORY(row2, spot->buffer, size);
+  blob_spot_free(spot);
+
+  /* Missing rows return their spot to the pool */
+  TEST_ASSERT_EQUAL(DISKANN_ROW_NOT_FOUND, blob_spot_load(idx, &spot, 999));
+  TEST_ASSERT_NULL(spot);
+  TEST_ASSERT_EQUAL(1, idx->blob_pool->n_free);
+
+  /* The flushed block reads back through a handle of its own */
+  rc = blob_spot_create(idx, &spot, 1, size, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 1, size));
+  TEST_ASSERT_EQUAL(0x33, spot->buffer[0]);
+  TEST_ASSERT_EQUAL(0x33, spot->buffer[size - 1]);
+  blob_spot_free(spot);
+
+  sqlite3_free(row1);
+  sqlite3_free(row2);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Test that the pool's handle survives SQL writes that expire it, and
+** that releasing it lets the transaction commit
+*/
+void test_blob_pool_expired_handle(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+  BlobSpot *spot = NULL;
+
+  int rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+
+  idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+
+  uint32_t size = idx->block_size;
+  uint8_t *row = (uint8_t *)sqlite3_malloc((int)size);
+  TEST_ASSERT_NOT_NULL(row);
+  memset(row, 0x11, size);
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 1, row, size));
+
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  rc = blob_spot_load(idx, &spot, 1);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_NOT_NULL(idx->blob_pool->pBlob);
+
+  /* Rewrite the row behind the handle's back: it expires */
+  memset(row, 0x44, size);
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_prepare_v2(db,
+                                       "UPDATE test_idx_shadow SET data = ? "
+                                       "WHERE id = 1",
+                                       -1, &stmt, NULL));
+  sqlite3_bind_blob(stmt, 1, row, (int)size, SQLITE_STATIC);
+  TEST_ASSERT_EQUAL(SQLITE_DONE, sqlite3_step(stmt));
+  sqlite3_finalize(stmt);
+
+  /* Reload and flush reopen it */
+  spot->is_initialized = 0;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 1, size));
+  TEST_ASSERT_EQUAL_MEMORY(row, spot->buffer, size);
+  spot->buffer[0] = 0x55;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_flush(idx, spot));
+
+  /* An open handle would make COMMIT fail */
+  blob_pool_release_handle(idx->blob_pool);
+  TEST_ASSERT_NULL(idx->blob_pool->pBlob);
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+
+  /* The spot keeps working after the release */
+  spot->is_initialized = 0;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 1, size));
+  TEST_ASSERT_EQUAL(0x55, spot->buffer[0]);
+  TEST_ASSERT_EQUAL(0x44, spot->buffer[1]);
+  blob_spot_free(spot);
+
+  sqlite3_free(row);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Test that inserts recycle their walk's spots and leave no handle open
+*/
+void test_blob_pool_insert_walks(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+
+  int rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+
+  idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+
+  float vector[128];
+  uint32_t seed = 42;
+  for (int64_t id = 1; id <= 50; id++) {
+    for (int d = 0; d < 128; d++) {
+      seed = seed * 1103515245u + 12345u;
+      vector[d] = (float)(seed >> 16) / 65536.0f;
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, id, vector, 128));
+    TEST_ASSERT_NOT_NULL(idx->blob_pool);
+    TEST_ASSERT_NULL(idx->blob_pool->pBlob);
+  }
+  /* Walks visit many nodes, all released back to the pool */
+  TEST_ASSERT_TRUE(idx->blob_pool->n_free > 1);
+
+  /* Every node is still reachable */
+  DiskAnnResult results[5];
+  int n = diskann_search(idx, vector, 128, 5, results);
+  TEST_ASSERT_EQUAL(5, n);
+  TEST_ASSERT_EQUAL_INT64(50, results[0].id);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Test dirty range tracking: touching ranges merge, and past the limit a
+** new range merges with its nearest neighbor
+*/
+void test_blob_spot_mark_dirty(void) {
+  uint8_t buffer[4096];
+  BlobSpot spot;
+  memset(&spot, 0, sizeof(spot));
+  spot.buffer = buffer;
+  spot.buffer_size = sizeof(buffer);
+
+  blob_spot_mark_dirty(&spot, 100, 10);
+  blob_spot_mark_dirty(&spot, 110, 10); /* touches */
+  blob_spot_mark_dirty(&spot, 95, 10);  /* overlaps */
+  blob_spot_mark_dirty(&spot, 200, 0);  /* empty */
+  TEST_ASSERT_EQUAL(1, spot.n_dirty);
+  TEST_ASSERT_EQUAL_UINT32(95, spot.dirty_start[0]);
+  TEST_ASSERT_EQUAL_UINT32(120, spot.dirty_end[0]);
+
+  /* Bridging two ranges merges all three */
+  blob_spot_mark_dirty(&spot, 300, 10);
+  blob_spot_mark_dirty(&spot, 115, 190);
+  TEST_ASSERT_EQUAL(1, spot.n_dirty);
+  TEST_ASSERT_EQUAL_UINT32(95, spot.dirty_start[0]);
+  TEST_ASSERT_EQUAL_UINT32(310, spot.dirty_end[0]);
+
+  /* Fill every slot, 100 bytes apart */
+  spot.n_dirty = 0;
+  for (uint32_t i = 0; i < BLOB_SPOT_DIRTY_RANGES; i++) {
+    blob_spot_mark_dirty(&spot, i * 100, 4);
+  }
+  TEST_ASSERT_EQUAL(BLOB_SPOT_DIRTY_RANGES, spot.n_dirty);
+
+  /* One more joins the range at 100 (3 bytes away) */
+  blob_spot_mark_dirty(&spot, 107, 2);
+  TEST_ASSERT_EQUAL(BLOB_SPOT_DIRTY_RANGES, spot.n_dirty);
+  int found = 0;
+  for (int i = 0; i < spot.n_dirty; i++) {
+    if (spot.dirty_start[i] == 100) {
+      TEST_ASSERT_EQUAL_UINT32(109, spot.dirty_end[i]);
+      found = 1;
+    }
+  }
+  TEST_ASSERT_TRUE(found);
+}
+
+/*
+** Test that a flush writes only the marked ranges, and the whole buffer
+** when nothing was marked
+*/
+void test_blob_spot_flush_dirty_ranges(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+  BlobSpot *spot = NULL;
+  BlobSpot *check = NULL;
+
+  int rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+
+  idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+
+  uint8_t zero[4096] = {0};
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 1, zero, 4096));
+
+  /* Own handle: only [100, 110) and [3000, 3004) reach the row */
+  rc = blob_spot_create(idx, &spot, 1, 4096, 1);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 1, 4096));
+  memset(spot->buffer, 0xEE, 4096);
+  blob_spot_mark_dirty(spot, 100, 10);
+  blob_spot_mark_dirty(spot, 3000, 4);
+  uint64_t bytes = idx->num_write_bytes;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_flush(idx, spot));
+  TEST_ASSERT_EQUAL_UINT64(bytes + 14, idx->num_write_bytes);
+  TEST_ASSERT_EQUAL(0, spot->n_dirty);
+
+  rc = blob_spot_create(idx, &check, 1, 4096, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, check, 1, 4096));
+  TEST_ASSERT_EQUAL(0x00, check->buffer[99]);
+  TEST_ASSERT_EQUAL(0xEE, check->buffer[100]);
+  TEST_ASSERT_EQUAL(0xEE, check->buffer[109]);
+  TEST_ASSERT_EQUAL(0x00, check->buffer[110]);
+  TEST_ASSERT_EQUAL(0xEE, check->buffer[3003]);
+  TEST_ASSERT_EQUAL(0x00, check->buffer[3004]);
+
+  /* Nothing marked: the whole buffer */
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_flush(idx, spot));
+  TEST_ASSERT_EQUAL_UINT64(bytes + 14 + 4096, idx->num_write_bytes);
+  check->is_initialized = 0;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, check, 1, 4096));
+  TEST_ASSERT_EQUAL_MEMORY(spot->buffer, check->buffer, 4096);
+  blob_spot_free(spot);
+
+  /* Pooled spots write their ranges through the pool's handle, and a
+  ** reload drops ranges marked since the last flush */
+  uint32_t size = idx->block_size;
+  uint8_t *row = (uint8_t *)sqlite3_malloc((int)size);
+  TEST_ASSERT_NOT_NULL(row);
+  memset(row, 0, size);
+  TEST_ASSERT_EQUAL(SQLITE_OK, insert_test_row(db, "test_idx", 2, row, size));
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_load(idx, &spot, 2));
+  blob_spot_mark_dirty(spot, 0, 8);
+  spot->is_initialized = 0;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, spot, 2, size));
+  TEST_ASSERT_EQUAL(0, spot->n_dirty);
+  memset(spot->buffer, 0x77, size);
+  blob_spot_mark_dirty(spot, size - 16, 16);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_flush(idx, spot));
+  blob_spot_free(spot);
+  blob_pool_release_handle(idx->blob_pool);
+
+  blob_spot_free(check);
+  check = NULL;
+  rc = blob_spot_create(idx, &check, 2, size, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_spot_reload(idx, check, 2, size));
+  TEST_ASSERT_EQUAL(0x00, check->buffer[size - 17]);
+  TEST_ASSERT_EQUAL(0x77, check->buffer[size - 16]);
+  TEST_ASSERT_EQUAL(0x77, check->buffer[size - 1]);
+
+  sqlite3_free(row);
+  blob_spot_free(check);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
 /* main() is in test_runner.c */
@@ -0,0 +1,319 @@
+/*
+** Tests for diskann_insert_vector() + diskann_build() — vector-only ingest
+** followed by the parallel in-memory graph build.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_blob.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_node.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <sqlite3.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUILD_TEST_DIMS 16
+#define BUILD_TEST_N 500
+#define BUILD_TEST_K 10
+#define BUILD_TEST_QUERIES 20
+#define BUILD_TEST_MAX_NEIGHBORS 16
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static DiskAnnIndex *create_build_index(sqlite3 *db, const char *name,
+                                        uint8_t metric) {
+  DiskAnnConfig config = {.dimensions = BUILD_TEST_DIMS,
+                          .metric = metric,
+                          .max_neighbors = BUILD_TEST_MAX_NEIGHBORS,
+                          .search_list_size = 64,
+                          .insert_list_size = 64};
+  DiskAnnIndex *idx = create_index(db, name, &config);
+  /* Measure the built graph, not the small-index exact scan */
+  diskann_set_exact_scan_threshold(idx, 0);
+  return idx;
+}
+
+/* Ingest vectors with ids 1..n */
+static void ingest(DiskAnnIndex *idx, const float *vectors, int n) {
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT(
+        DISKANN_OK,
+        diskann_insert_vector(idx, i + 1, vectors + i * BUILD_TEST_DIMS,
+                              BUILD_TEST_DIMS));
+  }
+}
+
+/* Mean recall@K over BUILD_TEST_QUERIES queries against brute force */
+static double measure_recall(DiskAnnIndex *idx, const float *vectors, int n,
+                             uint8_t metric) {
+  float *queries = gen_vectors(BUILD_TEST_QUERIES, BUILD_TEST_DIMS, 777u);
+  float *dists = malloc((size_t)n * sizeof(float));
+  TEST_ASSERT_NOT_NULL(dists);
+  int hits = 0;
+  DiskAnnStats before, after;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &before));
+
+  for (int q = 0; q < BUILD_TEST_QUERIES; q++) {
+    const float *query = queries + q * BUILD_TEST_DIMS;
+    for (int i = 0; i < n; i++) {
+      dists[i] = diskann_distance(query, vectors + i * BUILD_TEST_DIMS,
+                                  BUILD_TEST_DIMS, metric);
+    }
+    DiskAnnResult results[BUILD_TEST_K];
+    int n_results =
+        diskann_search(idx, query, BUILD_TEST_DIMS, BUILD_TEST_K, results);
+    TEST_ASSERT_EQUAL_INT(BUILD_TEST_K, n_results);
+
+    /* A result is a hit when fewer than K vectors are strictly closer */
+    for (int r = 0; r < n_results; r++) {
+      float d = dists[results[r].id - 1];
+      int closer = 0;
+      for (int i = 0; i < n; i++) {
+        if (dists[i] < d) {
+          closer++;
+        }
+      }
+      if (closer < BUILD_TEST_K) {
+        hits++;
+      }
+    }
+  }
+
+  /* Recall of an exact scan says nothing about the graph */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &after));
+  TEST_ASSERT_TRUE_MESSAGE(after.nodes_visited > before.nodes_visited,
+                           "recall was measured without walking the graph");
+
+  free(queries);
+  free(dists);
+  return (double)hits / (BUILD_TEST_QUERIES * BUILD_TEST_K);
+}
+
+static int edge_count(DiskAnnIndex *idx, int64_t rowid) {
+  BlobSpot *spot = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        blob_spot_create(idx, &spot, (uint64_t)rowid,
+                                         idx->block_size,
+                                         DISKANN_BLOB_READONLY));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, blob_spot_reload(idx, spot,
+                                                     (uint64_t)rowid,
+                                                     idx->block_size));
+  int n_edges = (int)node_bin_edges(idx, spot);
+  blob_spot_free(spot);
+  return n_edges;
+}
+
+/**************************************************************************
+** Tests
+**************************************************************************/
+
+void test_build_invalid(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_build_index(db, "b_invalid", DISKANN_METRIC_EUCLIDEAN);
+  float v[BUILD_TEST_DIMS] = {0};
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_build(NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_insert_vector(NULL, 1, v, BUILD_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_insert_vector(idx, 1, NULL, BUILD_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_DIMENSION,
+                        diskann_insert_vector(idx, 1, v, 3));
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_vector(idx, 1, v, BUILD_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_EXISTS,
+                        diskann_insert_vector(idx, 1, v, BUILD_TEST_DIMS));
+
+  /* The graph is off-limits while batch mode holds cached blocks */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_begin_batch(idx, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_build(idx, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(idx));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_build_empty_and_single(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_build_index(db, "b_single", DISKANN_METRIC_EUCLIDEAN);
+  float v[BUILD_TEST_DIMS] = {1.0f, 2.0f, 3.0f};
+  DiskAnnResult result;
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, NULL));
+  TEST_ASSERT_EQUAL_INT(0, diskann_search(idx, v, BUILD_TEST_DIMS, 1,
+                                          &result));
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_vector(idx, 42, v, BUILD_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, NULL));
+  TEST_ASSERT_EQUAL_INT(1, idx->has_entry);
+  TEST_ASSERT_EQUAL_INT64(42, idx->entry_rowid);
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, v, BUILD_TEST_DIMS, 1,
+                                          &result));
+  TEST_ASSERT_EQUAL_INT64(42, result.id);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, result.distance);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+static void check_build_recall(uint8_t metric, const char *name) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_build_index(db, name, metric);
+  float *vectors = gen_vectors(BUILD_TEST_N, BUILD_TEST_DIMS, 2024u + metric);
+  ingest(idx, vectors, BUILD_TEST_N);
+
+  DiskAnnBuildConfig config = {.num_threads = 4};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, &config));
+
+  for (int64_t id = 1; id <= BUILD_TEST_N; id++) {
+    int n_edges = edge_count(idx, id);
+    TEST_ASSERT_TRUE(n_edges >= 1);
+    TEST_ASSERT_TRUE(n_edges <= (int)node_edges_max_count(idx));
+  }
+
+  double recall = measure_recall(idx, vectors, BUILD_TEST_N, metric);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.9, "built graph recall@10 < 0.9");
+
+  free(vectors);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_build_recall_l2(void) {
+  check_build_recall(DISKANN_METRIC_EUCLIDEAN, "b_recall_l2");
+}
+
+void test_build_recall_cosine(void) {
+  check_build_recall(DISKANN_METRIC_COSINE, "b_recall_cos");
+}
+
+/* Rounds are order-independent, so the thread count must not change a
+** single byte of the stored graph */
+void test_build_thread_count_deterministic(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *one = create_build_index(db, "b_one", DISKANN_METRIC_EUCLIDEAN);
+  DiskAnnIndex *many =
+      create_build_index(db, "b_many", DISKANN_METRIC_EUCLIDEAN);
+  float *vectors = gen_vectors(BUILD_TEST_N, BUILD_TEST_DIMS, 99u);
+  ingest(one, vectors, BUILD_TEST_N);
+  ingest(many, vectors, BUILD_TEST_N);
+
+  DiskAnnBuildConfig config = {.num_threads = 1};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(one, &config));
+  config.num_threads = 7;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(many, &config));
+
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db,
+                         "SELECT a.data, b.data FROM b_one_shadow a "
+                         "JOIN b_many_shadow b USING (id)",
+                         -1, &stmt, NULL));
+  int rows = 0;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    int n_bytes = sqlite3_column_bytes(stmt, 0);
+    TEST_ASSERT_EQUAL_INT(n_bytes, sqlite3_column_bytes(stmt, 1));
+    TEST_ASSERT_EQUAL_MEMORY(sqlite3_column_blob(stmt, 0),
+                             sqlite3_column_blob(stmt, 1), (size_t)n_bytes);
+    rows++;
+  }
+  sqlite3_finalize(stmt);
+  TEST_ASSERT_EQUAL_INT(BUILD_TEST_N, rows);
+  TEST_ASSERT_EQUAL_INT64(one->entry_rowid, many->entry_rowid);
+
+  free(vectors);
+  diskann_close_index(one);
+  diskann_close_index(many);
+  sqlite3_close(db);
+}
+
+typedef struct ProgressLog {
+  uint32_t calls;
+  uint32_t last;
+  uint32_t total;
+  int monotonic;
+} ProgressLog;
+
+static void record_progress(uint32_t processed, uint32_t total, void *ctx) {
+  ProgressLog *log = (ProgressLog *)ctx;
+  if (processed < log->last) {
+    log->monotonic = 0;
+  }
+  log->calls++;
+  log->last = processed;
+  log->total = total;
+}
+
+void test_build_progress_callback(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_build_index(db, "b_progress", DISKANN_METRIC_EUCLIDEAN);
+  float *vectors = gen_vectors(BUILD_TEST_N, BUILD_TEST_DIMS, 5u);
+  ingest(idx, vectors, BUILD_TEST_N);
+
+  ProgressLog log = {.monotonic = 1};
+  DiskAnnBuildConfig config = {.num_threads = 2,
+                               .progress = record_progress,
+                               .progress_ctx = &log};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, &config));
+  TEST_ASSERT_TRUE(log.calls > 2);
+  TEST_ASSERT_TRUE(log.monotonic);
+  TEST_ASSERT_EQUAL_UINT32(BUILD_TEST_N, log.last);
+  TEST_ASSERT_EQUAL_UINT32(BUILD_TEST_N, log.total);
+
+  free(vectors);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* diskann_insert() and a rebuild both work on top of a built graph */
+void test_build_then_insert_and_rebuild(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_build_index(db, "b_incremental", DISKANN_METRIC_EUCLIDEAN);
+  float *vectors = gen_vectors(BUILD_TEST_N, BUILD_TEST_DIMS, 31u);
+  int n_bulk = BUILD_TEST_N - 50;
+  ingest(idx, vectors, n_bulk);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, NULL));
+
+  for (int i = n_bulk; i < BUILD_TEST_N; i++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(idx, i + 1,
+                                         vectors + i * BUILD_TEST_DIMS,
+                                         BUILD_TEST_DIMS));
+  }
+  for (int i = n_bulk; i < BUILD_TEST_N; i++) {
+    DiskAnnResult result;
+    TEST_ASSERT_EQUAL_INT(1, diskann_search(idx,
+                                            vectors + i * BUILD_TEST_DIMS,
+                                            BUILD_TEST_DIMS, 1, &result));
+    TEST_ASSERT_EQUAL_INT64(i + 1, result.id);
+  }
+  TEST_ASSERT_TRUE(measure_recall(idx, vectors, BUILD_TEST_N,
+                                  DISKANN_METRIC_EUCLIDEAN) >= 0.9);
+
+  /* Rebuilding the incrementally grown graph keeps it searchable */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, NULL));
+  TEST_ASSERT_TRUE(measure_recall(idx, vectors, BUILD_TEST_N,
+                                  DISKANN_METRIC_EUCLIDEAN) >= 0.9);
+
+  free(vectors);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
@@ -23,6 +23,10 @@
 ** 4. NULL SAFETY — defensive programming
 **    - All functions handle NULL pointers gracefully
 **
+** 5. HASH INDEX / BYTE BUDGET — large caches
+**    - Random put/get/remove churn matches a reference model
+**    - Byte budget evicts by entry size, eviction counter is kept
+**
 ** Note: These tests will FAIL to compile initially because diskann_cache.h
 ** doesn't exist yet. This is correct TDD — tests define the API contract
 ** before implementation.
@@ -488,3 +492,173 @@ void test_cache_same_pointer_no_leak(void) {
   blob_cache_deinit(&cache); /* 2 → 1 */
   blob_spot_free(spot);      /* 1 → 0 → freed */
 }
+
+/**************************************************************************
+** Invalidation — remove/clear
+**************************************************************************/
+
+void test_cache_remove_keeps_lru_chain(void) {
+  BlobCache cache;
+  blob_cache_init(&cache, 4);
+
+  BlobSpot *spots[4];
+  for (int i = 0; i < 4; i++) {
+    spots[i] = create_mock_blobspot();
+    TEST_ASSERT_NOT_NULL(spots[i]);
+    blob_cache_put(&cache, (uint64_t)(i + 1), spots[i]);
+  }
+
+  /* Remove a middle slot: the last slot moves into the hole */
+  blob_cache_remove(&cache, 2);
+  TEST_ASSERT_EQUAL(3, cache.count);
+  TEST_ASSERT_EQUAL(1, spots[1]->refcount); /* cache ref released */
+  TEST_ASSERT_NULL(blob_cache_get(&cache, 2));
+  blob_cache_remove(&cache, 2); /* absent: no-op */
+  TEST_ASSERT_EQUAL(3, cache.count);
+
+  /* LRU order is intact: 1 is oldest, so filling up evicts it first */
+  BlobSpot *extra = create_mock_blobspot();
+  BlobSpot *extra2 = create_mock_blobspot();
+  blob_cache_put(&cache, 5, extra);
+  blob_cache_put(&cache, 6, extra2);
+  TEST_ASSERT_EQUAL(4, cache.count);
+  TEST_ASSERT_NULL(blob_cache_get(&cache, 1));
+  for (uint64_t rowid = 3; rowid <= 6; rowid++) {
+    BlobSpot *got = blob_cache_get(&cache, rowid);
+    TEST_ASSERT_NOT_NULL(got);
+    blob_spot_free(got); /* balance get's addref */
+  }
+
+  blob_cache_deinit(&cache);
+  for (int i = 0; i < 4; i++) {
+    blob_spot_free(spots[i]);
+  }
+  blob_spot_free(extra);
+  blob_spot_free(extra2);
+}
+
+void test_cache_clear(void) {
+  BlobCache cache;
+  blob_cache_init(&cache, 8);
+
+  BlobSpot *spot = create_mock_blobspot();
+  blob_cache_put(&cache, 1, spot);
+  blob_cache_put(&cache, 2, spot);
+  TEST_ASSERT_EQUAL(3, spot->refcount);
+
+  blob_cache_clear(&cache);
+  TEST_ASSERT_EQUAL(0, cache.count);
+  TEST_ASSERT_EQUAL(8, cache.capacity);
+  TEST_ASSERT_EQUAL(1, spot->refcount);
+  TEST_ASSERT_NULL(blob_cache_get(&cache, 1));
+
+  /* Still usable after clear */
+  blob_cache_put(&cache, 3, spot);
+  TEST_ASSERT_EQUAL(1, cache.count);
+
+  blob_cache_clear(NULL); /* NULL safe */
+  blob_cache_remove(NULL, 1);
+  blob_cache_deinit(&cache);
+  blob_spot_free(spot);
+}
+
+/**************************************************************************
+** Hash index and byte budget
+**************************************************************************/
+
+void test_cache_byte_budget_evicts(void) {
+  BlobCache cache;
+  uint64_t entry = BLOB_CACHE_ENTRY_BYTES(1000);
+  TEST_ASSERT_EQUAL(DISKANN_ERROR, blob_cache_init_bytes(&cache, entry - 1,
+                                                         1000));
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_cache_init_bytes(&cache, 3 * entry, 1000));
+  TEST_ASSERT_EQUAL(3, cache.capacity);
+  TEST_ASSERT_EQUAL_UINT64(3 * entry, cache.max_bytes);
+
+  BlobSpot *spots[5];
+  for (int i = 0; i < 5; i++) {
+    spots[i] = create_mock_blobspot();
+    spots[i]->buffer_size = 1000;
+  }
+  spots[3]->buffer_size = 2000; /* costs two small entries */
+
+  for (int i = 0; i < 3; i++) {
+    blob_cache_put(&cache, (uint64_t)i, spots[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT64(3 * entry, cache.bytes);
+  TEST_ASSERT_EQUAL_UINT64(0, cache.evictions);
+
+  /* The big entry needs two evictions by bytes */
+  blob_cache_put(&cache, 3, spots[3]);
+  TEST_ASSERT_EQUAL(2, cache.count);
+  TEST_ASSERT_EQUAL_UINT64(2, cache.evictions);
+  TEST_ASSERT_TRUE(cache.bytes <= cache.max_bytes);
+  TEST_ASSERT_EQUAL(1, spots[0]->refcount);
+  TEST_ASSERT_EQUAL(1, spots[1]->refcount);
+
+  blob_cache_remove(&cache, 3);
+  TEST_ASSERT_EQUAL_UINT64(entry, cache.bytes);
+
+  blob_cache_deinit(&cache);
+  for (int i = 0; i < 5; i++) {
+    blob_spot_free(spots[i]);
+  }
+}
+
+void test_cache_hash_index_churn(void) {
+  enum { CAP = 1000, KEYS = 4096, OPS = 50000 };
+  BlobCache cache;
+  TEST_ASSERT_EQUAL(DISKANN_OK, blob_cache_init(&cache, CAP));
+
+  BlobSpot *spot = create_mock_blobspot();
+  static char present[KEYS];
+  memset(present, 0, sizeof(present));
+  int n_present = 0;
+  uint32_t state = 12345u;
+
+  for (int op = 0; op < OPS; op++) {
+    state = state * 1664525u + 1013904223u;
+    /* Clustered and strided keys: sequential rowids are the common case */
+    uint64_t key = (state >> 8) % KEYS;
+    uint64_t rowid = key * 64 + 1;
+    int action = (int)(state >> 28) % 4;
+
+    if (action == 0) {
+      blob_cache_remove(&cache, rowid);
+      if (present[key]) {
+        present[key] = 0;
+        n_present--;
+      }
+    } else if (action == 1) {
+      BlobSpot *got = blob_cache_get(&cache, rowid);
+      TEST_ASSERT_EQUAL(present[key] ? 1 : 0, got != NULL);
+      blob_spot_free(got);
+    } else {
+      if (cache.count == CAP && !present[key]) {
+        /* The LRU tail is about to go: mirror it in the model */
+        uint64_t tail = cache.rowids[cache.tail];
+        present[(tail - 1) / 64] = 0;
+        n_present--;
+      }
+      blob_cache_put(&cache, rowid, spot);
+      if (!present[key]) {
+        present[key] = 1;
+        n_present++;
+      }
+    }
+    TEST_ASSERT_EQUAL(n_present, cache.count);
+  }
+
+  /* Every key the model holds is findable */
+  for (uint64_t key = 0; key < KEYS; key++) {
+    BlobSpot *got = blob_cache_get(&cache, key * 64 + 1);
+    TEST_ASSERT_EQUAL(present[key] ? 1 : 0, got != NULL);
+    blob_spot_free(got);
+  }
+  TEST_ASSERT_EQUAL(cache.count + 1, spot->refcount);
+  TEST_ASSERT_TRUE(cache.hits + cache.misses >= KEYS);
+
+  blob_cache_deinit(&cache);
+  TEST_ASSERT_EQUAL(1, spot->refcount);
+  blob_spot_free(spot);
+}
@@ -0,0 +1,360 @@
+/*
+** Tests for diskann_calibrate(), recall-targeted search list sizes and
+** patience-based early termination
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int sqlite3_diskann_init(sqlite3 *db, char **pzErrMsg,
+                                const sqlite3_api_routines *pApi);
+
+/* Exposed via TESTING ifdef */
+extern int effective_search_list_size(DiskAnnIndex *idx,
+                                      const DiskAnnSearchParams *params,
+                                      int k);
+
+#ifdef _WIN32
+#define CALIBRATE_TEST_DB "diskann_test_calibrate.db"
+#else
+#define CALIBRATE_TEST_DB "/tmp/diskann_test_calibrate.db"
+#endif
+
+#define CALIBRATE_TEST_DIMS 16
+#define CALIBRATE_TEST_N 600
+#define CALIBRATE_TEST_QUERIES 40
+#define CALIBRATE_TEST_K 5
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static const DiskAnnConfig calibrate_config = {
+    .dimensions = CALIBRATE_TEST_DIMS,
+    .metric = DISKANN_METRIC_EUCLIDEAN,
+    .max_neighbors = 16,
+    .search_list_size = 32,
+    .insert_list_size = 32};
+
+/* Index of CALIBRATE_TEST_N random vectors on db */
+static DiskAnnIndex *build_calibrate_index(sqlite3 *db) {
+  return build_index(db, &calibrate_config, CALIBRATE_TEST_N, 11);
+}
+
+/* Mean recall@k of searches with params against exact results */
+static double measure_recall(DiskAnnIndex *idx,
+                             const DiskAnnSearchParams *params) {
+  DiskAnnSearchParams exact = {.exact = DISKANN_SEARCH_EXACT};
+  DiskAnnResult found[CALIBRATE_TEST_K];
+  DiskAnnResult truth[CALIBRATE_TEST_K];
+  float q[CALIBRATE_TEST_DIMS];
+  uint32_t state = 1234;
+  int hits = 0;
+  for (int i = 0; i < CALIBRATE_TEST_QUERIES; i++) {
+    fill_vector(q, CALIBRATE_TEST_DIMS, &state);
+    int n = diskann_search_ex(idx, q, CALIBRATE_TEST_DIMS, CALIBRATE_TEST_K,
+                              params, found, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(CALIBRATE_TEST_K, n);
+    TEST_ASSERT_EQUAL_INT(CALIBRATE_TEST_K,
+                          diskann_search_ex(idx, q, CALIBRATE_TEST_DIMS,
+                                            CALIBRATE_TEST_K, &exact, truth,
+                                            NULL, NULL));
+    for (int a = 0; a < n; a++) {
+      for (int b = 0; b < CALIBRATE_TEST_K; b++) {
+        if (found[a].id == truth[b].id) {
+          hits++;
+          break;
+        }
+      }
+    }
+  }
+  return (double)hits / (CALIBRATE_TEST_QUERIES * CALIBRATE_TEST_K);
+}
+
+static int query_int(sqlite3 *db, const char *sql) {
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db, sql, -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  int value = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  return value;
+}
+
+/**************************************************************************
+** diskann_calibrate()
+**************************************************************************/
+
+void test_calibrate_invalid(void) {
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_calibrate(NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_recall_curve(NULL, NULL, NULL, 0));
+
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_index(db, "idx", &calibrate_config);
+
+  DiskAnnCalibrateConfig bad_target = {.recall_target = 1.5f};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_calibrate(idx, &bad_target));
+  DiskAnnCalibrateConfig bad_k = {.k = 100000};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_calibrate(idx, &bad_k));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_recall_curve(idx, NULL, NULL, -1));
+
+  /* An empty index has nothing to measure */
+  TEST_ASSERT_EQUAL_INT(0, diskann_calibrate(idx, NULL));
+  TEST_ASSERT_EQUAL_INT(0, diskann_recall_curve(idx, NULL, NULL, 0));
+
+  /* Batch mode holds edges that are not on disk yet */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_begin_batch(idx, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_calibrate(idx, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(idx));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_calibrate_stores_curve(void) {
+  remove(CALIBRATE_TEST_DB);
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(CALIBRATE_TEST_DB, &db));
+  DiskAnnIndex *idx = build_calibrate_index(db);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats_reset(idx));
+
+  DiskAnnCalibrateConfig config = {.n_queries = 50,
+                                   .k = CALIBRATE_TEST_K,
+                                   .recall_target = 0.9f};
+  int n_points = diskann_calibrate(idx, &config);
+  TEST_ASSERT_TRUE(n_points > 0);
+  TEST_ASSERT_TRUE(n_points <= DISKANN_MAX_RECALL_POINTS);
+
+  /* Sizes grow from k + 1 until every neighbor was found */
+  uint32_t sizes[DISKANN_MAX_RECALL_POINTS];
+  float recalls[DISKANN_MAX_RECALL_POINTS];
+  TEST_ASSERT_EQUAL_INT(n_points, diskann_recall_curve(
+                                      idx, sizes, recalls,
+                                      DISKANN_MAX_RECALL_POINTS));
+  TEST_ASSERT_EQUAL_UINT32(CALIBRATE_TEST_K + 1, sizes[0]);
+  for (int i = 0; i < n_points; i++) {
+    TEST_ASSERT_TRUE(recalls[i] >= 0.0f && recalls[i] <= 1.0f);
+    if (i > 0) {
+      TEST_ASSERT_TRUE(sizes[i] > sizes[i - 1]);
+    }
+  }
+  TEST_ASSERT_TRUE(recalls[n_points - 1] >= 0.9f ||
+                   n_points == DISKANN_MAX_RECALL_POINTS);
+
+  /* Calibration searches are not the application's */
+  DiskAnnStats stats;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(0, stats.searches);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.blocks_read);
+
+  /* The curve survives reopening */
+  diskann_close_index(idx);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_index(db, "main", "idx", &idx));
+  uint32_t reopened[DISKANN_MAX_RECALL_POINTS];
+  float reopened_recalls[DISKANN_MAX_RECALL_POINTS];
+  TEST_ASSERT_EQUAL_INT(n_points,
+                        diskann_recall_curve(idx, reopened, reopened_recalls,
+                                             DISKANN_MAX_RECALL_POINTS));
+  for (int i = 0; i < n_points; i++) {
+    TEST_ASSERT_EQUAL_UINT32(sizes[i], reopened[i]);
+    TEST_ASSERT_TRUE(fabsf(recalls[i] - reopened_recalls[i]) < 1e-5f);
+  }
+  diskann_close_index(idx);
+
+  /* Clearing the index drops it */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_clear_index(db, "main", "idx"));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_index(db, "main", "idx", &idx));
+  TEST_ASSERT_EQUAL_INT(0, diskann_recall_curve(idx, NULL, NULL, 0));
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(CALIBRATE_TEST_DB);
+}
+
+void test_calibrate_sizes_search_list(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = build_calibrate_index(db);
+
+  /* Uncalibrated: the configured size, raised to sqrt(MAX(rowid)) */
+  int sqrt_n = (int)sqrtf((float)CALIBRATE_TEST_N);
+  TEST_ASSERT_EQUAL_INT(sqrt_n > 32 ? sqrt_n : 32,
+                        effective_search_list_size(idx, NULL, 0));
+
+  DiskAnnCalibrateConfig config = {.n_queries = 50, .k = CALIBRATE_TEST_K};
+  int n_points = diskann_calibrate(idx, &config);
+  TEST_ASSERT_TRUE(n_points > 0);
+  uint32_t sizes[DISKANN_MAX_RECALL_POINTS];
+  float recalls[DISKANN_MAX_RECALL_POINTS];
+  diskann_recall_curve(idx, sizes, recalls, DISKANN_MAX_RECALL_POINTS);
+
+  /* Default target 0.95: the smallest measured size reaching it */
+  int expected = n_points - 1;
+  for (int i = 0; i < n_points; i++) {
+    if (recalls[i] >= 0.95f) {
+      expected = i;
+      break;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT((int)sizes[expected],
+                        effective_search_list_size(idx, NULL,
+                                                   CALIBRATE_TEST_K));
+
+  /* A per-query target; 1.0 takes the last point */
+  DiskAnnSearchParams all = {.recall_target = 1.0f};
+  TEST_ASSERT_EQUAL_INT((int)sizes[n_points - 1],
+                        effective_search_list_size(idx, &all,
+                                                   CALIBRATE_TEST_K));
+  DiskAnnSearchParams low = {.recall_target = 0.01f};
+  TEST_ASSERT_EQUAL_INT((int)sizes[0], effective_search_list_size(
+                                           idx, &low, CALIBRATE_TEST_K));
+
+  /* A larger k widens the beam in proportion, never below k */
+  TEST_ASSERT_TRUE(effective_search_list_size(idx, &low, 40) >= 40);
+  int wide = effective_search_list_size(idx, &all, 4 * CALIBRATE_TEST_K);
+  TEST_ASSERT_TRUE(wide >= 4 * (int)sizes[n_points - 1] - 1);
+
+  /* An explicit search_list_size keeps the sqrt(n) rule */
+  DiskAnnSearchParams fixed = {.search_list_size = 200,
+                               .recall_target = 0.01f};
+  TEST_ASSERT_EQUAL_INT(200, effective_search_list_size(idx, &fixed, 0));
+
+  /* Searches at the default target come close to it */
+  DiskAnnSearchParams graph = {.exact = DISKANN_SEARCH_GRAPH};
+  TEST_ASSERT_TRUE(measure_recall(idx, &graph) >= 0.85);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Patience
+**************************************************************************/
+
+void test_search_patience(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = build_calibrate_index(db);
+
+  DiskAnnSearchParams full = {.search_list_size = 100,
+                              .exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnSearchParams patient = full;
+  patient.patience = 8;
+
+  DiskAnnStats stats;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats_reset(idx));
+  double full_recall = measure_recall(idx, &full);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  uint64_t full_visited = stats.nodes_visited;
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats_reset(idx));
+  double patient_recall = measure_recall(idx, &patient);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+
+  /* Stopping once the top k settles visits fewer nodes for little recall */
+  TEST_ASSERT_TRUE(stats.nodes_visited < full_visited);
+  TEST_ASSERT_TRUE(patient_recall >= full_recall - 0.15);
+
+  /* Patience also applies to filtered and batch searches */
+  float queries[4 * CALIBRATE_TEST_DIMS];
+  uint32_t state = 5;
+  for (int i = 0; i < 4; i++) {
+    fill_vector(queries + i * CALIBRATE_TEST_DIMS, CALIBRATE_TEST_DIMS,
+                &state);
+  }
+  DiskAnnResult results[4 * CALIBRATE_TEST_K];
+  int n_results[4];
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_search_batch_ex(
+                            idx, queries, 4, CALIBRATE_TEST_DIMS,
+                            CALIBRATE_TEST_K, &patient, results, n_results, 1));
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL_INT(CALIBRATE_TEST_K, n_results[i]);
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Virtual table
+**************************************************************************/
+
+void test_calibrate_vtab(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_diskann_init(db, NULL, NULL));
+  exec_ok(
+      db,
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, metric=euclidean)");
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(1, X'0000803f0000000000000000'), " /* [1,0,0] */
+              "(2, X'000000000000803f00000000'), " /* [0,1,0] */
+              "(3, X'00000000000000000000803f'), " /* [0,0,1] */
+              "(4, X'0000803f0000803f00000000')"); /* [1,1,0] */
+
+  exec_ok(db, "INSERT INTO t(t) VALUES ('calibrate')");
+  TEST_ASSERT_TRUE(query_int(db, "SELECT value FROM t_metadata "
+                                 "WHERE key = 'recall_points'") > 0);
+  TEST_ASSERT_EQUAL_INT(950000, query_int(db, "SELECT value FROM t_metadata "
+                                              "WHERE key = "
+                                              "'recall_target_x1e6'"));
+
+  /* recall_target is a per-query constraint, write-only like k */
+  TEST_ASSERT_EQUAL_INT(
+      2, query_int(db, "SELECT count(*) FROM t WHERE vector MATCH "
+                       "X'0000803f0000000000000000' AND k = 2 "
+                       "AND recall_target = 0.99"));
+  TEST_ASSERT_EQUAL_INT(
+      1, query_int(db, "SELECT recall_target IS NULL FROM t WHERE vector "
+                       "MATCH X'0000803f0000000000000000' AND k = 1 "
+                       "AND recall_target = 0.5"));
+
+  char *err = NULL;
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK,
+      sqlite3_exec(db,
+                   "SELECT rowid FROM t WHERE vector MATCH "
+                   "X'0000803f0000000000000000' AND recall_target = 1.5",
+                   NULL, NULL, &err));
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NOT_NULL(strstr(err, "recall_target"));
+  sqlite3_free(err);
+
+  /* Not a metadata column name */
+  err = NULL;
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK,
+      sqlite3_exec(db,
+                   "CREATE VIRTUAL TABLE u USING diskann(dimension=3, "
+                   "recall_target REAL)",
+                   NULL, NULL, &err));
+  sqlite3_free(err);
+
+  /* Not after a DELETE in the same transaction */
+  exec_ok(db, "BEGIN");
+  exec_ok(db, "DELETE FROM t WHERE rowid = 4");
+  err = NULL;
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK, sqlite3_exec(db, "INSERT INTO t(t) VALUES ('calibrate')",
+                              NULL, NULL, &err));
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NOT_NULL(strstr(err, "'calibrate'"));
+  sqlite3_free(err);
+  exec_ok(db, "ROLLBACK");
+
+  sqlite3_close(db);
+}
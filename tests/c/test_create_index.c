@@ -107,6 +107,18 @@ void test_create_index_zero_dimensions(void) {
     sqlite3_close(db);
 }
 
+void test_create_index_invalid_metric(void) {
+  sqlite3 *db = NULL;
+  sqlite3_open(":memory:", &db);
+
+  DiskAnnConfig config = {.dimensions = 3, .metric = 99}; /* Invalid! */
+  int rc = diskann_create_index(db, "main", "test_index", &config);
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, rc);
+
+  if (db)
+    sqlite3_close(db);
+}
+
 /*
 ** Test shadow table schema is correct
 */
@@ -44,6 +44,10 @@ static DiskAnnIndex *create_and_open_test_index(sqlite3 *db, const char *name) {
   if (rc != DISKANN_OK)
     return NULL;
 
+  /* These indexes are small: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
+  /* These indexes are small: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
   return idx;
 }
 
@@ -417,4 +421,300 @@ void test_delete_zombie_edge(void) {
   sqlite3_close(db);
 }
 
+/* ========================================================================
+** Tombstone mode
+** ======================================================================== */
+
+#define TOMB_N 200
+
+/* Deterministic pseudo-random vector for id */
+static void tomb_vector(int64_t id, float *out) {
+  uint32_t x = (uint32_t)id * 2654435761u + 12345u;
+  for (int d = 0; d < TEST_DIMS; d++) {
+    x = x * 1664525u + 1013904223u;
+    out[d] = (float)(x >> 8) / (float)(1u << 24);
+  }
+}
+
+/* Index of TOMB_N graph-inserted nodes (ids 1..TOMB_N) in tombstone mode */
+static DiskAnnIndex *create_tombstone_index(sqlite3 *db,
+                                            uint32_t consolidate_at) {
+  DiskAnnIndex *idx = create_and_open_test_index(db, "test_idx");
+  TEST_ASSERT_NOT_NULL(idx);
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    float vec[TEST_DIMS];
+    tomb_vector(id, vec);
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, id, vec, TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_delete_mode(idx, DISKANN_DELETE_TOMBSTONE,
+                                            consolidate_at));
+  return idx;
+}
+
+/* Live nodes left with an edge into a deleted id (multiples of 4) */
+static int count_edges_to_deleted(DiskAnnIndex *idx) {
+  int n = 0;
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    if (id % 4 == 0) {
+      continue;
+    }
+    for (int64_t dead = 4; dead <= TOMB_N; dead += 4) {
+      n += has_edge_to(idx, id, dead) == 1;
+    }
+  }
+  return n;
+}
+
+/*
+** A tombstoned row keeps its block but no search returns it
+*/
+void test_delete_tombstone_hides_row(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 0);
+
+  for (int64_t id = 4; id <= TOMB_N; id += 4) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, id));
+  }
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_NOTFOUND, diskann_delete(idx, 4));
+  TEST_ASSERT_EQUAL(TOMB_N, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(0, diskann_node_exists(idx, 4));
+  TEST_ASSERT_EQUAL(1, diskann_node_exists(idx, 5));
+
+  for (int64_t id = 4; id <= TOMB_N; id += 4) {
+    float query[TEST_DIMS];
+    DiskAnnResult results[10];
+    tomb_vector(id, query);
+
+    int n = diskann_search(idx, query, TEST_DIMS, 10, results);
+    TEST_ASSERT_EQUAL(10, n);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_NOT_EQUAL(0, results[i].id % 4);
+    }
+    n = diskann_search_exact(idx, query, TEST_DIMS, 10, results, NULL, NULL);
+    TEST_ASSERT_EQUAL(10, n);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_NOT_EQUAL(0, results[i].id % 4);
+    }
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Consolidation deletes the rows and rewires their neighbors
+*/
+void test_delete_tombstone_consolidate(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 0);
+
+  for (int64_t id = 4; id <= TOMB_N; id += 4) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, id));
+  }
+  TEST_ASSERT_EQUAL(TOMB_N / 4, diskann_consolidate(idx));
+  TEST_ASSERT_EQUAL(TOMB_N - TOMB_N / 4, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(0, count_edges_to_deleted(idx));
+  TEST_ASSERT_EQUAL(0, diskann_consolidate(idx));
+
+  /* Every live node still reaches itself */
+  int found = 0;
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    if (id % 4 == 0) {
+      continue;
+    }
+    float query[TEST_DIMS];
+    DiskAnnResult results[1];
+    tomb_vector(id, query);
+    if (diskann_search(idx, query, TEST_DIMS, 1, results) == 1 &&
+        results[0].id == id) {
+      found++;
+    }
+  }
+  TEST_ASSERT_TRUE(found >= (TOMB_N - TOMB_N / 4) * 95 / 100);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Inserting a tombstoned id replaces the old node
+*/
+void test_delete_tombstone_reinsert(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 0);
+
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 7));
+  float vec[TEST_DIMS] = {5.0f, 5.0f, 5.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 7, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_EXISTS,
+                    diskann_insert(idx, 7, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL(1, diskann_node_exists(idx, 7));
+
+  DiskAnnResult results[1];
+  TEST_ASSERT_EQUAL(1, diskann_search(idx, vec, TEST_DIMS, 1, results));
+  TEST_ASSERT_EQUAL(7, results[0].id);
+
+  /* The purge took the tombstone off the count */
+  TEST_ASSERT_EQUAL(0, diskann_consolidate(idx));
+  TEST_ASSERT_EQUAL(TOMB_N, count_shadow_rows(db, "test_idx"));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Reaching consolidate_threshold tombstones consolidates automatically
+*/
+void test_delete_tombstone_threshold(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 10);
+
+  for (int64_t id = 4; id < 40; id += 4) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, id));
+  }
+  TEST_ASSERT_EQUAL(TOMB_N, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 40));
+  TEST_ASSERT_EQUAL(TOMB_N - 10, count_shadow_rows(db, "test_idx"));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Delete mode and threshold persist; invalid modes are rejected
+*/
+void test_delete_mode_persists(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 77);
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_set_delete_mode(idx, 9, 0));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 3));
+  diskann_close_index(idx);
+
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_open_index(db, "main", "test_idx", &idx));
+  TEST_ASSERT_EQUAL(DISKANN_DELETE_TOMBSTONE, idx->delete_mode);
+  TEST_ASSERT_EQUAL(77, idx->consolidate_at);
+  TEST_ASSERT_EQUAL(0, diskann_node_exists(idx, 3));
+  TEST_ASSERT_EQUAL(1, diskann_consolidate(idx));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* ========================================================================
+** Bulk delete
+** ======================================================================== */
+
+/*
+** diskann_delete_batch() removes every existing id in one pass and repairs
+** the graph around them
+*/
+void test_delete_batch(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_delete_mode(idx, DISKANN_DELETE_IMMEDIATE, 0));
+
+  /* Multiples of 4, one duplicate and two ids that were never inserted */
+  int64_t ids[TOMB_N / 4 + 3];
+  int n = 0;
+  for (int64_t id = 4; id <= TOMB_N; id += 4) {
+    ids[n++] = id;
+  }
+  ids[n++] = 8;
+  ids[n++] = TOMB_N + 1;
+  ids[n++] = -5;
+
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_delete_batch(NULL, ids, n));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_delete_batch(idx, NULL, 1));
+  TEST_ASSERT_EQUAL(0, diskann_delete_batch(idx, ids, 0));
+
+  /* The deleted nodes' neighbors are the ones repaired (other in-edges stay
+  ** as zombie edges, as with diskann_delete()) */
+  int repaired[TOMB_N + 1] = {0};
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    for (int64_t dead = 4; dead <= TOMB_N && id % 4 != 0; dead += 4) {
+      repaired[id] |= has_edge_to(idx, dead, id) == 1;
+    }
+  }
+
+  TEST_ASSERT_EQUAL(TOMB_N / 4, diskann_delete_batch(idx, ids, n));
+  TEST_ASSERT_EQUAL(TOMB_N - TOMB_N / 4, count_shadow_rows(db, "test_idx"));
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    for (int64_t dead = 4; dead <= TOMB_N && repaired[id]; dead += 4) {
+      TEST_ASSERT_EQUAL(0, has_edge_to(idx, id, dead));
+    }
+  }
+  TEST_ASSERT_EQUAL(0, diskann_delete_batch(idx, ids, n));
+
+  int found = 0;
+  for (int64_t id = 1; id <= TOMB_N; id++) {
+    if (id % 4 == 0) {
+      continue;
+    }
+    float query[TEST_DIMS];
+    DiskAnnResult results[1];
+    tomb_vector(id, query);
+    if (diskann_search(idx, query, TEST_DIMS, 1, results) == 1 &&
+        results[0].id == id) {
+      found++;
+    }
+  }
+  TEST_ASSERT_TRUE(found >= (TOMB_N - TOMB_N / 4) * 95 / 100);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** DISKANN_BATCH_DEFERRED_DELETES queues deletes until diskann_end_batch();
+** queued rows are hidden right away and abort discards the queue
+*/
+void test_delete_batch_deferred(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_tombstone_index(db, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_delete_mode(idx, DISKANN_DELETE_IMMEDIATE, 0));
+
+  float query[TEST_DIMS];
+  DiskAnnResult results[1];
+  tomb_vector(12, query);
+
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_begin_batch(
+                                    idx, DISKANN_BATCH_DEFERRED_DELETES));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 12));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_NOTFOUND, diskann_delete(idx, 12));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 16));
+  TEST_ASSERT_EQUAL(TOMB_N, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(0, diskann_node_exists(idx, 12));
+  TEST_ASSERT_EQUAL(1, diskann_search(idx, query, TEST_DIMS, 1, results));
+  TEST_ASSERT_NOT_EQUAL(12, results[0].id);
+
+  /* Reinserting a queued id applies the queue first */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 16, query, TEST_DIMS));
+  TEST_ASSERT_EQUAL(TOMB_N - 1, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 20));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_end_batch(idx));
+  TEST_ASSERT_EQUAL(TOMB_N - 2, count_shadow_rows(db, "test_idx"));
+  TEST_ASSERT_EQUAL(0, has_edge_to(idx, 1, 20) + has_edge_to(idx, 2, 20));
+
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_begin_batch(
+                                    idx, DISKANN_BATCH_DEFERRED_DELETES));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 24));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_abort_batch(idx));
+  TEST_ASSERT_EQUAL(1, diskann_node_exists(idx, 24));
+  TEST_ASSERT_EQUAL(TOMB_N - 2, count_shadow_rows(db, "test_idx"));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
 /* main() is in test_runner.c */
@@ -0,0 +1,330 @@
+/*
+** Tests for half-precision vector storage (vector_type = float16/bfloat16):
+** conversions, mixed-precision kernels, block layout and index recall.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_node.h"
+#include "../../src/diskann_simd.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HALF_TEST_DIMS 32
+#define HALF_TEST_N 400
+#define HALF_TEST_K 10
+#define HALF_TEST_QUERIES 20
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static uint16_t to_half(uint8_t vector_type, float f) {
+  return vector_type == DISKANN_VECTOR_FLOAT16 ? diskann_f32_to_f16(f)
+                                               : diskann_f32_to_bf16(f);
+}
+
+static float from_half(uint8_t vector_type, uint16_t h) {
+  return vector_type == DISKANN_VECTOR_FLOAT16 ? diskann_f16_to_f32(h)
+                                               : diskann_bf16_to_f32(h);
+}
+
+static DiskAnnIndex *create_half_index(sqlite3 *db, const char *name,
+                                       uint8_t vector_type, uint8_t metric) {
+  DiskAnnConfig config = {.dimensions = HALF_TEST_DIMS,
+                          .metric = metric,
+                          .max_neighbors = 16,
+                          .search_list_size = 64,
+                          .insert_list_size = 64,
+                          .vector_type = vector_type};
+  return create_index(db, name, &config);
+}
+
+/* Share of the exact float32 top-K that graph walks of the index return
+** (these indexes are small enough for the default exact scan) */
+static double recall_at_k(DiskAnnIndex *idx, const float *vectors,
+                          const float *queries) {
+  DiskAnnSearchParams graph = {.exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnStats before, after;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &before));
+  int hits = 0;
+  for (int q = 0; q < HALF_TEST_QUERIES; q++) {
+    const float *query = queries + q * HALF_TEST_DIMS;
+    DiskAnnResult results[HALF_TEST_K];
+    int n = diskann_search_ex(idx, query, HALF_TEST_DIMS, HALF_TEST_K, &graph,
+                              results, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(HALF_TEST_K, n);
+
+    /* Brute-force float32 top-K by selection */
+    float dist[HALF_TEST_N];
+    for (int i = 0; i < HALF_TEST_N; i++) {
+      dist[i] = diskann_index_distance(idx, query,
+                                       vectors + i * HALF_TEST_DIMS);
+    }
+    for (int k = 0; k < HALF_TEST_K; k++) {
+      int best = 0;
+      for (int i = 1; i < HALF_TEST_N; i++) {
+        if (dist[i] < dist[best]) {
+          best = i;
+        }
+      }
+      for (int r = 0; r < n; r++) {
+        if (results[r].id == best + 1) {
+          hits++;
+          break;
+        }
+      }
+      dist[best] = INFINITY;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &after));
+  TEST_ASSERT_TRUE_MESSAGE(after.nodes_visited > before.nodes_visited,
+                           "recall was measured without walking the graph");
+  return (double)hits / (HALF_TEST_QUERIES * HALF_TEST_K);
+}
+
+/**************************************************************************
+** Tests
+**************************************************************************/
+
+void test_half_conversions(void) {
+  /* binary16: exact values, overflow, subnormals, rounding to even */
+  TEST_ASSERT_EQUAL_HEX16(0x3c00, diskann_f32_to_f16(1.0f));
+  TEST_ASSERT_EQUAL_HEX16(0xc000, diskann_f32_to_f16(-2.0f));
+  TEST_ASSERT_EQUAL_HEX16(0x7bff, diskann_f32_to_f16(65504.0f));
+  TEST_ASSERT_EQUAL_HEX16(0x7c00, diskann_f32_to_f16(65520.0f));
+  TEST_ASSERT_EQUAL_HEX16(0xfc00, diskann_f32_to_f16(-INFINITY));
+  TEST_ASSERT_EQUAL_HEX16(0x0001, diskann_f32_to_f16(ldexpf(1.0f, -24)));
+  TEST_ASSERT_EQUAL_HEX16(0x0000, diskann_f32_to_f16(ldexpf(1.0f, -25)));
+  TEST_ASSERT_EQUAL_HEX16(0x3c00, diskann_f32_to_f16(1.0f + ldexpf(1, -11)));
+  TEST_ASSERT_EQUAL_HEX16(0x3c02,
+                          diskann_f32_to_f16(1.0f + 3.0f * ldexpf(1, -11)));
+  TEST_ASSERT_TRUE(isnan(diskann_f16_to_f32(diskann_f32_to_f16(NAN))));
+  TEST_ASSERT_EQUAL_FLOAT(ldexpf(1.0f, -24), diskann_f16_to_f32(0x0001));
+  TEST_ASSERT_EQUAL_FLOAT(65504.0f, diskann_f16_to_f32(0x7bff));
+
+  /* bfloat16: float32 exponent range, 8-bit mantissa */
+  TEST_ASSERT_EQUAL_HEX16(0x3f80, diskann_f32_to_bf16(1.0f));
+  TEST_ASSERT_EQUAL_HEX16(0x3f80, diskann_f32_to_bf16(1.0f + ldexpf(1, -8)));
+  TEST_ASSERT_EQUAL_HEX16(0x3f82,
+                          diskann_f32_to_bf16(1.0f + 3.0f * ldexpf(1, -8)));
+  TEST_ASSERT_FLOAT_WITHIN(1e30f * ldexpf(1, -8), 1e30f,
+                           diskann_bf16_to_f32(diskann_f32_to_bf16(1e30f)));
+  TEST_ASSERT_TRUE(isnan(diskann_bf16_to_f32(diskann_f32_to_bf16(NAN))));
+
+  /* Round trips stay within half an ulp */
+  uint32_t seed = 5u;
+  for (int i = 0; i < 1000; i++) {
+    float f = next_float(&seed) * 100.0f;
+    float h = diskann_f16_to_f32(diskann_f32_to_f16(f));
+    float b = diskann_bf16_to_f32(diskann_f32_to_bf16(f));
+    TEST_ASSERT_FLOAT_WITHIN(fabsf(f) * ldexpf(1, -11) + 1e-6f, f, h);
+    TEST_ASSERT_FLOAT_WITHIN(fabsf(f) * ldexpf(1, -8), f, b);
+  }
+}
+
+/* Every compiled-in level agrees with exact math on the decoded values */
+void test_half_kernels_match_scalar(void) {
+  static const uint32_t dims_list[] = {1, 3, 7, 8, 15, 16, 17, 33, 100, 769};
+  static const uint8_t types[] = {DISKANN_VECTOR_FLOAT16,
+                                  DISKANN_VECTOR_BFLOAT16};
+  float a[769];
+  uint16_t b[769];
+
+  for (int level = 0; level < DISKANN_SIMD_LEVEL_COUNT; level++) {
+    if (!diskann_simd_kernels(level)) {
+      continue;
+    }
+    for (size_t t = 0; t < sizeof(types); t++) {
+      DiskAnnHalfDistanceFn l2 =
+          diskann_simd_half_fn(level, types[t], DISKANN_METRIC_EUCLIDEAN);
+      DiskAnnHalfDistanceFn dot =
+          diskann_simd_half_fn(level, types[t], DISKANN_METRIC_COSINE);
+      TEST_ASSERT_NOT_NULL(l2);
+      TEST_ASSERT_NOT_NULL(dot);
+      for (size_t d = 0; d < sizeof(dims_list) / sizeof(dims_list[0]); d++) {
+        uint32_t dims = dims_list[d];
+        uint32_t seed = 11u * dims + (uint32_t)t;
+        double l2_ref = 0.0, dot_ref = 0.0;
+        for (uint32_t i = 0; i < dims; i++) {
+          a[i] = next_float(&seed);
+          b[i] = to_half(types[t], next_float(&seed));
+          double y = from_half(types[t], b[i]);
+          l2_ref += ((double)a[i] - y) * ((double)a[i] - y);
+          dot_ref += (double)a[i] * y;
+        }
+        char msg[64];
+        snprintf(msg, sizeof(msg), "level=%d type=%u dims=%u", level,
+                 (unsigned)types[t], (unsigned)dims);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f * (float)fmax(1.0, l2_ref),
+                                         (float)l2_ref, l2(a, b, dims), msg);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f * (float)fmax(1.0,
+                                                             fabs(dot_ref)),
+                                         (float)dot_ref, dot(a, b, dims), msg);
+      }
+    }
+  }
+  TEST_ASSERT_NULL(diskann_simd_half_fn(DISKANN_SIMD_SCALAR,
+                                        DISKANN_VECTOR_FLOAT32,
+                                        DISKANN_METRIC_EUCLIDEAN));
+}
+
+/* Node and edge slots shrink by half, so a block holds more edges */
+void test_half_block_layout(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *f32 = create_half_index(db, "f32", DISKANN_VECTOR_FLOAT32,
+                                        DISKANN_METRIC_EUCLIDEAN);
+  DiskAnnIndex *f16 = create_half_index(db, "f16", DISKANN_VECTOR_FLOAT16,
+                                        DISKANN_METRIC_EUCLIDEAN);
+  DiskAnnIndex *bf16 = create_half_index(
+      db, "bf16", DISKANN_VECTOR_BFLOAT16, DISKANN_METRIC_EUCLIDEAN);
+
+  TEST_ASSERT_EQUAL_UINT32(HALF_TEST_DIMS * 4, f32->nNodeVectorSize);
+  TEST_ASSERT_EQUAL_UINT32(HALF_TEST_DIMS * 2, f16->nNodeVectorSize);
+  TEST_ASSERT_EQUAL_UINT32(HALF_TEST_DIMS * 2, f16->nEdgeVectorSize);
+  TEST_ASSERT_EQUAL_UINT32(HALF_TEST_DIMS * 2, bf16->nEdgeVectorSize);
+  TEST_ASSERT_EQUAL_UINT32(f32->block_size, f16->block_size); /* 4 KiB floor */
+  TEST_ASSERT_EQUAL_UINT32(node_edges_max_count(f16),
+                           node_edges_max_count(bf16));
+
+  /* Edge slots are the vector plus fixed metadata: ~1.8x the edges */
+  TEST_ASSERT_TRUE(2 * node_edges_max_count(f16) >
+                   3 * node_edges_max_count(f32));
+  diskann_close_index(f32);
+  diskann_close_index(f16);
+  diskann_close_index(bf16);
+
+  DiskAnnConfig config = {.dimensions = 8,
+                          .max_neighbors = 8,
+                          .vector_type = DISKANN_VECTOR_BFLOAT16 + 1};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_create_index(db, "main", "bad", &config));
+  sqlite3_close(db);
+}
+
+/* Half-precision indexes keep recall against the float32 ground truth */
+void test_half_index_recall(void) {
+  static const uint8_t types[] = {DISKANN_VECTOR_FLOAT16,
+                                  DISKANN_VECTOR_BFLOAT16};
+  static const uint8_t metrics[] = {DISKANN_METRIC_EUCLIDEAN,
+                                    DISKANN_METRIC_COSINE};
+  float *vectors = gen_vectors(HALF_TEST_N, HALF_TEST_DIMS, 42u);
+  float *queries = gen_vectors(HALF_TEST_QUERIES, HALF_TEST_DIMS, 777u);
+
+  for (size_t t = 0; t < sizeof(types); t++) {
+    for (size_t m = 0; m < sizeof(metrics); m++) {
+      sqlite3 *db = NULL;
+      TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+      DiskAnnIndex *idx = create_half_index(db, "h", types[t], metrics[m]);
+      for (int i = 0; i < HALF_TEST_N; i++) {
+        TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                              diskann_insert(idx, i + 1,
+                                             vectors + i * HALF_TEST_DIMS,
+                                             HALF_TEST_DIMS));
+      }
+      double recall = recall_at_k(idx, vectors, queries);
+      char msg[64];
+      snprintf(msg, sizeof(msg), "type=%u metric=%u recall=%.3f",
+               (unsigned)types[t], (unsigned)metrics[m], recall);
+      TEST_ASSERT_TRUE_MESSAGE(recall >= 0.9, msg);
+
+      /* A stored vector is its own nearest neighbor, at ~0 distance */
+      DiskAnnResult top[1];
+      TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, vectors, HALF_TEST_DIMS,
+                                              1, top));
+      TEST_ASSERT_EQUAL_INT64(1, top[0].id);
+      TEST_ASSERT_FLOAT_WITHIN(1e-2f, 0.0f, top[0].distance);
+
+      /* The element type survives reopening */
+      diskann_close_index(idx);
+      TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                            diskann_open_index(db, "main", "h", &idx));
+      TEST_ASSERT_EQUAL_UINT8(types[t], idx->vector_type);
+      TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, vectors, HALF_TEST_DIMS,
+                                              1, top));
+      TEST_ASSERT_EQUAL_INT64(1, top[0].id);
+      diskann_close_index(idx);
+      sqlite3_close(db);
+    }
+  }
+  free(vectors);
+  free(queries);
+}
+
+/* A half-precision index is not readable as a pre-v5 index */
+void test_half_requires_format_version(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_half_index(db, "h", DISKANN_VECTOR_FLOAT16,
+                                        DISKANN_METRIC_EUCLIDEAN);
+  diskann_close_index(idx);
+
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_exec(db,
+                                     "UPDATE h_metadata SET value = 4 "
+                                     "WHERE key = 'format_version'",
+                                     NULL, NULL, NULL));
+  idx = NULL;
+  TEST_ASSERT_NOT_EQUAL(DISKANN_OK, diskann_open_index(db, "main", "h", &idx));
+  TEST_ASSERT_NULL(idx);
+
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_exec(db,
+                                     "UPDATE h_metadata SET value = 5 "
+                                     "WHERE key = 'format_version';"
+                                     "UPDATE h_metadata SET value = 9 "
+                                     "WHERE key = 'vector_type'",
+                                     NULL, NULL, NULL));
+  TEST_ASSERT_NOT_EQUAL(DISKANN_OK, diskann_open_index(db, "main", "h", &idx));
+  sqlite3_close(db);
+}
+
+#ifdef _WIN32
+#define HALF_SNAPSHOT_FILE "diskann_test_half_snapshot.bin"
+#else
+#define HALF_SNAPSHOT_FILE "/tmp/diskann_test_half_snapshot.bin"
+#endif
+
+/* Bulk build, PQ routing and snapshots read the stored halves too */
+void test_half_build_pq_snapshot(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  float *vectors = gen_vectors(HALF_TEST_N, HALF_TEST_DIMS, 9u);
+  float *queries = gen_vectors(HALF_TEST_QUERIES, HALF_TEST_DIMS, 99u);
+  DiskAnnIndex *idx = create_half_index(db, "h", DISKANN_VECTOR_BFLOAT16,
+                                        DISKANN_METRIC_EUCLIDEAN);
+  for (int i = 0; i < HALF_TEST_N; i++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert_vector(idx, i + 1,
+                                                vectors + i * HALF_TEST_DIMS,
+                                                HALF_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_build(idx, NULL));
+  TEST_ASSERT_TRUE(recall_at_k(idx, vectors, queries) >= 0.9);
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_build(idx, 8, 0));
+  TEST_ASSERT_TRUE(recall_at_k(idx, vectors, queries) >= 0.85);
+
+  remove(HALF_SNAPSHOT_FILE);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_export_snapshot(idx, HALF_SNAPSHOT_FILE));
+  DiskAnnIndex *snap = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_snapshot(HALF_SNAPSHOT_FILE, &snap));
+  TEST_ASSERT_EQUAL_UINT8(DISKANN_VECTOR_BFLOAT16, snap->vector_type);
+  TEST_ASSERT_TRUE(recall_at_k(snap, vectors, queries) >= 0.9);
+
+  diskann_close_index(snap);
+  diskann_close_index(idx);
+  remove(HALF_SNAPSHOT_FILE);
+  free(vectors);
+  free(queries);
+  sqlite3_close(db);
+}
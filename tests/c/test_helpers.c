@@ -0,0 +1,62 @@
+/*
+** Shared fixtures for the C unit tests (see test_helpers.h)
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+float next_float(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (float)(*state >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+void fill_vector(float *v, uint32_t dims, uint32_t *state) {
+  for (uint32_t i = 0; i < dims; i++) {
+    v[i] = next_float(state);
+  }
+}
+
+float *gen_vectors(int n, uint32_t dims, uint32_t seed) {
+  float *v = malloc((size_t)n * dims * sizeof(float));
+  TEST_ASSERT_NOT_NULL(v);
+  fill_vector(v, (uint32_t)n * dims, &seed);
+  return v;
+}
+
+DiskAnnIndex *create_index(sqlite3 *db, const char *name,
+                           const DiskAnnConfig *config) {
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_create_index(db, "main", name, config));
+  DiskAnnIndex *idx = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_index(db, "main", name, &idx));
+  return idx;
+}
+
+DiskAnnIndex *build_index(sqlite3 *db, const DiskAnnConfig *config, int n,
+                          uint32_t seed) {
+  DiskAnnIndex *idx = create_index(db, "idx", config);
+  float *v = malloc(config->dimensions * sizeof(float));
+  TEST_ASSERT_NOT_NULL(v);
+  for (int i = 1; i <= n; i++) {
+    fill_vector(v, config->dimensions, &seed);
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(idx, i, v, config->dimensions));
+  }
+  free(v);
+  return idx;
+}
+
+void exec_ok(sqlite3 *db, const char *sql) {
+  char *err = NULL;
+  int rc = sqlite3_exec(db, sql, NULL, NULL, &err);
+  if (err) {
+    fprintf(stderr, "SQL error: %s\nSQL: %s\n", err, sql);
+    sqlite3_free(err);
+  }
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, rc);
+}
@@ -0,0 +1,36 @@
+/*
+** Shared fixtures for the C unit tests: deterministic random vectors,
+** index setup, and SQL that must succeed.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "../../src/diskann.h"
+#include <sqlite3.h>
+#include <stdint.h>
+
+/* Deterministic pseudo-random in [-1, 1) (LCG, independent of rand()) */
+float next_float(uint32_t *state);
+
+/* dims values from next_float(state) into v */
+void fill_vector(float *v, uint32_t dims, uint32_t *state);
+
+/* n vectors of dims values from seed, back to back (malloc'd) */
+float *gen_vectors(int n, uint32_t dims, uint32_t seed);
+
+/* Create index name in "main" with config and open it */
+DiskAnnIndex *create_index(sqlite3 *db, const char *name,
+                           const DiskAnnConfig *config);
+
+/* create_index() "idx", then diskann_insert() n vectors from seed with
+** ids 1..n */
+DiskAnnIndex *build_index(sqlite3 *db, const DiskAnnConfig *config, int n,
+                          uint32_t seed);
+
+/* sqlite3_exec() sql, reporting SQLite's message if it fails */
+void exec_ok(sqlite3 *db, const char *sql);
+
+#endif /* TEST_HELPERS_H */
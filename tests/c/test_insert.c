@@ -40,6 +40,8 @@ static DiskAnnIndex *create_and_open(sqlite3 *db, const char *name,
   if (rc != DISKANN_OK)
     return NULL;
 
+  /* These indexes are small: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
   return idx;
 }
 
@@ -664,12 +666,12 @@ void test_batch_insert_after_end(void) {
 
 void test_deferred_edge_list_lifecycle(void) {
   DeferredEdgeList list = {0};
-  int rc = deferred_edge_list_init(&list, 100, 3 * sizeof(float));
+  int rc = deferred_edge_list_init(&list, 4096, 3 * sizeof(float));
   TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
-  TEST_ASSERT_NOT_NULL(list.edges);
   TEST_ASSERT_EQUAL_INT(0, list.count);
-  TEST_ASSERT_EQUAL_INT(100, list.capacity);
+  TEST_ASSERT_EQUAL_UINT64(4096, list.budget);
   TEST_ASSERT_EQUAL_UINT32(12, list.vector_size);
+  TEST_ASSERT_EQUAL_UINT64(0, deferred_edge_list_bytes(&list));
 
   /* Add 5 edges */
   float vec1[] = {1.0f, 2.0f, 3.0f};
@@ -680,71 +682,88 @@ void test_deferred_edge_list_lifecycle(void) {
     TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
   }
   TEST_ASSERT_EQUAL_INT(5, list.count);
+  TEST_ASSERT_EQUAL_UINT32(5, list.n_vectors);
 
   /* Verify data integrity */
   TEST_ASSERT_EQUAL_INT64(100, list.edges[0].target_rowid);
   TEST_ASSERT_EQUAL_INT64(200, list.edges[0].inserted_rowid);
   TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, list.edges[0].distance);
   /* Vector is a copy, not the original */
-  TEST_ASSERT_NOT_EQUAL(vec1, list.edges[0].vector);
-  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, list.edges[0].vector[0]);
+  const float *copy = deferred_edge_vector(&list, &list.edges[1]);
+  TEST_ASSERT_TRUE(copy != vec2);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, copy[0]);
 
   deferred_edge_list_deinit(&list);
   TEST_ASSERT_NULL(list.edges);
+  TEST_ASSERT_NULL(list.vectors);
   TEST_ASSERT_EQUAL_INT(0, list.count);
 }
 
-void test_deferred_edge_list_capacity(void) {
+void test_deferred_edge_list_shared_vectors(void) {
   DeferredEdgeList list = {0};
-  int rc = deferred_edge_list_init(&list, 10, 3 * sizeof(float));
+  int rc = deferred_edge_list_init(&list, 4096, 3 * sizeof(float));
   TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
 
+  /* 30 back-edges of one insert keep one vector copy */
   float vec[] = {1.0f, 0.0f, 0.0f};
-  /* Fill to capacity */
-  for (int i = 0; i < 10; i++) {
-    rc = deferred_edge_list_add(&list, i, i + 100, 1.0f, vec);
+  for (int i = 0; i < 30; i++) {
+    rc = deferred_edge_list_add(&list, i, 500, 1.0f, vec);
     TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
   }
-  TEST_ASSERT_EQUAL_INT(10, list.count);
+  TEST_ASSERT_EQUAL_INT(30, list.count);
+  TEST_ASSERT_EQUAL_UINT32(1, list.n_vectors);
+  TEST_ASSERT_EQUAL_UINT64(30 * sizeof(DeferredEdge) + 12,
+                           deferred_edge_list_bytes(&list));
 
-  /* 11th add should return error (at capacity) */
-  rc = deferred_edge_list_add(&list, 99, 199, 1.0f, vec);
-  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR, rc);
-  TEST_ASSERT_EQUAL_INT(10, list.count); /* Count unchanged */
+  /* The same id with a new vector (deleted and reinserted) gets a slot */
+  float vec2[] = {0.0f, 1.0f, 0.0f};
+  rc = deferred_edge_list_add(&list, 99, 500, 1.0f, vec2);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL_UINT32(2, list.n_vectors);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f,
+                           deferred_edge_vector(&list, &list.edges[30])[1]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f,
+                           deferred_edge_vector(&list, &list.edges[29])[0]);
+
+  /* Invalid arguments */
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        deferred_edge_list_init(&list, 0, 12));
 
   deferred_edge_list_deinit(&list);
 }
 
 void test_deferred_edge_list_truncate(void) {
   DeferredEdgeList list = {0};
-  int rc = deferred_edge_list_init(&list, 100, 3 * sizeof(float));
+  int rc = deferred_edge_list_init(&list, 4096, 3 * sizeof(float));
   TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
 
   float vec[] = {1.0f, 2.0f, 3.0f};
   for (int i = 0; i < 8; i++) {
-    rc = deferred_edge_list_add(&list, i, i + 100, 1.0f, vec);
+    /* Two edges per inserted node */
+    rc = deferred_edge_list_add(&list, i, i / 2 + 100, 1.0f, vec);
     TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
   }
   TEST_ASSERT_EQUAL_INT(8, list.count);
+  TEST_ASSERT_EQUAL_UINT32(4, list.n_vectors);
 
-  /* Truncate to 5 — entries 5-7 freed */
+  /* Truncate to 5 — entries 5-7 dropped, slot 2 still used by entry 4 */
   deferred_edge_list_truncate(&list, 5);
   TEST_ASSERT_EQUAL_INT(5, list.count);
+  TEST_ASSERT_EQUAL_UINT32(3, list.n_vectors);
 
   /* Original 5 entries still valid */
   TEST_ASSERT_EQUAL_INT64(4, list.edges[4].target_rowid);
 
-  /* Truncated entries have NULL vectors */
-  TEST_ASSERT_NULL(list.edges[5].vector);
-  TEST_ASSERT_NULL(list.edges[6].vector);
-  TEST_ASSERT_NULL(list.edges[7].vector);
+  deferred_edge_list_truncate(&list, 0);
+  TEST_ASSERT_EQUAL_INT(0, list.count);
+  TEST_ASSERT_EQUAL_UINT64(0, deferred_edge_list_bytes(&list));
 
   deferred_edge_list_deinit(&list);
 }
 
 void test_deferred_edge_list_empty_deinit(void) {
   DeferredEdgeList list = {0};
-  int rc = deferred_edge_list_init(&list, 100, 3 * sizeof(float));
+  int rc = deferred_edge_list_init(&list, 4096, 3 * sizeof(float));
   TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
 
   /* Deinit immediately (no adds) — should not crash */
@@ -1149,7 +1168,7 @@ void test_lazy_batch_single_insert(void) {
 ** Spillover test
 **************************************************************************/
 
-void test_lazy_batch_spillover(void) {
+void test_lazy_batch_budget_repair(void) {
   sqlite3 *db = open_db();
   DiskAnnConfig cfg = {.dimensions = TEST_DIMS,
                        .metric = DISKANN_METRIC_EUCLIDEAN,
@@ -1157,34 +1176,51 @@ void test_lazy_batch_spillover(void) {
                        .search_list_size = 20,
                        .insert_list_size = 30,
                        .block_size = 0};
-  DiskAnnIndex *idx = create_and_open(db, "test_lazy_spill", &cfg);
+  DiskAnnIndex *idx = create_and_open(db, "test_lazy_budget", &cfg);
   TEST_ASSERT_NOT_NULL(idx);
 
-  diskann_begin_batch(idx, DISKANN_BATCH_DEFERRED_EDGES);
+  TEST_ASSERT_EQUAL_INT(
+      DISKANN_ERROR_INVALID,
+      diskann_begin_batch_budget(idx, DISKANN_BATCH_DEFERRED_EDGES, 0));
 
-  /* Artificially reduce capacity to force spillover */
+  /* Room for a few edges only: most inserts repair a chunk early */
+  int rc = diskann_begin_batch_budget(idx, DISKANN_BATCH_DEFERRED_EDGES, 128);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
   TEST_ASSERT_NOT_NULL(idx->deferred_edges);
-  idx->deferred_edges->capacity = 5; /* Very small — will overflow quickly */
 
-  /* Insert enough to trigger spillover */
   for (int i = 1; i <= 30; i++) {
     float vec[] = {(float)i, (float)(i % 3), 0.0f};
-    int rc = diskann_insert(idx, (int64_t)i, vec, TEST_DIMS);
+    rc = diskann_insert(idx, (int64_t)i, vec, TEST_DIMS);
     TEST_ASSERT_EQUAL_INT_MESSAGE(DISKANN_OK, rc,
-                                  "insert with spillover should succeed");
+                                  "insert with early repair should succeed");
+    TEST_ASSERT_TRUE(deferred_edge_list_bytes(idx->deferred_edges) < 128);
   }
 
-  diskann_end_batch(idx);
+  /* Node 1 already links forward: its back-edges were applied mid-batch */
+  BlobSpot *spot = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        blob_spot_create(idx, &spot, 1, idx->block_size,
+                                         DISKANN_BLOB_READONLY));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, blob_spot_reload(idx, spot, 1,
+                                                     idx->block_size));
+  TEST_ASSERT_TRUE(node_bin_edges(idx, spot) > 0);
+  blob_spot_free(spot);
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(idx));
 
   /* All 30 rows present */
-  TEST_ASSERT_EQUAL_INT(30, count_shadow_rows(db, "test_lazy_spill"));
+  TEST_ASSERT_EQUAL_INT(30, count_shadow_rows(db, "test_lazy_budget"));
 
-  /* Search still works */
-  float query[] = {15.0f, 0.0f, 0.0f};
-  DiskAnnResult results[3];
-  int n = diskann_search(idx, query, TEST_DIMS, 3, results);
-  TEST_ASSERT_TRUE(n >= 1);
-  TEST_ASSERT_EQUAL_INT64(15, results[0].id);
+  /* Rows linked before their chunk's back-edges were applied can end up
+  ** with no in-edges at this scale, so a walk may stop one row short; it
+  ** still ends in the queried row's neighborhood */
+  for (int i = 1; i <= 30; i++) {
+    float query[] = {(float)i, (float)(i % 3), 0.0f};
+    DiskAnnResult results[3];
+    int n = diskann_search(idx, query, TEST_DIMS, 3, results);
+    TEST_ASSERT_TRUE(n >= 1);
+    TEST_ASSERT_TRUE(llabs(results[0].id - i) <= 2);
+  }
 
   diskann_close_index(idx);
   sqlite3_close(db);
@@ -1287,3 +1323,385 @@ void test_insert_cosine_metric(void) {
   diskann_close_index(idx);
   sqlite3_close(db);
 }
+
+void test_insert_dot_metric(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = TEST_DIMS,
+                       .metric = DISKANN_METRIC_DOT,
+                       .max_neighbors = 8,
+                       .search_list_size = 20,
+                       .insert_list_size = 30,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_dot", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  /* Inner product rewards magnitude: v3 is farther in L2 from the query
+  ** than v1 but has the largest dot product */
+  float v1[] = {1.0f, 0.0f, 0.0f};
+  float v2[] = {0.0f, 1.0f, 0.0f};
+  float v3[] = {3.0f, 2.0f, 0.0f};
+  float v4[] = {-1.0f, 0.5f, 0.0f};
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, 1, v1, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, 2, v2, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, 3, v3, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, 4, v4, TEST_DIMS));
+
+  float query[] = {1.0f, 0.2f, 0.0f};
+  DiskAnnResult results[4];
+  int n = diskann_search(idx, query, TEST_DIMS, 4, results);
+  TEST_ASSERT_EQUAL_INT(4, n);
+  TEST_ASSERT_EQUAL_INT64(3, results[0].id);
+  /* Distance is the negated inner product */
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -3.4f, results[0].distance);
+  TEST_ASSERT_EQUAL_INT64(4, results[3].id);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_insert_cosine_distance_matches_exact(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = TEST_DIMS,
+                       .metric = DISKANN_METRIC_COSINE,
+                       .max_neighbors = 8,
+                       .search_list_size = 20,
+                       .insert_list_size = 30,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_cos_norm", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  /* Unnormalized vectors: stored norms must reproduce exact cosine */
+  float vecs[20][TEST_DIMS];
+  for (int i = 0; i < 20; i++) {
+    vecs[i][0] = (float)(i + 1) * 0.5f;
+    vecs[i][1] = (float)((i * 7) % 11) - 5.0f;
+    vecs[i][2] = (float)((i * 3) % 5) + 0.25f;
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(idx, i + 1, vecs[i], TEST_DIMS));
+  }
+
+  float query[] = {2.0f, -1.0f, 0.5f};
+  DiskAnnResult results[5];
+  int n = diskann_search(idx, query, TEST_DIMS, 5, results);
+  TEST_ASSERT_EQUAL_INT(5, n);
+  for (int i = 0; i < n; i++) {
+    float exact =
+        diskann_distance_cosine(query, vecs[results[i].id - 1], TEST_DIMS);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, exact, results[i].distance);
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Pairwise distance memo
+**************************************************************************/
+
+extern DiskAnnDistMemo *dist_memo_acquire(DiskAnnIndex *idx);
+extern void dist_memo_clear(DiskAnnDistMemo *memo);
+extern int dist_memo_get(DiskAnnDistMemo *memo, uint64_t a, uint64_t b,
+                         float *out);
+extern void dist_memo_put(DiskAnnDistMemo *memo, uint64_t a, uint64_t b,
+                          float distance);
+
+void test_dist_memo_basic(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = TEST_DIMS,
+                       .metric = DISKANN_METRIC_EUCLIDEAN,
+                       .max_neighbors = 8,
+                       .search_list_size = 20,
+                       .insert_list_size = 30,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_memo", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  DiskAnnDistMemo *memo = dist_memo_acquire(idx);
+  TEST_ASSERT_NOT_NULL(memo);
+  TEST_ASSERT_EQUAL_PTR(memo, dist_memo_acquire(idx));
+
+  /* Pairs are unordered */
+  float d = -1.0f;
+  TEST_ASSERT_EQUAL_INT(0, dist_memo_get(memo, 3, 7, &d));
+  dist_memo_put(memo, 7, 3, 2.5f);
+  TEST_ASSERT_EQUAL_INT(1, dist_memo_get(memo, 3, 7, &d));
+  TEST_ASSERT_EQUAL_FLOAT(2.5f, d);
+  TEST_ASSERT_EQUAL_INT(0, dist_memo_get(memo, 3, 8, &d));
+
+  /* Grows past its initial capacity, and forgets everything on clear */
+  for (uint64_t i = 0; i < 5000; i++) {
+    dist_memo_put(memo, i, i + 1000000, (float)i);
+  }
+  for (uint64_t i = 0; i < 5000; i++) {
+    TEST_ASSERT_EQUAL_INT(1, dist_memo_get(memo, i + 1000000, i, &d));
+    TEST_ASSERT_EQUAL_FLOAT((float)i, d);
+  }
+  dist_memo_clear(memo);
+  TEST_ASSERT_EQUAL_INT(0, dist_memo_get(memo, 3, 7, &d));
+  TEST_ASSERT_EQUAL_INT(0, dist_memo_get(memo, 0, 1000000, &d));
+
+  /* A full memo drops new pairs and keeps answering for the old ones */
+  for (uint64_t i = 0; i < 100000; i++) {
+    dist_memo_put(memo, i, i + 1, 1.0f);
+  }
+  TEST_ASSERT_EQUAL_INT(1, dist_memo_get(memo, 0, 1, &d));
+  TEST_ASSERT_EQUAL_INT(0, dist_memo_get(memo, 99999, 100000, &d));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* Every stored edge distance of rows 1..n is the exact distance between
+** the two rows' vectors */
+static void assert_edge_distances_exact(DiskAnnIndex *idx,
+                                        const float (*vecs)[TEST_DIMS],
+                                        int n) {
+  for (int i = 1; i <= n; i++) {
+    BlobSpot *spot = NULL;
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          blob_spot_create(idx, &spot, (uint64_t)i,
+                                           idx->block_size,
+                                           DISKANN_BLOB_READONLY));
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, blob_spot_reload(idx, spot, (uint64_t)i,
+                                                       idx->block_size));
+    int n_edges = (int)node_bin_edges(idx, spot);
+    TEST_ASSERT_TRUE(n_edges > 0);
+    for (int e = 0; e < n_edges; e++) {
+      uint64_t to;
+      float distance;
+      node_bin_edge(idx, spot, e, &to, &distance, NULL);
+      TEST_ASSERT_TRUE(to >= 1 && to <= (uint64_t)n);
+      float exact = diskann_distance_l2(vecs[i - 1], vecs[to - 1], TEST_DIMS);
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, exact, distance);
+    }
+    blob_spot_free(spot);
+  }
+}
+
+void test_insert_memo_edge_distances(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = TEST_DIMS,
+                       .metric = DISKANN_METRIC_EUCLIDEAN,
+                       .max_neighbors = 8,
+                       .search_list_size = 20,
+                       .insert_list_size = 30,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_memo_single", &cfg);
+  DiskAnnIndex *lazy = create_and_open(db, "test_memo_lazy", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_NOT_NULL(lazy);
+
+  /* Memoized distances (walk scores, replace-then-prune pairs, deferred
+  ** repairs) must land on the right rowid pairs */
+  float vecs[80][TEST_DIMS];
+  for (int i = 0; i < 80; i++) {
+    vecs[i][0] = (float)((i * 37) % 23) * 0.5f;
+    vecs[i][1] = (float)((i * 11) % 17) - 8.0f;
+    vecs[i][2] = (float)(i % 7) * 0.75f;
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_begin_batch(lazy,
+                                            DISKANN_BATCH_DEFERRED_EDGES));
+  for (int i = 0; i < 80; i++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(idx, i + 1, vecs[i], TEST_DIMS));
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(lazy, i + 1, vecs[i], TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(lazy));
+  TEST_ASSERT_NOT_NULL(idx->dist_memo);
+
+  assert_edge_distances_exact(idx, (const float (*)[TEST_DIMS])vecs, 80);
+  assert_edge_distances_exact(lazy, (const float (*)[TEST_DIMS])vecs, 80);
+
+  diskann_close_index(idx);
+  diskann_close_index(lazy);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** diskann_insert_batch() tests
+**************************************************************************/
+
+#define ARRAY_DIMS 8
+
+/* n vectors in 10 tight clusters, like photos from a few events */
+static void clustered_vectors(float *out, int n, unsigned int seed) {
+  srand(seed);
+  float centers[10][ARRAY_DIMS];
+  for (int c = 0; c < 10; c++) {
+    for (int d = 0; d < ARRAY_DIMS; d++) {
+      centers[c][d] = (float)rand() / (float)RAND_MAX * 10.0f;
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    for (int d = 0; d < ARRAY_DIMS; d++) {
+      out[i * ARRAY_DIMS + d] =
+          centers[i % 10][d] + (float)rand() / (float)RAND_MAX * 0.5f;
+    }
+  }
+}
+
+static int cmp_float(const void *a, const void *b) {
+  float x = *(const float *)a;
+  float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+/* Recall@10 of graph searches for the first n_queries of vectors[0..n):
+** a result counts when it is no farther than the true 10th nearest */
+static float graph_recall(DiskAnnIndex *idx, const float *vectors, int n,
+                          int n_queries) {
+  int k = 10;
+  int hits = 0;
+  float *dist = (float *)malloc((size_t)n * sizeof(float));
+  TEST_ASSERT_NOT_NULL(dist);
+  for (int q = 0; q < n_queries; q++) {
+    const float *query = vectors + q * ARRAY_DIMS;
+    for (int i = 0; i < n; i++) {
+      dist[i] = diskann_distance_l2(query, vectors + i * ARRAY_DIMS,
+                                    ARRAY_DIMS);
+    }
+    qsort(dist, (size_t)n, sizeof(float), cmp_float);
+    DiskAnnResult results[10];
+    int found = diskann_search(idx, query, ARRAY_DIMS, k, results);
+    TEST_ASSERT_EQUAL_INT(k, found);
+    for (int r = 0; r < k; r++) {
+      if (results[r].distance <= dist[k - 1] + 1e-5f) {
+        hits++;
+      }
+    }
+  }
+  free(dist);
+  return (float)hits / (float)(n_queries * k);
+}
+
+void test_insert_batch_empty_index(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = ARRAY_DIMS,
+                       .metric = DISKANN_METRIC_EUCLIDEAN,
+                       .max_neighbors = 16,
+                       .search_list_size = 40,
+                       .insert_list_size = 40,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_array", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  int n = 300;
+  int64_t ids[300];
+  float *vectors = (float *)malloc((size_t)n * ARRAY_DIMS * sizeof(float));
+  TEST_ASSERT_NOT_NULL(vectors);
+  clustered_vectors(vectors, n, 7);
+  for (int i = 0; i < n; i++) {
+    ids[i] = 1000 + i;
+  }
+
+  /* Argument checks */
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_insert_batch(NULL, ids, vectors, n,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_insert_batch(idx, NULL, vectors, n,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_DIMENSION,
+                        diskann_insert_batch(idx, ids, vectors, n, 3));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_batch(idx, ids, vectors, 0,
+                                             ARRAY_DIMS));
+
+  int rc = diskann_insert_batch(idx, ids, vectors, n, ARRAY_DIMS);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL_INT(n, count_shadow_rows(db, "test_array"));
+  TEST_ASSERT_NULL(idx->batch_cache); /* Own batch mode ended */
+
+  /* Every node got linked, and the graph finds near neighbors */
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(get_edge_count(idx, ids[i]) > 0);
+  }
+  float recall = graph_recall(idx, vectors, n, 50);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.9f, "array insert recall too low");
+
+  free(vectors);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_insert_batch_existing_index(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = {.dimensions = ARRAY_DIMS,
+                       .metric = DISKANN_METRIC_EUCLIDEAN,
+                       .max_neighbors = 16,
+                       .search_list_size = 40,
+                       .insert_list_size = 40,
+                       .block_size = 0};
+  DiskAnnIndex *idx = create_and_open(db, "test_array2", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  int n = 400;
+  int64_t ids[400];
+  float *vectors = (float *)malloc((size_t)n * ARRAY_DIMS * sizeof(float));
+  TEST_ASSERT_NOT_NULL(vectors);
+  clustered_vectors(vectors, n, 11);
+  for (int i = 0; i < n; i++) {
+    ids[i] = i + 1;
+  }
+
+  /* 200 one at a time, then two arrays, the second in the caller's lazy
+  ** batch */
+  for (int i = 0; i < 200; i++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, ids[i],
+                                                     vectors + i * ARRAY_DIMS,
+                                                     ARRAY_DIMS));
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_batch(idx, ids + 200,
+                                             vectors + 200 * ARRAY_DIMS, 100,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_begin_batch(idx, DISKANN_BATCH_DEFERRED_EDGES));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_batch(idx, ids + 300,
+                                             vectors + 300 * ARRAY_DIMS, 100,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_NOT_NULL(idx->batch_cache); /* Caller's batch stays open */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(idx));
+  TEST_ASSERT_EQUAL_INT(n, count_shadow_rows(db, "test_array2"));
+
+  /* Query with the array-inserted vectors */
+  float recall = graph_recall(idx, vectors, n, 50);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.9f, "array insert recall too low");
+  int hits = 0;
+  for (int i = 200; i < n; i++) {
+    DiskAnnResult result;
+    if (diskann_search(idx, vectors + i * ARRAY_DIMS, ARRAY_DIMS, 1,
+                       &result) == 1 &&
+        result.id == ids[i]) {
+      hits++;
+    }
+  }
+  TEST_ASSERT_TRUE(hits >= 190);
+
+  /* A live id, or one repeated in the array, fails the whole call */
+  int64_t dup_ids[3] = {5000, 5001, 5000};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_EXISTS,
+                        diskann_insert_batch(idx, dup_ids, vectors, 3,
+                                             ARRAY_DIMS));
+  int64_t live_ids[2] = {6000, 7};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_EXISTS,
+                        diskann_insert_batch(idx, live_ids, vectors, 2,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_EQUAL_INT(n, count_shadow_rows(db, "test_array2"));
+  TEST_ASSERT_EQUAL_INT(0, diskann_node_exists(idx, 5000));
+
+  /* A deleted id can be reused */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(idx, 7));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert_batch(idx, live_ids, vectors, 2,
+                                             ARRAY_DIMS));
+  TEST_ASSERT_EQUAL_INT(n + 1, count_shadow_rows(db, "test_array2"));
+
+  free(vectors);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
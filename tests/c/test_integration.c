@@ -7,6 +7,7 @@
 ** 1. REOPEN PERSISTENCE — close and reopen index, verify data survives
 ** 2. CLEAR THEN REINSERT — clear wipes vectors, reinsertion works
 ** 3. HIGHER-DIM RECALL — 200 vectors at 128D, brute-force comparison
+**    (float32 and INT8 edge vectors, PQ routing codes)
 ** 4. DELETE AT SCALE — insert 50, delete 10, verify search quality
 **
 ** All tests use 128D vectors (realistic for embeddings) with seeded
@@ -16,12 +17,16 @@
 ** MIT License
 */
 #include "unity/unity.h"
+#include <math.h>
 #include <sqlite3.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../../src/diskann.h"
+#include "../../src/diskann_blob.h"
+#include "../../src/diskann_internal.h"
 #include "../../src/diskann_node.h"
+#include "../../src/diskann_pq.h"
 
 /*
 ** 128D config: block_size=16384 gives max_edges=30, plenty for
@@ -67,6 +72,10 @@ static DiskAnnIndex *create_and_open(sqlite3 *db, const char *name,
   if (rc != DISKANN_OK)
     return NULL;
 
+  /* These indexes are small: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
+  /* These indexes are small: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
   return idx;
 }
 
@@ -138,6 +147,65 @@ static void brute_force_knn(const float *vectors, int n_vectors,
   free(indices);
 }
 
+/*
+** Average recall@k of diskann_search() against brute force over n_queries
+** queries. If max_dist_err is non-NULL, also reports the largest difference
+** between a returned distance and the exact L2 distance for that id.
+*/
+static float measure_recall(DiskAnnIndex *idx, const float *vectors,
+                            int n_vectors, const float *queries,
+                            int n_queries, int k, float *max_dist_err) {
+  int total_hits = 0;
+  int total_possible = 0;
+  DiskAnnStats before, after;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &before));
+
+  for (int q = 0; q < n_queries; q++) {
+    const float *query = queries + (size_t)q * INTEG_DIMS;
+
+    /* Brute-force reference */
+    int64_t bf_ids[10];
+    float bf_dists[10];
+    brute_force_knn(vectors, n_vectors, query, k, bf_ids, bf_dists);
+
+    /* ANN search */
+    DiskAnnResult ann_results[10];
+    int n = diskann_search(idx, query, INTEG_DIMS, k, ann_results);
+    TEST_ASSERT_TRUE_MESSAGE(n > 0, "search returned 0 results");
+
+    /* Count hits: how many of the true top-k are in the ANN results? */
+    int actual_k = k < n ? k : n;
+    for (int i = 0; i < actual_k; i++) {
+      for (int j = 0; j < n; j++) {
+        if (bf_ids[i] == ann_results[j].id) {
+          total_hits++;
+          break;
+        }
+      }
+    }
+    total_possible += actual_k;
+
+    if (max_dist_err) {
+      for (int j = 0; j < n; j++) {
+        const float *v =
+            vectors + (size_t)(ann_results[j].id - 1) * INTEG_DIMS;
+        float err = fabsf(diskann_distance_l2(query, v, INTEG_DIMS) -
+                          ann_results[j].distance);
+        if (err > *max_dist_err) {
+          *max_dist_err = err;
+        }
+      }
+    }
+  }
+
+  /* Recall of an exact scan says nothing about the graph */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &after));
+  TEST_ASSERT_TRUE_MESSAGE(after.nodes_visited > before.nodes_visited,
+                           "recall was measured without walking the graph");
+
+  return (float)total_hits / (float)total_possible;
+}
+
 /**************************************************************************
 ** 1. Reopen persistence
 **
@@ -300,44 +368,253 @@ void test_integration_recall_128d(void) {
   /* Generate query vectors (different seed so they're not in the index) */
   float *queries = gen_vectors(n_queries, 67890);
 
-  int total_hits = 0;
-  int total_possible = 0;
+  float recall =
+      measure_recall(idx, vectors, n_vectors, queries, n_queries, k, NULL);
 
-  for (int q = 0; q < n_queries; q++) {
-    float *query = queries + (size_t)q * INTEG_DIMS;
+  /* With 200 vectors, 128D, max_neighbors=16, recall should be >= 80% */
+  char msg[128];
+  snprintf(msg, sizeof(msg), "recall@%d = %.1f%% (expected >= 80%%)", k,
+           (double)recall * 100.0);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.8f, msg);
 
-    /* Brute-force reference */
-    int64_t bf_ids[10];
-    float bf_dists[10];
-    brute_force_knn(vectors, n_vectors, query, k, bf_ids, bf_dists);
+  diskann_close_index(idx);
+  free(vectors);
+  free(queries);
+  sqlite3_close(db);
+}
 
-    /* ANN search */
-    DiskAnnResult ann_results[10];
-    int n = diskann_search(idx, query, INTEG_DIMS, k, ann_results);
-    TEST_ASSERT_TRUE_MESSAGE(n > 0, "search returned 0 results");
+/**************************************************************************
+** 3b. INT8 edge vectors
+**
+** Same workload as 3 with quantized edge slots: blocks shrink ~4x, recall
+** must stay within a few points, and reranking must return exact float32
+** distances.
+**************************************************************************/
 
-    /* Count hits: how many of the true top-k are in the ANN results? */
-    int actual_k = k < n ? k : n;
-    for (int i = 0; i < actual_k; i++) {
-      for (int j = 0; j < n; j++) {
-        if (bf_ids[i] == ann_results[j].id) {
-          total_hits++;
-          break;
-        }
-      }
-    }
-    total_possible += actual_k;
+void test_integration_recall_int8_edges(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = integ_config();
+  cfg.block_size = 0; /* auto-size for the smaller edge slots */
+  cfg.edge_type = DISKANN_EDGE_INT8;
+  cfg.quant_min = 0.0f; /* gen_vectors() produces [0, 1) */
+  cfg.quant_max = 1.0f;
+  DiskAnnIndex *idx = create_and_open(db, "test_recall_int8", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL_UINT8(DISKANN_EDGE_INT8, idx->edge_type);
+  TEST_ASSERT_EQUAL_UINT32(INTEG_DIMS, idx->nEdgeVectorSize);
+  TEST_ASSERT_TRUE(idx->block_size < INTEG_BLOCK_SIZE / 2);
+
+  int n_vectors = 200;
+  int n_queries = 20;
+  int k = 10;
+  float *vectors = gen_vectors(n_vectors, 12345);
+  for (int i = 0; i < n_vectors; i++) {
+    int rc = diskann_insert(idx, (int64_t)(i + 1),
+                            vectors + (size_t)i * INTEG_DIMS, INTEG_DIMS);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(DISKANN_OK, rc, "insert failed");
   }
 
-  float recall = (float)total_hits / (float)total_possible;
+  float *queries = gen_vectors(n_queries, 67890);
+  float max_dist_err = 0.0f;
+  float recall = measure_recall(idx, vectors, n_vectors, queries, n_queries,
+                                k, &max_dist_err);
 
-  /* With 200 vectors, 128D, max_neighbors=16, recall should be >= 80% */
   char msg[128];
-  snprintf(msg, sizeof(msg), "recall@%d = %.1f%% (expected >= 80%%)", k,
+  snprintf(msg, sizeof(msg), "int8 recall@%d = %.1f%% (expected >= 80%%)", k,
            (double)recall * 100.0);
   TEST_ASSERT_TRUE_MESSAGE(recall >= 0.8f, msg);
+  /* Reranked distances come from the float32 node vector */
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, max_dist_err);
 
+  /* Format survives reopen */
   diskann_close_index(idx);
+  idx = NULL;
+  int rc = diskann_open_index(db, "main", "test_recall_int8", &idx);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, rc);
+  TEST_ASSERT_EQUAL_UINT8(DISKANN_EDGE_INT8, idx->edge_type);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, idx->quant_min);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f / 255.0f, idx->quant_scale);
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, vectors, INTEG_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(1, res[0].id);
+
+  diskann_close_index(idx);
+  free(vectors);
+  free(queries);
+  sqlite3_close(db);
+}
+
+/*
+** Without a configured range, INT8 edges take it from the data. Components
+** here span [-50, 50): the old fixed [-1, 1] default clamped nearly all of
+** them to the end codes.
+*/
+void test_integration_int8_range_from_data(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = integ_config();
+  cfg.block_size = 0;
+  cfg.edge_type = DISKANN_EDGE_INT8;
+  DiskAnnIndex *idx = create_and_open(db, "test_int8_auto", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_TRUE(idx->quant_auto);
+
+  int n_vectors = 200;
+  int n_queries = 20;
+  int k = 10;
+  float *vectors = gen_vectors(n_vectors, 12345);
+  float *queries = gen_vectors(n_queries, 67890);
+  for (int i = 0; i < n_vectors * INTEG_DIMS; i++) {
+    vectors[i] = vectors[i] * 100.0f - 50.0f;
+  }
+  for (int i = 0; i < n_queries * INTEG_DIMS; i++) {
+    queries[i] = queries[i] * 100.0f - 50.0f;
+  }
+
+  /* A first insert that is rolled back takes its range with it */
+  float far[INTEG_DIMS];
+  for (int i = 0; i < INTEG_DIMS; i++) {
+    far[i] = 1000.0f + (float)i;
+  }
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert(idx, 1000, far, INTEG_DIMS));
+  TEST_ASSERT_TRUE(idx->quant_min > 900.0f);
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL));
+
+  for (int i = 0; i < n_vectors; i++) {
+    int rc = diskann_insert(idx, (int64_t)(i + 1),
+                            vectors + (size_t)i * INTEG_DIMS, INTEG_DIMS);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(DISKANN_OK, rc, "insert failed");
+  }
+
+  /* The range covers the first vector with headroom, not the rolled-back
+  ** one */
+  float quant_max = idx->quant_min + 255.0f * idx->quant_scale;
+  TEST_ASSERT_TRUE(idx->quant_min < -50.0f && idx->quant_min > -100.0f);
+  TEST_ASSERT_TRUE(quant_max > 50.0f && quant_max < 100.0f);
+
+  float max_dist_err = 0.0f;
+  float recall = measure_recall(idx, vectors, n_vectors, queries, n_queries,
+                                k, &max_dist_err);
+  char msg[128];
+  snprintf(msg, sizeof(msg), "int8 recall@%d = %.1f%% (expected >= 80%%)", k,
+           (double)recall * 100.0);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.8f, msg);
+
+  /* Edge slots decode to within half a code step of the neighbors'
+  ** vectors, so navigation sees the data rather than clamped codes */
+  BlobSpot *spot = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        blob_spot_create(idx, &spot, 1, idx->block_size, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        blob_spot_reload(idx, spot, 1, idx->block_size));
+  TEST_ASSERT_TRUE(node_bin_edges(idx, spot) > 0);
+  float decoded[INTEG_DIMS];
+  for (int e = 0; e < node_bin_edges(idx, spot); e++) {
+    uint64_t rowid;
+    node_bin_edge(idx, spot, e, &rowid, NULL, NULL);
+    diskann_edge_decode(idx, node_bin_edge_data(idx, spot, e), decoded);
+    const float *v = vectors + (size_t)(rowid - 1) * INTEG_DIMS;
+    for (int d = 0; d < INTEG_DIMS; d++) {
+      TEST_ASSERT_FLOAT_WITHIN(idx->quant_scale * 0.5f + 1e-4f, v[d],
+                               decoded[d]);
+    }
+  }
+  blob_spot_free(spot);
+
+  /* The derived range is stored */
+  float quant_min = idx->quant_min;
+  float quant_scale = idx->quant_scale;
+  diskann_close_index(idx);
+  idx = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_open_index(db, "main",
+                                                       "test_int8_auto", &idx));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, quant_min, idx->quant_min);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, quant_scale, idx->quant_scale);
+  TEST_ASSERT_FALSE(idx->quant_unsettled);
+
+  diskann_close_index(idx);
+  free(vectors);
+  free(queries);
+  sqlite3_close(db);
+}
+
+void test_integration_recall_pq(void) {
+  sqlite3 *db = open_db();
+  DiskAnnConfig cfg = integ_config();
+  DiskAnnIndex *idx = create_and_open(db, "test_recall_pq", &cfg);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  /* Building with no data has nothing to train on */
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_NOTFOUND, diskann_pq_build(idx, 16, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_pq_build(idx, INTEG_DIMS + 1, 0));
+
+  int n_vectors = 200;
+  int n_queries = 20;
+  int k = 10;
+  float *vectors = gen_vectors(n_vectors + 1, 4242);
+  for (int i = 0; i < n_vectors; i++) {
+    int rc = diskann_insert(idx, (int64_t)(i + 1),
+                            vectors + (size_t)i * INTEG_DIMS, INTEG_DIMS);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(DISKANN_OK, rc, "insert failed");
+  }
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_build(idx, 32, 0));
+  TEST_ASSERT_NOT_NULL(idx->pq);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)n_vectors, idx->pq->count);
+
+  float *queries = gen_vectors(n_queries, 2424);
+  float max_dist_err = 0.0f;
+  float recall = measure_recall(idx, vectors, n_vectors, queries, n_queries,
+                                k, &max_dist_err);
+
+  char msg[128];
+  snprintf(msg, sizeof(msg), "PQ recall@%d = %.1f%% (expected >= 80%%)", k,
+           (double)recall * 100.0);
+  TEST_ASSERT_TRUE_MESSAGE(recall >= 0.8f, msg);
+  /* Visited nodes are reranked with their float32 vectors */
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, max_dist_err);
+
+  /* Inserts and deletes maintain the code table */
+  const float *extra = vectors + (size_t)n_vectors * INTEG_DIMS;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_insert(idx, n_vectors + 1, extra,
+                                                   INTEG_DIMS));
+  TEST_ASSERT_NOT_NULL(diskann_pq_get(idx->pq, n_vectors + 1));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(idx, 1));
+  TEST_ASSERT_NULL(diskann_pq_get(idx->pq, 1));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)n_vectors, idx->pq->count);
+
+  /* Codes are reloaded on open */
+  diskann_close_index(idx);
+  idx = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_index(db, "main", "test_recall_pq", &idx));
+  TEST_ASSERT_NOT_NULL(idx->pq);
+  TEST_ASSERT_EQUAL_UINT32(32, idx->pq->n_subvectors);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)n_vectors, idx->pq->count);
+  TEST_ASSERT_NULL(diskann_pq_get(idx->pq, 1));
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, extra, INTEG_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(n_vectors + 1, res[0].id);
+  diskann_close_index(idx);
+
+  /* Drop removes the PQ tables along with the index */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_drop_index(db, "main", "test_recall_pq"));
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db,
+                         "SELECT COUNT(*) FROM sqlite_master WHERE name "
+                         "LIKE 'test_recall_pq_pq%'",
+                         -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  TEST_ASSERT_EQUAL_INT(0, sqlite3_column_int(stmt, 0));
+  sqlite3_finalize(stmt);
+
   free(vectors);
   free(queries);
   sqlite3_close(db);
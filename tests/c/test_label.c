@@ -0,0 +1,220 @@
+/*
+** Tests for diskann_label.h/.c — labels of a LABEL metadata column and
+** the label-aware (Filtered-Vamana) graph built on them.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_bitmap.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_label.h"
+#include "../../src/diskann_search.h"
+#include "unity/unity.h"
+#include <sqlite3.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LABEL_DIMS 8
+#define LABEL_ROWS 1200
+#define LABEL_COUNT 5
+
+/* Values compare equal under the column affinity <=> equal labels */
+void test_label_hash_affinity(void) {
+  sqlite3 *db;
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_prepare_v2(db,
+                                       "SELECT 3, 3.0, '3', 3.5, 'abc', "
+                                       "'abd', NULL, x'03'",
+                                       -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL(SQLITE_ROW, sqlite3_step(stmt));
+
+  uint32_t h[3][8];
+  const int affinities[3] = {DISKANN_LABEL_AFFINITY_NONE,
+                             DISKANN_LABEL_AFFINITY_TEXT,
+                             DISKANN_LABEL_AFFINITY_NUMERIC};
+  for (int a = 0; a < 3; a++) {
+    for (int c = 0; c < 8; c++) {
+      sqlite3_value *v = sqlite3_value_dup(sqlite3_column_value(stmt, c));
+      TEST_ASSERT_NOT_NULL(v);
+      h[a][c] = diskann_label_hash(v, affinities[a]);
+      sqlite3_value_free(v);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DISKANN_LABEL_NONE, h[a][6]);
+    TEST_ASSERT_NOT_EQUAL(h[a][4], h[a][5]);
+    TEST_ASSERT_NOT_EQUAL(h[a][0], h[a][3]);
+    TEST_ASSERT_NOT_EQUAL(h[a][0], h[a][7]);
+  }
+
+  /* No affinity: 3 = 3.0, but 3 <> '3' */
+  TEST_ASSERT_EQUAL_UINT32(h[0][0], h[0][1]);
+  TEST_ASSERT_NOT_EQUAL(h[0][0], h[0][2]);
+  /* TEXT: 3 is stored and compared as '3' */
+  TEST_ASSERT_EQUAL_UINT32(h[1][0], h[1][2]);
+  /* Numeric: '3' and 3.0 both become 3 */
+  TEST_ASSERT_EQUAL_UINT32(h[2][0], h[2][1]);
+  TEST_ASSERT_EQUAL_UINT32(h[2][0], h[2][2]);
+
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+}
+
+/* Labels and entry points against a reference, through heavy removal */
+void test_label_map_entries(void) {
+  enum { N = 3000 };
+  static uint32_t ref[N + 1];
+  DiskAnnLabels *labels = sqlite3_malloc64(sizeof(DiskAnnLabels));
+  TEST_ASSERT_NOT_NULL(labels);
+  memset(labels, 0, sizeof(*labels));
+
+  for (int64_t r = 1; r <= N; r++) {
+    ref[r] = (uint32_t)(r % 7) + 1;
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_labels_put(labels, r, ref[r]));
+  }
+  int64_t entry;
+  TEST_ASSERT_TRUE(diskann_labels_entry(labels, 2, &entry));
+  TEST_ASSERT_EQUAL_INT64(1, entry); /* first row with the label */
+  TEST_ASSERT_FALSE(diskann_labels_entry(labels, 99, &entry));
+  TEST_ASSERT_FALSE(diskann_labels_entry(labels, DISKANN_LABEL_NONE, &entry));
+
+  /* Removing the entry point hands it to another row of the label */
+  diskann_labels_remove(labels, 1);
+  ref[1] = DISKANN_LABEL_NONE;
+  TEST_ASSERT_TRUE(diskann_labels_entry(labels, 2, &entry));
+  TEST_ASSERT_EQUAL_UINT32(2, diskann_labels_get(labels, entry));
+
+  /* Relabel: the row leaves its old label's entry */
+  TEST_ASSERT_TRUE(diskann_labels_entry(labels, 3, &entry));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_labels_put(labels, entry, 50));
+  ref[entry] = 50;
+  int64_t moved = entry;
+  TEST_ASSERT_TRUE(diskann_labels_entry(labels, 3, &entry));
+  TEST_ASSERT_TRUE(entry != moved);
+  TEST_ASSERT_TRUE(diskann_labels_entry(labels, 50, &entry));
+  TEST_ASSERT_EQUAL_INT64(moved, entry);
+
+  /* Remove two thirds in scrambled order (exercises backward shifts) */
+  uint32_t state = 7;
+  for (int i = 0; i < 2 * N; i++) {
+    state = state * 1103515245u + 12345u;
+    int64_t r = (int64_t)(state >> 8) % N + 1;
+    diskann_labels_remove(labels, r);
+    ref[r] = DISKANN_LABEL_NONE;
+  }
+  for (int64_t r = 1; r <= N; r++) {
+    TEST_ASSERT_EQUAL_UINT32(ref[r], diskann_labels_get(labels, r));
+  }
+  for (uint32_t l = 1; l <= 7; l++) {
+    int any = 0;
+    for (int64_t r = 1; r <= N; r++) {
+      any |= ref[r] == l;
+    }
+    TEST_ASSERT_EQUAL(any, diskann_labels_entry(labels, l, &entry));
+    if (any) {
+      TEST_ASSERT_EQUAL_UINT32(l, ref[entry]);
+    }
+  }
+
+  diskann_labels_free(labels);
+  diskann_labels_free(NULL);
+  TEST_ASSERT_EQUAL_UINT32(DISKANN_LABEL_NONE, diskann_labels_get(NULL, 1));
+}
+
+/*
+** A label-restricted walk reads only blocks of its label, fewer than the
+** whole-graph walk, and still returns the label's nearest rows.
+*/
+void test_label_search_stays_in_subgraph(void) {
+  sqlite3 *db;
+  DiskAnnIndex *idx = NULL;
+  static float vectors[LABEL_ROWS][LABEL_DIMS];
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+
+  DiskAnnConfig config = {.dimensions = LABEL_DIMS,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 16,
+                          .search_list_size = 8,
+                          .insert_list_size = 32};
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_create_index(db, "main", "li", &config));
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_exec(db,
+                                 "CREATE TABLE li_attrs(rowid INTEGER "
+                                 "PRIMARY KEY, cat INTEGER)",
+                                 NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_open_index(db, "main", "li", &idx));
+  diskann_set_exact_scan_threshold(idx, 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_labels_enable(
+                                    idx, "cat", DISKANN_LABEL_AFFINITY_NUMERIC));
+
+  /* Labels are independent of position: a 20% filter is spread evenly */
+  uint32_t seed = 99;
+  for (int i = 0; i < LABEL_ROWS; i++) {
+    for (int d = 0; d < LABEL_DIMS; d++) {
+      seed = seed * 1103515245u + 12345u;
+      vectors[i][d] = (float)(seed >> 8) / (float)(1u << 24);
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_labels_put(idx->labels, i + 1,
+                                         (uint32_t)(i % LABEL_COUNT) + 1));
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i + 1, vectors[i],
+                                                 LABEL_DIMS));
+  }
+
+  DiskAnnBitmap bm;
+  diskann_bitmap_init(&bm);
+  const uint32_t label = 4;
+  for (int i = 0; i < LABEL_ROWS; i++) {
+    if ((uint32_t)(i % LABEL_COUNT) + 1 == label) {
+      TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, i + 1));
+    }
+  }
+  /* Graph walk, not the exact scan */
+  TEST_ASSERT_FALSE(filter_plan_exact_scan(idx, bm.count, NULL));
+
+  float query[LABEL_DIMS];
+  for (int d = 0; d < LABEL_DIMS; d++) {
+    query[d] = 0.5f;
+  }
+
+  DiskAnnResult res[5];
+  uint64_t reads = idx->num_reads;
+  TEST_ASSERT_EQUAL_INT(5, diskann_search_bitmap(idx, query, LABEL_DIMS, 5,
+                                                 res, &bm, label, NULL));
+  uint64_t label_reads = idx->num_reads - reads;
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_TRUE(diskann_bitmap_contains(&bm, res[i].id));
+  }
+  TEST_ASSERT_TRUE(label_reads <= bm.count);
+
+  /* Brute-force nearest row of the label is found */
+  int64_t best = 0;
+  float best_dist = 0.0f;
+  for (int i = 0; i < LABEL_ROWS; i++) {
+    if (!diskann_bitmap_contains(&bm, i + 1)) {
+      continue;
+    }
+    float dist = 0.0f;
+    for (int d = 0; d < LABEL_DIMS; d++) {
+      float diff = vectors[i][d] - query[d];
+      dist += diff * diff;
+    }
+    if (best == 0 || dist < best_dist) {
+      best = i + 1;
+      best_dist = dist;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT64(best, res[0].id);
+
+  reads = idx->num_reads;
+  TEST_ASSERT_EQUAL_INT(5, diskann_search_bitmap(idx, query, LABEL_DIMS, 5,
+                                                 res, &bm,
+                                                 DISKANN_LABEL_NONE, NULL));
+  TEST_ASSERT_TRUE(label_reads < idx->num_reads - reads);
+
+  diskann_bitmap_deinit(&bm);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
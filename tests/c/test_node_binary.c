@@ -456,6 +456,190 @@ void test_distance_dispatch_cosine(void) {
   TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, d);
 }
 
+void test_distance_dot_known_value(void) {
+  float a[3] = {1.0f, 2.0f, 3.0f};
+  float b[3] = {4.0f, 5.0f, 6.0f};
+  /* Inner-product distance is negated: -(4 + 10 + 18) */
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -32.0f, diskann_distance_dot(a, b, 3));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 32.0f, diskann_dot_product(a, b, 3));
+}
+
+void test_distance_dispatch_dot(void) {
+  float a[2] = {2.0f, 1.0f};
+  float b[2] = {3.0f, -1.0f};
+  float d = diskann_distance(a, b, 2, DISKANN_METRIC_DOT);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -5.0f, d);
+}
+
+void test_node_bin_cosine_stores_inv_norm(void) {
+  DiskAnnIndex idx = make_test_index(3, 256);
+  idx.metric = DISKANN_METRIC_COSINE;
+  BlobSpot *spot = make_test_blobspot(256);
+
+  float vec[3] = {3.0f, 4.0f, 0.0f};
+  node_bin_init(&idx, spot, 1, vec);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f, node_bin_inv_norm(&idx, spot));
+
+  float edge_vec[3] = {0.0f, 2.0f, 0.0f};
+  node_bin_replace_edge(&idx, spot, 0, 2, 0.2f, edge_vec);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, node_bin_edge_inv_norm(&idx, spot, 0));
+  /* Norm bytes must not disturb the edge count or edge metadata */
+  TEST_ASSERT_EQUAL_UINT16(1, node_bin_edges(&idx, spot));
+  uint64_t rowid;
+  float dist;
+  node_bin_edge(&idx, spot, 0, &rowid, &dist, NULL);
+  TEST_ASSERT_EQUAL_UINT64(2, rowid);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.2f, dist);
+
+  /* Normed distance agrees with full cosine */
+  float query[3] = {1.0f, 1.0f, 0.0f};
+  float q_inv = diskann_index_inv_norm(&idx, query);
+  TEST_ASSERT_FLOAT_WITHIN(
+      1e-5f, diskann_distance_cosine(query, vec, 3),
+      diskann_index_distance_normed(&idx, query, q_inv,
+                                    node_bin_vector(&idx, spot),
+                                    node_bin_inv_norm(&idx, spot)));
+
+  free_test_blobspot(spot);
+}
+
+void test_node_bin_l2_no_inv_norm(void) {
+  DiskAnnIndex idx = make_test_index(3, 256);
+  BlobSpot *spot = make_test_blobspot(256);
+
+  float vec[3] = {3.0f, 4.0f, 0.0f};
+  node_bin_init(&idx, spot, 1, vec);
+  node_bin_replace_edge(&idx, spot, 0, 2, 1.0f, vec);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, node_bin_inv_norm(&idx, spot));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, node_bin_edge_inv_norm(&idx, spot, 0));
+
+  free_test_blobspot(spot);
+}
+
+/* ========================================================================
+** INT8 edge vector tests
+** ======================================================================== */
+
+static DiskAnnIndex make_int8_index(uint32_t dims, uint32_t block_size) {
+  DiskAnnIndex idx = make_test_index(dims, block_size);
+  idx.edge_type = DISKANN_EDGE_INT8;
+  idx.nEdgeVectorSize = dims; /* one code per dimension */
+  idx.quant_min = -1.0f;
+  idx.quant_scale = 2.0f / 255.0f;
+  return idx;
+}
+
+void test_max_edges_int8_3d_256block(void) {
+  /* nodeOverhead = 16 + 12 = 28, edgeOverhead = 3 + 16 = 19
+   * maxEdges = (256 - 28) / 19 = 12 (vs 8 for float32) */
+  DiskAnnIndex idx = make_int8_index(3, 256);
+  TEST_ASSERT_EQUAL_UINT32(12, node_edges_max_count(&idx));
+  TEST_ASSERT_EQUAL_UINT32(3, diskann_edge_vector_size(DISKANN_EDGE_INT8,
+                                                       DISKANN_VECTOR_FLOAT32,
+                                                       3));
+  TEST_ASSERT_EQUAL_UINT32(12, diskann_edge_vector_size(DISKANN_EDGE_FLOAT32,
+                                                        DISKANN_VECTOR_FLOAT32,
+                                                        3));
+  TEST_ASSERT_EQUAL_UINT32(6, diskann_edge_vector_size(DISKANN_EDGE_FLOAT32,
+                                                       DISKANN_VECTOR_FLOAT16,
+                                                       3));
+  TEST_ASSERT_EQUAL_UINT32(
+      0, diskann_edge_vector_size(99, DISKANN_VECTOR_FLOAT32, 3));
+}
+
+void test_edge_int8_encode_decode(void) {
+  DiskAnnIndex idx = make_int8_index(5, 256);
+  float vec[5] = {-1.0f, 1.0f, 0.0f, 0.3f, -0.77f};
+  uint8_t codes[5];
+  float out[5];
+
+  diskann_edge_encode(&idx, vec, codes);
+  TEST_ASSERT_EQUAL_UINT8(0, codes[0]);
+  TEST_ASSERT_EQUAL_UINT8(255, codes[1]);
+  diskann_edge_decode(&idx, codes, out);
+  for (int i = 0; i < 5; i++) {
+    /* Round-to-nearest: error is at most half a step */
+    TEST_ASSERT_FLOAT_WITHIN(idx.quant_scale * 0.5f + 1e-6f, vec[i], out[i]);
+  }
+
+  /* Out-of-range values clamp to the ends of the code range */
+  float wide[5] = {-5.0f, 5.0f, NAN, 0.0f, 0.0f};
+  diskann_edge_encode(&idx, wide, codes);
+  TEST_ASSERT_EQUAL_UINT8(0, codes[0]);
+  TEST_ASSERT_EQUAL_UINT8(255, codes[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, codes[2]);
+}
+
+void test_node_bin_int8_edge_distances(void) {
+  DiskAnnIndex idx = make_int8_index(4, 512);
+  BlobSpot *spot = make_test_blobspot(512);
+
+  float node[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+  float e0[4] = {0.5f, -0.5f, 0.25f, 0.0f};
+  float e1[4] = {-0.3f, 0.9f, -0.1f, 0.6f};
+  node_bin_init(&idx, spot, 1, node);
+  node_bin_replace_edge(&idx, spot, 0, 2, 1.0f, e0);
+  node_bin_replace_edge(&idx, spot, 1, 3, 2.0f, e1);
+  TEST_ASSERT_EQUAL_UINT16(2, node_bin_edges(&idx, spot));
+
+  /* Node vector is stored at full precision */
+  TEST_ASSERT_EQUAL_FLOAT(0.3f, node_bin_vector(&idx, spot)[2]);
+
+  float q[4] = {0.2f, 0.1f, -0.2f, 0.3f};
+  const float tol = 0.02f;
+  TEST_ASSERT_FLOAT_WITHIN(
+      tol, diskann_distance_l2(q, e0, 4),
+      diskann_edge_distance(&idx, q, 0.0f, node_bin_edge_data(&idx, spot, 0),
+                            0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(
+      tol, diskann_distance_l2(e0, e1, 4),
+      diskann_edge_pair_distance(&idx, node_bin_edge_data(&idx, spot, 0), 0.0f,
+                                 node_bin_edge_data(&idx, spot, 1), 0.0f));
+
+  idx.metric = DISKANN_METRIC_COSINE;
+  TEST_ASSERT_FLOAT_WITHIN(
+      tol, diskann_distance_cosine(q, e1, 4),
+      diskann_edge_distance(&idx, q, 0.0f, node_bin_edge_data(&idx, spot, 1),
+                            0.0f));
+  idx.metric = DISKANN_METRIC_DOT;
+  TEST_ASSERT_FLOAT_WITHIN(
+      tol, diskann_distance_dot(e0, e1, 4),
+      diskann_edge_pair_distance(&idx, node_bin_edge_data(&idx, spot, 0), 0.0f,
+                                 node_bin_edge_data(&idx, spot, 1), 0.0f));
+
+  free_test_blobspot(spot);
+}
+
+void test_node_bin_int8_cosine_edge_norm(void) {
+  DiskAnnIndex idx = make_int8_index(4, 512);
+  idx.metric = DISKANN_METRIC_COSINE;
+  BlobSpot *spot = make_test_blobspot(512);
+
+  /* Small components lose most of their precision to the codes, so the
+  ** stored norm must be of the decoded vector, not of e */
+  float node[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+  float e[4] = {0.3f, 0.01f, -0.02f, 0.004f};
+  node_bin_init(&idx, spot, 1, node);
+  node_bin_replace_edge(&idx, spot, 0, 2, 1.0f, e);
+
+  float decoded[4];
+  diskann_edge_decode(&idx, node_bin_edge_data(&idx, spot, 0), decoded);
+  float sq = 0.0f;
+  for (int i = 0; i < 4; i++) {
+    sq += decoded[i] * decoded[i];
+  }
+  float inv_norm = node_bin_edge_inv_norm(&idx, spot, 0);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f / sqrtf(sq), inv_norm);
+
+  /* So an edge is at distance 0 from itself */
+  const uint8_t *codes = node_bin_edge_data(&idx, spot, 0);
+  TEST_ASSERT_FLOAT_WITHIN(
+      1e-5f, 0.0f,
+      diskann_edge_pair_distance(&idx, codes, inv_norm, codes, inv_norm));
+
+  free_test_blobspot(spot);
+}
+
 /* ========================================================================
 ** Buffer management tests
 ** ======================================================================== */
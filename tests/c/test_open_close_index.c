@@ -150,6 +150,61 @@ void test_close_index_frees_resources(void) {
   sqlite3_close(db);
 }
 
+/* Prepared statements on db */
+static int count_statements(sqlite3 *db) {
+  int n = 0;
+  for (sqlite3_stmt *s = sqlite3_next_stmt(db, NULL); s;
+       s = sqlite3_next_stmt(db, s)) {
+    n++;
+  }
+  return n;
+}
+
+/*
+** Test that inserts, deletes and searches reuse the handle's prepared
+** statements and that closing the index finalizes them
+*/
+void test_close_index_finalizes_statements(void) {
+  sqlite3 *db = NULL;
+  DiskAnnIndex *idx = NULL;
+  float v[128];
+  DiskAnnResult results[4];
+  int rc;
+
+  rc = sqlite3_open(":memory:", &db);
+  TEST_ASSERT_EQUAL(SQLITE_OK, rc);
+  rc = create_test_index(db, "test_idx");
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+  rc = diskann_open_index(db, "main", "test_idx", &idx);
+  TEST_ASSERT_EQUAL(DISKANN_OK, rc);
+
+  for (int i = 0; i < 4; i++) {
+    for (int d = 0; d < 128; d++) {
+      v[d] = (float)(i * 128 + d);
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i + 1, v, 128));
+  }
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 4));
+  TEST_ASSERT_TRUE(diskann_search(idx, v, 128, 4, results) > 0);
+  int n_statements = count_statements(db);
+  TEST_ASSERT_TRUE(n_statements > 0);
+
+  /* Repeating the same operations prepares nothing new */
+  for (int i = 4; i < 8; i++) {
+    for (int d = 0; d < 128; d++) {
+      v[d] = (float)(i * 128 + d);
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i + 1, v, 128));
+  }
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 8));
+  TEST_ASSERT_TRUE(diskann_search(idx, v, 128, 4, results) > 0);
+  TEST_ASSERT_EQUAL(n_statements, count_statements(db));
+
+  diskann_close_index(idx);
+  TEST_ASSERT_EQUAL(0, count_statements(db));
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_close(db));
+}
+
 /*
 ** Test opening multiple indexes simultaneously
 */
@@ -0,0 +1,172 @@
+/*
+** Tests for diskann_optimize() — locality-ordered shadow table rewrite.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_internal.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <sqlite3.h>
+#include <stdlib.h>
+
+#define OPT_TEST_DIMS 16
+#define OPT_TEST_N 400
+#define OPT_TEST_K 10
+#define OPT_TEST_QUERIES 10
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+/* Index "opt" holding vectors with ids 1..n */
+static DiskAnnIndex *create_populated(sqlite3 *db, const float *vectors,
+                                      int n) {
+  DiskAnnConfig config = {.dimensions = OPT_TEST_DIMS,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 16,
+                          .search_list_size = 64,
+                          .insert_list_size = 64};
+  DiskAnnIndex *idx = create_index(db, "opt", &config);
+  /* Compare walks of the rewritten graph, not exact scans */
+  diskann_set_exact_scan_threshold(idx, 0);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_insert(idx, i + 1,
+                                         vectors + i * OPT_TEST_DIMS,
+                                         OPT_TEST_DIMS));
+  }
+  return idx;
+}
+
+static int count_shadow_rows(sqlite3 *db) {
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db,
+                                           "SELECT count(*) FROM opt_shadow",
+                                           -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  int n = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  return n;
+}
+
+/* Top-K of every query, OPT_TEST_QUERIES * OPT_TEST_K results */
+static void search_all(DiskAnnIndex *idx, const float *queries,
+                       DiskAnnResult *out) {
+  for (int q = 0; q < OPT_TEST_QUERIES; q++) {
+    TEST_ASSERT_EQUAL_INT(OPT_TEST_K,
+                          diskann_search(idx, queries + q * OPT_TEST_DIMS,
+                                         OPT_TEST_DIMS, OPT_TEST_K,
+                                         out + q * OPT_TEST_K));
+  }
+}
+
+/**************************************************************************
+** Tests
+**************************************************************************/
+
+void test_optimize_invalid(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_populated(db, NULL, 0);
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_optimize(NULL));
+  TEST_ASSERT_EQUAL_INT(0, diskann_optimize(idx)); /* empty index */
+
+  /* Batch mode holds state that is not on disk yet */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_begin_batch(idx, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_optimize(idx));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(idx));
+
+  DiskAnnIndex *reader = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_reader(idx, db, NULL, &reader));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_optimize(reader));
+  diskann_close_index(reader);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* Same rows, same results, before and after the rewrite */
+void test_optimize_preserves_results(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  float *vectors = gen_vectors(OPT_TEST_N, OPT_TEST_DIMS, 42u);
+  float *queries = gen_vectors(OPT_TEST_QUERIES, OPT_TEST_DIMS, 777u);
+  DiskAnnIndex *idx = create_populated(db, vectors, OPT_TEST_N);
+  for (int64_t id = 5; id <= OPT_TEST_N; id += 5) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(idx, id));
+  }
+  const int live = OPT_TEST_N - OPT_TEST_N / 5;
+
+  DiskAnnResult before[OPT_TEST_QUERIES * OPT_TEST_K];
+  DiskAnnResult after[OPT_TEST_QUERIES * OPT_TEST_K];
+  search_all(idx, queries, before);
+
+  TEST_ASSERT_EQUAL_INT(live, diskann_optimize(idx));
+  TEST_ASSERT_EQUAL_INT(live, count_shadow_rows(db));
+  search_all(idx, queries, after);
+  for (int i = 0; i < OPT_TEST_QUERIES * OPT_TEST_K; i++) {
+    TEST_ASSERT_EQUAL_INT64(before[i].id, after[i].id);
+    TEST_ASSERT_EQUAL_FLOAT(before[i].distance, after[i].distance);
+  }
+
+  /* The rewritten graph still takes inserts and deletes */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_insert(idx, OPT_TEST_N + 1, vectors,
+                                       OPT_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(idx, 1));
+  DiskAnnResult top[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, vectors, OPT_TEST_DIMS, 1,
+                                          top));
+  TEST_ASSERT_EQUAL_INT64(OPT_TEST_N + 1, top[0].id);
+
+  /* Reopening reads the same metadata and rows */
+  diskann_close_index(idx);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_index(db, "main", "opt", &idx));
+  TEST_ASSERT_EQUAL_INT(live, diskann_optimize(idx));
+
+  diskann_close_index(idx);
+  free(vectors);
+  free(queries);
+  sqlite3_close(db);
+}
+
+/* Tombstones are consolidated before the rewrite, not copied */
+void test_optimize_consolidates_tombstones(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  float *vectors = gen_vectors(OPT_TEST_N, OPT_TEST_DIMS, 7u);
+  DiskAnnIndex *idx = create_populated(db, vectors, OPT_TEST_N);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_set_delete_mode(idx, DISKANN_DELETE_TOMBSTONE,
+                                                0));
+  for (int64_t id = 2; id <= OPT_TEST_N; id += 2) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(idx, id));
+  }
+  TEST_ASSERT_EQUAL_INT(OPT_TEST_N, count_shadow_rows(db));
+
+  TEST_ASSERT_EQUAL_INT(OPT_TEST_N / 2, diskann_optimize(idx));
+  TEST_ASSERT_EQUAL_INT(OPT_TEST_N / 2, count_shadow_rows(db));
+  TEST_ASSERT_EQUAL_INT(0, diskann_consolidate(idx));
+
+  /* Every live row still finds itself */
+  int found = 0;
+  for (int i = 0; i < OPT_TEST_N; i += 2) {
+    DiskAnnResult top[1];
+    if (diskann_search(idx, vectors + i * OPT_TEST_DIMS, OPT_TEST_DIMS, 1,
+                       top) == 1 &&
+        top[0].id == i + 1) {
+      found++;
+    }
+  }
+  TEST_ASSERT_TRUE(found >= (OPT_TEST_N / 2) * 95 / 100);
+
+  diskann_close_index(idx);
+  free(vectors);
+  sqlite3_close(db);
+}
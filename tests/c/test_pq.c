@@ -0,0 +1,161 @@
+/*
+** Tests for diskann_pq.h/.c — codebook training, lookup-table distances and
+** the in-memory rowid -> code map.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann_node.h"
+#include "../../src/diskann_pq.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define PQ_TEST_DIMS 10 /* not a multiple of n_subvectors: uneven split */
+#define PQ_TEST_SUBVECTORS 4
+#define PQ_TEST_SAMPLES 100
+
+static float *gen_samples(uint32_t n, uint32_t seed) {
+  return gen_vectors((int)n, PQ_TEST_DIMS, seed);
+}
+
+void test_pq_create_invalid(void) {
+  DiskAnnPq *pq = NULL;
+  TEST_ASSERT_EQUAL_INT(
+      DISKANN_ERROR_INVALID,
+      diskann_pq_create(&pq, 8, DISKANN_METRIC_EUCLIDEAN, 0, NULL));
+  TEST_ASSERT_EQUAL_INT(
+      DISKANN_ERROR_INVALID,
+      diskann_pq_create(&pq, 8, DISKANN_METRIC_EUCLIDEAN, 9, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_pq_create(&pq, 8, 99, 2, NULL));
+  TEST_ASSERT_NULL(pq);
+
+  float sample[8] = {0};
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_pq_train(&pq, 8, DISKANN_METRIC_EUCLIDEAN, 2,
+                                         sample, 0));
+}
+
+/*
+** With fewer samples than centroids, every sample seeds its own centroid,
+** so codes are lossless and table distances equal exact distances.
+*/
+static void check_lossless_codes(uint8_t metric) {
+  float *samples = gen_samples(PQ_TEST_SAMPLES, 11u + metric);
+  float *queries = gen_samples(5, 99u);
+  DiskAnnPq *pq = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_pq_train(&pq, PQ_TEST_DIMS, metric,
+                                         PQ_TEST_SUBVECTORS, samples,
+                                         PQ_TEST_SAMPLES));
+  TEST_ASSERT_NOT_NULL(pq);
+  TEST_ASSERT_EQUAL_UINT32(PQ_TEST_DIMS, pq->offsets[PQ_TEST_SUBVECTORS]);
+
+  float table[PQ_TEST_SUBVECTORS * DISKANN_PQ_CENTROIDS];
+  uint8_t code[PQ_TEST_SUBVECTORS];
+  for (int q = 0; q < 5; q++) {
+    const float *query = queries + q * PQ_TEST_DIMS;
+    float q_norm = sqrtf(diskann_dot_product(query, query, PQ_TEST_DIMS));
+    diskann_pq_query_table(pq, query, 1.0f / q_norm, table);
+
+    for (int i = 0; i < PQ_TEST_SAMPLES; i++) {
+      const float *v = samples + i * PQ_TEST_DIMS;
+      TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_encode(pq, v, code));
+      float expected = diskann_distance(query, v, PQ_TEST_DIMS, metric);
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, expected,
+                               diskann_pq_table_distance(pq, table, code));
+    }
+  }
+
+  diskann_pq_free(pq);
+  free(samples);
+  free(queries);
+}
+
+void test_pq_lossless_codes_l2(void) {
+  check_lossless_codes(DISKANN_METRIC_EUCLIDEAN);
+}
+
+void test_pq_lossless_codes_cosine(void) {
+  check_lossless_codes(DISKANN_METRIC_COSINE);
+}
+
+void test_pq_lossless_codes_dot(void) {
+  check_lossless_codes(DISKANN_METRIC_DOT);
+}
+
+/* More samples than centroids: codes are lossy but close on average */
+void test_pq_train_approximates_l2(void) {
+  uint32_t n = 2000;
+  float *samples = gen_samples(n, 5u);
+  DiskAnnPq *pq = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_pq_train(&pq, PQ_TEST_DIMS,
+                                         DISKANN_METRIC_EUCLIDEAN, 5, samples,
+                                         n));
+
+  float table[5 * DISKANN_PQ_CENTROIDS];
+  uint8_t code[5];
+  const float *query = samples; /* any fixed point */
+  diskann_pq_query_table(pq, query, 0.0f, table);
+  double total_err = 0.0, total = 0.0;
+  for (uint32_t i = 1; i < n; i++) {
+    const float *v = samples + (size_t)i * PQ_TEST_DIMS;
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_encode(pq, v, code));
+    float exact = diskann_distance_l2(query, v, PQ_TEST_DIMS);
+    total_err += fabs(diskann_pq_table_distance(pq, table, code) - exact);
+    total += exact;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(total_err < 0.1 * total,
+                           "mean PQ error above 10% of mean distance");
+
+  diskann_pq_free(pq);
+  free(samples);
+}
+
+void test_pq_map_put_get_remove(void) {
+  DiskAnnPq *pq = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_pq_create(&pq, 8, DISKANN_METRIC_EUCLIDEAN, 2,
+                                          NULL));
+  TEST_ASSERT_NULL(diskann_pq_get(pq, 1));
+  diskann_pq_remove(pq, 1); /* empty map: no-op */
+
+  /* Spread-out and negative rowids; grows through several resizes */
+  const int n = 3000;
+  for (int i = 0; i < n; i++) {
+    int64_t rowid = (int64_t)(i - 500) * 7919;
+    uint8_t code[2] = {(uint8_t)i, (uint8_t)(i >> 8)};
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_put(pq, rowid, code));
+  }
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)n, pq->count);
+
+  for (int i = 0; i < n; i += 3) {
+    diskann_pq_remove(pq, (int64_t)(i - 500) * 7919);
+  }
+  diskann_pq_remove(pq, 123456789); /* absent: no-op */
+
+  int expected_count = 0;
+  for (int i = 0; i < n; i++) {
+    const uint8_t *code = diskann_pq_get(pq, (int64_t)(i - 500) * 7919);
+    if (i % 3 == 0) {
+      TEST_ASSERT_NULL(code);
+    } else {
+      expected_count++;
+      TEST_ASSERT_NOT_NULL(code);
+      TEST_ASSERT_EQUAL_UINT8((uint8_t)i, code[0]);
+      TEST_ASSERT_EQUAL_UINT8((uint8_t)(i >> 8), code[1]);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)expected_count, pq->count);
+
+  /* Put on an existing rowid replaces the code in place */
+  uint8_t replacement[2] = {0xAB, 0xCD};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_pq_put(pq, 15838, replacement));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)expected_count, pq->count);
+  TEST_ASSERT_EQUAL_UINT8(0xAB, diskann_pq_get(pq, 15838)[0]);
+
+  diskann_pq_free(pq);
+}
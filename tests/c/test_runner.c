@@ -15,6 +15,7 @@ extern void test_create_index_with_null_config(void);
 extern void test_create_index_null_database(void);
 extern void test_create_index_null_name(void);
 extern void test_create_index_zero_dimensions(void);
+extern void test_create_index_invalid_metric(void);
 extern void test_shadow_table_schema(void);
 extern void test_create_index_invalid_name(void);
 extern void test_metadata_roundtrip(void);
@@ -41,6 +42,7 @@ extern void test_open_index_null_name(void);
 extern void test_open_index_null_output(void);
 extern void test_close_index_null(void);
 extern void test_close_index_frees_resources(void);
+extern void test_close_index_finalizes_statements(void);
 extern void test_open_multiple_indexes(void);
 extern void test_reopen_same_index(void);
 extern void test_open_index_rejects_huge_dimensions(void);
@@ -56,6 +58,12 @@ extern void test_blob_spot_reload_different_rowid(void);
 extern void test_blob_spot_flush(void);
 extern void test_blob_spot_flush_readonly(void);
 extern void test_blob_spot_create_null_output(void);
+extern void test_blob_spot_partial_read(void);
+extern void test_blob_spot_load_pooled(void);
+extern void test_blob_pool_expired_handle(void);
+extern void test_blob_pool_insert_walks(void);
+extern void test_blob_spot_mark_dirty(void);
+extern void test_blob_spot_flush_dirty_ranges(void);
 
 /* LE serialization tests */
 extern void test_le16_roundtrip(void);
@@ -90,6 +98,14 @@ extern void test_distance_cosine_same_direction(void);
 extern void test_distance_cosine_opposite(void);
 extern void test_distance_dispatch_l2(void);
 extern void test_distance_dispatch_cosine(void);
+extern void test_distance_dot_known_value(void);
+extern void test_distance_dispatch_dot(void);
+extern void test_node_bin_cosine_stores_inv_norm(void);
+extern void test_node_bin_l2_no_inv_norm(void);
+extern void test_max_edges_int8_3d_256block(void);
+extern void test_edge_int8_encode_decode(void);
+extern void test_node_bin_int8_edge_distances(void);
+extern void test_node_bin_int8_cosine_edge_norm(void);
 
 /* Buffer management tests */
 extern void test_distance_buffer_insert_idx_empty(void);
@@ -149,6 +165,13 @@ extern void test_delete_node_cleans_backedges(void);
 extern void test_delete_last_node(void);
 extern void test_delete_double_delete(void);
 extern void test_delete_zombie_edge(void);
+extern void test_delete_tombstone_hides_row(void);
+extern void test_delete_tombstone_consolidate(void);
+extern void test_delete_tombstone_reinsert(void);
+extern void test_delete_tombstone_threshold(void);
+extern void test_delete_mode_persists(void);
+extern void test_delete_batch(void);
+extern void test_delete_batch_deferred(void);
 
 /* Insert tests */
 extern void test_insert_null_index(void);
@@ -162,17 +185,28 @@ extern void test_insert_edge_count_limit(void);
 extern void test_insert_recall(void);
 extern void test_insert_delete_search(void);
 extern void test_insert_cosine_metric(void);
+extern void test_insert_dot_metric(void);
+extern void test_insert_cosine_distance_matches_exact(void);
+extern void test_dist_memo_basic(void);
+extern void test_insert_memo_edge_distances(void);
 
 /* Integration tests */
 extern void test_integration_reopen_persistence(void);
 extern void test_integration_clear_reinsert(void);
 extern void test_integration_recall_128d(void);
+extern void test_integration_recall_int8_edges(void);
+extern void test_integration_int8_range_from_data(void);
+extern void test_integration_recall_pq(void);
 extern void test_integration_delete_at_scale(void);
 
 /* Virtual table tests */
 extern void test_vtab_create(void);
 extern void test_vtab_create_no_dimension(void);
 extern void test_vtab_create_bad_metric(void);
+extern void test_vtab_create_edge_type_int8(void);
+extern void test_vtab_create_bad_edge_type(void);
+extern void test_vtab_vector_type_f16(void);
+extern void test_vtab_create_bad_vector_type(void);
 extern void test_vtab_drop(void);
 extern void test_vtab_create_sql_injection(void);
 extern void test_vtab_insert_blob(void);
@@ -188,6 +222,8 @@ extern void test_vtab_search_empty(void);
 extern void test_vtab_search_no_match(void);
 extern void test_vtab_delete(void);
 extern void test_vtab_delete_nonexistent(void);
+extern void test_vtab_delete_tombstone(void);
+extern void test_vtab_delete_multi_row(void);
 extern void test_vtab_reopen(void);
 
 /* Phase 2: Virtual table metadata column tests */
@@ -227,6 +263,32 @@ extern void test_vtab_filter_graph_bridge(void);
 /* Dynamic search list size scaling tests */
 extern void test_effective_search_list_size_small_index(void);
 extern void test_effective_search_list_size_scales_up(void);
+extern void test_entry_point_set_on_first_insert(void);
+extern void test_entry_point_refresh_picks_central_node(void);
+extern void test_entry_point_refreshed_at_end_batch(void);
+extern void test_entry_point_delete_hands_off(void);
+extern void test_entry_point_stale_falls_back(void);
+extern void test_read_cache_serves_repeat_queries(void);
+extern void test_read_cache_invalidated_by_writes(void);
+extern void test_read_cache_cleared_by_other_connection(void);
+extern void test_search_wide_beam_matches_brute_force(void);
+extern void test_search_pool_reused_across_queries(void);
+extern void test_search_pool_nested_acquire(void);
+extern void test_partial_reads_match_full_float32(void);
+extern void test_partial_reads_match_full_int8(void);
+extern void test_partial_reads_match_full_pq(void);
+extern void test_beam_width_invalid(void);
+extern void test_beam_width_recall(void);
+extern void test_beam_width_skips_deleted(void);
+extern void test_filter_plan_by_selectivity(void);
+extern void test_search_bitmap_matches_brute_force(void);
+extern void test_search_batch_validation(void);
+extern void test_search_batch_workers_match_sequential(void);
+extern void test_search_batch_sequential_fallbacks(void);
+extern void test_search_batch_sees_pending_writes(void);
+extern void test_search_ex_params(void);
+extern void test_open_reader_concurrent_search(void);
+extern void test_open_reader_follows_shared_handle(void);
 
 /* Hash set tests (build speed optimization) */
 extern void test_visited_set_init(void);
@@ -235,6 +297,8 @@ extern void test_visited_set_collisions(void);
 extern void test_visited_set_wraparound(void);
 extern void test_visited_set_duplicates(void);
 extern void test_visited_set_full_table(void);
+extern void test_visited_set_clear(void);
+extern void test_visited_set_states_and_growth(void);
 extern void test_visited_set_null_safety(void);
 
 /* BLOB cache tests (build speed optimization) */
@@ -255,6 +319,10 @@ extern void test_cache_owning_eviction_clears_flag(void);
 extern void test_cache_owning_deinit_frees(void);
 extern void test_cache_non_owning_no_flag(void);
 extern void test_cache_same_pointer_no_leak(void);
+extern void test_cache_remove_keeps_lru_chain(void);
+extern void test_cache_clear(void);
+extern void test_cache_byte_budget_evicts(void);
+extern void test_cache_hash_index_churn(void);
 
 /* Batch insert tests */
 extern void test_batch_begin_end(void);
@@ -268,7 +336,7 @@ extern void test_batch_insert_after_end(void);
 
 /* Deferred edge list unit tests */
 extern void test_deferred_edge_list_lifecycle(void);
-extern void test_deferred_edge_list_capacity(void);
+extern void test_deferred_edge_list_shared_vectors(void);
 extern void test_deferred_edge_list_truncate(void);
 extern void test_deferred_edge_list_empty_deinit(void);
 
@@ -284,14 +352,121 @@ extern void test_vtab_batch_transaction(void);
 extern void test_vtab_batch_autocommit(void);
 extern void test_vtab_batch_rollback(void);
 extern void test_vtab_batch_multiple_txns(void);
+extern void test_vtab_batch_savepoint_recall(void);
+extern void test_vtab_multi_query_match(void);
+extern void test_vtab_multi_query_filtered(void);
+extern void test_vtab_query_index_reserved(void);
+extern void test_vtab_filter_cache_invalidation(void);
+extern void test_vtab_filter_cache_keys_values(void);
 
 /* Lazy back-edges error handling tests */
 extern void test_lazy_batch_close_without_end(void);
 extern void test_lazy_batch_empty_repair(void);
 extern void test_lazy_batch_single_insert(void);
-extern void test_lazy_batch_spillover(void);
+extern void test_lazy_batch_budget_repair(void);
+extern void test_insert_batch_empty_index(void);
+extern void test_insert_batch_existing_index(void);
 extern void test_batch_cache_eviction_use_after_free(void);
 
+/* SIMD distance kernel tests */
+extern void test_simd_scalar_always_available(void);
+extern void test_simd_selected_level_is_available(void);
+extern void test_simd_invalid_level_returns_null(void);
+extern void test_simd_distance_fn_by_metric(void);
+extern void test_simd_kernels_match_scalar(void);
+extern void test_simd_kernels_zero_vector(void);
+extern void test_simd_l2_bounded(void);
+
+/* PQ routing code tests */
+extern void test_pq_create_invalid(void);
+extern void test_pq_lossless_codes_l2(void);
+extern void test_pq_lossless_codes_cosine(void);
+extern void test_pq_lossless_codes_dot(void);
+extern void test_pq_train_approximates_l2(void);
+extern void test_pq_map_put_get_remove(void);
+
+/* Bulk build tests */
+extern void test_build_invalid(void);
+extern void test_build_empty_and_single(void);
+extern void test_build_recall_l2(void);
+extern void test_build_recall_cosine(void);
+extern void test_build_thread_count_deterministic(void);
+extern void test_build_progress_callback(void);
+extern void test_build_then_insert_and_rebuild(void);
+
+/* Rowid bitmap tests */
+extern void test_bitmap_empty(void);
+extern void test_bitmap_sparse_random(void);
+extern void test_bitmap_dense_range(void);
+extern void test_bitmap_copy(void);
+
+/* Label-aware graph tests */
+extern void test_label_hash_affinity(void);
+extern void test_label_map_entries(void);
+extern void test_label_search_stays_in_subgraph(void);
+extern void test_vtab_label_create(void);
+extern void test_vtab_label_filtered_search(void);
+
+/* Exact scan tests */
+extern void test_search_exact_matches_brute_force(void);
+extern void test_search_exact_validation(void);
+extern void test_search_exact_below_threshold(void);
+extern void test_vtab_exact_column(void);
+
+/* Streaming search tests */
+extern void test_search_stream_resumes_walk(void);
+extern void test_search_stream_range(void);
+extern void test_vtab_stream_range(void);
+extern void test_vtab_stream_beyond_beam(void);
+extern void test_vtab_meta_batch_fetch(void);
+extern void test_vtab_filter_stmt_reuse(void);
+extern void test_vtab_optimize_command(void);
+extern void test_vtab_shards_create_errors(void);
+extern void test_vtab_shards_rowid_routing(void);
+extern void test_vtab_shards_partition(void);
+
+/* Memory-mapped snapshot tests */
+extern void test_snapshot_matches_live_index(void);
+extern void test_snapshot_is_read_only(void);
+extern void test_snapshot_batch_and_readers(void);
+extern void test_snapshot_empty_index(void);
+extern void test_snapshot_rejects_bad_files(void);
+
+/* Optimize tests */
+extern void test_optimize_invalid(void);
+extern void test_optimize_preserves_results(void);
+extern void test_optimize_consolidates_tombstones(void);
+
+/* Half-precision vector storage tests */
+extern void test_half_conversions(void);
+extern void test_half_kernels_match_scalar(void);
+extern void test_half_block_layout(void);
+extern void test_half_index_recall(void);
+extern void test_half_requires_format_version(void);
+extern void test_half_build_pq_snapshot(void);
+
+/* Statistics tests */
+extern void test_stats_invalid(void);
+extern void test_stats_counts_inserts_and_searches(void);
+extern void test_stats_batch_and_stream(void);
+extern void test_stats_vtab(void);
+
+/* Recall calibration tests */
+extern void test_calibrate_invalid(void);
+extern void test_calibrate_stores_curve(void);
+extern void test_calibrate_sizes_search_list(void);
+extern void test_search_patience(void);
+extern void test_calibrate_vtab(void);
+
+/* Partitioned index tests */
+extern void test_shards_open_validation(void);
+extern void test_shards_routing(void);
+extern void test_shards_search_merges_shards(void);
+extern void test_shards_search_sees_pending_writes(void);
+extern void test_shards_readers_follow_growth(void);
+extern void test_shards_build_parallel(void);
+extern void test_shards_search_bitmap(void);
+
 void setUp(void) { /* Global setup if needed */ }
 
 void tearDown(void) { /* Global teardown if needed */ }
@@ -312,6 +487,7 @@ int main(void) {
   RUN_TEST(test_create_index_null_database);
   RUN_TEST(test_create_index_null_name);
   RUN_TEST(test_create_index_zero_dimensions);
+  RUN_TEST(test_create_index_invalid_metric);
   RUN_TEST(test_shadow_table_schema);
   RUN_TEST(test_create_index_invalid_name);
   RUN_TEST(test_metadata_roundtrip);
@@ -343,6 +519,7 @@ int main(void) {
   RUN_TEST(test_open_index_null_output);
   RUN_TEST(test_close_index_null);
   RUN_TEST(test_close_index_frees_resources);
+  RUN_TEST(test_close_index_finalizes_statements);
   RUN_TEST(test_open_multiple_indexes);
   RUN_TEST(test_reopen_same_index);
   RUN_TEST(test_open_index_rejects_huge_dimensions);
@@ -358,6 +535,12 @@ int main(void) {
   RUN_TEST(test_blob_spot_flush);
   RUN_TEST(test_blob_spot_flush_readonly);
   RUN_TEST(test_blob_spot_create_null_output);
+  RUN_TEST(test_blob_spot_partial_read);
+  RUN_TEST(test_blob_spot_load_pooled);
+  RUN_TEST(test_blob_pool_expired_handle);
+  RUN_TEST(test_blob_pool_insert_walks);
+  RUN_TEST(test_blob_spot_mark_dirty);
+  RUN_TEST(test_blob_spot_flush_dirty_ranges);
 
   /* LE serialization tests */
   RUN_TEST(test_le16_roundtrip);
@@ -392,6 +575,14 @@ int main(void) {
   RUN_TEST(test_distance_cosine_opposite);
   RUN_TEST(test_distance_dispatch_l2);
   RUN_TEST(test_distance_dispatch_cosine);
+  RUN_TEST(test_distance_dot_known_value);
+  RUN_TEST(test_distance_dispatch_dot);
+  RUN_TEST(test_node_bin_cosine_stores_inv_norm);
+  RUN_TEST(test_node_bin_l2_no_inv_norm);
+  RUN_TEST(test_max_edges_int8_3d_256block);
+  RUN_TEST(test_edge_int8_encode_decode);
+  RUN_TEST(test_node_bin_int8_edge_distances);
+  RUN_TEST(test_node_bin_int8_cosine_edge_norm);
 
   /* Buffer management tests */
   RUN_TEST(test_distance_buffer_insert_idx_empty);
@@ -451,6 +642,13 @@ int main(void) {
   RUN_TEST(test_delete_last_node);
   RUN_TEST(test_delete_double_delete);
   RUN_TEST(test_delete_zombie_edge);
+  RUN_TEST(test_delete_tombstone_hides_row);
+  RUN_TEST(test_delete_tombstone_consolidate);
+  RUN_TEST(test_delete_tombstone_reinsert);
+  RUN_TEST(test_delete_tombstone_threshold);
+  RUN_TEST(test_delete_mode_persists);
+  RUN_TEST(test_delete_batch);
+  RUN_TEST(test_delete_batch_deferred);
 
   /* Insert tests */
   RUN_TEST(test_insert_null_index);
@@ -464,17 +662,28 @@ int main(void) {
   RUN_TEST(test_insert_recall);
   RUN_TEST(test_insert_delete_search);
   RUN_TEST(test_insert_cosine_metric);
+  RUN_TEST(test_insert_dot_metric);
+  RUN_TEST(test_insert_cosine_distance_matches_exact);
+  RUN_TEST(test_dist_memo_basic);
+  RUN_TEST(test_insert_memo_edge_distances);
 
   /* Integration tests */
   RUN_TEST(test_integration_reopen_persistence);
   RUN_TEST(test_integration_clear_reinsert);
   RUN_TEST(test_integration_recall_128d);
+  RUN_TEST(test_integration_recall_int8_edges);
+  RUN_TEST(test_integration_int8_range_from_data);
+  RUN_TEST(test_integration_recall_pq);
   RUN_TEST(test_integration_delete_at_scale);
 
   /* Virtual table tests */
   RUN_TEST(test_vtab_create);
   RUN_TEST(test_vtab_create_no_dimension);
   RUN_TEST(test_vtab_create_bad_metric);
+  RUN_TEST(test_vtab_create_edge_type_int8);
+  RUN_TEST(test_vtab_create_bad_edge_type);
+  RUN_TEST(test_vtab_vector_type_f16);
+  RUN_TEST(test_vtab_create_bad_vector_type);
   RUN_TEST(test_vtab_drop);
   RUN_TEST(test_vtab_create_sql_injection);
   RUN_TEST(test_vtab_insert_blob);
@@ -490,6 +699,8 @@ int main(void) {
   RUN_TEST(test_vtab_search_no_match);
   RUN_TEST(test_vtab_delete);
   RUN_TEST(test_vtab_delete_nonexistent);
+  RUN_TEST(test_vtab_delete_tombstone);
+  RUN_TEST(test_vtab_delete_multi_row);
   RUN_TEST(test_vtab_reopen);
 
   /* Virtual table metadata column tests (Phase 2) */
@@ -529,6 +740,32 @@ int main(void) {
   /* Dynamic search list size scaling tests */
   RUN_TEST(test_effective_search_list_size_small_index);
   RUN_TEST(test_effective_search_list_size_scales_up);
+  RUN_TEST(test_entry_point_set_on_first_insert);
+  RUN_TEST(test_entry_point_refresh_picks_central_node);
+  RUN_TEST(test_entry_point_refreshed_at_end_batch);
+  RUN_TEST(test_entry_point_delete_hands_off);
+  RUN_TEST(test_entry_point_stale_falls_back);
+  RUN_TEST(test_read_cache_serves_repeat_queries);
+  RUN_TEST(test_read_cache_invalidated_by_writes);
+  RUN_TEST(test_read_cache_cleared_by_other_connection);
+  RUN_TEST(test_search_wide_beam_matches_brute_force);
+  RUN_TEST(test_search_pool_reused_across_queries);
+  RUN_TEST(test_search_pool_nested_acquire);
+  RUN_TEST(test_partial_reads_match_full_float32);
+  RUN_TEST(test_partial_reads_match_full_int8);
+  RUN_TEST(test_partial_reads_match_full_pq);
+  RUN_TEST(test_beam_width_invalid);
+  RUN_TEST(test_beam_width_recall);
+  RUN_TEST(test_beam_width_skips_deleted);
+  RUN_TEST(test_filter_plan_by_selectivity);
+  RUN_TEST(test_search_bitmap_matches_brute_force);
+  RUN_TEST(test_search_batch_validation);
+  RUN_TEST(test_search_batch_workers_match_sequential);
+  RUN_TEST(test_search_batch_sequential_fallbacks);
+  RUN_TEST(test_search_batch_sees_pending_writes);
+  RUN_TEST(test_search_ex_params);
+  RUN_TEST(test_open_reader_concurrent_search);
+  RUN_TEST(test_open_reader_follows_shared_handle);
 
   /* Hash set tests (build speed optimization) */
   RUN_TEST(test_visited_set_init);
@@ -537,6 +774,8 @@ int main(void) {
   RUN_TEST(test_visited_set_wraparound);
   RUN_TEST(test_visited_set_duplicates);
   RUN_TEST(test_visited_set_full_table);
+  RUN_TEST(test_visited_set_clear);
+  RUN_TEST(test_visited_set_states_and_growth);
   RUN_TEST(test_visited_set_null_safety);
 
   /* BLOB cache tests (build speed optimization) */
@@ -557,6 +796,10 @@ int main(void) {
   RUN_TEST(test_cache_owning_deinit_frees);
   RUN_TEST(test_cache_non_owning_no_flag);
   RUN_TEST(test_cache_same_pointer_no_leak);
+  RUN_TEST(test_cache_remove_keeps_lru_chain);
+  RUN_TEST(test_cache_clear);
+  RUN_TEST(test_cache_byte_budget_evicts);
+  RUN_TEST(test_cache_hash_index_churn);
 
   /* Batch insert tests */
   RUN_TEST(test_batch_begin_end);
@@ -570,7 +813,7 @@ int main(void) {
 
   /* Deferred edge list unit tests */
   RUN_TEST(test_deferred_edge_list_lifecycle);
-  RUN_TEST(test_deferred_edge_list_capacity);
+  RUN_TEST(test_deferred_edge_list_shared_vectors);
   RUN_TEST(test_deferred_edge_list_truncate);
   RUN_TEST(test_deferred_edge_list_empty_deinit);
 
@@ -586,15 +829,124 @@ int main(void) {
   RUN_TEST(test_vtab_batch_autocommit);
   RUN_TEST(test_vtab_batch_rollback);
   RUN_TEST(test_vtab_batch_multiple_txns);
+  RUN_TEST(test_vtab_batch_savepoint_recall);
+  RUN_TEST(test_vtab_multi_query_match);
+  RUN_TEST(test_vtab_multi_query_filtered);
+  RUN_TEST(test_vtab_query_index_reserved);
+  RUN_TEST(test_vtab_filter_cache_invalidation);
+  RUN_TEST(test_vtab_filter_cache_keys_values);
 
   /* Lazy back-edges error handling tests */
   RUN_TEST(test_lazy_batch_close_without_end);
   RUN_TEST(test_lazy_batch_empty_repair);
   RUN_TEST(test_lazy_batch_single_insert);
-  RUN_TEST(test_lazy_batch_spillover);
+  RUN_TEST(test_lazy_batch_budget_repair);
+
+  /* diskann_insert_batch() tests */
+  RUN_TEST(test_insert_batch_empty_index);
+  RUN_TEST(test_insert_batch_existing_index);
 
   /* Cache eviction regression test */
   RUN_TEST(test_batch_cache_eviction_use_after_free);
 
+  /* SIMD distance kernel tests */
+  RUN_TEST(test_simd_scalar_always_available);
+  RUN_TEST(test_simd_selected_level_is_available);
+  RUN_TEST(test_simd_invalid_level_returns_null);
+  RUN_TEST(test_simd_distance_fn_by_metric);
+  RUN_TEST(test_simd_kernels_match_scalar);
+  RUN_TEST(test_simd_kernels_zero_vector);
+  RUN_TEST(test_simd_l2_bounded);
+
+  /* PQ routing code tests */
+  RUN_TEST(test_pq_create_invalid);
+  RUN_TEST(test_pq_lossless_codes_l2);
+  RUN_TEST(test_pq_lossless_codes_cosine);
+  RUN_TEST(test_pq_lossless_codes_dot);
+  RUN_TEST(test_pq_train_approximates_l2);
+  RUN_TEST(test_pq_map_put_get_remove);
+
+  /* Bulk build tests */
+  RUN_TEST(test_build_invalid);
+  RUN_TEST(test_build_empty_and_single);
+  RUN_TEST(test_build_recall_l2);
+  RUN_TEST(test_build_recall_cosine);
+  RUN_TEST(test_build_thread_count_deterministic);
+  RUN_TEST(test_build_progress_callback);
+  RUN_TEST(test_build_then_insert_and_rebuild);
+
+  /* Rowid bitmap tests */
+  RUN_TEST(test_bitmap_empty);
+  RUN_TEST(test_bitmap_sparse_random);
+  RUN_TEST(test_bitmap_dense_range);
+  RUN_TEST(test_bitmap_copy);
+
+  /* Label-aware graph tests */
+  RUN_TEST(test_label_hash_affinity);
+  RUN_TEST(test_label_map_entries);
+  RUN_TEST(test_label_search_stays_in_subgraph);
+  RUN_TEST(test_vtab_label_create);
+  RUN_TEST(test_vtab_label_filtered_search);
+
+  /* Exact scan tests */
+  RUN_TEST(test_search_exact_matches_brute_force);
+  RUN_TEST(test_search_exact_validation);
+  RUN_TEST(test_search_exact_below_threshold);
+  RUN_TEST(test_vtab_exact_column);
+
+  /* Streaming search tests */
+  RUN_TEST(test_search_stream_resumes_walk);
+  RUN_TEST(test_search_stream_range);
+  RUN_TEST(test_vtab_stream_range);
+  RUN_TEST(test_vtab_stream_beyond_beam);
+  RUN_TEST(test_vtab_meta_batch_fetch);
+  RUN_TEST(test_vtab_filter_stmt_reuse);
+  RUN_TEST(test_vtab_optimize_command);
+  RUN_TEST(test_vtab_shards_create_errors);
+  RUN_TEST(test_vtab_shards_rowid_routing);
+  RUN_TEST(test_vtab_shards_partition);
+
+  /* Memory-mapped snapshot tests */
+  RUN_TEST(test_snapshot_matches_live_index);
+  RUN_TEST(test_snapshot_is_read_only);
+  RUN_TEST(test_snapshot_batch_and_readers);
+  RUN_TEST(test_snapshot_empty_index);
+  RUN_TEST(test_snapshot_rejects_bad_files);
+
+  /* Optimize tests */
+  RUN_TEST(test_optimize_invalid);
+  RUN_TEST(test_optimize_preserves_results);
+  RUN_TEST(test_optimize_consolidates_tombstones);
+
+  /* Half-precision vector storage tests */
+  RUN_TEST(test_half_conversions);
+  RUN_TEST(test_half_kernels_match_scalar);
+  RUN_TEST(test_half_block_layout);
+  RUN_TEST(test_half_index_recall);
+  RUN_TEST(test_half_requires_format_version);
+  RUN_TEST(test_half_build_pq_snapshot);
+
+  /* Statistics tests */
+  RUN_TEST(test_stats_invalid);
+  RUN_TEST(test_stats_counts_inserts_and_searches);
+  RUN_TEST(test_stats_batch_and_stream);
+  RUN_TEST(test_stats_vtab);
+
+  /* Recall calibration tests */
+  RUN_TEST(test_calibrate_invalid);
+  RUN_TEST(test_calibrate_stores_curve);
+  RUN_TEST(test_calibrate_sizes_search_list);
+  RUN_TEST(test_search_patience);
+  RUN_TEST(test_calibrate_vtab);
+
+  /* Partitioned index tests */
+  RUN_TEST(test_shards_open_validation);
+  RUN_TEST(test_shards_routing);
+  RUN_TEST(test_shards_search_merges_shards);
+  RUN_TEST(test_shards_search_sees_pending_writes);
+  RUN_TEST(test_shards_readers_follow_growth);
+  RUN_TEST(test_shards_build_parallel);
+  RUN_TEST(test_shards_search_bitmap);
+
   return UNITY_END();
 }
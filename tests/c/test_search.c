@@ -31,6 +31,32 @@
 **
 ** 6. COSINE METRIC — verify search works with cosine distance
 **
+** 7. ENTRY POINT — persisted medoid start node: set on first insert,
+**    refreshed toward the center, handed off on delete, stale fallback
+**
+** 8. READ CACHE — diskann_set_cache_budget(): repeat queries skip BLOB
+**    reads, and writes through the handle invalidate cached blocks
+**
+** 9. PARTIAL READS — large blocks read adjacency first and only the
+**    vectors that get scored; results match full-block reads
+**
+** 10. SEARCH POOL — the per-index search context is reused across
+**     queries without new allocations; nested searches get their own
+**
+** 11. BEAM WIDTH — diskann_set_beam_width(): hops that expand several
+**     candidates keep recall, match cached reads and skip deleted nodes
+**
+** 12. BITMAP FILTER — diskann_search_bitmap(): the planner scans narrow
+**     filters exactly and walks the graph for broad ones
+**
+** 13. BATCH SEARCH — diskann_search_batch() matches per-query
+**     diskann_search() with worker connections (file DB) and on the
+**     sequential fallbacks (:memory:, open write transaction)
+**
+** 14. SHARED READERS — diskann_search_ex() applies per-query parameters
+**     without touching the handle; diskann_open_reader() handles on
+**     their own connections search concurrently and refuse writes
+**
 ** Test data setup:
 **   Tests use small 3D vectors for human-verifiable distances.
 **   Graph data is inserted by:
@@ -45,15 +71,26 @@
 */
 #include "../../src/diskann.h"
 #include "../../src/diskann_blob.h"
+#include "../../src/diskann_cache.h"
 #include "../../src/diskann_internal.h"
+#include "../../src/diskann_label.h"
 #include "../../src/diskann_node.h"
 #include "../../src/diskann_search.h"
+#include "../../src/diskann_thread.h"
 #include "unity/unity.h"
 #include <math.h>
 #include <sqlite3.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Platform-specific temp directory (multi-connection tests need a file) */
+#ifdef _WIN32
+#define SEARCH_TEST_DB "diskann_test_search.db"
+#else
+#define SEARCH_TEST_DB "/tmp/diskann_test_search.db"
+#endif
+
 /*
 ** Test configuration: 3D vectors, auto-calculated block size.
 */
@@ -86,6 +123,8 @@ static DiskAnnIndex *create_test_index(sqlite3 *db, const char *name,
   if (rc != DISKANN_OK)
     return NULL;
 
+  /* These indexes are tiny: keep searches on the graph under test */
+  diskann_set_exact_scan_threshold(idx, 0);
   return idx;
 }
 
@@ -750,9 +789,11 @@ void test_visited_set_init(void) {
   TEST_ASSERT_EQUAL(0, set.count);
   TEST_ASSERT_NOT_NULL(set.rowids);
 
-  /* Verify all slots initialized to empty sentinel (0xFFFFFFFFFFFFFFFF) */
-  for (int i = 0; i < 10; i++) {
-    TEST_ASSERT_EQUAL_UINT64(0xFFFFFFFFFFFFFFFFULL, set.rowids[i]);
+  /* Verify no slot carries the current generation stamp */
+  TEST_ASSERT_NOT_NULL(set.stamps);
+  TEST_ASSERT_TRUE(set.stamp != 0);
+  for (int i = 0; i < 256; i++) {
+    TEST_ASSERT_TRUE(set.stamps[i] != set.stamp);
   }
 
   visited_set_deinit(&set);
@@ -869,7 +910,62 @@ void test_visited_set_full_table(void) {
   visited_set_deinit(&set);
 }
 
-/* Test 7: NULL safety for visited set functions */
+/* Test 7: clear empties the set without touching the slots */
+void test_visited_set_clear(void) {
+  VisitedSet set;
+  visited_set_init(&set, 256);
+  for (uint64_t i = 1; i <= 100; i++) {
+    visited_set_add(&set, i);
+  }
+
+  visited_set_clear(&set);
+  TEST_ASSERT_EQUAL(0, set.count);
+  for (uint64_t i = 1; i <= 100; i++) {
+    TEST_ASSERT_EQUAL(0, visited_set_contains(&set, i));
+  }
+  visited_set_add(&set, 5);
+  TEST_ASSERT_EQUAL(1, visited_set_contains(&set, 5));
+  TEST_ASSERT_EQUAL(0, visited_set_contains(&set, 6));
+
+  /* Stamp wraparound rewrites the stamps instead of reusing 0 */
+  set.stamp = 0xFFFFFFFFu;
+  visited_set_add(&set, 7);
+  visited_set_clear(&set);
+  TEST_ASSERT_EQUAL_UINT32(1, set.stamp);
+  TEST_ASSERT_EQUAL(0, visited_set_contains(&set, 5));
+  TEST_ASSERT_EQUAL(0, visited_set_contains(&set, 7));
+
+  visited_set_deinit(&set);
+}
+
+/* Test 8: queued/visited states survive updates and growth */
+void test_visited_set_states_and_growth(void) {
+  VisitedSet set;
+  visited_set_init(&set, 8);
+  TEST_ASSERT_EQUAL_UINT8(0, visited_set_state(&set, 1));
+
+  for (uint64_t i = 1; i <= 100; i++) {
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      visited_set_put(&set, i * 1000, VISITED_SET_QUEUED));
+  }
+  TEST_ASSERT_EQUAL(100, set.count);
+  TEST_ASSERT_TRUE(set.capacity >= 200); /* kept at most half full */
+
+  for (uint64_t i = 1; i <= 100; i += 2) {
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      visited_set_put(&set, i * 1000, VISITED_SET_VISITED));
+  }
+  TEST_ASSERT_EQUAL(100, set.count); /* updates in place */
+  for (uint64_t i = 1; i <= 100; i++) {
+    TEST_ASSERT_EQUAL_UINT8(i % 2 ? VISITED_SET_VISITED : VISITED_SET_QUEUED,
+                            visited_set_state(&set, i * 1000));
+  }
+  TEST_ASSERT_EQUAL_UINT8(0, visited_set_state(&set, 999));
+
+  visited_set_deinit(&set);
+}
+
+/* Test 9: NULL safety for visited set functions */
 void test_visited_set_null_safety(void) {
   /* visited_set_deinit with NULL — should not crash */
   visited_set_deinit(NULL);
@@ -883,7 +979,9 @@ void test_visited_set_null_safety(void) {
 **************************************************************************/
 
 /* Exposed via TESTING ifdef */
-extern int effective_search_list_size(DiskAnnIndex *idx);
+extern int effective_search_list_size(DiskAnnIndex *idx,
+                                      const DiskAnnSearchParams *params,
+                                      int k);
 
 void test_effective_search_list_size_small_index(void) {
   /* Small index (few rows) should use configured default */
@@ -894,7 +992,7 @@ void test_effective_search_list_size_small_index(void) {
   TEST_ASSERT_NOT_NULL(idx);
 
   /* Empty index: should return configured value */
-  int sls = effective_search_list_size(idx);
+  int sls = effective_search_list_size(idx, NULL, 0);
   TEST_ASSERT_EQUAL(TEST_SEARCH_L, sls);
 
   /* Insert a few rows via diskann_insert */
@@ -906,7 +1004,7 @@ void test_effective_search_list_size_small_index(void) {
   }
 
   /* 5 rows: sqrt(5) ≈ 2, well below configured 32, should use configured */
-  sls = effective_search_list_size(idx);
+  sls = effective_search_list_size(idx, NULL, 0);
   TEST_ASSERT_EQUAL(TEST_SEARCH_L, sls);
 
   diskann_close_index(idx);
@@ -943,7 +1041,7 @@ void test_effective_search_list_size_scales_up(void) {
     TEST_ASSERT_EQUAL(DISKANN_OK, rc);
   }
 
-  int sls = effective_search_list_size(idx);
+  int sls = effective_search_list_size(idx, NULL, 0);
   /* sqrt(200) ≈ 14.1, so effective should be 14 (> configured 10) */
   TEST_ASSERT_TRUE(sls >= 14);
   TEST_ASSERT_TRUE(sls > 10); /* Must be above configured */
@@ -952,4 +1050,1444 @@ void test_effective_search_list_size_scales_up(void) {
   sqlite3_close(db);
 }
 
+/**************************************************************************
+** Entry point tests
+**************************************************************************/
+
+/* Insert ids 1..n at (i, 0, 0): the medoid is the middle id */
+static void insert_line(DiskAnnIndex *idx, int n) {
+  for (int i = 1; i <= n; i++) {
+    float vec[TEST_DIMS] = {(float)i, 0.0f, 0.0f};
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i, vec, TEST_DIMS));
+  }
+}
+
+void test_entry_point_set_on_first_insert(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_entry_first", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL_INT(0, idx->has_entry);
+
+  float vec[TEST_DIMS] = {1.0f, 2.0f, 3.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 42, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(1, idx->has_entry);
+  TEST_ASSERT_EQUAL_INT64(42, idx->entry_rowid);
+
+  /* Persisted in metadata */
+  diskann_close_index(idx);
+  idx = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_open_index(db, "main", "test_entry_first", &idx));
+  TEST_ASSERT_EQUAL_INT(1, idx->has_entry);
+  TEST_ASSERT_EQUAL_INT64(42, idx->entry_rowid);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_entry_point_refresh_picks_central_node(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_entry_medoid", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 101);
+  TEST_ASSERT_EQUAL_INT64(1, idx->entry_rowid); /* first insert */
+
+  uint32_t refresh_at = idx->entry_refresh_at;
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_refresh_entry_point(idx));
+  /* Sampled medoid lands near the middle of the line */
+  TEST_ASSERT_INT64_WITHIN(15, 51, idx->entry_rowid);
+  TEST_ASSERT_EQUAL_UINT32(0, idx->entry_inserts);
+  TEST_ASSERT_EQUAL_UINT32(refresh_at * 2, idx->entry_refresh_at);
+
+  /* Search starts there and still finds the nearest node */
+  float query[TEST_DIMS] = {100.0f, 0.0f, 0.0f};
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, query, TEST_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(100, res[0].id);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_entry_point_refreshed_at_end_batch(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_entry_batch", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_begin_batch(idx, 0));
+  insert_line(idx, DISKANN_ENTRY_REFRESH_MIN_INSERTS + 1);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_end_batch(idx));
+
+  TEST_ASSERT_EQUAL_UINT32(0, idx->entry_inserts);
+  TEST_ASSERT_EQUAL_UINT32(DISKANN_ENTRY_REFRESH_MIN_INSERTS * 2,
+                           idx->entry_refresh_at);
+  TEST_ASSERT_EQUAL_INT(1, idx->has_entry);
+
+  /* A small batch below the threshold leaves the entry point alone */
+  int64_t entry = idx->entry_rowid;
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_begin_batch(idx, 0));
+  float vec[TEST_DIMS] = {0.5f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 1000, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_end_batch(idx));
+  TEST_ASSERT_EQUAL_INT64(entry, idx->entry_rowid);
+  TEST_ASSERT_EQUAL_UINT32(1, idx->entry_inserts);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_entry_point_delete_hands_off(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_entry_delete", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 5);
+  TEST_ASSERT_EQUAL_INT64(1, idx->entry_rowid);
+
+  /* Deleting the entry hands it to one of its neighbors */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 1));
+  TEST_ASSERT_EQUAL_INT(1, idx->has_entry);
+  TEST_ASSERT_TRUE(idx->entry_rowid >= 2 && idx->entry_rowid <= 5);
+
+  /* Deleting everything clears it; searches see an empty index */
+  for (int i = 2; i <= 5; i++) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, i));
+  }
+  TEST_ASSERT_EQUAL_INT(0, idx->has_entry);
+  float query[TEST_DIMS] = {1.0f, 0.0f, 0.0f};
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(0, diskann_search(idx, query, TEST_DIMS, 1, res));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_entry_point_stale_falls_back(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_entry_stale", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 10);
+
+  /* Simulate the entry node vanishing behind this handle's back */
+  idx->entry_rowid = 9999;
+  float query[TEST_DIMS] = {3.0f, 0.0f, 0.0f};
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, query, TEST_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(3, res[0].id);
+  TEST_ASSERT_EQUAL_INT(0, idx->has_entry);
+
+  /* Inserts recover the same way */
+  idx->has_entry = 1;
+  float vec[TEST_DIMS] = {11.0f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 11, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(0, idx->has_entry);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Shared read cache tests
+**************************************************************************/
+
+void test_read_cache_serves_repeat_queries(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_read_cache", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 50);
+
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_set_cache_budget(NULL, 1));
+  /* Budget below one block leaves the cache disabled */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1));
+  TEST_ASSERT_NULL(idx->read_cache);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+  TEST_ASSERT_NOT_NULL(idx->read_cache);
+
+  float query[TEST_DIMS] = {20.0f, 0.0f, 0.0f};
+  DiskAnnResult first[5], second[5];
+  int n = diskann_search(idx, query, TEST_DIMS, 5, first);
+  TEST_ASSERT_EQUAL_INT(5, n);
+  uint64_t reads = idx->num_reads;
+  TEST_ASSERT_TRUE(idx->read_cache->count > 0);
+
+  /* Same query again: every block comes from memory */
+  TEST_ASSERT_EQUAL_INT(5, diskann_search(idx, query, TEST_DIMS, 5, second));
+  TEST_ASSERT_EQUAL_UINT64(reads, idx->num_reads);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(first[i].id, second[i].id);
+    TEST_ASSERT_EQUAL_FLOAT(first[i].distance, second[i].distance);
+  }
+
+  /* Disabling frees the cache */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 0));
+  TEST_ASSERT_NULL(idx->read_cache);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_read_cache_invalidated_by_writes(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_read_cache_inv", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 30);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+
+  float query[TEST_DIMS] = {10.2f, 0.0f, 0.0f};
+  DiskAnnResult res[3];
+  TEST_ASSERT_EQUAL_INT(3, diskann_search(idx, query, TEST_DIMS, 3, res));
+  TEST_ASSERT_EQUAL_INT64(10, res[0].id);
+
+  /* A new node is reachable only through rewritten (uncached) blocks */
+  float vec[TEST_DIMS] = {10.25f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 100, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(3, diskann_search(idx, query, TEST_DIMS, 3, res));
+  TEST_ASSERT_EQUAL_INT64(100, res[0].id);
+
+  /* Deleted nodes must not come back from cached copies */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 100));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 10));
+  int n = diskann_search(idx, query, TEST_DIMS, 3, res);
+  TEST_ASSERT_EQUAL_INT(3, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(res[i].id != 100 && res[i].id != 10);
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_read_cache_cleared_by_other_connection(void) {
+  const char *path = SEARCH_TEST_DB;
+  remove(path);
+  sqlite3 *db, *db2;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db));
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db2));
+  DiskAnnIndex *idx = create_test_index(db, "test_read_cache_ext", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 20);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+
+  float query[TEST_DIMS] = {5.0f, 0.0f, 0.0f};
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, query, TEST_DIMS, 1, res));
+  TEST_ASSERT_TRUE(idx->read_cache->count > 0);
+
+  /* A write from another connection bumps the data version */
+  DiskAnnIndex *idx2 = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_open_index(db2, "main",
+                                                   "test_read_cache_ext",
+                                                   &idx2));
+  float vec[TEST_DIMS] = {5.1f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx2, 200, vec, TEST_DIMS));
+  diskann_close_index(idx2);
+
+  query[0] = 5.2f;
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, query, TEST_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(200, res[0].id);
+
+  diskann_close_index(idx);
+  sqlite3_close(db2);
+  sqlite3_close(db);
+  remove(path);
+}
+
+/*
+** A beam wider than the index keeps every node it reaches, so the heap
+** queue must return the exact top-k in order.
+*/
+void test_search_wide_beam_matches_brute_force(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_test_index(db, "test_wide_beam", DISKANN_METRIC_EUCLIDEAN);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  enum { N = 300, K = 10 };
+  static float vectors[N][TEST_DIMS];
+  uint32_t seed = 777;
+  for (int i = 0; i < N; i++) {
+    for (int d = 0; d < TEST_DIMS; d++) {
+      seed = seed * 1103515245 + 12345;
+      vectors[i][d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_insert(idx, i + 1, vectors[i], TEST_DIMS));
+  }
+  idx->search_list_size = 2 * N;
+
+  for (int q = 0; q < 5; q++) {
+    float query[TEST_DIMS] = {0.2f * (float)q, 0.5f, 1.0f - 0.2f * (float)q};
+    int64_t bf_ids[K];
+    float bf_distances[K];
+    brute_force_knn((const float *)vectors, N, TEST_DIMS,
+                    DISKANN_METRIC_EUCLIDEAN, query, K, bf_ids, bf_distances);
+
+    DiskAnnResult res[K];
+    TEST_ASSERT_EQUAL_INT(K, diskann_search(idx, query, TEST_DIMS, K, res));
+    for (int i = 0; i < K; i++) {
+      TEST_ASSERT_EQUAL_INT64(bf_ids[i], res[i].id);
+      TEST_ASSERT_FLOAT_WITHIN(1e-5f, bf_distances[i], res[i].distance);
+    }
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Pooled search context tests
+**************************************************************************/
+
+void test_search_pool_reused_across_queries(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_search_pool", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 40);
+  TEST_ASSERT_NULL(idx->search_pool);
+
+  float query[TEST_DIMS] = {12.0f, 0.0f, 0.0f};
+  DiskAnnResult first[5], second[5];
+  TEST_ASSERT_EQUAL_INT(5, diskann_search(idx, query, TEST_DIMS, 5, first));
+  DiskAnnSearchCtx *pool = idx->search_pool;
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(pool->node_chunks);
+  TEST_ASSERT_NULL(pool->visited_list);
+  TEST_ASSERT_NULL(pool->hop[0].spot->pBlob); /* handle closed */
+
+  /* Steady state: same buffers, no new node chunks */
+  DiskAnnNodeChunk *chunks = pool->node_chunks;
+  DiskAnnNode **candidates = pool->candidates;
+  uint64_t *rowids = pool->visited_set.rowids;
+  for (int q = 0; q < 3; q++) {
+    TEST_ASSERT_EQUAL_INT(5,
+                          diskann_search(idx, query, TEST_DIMS, 5, second));
+    TEST_ASSERT_EQUAL_PTR(pool, idx->search_pool);
+    TEST_ASSERT_EQUAL_PTR(chunks, pool->node_chunks);
+    TEST_ASSERT_NULL(pool->node_chunks->next);
+    TEST_ASSERT_EQUAL_PTR(candidates, pool->candidates);
+    TEST_ASSERT_EQUAL_PTR(rowids, pool->visited_set.rowids);
+    for (int i = 0; i < 5; i++) {
+      TEST_ASSERT_EQUAL_INT64(first[i].id, second[i].id);
+      TEST_ASSERT_EQUAL_FLOAT(first[i].distance, second[i].distance);
+    }
+  }
+
+  /* Writes between queries are seen (the pooled buffer is not reused) */
+  float moved[TEST_DIMS] = {12.0f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 100, moved, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(5, diskann_search(idx, query, TEST_DIMS, 5, second));
+  TEST_ASSERT_TRUE(second[0].id == 12 || second[0].id == 100);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, second[1].distance);
+
+  /* A larger k grows the arrays in place of the old ones */
+  DiskAnnResult many[30];
+  TEST_ASSERT_EQUAL_INT(30, diskann_search(idx, query, TEST_DIMS, 30, many));
+  TEST_ASSERT_TRUE(idx->search_pool->cap_top >= 30);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_search_pool_nested_acquire(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_search_pool_nest", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 5);
+
+  float query[TEST_DIMS] = {2.0f, 0.0f, 0.0f};
+  DiskAnnSearchCtx *outer = NULL, *inner = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_ctx_acquire(idx, &outer, query, 10, 1));
+  TEST_ASSERT_NULL(idx->search_pool);
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_ctx_acquire(idx, &inner, query, 10, 1));
+  TEST_ASSERT_TRUE(outer != inner);
+
+  /* While checked out, searches still work on a fresh context */
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_search(idx, query, TEST_DIMS, 1, res));
+  TEST_ASSERT_EQUAL_INT64(2, res[0].id);
+
+  /* First release refills the pool, the rest are freed */
+  diskann_search_ctx_release(idx, inner);
+  DiskAnnSearchCtx *pooled = idx->search_pool;
+  TEST_ASSERT_NOT_NULL(pooled);
+  diskann_search_ctx_release(idx, outer);
+  TEST_ASSERT_EQUAL_PTR(pooled, idx->search_pool);
+  diskann_search_ctx_release(idx, NULL);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Partial read tests
+**************************************************************************/
+
+#define PARTIAL_DIMS 64
+
+static void partial_vector(int i, float *v) {
+  uint32_t state = (uint32_t)i * 2654435761u + 1u;
+  for (int d = 0; d < PARTIAL_DIMS; d++) {
+    state = state * 1664525u + 1013904223u;
+    v[d] = (float)(state >> 8) / (float)(1u << 24);
+  }
+}
+
+/*
+** Search with partial reads (no cache) and full reads (read cache) and
+** compare. max_ratio bounds partial bytes / full bytes.
+*/
+static void check_partial_reads(uint8_t edge_type, uint32_t block_size,
+                                int use_pq, double max_ratio) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnConfig config = {.dimensions = PARTIAL_DIMS,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 32,
+                          .search_list_size = 40,
+                          .insert_list_size = 60,
+                          .block_size = block_size,
+                          .edge_type = edge_type,
+                          .quant_min = 0.0f,
+                          .quant_max = 1.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_create_index(db, "main", "test_partial", &config));
+  DiskAnnIndex *idx = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_open_index(db, "main", "test_partial", &idx));
+  TEST_ASSERT_TRUE(idx->block_size >= 8192); /* partial read threshold */
+  diskann_set_exact_scan_threshold(idx, 0);
+
+  float v[PARTIAL_DIMS];
+  for (int i = 1; i <= 200; i++) {
+    partial_vector(i, v);
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i, v, PARTIAL_DIMS));
+  }
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, 7));
+  if (use_pq) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_pq_build(idx, 8, 0));
+  }
+
+  DiskAnnResult partial[10], full[10];
+  for (int q = 0; q < 5; q++) {
+    partial_vector(1000 + q, v);
+
+    /* No read cache: partial reads */
+    uint64_t before = idx->num_read_bytes;
+    int n = diskann_search(idx, v, PARTIAL_DIMS, 10, partial);
+    uint64_t partial_bytes = idx->num_read_bytes - before;
+
+    /* A read cache loads full blocks (cleared so every block is read) */
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 24));
+    before = idx->num_read_bytes;
+    TEST_ASSERT_EQUAL_INT(n, diskann_search(idx, v, PARTIAL_DIMS, 10, full));
+    uint64_t full_bytes = idx->num_read_bytes - before;
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 0));
+
+    TEST_ASSERT_EQUAL_INT(10, n);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_INT64(full[i].id, partial[i].id);
+      TEST_ASSERT_EQUAL_FLOAT(full[i].distance, partial[i].distance);
+      TEST_ASSERT_TRUE(partial[i].id != 7);
+    }
+    TEST_ASSERT_TRUE_MESSAGE((double)partial_bytes <
+                                 max_ratio * (double)full_bytes,
+                             "partial reads should fetch fewer bytes");
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* Edge vectors of already-seen neighbors and unused slots are skipped */
+void test_partial_reads_match_full_float32(void) {
+  check_partial_reads(DISKANN_EDGE_FLOAT32, 0, 0, 0.9);
+}
+
+/* Reranking reads the node vector too */
+void test_partial_reads_match_full_int8(void) {
+  check_partial_reads(DISKANN_EDGE_INT8, 16384, 0, 0.9);
+}
+
+/* PQ codes live in RAM: only adjacency and the rerank vector are read */
+void test_partial_reads_match_full_pq(void) {
+  check_partial_reads(DISKANN_EDGE_FLOAT32, 0, 1, 0.25);
+}
+
 /* main() is in test_runner.c */
+
+/**************************************************************************
+** Beam width tests
+**************************************************************************/
+
+#define BEAM_N 400
+#define BEAM_K 10
+
+void test_beam_width_invalid(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_beam_invalid", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL_UINT32(1, idx->beam_width);
+
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_set_beam_width(NULL, 2));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_set_beam_width(idx, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_set_beam_width(idx, DISKANN_MAX_BEAM_WIDTH + 1));
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_beam_width(idx, DISKANN_MAX_BEAM_WIDTH));
+  TEST_ASSERT_EQUAL_UINT32(DISKANN_MAX_BEAM_WIDTH, idx->beam_width);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Recall@10 against brute force for each width, with partial reads (no
+** cache) and full reads (read cache) returning the same results.
+*/
+void test_beam_width_recall(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnConfig config = {.dimensions = PARTIAL_DIMS,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 32,
+                          .search_list_size = 40,
+                          .insert_list_size = 60};
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_create_index(db, "main", "test_beam", &config));
+  DiskAnnIndex *idx = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_open_index(db, "main", "test_beam", &idx));
+
+  static float vectors[BEAM_N * PARTIAL_DIMS];
+  for (int i = 0; i < BEAM_N; i++) {
+    partial_vector(i + 1, vectors + i * PARTIAL_DIMS);
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_insert(idx, i + 1, vectors + i * PARTIAL_DIMS,
+                                     PARTIAL_DIMS));
+  }
+
+  const uint32_t widths[] = {1, 4, DISKANN_MAX_BEAM_WIDTH};
+  for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_beam_width(idx, widths[w]));
+    int hits = 0;
+    for (int q = 0; q < 10; q++) {
+      float query[PARTIAL_DIMS];
+      partial_vector(5000 + q, query);
+      int64_t bf_ids[BEAM_K];
+      float bf_distances[BEAM_K];
+      brute_force_knn(vectors, BEAM_N, PARTIAL_DIMS,
+                      DISKANN_METRIC_EUCLIDEAN, query, BEAM_K, bf_ids,
+                      bf_distances);
+
+      DiskAnnResult partial[BEAM_K], full[BEAM_K];
+      TEST_ASSERT_EQUAL_INT(BEAM_K, diskann_search(idx, query, PARTIAL_DIMS,
+                                                   BEAM_K, partial));
+      TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 24));
+      TEST_ASSERT_EQUAL_INT(BEAM_K, diskann_search(idx, query, PARTIAL_DIMS,
+                                                   BEAM_K, full));
+      TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 0));
+
+      for (int i = 0; i < BEAM_K; i++) {
+        TEST_ASSERT_EQUAL_INT64(full[i].id, partial[i].id);
+        TEST_ASSERT_EQUAL_FLOAT(full[i].distance, partial[i].distance);
+        if (i > 0) {
+          TEST_ASSERT_TRUE(partial[i - 1].distance <= partial[i].distance);
+        }
+        for (int j = 0; j < BEAM_K; j++) {
+          if (partial[i].id == bf_ids[j]) {
+            hits++;
+            break;
+          }
+        }
+      }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(hits >= 90, "recall@10 below 0.9");
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* Deleted neighbors taken in the same hop are dropped, not returned */
+void test_beam_width_skips_deleted(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_beam_deleted", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 40);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_beam_width(idx, 8));
+
+  /* Remove shadow rows behind the index's back: the graph keeps edges to
+  ** them, so the search meets them as zombies */
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_exec(db,
+                                 "DELETE FROM test_beam_deleted_shadow "
+                                 "WHERE id BETWEEN 18 AND 22",
+                                 NULL, NULL, NULL));
+
+  float query[TEST_DIMS] = {20.0f, 0.0f, 0.0f};
+  DiskAnnResult res[6];
+  TEST_ASSERT_EQUAL_INT(6, diskann_search(idx, query, TEST_DIMS, 6, res));
+  for (int i = 0; i < 6; i++) {
+    TEST_ASSERT_TRUE(res[i].id < 18 || res[i].id > 22);
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Bitmap filter tests
+**************************************************************************/
+
+void test_filter_plan_by_selectivity(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_filter_plan", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  /* Few matches per beam slot: scan; more: walk the graph */
+  idx->cached_max_rowid = 1000;
+  TEST_ASSERT_TRUE(filter_plan_exact_scan(idx, 4 * TEST_SEARCH_L, NULL));
+  TEST_ASSERT_FALSE(
+      filter_plan_exact_scan(idx, 4 * TEST_SEARCH_L + 1, NULL));
+
+  /* A large index makes the same match count too selective to walk */
+  idx->cached_max_rowid = 1000000;
+  TEST_ASSERT_TRUE(filter_plan_exact_scan(idx, 10000, NULL));
+  TEST_ASSERT_FALSE(filter_plan_exact_scan(idx, 100000, NULL));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/* Graph walk and exact scan both return the filtered brute-force top-k */
+void test_search_bitmap_matches_brute_force(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx =
+      create_test_index(db, "test_search_bitmap", DISKANN_METRIC_EUCLIDEAN);
+  TEST_ASSERT_NOT_NULL(idx);
+  static float vectors[BEAM_N][TEST_DIMS];
+  uint32_t seed = 31337;
+  for (int i = 0; i < BEAM_N; i++) {
+    for (int d = 0; d < TEST_DIMS; d++) {
+      seed = seed * 1103515245 + 12345;
+      vectors[i][d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_insert(idx, i + 1, vectors[i], TEST_DIMS));
+  }
+
+  /* Narrow (every 97th row: exact scan), broad (every 2nd: graph walk) */
+  const int strides[] = {97, 2};
+  for (int t = 0; t < 2; t++) {
+    DiskAnnBitmap bm;
+    diskann_bitmap_init(&bm);
+    static float subset[BEAM_N][TEST_DIMS];
+    int64_t ids[BEAM_N];
+    int n_subset = 0;
+    for (int i = 0; i < BEAM_N; i += strides[t]) {
+      TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, i + 1));
+      memcpy(subset[n_subset], vectors[i], sizeof(subset[0]));
+      ids[n_subset++] = i + 1;
+    }
+    TEST_ASSERT_EQUAL_INT(t == 0,
+                          filter_plan_exact_scan(idx, bm.count, NULL));
+    /* A member without a vector (e.g. a stale _attrs row) is skipped */
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_bitmap_add(&bm, 999999));
+
+    float query[TEST_DIMS] = {0.5f, 0.25f, 0.75f};
+    int64_t bf_ids[5];
+    float bf_distances[5];
+    int want = n_subset < 5 ? n_subset : 5;
+    brute_force_knn((const float *)subset, n_subset, TEST_DIMS,
+                    DISKANN_METRIC_EUCLIDEAN, query, want, bf_ids,
+                    bf_distances);
+
+    DiskAnnResult res[5];
+    TEST_ASSERT_EQUAL_INT(want, diskann_search_bitmap(idx, query, TEST_DIMS,
+                                                      5, res, &bm, 0, NULL));
+    for (int i = 0; i < want; i++) {
+      TEST_ASSERT_EQUAL_INT64(ids[bf_ids[i] - 1], res[i].id);
+      TEST_ASSERT_FLOAT_WITHIN(1e-5f, bf_distances[i], res[i].distance);
+    }
+    diskann_bitmap_deinit(&bm);
+  }
+
+  /* Empty filter: no results without touching the graph */
+  DiskAnnBitmap empty;
+  diskann_bitmap_init(&empty);
+  float query[TEST_DIMS] = {0};
+  DiskAnnResult res[1];
+  TEST_ASSERT_EQUAL_INT(0, diskann_search_bitmap(idx, query, TEST_DIMS, 1,
+                                                 res, &empty, 0, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_DIMENSION,
+                    diskann_search_bitmap(idx, query, TEST_DIMS + 1, 1, res,
+                                          &empty, 0, NULL));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Batch search
+**************************************************************************/
+
+#define BATCH_N 200
+#define BATCH_QUERIES 16
+#define BATCH_K 5
+
+static void insert_random(DiskAnnIndex *idx, int n, uint32_t seed) {
+  for (int i = 1; i <= n; i++) {
+    float vec[TEST_DIMS];
+    for (int d = 0; d < TEST_DIMS; d++) {
+      seed = seed * 1103515245 + 12345;
+      vec[d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+    }
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i, vec, TEST_DIMS));
+  }
+}
+
+/* Run a batch and check every query against diskann_search() */
+static void check_batch_matches_sequential(DiskAnnIndex *idx,
+                                           uint32_t num_threads) {
+  static float queries[BATCH_QUERIES * TEST_DIMS];
+  static DiskAnnResult batch[BATCH_QUERIES * BATCH_K];
+  int counts[BATCH_QUERIES];
+  uint32_t seed = 4242;
+  for (int i = 0; i < BATCH_QUERIES * TEST_DIMS; i++) {
+    seed = seed * 1103515245 + 12345;
+    queries[i] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+  }
+
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_batch(idx, queries, BATCH_QUERIES,
+                                         TEST_DIMS, BATCH_K, batch, counts,
+                                         num_threads));
+  for (int q = 0; q < BATCH_QUERIES; q++) {
+    DiskAnnResult single[BATCH_K];
+    int n = diskann_search(idx, queries + q * TEST_DIMS, TEST_DIMS, BATCH_K,
+                           single);
+    TEST_ASSERT_EQUAL_INT(n, counts[q]);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_INT64(single[i].id, batch[q * BATCH_K + i].id);
+      TEST_ASSERT_EQUAL_FLOAT(single[i].distance,
+                              batch[q * BATCH_K + i].distance);
+    }
+  }
+}
+
+void test_search_batch_validation(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_batch_val", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  float queries[2 * TEST_DIMS] = {0};
+  DiskAnnResult res[2 * BATCH_K];
+  int counts[2] = {-1, -1};
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_batch(NULL, queries, 2, TEST_DIMS, 1, res,
+                                         counts, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_batch(idx, NULL, 2, TEST_DIMS, 1, res,
+                                         counts, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_batch(idx, queries, 2, TEST_DIMS, 1, res,
+                                         NULL, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_batch(idx, queries, -1, TEST_DIMS, 1, res,
+                                         counts, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_batch(idx, queries, 2, TEST_DIMS, -1, res,
+                                         counts, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_DIMENSION,
+                    diskann_search_batch(idx, queries, 2, TEST_DIMS + 1, 1,
+                                         res, counts, 0));
+
+  /* Empty index: every query gets 0 results */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_search_batch(idx, queries, 2,
+                                                     TEST_DIMS, BATCH_K, res,
+                                                     counts, 4));
+  TEST_ASSERT_EQUAL_INT(0, counts[0]);
+  TEST_ASSERT_EQUAL_INT(0, counts[1]);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_search_batch_workers_match_sequential(void) {
+  const char *path = SEARCH_TEST_DB;
+  remove(path);
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_batch_workers", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  insert_random(idx, BATCH_N, 99);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+
+  /* Worker reads are folded into the caller's counters, and land in the
+  ** shared read cache */
+  uint64_t reads_before = idx->num_reads;
+  check_batch_matches_sequential(idx, 4);
+  TEST_ASSERT_TRUE(idx->num_reads > reads_before);
+  TEST_ASSERT_TRUE(idx->read_cache->count > 0);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(path);
+}
+
+void test_search_batch_sequential_fallbacks(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_batch_fallback", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_random(idx, BATCH_N, 7);
+
+  /* :memory: cannot be shared with worker connections */
+  check_batch_matches_sequential(idx, 4);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_search_batch_sees_pending_writes(void) {
+  const char *path = SEARCH_TEST_DB;
+  remove(path);
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_batch_pending", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_line(idx, 20);
+
+  /* Worker connections cannot see uncommitted rows: the batch runs on the
+  ** caller's connection while a write transaction is open */
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  float vec[TEST_DIMS] = {30.0f, 0.0f, 0.0f};
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, 1000, vec, TEST_DIMS));
+  float queries[2 * TEST_DIMS] = {30.0f, 0.0f, 0.0f, 29.0f, 0.0f, 0.0f};
+  DiskAnnResult res[2];
+  int counts[2];
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_search_batch(idx, queries, 2,
+                                                     TEST_DIMS, 1, res,
+                                                     counts, 2));
+  TEST_ASSERT_EQUAL_INT(1, counts[0]);
+  TEST_ASSERT_EQUAL_INT(1, counts[1]);
+  TEST_ASSERT_EQUAL_INT64(1000, res[0].id);
+  TEST_ASSERT_EQUAL_INT64(1000, res[1].id);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(path);
+}
+
+/**************************************************************************
+** Shared reader tests
+**************************************************************************/
+
+#define READER_THREADS 4
+
+/* Deterministic query q in [0, 1)^TEST_DIMS */
+static void reader_query(int q, float *query) {
+  uint32_t seed = 777u + (uint32_t)q;
+  for (int d = 0; d < TEST_DIMS; d++) {
+    seed = seed * 1103515245 + 12345;
+    query[d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+  }
+}
+
+void test_search_ex_params(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_search_ex", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_random(idx, BATCH_N, 11);
+  diskann_set_exact_scan_threshold(idx, DISKANN_DEFAULT_EXACT_SCAN_ROWS);
+
+  float query[TEST_DIMS];
+  reader_query(0, query);
+  DiskAnnResult want[BATCH_K], got[BATCH_K];
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_exact(idx, query, TEST_DIMS,
+                                                      BATCH_K, want, NULL,
+                                                      NULL));
+
+  /* NULL and zeroed params search like diskann_search(): a scan here */
+  DiskAnnSearchParams params = {0};
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_ex(idx, query, TEST_DIMS,
+                                                   BATCH_K, NULL, got, NULL,
+                                                   NULL));
+  TEST_ASSERT_EQUAL_INT64(want[0].id, got[0].id);
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_ex(idx, query, TEST_DIMS,
+                                                   BATCH_K, &params, got, NULL,
+                                                   NULL));
+  for (int i = 0; i < BATCH_K; i++) {
+    TEST_ASSERT_EQUAL_INT64(want[i].id, got[i].id);
+  }
+
+  /* Overrides apply to one query and leave the handle as it was */
+  params.search_list_size = 3 * TEST_SEARCH_L;
+  params.exact = DISKANN_SEARCH_GRAPH;
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_ex(idx, query, TEST_DIMS,
+                                                   BATCH_K, &params, got, NULL,
+                                                   NULL));
+  TEST_ASSERT_EQUAL_UINT32(TEST_SEARCH_L, idx->search_list_size);
+  TEST_ASSERT_EQUAL_UINT32(DISKANN_DEFAULT_EXACT_SCAN_ROWS,
+                           idx->exact_scan_max_rows);
+  TEST_ASSERT_EQUAL_INT(3 * TEST_SEARCH_L,
+                        effective_search_list_size(idx, &params, 0));
+
+  /* Forced scan on a handle that would walk */
+  diskann_set_exact_scan_threshold(idx, 0);
+  params.exact = DISKANN_SEARCH_EXACT;
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_ex(idx, query, TEST_DIMS,
+                                                   BATCH_K, &params, got, NULL,
+                                                   NULL));
+  for (int i = 0; i < BATCH_K; i++) {
+    TEST_ASSERT_EQUAL_INT64(want[i].id, got[i].id);
+    TEST_ASSERT_EQUAL_FLOAT(want[i].distance, got[i].distance);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, idx->exact_scan_max_rows);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+typedef struct ReaderThread {
+  DiskAnnIndex *reader;
+  const DiskAnnResult *expected; /* BATCH_QUERIES * BATCH_K */
+  const int *expected_n;
+  int mismatches;
+} ReaderThread;
+
+/* Run every query a few times and count results that differ */
+static void reader_thread_run(void *arg) {
+  ReaderThread *t = (ReaderThread *)arg;
+  for (int round = 0; round < 3; round++) {
+    for (int q = 0; q < BATCH_QUERIES; q++) {
+      float query[TEST_DIMS];
+      DiskAnnResult res[BATCH_K];
+      reader_query(q, query);
+      int n = diskann_search(t->reader, query, TEST_DIMS, BATCH_K, res);
+      if (n != t->expected_n[q]) {
+        t->mismatches++;
+        continue;
+      }
+      for (int i = 0; i < n; i++) {
+        if (res[i].id != t->expected[q * BATCH_K + i].id) {
+          t->mismatches++;
+        }
+      }
+    }
+  }
+}
+
+void test_open_reader_concurrent_search(void) {
+  const char *path = SEARCH_TEST_DB;
+  remove(path);
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_readers", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  insert_random(idx, BATCH_N, 5);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+
+  static DiskAnnResult expected[BATCH_QUERIES * BATCH_K];
+  int expected_n[BATCH_QUERIES];
+  for (int q = 0; q < BATCH_QUERIES; q++) {
+    float query[TEST_DIMS];
+    reader_query(q, query);
+    expected_n[q] = diskann_search(idx, query, TEST_DIMS, BATCH_K,
+                                   expected + q * BATCH_K);
+    TEST_ASSERT_EQUAL_INT(BATCH_K, expected_n[q]);
+  }
+  blob_cache_clear(idx->read_cache);
+
+  sqlite3 *conns[READER_THREADS];
+  ReaderThread threads[READER_THREADS];
+  for (int i = 0; i < READER_THREADS; i++) {
+    TEST_ASSERT_EQUAL(SQLITE_OK,
+                      sqlite3_open_v2(path, &conns[i], SQLITE_OPEN_READONLY,
+                                      NULL));
+    threads[i].reader = NULL;
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_open_reader(idx, conns[i], NULL,
+                                                      &threads[i].reader));
+    threads[i].expected = expected;
+    threads[i].expected_n = expected_n;
+    threads[i].mismatches = 0;
+  }
+
+  diskann_parallel_run(reader_thread_run, threads, sizeof(ReaderThread),
+                       READER_THREADS);
+  for (int i = 0; i < READER_THREADS; i++) {
+    TEST_ASSERT_EQUAL_INT(0, threads[i].mismatches);
+    TEST_ASSERT_TRUE(threads[i].reader->num_reads > 0);
+  }
+  /* The readers filled the shared handle's cache */
+  TEST_ASSERT_TRUE(idx->read_cache->count > 0);
+
+  /* Readers only search */
+  DiskAnnIndex *reader = threads[0].reader;
+  float vec[TEST_DIMS] = {0};
+  DiskAnnIndex *nested = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_insert(reader, BATCH_N + 1, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_delete(reader, 1));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID, diskann_begin_batch(reader, 0));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_set_cache_budget(reader, 1 << 20));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_open_reader(reader, conns[0], NULL, &nested));
+  TEST_ASSERT_NULL(nested);
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_open_reader(idx, NULL, NULL, &nested));
+
+  for (int i = 0; i < READER_THREADS; i++) {
+    diskann_close_index(threads[i].reader);
+    sqlite3_close(conns[i]);
+  }
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(path);
+}
+
+/*
+** A reader re-borrows the shared handle's read cache, PQ codes and row
+** count at each search, so replacing them between searches is safe (ASan
+** flags the stale pointers otherwise).
+*/
+void test_open_reader_follows_shared_handle(void) {
+  const char *path = SEARCH_TEST_DB;
+  remove(path);
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(path, &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_reader_sync", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  insert_random(idx, BATCH_N, 9);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 1 << 20));
+
+  sqlite3 *conn;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open_v2(path, &conn,
+                                               SQLITE_OPEN_READONLY, NULL));
+  DiskAnnIndex *reader = NULL;
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_open_reader(idx, conn, NULL, &reader));
+
+  DiskAnnSearchParams params;
+  memset(&params, 0, sizeof(params));
+  params.exact = DISKANN_SEARCH_GRAPH;
+  float query[TEST_DIMS];
+  DiskAnnResult want[BATCH_K];
+  DiskAnnResult got[BATCH_K];
+  reader_query(0, query);
+  int n = diskann_search_ex(idx, query, TEST_DIMS, BATCH_K, &params, want,
+                            NULL, NULL);
+  TEST_ASSERT_EQUAL_INT(BATCH_K, n);
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+
+  /* Resizing frees the cache the reader searched through */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 2 << 20));
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+  TEST_ASSERT_TRUE(reader->read_cache == idx->read_cache);
+  TEST_ASSERT_TRUE(idx->read_cache->count > 0);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_set_cache_budget(idx, 0));
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+  TEST_ASSERT_NULL(reader->read_cache);
+
+  /* Rebuilding PQ codes frees the previous ones */
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_pq_build(idx, 1, 0));
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+  TEST_ASSERT_TRUE(reader->pq == idx->pq);
+  TEST_ASSERT_EQUAL(DISKANN_OK, diskann_pq_build(idx, TEST_DIMS, 0));
+  n = diskann_search_ex(idx, query, TEST_DIMS, BATCH_K, &params, want, NULL,
+                        NULL);
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+  TEST_ASSERT_TRUE(reader->pq == idx->pq);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(want[i].id, got[i].id);
+  }
+
+  /* Rows inserted through the shared handle count toward the beam size */
+  float vec[TEST_DIMS] = {0};
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_insert(idx, BATCH_N * 10, vec, TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(n, diskann_search_ex(reader, query, TEST_DIMS,
+                                             BATCH_K, &params, got, NULL,
+                                             NULL));
+  TEST_ASSERT_EQUAL_INT64(BATCH_N * 10, reader->cached_max_rowid);
+
+  diskann_close_index(reader);
+  sqlite3_close(conn);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(path);
+}
+
+/**************************************************************************
+** Exact scan tests
+**************************************************************************/
+
+#define EXACT_N 300
+#define EXACT_K 8
+
+static int exact_accept_odd(int64_t rowid, void *ctx) {
+  (void)ctx;
+  return rowid % 2 == 1;
+}
+
+/* Brute-force top-k over rows 1..n (skipping gone, and even rows if odd) */
+static int exact_reference(const float (*vectors)[TEST_DIMS], int n,
+                           const int *gone, const float *query,
+                           uint8_t metric, int odd, DiskAnnResult *out) {
+  int count = 0;
+  for (int i = 0; i < n; i++) {
+    if (gone[i] || (odd && (i + 1) % 2 == 0)) {
+      continue;
+    }
+    float d = diskann_distance(query, vectors[i], TEST_DIMS, metric);
+    if (count == EXACT_K && d >= out[EXACT_K - 1].distance) {
+      continue;
+    }
+    int j = count < EXACT_K ? count++ : EXACT_K - 1;
+    for (; j > 0 && out[j - 1].distance > d; j--) {
+      out[j] = out[j - 1];
+    }
+    out[j].id = i + 1;
+    out[j].distance = d;
+  }
+  return count;
+}
+
+static void check_exact_scan(uint8_t metric) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_exact", metric);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  static float vectors[EXACT_N][TEST_DIMS];
+  static int gone[EXACT_N];
+  uint32_t seed = 2024;
+  for (int i = 0; i < EXACT_N; i++) {
+    for (int d = 0; d < TEST_DIMS; d++) {
+      seed = seed * 1103515245 + 12345;
+      vectors[i][d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF - 0.5f;
+    }
+    gone[i] = 0;
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_insert(idx, i + 1, vectors[i], TEST_DIMS));
+  }
+  for (int i = 0; i < EXACT_N; i += 7) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_delete(idx, i + 1));
+    gone[i] = 1;
+  }
+
+  for (int q = 0; q < 10; q++) {
+    float query[TEST_DIMS];
+    for (int d = 0; d < TEST_DIMS; d++) {
+      seed = seed * 1103515245 + 12345;
+      query[d] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF - 0.5f;
+    }
+    for (int odd = 0; odd < 2; odd++) {
+      DiskAnnResult expected[EXACT_K], got[EXACT_K];
+      int n_expected = exact_reference((const float(*)[TEST_DIMS])vectors,
+                                       EXACT_N, gone, query, metric, odd,
+                                       expected);
+      int n = diskann_search_exact(idx, query, TEST_DIMS, EXACT_K, got,
+                                   odd ? exact_accept_odd : NULL, NULL);
+      TEST_ASSERT_EQUAL_INT(n_expected, n);
+      for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_INT64(expected[i].id, got[i].id);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected[i].distance,
+                                 got[i].distance);
+      }
+    }
+  }
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_search_exact_matches_brute_force(void) {
+  check_exact_scan(DISKANN_METRIC_EUCLIDEAN);
+  check_exact_scan(DISKANN_METRIC_COSINE);
+  check_exact_scan(DISKANN_METRIC_DOT);
+}
+
+void test_search_exact_validation(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_exact_val", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+
+  float query[TEST_DIMS] = {0};
+  DiskAnnResult res[2];
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_exact(NULL, query, TEST_DIMS, 2, res, NULL,
+                                         NULL));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_search_exact(idx, query, TEST_DIMS, -1, res, NULL,
+                                         NULL));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_DIMENSION,
+                    diskann_search_exact(idx, query, TEST_DIMS + 1, 2, res,
+                                         NULL, NULL));
+  TEST_ASSERT_EQUAL(DISKANN_ERROR_INVALID,
+                    diskann_set_exact_scan_threshold(NULL, 10));
+  /* Empty index */
+  TEST_ASSERT_EQUAL_INT(
+      0, diskann_search_exact(idx, query, TEST_DIMS, 2, res, NULL, NULL));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** Below the threshold, searches (single, filtered, batched) are answered
+** by the scan: one read of header + vector per row, never the edge slots.
+*/
+void test_search_exact_below_threshold(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_test_index(db, "test_exact_auto", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  insert_random(idx, BATCH_N, 17);
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_exact_scan_threshold(idx, BATCH_N));
+
+  float query[TEST_DIMS] = {0.3f, 0.6f, 0.1f};
+  DiskAnnResult res[BATCH_K], expected[BATCH_K];
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search_exact(idx, query, TEST_DIMS,
+                                                      BATCH_K, expected, NULL,
+                                                      NULL));
+  uint64_t reads = idx->num_reads, bytes = idx->num_read_bytes;
+  TEST_ASSERT_EQUAL_INT(BATCH_K,
+                        diskann_search(idx, query, TEST_DIMS, BATCH_K, res));
+  TEST_ASSERT_EQUAL_UINT64(BATCH_N, idx->num_reads - reads);
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)BATCH_N * (16 + TEST_DIMS * 4),
+                           idx->num_read_bytes - bytes);
+  for (int i = 0; i < BATCH_K; i++) {
+    TEST_ASSERT_EQUAL_INT64(expected[i].id, res[i].id);
+  }
+
+  /* Filtered searches scan too, only reading accepted rows */
+  reads = idx->num_reads;
+  int n = diskann_search_filtered(idx, query, TEST_DIMS, BATCH_K, res,
+                                  exact_accept_odd, NULL);
+  TEST_ASSERT_EQUAL_INT(BATCH_K, n);
+  TEST_ASSERT_EQUAL_UINT64(BATCH_N / 2, idx->num_reads - reads);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(1, res[i].id % 2);
+  }
+
+  /* A batch shares one pass over the rows */
+  reads = idx->num_reads;
+  check_batch_matches_sequential(idx, 4);
+  TEST_ASSERT_EQUAL_UINT64(BATCH_N * (1 + BATCH_QUERIES),
+                           idx->num_reads - reads);
+
+  /* One row over the threshold walks the graph again */
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_set_exact_scan_threshold(idx, BATCH_N - 1));
+  reads = idx->num_reads;
+  TEST_ASSERT_EQUAL_INT(BATCH_K,
+                        diskann_search(idx, query, TEST_DIMS, BATCH_K, res));
+  TEST_ASSERT_TRUE(idx->num_reads - reads < BATCH_N);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Resumable search (DiskAnnSearchStream)
+**************************************************************************/
+
+#define STREAM_N 400
+
+/* 400 random rows, searched on the graph; vectors[i] is rowid i + 1 */
+static DiskAnnIndex *create_stream_index(sqlite3 *db, float *vectors) {
+  DiskAnnIndex *idx = create_test_index(db, "test_stream", 0);
+  TEST_ASSERT_NOT_NULL(idx);
+  uint32_t seed = 777;
+  for (int i = 0; i < STREAM_N * TEST_DIMS; i++) {
+    seed = seed * 1103515245 + 12345;
+    vectors[i] = (float)(seed & 0x7FFFFFFF) / (float)0x7FFFFFFF;
+  }
+  for (int i = 0; i < STREAM_N; i++) {
+    TEST_ASSERT_EQUAL(DISKANN_OK, diskann_insert(idx, i + 1,
+                                                 vectors + i * TEST_DIMS,
+                                                 TEST_DIMS));
+  }
+  return idx;
+}
+
+/* Pull up to max rows; each rowid must come out once */
+static int stream_drain(DiskAnnSearchStream *stream, DiskAnnResult *rows,
+                        int max) {
+  static int seen[STREAM_N + 1];
+  memset(seen, 0, sizeof(seen));
+  int n = 0;
+  int rc = 0;
+  while (n < max && (rc = diskann_search_stream_next(stream, &rows[n])) == 1) {
+    TEST_ASSERT_TRUE(rows[n].id >= 1 && rows[n].id <= STREAM_N);
+    TEST_ASSERT_EQUAL_INT(0, seen[rows[n].id]);
+    seen[rows[n].id] = 1;
+    n++;
+  }
+  TEST_ASSERT_TRUE(rc >= 0);
+  return n;
+}
+
+/*
+** A stream starts as the plain search would, walks further only as rows
+** are pulled, and can reach every row of the graph.
+*/
+void test_search_stream_resumes_walk(void) {
+  sqlite3 *db;
+  static float vectors[STREAM_N * TEST_DIMS];
+  static DiskAnnResult rows[STREAM_N];
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_stream_index(db, vectors);
+  float query[TEST_DIMS] = {0.25f, 0.5f, 0.75f};
+  DiskAnnSearchStream *stream = NULL;
+
+  /* First rows match diskann_search() */
+  DiskAnnResult expected[BATCH_K];
+  TEST_ASSERT_EQUAL_INT(BATCH_K, diskann_search(idx, query, TEST_DIMS,
+                                                BATCH_K, expected));
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_stream_open(idx, query, TEST_DIMS, -1,
+                                               INFINITY, NULL,
+                                               DISKANN_LABEL_NONE, NULL,
+                                               &stream));
+  uint64_t reads = idx->num_reads;
+  TEST_ASSERT_EQUAL_INT(BATCH_K, stream_drain(stream, rows, BATCH_K));
+  uint64_t first_reads = idx->num_reads - reads;
+  for (int i = 0; i < BATCH_K; i++) {
+    TEST_ASSERT_EQUAL_INT64(expected[i].id, rows[i].id);
+  }
+  /* The first walk is a plain search: far fewer reads than rows */
+  TEST_ASSERT_TRUE(first_reads < STREAM_N / 2);
+  diskann_search_stream_close(stream);
+
+  /* Pulled to the end, the walk reaches every row, close to distance
+  ** order: the first 100 are nearly the true 100 nearest */
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_stream_open(idx, query, TEST_DIMS, -1,
+                                               INFINITY, NULL,
+                                               DISKANN_LABEL_NONE, NULL,
+                                               &stream));
+  TEST_ASSERT_EQUAL_INT(STREAM_N, stream_drain(stream, rows, STREAM_N));
+  DiskAnnResult extra;
+  TEST_ASSERT_EQUAL_INT(0, diskann_search_stream_next(stream, &extra));
+  diskann_search_stream_close(stream);
+
+  int64_t true_ids[100];
+  float true_dists[100];
+  brute_force_knn(vectors, STREAM_N, TEST_DIMS, 0, query, 100, true_ids,
+                  true_dists);
+  int hits = 0;
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 100; j++) {
+      if (rows[i].id == true_ids[j]) {
+        hits++;
+        break;
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(hits >= 90);
+
+  /* limit ends the stream */
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_stream_open(idx, query, TEST_DIMS, 7,
+                                               INFINITY, NULL,
+                                               DISKANN_LABEL_NONE, NULL,
+                                               &stream));
+  TEST_ASSERT_EQUAL_INT(7, stream_drain(stream, rows, STREAM_N));
+  diskann_search_stream_close(stream);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+/*
+** A range stream returns the rows within max_distance, on the graph and
+** by exact scan, and stops there.
+*/
+void test_search_stream_range(void) {
+  sqlite3 *db;
+  static float vectors[STREAM_N * TEST_DIMS];
+  static DiskAnnResult rows[STREAM_N];
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_stream_index(db, vectors);
+  float query[TEST_DIMS] = {0.6f, 0.4f, 0.2f};
+  DiskAnnSearchStream *stream = NULL;
+
+  int64_t true_ids[60];
+  float true_dists[60];
+  brute_force_knn(vectors, STREAM_N, TEST_DIMS, 0, query, 60, true_ids,
+                  true_dists);
+  float radius = true_dists[49]; /* 50 rows within */
+
+  for (int exact = 0; exact < 2; exact++) {
+    DiskAnnSearchParams params = {0};
+    params.exact = exact ? DISKANN_SEARCH_EXACT : DISKANN_SEARCH_AUTO;
+    TEST_ASSERT_EQUAL(DISKANN_OK,
+                      diskann_search_stream_open(idx, query, TEST_DIMS, -1,
+                                                 radius, NULL,
+                                                 DISKANN_LABEL_NONE, &params,
+                                                 &stream));
+    int n = stream_drain(stream, rows, STREAM_N);
+    diskann_search_stream_close(stream);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_TRUE(rows[i].distance <= radius);
+    }
+    if (exact) {
+      TEST_ASSERT_EQUAL_INT(50, n);
+      for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_INT64(true_ids[i], rows[i].id);
+      }
+    } else {
+      TEST_ASSERT_TRUE(n >= 45 && n <= 50);
+    }
+  }
+
+  /* Nothing in range */
+  TEST_ASSERT_EQUAL(DISKANN_OK,
+                    diskann_search_stream_open(idx, query, TEST_DIMS, -1,
+                                               true_dists[0] / 2.0f, NULL,
+                                               DISKANN_LABEL_NONE, NULL,
+                                               &stream));
+  TEST_ASSERT_EQUAL_INT(0, stream_drain(stream, rows, STREAM_N));
+  diskann_search_stream_close(stream);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
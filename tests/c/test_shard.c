@@ -0,0 +1,545 @@
+/*
+** Tests for diskann_open_shards() — hash-routed partitioned indexes with
+** fan-out search.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_bitmap.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_search.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define SHARD_TEST_DIR ""
+#else
+#define SHARD_TEST_DIR "/tmp/"
+#endif
+#define SHARD_TEST_MAIN SHARD_TEST_DIR "diskann_test_shard0.db"
+#define SHARD_TEST_ONE SHARD_TEST_DIR "diskann_test_shard1.db"
+#define SHARD_TEST_TWO SHARD_TEST_DIR "diskann_test_shard2.db"
+
+#define SHARD_TEST_DIMS 8
+#define SHARD_TEST_N 300
+#define SHARD_TEST_K 10
+
+static const char *const shard_names[] = {"main", "s1", "s2"};
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static void remove_shard_files(void) {
+  remove(SHARD_TEST_MAIN);
+  remove(SHARD_TEST_ONE);
+  remove(SHARD_TEST_TWO);
+}
+
+static void create_shard_index(sqlite3 *db, const char *db_name,
+                               uint32_t dims) {
+  DiskAnnConfig config = {.dimensions = dims,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 16,
+                          .search_list_size = 48,
+                          .insert_list_size = 64};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_create_index(db, db_name, "vec", &config));
+}
+
+/* Three file-backed shards: main plus two ATTACHed databases */
+static sqlite3 *open_shard_db(void) {
+  sqlite3 *db;
+  remove_shard_files();
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(SHARD_TEST_MAIN, &db));
+  TEST_ASSERT_EQUAL(SQLITE_OK,
+                    sqlite3_exec(db,
+                                 "ATTACH '" SHARD_TEST_ONE "' AS s1;"
+                                 "ATTACH '" SHARD_TEST_TWO "' AS s2;",
+                                 NULL, NULL, NULL));
+  for (int i = 0; i < 3; i++) {
+    create_shard_index(db, shard_names[i], SHARD_TEST_DIMS);
+  }
+  return db;
+}
+
+/* Insert SHARD_TEST_N random vectors with ids 1..n in one transaction;
+** returns them (row i is id i + 1, malloc'd) */
+static float *insert_rows(sqlite3 *db, DiskAnnShards *shards) {
+  float *vectors = gen_vectors(SHARD_TEST_N, SHARD_TEST_DIMS, 17);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  for (int i = 0; i < SHARD_TEST_N; i++) {
+    TEST_ASSERT_EQUAL_INT(
+        DISKANN_OK,
+        diskann_shards_insert(shards, i + 1,
+                              vectors + (size_t)i * SHARD_TEST_DIMS,
+                              SHARD_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  return vectors;
+}
+
+/* Shard row id routes to */
+static int home_shard(const DiskAnnShards *shards, int64_t id) {
+  int shard = -1;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shard_for(shards, id, &shard));
+  return shard;
+}
+
+/* Whether row id is stored in schema db_name's shard */
+static int shard_has_row(sqlite3 *db, const char *db_name, int64_t id) {
+  char *sql = sqlite3_mprintf(
+      "SELECT 1 FROM \"%w\".vec_shadow WHERE id = %lld", db_name,
+      (long long)id);
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_prepare_v2(db, sql, -1, &stmt, NULL));
+  int found = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_finalize(stmt);
+  sqlite3_free(sql);
+  return found;
+}
+
+/* Ids of the k rows nearest to query, by brute force over vectors */
+static void true_neighbors(const float *vectors, const float *query,
+                           int64_t *ids) {
+  float best[SHARD_TEST_K];
+  for (int j = 0; j < SHARD_TEST_K; j++) {
+    best[j] = 1e30f;
+    ids[j] = 0;
+  }
+  for (int i = 0; i < SHARD_TEST_N; i++) {
+    float d = 0.0f;
+    for (int c = 0; c < SHARD_TEST_DIMS; c++) {
+      float diff = vectors[(size_t)i * SHARD_TEST_DIMS + (size_t)c] - query[c];
+      d += diff * diff;
+    }
+    int j = SHARD_TEST_K;
+    while (j > 0 && d < best[j - 1]) {
+      if (j < SHARD_TEST_K) {
+        best[j] = best[j - 1];
+        ids[j] = ids[j - 1];
+      }
+      j--;
+    }
+    if (j < SHARD_TEST_K) {
+      best[j] = d;
+      ids[j] = i + 1;
+    }
+  }
+}
+
+/**************************************************************************
+** Tests
+**************************************************************************/
+
+void test_shards_open_validation(void) {
+  sqlite3 *db;
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db,
+                                            "ATTACH ':memory:' AS s1;"
+                                            "ATTACH ':memory:' AS s2;",
+                                            NULL, NULL, NULL));
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(NULL, shard_names, 3, "vec",
+                                            &shards));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(db, NULL, 3, "vec", &shards));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(db, shard_names, 0, "vec",
+                                            &shards));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(db, shard_names,
+                                            DISKANN_MAX_SHARDS + 1, "vec",
+                                            &shards));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(db, shard_names, 3, NULL,
+                                            &shards));
+  TEST_ASSERT_NULL(shards);
+
+  /* A missing shard fails the whole open */
+  create_shard_index(db, "main", SHARD_TEST_DIMS);
+  create_shard_index(db, "s1", SHARD_TEST_DIMS);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_NOTFOUND,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  TEST_ASSERT_NULL(shards);
+
+  /* Distances from shards of different dimensions do not merge */
+  create_shard_index(db, "s2", SHARD_TEST_DIMS * 2);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  TEST_ASSERT_NULL(shards);
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 2, "vec",
+                                            &shards));
+  TEST_ASSERT_NOT_NULL(diskann_shard_index(shards, 1));
+  TEST_ASSERT_NULL(diskann_shard_index(shards, 2));
+  TEST_ASSERT_NULL(diskann_shard_index(shards, -1));
+  float query[SHARD_TEST_DIMS] = {0};
+  DiskAnnResult results[SHARD_TEST_K];
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_DIMENSION,
+                        diskann_shards_search(shards, query,
+                                              SHARD_TEST_DIMS + 1,
+                                              SHARD_TEST_K, NULL, results,
+                                              0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_shards_search(shards, query, SHARD_TEST_DIMS,
+                                              -1, NULL, results, 0));
+  TEST_ASSERT_EQUAL_INT(0, diskann_shards_search(shards, query,
+                                                 SHARD_TEST_DIMS, 0, NULL,
+                                                 results, 0));
+  diskann_close_shards(shards);
+  diskann_close_shards(NULL);
+  sqlite3_close(db);
+}
+
+void test_shards_routing(void) {
+  sqlite3 *db;
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(":memory:", &db));
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db,
+                                            "ATTACH ':memory:' AS s1;"
+                                            "ATTACH ':memory:' AS s2;",
+                                            NULL, NULL, NULL));
+  for (int i = 0; i < 3; i++) {
+    create_shard_index(db, shard_names[i], SHARD_TEST_DIMS);
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+
+  int shard = -1;
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_shard_for(NULL, 1, &shard));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_shard_for(shards, 1, NULL));
+  TEST_ASSERT_EQUAL_INT(3, diskann_shard_count(shards));
+  TEST_ASSERT_EQUAL_INT(0, diskann_shard_count(NULL));
+
+  /* Consecutive rowids spread over every shard */
+  int per_shard[3] = {0};
+  for (int64_t id = 1; id <= 3000; id++) {
+    int s = home_shard(shards, id);
+    TEST_ASSERT_TRUE(s >= 0 && s < 3);
+    TEST_ASSERT_EQUAL_INT(s, home_shard(shards, id));
+    per_shard[s]++;
+  }
+  for (int s = 0; s < 3; s++) {
+    TEST_ASSERT_TRUE(per_shard[s] > 800);
+  }
+
+  /* Rows land in, and are deleted from, the shard they route to */
+  float vec[SHARD_TEST_DIMS] = {1.0f};
+  for (int64_t id = 1; id <= 30; id++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_insert(
+                                          shards, id, vec, SHARD_TEST_DIMS));
+  }
+  for (int64_t id = 1; id <= 30; id++) {
+    int home = home_shard(shards, id);
+    for (int s = 0; s < 3; s++) {
+      TEST_ASSERT_EQUAL_INT(s == home, shard_has_row(db, shard_names[s], id));
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_delete(shards, 7));
+  TEST_ASSERT_EQUAL_INT(
+      0, shard_has_row(db, shard_names[home_shard(shards, 7)], 7));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_NOTFOUND,
+                        diskann_shards_delete(shards, 7));
+
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+}
+
+void test_shards_search_merges_shards(void) {
+  sqlite3 *db = open_shard_db();
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  float *vectors = insert_rows(db, shards);
+
+  /* Exact per-shard top k merge to the global top k, whether the shards
+  ** run on the caller's connection or concurrently on their own */
+  DiskAnnSearchParams exact = {.exact = DISKANN_SEARCH_EXACT};
+  DiskAnnResult results[SHARD_TEST_K];
+  int64_t truth[SHARD_TEST_K];
+  for (uint32_t threads = 1; threads <= 3; threads += 2) {
+    for (int q = 0; q < 20; q++) {
+      const float *query = vectors + (size_t)(q * 13) * SHARD_TEST_DIMS;
+      true_neighbors(vectors, query, truth);
+      TEST_ASSERT_EQUAL_INT(
+          SHARD_TEST_K,
+          diskann_shards_search(shards, query, SHARD_TEST_DIMS, SHARD_TEST_K,
+                                &exact, results, threads));
+      for (int j = 0; j < SHARD_TEST_K; j++) {
+        TEST_ASSERT_EQUAL_INT64(truth[j], results[j].id);
+      }
+    }
+  }
+
+  /* Graph searches agree between the two paths; the concurrent one's
+  ** reads are counted on the shard handles */
+  uint64_t reads_before = diskann_shard_index(shards, 1)->num_reads;
+  for (int q = 0; q < 20; q++) {
+    const float *query = vectors + (size_t)(q * 7) * SHARD_TEST_DIMS;
+    DiskAnnResult sequential[SHARD_TEST_K];
+    int n = diskann_shards_search(shards, query, SHARD_TEST_DIMS,
+                                  SHARD_TEST_K, NULL, sequential, 1);
+    TEST_ASSERT_EQUAL_INT(SHARD_TEST_K, n);
+    TEST_ASSERT_EQUAL_INT(n, diskann_shards_search(shards, query,
+                                                   SHARD_TEST_DIMS,
+                                                   SHARD_TEST_K, NULL,
+                                                   results, 0));
+    for (int j = 0; j < n; j++) {
+      TEST_ASSERT_EQUAL_INT64(sequential[j].id, results[j].id);
+      TEST_ASSERT_TRUE(j == 0 ||
+                       results[j - 1].distance <= results[j].distance);
+    }
+  }
+  TEST_ASSERT_TRUE(diskann_shard_index(shards, 1)->num_reads > reads_before);
+
+  /* Fewer rows than k: every row comes back once */
+  DiskAnnResult all[SHARD_TEST_N + 10];
+  TEST_ASSERT_EQUAL_INT(SHARD_TEST_N,
+                        diskann_shards_search(shards, vectors,
+                                              SHARD_TEST_DIMS,
+                                              SHARD_TEST_N + 10, &exact, all,
+                                              0));
+
+  free(vectors);
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+  remove_shard_files();
+}
+
+void test_shards_search_sees_pending_writes(void) {
+  sqlite3 *db = open_shard_db();
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  float *vectors = insert_rows(db, shards);
+
+  /* Reader connections cannot see uncommitted rows: the search runs on
+  ** the caller's connection while a write transaction is open */
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  float far[SHARD_TEST_DIMS];
+  for (int c = 0; c < SHARD_TEST_DIMS; c++) {
+    far[c] = 50.0f;
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_insert(shards, 5000, far,
+                                                          SHARD_TEST_DIMS));
+  DiskAnnResult results[1];
+  TEST_ASSERT_EQUAL_INT(1, diskann_shards_search(shards, far,
+                                                 SHARD_TEST_DIMS, 1, NULL,
+                                                 results, 0));
+  TEST_ASSERT_EQUAL_INT64(5000, results[0].id);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+
+  /* And the committed row is visible to the readers */
+  TEST_ASSERT_EQUAL_INT(1, diskann_shards_search(shards, far,
+                                                 SHARD_TEST_DIMS, 1, NULL,
+                                                 results, 0));
+  TEST_ASSERT_EQUAL_INT64(5000, results[0].id);
+
+  free(vectors);
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+  remove_shard_files();
+}
+
+void test_shards_readers_follow_growth(void) {
+  sqlite3 *db = open_shard_db();
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+
+  /* A few rows: the first concurrent search scans each shard exactly */
+  uint32_t seed = 5;
+  float vec[SHARD_TEST_DIMS];
+  int64_t n = 30;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  for (int64_t id = 1; id <= n; id++) {
+    fill_vector(vec, SHARD_TEST_DIMS, &seed);
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_insert(
+                                          shards, id, vec, SHARD_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  DiskAnnResult results[SHARD_TEST_K];
+  TEST_ASSERT_EQUAL_INT(SHARD_TEST_K,
+                        diskann_shards_search(shards, vec, SHARD_TEST_DIMS,
+                                              SHARD_TEST_K, NULL, results,
+                                              0));
+  DiskAnnStats stats;
+  for (int s = 0; s < 3; s++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_stats(diskann_shard_index(shards, s),
+                                        &stats));
+    TEST_ASSERT_EQUAL_UINT64(1, stats.searches);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.nodes_visited);
+  }
+
+  /* Grow every shard past the exact scan threshold: the readers made by
+  ** that search must see the new size and entry point, and walk */
+  n = 3 * DISKANN_DEFAULT_EXACT_SCAN_ROWS;
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  for (int64_t id = 31; id <= n; id++) {
+    fill_vector(vec, SHARD_TEST_DIMS, &seed);
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_insert(
+                                          shards, id, vec, SHARD_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(SHARD_TEST_K,
+                        diskann_shards_search(shards, vec, SHARD_TEST_DIMS,
+                                              SHARD_TEST_K, NULL, results,
+                                              0));
+  TEST_ASSERT_EQUAL_INT64(n, results[0].id);
+  for (int s = 0; s < 3; s++) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_stats(diskann_shard_index(shards, s),
+                                        &stats));
+    TEST_ASSERT_EQUAL_UINT64(2, stats.searches);
+    TEST_ASSERT_TRUE(stats.nodes_visited > 0);
+    TEST_ASSERT_TRUE((uint64_t)stats.nodes_visited <
+                     (uint64_t)DISKANN_DEFAULT_EXACT_SCAN_ROWS);
+  }
+
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+  remove_shard_files();
+}
+
+void test_shards_build_parallel(void) {
+  sqlite3 *db = open_shard_db();
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_shards_build(NULL, NULL));
+
+  /* Bulk load: vectors stored unlinked, then every shard built at once */
+  float *vectors = gen_vectors(SHARD_TEST_N, SHARD_TEST_DIMS, 23);
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  for (int i = 0; i < SHARD_TEST_N; i++) {
+    DiskAnnIndex *idx = diskann_shard_index(shards, home_shard(shards, i + 1));
+    TEST_ASSERT_EQUAL_INT(
+        DISKANN_OK,
+        diskann_insert_vector(idx, i + 1,
+                              vectors + (size_t)i * SHARD_TEST_DIMS,
+                              SHARD_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+
+  DiskAnnBuildConfig config = {.num_threads = 3};
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_build(shards, &config));
+
+  /* Each handle picked up the entry point its worker stored */
+  for (int s = 0; s < 3; s++) {
+    DiskAnnIndex *idx = diskann_shard_index(shards, s);
+    TEST_ASSERT_TRUE(idx->has_entry);
+    TEST_ASSERT_EQUAL_INT(s, home_shard(shards, idx->entry_rowid));
+  }
+
+  /* Graph walks over the built shards find the true neighbors */
+  DiskAnnSearchParams graph = {.exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnResult results[SHARD_TEST_K];
+  int64_t truth[SHARD_TEST_K];
+  int hits = 0;
+  for (int q = 0; q < 20; q++) {
+    const float *query = vectors + (size_t)(q * 11) * SHARD_TEST_DIMS;
+    true_neighbors(vectors, query, truth);
+    TEST_ASSERT_EQUAL_INT(SHARD_TEST_K,
+                          diskann_shards_search(shards, query,
+                                                SHARD_TEST_DIMS,
+                                                SHARD_TEST_K, &graph,
+                                                results, 0));
+    for (int j = 0; j < SHARD_TEST_K; j++) {
+      for (int t = 0; t < SHARD_TEST_K; t++) {
+        hits += results[j].id == truth[t];
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(hits >= 20 * SHARD_TEST_K * 9 / 10);
+
+  /* Inside a transaction the shards build on the caller's connection */
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "BEGIN", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_shards_build(shards, NULL));
+  TEST_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, "COMMIT", NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(SHARD_TEST_K,
+                        diskann_shards_search(shards, vectors,
+                                              SHARD_TEST_DIMS, SHARD_TEST_K,
+                                              &graph, results, 0));
+  TEST_ASSERT_EQUAL_INT64(1, results[0].id);
+
+  free(vectors);
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+  remove_shard_files();
+}
+
+void test_shards_search_bitmap(void) {
+  sqlite3 *db = open_shard_db();
+  DiskAnnShards *shards = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_shards(db, shard_names, 3, "vec",
+                                            &shards));
+  float *vectors = insert_rows(db, shards);
+
+  DiskAnnBitmap odd;
+  diskann_bitmap_init(&odd);
+  for (int64_t id = 1; id <= SHARD_TEST_N; id += 2) {
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_bitmap_add(&odd, id));
+  }
+  DiskAnnResult results[SHARD_TEST_K];
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_shards_search_bitmap(
+                            shards, vectors, SHARD_TEST_DIMS, SHARD_TEST_K,
+                            NULL, NULL, results, 0));
+
+  /* One bitmap of global rowids filters every shard, on either path */
+  DiskAnnSearchParams exact = {.exact = DISKANN_SEARCH_EXACT};
+  for (uint32_t threads = 1; threads <= 3; threads += 2) {
+    for (int q = 0; q < 10; q++) {
+      const float *query = vectors + (size_t)(q * 17) * SHARD_TEST_DIMS;
+      DiskAnnResult all[SHARD_TEST_N];
+      int n_all = diskann_shards_search(shards, query, SHARD_TEST_DIMS,
+                                        SHARD_TEST_N, &exact, all, threads);
+      TEST_ASSERT_EQUAL_INT(SHARD_TEST_N, n_all);
+      int n = diskann_shards_search_bitmap(shards, query, SHARD_TEST_DIMS,
+                                           SHARD_TEST_K, &exact, &odd,
+                                           results, threads);
+      TEST_ASSERT_EQUAL_INT(SHARD_TEST_K, n);
+      int j = 0;
+      for (int i = 0; i < n_all && j < n; i++) {
+        if (all[i].id % 2 == 1) {
+          TEST_ASSERT_EQUAL_INT64(all[i].id, results[j].id);
+          j++;
+        }
+      }
+      n = diskann_shards_search_bitmap(shards, query, SHARD_TEST_DIMS,
+                                       SHARD_TEST_K, NULL, &odd, results,
+                                       threads);
+      TEST_ASSERT_TRUE(n > 0);
+      for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_INT64(1, results[i].id % 2);
+      }
+    }
+  }
+
+  diskann_bitmap_deinit(&odd);
+  free(vectors);
+  diskann_close_shards(shards);
+  sqlite3_close(db);
+  remove_shard_files();
+}
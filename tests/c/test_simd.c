@@ -0,0 +1,162 @@
+/*
+** Tests for diskann_simd.h/.c — every compiled-in kernel must agree with
+** the scalar reference implementation, including odd-length tails.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann_node.h"
+#include "../../src/diskann_simd.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Covers: tiny, sub-vector-width, exact multiples of 4/8/16/32, odd tails */
+static const uint32_t test_dims[] = {1,  3,  4,   7,   8,   15,  16,  17,
+                                     31, 33, 100, 128, 255, 256, 768, 1537};
+#define NUM_TEST_DIMS (sizeof(test_dims) / sizeof(test_dims[0]))
+
+/* dims values from seed: every kernel level sees the same vectors */
+static void fill_seeded(float *v, uint32_t dims, uint32_t seed) {
+  fill_vector(v, dims, &seed);
+}
+
+/* Relative tolerance: SIMD reorders the summation */
+static void assert_close(float expected, float actual, uint32_t dims,
+                         const char *kernel) {
+  float tol = 1e-4f * fmaxf(1.0f, fabsf(expected));
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%s dims=%u", kernel, (unsigned)dims);
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(tol, expected, actual, msg);
+}
+
+void test_simd_scalar_always_available(void) {
+  const DiskAnnDistanceKernels *k = diskann_simd_kernels(DISKANN_SIMD_SCALAR);
+  TEST_ASSERT_NOT_NULL(k);
+  TEST_ASSERT_EQUAL_INT(DISKANN_SIMD_SCALAR, k->level);
+  TEST_ASSERT_EQUAL_STRING("scalar", k->name);
+}
+
+void test_simd_selected_level_is_available(void) {
+  int level = diskann_simd_level();
+  TEST_ASSERT_TRUE(level >= DISKANN_SIMD_SCALAR);
+  TEST_ASSERT_TRUE(level < DISKANN_SIMD_LEVEL_COUNT);
+  TEST_ASSERT_NOT_NULL(diskann_simd_kernels(level));
+  /* Level is cached */
+  TEST_ASSERT_EQUAL_INT(level, diskann_simd_level());
+}
+
+void test_simd_invalid_level_returns_null(void) {
+  TEST_ASSERT_NULL(diskann_simd_kernels(-1));
+  TEST_ASSERT_NULL(diskann_simd_kernels(DISKANN_SIMD_LEVEL_COUNT));
+}
+
+void test_simd_distance_fn_by_metric(void) {
+  const DiskAnnDistanceKernels *k = diskann_simd_kernels(DISKANN_SIMD_SCALAR);
+  TEST_ASSERT_TRUE(
+      diskann_simd_distance_fn(DISKANN_SIMD_SCALAR,
+                               DISKANN_METRIC_EUCLIDEAN) == k->l2);
+  TEST_ASSERT_TRUE(diskann_simd_distance_fn(DISKANN_SIMD_SCALAR,
+                                            DISKANN_METRIC_COSINE) ==
+                   k->cosine);
+  TEST_ASSERT_TRUE(
+      diskann_simd_distance_fn(DISKANN_SIMD_SCALAR, DISKANN_METRIC_DOT) ==
+      k->neg_dot);
+  TEST_ASSERT_NULL(diskann_simd_distance_fn(DISKANN_SIMD_SCALAR, 99));
+  /* Unavailable level falls back to scalar */
+  TEST_ASSERT_TRUE(diskann_simd_distance_fn(DISKANN_SIMD_LEVEL_COUNT,
+                                            DISKANN_METRIC_EUCLIDEAN) ==
+                   k->l2);
+}
+
+void test_simd_kernels_match_scalar(void) {
+  float *a = malloc(1537 * sizeof(float));
+  float *b = malloc(1537 * sizeof(float));
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+
+  int tested = 0;
+  for (int level = 0; level < DISKANN_SIMD_LEVEL_COUNT; level++) {
+    const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+    if (!k) {
+      continue; /* not compiled in or not supported by this CPU */
+    }
+    tested++;
+    for (size_t d = 0; d < NUM_TEST_DIMS; d++) {
+      uint32_t dims = test_dims[d];
+      fill_seeded(a, dims, 42u + dims);
+      fill_seeded(b, dims, 7u * dims + 1u);
+
+      assert_close(diskann_distance_l2(a, b, dims), k->l2(a, b, dims), dims,
+                   k->name);
+      assert_close(diskann_dot_product(a, b, dims), k->dot(a, b, dims), dims,
+                   k->name);
+      assert_close(diskann_distance_dot(a, b, dims), k->neg_dot(a, b, dims),
+                   dims, k->name);
+      assert_close(diskann_distance_cosine(a, b, dims), k->cosine(a, b, dims),
+                   dims, k->name);
+    }
+  }
+  TEST_ASSERT_TRUE(tested >= 1);
+
+  free(a);
+  free(b);
+}
+
+void test_simd_kernels_zero_vector(void) {
+  float zero[17] = {0};
+  float v[17];
+  fill_seeded(v, 17, 3u);
+
+  for (int level = 0; level < DISKANN_SIMD_LEVEL_COUNT; level++) {
+    const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+    if (!k) {
+      continue;
+    }
+    /* Same convention as scalar: cosine with a zero vector is 0 */
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, k->cosine(zero, v, 17));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, k->l2(v, v, 17));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, k->dot(zero, v, 17));
+  }
+}
+
+/* Below the bound l2_bounded is bit-identical to l2; at or past it the
+** result is never below the bound */
+void test_simd_l2_bounded(void) {
+  float *a = malloc(1537 * sizeof(float));
+  float *b = malloc(1537 * sizeof(float));
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+
+  for (int level = 0; level < DISKANN_SIMD_LEVEL_COUNT; level++) {
+    const DiskAnnDistanceKernels *k = diskann_simd_kernels(level);
+    if (!k) {
+      continue;
+    }
+    TEST_ASSERT_NOT_NULL(k->l2_bounded);
+    for (size_t d = 0; d < NUM_TEST_DIMS; d++) {
+      uint32_t dims = test_dims[d];
+      fill_seeded(a, dims, 42u + dims);
+      fill_seeded(b, dims, 7u * dims + 1u);
+      float full = k->l2(a, b, dims);
+
+      TEST_ASSERT_TRUE(full == k->l2_bounded(a, b, dims, INFINITY));
+      TEST_ASSERT_TRUE(full == k->l2_bounded(a, b, dims, full * 1.001f));
+      float bounds[] = {0.0f, full * 0.01f, full * 0.5f, full};
+      for (size_t j = 0; j < sizeof(bounds) / sizeof(bounds[0]); j++) {
+        float got = k->l2_bounded(a, b, dims, bounds[j]);
+        TEST_ASSERT_TRUE(got >= bounds[j]);
+        TEST_ASSERT_TRUE(got <= full);
+      }
+    }
+    /* Past the first block the sum can stop early */
+    fill_seeded(a, 1537, 1u);
+    fill_seeded(b, 1537, 2u);
+    TEST_ASSERT_TRUE(k->l2_bounded(a, b, 1537, 1.0f) < k->l2(a, b, 1537));
+  }
+
+  free(a);
+  free(b);
+}
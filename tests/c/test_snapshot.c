@@ -0,0 +1,311 @@
+/*
+** Tests for diskann_export_snapshot() + diskann_open_snapshot() —
+** read-only memory-mapped graph snapshots.
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_internal.h"
+#include "../../src/diskann_snapshot.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define SNAPSHOT_TEST_FILE "diskann_test_snapshot.bin"
+#else
+#define SNAPSHOT_TEST_FILE "/tmp/diskann_test_snapshot.bin"
+#endif
+
+#define SNAP_TEST_DIMS 16
+#define SNAP_TEST_N 400
+#define SNAP_TEST_K 10
+#define SNAP_TEST_QUERIES 20
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+/* Index "snap" on db holding SNAP_TEST_N vectors with ids 1..n, every
+** third rowid skipped when sparse (exercises the binary-search lookup) */
+static DiskAnnIndex *create_snapshot_index(sqlite3 *db, const float *vectors,
+                                           int sparse) {
+  DiskAnnConfig config = {.dimensions = SNAP_TEST_DIMS,
+                          .metric = DISKANN_METRIC_EUCLIDEAN,
+                          .max_neighbors = 16,
+                          .search_list_size = 48,
+                          .insert_list_size = 64};
+  DiskAnnIndex *idx = create_index(db, "snap", &config);
+  for (int i = 0; i < SNAP_TEST_N; i++) {
+    int64_t id = sparse ? (int64_t)i * 3 / 2 + 1 : i + 1;
+    TEST_ASSERT_EQUAL_INT(
+        DISKANN_OK, diskann_insert(idx, id, vectors + i * SNAP_TEST_DIMS,
+                                   SNAP_TEST_DIMS));
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_refresh_entry_point(idx));
+  diskann_set_exact_scan_threshold(idx, 0); /* keep searches on the graph */
+  return idx;
+}
+
+/* Searches on both handles return the same ids and distances */
+static void assert_same_results(DiskAnnIndex *live, DiskAnnIndex *snap,
+                                const float *queries) {
+  for (int q = 0; q < SNAP_TEST_QUERIES; q++) {
+    const float *query = queries + q * SNAP_TEST_DIMS;
+    DiskAnnResult expected[SNAP_TEST_K], actual[SNAP_TEST_K];
+    int n_expected =
+        diskann_search(live, query, SNAP_TEST_DIMS, SNAP_TEST_K, expected);
+    int n_actual =
+        diskann_search(snap, query, SNAP_TEST_DIMS, SNAP_TEST_K, actual);
+    TEST_ASSERT_EQUAL_INT(SNAP_TEST_K, n_expected);
+    TEST_ASSERT_EQUAL_INT(n_expected, n_actual);
+    for (int r = 0; r < n_actual; r++) {
+      TEST_ASSERT_EQUAL_INT64(expected[r].id, actual[r].id);
+      TEST_ASSERT_EQUAL_FLOAT(expected[r].distance, actual[r].distance);
+    }
+  }
+}
+
+/* Write bytes to path, replacing it */
+static void write_file(const char *path, const void *bytes, size_t n) {
+  FILE *f = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(f);
+  TEST_ASSERT_EQUAL_size_t(n, fwrite(bytes, 1, n, f));
+  TEST_ASSERT_EQUAL_INT(0, fclose(f));
+}
+
+/* Whole file at path (caller frees), size in *n */
+static uint8_t *read_file(const char *path, size_t *n) {
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(f);
+  TEST_ASSERT_EQUAL_INT(0, fseek(f, 0, SEEK_END));
+  long size = ftell(f);
+  TEST_ASSERT_TRUE(size > 0);
+  TEST_ASSERT_EQUAL_INT(0, fseek(f, 0, SEEK_SET));
+  uint8_t *bytes = malloc((size_t)size);
+  TEST_ASSERT_NOT_NULL(bytes);
+  TEST_ASSERT_EQUAL_size_t((size_t)size, fread(bytes, 1, (size_t)size, f));
+  fclose(f);
+  *n = (size_t)size;
+  return bytes;
+}
+
+/**************************************************************************
+** Tests
+**************************************************************************/
+
+void test_snapshot_matches_live_index(void) {
+  float *vectors = gen_vectors(SNAP_TEST_N, SNAP_TEST_DIMS, 42u);
+  float *queries = gen_vectors(SNAP_TEST_QUERIES, SNAP_TEST_DIMS, 777u);
+
+  for (int sparse = 0; sparse <= 1; sparse++) {
+    sqlite3 *db = NULL;
+    TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+    DiskAnnIndex *live = create_snapshot_index(db, vectors, sparse);
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+
+    DiskAnnIndex *snap = NULL;
+    TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                          diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+    TEST_ASSERT_NOT_NULL(snap);
+    TEST_ASSERT_EQUAL_INT(!sparse, snap->snapshot->dense);
+    TEST_ASSERT_EQUAL_INT64(live->entry_rowid, snap->entry_rowid);
+    diskann_set_exact_scan_threshold(snap, 0);
+    assert_same_results(live, snap, queries);
+
+    /* Searches read the mapping, not SQLite */
+    TEST_ASSERT_EQUAL_UINT64(0, snap->num_reads);
+
+    /* Exact scans agree as well */
+    DiskAnnResult expected[SNAP_TEST_K], actual[SNAP_TEST_K];
+    int n_expected = diskann_search_exact(live, queries, SNAP_TEST_DIMS,
+                                          SNAP_TEST_K, expected, NULL, NULL);
+    int n_actual = diskann_search_exact(snap, queries, SNAP_TEST_DIMS,
+                                        SNAP_TEST_K, actual, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(SNAP_TEST_K, n_actual);
+    TEST_ASSERT_EQUAL_INT(n_expected, n_actual);
+    for (int r = 0; r < n_actual; r++) {
+      TEST_ASSERT_EQUAL_INT64(expected[r].id, actual[r].id);
+    }
+
+    diskann_close_index(snap);
+    diskann_close_index(live);
+    sqlite3_close(db);
+  }
+
+  remove(SNAPSHOT_TEST_FILE);
+  free(queries);
+  free(vectors);
+}
+
+void test_snapshot_is_read_only(void) {
+  float *vectors = gen_vectors(SNAP_TEST_N, SNAP_TEST_DIMS, 42u);
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *live = create_snapshot_index(db, vectors, 0);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+  DiskAnnIndex *snap = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_insert(snap, 9999, vectors, SNAP_TEST_DIMS));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_delete(snap, 1));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_refresh_entry_point(snap));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_export_snapshot(snap, SNAPSHOT_TEST_FILE));
+
+  /* Later writes to the source do not reach the snapshot */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_delete(live, 1));
+  DiskAnnResult result;
+  TEST_ASSERT_EQUAL_INT(
+      1, diskann_search(snap, vectors, SNAP_TEST_DIMS, 1, &result));
+  TEST_ASSERT_EQUAL_INT64(1, result.id);
+
+  diskann_close_index(snap);
+  diskann_close_index(live);
+  sqlite3_close(db);
+  remove(SNAPSHOT_TEST_FILE);
+  free(vectors);
+}
+
+void test_snapshot_batch_and_readers(void) {
+  float *vectors = gen_vectors(SNAP_TEST_N, SNAP_TEST_DIMS, 42u);
+  float *queries = gen_vectors(SNAP_TEST_QUERIES, SNAP_TEST_DIMS, 777u);
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *live = create_snapshot_index(db, vectors, 0);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+  DiskAnnIndex *snap = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+  diskann_set_exact_scan_threshold(snap, 0);
+
+  /* Parallel batch workers share the mapping without connections */
+  DiskAnnResult batch[SNAP_TEST_QUERIES * SNAP_TEST_K];
+  int counts[SNAP_TEST_QUERIES];
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_search_batch(snap, queries, SNAP_TEST_QUERIES,
+                                             SNAP_TEST_DIMS, SNAP_TEST_K,
+                                             batch, counts, 4));
+
+  DiskAnnIndex *reader = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_reader(snap, NULL, NULL, &reader));
+  for (int q = 0; q < SNAP_TEST_QUERIES; q++) {
+    DiskAnnResult results[SNAP_TEST_K];
+    int n = diskann_search(reader, queries + q * SNAP_TEST_DIMS,
+                           SNAP_TEST_DIMS, SNAP_TEST_K, results);
+    TEST_ASSERT_EQUAL_INT(counts[q], n);
+    for (int r = 0; r < n; r++) {
+      TEST_ASSERT_EQUAL_INT64(results[r].id, batch[q * SNAP_TEST_K + r].id);
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_delete(reader, 1));
+
+  diskann_close_index(reader);
+  diskann_close_index(snap);
+  diskann_close_index(live);
+  sqlite3_close(db);
+  remove(SNAPSHOT_TEST_FILE);
+  free(queries);
+  free(vectors);
+}
+
+void test_snapshot_empty_index(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnConfig config = {.dimensions = SNAP_TEST_DIMS,
+                          .metric = DISKANN_METRIC_COSINE,
+                          .max_neighbors = 16,
+                          .search_list_size = 48,
+                          .insert_list_size = 64};
+  DiskAnnIndex *live = create_index(db, "snap", &config);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+
+  DiskAnnIndex *snap = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+  TEST_ASSERT_EQUAL_UINT8(DISKANN_METRIC_COSINE, snap->metric);
+  float query[SNAP_TEST_DIMS] = {1.0f};
+  DiskAnnResult result;
+  TEST_ASSERT_EQUAL_INT(
+      0, diskann_search(snap, query, SNAP_TEST_DIMS, 1, &result));
+  TEST_ASSERT_EQUAL_INT(0, diskann_search_exact(snap, query, SNAP_TEST_DIMS,
+                                                1, &result, NULL, NULL));
+
+  diskann_close_index(snap);
+  diskann_close_index(live);
+  sqlite3_close(db);
+  remove(SNAPSHOT_TEST_FILE);
+}
+
+void test_snapshot_rejects_bad_files(void) {
+  float *vectors = gen_vectors(SNAP_TEST_N, SNAP_TEST_DIMS, 42u);
+  DiskAnnIndex *snap = NULL;
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_open_snapshot(NULL, &snap));
+  remove(SNAPSHOT_TEST_FILE);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_IO,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+  TEST_ASSERT_NULL(snap);
+
+  /* Too short for a header */
+  write_file(SNAPSHOT_TEST_FILE, "DANNSNAP", 8);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_VERSION,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *live = create_snapshot_index(db, vectors, 0);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+  size_t n = 0;
+  uint8_t *bytes = read_file(SNAPSHOT_TEST_FILE, &n);
+
+  /* Bad magic */
+  bytes[0] ^= 0xff;
+  write_file(SNAPSHOT_TEST_FILE, bytes, n);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_VERSION,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+  bytes[0] ^= 0xff;
+
+  /* Truncated */
+  write_file(SNAPSHOT_TEST_FILE, bytes, n - sizeof(int64_t));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+
+  /* Rowids out of order */
+  DiskAnnSnapshotHeader header;
+  memcpy(&header, bytes, sizeof(header));
+  int64_t *rowids = (int64_t *)(bytes + header.rowids_offset);
+  int64_t tmp = rowids[0];
+  rowids[0] = rowids[1];
+  rowids[1] = tmp;
+  write_file(SNAPSHOT_TEST_FILE, bytes, n);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR,
+                        diskann_open_snapshot(SNAPSHOT_TEST_FILE, &snap));
+  TEST_ASSERT_NULL(snap);
+
+  /* Batch mode keeps queued deletes off disk: refuse to export */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_begin_batch(live, 0));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID,
+                        diskann_export_snapshot(live, SNAPSHOT_TEST_FILE));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_end_batch(live));
+
+  free(bytes);
+  diskann_close_index(live);
+  sqlite3_close(db);
+  remove(SNAPSHOT_TEST_FILE);
+  free(vectors);
+}
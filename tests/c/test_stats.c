@@ -0,0 +1,279 @@
+/*
+** Tests for diskann_stats() and the "<table>_stats" virtual table
+**
+** Copyright 2026 PhotoStructure Inc.
+** MIT License
+*/
+#include "../../src/diskann.h"
+#include "../../src/diskann_label.h"
+#include "../../src/diskann_search.h"
+#include "test_helpers.h"
+#include "unity/unity.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int sqlite3_diskann_init(sqlite3 *db, char **pzErrMsg,
+                                const sqlite3_api_routines *pApi);
+
+#ifdef _WIN32
+#define STATS_TEST_DB "diskann_test_stats.db"
+#else
+#define STATS_TEST_DB "/tmp/diskann_test_stats.db"
+#endif
+
+#define STATS_TEST_DIMS 16
+#define STATS_TEST_N 200
+#define STATS_TEST_QUERIES 20
+#define STATS_TEST_K 5
+
+/**************************************************************************
+** Helpers
+**************************************************************************/
+
+static const DiskAnnConfig stats_config = {
+    .dimensions = STATS_TEST_DIMS,
+    .metric = DISKANN_METRIC_EUCLIDEAN,
+    .max_neighbors = 16,
+    .search_list_size = 32,
+    .insert_list_size = 32};
+
+/* Index "idx" of STATS_TEST_N random vectors on db */
+static DiskAnnIndex *build_stats_index(sqlite3 *db) {
+  return build_index(db, &stats_config, STATS_TEST_N, 7);
+}
+
+static uint64_t visited_total(const DiskAnnStats *s) {
+  uint64_t total = 0;
+  for (int i = 0; i < DISKANN_STATS_VISITED_BUCKETS; i++) {
+    total += s->visited[i];
+  }
+  return total;
+}
+
+/* value of stat in table_stats (-1 if the row is missing) */
+static sqlite3_int64 stat_value(sqlite3 *db, const char *stat) {
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db, "SELECT value FROM t_stats WHERE stat = ?", -1,
+                         &stmt, NULL));
+  sqlite3_bind_text(stmt, 1, stat, -1, SQLITE_STATIC);
+  sqlite3_int64 value = -1;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    value = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return value;
+}
+
+/**************************************************************************
+** diskann_stats()
+**************************************************************************/
+
+void test_stats_invalid(void) {
+  DiskAnnStats stats;
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_stats(NULL, &stats));
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_stats_reset(NULL));
+
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = create_index(db, "idx", &stats_config);
+  TEST_ASSERT_EQUAL_INT(DISKANN_ERROR_INVALID, diskann_stats(idx, NULL));
+
+  /* A fresh handle has counted nothing */
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(0, stats.searches);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.inserts);
+  TEST_ASSERT_TRUE(stats.search_p50_us == 0.0);
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_stats_counts_inserts_and_searches(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  DiskAnnIndex *idx = build_stats_index(db);
+
+  DiskAnnStats stats;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_N, stats.inserts);
+  TEST_ASSERT_TRUE(stats.insert_p50_us > 0.0);
+  TEST_ASSERT_TRUE(stats.insert_p99_us >= stats.insert_p50_us);
+  TEST_ASSERT_TRUE(stats.blocks_written > 0);
+  /* Links rewrite only the edge slots they change */
+  TEST_ASSERT_TRUE(stats.bytes_written > 0);
+  TEST_ASSERT_TRUE(stats.bytes_written <
+                   stats.blocks_written * idx->block_size);
+  TEST_ASSERT_TRUE(stats.insert_cache_hits + stats.insert_cache_misses > 0);
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats_reset(idx));
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(0, stats.inserts);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.blocks_written);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.bytes_written);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.insert_cache_misses);
+
+  /* Graph searches walk; exact ones count as searches only */
+  DiskAnnSearchParams graph = {.exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnSearchParams exact = {.exact = DISKANN_SEARCH_EXACT};
+  DiskAnnResult results[STATS_TEST_K];
+  uint32_t state = 99;
+  float q[STATS_TEST_DIMS];
+  for (int i = 0; i < STATS_TEST_QUERIES; i++) {
+    fill_vector(q, STATS_TEST_DIMS, &state);
+    TEST_ASSERT_EQUAL_INT(STATS_TEST_K,
+                          diskann_search_ex(idx, q, STATS_TEST_DIMS,
+                                            STATS_TEST_K, &graph, results,
+                                            NULL, NULL));
+  }
+  TEST_ASSERT_EQUAL_INT(STATS_TEST_K,
+                        diskann_search_ex(idx, q, STATS_TEST_DIMS,
+                                          STATS_TEST_K, &exact, results, NULL,
+                                          NULL));
+
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES + 1, stats.searches);
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES, visited_total(&stats));
+  TEST_ASSERT_TRUE(stats.nodes_visited >= STATS_TEST_QUERIES * STATS_TEST_K);
+  TEST_ASSERT_TRUE(stats.blocks_read > 0);
+  TEST_ASSERT_TRUE(stats.bytes_read > 0);
+  TEST_ASSERT_TRUE(stats.search_p50_us > 0.0);
+  TEST_ASSERT_TRUE(stats.search_p99_us >= stats.search_p50_us);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.inserts);
+
+  /* Walks of at least 2^i nodes land in bucket i or above */
+  uint64_t low = 0;
+  for (int i = 0; i < 3; i++) {
+    low += stats.visited[i];
+  }
+  TEST_ASSERT_EQUAL_UINT64(0, low);
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+}
+
+void test_stats_batch_and_stream(void) {
+  remove(STATS_TEST_DB);
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(STATS_TEST_DB, &db));
+  DiskAnnIndex *idx = build_stats_index(db);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats_reset(idx));
+
+  /* Parallel workers fold their counters into the caller's handle */
+  float queries[STATS_TEST_QUERIES * STATS_TEST_DIMS];
+  uint32_t state = 3;
+  for (int i = 0; i < STATS_TEST_QUERIES; i++) {
+    fill_vector(queries + i * STATS_TEST_DIMS, STATS_TEST_DIMS, &state);
+  }
+  DiskAnnSearchParams graph = {.exact = DISKANN_SEARCH_GRAPH};
+  DiskAnnResult results[STATS_TEST_QUERIES * STATS_TEST_K];
+  int n_results[STATS_TEST_QUERIES];
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_search_batch_ex(
+                            idx, queries, STATS_TEST_QUERIES, STATS_TEST_DIMS,
+                            STATS_TEST_K, &graph, results, n_results, 4));
+
+  DiskAnnStats stats;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES, stats.searches);
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES, visited_total(&stats));
+  TEST_ASSERT_TRUE(stats.blocks_read > 0);
+
+  /* A stream is one search, recorded when it closes */
+  DiskAnnSearchStream *stream = NULL;
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK,
+                        diskann_search_stream_open(idx, queries,
+                                                   STATS_TEST_DIMS, 30,
+                                                   INFINITY, NULL,
+                                                   DISKANN_LABEL_NONE, &graph,
+                                                   &stream));
+  DiskAnnResult row;
+  int n = 0;
+  while (diskann_search_stream_next(stream, &row) == 1) {
+    n++;
+  }
+  TEST_ASSERT_EQUAL_INT(30, n);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES, stats.searches);
+  diskann_search_stream_close(stream);
+  TEST_ASSERT_EQUAL_INT(DISKANN_OK, diskann_stats(idx, &stats));
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES + 1, stats.searches);
+  TEST_ASSERT_EQUAL_UINT64(STATS_TEST_QUERIES + 1, visited_total(&stats));
+
+  diskann_close_index(idx);
+  sqlite3_close(db);
+  remove(STATS_TEST_DB);
+}
+
+/**************************************************************************
+** "<table>_stats" virtual table
+**************************************************************************/
+
+void test_stats_vtab(void) {
+  sqlite3 *db = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(":memory:", &db));
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_diskann_init(db, NULL, NULL));
+  exec_ok(
+      db,
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, metric=euclidean)");
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(1, X'0000803f0000000000000000'), " /* [1,0,0] */
+              "(2, X'000000000000803f00000000'), " /* [0,1,0] */
+              "(3, X'00000000000000000000803f')"); /* [0,0,1] */
+  exec_ok(db, "SELECT rowid FROM t WHERE vector MATCH "
+              "X'0000803f0000000000000000' AND k = 2");
+
+  TEST_ASSERT_EQUAL_INT64(3, stat_value(db, "inserts"));
+  TEST_ASSERT_EQUAL_INT64(1, stat_value(db, "searches"));
+  TEST_ASSERT_EQUAL_INT64(0, stat_value(db, "visited_lt_2"));
+  TEST_ASSERT_EQUAL_INT64(0, stat_value(db, "visited_ge_32768"));
+
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db, "SELECT count(*) FROM t_stats",
+                                           -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  TEST_ASSERT_EQUAL_INT(18 + DISKANN_STATS_VISITED_BUCKETS,
+                        sqlite3_column_int(stmt, 0));
+  sqlite3_finalize(stmt);
+
+  /* Hit rates are NULL until the cache is used */
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db,
+                                           "SELECT value IS NULL OR value "
+                                           "BETWEEN 0 AND 1 FROM t_stats "
+                                           "WHERE stat LIKE '%hit_rate'",
+                                           -1, &stmt, NULL));
+  int rows = 0;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    TEST_ASSERT_EQUAL_INT(1, sqlite3_column_int(stmt, 0));
+    rows++;
+  }
+  TEST_ASSERT_EQUAL_INT(2, rows);
+  sqlite3_finalize(stmt);
+
+  /* The view is eponymous only, and errors once its table is gone */
+  char *err = NULL;
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK,
+      sqlite3_exec(db, "CREATE VIRTUAL TABLE s USING t_stats", NULL, NULL,
+                   &err));
+  sqlite3_free(err);
+  exec_ok(db, "DROP TABLE t");
+  err = NULL;
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK, sqlite3_exec(db, "SELECT * FROM t_stats", NULL, NULL, &err));
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NOT_NULL(strstr(err, "not open"));
+  sqlite3_free(err);
+
+  /* A new table of the same name takes the view over */
+  exec_ok(
+      db,
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, metric=euclidean)");
+  TEST_ASSERT_EQUAL_INT64(0, stat_value(db, "inserts"));
+  sqlite3_close(db);
+}
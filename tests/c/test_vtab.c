@@ -9,6 +9,7 @@
 ** Copyright 2026 PhotoStructure Inc.
 ** MIT License
 */
+#include "test_helpers.h"
 #include "unity/unity.h"
 #include <math.h>
 #include <sqlite3.h>
@@ -50,16 +51,6 @@ static sqlite3 *open_vtab_db(void) {
   return db;
 }
 
-static void exec_ok(sqlite3 *db, const char *sql) {
-  char *err = NULL;
-  int rc = sqlite3_exec(db, sql, NULL, NULL, &err);
-  if (err) {
-    fprintf(stderr, "SQL error: %s\nSQL: %s\n", err, sql);
-    sqlite3_free(err);
-  }
-  TEST_ASSERT_EQUAL_INT(SQLITE_OK, rc);
-}
-
 static int exec_expect_error(sqlite3 *db, const char *sql) {
   char *err = NULL;
   int rc = sqlite3_exec(db, sql, NULL, NULL, &err);
@@ -168,6 +159,21 @@ static int search_vtab_limit(sqlite3 *db, const char *table, const float *query,
   return count;
 }
 
+/* Rowids of a query's rows, in order; returns the count */
+static int query_rowids(sqlite3 *db, const char *sql, const float *query,
+                        int query_bytes, int64_t *rowids, int max) {
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db, sql, -1, &stmt, NULL));
+  sqlite3_bind_blob(stmt, 1, query, query_bytes, SQLITE_STATIC);
+  int n = 0;
+  while (sqlite3_step(stmt) == SQLITE_ROW && n < max) {
+    rowids[n++] = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return n;
+}
+
 /**************************************************************************
 ** CREATE/DROP tests (5)
 **************************************************************************/
@@ -200,6 +206,93 @@ void test_vtab_create_bad_metric(void) {
   sqlite3_close(db);
 }
 
+void test_vtab_create_edge_type_int8(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, edge_type=int8, quant_min=0, quant_max=1)");
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(1, X'0000803f0000000000000000')"); /* [1,0,0] */
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(2, X'000000000000803f00000000')"); /* [0,1,0] */
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(3, X'0000803f0000803f00000000')"); /* [1,1,0] */
+
+  float query[] = {1.0f, 0.1f, 0.0f};
+  int64_t rowids[3];
+  float distances[3];
+  int n = search_vtab(db, "t", query, (int)sizeof(query), 3, rowids,
+                      distances, 3);
+  TEST_ASSERT_EQUAL_INT(3, n);
+  TEST_ASSERT_EQUAL_INT64(1, rowids[0]);
+  /* Exact (reranked) squared L2 distance to [1,0,0] */
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.01f, distances[0]);
+
+  sqlite3_close(db);
+}
+
+void test_vtab_create_bad_edge_type(void) {
+  sqlite3 *db = open_vtab_db();
+  int rc = exec_expect_error(
+      db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, edge_type=int4)");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK, rc);
+  rc = exec_expect_error(db, "CREATE VIRTUAL TABLE t2 USING diskann("
+                             "dimension=3, edge_type=int8, quant_min=1, "
+                             "quant_max=-1)");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK, rc);
+  sqlite3_close(db);
+}
+
+void test_vtab_vector_type_f16(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, vector_type=f16)");
+  /* Vectors are binary16 BLOBs, 2 bytes per dimension */
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(1, X'003C00000000')"); /* [1,0,0] */
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(2, X'0000003C0000')"); /* [0,1,0] */
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(3, X'003C003C0000')"); /* [1,1,0] */
+
+  /* A float32 BLOB has the wrong size for a binary16 table */
+  int rc = exec_expect_error(db, "INSERT INTO t(rowid, vector) VALUES "
+                                 "(4, X'0000803f0000000000000000')");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK, rc);
+
+  /* [1, 0.1, 0]: 0.1 is 0x2E66 in binary16 */
+  static const uint8_t query[] = {0x00, 0x3C, 0x66, 0x2E, 0x00, 0x00};
+  sqlite3_stmt *stmt = NULL;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db,
+                         "SELECT rowid, distance FROM t "
+                         "WHERE vector MATCH ?1 AND k = 3",
+                         -1, &stmt, NULL));
+  sqlite3_bind_blob(stmt, 1, query, (int)sizeof(query), SQLITE_STATIC);
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  TEST_ASSERT_EQUAL_INT64(1, sqlite3_column_int64(stmt, 0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.01f,
+                           (float)sqlite3_column_double(stmt, 1));
+  int n = 1;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    n++;
+  }
+  sqlite3_finalize(stmt);
+  TEST_ASSERT_EQUAL_INT(3, n);
+
+  sqlite3_close(db);
+}
+
+void test_vtab_create_bad_vector_type(void) {
+  sqlite3 *db = open_vtab_db();
+  int rc = exec_expect_error(
+      db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, vector_type=f8)");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK, rc);
+  exec_ok(db, "CREATE VIRTUAL TABLE t2 USING diskann(dimension=3, "
+              "vector_type=bfloat16)");
+  sqlite3_close(db);
+}
+
 void test_vtab_drop(void) {
   sqlite3 *db = open_vtab_db();
   exec_ok(
@@ -442,6 +535,92 @@ void test_vtab_delete_nonexistent(void) {
   sqlite3_close(db);
 }
 
+void test_vtab_delete_tombstone(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, delete_mode=tombstone, "
+              "consolidate_threshold=2)");
+  exec_ok(db, "INSERT INTO t(rowid, vector) VALUES "
+              "(1, X'0000803f0000000000000000'), "
+              "(2, X'000000000000803f00000000'), "
+              "(3, X'00000000000000000000803f'), "
+              "(4, X'0000803f0000803f00000000')");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK,
+                        exec_expect_error(db, "CREATE VIRTUAL TABLE u USING "
+                                              "diskann(dimension=3, "
+                                              "delete_mode=lazy)"));
+
+  /* Tombstoned: gone from searches and rowid lookups, block kept */
+  exec_ok(db, "DELETE FROM t WHERE rowid = 1");
+  TEST_ASSERT_EQUAL_INT(0,
+                        count_rows(db, "SELECT rowid FROM t WHERE rowid = 1"));
+  TEST_ASSERT_EQUAL_INT(4, count_rows(db, "SELECT id FROM t_shadow"));
+  float query[] = {1.0f, 0.0f, 0.0f};
+  int64_t rowids[4];
+  int n = search_vtab(db, "t", query, (int)sizeof(query), 4, rowids, NULL, 4);
+  TEST_ASSERT_EQUAL_INT(3, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_NOT_EQUAL(1, (int)rowids[i]);
+  }
+
+  /* The second tombstone reaches consolidate_threshold */
+  exec_ok(db, "DELETE FROM t WHERE rowid = 2");
+  TEST_ASSERT_EQUAL_INT(2, count_rows(db, "SELECT id FROM t_shadow"));
+
+  sqlite3_close(db);
+}
+
+void test_vtab_delete_multi_row(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, album INTEGER)");
+  char sql[160];
+  for (int i = 1; i <= 60; i++) {
+    float v[3] = {(float)(i % 7), (float)(i % 11), (float)i * 0.1f};
+    const uint8_t *b = (const uint8_t *)v;
+    snprintf(sql, sizeof(sql),
+             "INSERT INTO t(rowid, vector, album) VALUES (%d, X'%02x%02x%02x"
+             "%02x%02x%02x%02x%02x%02x%02x%02x%02x', %d)",
+             i, b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], b[8], b[9],
+             b[10], b[11], i % 3);
+    exec_ok(db, sql);
+  }
+
+  /* Queued deletes are invisible inside the transaction */
+  exec_ok(db, "BEGIN");
+  exec_ok(db, "DELETE FROM t WHERE rowid IN "
+              "(SELECT rowid FROM t_attrs WHERE album = 0)");
+  TEST_ASSERT_EQUAL_INT(60, count_rows(db, "SELECT id FROM t_shadow"));
+  TEST_ASSERT_EQUAL_INT(0,
+                        count_rows(db, "SELECT rowid FROM t WHERE rowid = 3"));
+  float query[] = {3.0f, 3.0f, 0.3f};
+  int64_t rowids[10];
+  int n = search_vtab(db, "t", query, (int)sizeof(query), 10, rowids, NULL, 10);
+  TEST_ASSERT_EQUAL_INT(10, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_NOT_EQUAL(0, (int)(rowids[i] % 3));
+  }
+
+  /* A rolled-back savepoint takes its queued deletes with it */
+  exec_ok(db, "SAVEPOINT s");
+  exec_ok(db, "DELETE FROM t WHERE rowid = 1");
+  exec_ok(db, "ROLLBACK TO s");
+  exec_ok(db, "RELEASE s");
+  exec_ok(db, "COMMIT");
+  TEST_ASSERT_EQUAL_INT(40, count_rows(db, "SELECT id FROM t_shadow"));
+  TEST_ASSERT_EQUAL_INT(1,
+                        count_rows(db, "SELECT rowid FROM t WHERE rowid = 1"));
+
+  /* A rolled-back transaction deletes nothing */
+  exec_ok(db, "BEGIN");
+  exec_ok(db, "DELETE FROM t WHERE rowid IN (1, 2, 4)");
+  exec_ok(db, "ROLLBACK");
+  TEST_ASSERT_EQUAL_INT(40, count_rows(db, "SELECT id FROM t_shadow"));
+  TEST_ASSERT_EQUAL_INT(40, count_rows(db, "SELECT rowid FROM t_attrs"));
+
+  sqlite3_close(db);
+}
+
 /**************************************************************************
 ** PERSISTENCE test (1)
 **************************************************************************/
@@ -1470,7 +1649,7 @@ void test_vtab_filter_graph_bridge(void) {
 }
 
 /**************************************************************************
-** Vtab batch transaction tests (4)
+** Vtab batch transaction tests (5)
 **
 ** Verify that vtab transaction hooks (xBegin/xSync/xCommit/xRollback)
 ** activate the persistent BlobCache for write transactions.
@@ -1591,3 +1770,1021 @@ void test_vtab_batch_multiple_txns(void) {
 
   sqlite3_close(db);
 }
+
+#define BULK_DIMS 16
+#define BULK_ROWS 400
+#define BULK_K 10
+
+/* Insert the BULK_ROWS vectors into table with one prepared statement */
+static void bulk_insert(sqlite3 *db, const char *table, const float *vectors) {
+  char *sql =
+      sqlite3_mprintf("INSERT INTO %s(rowid, vector) VALUES (?, ?)", table);
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db, sql, -1, &stmt, NULL));
+  sqlite3_free(sql);
+  for (int i = 0; i < BULK_ROWS; i++) {
+    sqlite3_bind_int(stmt, 1, i + 1);
+    sqlite3_bind_blob(stmt, 2, vectors + (size_t)i * BULK_DIMS,
+                      BULK_DIMS * (int)sizeof(float), SQLITE_STATIC);
+    TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+}
+
+/*
+** Rows inserted under one savepoint (insertVectors() in the TS API) go
+** through the batch path: the graph, and so recall, must match inserting
+** them one autocommit statement at a time.
+*/
+void test_vtab_batch_savepoint_recall(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE a USING diskann(dimension=16, "
+              "metric=euclidean)");
+  exec_ok(db, "CREATE VIRTUAL TABLE b USING diskann(dimension=16, "
+              "metric=euclidean)");
+  float *vectors = gen_vectors(BULK_ROWS, BULK_DIMS, 99);
+
+  bulk_insert(db, "a", vectors);
+  exec_ok(db, "SAVEPOINT bulk");
+  bulk_insert(db, "b", vectors);
+  exec_ok(db, "RELEASE bulk");
+
+  int hits = 0;
+  for (int q = 0; q < 20; q++) {
+    float query[BULK_DIMS];
+    for (int c = 0; c < BULK_DIMS; c++) {
+      query[c] = vectors[(size_t)(q * 19) * BULK_DIMS + (size_t)c] + 0.05f;
+    }
+    int64_t truth[BULK_K], per_row[BULK_K], bulk[BULK_K];
+    TEST_ASSERT_EQUAL_INT(
+        BULK_K, query_rowids(db,
+                             "SELECT rowid FROM a WHERE vector MATCH ?1 "
+                             "AND k = 10 AND exact = 1",
+                             query, (int)sizeof(query), truth, BULK_K));
+    TEST_ASSERT_EQUAL_INT(
+        BULK_K, query_rowids(db,
+                             "SELECT rowid FROM a WHERE vector MATCH ?1 "
+                             "AND k = 10 AND exact = 0",
+                             query, (int)sizeof(query), per_row, BULK_K));
+    TEST_ASSERT_EQUAL_INT(
+        BULK_K, query_rowids(db,
+                             "SELECT rowid FROM b WHERE vector MATCH ?1 "
+                             "AND k = 10 AND exact = 0",
+                             query, (int)sizeof(query), bulk, BULK_K));
+    for (int j = 0; j < BULK_K; j++) {
+      TEST_ASSERT_EQUAL_INT64(per_row[j], bulk[j]);
+      for (int t = 0; t < BULK_K; t++) {
+        hits += bulk[j] == truth[t];
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(hits >= 20 * BULK_K * 9 / 10);
+
+  free(vectors);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Multi-query MATCH: n concatenated query vectors, k results per query
+**************************************************************************/
+
+/*
+** Run a multi-query MATCH, collecting (query_index, rowid) pairs.
+** Returns the row count.
+*/
+static int search_vtab_multi(sqlite3 *db, const float *queries,
+                             int query_bytes, int k, const char *extra,
+                             int *out_query, int64_t *out_rowids,
+                             int max_results) {
+  char *sql = sqlite3_mprintf("SELECT query_index, rowid FROM t "
+                              "WHERE vector MATCH ?1 AND k = ?2%s",
+                              extra ? extra : "");
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, rc);
+
+  sqlite3_bind_blob(stmt, 1, queries, query_bytes, SQLITE_STATIC);
+  sqlite3_bind_int(stmt, 2, k);
+
+  int n = 0;
+  while (sqlite3_step(stmt) == SQLITE_ROW && n < max_results) {
+    out_query[n] = sqlite3_column_int(stmt, 0);
+    out_rowids[n] = sqlite3_column_int64(stmt, 1);
+    n++;
+  }
+  sqlite3_finalize(stmt);
+  return n;
+}
+
+void test_vtab_multi_query_match(void) {
+  sqlite3 *db = create_populated_vtab();
+
+  /* [1,0,0] then [0,0,1]: nearest are rowid 1 and rowid 3 */
+  float queries[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+  int query_index[8];
+  int64_t rowids[8];
+  int n = search_vtab_multi(db, queries, (int)sizeof(queries), 2, NULL,
+                            query_index, rowids, 8);
+  TEST_ASSERT_EQUAL_INT(4, n);
+  TEST_ASSERT_EQUAL_INT(0, query_index[0]);
+  TEST_ASSERT_EQUAL_INT64(1, rowids[0]);
+  TEST_ASSERT_EQUAL_INT(0, query_index[1]);
+  TEST_ASSERT_EQUAL_INT(1, query_index[2]);
+  TEST_ASSERT_EQUAL_INT64(3, rowids[2]);
+  TEST_ASSERT_EQUAL_INT(1, query_index[3]);
+
+  /* A single query reports query_index 0 */
+  n = search_vtab_multi(db, queries, 3 * (int)sizeof(float), 1, NULL,
+                        query_index, rowids, 8);
+  TEST_ASSERT_EQUAL_INT(1, n);
+  TEST_ASSERT_EQUAL_INT(0, query_index[0]);
+
+  sqlite3_close(db);
+}
+
+void test_vtab_multi_query_filtered(void) {
+  sqlite3 *db = create_filter_vtab();
+
+  /* Near cluster A, then near cluster B; both restricted to category B */
+  float queries[] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  int query_index[16];
+  int64_t rowids[16];
+  int n = search_vtab_multi(db, queries, (int)sizeof(queries), 3,
+                            " AND category = 'B'", query_index, rowids, 16);
+  TEST_ASSERT_EQUAL_INT(6, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT(i / 3, query_index[i]);
+    TEST_ASSERT_TRUE_MESSAGE(rowids[i] >= 11 && rowids[i] <= 20,
+                             "Expected only category B rowids (11-20)");
+  }
+  TEST_ASSERT_EQUAL_INT64(20, rowids[3]); /* [0,1,0] nearest in B */
+
+  sqlite3_close(db);
+}
+
+void test_vtab_query_index_reserved(void) {
+  sqlite3 *db = open_vtab_db();
+  int rc = exec_expect_error(db, "CREATE VIRTUAL TABLE t USING diskann("
+                                 "dimension=3, query_index INTEGER)");
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK, rc);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Filter bitmap cache
+**************************************************************************/
+
+/* A repeated filter is served from the cache until the data changes */
+void test_vtab_filter_cache_invalidation(void) {
+  sqlite3 *db = create_filter_vtab();
+  float query[] = {0.0f, 5.0f, 0.0f};
+  int64_t rowids[20];
+
+  for (int pass = 0; pass < 2; pass++) {
+    int n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 1,
+                                 " AND category = 'B'", rowids, NULL, 20);
+    TEST_ASSERT_EQUAL_INT(1, n);
+    TEST_ASSERT_EQUAL_INT64(20, rowids[0]);
+  }
+
+  /* Uncommitted rows are visible to filters, and gone after rollback */
+  exec_ok(db, "BEGIN");
+  exec_ok(db, "INSERT INTO t(rowid, vector, category, score) VALUES "
+              "(21, X'000000000000a04000000000', 'B', 3.0)"); /* [0,5,0] */
+  int n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 1,
+                               " AND category = 'B'", rowids, NULL, 20);
+  TEST_ASSERT_EQUAL_INT(1, n);
+  TEST_ASSERT_EQUAL_INT64(21, rowids[0]);
+  exec_ok(db, "ROLLBACK");
+  n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 1,
+                           " AND category = 'B'", rowids, NULL, 20);
+  TEST_ASSERT_EQUAL_INT(1, n);
+  TEST_ASSERT_EQUAL_INT64(20, rowids[0]);
+
+  /* A committed change clears cached filters */
+  exec_ok(db, "INSERT INTO t(rowid, vector, category, score) VALUES "
+              "(21, X'000000000000a04000000000', 'B', 3.0)");
+  n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 1,
+                           " AND category = 'B'", rowids, NULL, 20);
+  TEST_ASSERT_EQUAL_INT(1, n);
+  TEST_ASSERT_EQUAL_INT64(21, rowids[0]);
+  exec_ok(db, "DELETE FROM t WHERE rowid = 21");
+  n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 1,
+                           " AND category = 'B'", rowids, NULL, 20);
+  TEST_ASSERT_EQUAL_INT(1, n);
+  TEST_ASSERT_EQUAL_INT64(20, rowids[0]);
+
+  sqlite3_close(db);
+}
+
+/* Same SQL with different bound values must not share an entry */
+void test_vtab_filter_cache_keys_values(void) {
+  sqlite3 *db = create_filter_vtab();
+  float query[] = {0.5f, 0.5f, 0.0f};
+  int64_t rowids[20];
+
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db,
+                         "SELECT rowid FROM t WHERE vector MATCH ?1 "
+                         "AND k = 20 AND category = ?2",
+                         -1, &stmt, NULL));
+  const char *cats[] = {"A", "B", "A"};
+  for (int c = 0; c < 3; c++) {
+    sqlite3_bind_blob(stmt, 1, query, (int)sizeof(query), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, cats[c], -1, SQLITE_STATIC);
+    int n = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      rowids[n++] = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+    TEST_ASSERT_EQUAL_INT(10, n);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_TRUE(c == 1 ? rowids[i] > 10 : rowids[i] <= 10);
+    }
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** LABEL metadata columns (label-aware filtered graph)
+**************************************************************************/
+
+void test_vtab_label_create(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann("
+              "dimension=3, cat TEXT label, score REAL)");
+  TEST_ASSERT_EQUAL_INT(
+      1, count_rows(db, "SELECT 1 FROM t_columns WHERE name = 'cat' "
+                        "AND label = 1"));
+  TEST_ASSERT_EQUAL_INT(
+      1, count_rows(db, "SELECT 1 FROM t_columns WHERE name = 'score' "
+                        "AND label = 0"));
+
+  /* One LABEL column per table, and no other flags */
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK,
+                        exec_expect_error(db, "CREATE VIRTUAL TABLE t2 USING "
+                                              "diskann(dimension=3, a TEXT "
+                                              "LABEL, b INTEGER LABEL)"));
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK,
+                        exec_expect_error(db, "CREATE VIRTUAL TABLE t3 USING "
+                                              "diskann(dimension=3, a TEXT "
+                                              "UNIQUE)"));
+  sqlite3_close(db);
+}
+
+#define LABEL_DIMS 16
+#define LABEL_ROWS 1500
+#define LABEL_VALUES 15
+
+static void label_vector(int rowid, float *v) {
+  uint32_t seed = (uint32_t)rowid * 2654435761u;
+  for (int d = 0; d < LABEL_DIMS; d++) {
+    seed = seed * 1103515245u + 12345u;
+    v[d] = (float)(seed >> 8) / (float)(1u << 24);
+  }
+}
+
+/* Mean recall@10 of cat = label over a few queries; every row must match */
+static float label_recall(sqlite3 *db, int label, int first_rowid) {
+  int hits = 0;
+  for (int q = 0; q < 4; q++) {
+    float query[LABEL_DIMS];
+    label_vector(100000 + q, query);
+
+    /* Brute force over the label's rows */
+    int64_t best[10];
+    float best_dist[10];
+    int n_best = 0;
+    for (int r = first_rowid; r <= LABEL_ROWS; r++) {
+      if (r % LABEL_VALUES != label) {
+        continue;
+      }
+      float v[LABEL_DIMS], dist = 0.0f;
+      label_vector(r, v);
+      for (int d = 0; d < LABEL_DIMS; d++) {
+        dist += (v[d] - query[d]) * (v[d] - query[d]);
+      }
+      if (n_best == 10 && dist >= best_dist[9]) {
+        continue;
+      }
+      int i = n_best < 10 ? n_best++ : 9;
+      for (; i > 0 && best_dist[i - 1] > dist; i--) {
+        best[i] = best[i - 1];
+        best_dist[i] = best_dist[i - 1];
+      }
+      best[i] = r;
+      best_dist[i] = dist;
+    }
+
+    /* exact = 0 and search_list_size = 10 keep the planner on the graph */
+    char *where = sqlite3_mprintf(" AND exact = 0 AND search_list_size = 10 "
+                                  "AND cat = %d",
+                                  label);
+    int64_t ids[10];
+    int n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 10,
+                                 where, ids, NULL, 10);
+    sqlite3_free(where);
+    TEST_ASSERT_EQUAL_INT(10, n);
+    for (int i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_INT(label, (int)(ids[i] % LABEL_VALUES));
+      for (int j = 0; j < 10; j++) {
+        hits += ids[i] == best[j];
+      }
+    }
+  }
+  return (float)hits / 40.0f;
+}
+
+void test_vtab_label_filtered_search(void) {
+  unlink(VTAB_TEST_DB);
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(VTAB_TEST_DB, &db));
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_diskann_init(db, NULL, NULL));
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=16, "
+              "metric=euclidean, cat INTEGER LABEL)");
+
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db, "INSERT INTO t(rowid, vector, cat) VALUES "
+                             "(?, ?, ?)",
+                         -1, &stmt, NULL));
+  exec_ok(db, "BEGIN");
+  for (int r = 1; r <= LABEL_ROWS; r++) {
+    float v[LABEL_DIMS];
+    label_vector(r, v);
+    sqlite3_bind_int64(stmt, 1, r);
+    sqlite3_bind_blob(stmt, 2, v, (int)sizeof(v), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, r % LABEL_VALUES);
+    TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  exec_ok(db, "COMMIT");
+
+  TEST_ASSERT_TRUE(label_recall(db, 3, 1) >= 0.9f);
+  TEST_ASSERT_TRUE(label_recall(db, 11, 1) >= 0.9f);
+
+  /* Deleting the label's first rows moves its entry point */
+  exec_ok(db, "DELETE FROM t WHERE rowid IN (3, 18, 33)");
+  TEST_ASSERT_TRUE(label_recall(db, 3, 34) >= 0.9f);
+
+  /* Rolled-back rows leave no label behind */
+  float v[LABEL_DIMS];
+  label_vector(1, v);
+  exec_ok(db, "BEGIN");
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db, "INSERT INTO t(rowid, vector, cat) VALUES "
+                             "(5000, ?, 99)",
+                         -1, &stmt, NULL));
+  sqlite3_bind_blob(stmt, 1, v, (int)sizeof(v), SQLITE_STATIC);
+  TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+  sqlite3_finalize(stmt);
+  exec_ok(db, "ROLLBACK");
+  TEST_ASSERT_EQUAL_INT(0, search_vtab_filtered(db, "t", v, (int)sizeof(v), 5,
+                                                " AND cat = 99", NULL, NULL,
+                                                5));
+  sqlite3_close(db);
+
+  /* Labels are rebuilt from _attrs on reconnect */
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(VTAB_TEST_DB, &db));
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_diskann_init(db, NULL, NULL));
+  TEST_ASSERT_TRUE(label_recall(db, 3, 34) >= 0.9f);
+  TEST_ASSERT_TRUE(label_recall(db, 7, 1) >= 0.9f);
+  sqlite3_close(db);
+  unlink(VTAB_TEST_DB);
+}
+
+/**************************************************************************
+** exact hidden column
+**************************************************************************/
+
+void test_vtab_exact_column(void) {
+  sqlite3 *db = create_filter_vtab();
+  float query[] = {0.42f, 0.05f, 0.0f};
+  int64_t forced[5], walked[5];
+
+  /* Category A lies on the x axis: rowid 4 (0.4) is nearest, then 5, 3 */
+  int n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 5,
+                               " AND exact = 1", forced, NULL, 5);
+  TEST_ASSERT_EQUAL_INT(5, n);
+  TEST_ASSERT_EQUAL_INT64(4, forced[0]);
+  TEST_ASSERT_EQUAL_INT64(5, forced[1]);
+  TEST_ASSERT_EQUAL_INT64(3, forced[2]);
+  TEST_ASSERT_EQUAL_INT(5, search_vtab_filtered(db, "t", query,
+                                                (int)sizeof(query), 5,
+                                                " AND exact = 0", walked,
+                                                NULL, 5));
+  TEST_ASSERT_EQUAL_INT64(4, walked[0]);
+
+  /* Exact over a filter: only category B rows */
+  n = search_vtab_filtered(db, "t", query, (int)sizeof(query), 3,
+                           " AND exact = 1 AND category = 'B'", forced, NULL,
+                           3);
+  TEST_ASSERT_EQUAL_INT(3, n);
+  TEST_ASSERT_EQUAL_INT64(11, forced[0]);
+  TEST_ASSERT_EQUAL_INT64(12, forced[1]);
+
+  /* Several queries in one scan */
+  float queries[] = {0.42f, 0.05f, 0.0f, 0.0f, 0.71f, 0.0f};
+  int query_index[4];
+  int64_t rowids[4];
+  n = search_vtab_multi(db, queries, (int)sizeof(queries), 2, " AND exact = 1",
+                        query_index, rowids, 4);
+  TEST_ASSERT_EQUAL_INT(4, n);
+  TEST_ASSERT_EQUAL_INT(0, query_index[0]);
+  TEST_ASSERT_EQUAL_INT64(4, rowids[0]);
+  TEST_ASSERT_EQUAL_INT(1, query_index[2]);
+  TEST_ASSERT_EQUAL_INT64(17, rowids[2]);
+
+  /* exact is a reserved column name */
+  TEST_ASSERT_NOT_EQUAL(SQLITE_OK,
+                        exec_expect_error(db, "CREATE VIRTUAL TABLE t2 USING "
+                                              "diskann(dimension=3, exact "
+                                              "INTEGER)"));
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Streaming cursor and distance range
+**************************************************************************/
+
+#define STREAM_ROWS 600
+
+static void stream_vector(int rowid, float *v) {
+  uint32_t seed = (uint32_t)rowid * 2246822519u;
+  for (int d = 0; d < 3; d++) {
+    seed = seed * 1103515245u + 12345u;
+    v[d] = (float)(seed >> 8) / (float)(1u << 24);
+  }
+}
+
+static sqlite3 *create_stream_vtab(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, search_list_size=20)");
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db,
+                                           "INSERT INTO t(rowid, vector) "
+                                           "VALUES (?, ?)",
+                                           -1, &stmt, NULL));
+  exec_ok(db, "BEGIN");
+  for (int i = 1; i <= STREAM_ROWS; i++) {
+    float v[3];
+    stream_vector(i, v);
+    sqlite3_bind_int(stmt, 1, i);
+    sqlite3_bind_blob(stmt, 2, v, (int)sizeof(v), SQLITE_TRANSIENT);
+    TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+    sqlite3_reset(stmt);
+  }
+  exec_ok(db, "COMMIT");
+  sqlite3_finalize(stmt);
+  return db;
+}
+
+/* Rows of "SELECT rowid, distance FROM t WHERE vector MATCH ?1<where>" */
+static int stream_query(sqlite3 *db, const float *query, const char *where,
+                        double bound, int64_t *rowids, double *distances,
+                        int max) {
+  char *sql = sqlite3_mprintf(
+      "SELECT rowid, distance FROM t WHERE vector MATCH ?1%s", where);
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, rc);
+  sqlite3_bind_blob(stmt, 1, query, 3 * (int)sizeof(float), SQLITE_STATIC);
+  if (sqlite3_bind_parameter_count(stmt) >= 2) {
+    sqlite3_bind_double(stmt, 2, bound);
+  }
+  int n = 0;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW && n < max) {
+    rowids[n] = sqlite3_column_int64(stmt, 0);
+    distances[n] = sqlite3_column_double(stmt, 1);
+    n++;
+  }
+  TEST_ASSERT_TRUE(rc == SQLITE_DONE || rc == SQLITE_ROW);
+  sqlite3_finalize(stmt);
+  return n;
+}
+
+/* Rows within a distance, with no k: all of them, on the graph and exact */
+void test_vtab_stream_range(void) {
+  sqlite3 *db = create_stream_vtab();
+  float query[] = {0.3f, 0.6f, 0.5f};
+  static int64_t rowids[STREAM_ROWS];
+  static double distances[STREAM_ROWS];
+
+  /* Reference: the exact scan with a generous k */
+  int n_all = stream_query(db, query, " AND k = 600 AND exact = 1", 0.0,
+                           rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(STREAM_ROWS, n_all);
+  double bound = distances[39]; /* 40 rows at or below it */
+
+  int n = stream_query(db, query, " AND exact = 1 AND distance <= ?2", bound,
+                       rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(40, n);
+  n = stream_query(db, query, " AND exact = 1 AND distance < ?2", bound,
+                   rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(39, n);
+
+  n = stream_query(db, query, " AND exact = 0 AND distance <= ?2", bound,
+                   rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_TRUE(n >= 36 && n <= 40);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(distances[i] <= bound);
+  }
+
+  /* k still caps a range search */
+  n = stream_query(db, query, " AND k = 5 AND exact = 0 AND distance <= ?2",
+                   bound, rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(5, n);
+  sqlite3_close(db);
+}
+
+/*
+** k larger than the search list: the cursor keeps walking past the first
+** beam. An outer condition SQLite checks itself just pulls more rows.
+*/
+void test_vtab_stream_beyond_beam(void) {
+  sqlite3 *db = create_stream_vtab();
+  float query[] = {0.5f, 0.5f, 0.5f};
+  static int64_t rowids[STREAM_ROWS];
+  static double distances[STREAM_ROWS];
+
+  int n = stream_query(db, query, " AND k = 300 AND exact = 0", 0.0, rowids,
+                       distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(300, n);
+  static int seen[STREAM_ROWS + 1];
+  memset(seen, 0, sizeof(seen));
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT(0, seen[rowids[i]]);
+    seen[rowids[i]] = 1;
+  }
+
+  n = stream_query(db, query,
+                   " AND k = 500 AND exact = 0 AND rowid % 7 = 0 LIMIT 20",
+                   0.0, rowids, distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(20, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(0, rowids[i] % 7);
+  }
+
+  /* Without k, LIMIT alone sets the row count */
+  n = stream_query(db, query, " AND exact = 0 LIMIT 150", 0.0, rowids,
+                   distances, STREAM_ROWS);
+  TEST_ASSERT_EQUAL_INT(150, n);
+  for (int i = 1; i < n; i++) {
+    TEST_ASSERT_TRUE(distances[i - 1] <= distances[i]);
+  }
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Batched metadata fetch and cached filter statements
+**************************************************************************/
+
+#define META_ROWS 300
+
+/* tag = 3 * rowid, name = 'r<rowid>' except NULL on every 10th row */
+static sqlite3 *create_meta_batch_vtab(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, tag INTEGER, name TEXT)");
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(
+      SQLITE_OK,
+      sqlite3_prepare_v2(db,
+                         "INSERT INTO t(rowid, vector, tag, name) "
+                         "VALUES (?1, ?2, ?1 * 3, "
+                         "CASE WHEN ?1 % 10 = 0 THEN NULL ELSE 'r' || ?1 END)",
+                         -1, &stmt, NULL));
+  exec_ok(db, "BEGIN");
+  for (int i = 1; i <= META_ROWS; i++) {
+    float v[3];
+    stream_vector(i, v);
+    sqlite3_bind_int(stmt, 1, i);
+    sqlite3_bind_blob(stmt, 2, v, (int)sizeof(v), SQLITE_TRANSIENT);
+    TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+    sqlite3_reset(stmt);
+  }
+  exec_ok(db, "COMMIT");
+  sqlite3_finalize(stmt);
+  return db;
+}
+
+/* Run "SELECT rowid, tag, name FROM t WHERE vector MATCH ?1<where>" and
+** check every row's metadata; returns the row count */
+static int meta_query(sqlite3 *db, const float *query, int query_bytes,
+                      const char *where) {
+  char *sql = sqlite3_mprintf(
+      "SELECT rowid, tag, name FROM t WHERE vector MATCH ?1%s", where);
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, rc);
+  sqlite3_bind_blob(stmt, 1, query, query_bytes, SQLITE_STATIC);
+  int n = 0;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t rowid = sqlite3_column_int64(stmt, 0);
+    TEST_ASSERT_EQUAL_INT64(rowid * 3, sqlite3_column_int64(stmt, 1));
+    if (rowid % 10 == 0) {
+      TEST_ASSERT_EQUAL_INT(SQLITE_NULL, sqlite3_column_type(stmt, 2));
+    } else {
+      char expected[32];
+      snprintf(expected, sizeof(expected), "r%lld", (long long)rowid);
+      TEST_ASSERT_EQUAL_STRING(expected,
+                               (const char *)sqlite3_column_text(stmt, 2));
+    }
+    n++;
+  }
+  TEST_ASSERT_EQUAL_INT(SQLITE_DONE, rc);
+  sqlite3_finalize(stmt);
+  return n;
+}
+
+/* Metadata of more rows than one batch, streamed and filled up front */
+void test_vtab_meta_batch_fetch(void) {
+  sqlite3 *db = create_meta_batch_vtab();
+  float queries[] = {0.5f, 0.5f, 0.5f, 0.2f, 0.8f, 0.4f};
+
+  TEST_ASSERT_EQUAL_INT(
+      200, meta_query(db, queries, 3 * (int)sizeof(float), " AND k = 200"));
+  TEST_ASSERT_EQUAL_INT(
+      150, meta_query(db, queries, 3 * (int)sizeof(float), " LIMIT 150"));
+  TEST_ASSERT_EQUAL_INT(META_ROWS,
+                        meta_query(db, queries, 3 * (int)sizeof(float),
+                                   " AND k = 1000 AND exact = 1"));
+
+  /* Several queries share rowids */
+  TEST_ASSERT_EQUAL_INT(
+      200, meta_query(db, queries, (int)sizeof(queries), " AND k = 100"));
+
+  /* Filters are checked again by SQLite against the fetched values */
+  int n = meta_query(db, queries, 3 * (int)sizeof(float),
+                     " AND k = 100 AND tag > 600");
+  TEST_ASSERT_TRUE(n > 0 && n <= 100);
+
+  /* ROWID lookup */
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db,
+                                           "SELECT tag, name FROM t "
+                                           "WHERE rowid = 31",
+                                           -1, &stmt, NULL));
+  TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+  TEST_ASSERT_EQUAL_INT64(93, sqlite3_column_int64(stmt, 0));
+  TEST_ASSERT_EQUAL_STRING("r31", (const char *)sqlite3_column_text(stmt, 1));
+  TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+}
+
+/* Prepared statements on db */
+static int count_statements(sqlite3 *db) {
+  int n = 0;
+  for (sqlite3_stmt *s = sqlite3_next_stmt(db, NULL); s;
+       s = sqlite3_next_stmt(db, s)) {
+    n++;
+  }
+  return n;
+}
+
+/* Repeated filters and metadata reads reuse the vtab's statements */
+void test_vtab_filter_stmt_reuse(void) {
+  sqlite3 *db = create_meta_batch_vtab();
+  float query[] = {0.5f, 0.5f, 0.5f};
+  const char *filters[] = {" AND k = 20 AND tag > 300",
+                           " AND k = 20 AND tag < 600 AND name IS NOT NULL",
+                           " AND k = 20 AND tag > 450"};
+
+  for (int f = 0; f < 3; f++) {
+    TEST_ASSERT_TRUE(meta_query(db, query, (int)sizeof(query), filters[f]) >
+                     0);
+  }
+  int n_statements = count_statements(db);
+  for (int pass = 0; pass < 3; pass++) {
+    for (int f = 0; f < 3; f++) {
+      TEST_ASSERT_TRUE(
+          meta_query(db, query, (int)sizeof(query), filters[f]) > 0);
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(n_statements, count_statements(db));
+
+  /* Cached statements do not keep the table from being dropped */
+  exec_ok(db, "DROP TABLE t");
+  sqlite3_close(db);
+}
+
+/* INSERT INTO t(t) VALUES ('optimize') rewrites the graph in place */
+void test_vtab_optimize_command(void) {
+  sqlite3 *db = create_meta_batch_vtab();
+  float query[] = {0.5f, 0.5f, 0.5f};
+  int64_t before[20], after[20];
+  float before_d[20], after_d[20];
+
+  int n = search_vtab(db, "t", query, (int)sizeof(query), 20, before,
+                      before_d, 20);
+  TEST_ASSERT_EQUAL_INT(20, n);
+  exec_ok(db, "INSERT INTO t(t) VALUES ('optimize')");
+  TEST_ASSERT_EQUAL_INT(n, search_vtab(db, "t", query, (int)sizeof(query), 20,
+                                       after, after_d, 20));
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(before[i], after[i]);
+    TEST_ASSERT_EQUAL_FLOAT(before_d[i], after_d[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(META_ROWS, meta_query(db, query, (int)sizeof(query),
+                                              " AND k = 1000 AND exact = 1"));
+
+  /* Inside a transaction, after inserts; not after queued deletes */
+  exec_ok(db, "BEGIN");
+  float v[3] = {0.25f, 0.5f, 0.75f};
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db,
+                                           "INSERT INTO t(rowid, vector) "
+                                           "VALUES (1000, ?)",
+                                           -1, &stmt, NULL));
+  sqlite3_bind_blob(stmt, 1, v, (int)sizeof(v), SQLITE_STATIC);
+  TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+  sqlite3_finalize(stmt);
+  exec_ok(db, "INSERT INTO t(t) VALUES ('optimize')");
+  exec_ok(db, "DELETE FROM t WHERE rowid = 1");
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK, exec_expect_error(db, "INSERT INTO t(t) VALUES ('optimize')"));
+  exec_ok(db, "COMMIT");
+  TEST_ASSERT_EQUAL_INT(1, search_vtab(db, "t", v, (int)sizeof(v), 1, after,
+                                       NULL, 1));
+  TEST_ASSERT_EQUAL_INT64(1000, after[0]);
+
+  TEST_ASSERT_NOT_EQUAL(
+      SQLITE_OK, exec_expect_error(db, "INSERT INTO t(t) VALUES ('rebuild')"));
+  sqlite3_close(db);
+
+  /* A metadata column named after the table stays a metadata column */
+  db = open_vtab_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE tag USING diskann(dimension=3, "
+              "metric=euclidean, tag TEXT)");
+  exec_ok(db, "INSERT INTO tag(rowid, vector, tag) VALUES "
+              "(1, X'0000803f0000000000000000', 'optimize')");
+  TEST_ASSERT_EQUAL_INT(1, count_rows(db, "SELECT tag FROM tag "
+                                          "WHERE rowid = 1"));
+  sqlite3_close(db);
+}
+
+/**************************************************************************
+** Sharded tables (shards=)
+**************************************************************************/
+
+#ifdef _WIN32
+#define VTAB_SHARD_ONE "diskann_test_vtab_s1.db"
+#define VTAB_SHARD_TWO "diskann_test_vtab_s2.db"
+#else
+#define VTAB_SHARD_ONE "/tmp/diskann_test_vtab_s1.db"
+#define VTAB_SHARD_TWO "/tmp/diskann_test_vtab_s2.db"
+#endif
+#define SHARD_ROWS 200
+
+static void shard_vector(int i, float *v) {
+  v[0] = sinf((float)i);
+  v[1] = cosf((float)i * 0.7f);
+  v[2] = (float)(i % 10) / 10.0f;
+}
+
+/* Insert rows 1..n into table, with tenant = rowid % 4 if with_tenant */
+static void insert_shard_rows(sqlite3 *db, const char *table, int n,
+                              int with_tenant) {
+  char *sql = sqlite3_mprintf(
+      with_tenant ? "INSERT INTO %s(rowid, vector, tenant) VALUES (?, ?, ?)"
+                  : "INSERT INTO %s(rowid, vector) VALUES (?, ?)",
+      table);
+  sqlite3_stmt *stmt;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK,
+                        sqlite3_prepare_v2(db, sql, -1, &stmt, NULL));
+  sqlite3_free(sql);
+  exec_ok(db, "BEGIN");
+  for (int i = 1; i <= n; i++) {
+    float v[3];
+    shard_vector(i, v);
+    sqlite3_bind_int(stmt, 1, i);
+    sqlite3_bind_blob(stmt, 2, v, (int)sizeof(v), SQLITE_TRANSIENT);
+    if (with_tenant) {
+      sqlite3_bind_int(stmt, 3, i % 4);
+    }
+    TEST_ASSERT_EQUAL_INT(SQLITE_DONE, sqlite3_step(stmt));
+    sqlite3_reset(stmt);
+  }
+  exec_ok(db, "COMMIT");
+  sqlite3_finalize(stmt);
+}
+
+static int shard_rows(sqlite3 *db, const char *schema) {
+  char *sql = sqlite3_mprintf("SELECT id FROM \"%w\".t_shadow", schema);
+  int n = count_rows(db, sql);
+  sqlite3_free(sql);
+  return n;
+}
+
+void test_vtab_shards_create_errors(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "ATTACH ':memory:' AS s1; ATTACH ':memory:' AS s2");
+
+  const char *bad[] = {
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:s1)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:a-b)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:nosuch)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:s2, "
+      "cat TEXT LABEL)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+      "tenant INTEGER PARTITION)",
+      "CREATE VIRTUAL TABLE t USING diskann(dimension=3, shards=s1:s2, "
+      "a INTEGER PARTITION, b INTEGER PARTITION)",
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    TEST_ASSERT_NOT_EQUAL(SQLITE_OK, exec_expect_error(db, bad[i]));
+  }
+  /* Nothing is left behind */
+  TEST_ASSERT_FALSE(table_exists(db, "t_shards"));
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM s1.sqlite_master"));
+  sqlite3_close(db);
+}
+
+void test_vtab_shards_rowid_routing(void) {
+  sqlite3 *db = open_vtab_db();
+  exec_ok(db, "ATTACH ':memory:' AS s1; ATTACH ':memory:' AS s2");
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, shards=main:s1:s2)");
+  exec_ok(db, "CREATE VIRTUAL TABLE u USING diskann(dimension=3, "
+              "metric=euclidean)");
+  insert_shard_rows(db, "t", SHARD_ROWS, 0);
+  insert_shard_rows(db, "u", SHARD_ROWS, 0);
+
+  /* Every row is in exactly one shard */
+  int n1 = shard_rows(db, "s1"), n2 = shard_rows(db, "s2");
+  TEST_ASSERT_TRUE(n1 > 0 && n2 > 0);
+  TEST_ASSERT_TRUE(n1 + n2 < SHARD_ROWS);
+  TEST_ASSERT_EQUAL_INT(SHARD_ROWS,
+                        count_rows(db, "SELECT 1 FROM main.t_shadow") + n1 +
+                            n2);
+
+  /* Exact searches merge to the unsharded table's results */
+  float query[3] = {0.3f, -0.2f, 0.5f};
+  int64_t a[SHARD_ROWS], b[SHARD_ROWS];
+  int n = query_rowids(db,
+                       "SELECT rowid FROM t WHERE vector MATCH ?1 "
+                       "AND k = 10 AND exact = 1",
+                       query, (int)sizeof(query), a, SHARD_ROWS);
+  TEST_ASSERT_EQUAL_INT(10, n);
+  TEST_ASSERT_EQUAL_INT(n, query_rowids(db,
+                                        "SELECT rowid FROM u WHERE vector "
+                                        "MATCH ?1 AND k = 10 AND exact = 1",
+                                        query, (int)sizeof(query), b,
+                                        SHARD_ROWS));
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(b[i], a[i]);
+  }
+
+  /* Range search: every row within the bound, nearest first */
+  n = query_rowids(db,
+                   "SELECT rowid FROM t WHERE vector MATCH ?1 "
+                   "AND distance < 0.6",
+                   query, (int)sizeof(query), a, SHARD_ROWS);
+  TEST_ASSERT_TRUE(n > 10);
+  TEST_ASSERT_EQUAL_INT(n, query_rowids(db,
+                                        "SELECT rowid FROM u WHERE vector "
+                                        "MATCH ?1 AND distance < 0.6 "
+                                        "AND exact = 1",
+                                        query, (int)sizeof(query), b,
+                                        SHARD_ROWS));
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(b[i], a[i]);
+  }
+
+  /* Graph searches and multi-query MATCH */
+  float v[6];
+  shard_vector(42, v);
+  shard_vector(77, v + 3);
+  TEST_ASSERT_EQUAL_INT(1, search_vtab(db, "t", v, 3 * (int)sizeof(float), 1,
+                                       a, NULL, 1));
+  TEST_ASSERT_EQUAL_INT64(42, a[0]);
+  int qi[8];
+  TEST_ASSERT_EQUAL_INT(
+      4, search_vtab_multi(db, v, (int)sizeof(v), 2, NULL, qi, a, 8));
+  TEST_ASSERT_EQUAL_INT(0, qi[0]);
+  TEST_ASSERT_EQUAL_INT64(42, a[0]);
+  TEST_ASSERT_EQUAL_INT(1, qi[2]);
+  TEST_ASSERT_EQUAL_INT64(77, a[2]);
+
+  /* DELETE finds the row's shard */
+  exec_ok(db, "DELETE FROM t WHERE rowid = 42");
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM t "
+                                          "WHERE rowid = 42"));
+  TEST_ASSERT_EQUAL_INT(1, count_rows(db, "SELECT 1 FROM t "
+                                          "WHERE rowid = 43"));
+  TEST_ASSERT_EQUAL_INT(1, search_vtab(db, "t", v, 3 * (int)sizeof(float), 1,
+                                       a, NULL, 1));
+  TEST_ASSERT_TRUE(a[0] != 42);
+  exec_ok(db, "DELETE FROM t WHERE rowid = 42");
+  exec_ok(db, "INSERT INTO t(t) VALUES ('optimize')");
+
+  exec_ok(db, "DROP TABLE t");
+  TEST_ASSERT_FALSE(table_exists(db, "t_shards"));
+  TEST_ASSERT_FALSE(table_exists(db, "t_shadow"));
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM s1.sqlite_master"));
+  TEST_ASSERT_TRUE(table_exists(db, "u_shadow"));
+  sqlite3_close(db);
+}
+
+static sqlite3 *open_partition_db(void) {
+  sqlite3 *db;
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open(VTAB_TEST_DB, &db));
+  TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_diskann_init(db, NULL, NULL));
+  exec_ok(db, "ATTACH '" VTAB_SHARD_ONE "' AS s1;"
+              "ATTACH '" VTAB_SHARD_TWO "' AS s2");
+  return db;
+}
+
+/* Schemas holding some row of tenant */
+static int tenant_shards(sqlite3 *db, int tenant) {
+  char *sql = sqlite3_mprintf(
+      "SELECT 1 FROM s1.t_shadow WHERE id IN "
+      "(SELECT rowid FROM t_attrs WHERE tenant = %d) LIMIT 1", tenant);
+  int n = count_rows(db, sql);
+  sqlite3_free(sql);
+  sql = sqlite3_mprintf(
+      "SELECT 1 FROM s2.t_shadow WHERE id IN "
+      "(SELECT rowid FROM t_attrs WHERE tenant = %d) LIMIT 1", tenant);
+  n += count_rows(db, sql);
+  sqlite3_free(sql);
+  return n;
+}
+
+void test_vtab_shards_partition(void) {
+  unlink(VTAB_TEST_DB);
+  unlink(VTAB_SHARD_ONE);
+  unlink(VTAB_SHARD_TWO);
+  sqlite3 *db = open_partition_db();
+  exec_ok(db, "CREATE VIRTUAL TABLE t USING diskann(dimension=3, "
+              "metric=euclidean, shards=s1:s2, tenant INTEGER PARTITION)");
+  insert_shard_rows(db, "t", SHARD_ROWS, 1);
+
+  /* A tenant's rows share one shard */
+  for (int tenant = 0; tenant < 4; tenant++) {
+    TEST_ASSERT_EQUAL_INT(1, tenant_shards(db, tenant));
+  }
+  TEST_ASSERT_EQUAL_INT(SHARD_ROWS,
+                        shard_rows(db, "s1") + shard_rows(db, "s2"));
+
+  /* Filtered searches see only the tenant's rows (shards searched on
+  ** their own connections: the table is file-backed) */
+  float query[3] = {0.1f, 0.9f, 0.3f};
+  int64_t rowids[SHARD_ROWS];
+  int n = query_rowids(db,
+                       "SELECT rowid FROM t WHERE vector MATCH ?1 "
+                       "AND k = 8 AND tenant = 2",
+                       query, (int)sizeof(query), rowids, SHARD_ROWS);
+  TEST_ASSERT_EQUAL_INT(8, n);
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT64(2, rowids[i] % 4);
+  }
+
+  /* DELETE routes by the stored key */
+  exec_ok(db, "DELETE FROM t WHERE rowid = 6");
+  TEST_ASSERT_EQUAL_INT(SHARD_ROWS - 1,
+                        shard_rows(db, "s1") + shard_rows(db, "s2"));
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM t "
+                                          "WHERE rowid = 6"));
+  sqlite3_close(db);
+
+  /* Reconnected, the table reopens its shards and keeps routing by
+  ** tenant */
+  db = open_partition_db();
+  exec_ok(db, "INSERT INTO t(rowid, vector, tenant) VALUES "
+              "(1000, X'0000803f0000803f0000803f', 3)");
+  TEST_ASSERT_EQUAL_INT(1, tenant_shards(db, 3));
+  float ones[3] = {1.0f, 1.0f, 1.0f};
+  TEST_ASSERT_EQUAL_INT(1, query_rowids(db,
+                                        "SELECT rowid FROM t WHERE vector "
+                                        "MATCH ?1 AND k = 1 AND tenant = 3",
+                                        ones, (int)sizeof(ones), rowids, 1));
+  TEST_ASSERT_EQUAL_INT64(1000, rowids[0]);
+  TEST_ASSERT_EQUAL_INT(1, count_rows(db, "SELECT tenant FROM t "
+                                          "WHERE rowid = 1000"));
+
+  exec_ok(db, "DROP TABLE t");
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM sqlite_master "
+                                          "WHERE name LIKE 't_%'"));
+  TEST_ASSERT_EQUAL_INT(0, count_rows(db, "SELECT 1 FROM s1.sqlite_master"));
+  sqlite3_close(db);
+  unlink(VTAB_TEST_DB);
+  unlink(VTAB_SHARD_ONE);
+  unlink(VTAB_SHARD_TWO);
+}
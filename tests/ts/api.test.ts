@@ -9,10 +9,15 @@ import { afterEach, beforeEach, describe, expect, it } from "vitest";
 import type { DatabaseLike } from "../../src/index.js";
 import {
   createDiskAnnIndex,
+  createSearcher,
   deleteVector,
+  deleteVectors,
+  encodeHalfVector,
   getExtensionPath,
   insertVector,
+  insertVectors,
   loadDiskAnnExtension,
+  optimizeIndex,
   searchNearest,
 } from "../../src/index.js";
 import { dbFactories } from "./db-factory.js";
@@ -47,8 +52,13 @@ describe("TypeScript API", () => {
       expect(module.loadDiskAnnExtension).toBeDefined();
       expect(module.createDiskAnnIndex).toBeDefined();
       expect(module.insertVector).toBeDefined();
+      expect(module.insertVectors).toBeDefined();
+      expect(module.createSearcher).toBeDefined();
       expect(module.searchNearest).toBeDefined();
       expect(module.deleteVector).toBeDefined();
+      expect(module.deleteVectors).toBeDefined();
+      expect(module.optimizeIndex).toBeDefined();
+      expect(module.encodeHalfVector).toBeDefined();
       expect(module.getExtensionPath).toBeTypeOf("function");
     });
   });
@@ -152,6 +162,53 @@ for (const factory of dbFactories) {
         }).toThrow(/Invalid maxDegree/);
       });
 
+      it("validates vectorType parameter", () => {
+        expect(() => {
+          createDiskAnnIndex(db, "test", {
+            dimension: 128,
+            // eslint-disable-next-line @typescript-eslint/no-explicit-any
+            vectorType: "float8" as any,
+          });
+        }).toThrow(/Invalid vectorType/);
+      });
+
+      it("stores and searches float16 vectors", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "halves", {
+          dimension: 3,
+          metric: "euclidean",
+          vectorType: "float16",
+        });
+        expect(Array.from(encodeHalfVector([1, -2, 0.1], "float16"))).toEqual([
+          0x3c00, 0xc000, 0x2e66,
+        ]);
+        expect(Array.from(encodeHalfVector([1], "bfloat16"))).toEqual([0x3f80]);
+
+        insertVector(db, "halves", 1, encodeHalfVector([1, 0, 0], "float16"));
+        insertVector(db, "halves", 2, encodeHalfVector([0, 1, 0], "float16"));
+        // A float32 BLOB has the wrong size for a float16 table
+        expect(() => insertVector(db, "halves", 3, [0, 0, 1])).toThrow();
+
+        const results = searchNearest(
+          db,
+          "halves",
+          encodeHalfVector([1, 0.1, 0], "float16"),
+          2
+        );
+        expect(results).toHaveLength(2);
+        expect(results[0].rowid).toBe(1);
+        expect(results[0].distance).toBeCloseTo(0.01, 3);
+
+        // Bulk inserts and prepared searches bind the halves as they are
+        insertVectors(db, "halves", [
+          { id: 3, vector: encodeHalfVector([0, 0, 1], "float16") },
+        ]);
+        const searcher = createSearcher(db, "halves", { k: 1 });
+        expect(
+          searcher.search(encodeHalfVector([0, 0.1, 1], "float16"))[0].rowid
+        ).toBe(3);
+      });
+
       it("uses default values for optional parameters", () => {
         // This will fail until extension is loaded, but validates API
         try {
@@ -299,6 +356,177 @@ for (const factory of dbFactories) {
       });
     });
 
+    describe("insertVectors()", () => {
+      let db: DatabaseLike;
+
+      beforeEach(() => {
+        db = factory.create(":memory:");
+      });
+
+      afterEach(() => {
+        factory.cleanup?.(db);
+      });
+
+      it("inserts every row from an iterable", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "embeddings", {
+          dimension: 3,
+          metric: "euclidean",
+        });
+
+        function* rows() {
+          for (let i = 1; i <= 50; i++) {
+            yield { id: i, vector: new Float32Array([i, i % 7, 0]) };
+          }
+        }
+        expect(insertVectors(db, "embeddings", rows())).toBe(50);
+        expect(
+          insertVectors(db, "embeddings", [{ id: 51n, vector: [0, 0, 1] }])
+        ).toBe(1);
+
+        const results = searchNearest(
+          db,
+          "embeddings",
+          new Float32Array([10, 3, 0]),
+          1
+        );
+        expect(results[0].rowid).toBe(10);
+        expect(searchNearest(db, "embeddings", [0, 0, 1], 1)[0].rowid).toBe(51);
+      });
+
+      it("inserts nothing when a row fails", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "embeddings", {
+          dimension: 3,
+          metric: "euclidean",
+        });
+
+        expect(() =>
+          insertVectors(db, "embeddings", [
+            { id: 1, vector: new Float32Array([1, 0, 0]) },
+            { id: 2, vector: [] },
+          ])
+        ).toThrow(/non-empty array/);
+        expect(() =>
+          insertVectors(db, "embeddings", [
+            { id: 1, vector: new Float32Array([1, 0, 0]) },
+            { id: 1.5, vector: new Float32Array([0, 1, 0]) },
+          ])
+        ).toThrow(/Invalid id/);
+        // SQLite rejects the short vector after row 1 went into the index
+        expect(() =>
+          insertVectors(db, "embeddings", [
+            { id: 1, vector: new Float32Array([1, 0, 0]) },
+            { id: 2, vector: new Float32Array([0, 1]) },
+          ])
+        ).toThrow();
+
+        const results = searchNearest(
+          db,
+          "embeddings",
+          new Float32Array([1, 0, 0]),
+          10
+        );
+        expect(results).toEqual([]);
+
+        // Inside a transaction only the savepoint is rolled back
+        db.exec("BEGIN");
+        insertVector(db, "embeddings", 7, new Float32Array([0, 0, 1]));
+        expect(() =>
+          insertVectors(db, "embeddings", [
+            { id: 8, vector: new Float32Array([1, 0, 0]) },
+            { id: 7, vector: new Float32Array([0, 1, 0]) },
+          ])
+        ).toThrow();
+        db.exec("COMMIT");
+        expect(
+          searchNearest(db, "embeddings", [1, 0, 0], 10).map((r) => r.rowid)
+        ).toEqual([7]);
+      });
+
+      it("keeps the recall of row-by-row inserts", () => {
+        loadDiskAnnExtension(db);
+        for (const table of ["per_row", "bulk"]) {
+          createDiskAnnIndex(db, table, { dimension: 16, metric: "euclidean" });
+        }
+        let seed = 99;
+        const vectors = Array.from({ length: 400 }, () =>
+          Float32Array.from({ length: 16 }, () => {
+            seed = (seed * 1664525 + 1013904223) >>> 0;
+            return (seed >>> 8) / (1 << 23) - 1;
+          })
+        );
+        vectors.forEach((vector, i) => insertVector(db, "per_row", i + 1, vector));
+        insertVectors(
+          db,
+          "bulk",
+          vectors.map((vector, i) => ({ id: i + 1, vector }))
+        );
+
+        let hits = 0;
+        for (let q = 0; q < 20; q++) {
+          const query = vectors[q * 19].map((x) => x + 0.05);
+          const ids = (table: string, exact: boolean) =>
+            searchNearest(db, table, query, 10, { exact }).map((r) => r.rowid);
+          const truth = new Set(ids("per_row", true));
+          const bulk = ids("bulk", false);
+          expect(bulk).toEqual(ids("per_row", false));
+          hits += bulk.filter((id) => truth.has(id)).length;
+        }
+        expect(hits).toBeGreaterThanOrEqual(180);
+      });
+
+      it("validates table name", () => {
+        expect(() => insertVectors(db, "bad-name", [])).toThrow(/Invalid table name/);
+      });
+    });
+
+    describe("createSearcher()", () => {
+      let db: DatabaseLike;
+
+      beforeEach(() => {
+        db = factory.create(":memory:");
+      });
+
+      afterEach(() => {
+        factory.cleanup?.(db);
+      });
+
+      it("validates parameters", () => {
+        expect(() => createSearcher(db, "bad-name")).toThrow(/Invalid table name/);
+        expect(() => createSearcher(db, "embeddings", { k: 0 })).toThrow(/Invalid k/);
+        expect(() =>
+          createSearcher(db, "embeddings", { searchListSize: -1 })
+        ).toThrow(/Invalid searchListSize/);
+      });
+
+      it("matches searchNearest() across repeated searches", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "embeddings", {
+          dimension: 3,
+          metric: "euclidean",
+        });
+        insertVector(db, "embeddings", 1, new Float32Array([1.0, 0.0, 0.0]));
+        insertVector(db, "embeddings", 2, new Float32Array([0.0, 1.0, 0.0]));
+        insertVector(db, "embeddings", 3, new Float32Array([0.0, 0.0, 1.0]));
+
+        const searcher = createSearcher(db, "embeddings", {
+          k: 2,
+          searchListSize: 20,
+        });
+        for (const query of [
+          new Float32Array([1.0, 0.1, 0.0]),
+          new Float32Array([0.0, 0.2, 0.9]),
+        ]) {
+          expect(searcher.search(query)).toEqual(
+            searchNearest(db, "embeddings", query, 2, { searchListSize: 20 })
+          );
+        }
+        expect(searcher.search([0, 1, 0])[0].rowid).toBe(2);
+        expect(() => searcher.search([])).toThrow(/non-empty array/);
+      });
+    });
+
     describe("deleteVector()", () => {
       let db: DatabaseLike;
 
@@ -329,6 +557,59 @@ for (const factory of dbFactories) {
         );
         expect(results).toHaveLength(0);
       });
+
+      it("deletes many vectors in one call", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "embeddings", {
+          dimension: 3,
+          metric: "euclidean",
+        });
+
+        insertVector(db, "embeddings", 1, new Float32Array([1.0, 0.0, 0.0]));
+        insertVector(db, "embeddings", 2, new Float32Array([0.0, 1.0, 0.0]));
+        insertVector(db, "embeddings", 3, new Float32Array([0.0, 0.0, 1.0]));
+
+        // Missing rowid 99 is ignored
+        deleteVectors(db, "embeddings", [1, 3, 99]);
+        deleteVectors(db, "embeddings", []);
+
+        const results = searchNearest(
+          db,
+          "embeddings",
+          new Float32Array([1.0, 0.0, 0.0]),
+          10
+        );
+        expect(results.map((r) => r.rowid)).toEqual([2]);
+      });
+
+      it("rejects non-integer rowids", () => {
+        expect(() => deleteVectors(db, "embeddings", [1.5])).toThrow(
+          /Invalid rowids/
+        );
+      });
+
+      it("optimizes the index without changing results", () => {
+        loadDiskAnnExtension(db);
+        createDiskAnnIndex(db, "embeddings", {
+          dimension: 3,
+          metric: "euclidean",
+        });
+
+        insertVector(db, "embeddings", 1, new Float32Array([1.0, 0.0, 0.0]));
+        insertVector(db, "embeddings", 2, new Float32Array([0.0, 1.0, 0.0]));
+        insertVector(db, "embeddings", 3, new Float32Array([0.0, 0.0, 1.0]));
+        deleteVector(db, "embeddings", 2);
+
+        optimizeIndex(db, "embeddings");
+
+        const results = searchNearest(
+          db,
+          "embeddings",
+          new Float32Array([1.0, 0.0, 0.0]),
+          10
+        );
+        expect(results.map((r) => r.rowid)).toEqual([1, 3]);
+      });
     });
 
     describe("Metadata columns", () => {
@@ -389,6 +670,89 @@ for (const factory of dbFactories) {
         }).toThrow(/duplicate.*column/i);
       });
 
+      it("creates a LABEL column and filters on it", () => {
+        loadDiskAnnExtension(db);
+        expect(() => {
+          createDiskAnnIndex(db, "photos2", {
+            dimension: 3,
+            metric: "euclidean",
+            metadataColumns: [
+              { name: "a", type: "TEXT", label: true },
+              { name: "b", type: "TEXT", label: true },
+            ],
+          });
+        }).toThrow(/one LABEL/i);
+
+        createDiskAnnIndex(db, "photos", {
+          dimension: 3,
+          metric: "euclidean",
+          metadataColumns: [{ name: "category", type: "TEXT", label: true }],
+        });
+        const insert = db.prepare(
+          "INSERT INTO photos(rowid, vector, category) VALUES (?, ?, ?)"
+        );
+        for (let i = 1; i <= 20; i++) {
+          insert.run(i, new Float32Array([i, 0, 0]), i % 2 ? "odd" : "even");
+        }
+
+        const results = db
+          .prepare(
+            "SELECT rowid FROM photos WHERE vector MATCH ? AND k = 3 AND category = 'even'"
+          )
+          .all(new Float32Array([5.2, 0, 0])) as Array<{ rowid: number }>;
+        expect(results.map((r) => r.rowid).sort((x, y) => x - y)).toEqual([4, 6, 8]);
+      });
+
+      it("creates a sharded index routed by a PARTITION column", () => {
+        loadDiskAnnExtension(db);
+        db.exec("ATTACH ':memory:' AS s1");
+        db.exec("ATTACH ':memory:' AS s2");
+        expect(() => {
+          createDiskAnnIndex(db, "photos2", {
+            dimension: 3,
+            shards: ["s1", "S1"],
+          });
+        }).toThrow(/duplicate shard/i);
+        expect(() => {
+          createDiskAnnIndex(db, "photos2", {
+            dimension: 3,
+            shards: ["s1", "s2"],
+            metadataColumns: [
+              { name: "a", type: "INTEGER", partition: true },
+              { name: "b", type: "INTEGER", partition: true },
+            ],
+          });
+        }).toThrow(/one PARTITION/i);
+
+        createDiskAnnIndex(db, "photos", {
+          dimension: 3,
+          metric: "euclidean",
+          shards: ["s1", "s2"],
+          metadataColumns: [{ name: "tenant", type: "INTEGER", partition: true }],
+        });
+        const insert = db.prepare(
+          "INSERT INTO photos(rowid, vector, tenant) VALUES (?, ?, ?)"
+        );
+        for (let i = 1; i <= 20; i++) {
+          insert.run(i, new Float32Array([i, 0, 0]), i % 2);
+        }
+
+        const count = (schema: string) =>
+          (
+            db
+              .prepare(`SELECT count(*) AS n FROM ${schema}.photos_shadow`)
+              .all() as Array<{ n: number }>
+          )[0].n;
+        expect(count("s1") + count("s2")).toBe(20);
+
+        const results = db
+          .prepare(
+            "SELECT rowid FROM photos WHERE vector MATCH ? AND k = 3 AND tenant = 0"
+          )
+          .all(new Float32Array([5.2, 0, 0])) as Array<{ rowid: number }>;
+        expect(results.map((r) => r.rowid).sort((x, y) => x - y)).toEqual([4, 6, 8]);
+      });
+
       it("inserts and searches with metadata", () => {
         loadDiskAnnExtension(db);
         createDiskAnnIndex(db, "photos", {